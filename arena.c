@@ -0,0 +1,111 @@
+#include "arena.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ARENA_DEFAULT_CHUNK (64 * 1024)
+#define ARENA_ALIGN 16
+
+static size_t align_up(size_t size) {
+    return (size + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+}
+
+static ArenaChunk* chunk_create(size_t size, ArenaChunk* next) {
+    ArenaChunk* chunk = (ArenaChunk*)malloc(sizeof(ArenaChunk) + size);
+    if (!chunk) {
+        perror("malloc failed for ArenaChunk");
+        exit(1);
+    }
+    chunk->next = next;
+    chunk->size = size;
+    chunk->used = 0;
+    return chunk;
+}
+
+Arena* arena_create(size_t chunk_size) {
+    Arena* arena = (Arena*)malloc(sizeof(Arena));
+    if (!arena) {
+        perror("malloc failed for Arena");
+        exit(1);
+    }
+    arena->chunk_size = chunk_size > 0 ? chunk_size : ARENA_DEFAULT_CHUNK;
+    arena->head = chunk_create(arena->chunk_size, NULL);
+    arena->bytes_allocated = 0;
+    arena->last = NULL;
+    return arena;
+}
+
+void arena_destroy(Arena* arena) {
+    if (!arena) return;
+
+    ArenaChunk* chunk = arena->head;
+    while (chunk) {
+        ArenaChunk* next = chunk->next;
+        free(chunk);
+        chunk = next;
+    }
+    free(arena);
+}
+
+void* arena_alloc(Arena* arena, size_t size) {
+    size_t aligned = align_up(size > 0 ? size : 1);
+
+    if (arena->head->used + aligned > arena->head->size) {
+        // 大块单独分配, 避免浪费当前块剩余的空间
+        size_t chunk_size = aligned > arena->chunk_size ? aligned : arena->chunk_size;
+        arena->head = chunk_create(chunk_size, arena->head);
+    }
+
+    void* ptr = arena->head->data + arena->head->used;
+    arena->head->used += aligned;
+    arena->bytes_allocated += size;
+    arena->last = ptr;
+    memset(ptr, 0, size);
+    return ptr;
+}
+
+void* arena_grow(Arena* arena, void* ptr, size_t old_size, size_t new_size) {
+    if (!ptr) {
+        return arena_alloc(arena, new_size);
+    }
+    if (new_size <= old_size) {
+        return ptr;
+    }
+
+    // 最近一次分配且当前块还有空间: 原地扩展
+    ArenaChunk* head = arena->head;
+    if (ptr == arena->last) {
+        size_t offset = (size_t)((char*)ptr - head->data);
+        size_t aligned = align_up(new_size);
+        if (offset + aligned <= head->size) {
+            memset((char*)ptr + old_size, 0, new_size - old_size);
+            head->used = offset + aligned;
+            arena->bytes_allocated += new_size - old_size;
+            return ptr;
+        }
+    }
+
+    void* moved = arena_alloc(arena, new_size);
+    memcpy(moved, ptr, old_size);
+    return moved;
+}
+
+char* arena_strdup(Arena* arena, const char* str) {
+    if (!str) return NULL;
+
+    size_t length = strlen(str) + 1;
+    char* copy = (char*)arena_alloc(arena, length);
+    memcpy(copy, str, length);
+    return copy;
+}
+
+void* arena_array_reserve(Arena* arena, void* data, int count, int* capacity, size_t elem_size) {
+    if (count < *capacity) {
+        return data;
+    }
+
+    int new_capacity = *capacity > 0 ? *capacity * 2 : 8;
+    data = arena_grow(arena, data, (size_t)*capacity * elem_size, (size_t)new_capacity * elem_size);
+    *capacity = new_capacity;
+    return data;
+}
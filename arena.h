@@ -0,0 +1,41 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+// ========== 区域分配器(Arena) ==========
+//
+// 从大块内存中顺序分配, 不支持单独释放, 只能整体销毁。
+// IR的所有数组都从模块的Arena中分配, 一次arena_destroy释放整个模块。
+
+typedef struct ArenaChunk {
+    struct ArenaChunk* next;    // 上一个(更早分配的)块
+    size_t size;                // data的容量
+    size_t used;                // 已使用的字节数
+    char data[];
+} ArenaChunk;
+
+typedef struct Arena {
+    ArenaChunk* head;           // 当前分配的块
+    size_t chunk_size;          // 新块的默认大小
+    size_t bytes_allocated;     // 累计分配的字节数(不含对齐填充)
+    void* last;                 // 最近一次分配的地址(用于原地扩容)
+} Arena;
+
+// chunk_size为0时使用默认块大小
+Arena* arena_create(size_t chunk_size);
+void arena_destroy(Arena* arena);
+
+// 分配清零的内存(按16字节对齐)
+void* arena_alloc(Arena* arena, size_t size);
+// 把ptr处old_size字节的分配扩大到new_size: 是最近一次分配时原地扩展, 否则复制
+void* arena_grow(Arena* arena, void* ptr, size_t old_size, size_t new_size);
+char* arena_strdup(Arena* arena, const char* str);
+
+// 保证数组至少能容纳count+1个元素, 容量按2倍增长, 返回(可能移动过的)数组
+void* arena_array_reserve(Arena* arena, void* data, int count, int* capacity, size_t elem_size);
+
+#define ARENA_RESERVE(arena, data, count, capacity) \
+    ((data) = arena_array_reserve((arena), (data), (count), &(capacity), sizeof(*(data))))
+
+#endif // ARENA_H
@@ -160,7 +160,7 @@ bool type_is_compatible(Type* t1, Type* t2) {
 const char* type_to_string(Type* type) {
     if (!type) return "NULL";
     
-    static char buffer[256];
+    static _Thread_local char buffer[256];  // 线程局部缓冲区,允许多个线程并行报告错误
     
     switch (type->base_type) {
         case TYPE_VOID: return "void";
@@ -443,11 +443,15 @@ void ast_free(ASTNode* node) {
             break;
         case AST_VAR_DECL:
             free(node->data.var_decl.var_name);
+            // node->type与var_type指向同一对象,只释放一次
+            if (node->type == node->data.var_decl.var_type) node->type = NULL;
             type_free(node->data.var_decl.var_type);
             ast_free(node->data.var_decl.init_value);
             break;
         case AST_FUNC_DECL:
             free(node->data.func_decl.func_name);
+            // node->type与return_type指向同一对象,只释放一次
+            if (node->type == node->data.func_decl.return_type) node->type = NULL;
             type_free(node->data.func_decl.return_type);
             for (int i = 0; i < node->data.func_decl.param_count; i++) {
                 ast_free(node->data.func_decl.params[i]);
@@ -482,54 +486,168 @@ void ast_free(ASTNode* node) {
     free(node);
 }
 
-void ast_print(ASTNode* node, int indent) {
+int ast_count_nodes(ASTNode* node) {
+    if (!node) return 0;
+    
+    int count = 1;
+    switch (node->node_type) {
+        case AST_BINARY_OP:
+            count += ast_count_nodes(node->data.binary_op.left);
+            count += ast_count_nodes(node->data.binary_op.right);
+            break;
+        case AST_UNARY_OP:
+            count += ast_count_nodes(node->data.unary_op.operand);
+            break;
+        case AST_ARRAY_ACCESS:
+            count += ast_count_nodes(node->data.array_access.array);
+            count += ast_count_nodes(node->data.array_access.index);
+            break;
+        case AST_FUNC_CALL:
+            for (int i = 0; i < node->data.func_call.arg_count; i++) {
+                count += ast_count_nodes(node->data.func_call.args[i]);
+            }
+            break;
+        case AST_IF_STMT:
+            count += ast_count_nodes(node->data.if_stmt.condition);
+            count += ast_count_nodes(node->data.if_stmt.then_branch);
+            count += ast_count_nodes(node->data.if_stmt.else_branch);
+            break;
+        case AST_WHILE_STMT:
+            count += ast_count_nodes(node->data.while_stmt.condition);
+            count += ast_count_nodes(node->data.while_stmt.body);
+            break;
+        case AST_RETURN_STMT:
+            count += ast_count_nodes(node->data.return_stmt.return_value);
+            break;
+        case AST_VAR_DECL:
+            count += ast_count_nodes(node->data.var_decl.init_value);
+            break;
+        case AST_FUNC_DECL:
+            for (int i = 0; i < node->data.func_decl.param_count; i++) {
+                count += ast_count_nodes(node->data.func_decl.params[i]);
+            }
+            count += ast_count_nodes(node->data.func_decl.body);
+            break;
+        case AST_ASSIGN_STMT:
+            count += ast_count_nodes(node->data.assign_stmt.lvalue);
+            count += ast_count_nodes(node->data.assign_stmt.rvalue);
+            break;
+        case AST_COMPOUND_STMT:
+            for (int i = 0; i < node->data.compound_stmt.stmt_count; i++) {
+                count += ast_count_nodes(node->data.compound_stmt.statements[i]);
+            }
+            break;
+        case AST_EXPR_STMT:
+            count += ast_count_nodes(node->data.expr_stmt.expr);
+            break;
+        case AST_PROGRAM:
+            for (int i = 0; i < node->data.program.decl_count; i++) {
+                count += ast_count_nodes(node->data.program.declarations[i]);
+            }
+            break;
+        default:
+            break;
+    }
+    return count;
+}
+
+void ast_fprint(FILE* out, ASTNode* node, int indent) {
     if (!node) return;
     
-    for (int i = 0; i < indent; i++) printf("  ");
+    for (int i = 0; i < indent; i++) fprintf(out, "  ");
     
-    printf("%s", ast_node_type_str(node->node_type));
+    fprintf(out, "%s", ast_node_type_str(node->node_type));
     if (node->type) {
-        printf(" [type: %s]", type_to_string(node->type));
+        fprintf(out, " [type: %s]", type_to_string(node->type));
     }
-    printf("\n");
+    fprintf(out, "\n");
     
     switch (node->node_type) {
         case AST_BINARY_OP:
-            for (int i = 0; i < indent + 1; i++) printf("  ");
-            printf("op: %s\n", binary_op_str(node->data.binary_op.op));
-            ast_print(node->data.binary_op.left, indent + 1);
-            ast_print(node->data.binary_op.right, indent + 1);
+            for (int i = 0; i < indent + 1; i++) fprintf(out, "  ");
+            fprintf(out, "op: %s\n", binary_op_str(node->data.binary_op.op));
+            ast_fprint(out, node->data.binary_op.left, indent + 1);
+            ast_fprint(out, node->data.binary_op.right, indent + 1);
             break;
         case AST_UNARY_OP:
-            for (int i = 0; i < indent + 1; i++) printf("  ");
-            printf("op: %s\n", unary_op_str(node->data.unary_op.op));
-            ast_print(node->data.unary_op.operand, indent + 1);
+            for (int i = 0; i < indent + 1; i++) fprintf(out, "  ");
+            fprintf(out, "op: %s\n", unary_op_str(node->data.unary_op.op));
+            ast_fprint(out, node->data.unary_op.operand, indent + 1);
             break;
         case AST_LITERAL:
-            for (int i = 0; i < indent + 1; i++) printf("  ");
-            printf("value: %d\n", node->data.literal.value.int_value);
+            for (int i = 0; i < indent + 1; i++) fprintf(out, "  ");
+            fprintf(out, "value: %d\n", node->data.literal.value.int_value);
             break;
         case AST_IDENTIFIER:
-            for (int i = 0; i < indent + 1; i++) printf("  ");
-            printf("name: %s\n", node->data.identifier.name);
+            for (int i = 0; i < indent + 1; i++) fprintf(out, "  ");
+            fprintf(out, "name: %s\n", node->data.identifier.name);
             break;
         case AST_VAR_DECL:
-            for (int i = 0; i < indent + 1; i++) printf("  ");
-            printf("name: %s, type: %s\n", node->data.var_decl.var_name, 
+            for (int i = 0; i < indent + 1; i++) fprintf(out, "  ");
+            fprintf(out, "name: %s, type: %s\n", node->data.var_decl.var_name, 
                    type_to_string(node->data.var_decl.var_type));
             if (node->data.var_decl.init_value) {
-                ast_print(node->data.var_decl.init_value, indent + 1);
+                ast_fprint(out, node->data.var_decl.init_value, indent + 1);
             }
             break;
         case AST_ASSIGN_STMT:
-            ast_print(node->data.assign_stmt.lvalue, indent + 1);
-            ast_print(node->data.assign_stmt.rvalue, indent + 1);
+            ast_fprint(out, node->data.assign_stmt.lvalue, indent + 1);
+            ast_fprint(out, node->data.assign_stmt.rvalue, indent + 1);
+            break;
+        case AST_ARRAY_ACCESS:
+            ast_fprint(out, node->data.array_access.array, indent + 1);
+            ast_fprint(out, node->data.array_access.index, indent + 1);
+            break;
+        case AST_FUNC_CALL:
+            for (int i = 0; i < indent + 1; i++) fprintf(out, "  ");
+            fprintf(out, "name: %s\n", node->data.func_call.func_name);
+            for (int i = 0; i < node->data.func_call.arg_count; i++) {
+                ast_fprint(out, node->data.func_call.args[i], indent + 1);
+            }
+            break;
+        case AST_FUNC_DECL:
+            for (int i = 0; i < indent + 1; i++) fprintf(out, "  ");
+            fprintf(out, "name: %s, params: %d%s\n", node->data.func_decl.func_name,
+                   node->data.func_decl.param_count, node->data.func_decl.body ? "" : " (声明)");
+            for (int i = 0; i < node->data.func_decl.param_count; i++) {
+                ast_fprint(out, node->data.func_decl.params[i], indent + 1);
+            }
+            ast_fprint(out, node->data.func_decl.body, indent + 1);
+            break;
+        case AST_IF_STMT:
+            ast_fprint(out, node->data.if_stmt.condition, indent + 1);
+            ast_fprint(out, node->data.if_stmt.then_branch, indent + 1);
+            ast_fprint(out, node->data.if_stmt.else_branch, indent + 1);
+            break;
+        case AST_WHILE_STMT:
+            ast_fprint(out, node->data.while_stmt.condition, indent + 1);
+            ast_fprint(out, node->data.while_stmt.body, indent + 1);
+            break;
+        case AST_RETURN_STMT:
+            ast_fprint(out, node->data.return_stmt.return_value, indent + 1);
+            break;
+        case AST_EXPR_STMT:
+            ast_fprint(out, node->data.expr_stmt.expr, indent + 1);
+            break;
+        case AST_COMPOUND_STMT:
+            for (int i = 0; i < node->data.compound_stmt.stmt_count; i++) {
+                ast_fprint(out, node->data.compound_stmt.statements[i], indent + 1);
+            }
+            break;
+        case AST_PROGRAM:
+            for (int i = 0; i < node->data.program.decl_count; i++) {
+                ast_fprint(out, node->data.program.declarations[i], indent + 1);
+            }
             break;
         default:
             break;
     }
 }
 
+void ast_print(ASTNode* node, int indent) {
+    ast_fprint(stdout, node, indent);
+}
+
 const char* ast_node_type_str(ASTNodeType type) {
     switch (type) {
         case AST_BINARY_OP: return "BinaryOp";
@@ -3,6 +3,7 @@
 
 #include <stdbool.h>
 #include <stdlib.h>
+#include <stdio.h>
 
 // 前向声明
 typedef struct ASTNode ASTNode;
@@ -256,6 +257,8 @@ ASTNode* ast_create_program(ASTNode** declarations, int decl_count);
 
 void ast_free(ASTNode* node);
 void ast_print(ASTNode* node, int indent);
+void ast_fprint(FILE* out, ASTNode* node, int indent);
+int ast_count_nodes(ASTNode* node);
 const char* ast_node_type_str(ASTNodeType type);
 const char* binary_op_str(BinaryOp op);
 const char* unary_op_str(UnaryOp op);
@@ -0,0 +1,486 @@
+#include "ast_parser.h"
+#include <stdlib.h>
+#include <string.h>
+
+char* strdup(const char* s);
+
+// 递归下降解析器(构建AST)
+//
+// 支持的C子集:
+//   程序     := { 函数定义 | 函数声明 | 全局变量声明 | 语句 }
+//   声明     := ("int" | "void") 名字 [ "[" 常量 "]" ] [ "=" 表达式 ] { "," ... } ";"
+//   函数     := ("int" | "void") 名字 "(" [ "int" 名字 { "," "int" 名字 } | "void" ] ")" ( 复合语句 | ";" )
+//   语句     := 复合语句 | if | while | return | 声明 | 赋值 | 表达式 ";"
+//   表达式   := || → && → == != → < <= > >= → + - → * / % → 一元(- ! ++ --) → 后缀([] 调用) → 基本
+//
+// 顶层允许出现语句(脚本形式); 顶层最后一条简单语句可以省略分号。
+
+static ASTNode* parse_expression(ASTParser* parser);
+static ASTNode* parse_statement(ASTParser* parser, bool top_level);
+
+#define CUR(parser) ((parser)->lexer->current_token)
+
+// 节点列表(复合语句、参数、实参、全局声明)
+typedef struct NodeList {
+    ASTNode** items;
+    int count;
+    int capacity;
+} NodeList;
+
+static void node_list_append(NodeList* list, ASTNode* node) {
+    if (list->count == list->capacity) {
+        list->capacity = list->capacity ? list->capacity * 2 : 8;
+        list->items = (ASTNode**)realloc(list->items, sizeof(ASTNode*) * list->capacity);
+        if (!list->items) {
+            perror("malloc failed for NodeList");
+            exit(1);
+        }
+    }
+    list->items[list->count++] = node;
+}
+
+// 报告语法错误(只报告第一个,之后的解析结果将被丢弃)
+static void parser_error(ASTParser* parser, const char* message) {
+    if (!parser->has_errors) {
+        fprintf(parser->err, "语法错误 (行 %d): %s\n", CUR(parser).line, message);
+    }
+    parser->has_errors = true;
+}
+
+static bool accept(ASTParser* parser, TokenType type) {
+    if (CUR(parser).type == type) {
+        lexer_advance(parser->lexer);
+        return true;
+    }
+    return false;
+}
+
+static bool expect(ASTParser* parser, TokenType type, const char* message) {
+    if (parser->has_errors) return false;
+    if (accept(parser, type)) return true;
+    parser_error(parser, message);
+    return false;
+}
+
+// 复制表达式(用于把 a += b 展开为 a = a + b)
+static ASTNode* clone_expr(ASTNode* node) {
+    if (!node) return NULL;
+
+    switch (node->node_type) {
+        case AST_LITERAL:
+            return ast_create_int_literal(node->data.literal.value.int_value, node->line);
+        case AST_IDENTIFIER:
+            return ast_create_identifier(node->data.identifier.name, node->line);
+        case AST_BINARY_OP:
+            return ast_create_binary_op(node->data.binary_op.op,
+                                        clone_expr(node->data.binary_op.left),
+                                        clone_expr(node->data.binary_op.right), node->line);
+        case AST_UNARY_OP:
+            return ast_create_unary_op(node->data.unary_op.op,
+                                       clone_expr(node->data.unary_op.operand), node->line);
+        case AST_ARRAY_ACCESS:
+            return ast_create_array_access(clone_expr(node->data.array_access.array),
+                                           clone_expr(node->data.array_access.index), node->line);
+        case AST_FUNC_CALL: {
+            int count = node->data.func_call.arg_count;
+            ASTNode** args = NULL;
+            if (count > 0) {
+                args = (ASTNode**)malloc(sizeof(ASTNode*) * count);
+                if (!args) {
+                    perror("malloc failed for args");
+                    exit(1);
+                }
+                for (int i = 0; i < count; i++) {
+                    args[i] = clone_expr(node->data.func_call.args[i]);
+                }
+            }
+            return ast_create_func_call(node->data.func_call.func_name, args, count, node->line);
+        }
+        default:
+            return NULL;
+    }
+}
+
+// ========== 表达式 ==========
+
+static ASTNode* parse_primary(ASTParser* parser) {
+    if (parser->has_errors) return NULL;
+    int line = CUR(parser).line;
+
+    if (accept(parser, TOKEN_LPAREN)) {
+        ASTNode* expr = parse_expression(parser);
+        expect(parser, TOKEN_RPAREN, "期望 ')'");
+        return expr;
+    } else if (CUR(parser).type == TOKEN_INT_CONST) {
+        // 支持八进制/十六进制写法
+        int value = (int)strtol(CUR(parser).value, NULL, 0);
+        lexer_advance(parser->lexer);
+        return ast_create_int_literal(value, line);
+    } else if (CUR(parser).type == TOKEN_IDENTIFIER) {
+        char* name = strdup(CUR(parser).value);
+        lexer_advance(parser->lexer);
+
+        ASTNode* node;
+        if (accept(parser, TOKEN_LPAREN)) {
+            // 函数调用
+            NodeList args = { NULL, 0, 0 };
+            if (CUR(parser).type != TOKEN_RPAREN) {
+                do {
+                    node_list_append(&args, parse_expression(parser));
+                } while (!parser->has_errors && accept(parser, TOKEN_COMMA));
+            }
+            expect(parser, TOKEN_RPAREN, "函数调用期望 ')'");
+            node = ast_create_func_call(name, args.items, args.count, line);
+        } else {
+            node = ast_create_identifier(name, line);
+        }
+        free(name);
+        return node;
+    } else {
+        parser_error(parser, "期望标识符或常量");
+        return NULL;
+    }
+}
+
+static ASTNode* parse_postfix(ASTParser* parser) {
+    ASTNode* node = parse_primary(parser);
+
+    while (!parser->has_errors && CUR(parser).type == TOKEN_LBRACKET) {
+        int line = CUR(parser).line;
+        lexer_advance(parser->lexer);
+        ASTNode* index = parse_expression(parser);
+        expect(parser, TOKEN_RBRACKET, "期望 ']'");
+        node = ast_create_array_access(node, index, line);
+    }
+
+    return node;
+}
+
+static ASTNode* parse_unary(ASTParser* parser) {
+    if (parser->has_errors) return NULL;
+    int line = CUR(parser).line;
+
+    switch (CUR(parser).type) {
+        case TOKEN_MINUS:
+            lexer_advance(parser->lexer);
+            return ast_create_unary_op(OP_NEG, parse_unary(parser), line);
+        case TOKEN_PLUS:
+            lexer_advance(parser->lexer);
+            return parse_unary(parser);
+        case TOKEN_NOT:
+            lexer_advance(parser->lexer);
+            return ast_create_unary_op(OP_NOT, parse_unary(parser), line);
+        case TOKEN_INC:
+            lexer_advance(parser->lexer);
+            return ast_create_unary_op(OP_INC, parse_unary(parser), line);
+        case TOKEN_DEC:
+            lexer_advance(parser->lexer);
+            return ast_create_unary_op(OP_DEC, parse_unary(parser), line);
+        default:
+            return parse_postfix(parser);
+    }
+}
+
+// 二元运算符优先级表(从低到高), 每一层以TOKEN_EOF结尾
+typedef struct BinaryOpEntry {
+    TokenType token;
+    BinaryOp op;
+} BinaryOpEntry;
+
+static const BinaryOpEntry binary_precedence[][5] = {
+    { {TOKEN_OR, OP_OR}, {TOKEN_EOF, 0} },
+    { {TOKEN_AND, OP_AND}, {TOKEN_EOF, 0} },
+    { {TOKEN_EQ, OP_EQ}, {TOKEN_NE, OP_NE}, {TOKEN_EOF, 0} },
+    { {TOKEN_LT, OP_LT}, {TOKEN_LE, OP_LE}, {TOKEN_GT, OP_GT}, {TOKEN_GE, OP_GE}, {TOKEN_EOF, 0} },
+    { {TOKEN_PLUS, OP_ADD}, {TOKEN_MINUS, OP_SUB}, {TOKEN_EOF, 0} },
+    { {TOKEN_MUL, OP_MUL}, {TOKEN_DIV, OP_DIV}, {TOKEN_MOD, OP_MOD}, {TOKEN_EOF, 0} },
+};
+
+#define PRECEDENCE_LEVELS ((int)(sizeof(binary_precedence) / sizeof(binary_precedence[0])))
+
+// 解析第level层及更高优先级的左结合二元运算
+static ASTNode* parse_binary(ASTParser* parser, int level) {
+    if (level == PRECEDENCE_LEVELS) {
+        return parse_unary(parser);
+    }
+
+    ASTNode* left = parse_binary(parser, level + 1);
+    while (!parser->has_errors) {
+        const BinaryOpEntry* entry = binary_precedence[level];
+        while (entry->token != TOKEN_EOF && entry->token != CUR(parser).type) {
+            entry++;
+        }
+        if (entry->token == TOKEN_EOF) break;
+
+        int line = CUR(parser).line;
+        lexer_advance(parser->lexer);
+        ASTNode* right = parse_binary(parser, level + 1);
+        left = ast_create_binary_op(entry->op, left, right, line);
+    }
+
+    return left;
+}
+
+static ASTNode* parse_expression(ASTParser* parser) {
+    return parse_binary(parser, 0);
+}
+
+// ========== 声明 ==========
+
+// 解析 int/void 之后的变量声明列表, 每个变量追加到list
+static void parse_var_decls(ASTParser* parser, BaseType base, char* first_name, int line,
+                            NodeList* list) {
+    char* name = first_name;
+
+    while (1) {
+        Type* var_type = type_create_basic(base);
+        ASTNode* init_value = NULL;
+
+        if (accept(parser, TOKEN_LBRACKET)) {
+            int size = -1;
+            if (CUR(parser).type == TOKEN_INT_CONST) {
+                size = (int)strtol(CUR(parser).value, NULL, 0);
+                lexer_advance(parser->lexer);
+            } else {
+                parser_error(parser, "数组大小必须是整数常量");
+            }
+            expect(parser, TOKEN_RBRACKET, "期望 ']'");
+            var_type = type_create_array(var_type, size);
+        }
+        if (!parser->has_errors && accept(parser, TOKEN_ASSIGN)) {
+            init_value = parse_expression(parser);
+        }
+        node_list_append(list, ast_create_var_decl(name, var_type, init_value, line));
+        free(name);
+
+        if (parser->has_errors || !accept(parser, TOKEN_COMMA)) break;
+
+        line = CUR(parser).line;
+        if (CUR(parser).type != TOKEN_IDENTIFIER) {
+            parser_error(parser, "期望标识符");
+            return;
+        }
+        name = strdup(CUR(parser).value);
+        lexer_advance(parser->lexer);
+    }
+
+    expect(parser, TOKEN_SEMICOLON, "期望 ';'");
+}
+
+// 解析类型说明符, 不是 int/void 时返回TYPE_ERROR
+static BaseType parse_type_specifier(ASTParser* parser) {
+    if (accept(parser, TOKEN_INT)) return TYPE_INT;
+    if (accept(parser, TOKEN_VOID)) return TYPE_VOID;
+    return TYPE_ERROR;
+}
+
+// 解析函数参数列表(左括号已读入)
+static void parse_params(ASTParser* parser, NodeList* params) {
+    // f() 和 f(void) 都表示没有参数
+    if (accept(parser, TOKEN_RPAREN)) return;
+    if (CUR(parser).type == TOKEN_VOID) {
+        lexer_advance(parser->lexer);
+        expect(parser, TOKEN_RPAREN, "期望 ')'");
+        return;
+    }
+
+    do {
+        int line = CUR(parser).line;
+        if (!expect(parser, TOKEN_INT, "参数类型必须是 int")) return;
+        if (CUR(parser).type != TOKEN_IDENTIFIER) {
+            parser_error(parser, "期望参数名");
+            return;
+        }
+        Type* param_type = type_create_basic(TYPE_INT);
+        node_list_append(params, ast_create_var_decl(CUR(parser).value, param_type, NULL, line));
+        lexer_advance(parser->lexer);
+        if (CUR(parser).type == TOKEN_LBRACKET) {
+            parser_error(parser, "不支持数组参数");
+            return;
+        }
+    } while (accept(parser, TOKEN_COMMA));
+
+    expect(parser, TOKEN_RPAREN, "期望 ')'");
+}
+
+// ========== 语句 ==========
+
+static ASTNode* parse_compound(ASTParser* parser) {
+    int line = CUR(parser).line;
+    NodeList statements = { NULL, 0, 0 };
+
+    expect(parser, TOKEN_LBRACE, "期望 '{'");
+    while (!parser->has_errors && CUR(parser).type != TOKEN_RBRACE) {
+        if (CUR(parser).type == TOKEN_EOF) {
+            parser_error(parser, "期望 '}'");
+            break;
+        }
+
+        if (CUR(parser).type == TOKEN_INT) {
+            // 局部变量声明
+            int decl_line = CUR(parser).line;
+            lexer_advance(parser->lexer);
+            if (CUR(parser).type != TOKEN_IDENTIFIER) {
+                parser_error(parser, "期望标识符");
+                break;
+            }
+            char* name = strdup(CUR(parser).value);
+            lexer_advance(parser->lexer);
+            parse_var_decls(parser, TYPE_INT, name, decl_line, &statements);
+        } else {
+            node_list_append(&statements, parse_statement(parser, false));
+        }
+    }
+    expect(parser, TOKEN_RBRACE, "期望 '}'");
+
+    return ast_create_compound_stmt(statements.items, statements.count, line);
+}
+
+// 赋值、复合赋值、自增自减或表达式语句
+static ASTNode* parse_simple_statement(ASTParser* parser, bool top_level) {
+    int line = CUR(parser).line;
+    ASTNode* expr = parse_expression(parser);
+    ASTNode* stmt;
+
+    if (parser->has_errors) {
+        return ast_create_expr_stmt(expr, line);
+    }
+
+    switch (CUR(parser).type) {
+        case TOKEN_ASSIGN:
+            lexer_advance(parser->lexer);
+            stmt = ast_create_assign_stmt(expr, parse_expression(parser), line);
+            break;
+        case TOKEN_PLUS_EQ:
+        case TOKEN_MINUS_EQ: {
+            BinaryOp op = CUR(parser).type == TOKEN_PLUS_EQ ? OP_ADD : OP_SUB;
+            lexer_advance(parser->lexer);
+            ASTNode* value = ast_create_binary_op(op, clone_expr(expr), parse_expression(parser), line);
+            stmt = ast_create_assign_stmt(expr, value, line);
+            break;
+        }
+        case TOKEN_INC:
+        case TOKEN_DEC: {
+            // 后缀自增自减只作为独立语句出现, 此时与前缀形式等价
+            UnaryOp op = CUR(parser).type == TOKEN_INC ? OP_INC : OP_DEC;
+            lexer_advance(parser->lexer);
+            stmt = ast_create_expr_stmt(ast_create_unary_op(op, expr, line), line);
+            break;
+        }
+        default:
+            stmt = ast_create_expr_stmt(expr, line);
+            break;
+    }
+
+    // 顶层最后一条语句可以省略分号
+    if (!(top_level && CUR(parser).type == TOKEN_EOF)) {
+        expect(parser, TOKEN_SEMICOLON, "期望 ';'");
+    }
+    return stmt;
+}
+
+static ASTNode* parse_statement(ASTParser* parser, bool top_level) {
+    if (parser->has_errors) return NULL;
+    int line = CUR(parser).line;
+
+    switch (CUR(parser).type) {
+        case TOKEN_LBRACE:
+            return parse_compound(parser);
+
+        case TOKEN_IF: {
+            lexer_advance(parser->lexer);
+            expect(parser, TOKEN_LPAREN, "if 后期望 '('");
+            ASTNode* condition = parse_expression(parser);
+            expect(parser, TOKEN_RPAREN, "期望 ')'");
+            ASTNode* then_branch = parse_statement(parser, false);
+            ASTNode* else_branch = NULL;
+            if (!parser->has_errors && accept(parser, TOKEN_ELSE)) {
+                else_branch = parse_statement(parser, false);
+            }
+            return ast_create_if_stmt(condition, then_branch, else_branch, line);
+        }
+
+        case TOKEN_WHILE: {
+            lexer_advance(parser->lexer);
+            expect(parser, TOKEN_LPAREN, "while 后期望 '('");
+            ASTNode* condition = parse_expression(parser);
+            expect(parser, TOKEN_RPAREN, "期望 ')'");
+            ASTNode* body = parse_statement(parser, false);
+            return ast_create_while_stmt(condition, body, line);
+        }
+
+        case TOKEN_RETURN: {
+            lexer_advance(parser->lexer);
+            ASTNode* value = NULL;
+            if (CUR(parser).type != TOKEN_SEMICOLON) {
+                value = parse_expression(parser);
+            }
+            expect(parser, TOKEN_SEMICOLON, "期望 ';'");
+            return ast_create_return_stmt(value, line);
+        }
+
+        case TOKEN_SEMICOLON:
+            // 空语句
+            lexer_advance(parser->lexer);
+            return ast_create_compound_stmt(NULL, 0, line);
+
+        case TOKEN_INT:
+        case TOKEN_VOID:
+            parser_error(parser, "声明不能出现在这里");
+            return NULL;
+
+        default:
+            return parse_simple_statement(parser, top_level);
+    }
+}
+
+// 顶层: 函数定义/声明或全局变量声明(类型说明符已读入)
+static void parse_external_decl(ASTParser* parser, BaseType base, int line, NodeList* decls) {
+    if (CUR(parser).type != TOKEN_IDENTIFIER) {
+        parser_error(parser, "期望标识符");
+        return;
+    }
+    char* name = strdup(CUR(parser).value);
+    lexer_advance(parser->lexer);
+
+    if (!accept(parser, TOKEN_LPAREN)) {
+        parse_var_decls(parser, base, name, line, decls);
+        return;
+    }
+
+    NodeList params = { NULL, 0, 0 };
+    parse_params(parser, &params);
+
+    ASTNode* body = NULL;
+    if (!parser->has_errors && !accept(parser, TOKEN_SEMICOLON)) {
+        body = parse_compound(parser);
+    }
+
+    node_list_append(decls, ast_create_func_decl(name, type_create_basic(base),
+                                                 params.items, params.count, body, line));
+    free(name);
+}
+
+ASTNode* ast_parse_program(Lexer* lexer, FILE* err) {
+    ASTParser parser_state = { lexer, err, false };
+    ASTParser* parser = &parser_state;
+    NodeList decls = { NULL, 0, 0 };
+
+    while (!parser->has_errors && CUR(parser).type != TOKEN_EOF) {
+        int line = CUR(parser).line;
+        BaseType base = parse_type_specifier(parser);
+
+        if (base != TYPE_ERROR) {
+            parse_external_decl(parser, base, line, &decls);
+        } else {
+            node_list_append(&decls, parse_statement(parser, true));
+        }
+    }
+
+    ASTNode* program = ast_create_program(decls.items, decls.count);
+    if (parser->has_errors) {
+        ast_free(program);
+        return NULL;
+    }
+    return program;
+}
@@ -0,0 +1,20 @@
+#ifndef AST_PARSER_H
+#define AST_PARSER_H
+
+#include "lexer.h"
+#include "ast.h"
+#include <stdio.h>
+#include <stdbool.h>
+
+// ========== 语法分析器(构建AST) ==========
+
+typedef struct ASTParser {
+    Lexer* lexer;       // 词法分析器实例
+    FILE* err;          // 语法错误输出流
+    bool has_errors;    // 是否出现语法错误
+} ASTParser;
+
+// 解析整个输入,构建程序AST; 出现语法错误时返回NULL(错误信息写入err)
+ASTNode* ast_parse_program(Lexer* lexer, FILE* err);
+
+#endif // AST_PARSER_H
@@ -0,0 +1,71 @@
+int putchar(int c);
+
+int sieve[20000];
+int a[1024];
+int b[1024];
+int hits;
+
+int fib(int n) {
+    if (n < 2) return n;
+    return fib(n - 1) + fib(n - 2);
+}
+
+// 埃氏筛: 返回素数个数
+int primes(int n) {
+    int i = 2;
+    while (i < n) { sieve[i] = 1; i++; }
+    i = 2;
+    while (i * i < n) {
+        if (sieve[i]) {
+            int j = i * i;
+            while (j < n) { sieve[j] = 0; j = j + i; }
+        }
+        i++;
+    }
+    int count = 0;
+    i = 2;
+    while (i < n) { count = count + sieve[i]; i++; }
+    return count;
+}
+
+int gcd(int x, int y) {
+    while (y != 0) {
+        int t = x % y;
+        x = y;
+        y = t;
+    }
+    return x;
+}
+
+// 数组的点积和前缀和, 全局计数器的读-加-写
+int arrays(int rounds) {
+    int i = 0;
+    while (i < 1024) { a[i] = i % 17 - 8; b[i] = i % 13 + 1; i++; }
+    int s = 0;
+    int r = 0;
+    while (r < rounds) {
+        i = 1;
+        while (i < 1024) {
+            s = s + a[i] * b[i];
+            b[i] = b[i] + a[i - 1];
+            hits = hits + 1;
+            i++;
+        }
+        r++;
+    }
+    return s;
+}
+
+int main() {
+    int failures = 0;
+    if (fib(30) != 832040) failures++;
+    if (primes(20000) != 2262) failures++;
+    int g = 0;
+    int i = 1;
+    while (i < 3000) { g = g + gcd(i * 7919, 104729 + i); i++; }
+    if (g != 2999) failures++;
+    arrays(3000);
+    if (hits != 3000 * 1023) failures++;
+    if (failures == 0) { putchar(79); putchar(75); putchar(10); }
+    return failures;
+}
@@ -0,0 +1,349 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include "lexer.h"
+#include "ast.h"
+#include "ast_parser.h"
+#include "semantic_analyzer.h"
+#include "driver.h"
+#include "perf_report.h"
+#include "ir.h"
+#include "ir_lower.h"
+#include "ir_ssa.h"
+#include "ir_dce.h"
+#include "ir_regalloc.h"
+#include "x86_64.h"
+
+// ========== 前端基准测试 ==========
+//
+// 对每个输入文件重复运行各个前端阶段, 取每个阶段的最短耗时,
+// 按 MB/s、tokens/s、nodes/s 报告吞吐量, 并可与基线文件比较。
+//
+// 用法: bench_frontend [-n 次数] [--baseline 文件] [--save-baseline 文件] 文件...
+//
+// 基线文件每行一条记录: <文件名> <阶段> <毫秒>
+
+#define DEFAULT_ITERATIONS 5
+#define REGRESSION_THRESHOLD 10.0   // 变慢超过该百分比时标记
+
+typedef struct BenchResult {
+    const char* name;               // 文件名(不含目录)
+    size_t bytes;
+    long tokens;
+    int nodes;
+    double best[PHASE_COUNT];       // 每个阶段的最短耗时(秒)
+    bool ok;
+} BenchResult;
+
+typedef struct BaselineEntry {
+    char name[128];
+    char phase[32];
+    double ms;
+} BaselineEntry;
+
+typedef struct Baseline {
+    BaselineEntry* entries;
+    int count;
+    int capacity;
+} Baseline;
+
+static FILE* null_stream;
+
+static const char* base_name(const char* path) {
+    const char* slash = strrchr(path, '/');
+    return slash ? slash + 1 : path;
+}
+
+static void record_best(BenchResult* result, CompilePhase phase, double seconds) {
+    if (result->best[phase] < 0 || seconds < result->best[phase]) {
+        result->best[phase] = seconds;
+    }
+}
+
+// 只做词法分析, 返回Token数
+static long run_tokenize(const char* source, size_t length) {
+    Lexer* lexer = lexer_create_from_memory(source, length);
+    if (!lexer) {
+        return -1;
+    }
+    lexer->err = null_stream;
+
+    long tokens = 0;
+    while (lexer->current_token.type != TOKEN_EOF) {
+        tokens++;
+        lexer_advance(lexer);
+    }
+    lexer_destroy(lexer);
+    return tokens;
+}
+
+// 一次完整的前端流程, 各阶段耗时记入result
+static bool run_frontend(BenchResult* result, const char* source, size_t length) {
+    double start = perf_now();
+    long tokens = run_tokenize(source, length);
+    record_best(result, PHASE_TOKENIZE, perf_now() - start);
+    if (tokens < 0) {
+        return false;
+    }
+    result->tokens = tokens;
+
+    start = perf_now();
+    Lexer* lexer = lexer_create_from_memory(source, length);
+    if (!lexer) {
+        return false;
+    }
+    lexer->err = null_stream;
+    ASTNode* program = ast_parse_program(lexer, null_stream);
+    lexer_destroy(lexer);
+    record_best(result, PHASE_PARSE, perf_now() - start);
+    if (!program) {
+        return false;
+    }
+    result->nodes = ast_count_nodes(program);
+
+    PerfReport report;
+    perf_report_init(&report);
+    SemanticAnalyzer* analyzer = semantic_analyzer_create();
+    semantic_analyzer_set_output(analyzer, null_stream, null_stream);
+    analyzer->perf = &report;
+    semantic_analyze_program(analyzer, program);
+    record_best(result, PHASE_TYPE_CHECK, report.phases[PHASE_TYPE_CHECK].seconds);
+    record_best(result, PHASE_SEMANTIC, report.phases[PHASE_SEMANTIC].seconds);
+    record_best(result, PHASE_FOLD, report.phases[PHASE_FOLD].seconds);
+
+    if (!analyzer->has_errors) {
+        start = perf_now();
+        IRModule* module = ir_lower_program(program, null_stream);
+        record_best(result, PHASE_IR, perf_now() - start);
+
+        if (module) {
+            start = perf_now();
+            IRDCEStats dse;
+            memset(&dse, 0, sizeof(dse));
+            ir_module_dse(module, true, &dse);
+            ir_dce_stats_free(&dse);
+            double dse_seconds = perf_now() - start;
+
+            start = perf_now();
+            ir_module_to_ssa(module, NULL);
+            record_best(result, PHASE_SSA, perf_now() - start);
+
+            PerfReport opt_report;
+            perf_report_init(&opt_report);
+            driver_optimize_module(module, NULL, null_stream, &opt_report);
+            record_best(result, PHASE_OPT, dse_seconds + opt_report.phases[PHASE_OPT].seconds);
+
+            start = perf_now();
+            for (int f = 0; f < module->function_count; f++) {
+                if (!module->functions[f].is_defined) continue;
+                ir_regalloc_destroy(ir_regalloc_create(&module->functions[f], &x86_64_target));
+            }
+            record_best(result, PHASE_REGALLOC, perf_now() - start);
+        }
+        ir_module_destroy(module);
+    }
+
+    start = perf_now();
+    semantic_analyzer_destroy(analyzer);
+    ast_free(program);
+    record_best(result, PHASE_TEARDOWN, perf_now() - start);
+    return true;
+}
+
+static bool bench_file(BenchResult* result, const char* path, int iterations) {
+    memset(result, 0, sizeof(*result));
+    result->name = base_name(path);
+    for (int p = 0; p < PHASE_COUNT; p++) {
+        result->best[p] = -1;
+    }
+
+    FILE* in = fopen(path, "r");
+    if (!in) {
+        fprintf(stderr, "错误: 无法打开文件 '%s': %s\n", path, strerror(errno));
+        return false;
+    }
+    size_t length;
+    char* source = driver_read_stream(in, &length);
+    fclose(in);
+
+    result->bytes = length;
+    result->ok = true;
+    for (int i = 0; i < iterations && result->ok; i++) {
+        result->ok = run_frontend(result, source, length);
+    }
+    free(source);
+
+    if (!result->ok) {
+        fprintf(stderr, "错误: '%s' 无法通过语法分析, 已跳过\n", path);
+    }
+    return result->ok;
+}
+
+// ========== 基线文件 ==========
+
+static void baseline_load(Baseline* baseline, const char* path) {
+    baseline->entries = NULL;
+    baseline->count = 0;
+    baseline->capacity = 0;
+
+    FILE* in = fopen(path, "r");
+    if (!in) {
+        printf("基线文件 '%s' 不存在, 跳过比较\n", path);
+        return;
+    }
+
+    BaselineEntry entry;
+    while (fscanf(in, "%127s %31s %lf", entry.name, entry.phase, &entry.ms) == 3) {
+        if (baseline->count == baseline->capacity) {
+            baseline->capacity = baseline->capacity ? baseline->capacity * 2 : 32;
+            baseline->entries = realloc(baseline->entries,
+                                        baseline->capacity * sizeof(BaselineEntry));
+            if (!baseline->entries) {
+                perror("malloc failed for baseline");
+                exit(1);
+            }
+        }
+        baseline->entries[baseline->count++] = entry;
+    }
+    fclose(in);
+}
+
+static const BaselineEntry* baseline_find(const Baseline* baseline, const char* name,
+                                          const char* phase) {
+    for (int i = 0; i < baseline->count; i++) {
+        if (strcmp(baseline->entries[i].name, name) == 0 &&
+            strcmp(baseline->entries[i].phase, phase) == 0) {
+            return &baseline->entries[i];
+        }
+    }
+    return NULL;
+}
+
+static bool baseline_save(const char* path, const BenchResult* results, int count) {
+    FILE* out = fopen(path, "w");
+    if (!out) {
+        fprintf(stderr, "错误: 无法写入基线文件 '%s': %s\n", path, strerror(errno));
+        return false;
+    }
+    for (int i = 0; i < count; i++) {
+        if (!results[i].ok) continue;
+        for (int p = 0; p < PHASE_COUNT; p++) {
+            fprintf(out, "%s %s %.4f\n", results[i].name, compile_phase_key(p),
+                    results[i].best[p] * 1000.0);
+        }
+    }
+    fclose(out);
+    printf("基线已保存到 %s\n", path);
+    return true;
+}
+
+// ========== 报告 ==========
+
+static double per_second(double amount, double seconds) {
+    return seconds > 0 ? amount / seconds : 0.0;
+}
+
+static void print_result(const BenchResult* result, const Baseline* baseline) {
+    printf("\n%s: %.1f KB, %ld tokens, %d nodes\n", result->name,
+           result->bytes / 1024.0, result->tokens, result->nodes);
+    printf("  %-12s %10s %10s %12s %12s", "phase", "ms", "MB/s", "Mtokens/s", "Mnodes/s");
+    if (baseline) {
+        printf(" %10s %8s", "base ms", "delta");
+    }
+    printf("\n");
+
+    for (int p = 0; p < PHASE_COUNT; p++) {
+        double seconds = result->best[p];
+        printf("  %-12s %10.3f %10.2f %12.2f %12.2f", compile_phase_key(p), seconds * 1000.0,
+               per_second(result->bytes / (1024.0 * 1024.0), seconds),
+               per_second(result->tokens / 1e6, seconds),
+               per_second(result->nodes / 1e6, seconds));
+
+        const BaselineEntry* entry = baseline
+            ? baseline_find(baseline, result->name, compile_phase_key(p)) : NULL;
+        if (entry && entry->ms > 0) {
+            double delta = (seconds * 1000.0 - entry->ms) / entry->ms * 100.0;
+            printf(" %10.3f %+7.1f%%%s", entry->ms, delta,
+                   delta > REGRESSION_THRESHOLD ? " !" : "");
+        }
+        printf("\n");
+    }
+}
+
+static void print_usage(const char* program) {
+    fprintf(stderr, "用法: %s [-n 次数] [--baseline 文件] [--save-baseline 文件] 文件...\n", program);
+}
+
+int main(int argc, char* argv[]) {
+    int iterations = DEFAULT_ITERATIONS;
+    const char* baseline_path = NULL;
+    const char* save_path = NULL;
+    const char** files = malloc(argc * sizeof(const char*));
+    if (!files) {
+        perror("malloc failed for files");
+        exit(1);
+    }
+    int file_count = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            iterations = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--baseline") == 0 && i + 1 < argc) {
+            baseline_path = argv[++i];
+        } else if (strcmp(argv[i], "--save-baseline") == 0 && i + 1 < argc) {
+            save_path = argv[++i];
+        } else if (argv[i][0] == '-') {
+            print_usage(argv[0]);
+            return 1;
+        } else {
+            files[file_count++] = argv[i];
+        }
+    }
+    if (file_count == 0 || iterations < 1) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    null_stream = fopen("/dev/null", "w");
+    if (!null_stream) {
+        perror("无法打开 /dev/null");
+        return 1;
+    }
+
+    Baseline baseline;
+    if (baseline_path) {
+        baseline_load(&baseline, baseline_path);
+    }
+
+    BenchResult* results = malloc(file_count * sizeof(BenchResult));
+    if (!results) {
+        perror("malloc failed for results");
+        exit(1);
+    }
+
+    printf("前端基准测试: %d 个文件, 每个阶段取 %d 次中的最短耗时\n", file_count, iterations);
+    int failed = 0;
+    for (int i = 0; i < file_count; i++) {
+        if (!bench_file(&results[i], files[i], iterations)) {
+            failed++;
+            continue;
+        }
+        print_result(&results[i],
+                     baseline_path && baseline.count > 0 ? &baseline : NULL);
+    }
+
+    if (save_path && !baseline_save(save_path, results, file_count)) {
+        failed++;
+    }
+
+    if (baseline_path) {
+        free(baseline.entries);
+    }
+    free(results);
+    free(files);
+    fclose(null_stream);
+    return failed > 0 ? 1 : 0;
+}
@@ -0,0 +1,213 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/stat.h>
+
+// ========== 基准测试源文件生成器 ==========
+//
+// 生成按比例放大的合成C源文件, 分别侧重前端的不同压力点:
+//   decls.c     大量变量声明(符号表插入/查找)
+//   nesting.c   深层括号嵌套(递归下降深度)
+//   long_expr.c 超长表达式(Token吞吐与AST规模)
+//   comments.c  注释占多数的文件(词法分析跳过注释的速度)
+//   functions.c 大量带分支和循环的函数(中间代码生成和优化)
+//   redundant.c 反复出现相同子表达式的函数和顶层语句(值编号)
+//   loops.c     在小循环里反复计算边界和下标的数值内核(循环优化)
+//
+// 用法: bench_gen [-s 比例] [-o 输出目录]
+
+#define DEFAULT_OUTPUT_DIR "bench_data"
+
+// 基准规模(比例为1时)
+#define DECL_COUNT      20000
+#define NESTING_DEPTH   1000
+#define EXPR_TERMS      5000
+#define COMMENT_DECLS   2000
+#define FUNCTION_COUNT  1000
+#define REDUNDANT_COUNT 1000
+#define LOOP_COUNT      1000
+
+static FILE* open_output(const char* dir, const char* name) {
+    char path[1024];
+    snprintf(path, sizeof(path), "%s/%s", dir, name);
+
+    FILE* out = fopen(path, "w");
+    if (!out) {
+        fprintf(stderr, "错误: 无法创建文件 '%s': %s\n", path, strerror(errno));
+        exit(1);
+    }
+    printf("生成 %s\n", path);
+    return out;
+}
+
+// 大量声明, 最后一条赋值语句引用首尾两个变量
+static void generate_decls(const char* dir, int scale) {
+    FILE* out = open_output(dir, "decls.c");
+    int count = DECL_COUNT * scale;
+
+    for (int i = 0; i < count; i++) {
+        fprintf(out, "int v%d;\n", i);
+    }
+    fprintf(out, "v0 = v%d + %d\n", count - 1, count);
+    fclose(out);
+}
+
+// ((((a + 1) * 2) + 3) ...) 形式的深层嵌套
+static void generate_nesting(const char* dir, int scale) {
+    FILE* out = open_output(dir, "nesting.c");
+    int depth = NESTING_DEPTH * scale;
+    static const char ops[] = { '+', '*', '-', '+' };
+
+    fprintf(out, "int a;\nint r;\nr = ");
+    for (int i = 0; i < depth; i++) {
+        fputc('(', out);
+    }
+    fputc('a', out);
+    for (int i = 0; i < depth; i++) {
+        fprintf(out, " %c %d)", ops[i % 4], i % 9 + 1);
+    }
+    fprintf(out, "\n");
+    fclose(out);
+}
+
+// 一条很长的表达式, 混合变量、常量和少量括号分组
+static void generate_long_expr(const char* dir, int scale) {
+    FILE* out = open_output(dir, "long_expr.c");
+    int terms = EXPR_TERMS * scale;
+    static const char ops[] = { '+', '-', '*', '+', '/' };
+
+    fprintf(out, "int a;\nint b;\nint c;\nint r;\nr = a");
+    for (int i = 1; i < terms; i++) {
+        char op = ops[i % 5];
+        switch (i % 4) {
+            case 0: fprintf(out, " %c %d", op, i % 97 + 1); break;
+            case 1: fprintf(out, " %c b", op); break;
+            case 2: fprintf(out, " %c (c + %d)", op, i % 13 + 1); break;
+            default: fprintf(out, " %c a", op); break;
+        }
+        if (i % 8 == 0) {
+            fputc('\n', out);
+        }
+    }
+    fprintf(out, "\n");
+    fclose(out);
+}
+
+// 每个声明前都有块注释和行注释, 注释约占文件的九成
+static void generate_comments(const char* dir, int scale) {
+    FILE* out = open_output(dir, "comments.c");
+    int count = COMMENT_DECLS * scale;
+
+    for (int i = 0; i < count; i++) {
+        fprintf(out, "/*\n * 变量 c%d 的说明: 这段注释只用于测试词法分析器\n"
+                     " * 跳过注释的速度, 内容本身没有任何意义 * / ** //\n */\n", i);
+        fprintf(out, "// 行注释 %d: 同样会被词法分析器整体跳过 /* 不是块注释\n", i);
+        fprintf(out, "int c%d; // 行尾注释\n", i);
+    }
+    fprintf(out, "c0 = c%d * 2\n", count - 1);
+    fclose(out);
+}
+
+// 每个函数有参数、局部变量、if/while, 并调用前一个函数
+static void generate_functions(const char* dir, int scale) {
+    FILE* out = open_output(dir, "functions.c");
+    int count = FUNCTION_COUNT * scale;
+
+    fprintf(out, "int g;\n\n");
+    for (int i = 0; i < count; i++) {
+        fprintf(out, "int f%d(int a, int b) {\n", i);
+        fprintf(out, "    int s = %d;\n    int i = 0;\n", i % 17);
+        fprintf(out, "    while (i < a) {\n");
+        fprintf(out, "        if (i %% %d == 0 && b > s) {\n", i % 5 + 2);
+        fprintf(out, "            s = s + b * %d;\n", i % 7 + 1);
+        fprintf(out, "        } else {\n");
+        fprintf(out, "            s = s - i;\n");
+        fprintf(out, "        }\n");
+        fprintf(out, "        i++;\n    }\n");
+        if (i > 0) {
+            fprintf(out, "    s += f%d(s, a - 1);\n", i - 1);
+        }
+        fprintf(out, "    g = g + s;\n    return s;\n}\n\n");
+    }
+    fclose(out);
+}
+
+// 每个函数和顶层语句都多次计算 num1 * (num2 + k), 写法上交换了操作数顺序
+static void generate_redundant(const char* dir, int scale) {
+    FILE* out = open_output(dir, "redundant.c");
+    int count = REDUNDANT_COUNT * scale;
+
+    fprintf(out, "int num1;\nint num2;\nint result;\n\n");
+    for (int i = 0; i < count; i++) {
+        int k = i % 11 + 1;
+        fprintf(out, "int r%d(int a, int b) {\n", i);
+        fprintf(out, "    int x = a * (b + %d) / 2 - 10;\n", k);
+        fprintf(out, "    int y = (b + %d) * a + a * (%d + b);\n", k, k);
+        fprintf(out, "    if (a * (b + %d) > b + %d) y = y - (b + %d);\n", k, k, k);
+        fprintf(out, "    return x + y + (%d + b) * a;\n}\n\n", k);
+    }
+    for (int i = 0; i < count; i++) {
+        fprintf(out, "result = result + num1 * (num2 + %d) - (num2 + %d) * num1;\n", i % 5, i % 5);
+    }
+    fprintf(out, "result = result + 1\n");
+    fclose(out);
+}
+
+// 两层循环, 内层的循环边界、系数和全局变量的load在每次迭代中都不变
+static void generate_loops(const char* dir, int scale) {
+    FILE* out = open_output(dir, "loops.c");
+    int count = LOOP_COUNT * scale;
+
+    fprintf(out, "int data[256];\nint n;\nint factor;\n\n");
+    for (int i = 0; i < count; i++) {
+        int k = i % 13 + 1;
+        fprintf(out, "int k%d(int a, int b) {\n", i);
+        fprintf(out, "    int s = 0;\n    int i = 0;\n");
+        fprintf(out, "    while (i < n - 1) {\n");
+        fprintf(out, "        int j = 0;\n");
+        fprintf(out, "        while (j < a * b + %d) {\n", k);
+        fprintf(out, "            s = s + data[j %% 256] * factor + (a + %d) * b + j * %d;\n", k, k + 2);
+        fprintf(out, "            j = j + 1;\n        }\n");
+        fprintf(out, "        data[i %% 256] = s;\n");
+        fprintf(out, "        i = i + 1;\n    }\n");
+        fprintf(out, "    return s;\n}\n\n");
+    }
+    fclose(out);
+}
+
+int main(int argc, char* argv[]) {
+    int scale = 1;
+    const char* dir = DEFAULT_OUTPUT_DIR;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+            scale = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            dir = argv[++i];
+        } else {
+            fprintf(stderr, "用法: %s [-s 比例] [-o 输出目录]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (scale < 1) {
+        fprintf(stderr, "错误: 比例必须是正整数\n");
+        return 1;
+    }
+
+    if (mkdir(dir, 0755) != 0 && errno != EEXIST) {
+        fprintf(stderr, "错误: 无法创建目录 '%s': %s\n", dir, strerror(errno));
+        return 1;
+    }
+
+    generate_decls(dir, scale);
+    generate_nesting(dir, scale);
+    generate_long_expr(dir, scale);
+    generate_comments(dir, scale);
+    generate_functions(dir, scale);
+    generate_redundant(dir, scale);
+    generate_loops(dir, scale);
+    return 0;
+}
@@ -0,0 +1,946 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "driver.h"
+#include "lexer.h"
+#include "ast.h"
+#include "ast_parser.h"
+#include "symbol_table.h"
+#include "semantic_analyzer.h"
+#include "ir_lower.h"
+#include "ir_ssa.h"
+#include "ir_verify.h"
+#include "ir_sccp.h"
+#include "ir_tailcall.h"
+#include "ir_inline.h"
+#include "ir_gvn.h"
+#include "ir_licm.h"
+#include "ir_strength.h"
+#include "ir_dce.h"
+#include "ir_unroll.h"
+#include "profile.h"
+#include "ir_regalloc.h"
+#include "x86_64.h"
+#include "x86_codegen.h"
+#include "x86_asm.h"
+#include "x86_encode.h"
+#include "elf_object.h"
+#include "jit.h"
+#include "vm.h"
+#include "tiered.h"
+#include "outbuf.h"
+#include "trace.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include <unistd.h>
+
+// ========== 单文件编译 ==========
+
+void driver_options_init(DriverOptions* options) {
+    options->jobs = 0;
+    options->base_dir = NULL;
+    options->stdin_source = NULL;
+    options->stdin_length = 0;
+    options->time_report = false;
+    options->mem_report = false;
+    options->report_json = NULL;
+    options->trace = NULL;
+    options->dump_ir = false;
+    options->verify_ir = false;
+    options->opt_level = 1;
+    options->peephole = true;
+    options->share_frame_slots = true;
+    options->opt_report = false;
+    options->dump_regalloc = false;
+    options->emit_asm = false;
+    options->emit_object = false;
+    options->run = RUN_NONE;
+    options->allow_run = true;
+    options->allow_trace = true;
+    options->output = NULL;
+    options->profile_generate = NULL;
+    options->profile_use = NULL;
+}
+
+static char* resolve_path(const char* filename, const DriverOptions* options);
+
+// 校验失败说明前面的某一遍有错误, 编译失败
+static bool verify_module(const IRModule* module, const DriverOptions* options, const char* pass,
+                          FILE* err) {
+    if (!options || !options->verify_ir) return true;
+    if (ir_module_verify(module, err)) return true;
+
+    fprintf(err, "\033[31m内部错误: %s之后中间代码校验失败\033[0m\n", pass);
+    return false;
+}
+
+bool driver_optimize_module(IRModule* module, const DriverOptions* options, FILE* err,
+                            PerfReport* perf) {
+    int level = options ? options->opt_level : 1;
+    bool report = options && options->opt_report;
+    if (level <= 0) return true;
+
+    perf_phase_begin(perf, PHASE_OPT);
+    int instrs_before = report ? ir_module_instr_count(module) : 0;
+
+    IRSCCPStats sccp;
+    memset(&sccp, 0, sizeof(sccp));
+    ir_module_sccp(module, &sccp, err);
+    bool ok = verify_module(module, options, "常量传播", err);
+    if (report) {
+        fprintf(err, "常量传播: 删除指令 %d 条, 删除基本块 %d 个, 折叠分支 %d 个, 转发load %d 条\n",
+                sccp.removed_instrs, sccp.removed_blocks, sccp.folded_branches, sccp.forwarded_loads);
+    }
+
+    // 在内联之前消除尾递归: 改为循环之后函数不再递归, 可以被内联
+    IRTailCallStats tailcall;
+    memset(&tailcall, 0, sizeof(tailcall));
+    ir_module_eliminate_tail_recursion(module, &tailcall);
+    ok = ok && verify_module(module, options, "尾递归消除", err);
+    if (report) {
+        fprintf(err, "尾递归消除: 函数 %d 个, 尾调用改为循环 %d 处\n", tailcall.functions, tailcall.tail_calls);
+    }
+
+    // 内联之后对有内联的函数重新做常量传播(在ir_module_inline中)
+    IRInlineStats inlining;
+    memset(&inlining, 0, sizeof(inlining));
+    ir_module_inline(module, &inlining);
+    ok = ok && verify_module(module, options, "内联", err);
+    if (report) {
+        fprintf(err, "内联: 调用点 %d 个, 内联 %d 处, 递归不内联 %d 处, 热点放宽 %d 处, 未执行不内联 %d 处, "
+                "指令数 %d → %d\n", inlining.call_sites, inlining.inlined_calls, inlining.recursive_calls,
+                inlining.hot_calls, inlining.cold_calls, inlining.instrs_before, inlining.instrs_after);
+    }
+
+    IRGVNStats gvn;
+    memset(&gvn, 0, sizeof(gvn));
+    ir_module_gvn(module, &gvn);
+    ok = ok && verify_module(module, options, "值编号", err);
+    if (report) {
+        fprintf(err, "值编号: 删除冗余计算 %d 条\n", gvn.removed_instrs);
+    }
+
+    IRLICMStats licm;
+    memset(&licm, 0, sizeof(licm));
+    ir_module_licm(module, &licm);
+    ok = ok && verify_module(module, options, "循环不变量外提", err);
+    if (report) {
+        fprintf(err, "循环不变量外提: 循环 %d 个, 新建前置块 %d 个, 外提指令 %d 条\n",
+                licm.loops, licm.preheaders, licm.hoisted_instrs);
+    }
+
+    IRStrengthStats strength;
+    memset(&strength, 0, sizeof(strength));
+    ir_module_strength_reduce(module, &strength);
+    ok = ok && verify_module(module, options, "强度削弱", err);
+    if (report) {
+        fprintf(err, "强度削弱: 归纳变量 %d 个, 乘法改为递增 %d 处, 乘除改为移位 %d 处\n",
+                strength.induction_vars, strength.reduced_muls, strength.shifts);
+    }
+
+    IRDCEStats dce;
+    memset(&dce, 0, sizeof(dce));
+    ir_module_dce(module, &dce);
+    ok = ok && verify_module(module, options, "死代码删除", err);
+    if (report) {
+        fprintf(err, "死代码删除: 删除指令 %d 条\n", dce.removed_instrs);
+    }
+
+    // 在死代码删除之后展开, 复制的循环体里没有无用的指令
+    IRUnrollStats unroll;
+    memset(&unroll, 0, sizeof(unroll));
+    ir_module_unroll(module, &unroll);
+    ok = ok && verify_module(module, options, "循环展开", err);
+    if (report) {
+        fprintf(err, "循环展开: 计数循环 %d 个, 展开 %d 个, 向量化 %d 个, 迭代太少不展开 %d 个\n",
+                unroll.counted_loops, unroll.unrolled_loops, unroll.vectorized_loops, unroll.short_loops);
+        fprintf(err, "指令数: %d → %d\n", instrs_before, ir_module_instr_count(module));
+    }
+
+    perf_phase_end(perf, PHASE_OPT);
+    return ok;
+}
+
+// 按x86-64寄存器描述为每个函数分配寄存器并输出结果
+static void dump_register_allocation(IRModule* module, FILE* out, PerfReport* perf) {
+    fprintf(out, "\n=== 寄存器分配 ===\n");
+    for (int i = 0; i < module->function_count; i++) {
+        IRFunction* function = &module->functions[i];
+        if (!function->is_defined) continue;
+
+        perf_phase_begin(perf, PHASE_REGALLOC);
+        IRRegAlloc* alloc = ir_regalloc_create(function, &x86_64_target);
+        perf_phase_end(perf, PHASE_REGALLOC);
+        ir_regalloc_print(out, function, alloc);
+        ir_regalloc_destroy(alloc);
+    }
+}
+
+// 为每个定义了的函数分配寄存器、选择指令
+static X86Module* select_machine_code(IRModule* module, const DriverOptions* options, PerfReport* perf) {
+    X86Module* x86 = x86_module_create(module);
+    x86->peephole = !options || (options->peephole && options->opt_level > 0);
+    x86->share_frame_slots = !options || (options->share_frame_slots && options->opt_level > 0);
+    for (int i = 0; i < module->function_count; i++) {
+        IRFunction* function = &module->functions[i];
+        if (!function->is_defined) continue;
+
+        perf_phase_begin(perf, PHASE_REGALLOC);
+        IRRegAlloc* alloc = ir_regalloc_create(function, &x86_64_target);
+        perf_phase_end(perf, PHASE_REGALLOC);
+        perf_phase_begin(perf, PHASE_CODEGEN);
+        x86_module_add_function(x86, i, alloc);
+        perf_phase_end(perf, PHASE_CODEGEN);
+        ir_regalloc_destroy(alloc);
+    }
+    return x86;
+}
+
+static void report_codegen(const X86Module* x86, const X86Code* code, FILE* err) {
+    const X86CodegenStats* stats = &x86->stats;
+    fprintf(err, "代码生成: 函数 %d 个, 机器指令 %d 条, 读溢出槽 %d 次, 写溢出槽 %d 次, 栈帧共 %d 字节"
+            "(共用栈槽的对象 %d 个), 尾调用 %d 处, 冷块后移 %d 个\n", stats->functions, stats->instrs,
+            stats->spill_loads, stats->spill_stores, stats->frame_bytes, stats->frame_shared, stats->tail_calls,
+            stats->cold_blocks);
+    fprintf(err, "窥孔优化: 改写 %d 处, 删除指令 %d 条\n", stats->peephole, stats->peephole_removed);
+    if (code) {
+        fprintf(err, "机器码: %zu 字节, 重定位 %d 个, 长跳转 %d 条\n",
+                code->text.length, code->reloc_count, code->long_jumps);
+    }
+}
+
+// 把汇编(-S)或直接编码的目标文件(-c)写到path
+static bool emit_code(IRModule* module, const DriverOptions* options, const char* path, FILE* err,
+                      PerfReport* perf) {
+    X86Module* x86 = select_machine_code(module, options, perf);
+
+    perf_phase_begin(perf, PHASE_CODEGEN);
+    bool ok = false;
+    bool object = !options->emit_asm;
+    X86Code* code = object ? x86_code_create(x86) : NULL;
+    FILE* file = fopen(path, object ? "wb" : "w");
+    if (file) {
+        OutBuf out;
+        outbuf_init(&out, file);
+        if (object) elf_object_write(&out, x86, code);
+        else x86_asm_emit_module(&out, x86);
+        ok = outbuf_flush(&out);
+        outbuf_free(&out);
+        ok = fclose(file) == 0 && ok;
+    }
+    if (!ok) fprintf(err, "无法写入%s文件 %s: %s\n", object ? "目标" : "汇编", path, strerror(errno));
+    perf_phase_end(perf, PHASE_CODEGEN);
+
+    if (options->opt_report) report_codegen(x86, code, err);
+    x86_code_destroy(code);
+    x86_module_destroy(x86);
+    return ok;
+}
+
+// --profile-generate: 程序结束后把计数器(插桩的全局变量)的内容写入profile文件
+static bool write_profile(const IRModule* module, const ProfileLayout* profile, const void* counters,
+                          const DriverOptions* options, FILE* err) {
+    char* path = resolve_path(options->profile_generate, options);
+    bool ok = profile_write(module, profile, counters, path, err);
+    free(path);
+    return ok;
+}
+
+// --run: 把机器码装入本进程的内存, 执行顶层语句和main, main的返回值写入exit_status
+static bool run_native(IRModule* module, const DriverOptions* options, const ProfileLayout* profile,
+                       int* exit_status, FILE* err, PerfReport* perf) {
+    X86Module* x86 = select_machine_code(module, options, perf);
+    perf_phase_begin(perf, PHASE_CODEGEN);
+    X86Code* code = x86_code_create(x86);
+    JitProgram* program = jit_program_create(x86, code, err);
+    perf_phase_end(perf, PHASE_CODEGEN);
+    if (options->opt_report) report_codegen(x86, code, err);
+
+    bool ok = false;
+    if (program) {
+        fflush(err);
+        ok = jit_program_run(program, exit_status, err);
+        fflush(stdout);
+        if (ok && profile && profile->global >= 0) {
+            ok = write_profile(module, profile, program->globals[profile->global], options, err);
+        }
+        jit_program_destroy(program);
+    }
+    x86_code_destroy(code);
+    x86_module_destroy(x86);
+    return ok;
+}
+
+// --run=vm: 编译成字节码解释执行
+static bool run_bytecode(IRModule* module, const DriverOptions* options, const ProfileLayout* profile,
+                         int* exit_status, FILE* err, PerfReport* perf) {
+    perf_phase_begin(perf, PHASE_CODEGEN);
+    VMProgram* program = vm_program_create(module, err);
+    perf_phase_end(perf, PHASE_CODEGEN);
+    if (!program) return false;
+    if (options->opt_report) {
+        const VMStats* stats = &program->stats;
+        fprintf(err, "字节码: 函数 %d 个, 指令 %d 条, 比较跳转 %d 条, 读-加-写 %d 条, 尾调用 %d 条\n",
+                stats->functions, stats->instrs, stats->fused_branches, stats->fused_updates, stats->tail_calls);
+    }
+
+    fflush(err);
+    bool ok = vm_program_run(program, exit_status, err);
+    fflush(stdout);
+    if (ok && profile && profile->global >= 0) {
+        ok = write_profile(module, profile, program->globals + program->global_offsets[profile->global], options, err);
+    }
+    vm_program_destroy(program);
+    return ok;
+}
+
+// --run=tiered: 解释执行, 热点函数由后台线程编译后换成机器码; 后台编译计入PHASE_JIT
+static bool run_tiered(IRModule* module, const DriverOptions* options, const ProfileLayout* profile,
+                       int* exit_status, FILE* err, PerfReport* perf) {
+    perf_phase_begin(perf, PHASE_CODEGEN);
+    TieredProgram* program = tiered_program_create(module, 0, 0, err);
+    perf_phase_end(perf, PHASE_CODEGEN);
+    if (!program) return false;
+
+    fflush(err);
+    bool ok = tiered_program_run(program, exit_status, err);
+    fflush(stdout);
+    // 先停下后台线程, 统计才完整
+    tiered_program_stop(program);
+    if (ok && profile && profile->global >= 0) {
+        ok = write_profile(module, profile, program->globals[profile->global], options, err);
+    }
+    if (options->opt_report) {
+        const TierStats* stats = &program->perf.tier;
+        fprintf(err, "分层执行: 请求编译 %d 个函数, 编译 %d 批, 换成本机代码 %d 个函数\n",
+                stats->requests, stats->units, stats->compiled);
+    }
+    if (perf) perf_report_merge(perf, &program->perf);
+    tiered_program_destroy(program);
+    return ok;
+}
+
+// profile不为NULL时程序经过插桩(--profile-generate), 结束后写出计数
+static bool run_program(IRModule* module, const DriverOptions* options, const ProfileLayout* profile,
+                        int* exit_status, FILE* err, PerfReport* perf) {
+    if (options->run == RUN_VM) return run_bytecode(module, options, profile, exit_status, err, perf);
+    if (options->run == RUN_TIERED) return run_tiered(module, options, profile, exit_status, err, perf);
+    return run_native(module, options, profile, exit_status, err, perf);
+}
+
+// 在SSA构造之后、优化之前: --profile-generate插入计数, --profile-use读取计数;
+// 两种情况下IR的改动(拆分关键边)相同, 各函数的校验和才能对上。读不到profile时只警告, 照常编译
+static ProfileLayout* prepare_profile(IRModule* module, const DriverOptions* options, FILE* err, PerfReport* perf) {
+    perf_phase_begin(perf, PHASE_OPT);
+    ProfileLayout* layout = profile_layout_create(module);
+    ProfileStats stats;
+    memset(&stats, 0, sizeof(stats));
+    if (options->profile_generate) {
+        profile_instrument(module, layout, &stats);
+        if (options->opt_report) {
+            fprintf(err, "profile插桩: 函数 %d 个, 计数器 %d 个\n", stats.functions, stats.counters);
+        }
+    } else {
+        char* path = resolve_path(options->profile_use, options);
+        bool ok = profile_apply(module, layout, path, &stats, err);
+        free(path);
+        if (ok && options->opt_report) {
+            fprintf(err, "profile: 使用计数的函数 %d 个, 源代码已修改 %d 个, 没有记录 %d 个\n",
+                    stats.matched, stats.mismatched, stats.missing);
+        }
+    }
+    perf_phase_end(perf, PHASE_OPT);
+    return layout;
+}
+
+// 死存储分析在SSA构造之前进行(之后局部变量的读写就看不到了),
+// 发现的未使用变量和无用赋值交给语义分析器报告; -O0时只报告不删除
+static bool eliminate_dead_stores(IRModule* module, const DriverOptions* options,
+                                  SemanticAnalyzer* analyzer, FILE* err, PerfReport* perf) {
+    bool remove = !options || options->opt_level > 0;
+
+    perf_phase_begin(perf, PHASE_OPT);
+    IRDCEStats stats;
+    memset(&stats, 0, sizeof(stats));
+    ir_module_dse(module, remove, &stats);
+    perf_phase_end(perf, PHASE_OPT);
+
+    for (int i = 0; i < stats.note_count; i++) {
+        const IRDeadNote* note = &stats.notes[i];
+        semantic_note_unused(analyzer, note->name, note->line, note->kind == IR_DEAD_STORE);
+    }
+    check_unused_variables(analyzer);
+    if (options && options->opt_report && remove) {
+        fprintf(err, "死存储: 删除store %d 条\n", stats.removed_stores);
+    }
+    ir_dce_stats_free(&stats);
+    return verify_module(module, options, "死存储删除", err);
+}
+
+// code_path: -S/-c时汇编或目标文件的输出路径; exit_status: --run时写入程序的返回值
+static bool compile_lexer(Lexer* lexer, const DriverOptions* options, const char* code_path,
+                          int* exit_status, FILE* out, FILE* err, PerfReport* perf) {
+    // 打印 Token 流
+    perf_phase_begin(perf, PHASE_TOKENIZE);
+    fprintf(out, "=== Token 流 ===\n");
+    lexer->err = err;
+    
+    while (1) {
+        Token token = lexer->current_token;
+        fprintf(out, "[%s] -> %s\n", token_type_str(token.type), token.value ? token.value : "NULL");
+        
+        if (token.type == TOKEN_EOF) {
+            break;
+        }
+        
+        lexer_advance(lexer);
+    }
+    fprintf(out, "=== Token 流结束 ===\n\n");
+    perf_phase_end(perf, PHASE_TOKENIZE);
+
+    // 构建AST并进行语义分析
+    perf_phase_begin(perf, PHASE_PARSE);
+    if (lexer_rewind(lexer) != 0) {
+        lexer_destroy(lexer);
+        return false;
+    }
+    
+    fprintf(out, "=== 构建AST ===\n");
+    ASTNode* program = ast_parse_program(lexer, err);
+    lexer_destroy(lexer);
+    perf_phase_end(perf, PHASE_PARSE);
+    if (!program) {
+        fprintf(out, "\n\033[31m编译失败!\033[0m\n");
+        return false;
+    }
+    fprintf(out, "AST构建完成\n\n");
+    
+    // 打印AST
+    fprintf(out, "=== 抽象语法树结构 ===\n");
+    ast_fprint(out, program, 0);
+    fprintf(out, "\n");
+    
+    // 创建语义分析器
+    SemanticAnalyzer* analyzer = semantic_analyzer_create();
+    semantic_analyzer_set_output(analyzer, out, err);
+    analyzer->perf = perf;
+    
+    // 进行语义分析(包含类型检查和常量折叠)
+    bool success = semantic_analyze_program(analyzer, program);
+    
+    // 打印符号表
+    symbol_table_fprint(out, analyzer->symbol_table);
+    
+    // 生成中间代码
+    if (success) {
+        perf_phase_begin(perf, PHASE_IR);
+        IRModule* module = ir_lower_program(program, err);
+        perf_phase_end(perf, PHASE_IR);
+        
+        if (!module) {
+            success = false;
+        } else {
+            success = verify_module(module, options, "IR生成", err);
+            success = success && eliminate_dead_stores(module, options, analyzer, err, perf);
+
+            perf_phase_begin(perf, PHASE_SSA);
+            ir_module_to_ssa(module, NULL);
+            perf_phase_end(perf, PHASE_SSA);
+            success = success && verify_module(module, options, "SSA构造", err);
+
+            ProfileLayout* profile = NULL;
+            if (success && options && (options->profile_generate || options->profile_use)) {
+                profile = prepare_profile(module, options, err, perf);
+                success = verify_module(module, options, "profile插桩", err);
+            }
+            success = success && driver_optimize_module(module, options, err, perf);
+
+            if (options && options->dump_ir) {
+                fprintf(out, "\n=== 中间代码 ===\n");
+                ir_module_print(out, module);
+            }
+            if (success && options && options->dump_regalloc) {
+                dump_register_allocation(module, out, perf);
+            }
+            if (success && code_path) {
+                success = emit_code(module, options, code_path, err, perf);
+            }
+            if (success && exit_status) {
+                success = run_program(module, options, options->profile_generate ? profile : NULL, exit_status,
+                                      err, perf);
+            }
+            profile_layout_destroy(profile);
+        }
+        ir_module_destroy(module);
+    }
+    
+    // 清理资源
+    perf_phase_begin(perf, PHASE_TEARDOWN);
+    semantic_analyzer_destroy(analyzer);
+    ast_free(program);
+    perf_phase_end(perf, PHASE_TEARDOWN);
+    
+    if (success) {
+        fprintf(out, "\n\033[32m编译成功!\033[0m\n");
+    } else {
+        fprintf(out, "\n\033[31m编译失败!\033[0m\n");
+    }
+    return success;
+}
+
+// 按驱动选项解析路径: 相对路径基于base_dir, 返回值需要释放
+static char* resolve_path(const char* filename, const DriverOptions* options) {
+    if (!options->base_dir || filename[0] == '/') {
+        return strdup(filename);
+    }
+    
+    size_t size = strlen(options->base_dir) + strlen(filename) + 2;
+    char* path = (char*)malloc(size);
+    if (!path) {
+        perror("malloc failed for path");
+        exit(1);
+    }
+    snprintf(path, size, "%s/%s", options->base_dir, filename);
+    return path;
+}
+
+// 汇编或目标文件的输出路径: -o指定的文件(相对base_dir), 否则把输入文件的扩展名换成.s或.o; 返回值需要释放
+static char* output_path(const char* input, const DriverOptions* options) {
+    if (options->output) return resolve_path(options->output, options);
+
+    const char* slash = strrchr(input, '/');
+    const char* dot = strrchr(input, '.');
+    size_t stem = dot && (!slash || dot > slash) ? (size_t)(dot - input) : strlen(input);
+    char* path = (char*)malloc(stem + 3);
+    if (!path) {
+        perror("malloc failed for path");
+        exit(1);
+    }
+    memcpy(path, input, stem);
+    memcpy(path + stem, options->emit_asm ? ".s" : ".o", 3);
+    return path;
+}
+
+// exit_status不为NULL时(--run)编译后直接执行程序
+static bool compile_path(const char* filename, const DriverOptions* options, int* exit_status, FILE* out,
+                         FILE* err, PerfReport* perf) {
+    Lexer* lexer = lexer_create(filename);
+    if (!lexer) {
+        fprintf(err, "Open file failed: %s\n", strerror(errno));
+        return false;
+    }
+    bool emit = options && (options->emit_asm || options->emit_object);
+    char* code_path = emit ? output_path(filename, options) : NULL;
+    bool success = compile_lexer(lexer, options, code_path, exit_status, out, err, perf);
+    free(code_path);
+    return success;
+}
+
+static bool compile_memory(const char* name, const char* source, size_t length, const DriverOptions* options,
+                           int* exit_status, FILE* out, FILE* err, PerfReport* perf) {
+    Lexer* lexer = lexer_create_from_memory(source, length);
+    if (!lexer) {
+        fprintf(err, "%s: 无法读取源代码: %s\n", name, strerror(errno));
+        return false;
+    }
+    char* code_path = NULL;
+    if (options && (options->emit_asm || options->emit_object)) {
+        // 标准输入没有文件名, 输出到a.s或a.o
+        char* input = resolve_path("a.c", options);
+        code_path = output_path(input, options);
+        free(input);
+    }
+    bool success = compile_lexer(lexer, options, code_path, exit_status, out, err, perf);
+    free(code_path);
+    return success;
+}
+
+bool compile_file(const char* filename, const DriverOptions* options, FILE* out, FILE* err,
+                  PerfReport* perf) {
+    return compile_path(filename, options, NULL, out, err, perf);
+}
+
+bool compile_source(const char* name, const char* source, size_t length,
+                    const DriverOptions* options, FILE* out, FILE* err, PerfReport* perf) {
+    return compile_memory(name, source, length, options, NULL, out, err, perf);
+}
+
+// 按驱动选项编译一个任务: "-"表示stdin_source, 相对路径基于base_dir
+static bool compile_job_input(CompileJob* job, const DriverOptions* options, FILE* out, FILE* err) {
+    const char* filename = job->filename;
+    int* exit_status = options->run ? &job->exit_status : NULL;
+    
+    if (strcmp(filename, "-") == 0) {
+        if (!options->stdin_source) {
+            fprintf(err, "没有提供标准输入的源代码\n");
+            return false;
+        }
+        return compile_memory("<stdin>", options->stdin_source, options->stdin_length,
+                              options, exit_status, out, err, &job->perf);
+    }
+    
+    char* path = resolve_path(filename, options);
+    bool success = compile_path(path, options, exit_status, out, err, &job->perf);
+    free(path);
+    return success;
+}
+
+static bool compile_job(CompileJob* job, const DriverOptions* options, FILE* out, FILE* err) {
+    trace_begin("file", job->filename);
+    bool success = compile_job_input(job, options, out, err);
+    trace_end();
+    return success;
+}
+
+// ========== 线程池 ==========
+
+typedef struct JobQueue {
+    CompileJob* jobs;
+    const DriverOptions* options;
+    int count;
+    int next;                   // 下一个待领取的任务下标
+    pthread_mutex_t lock;
+    pthread_cond_t job_done;    // 有任务完成时广播
+} JobQueue;
+
+static void run_job(CompileJob* job, const DriverOptions* options) {
+    FILE* out = open_memstream(&job->out_buf, &job->out_len);
+    FILE* err = open_memstream(&job->err_buf, &job->err_len);
+    if (!out || !err) {
+        perror("open_memstream failed");
+        exit(1);
+    }
+    
+    job->success = compile_job(job, options, out, err);
+    
+    fclose(out);
+    fclose(err);
+}
+
+static void* worker_main(void* arg) {
+    JobQueue* queue = (JobQueue*)arg;
+    
+    while (1) {
+        pthread_mutex_lock(&queue->lock);
+        int index = queue->next++;
+        pthread_mutex_unlock(&queue->lock);
+        
+        if (index >= queue->count) break;
+        
+        run_job(&queue->jobs[index], queue->options);
+        
+        pthread_mutex_lock(&queue->lock);
+        queue->jobs[index].done = true;
+        pthread_cond_broadcast(&queue->job_done);
+        pthread_mutex_unlock(&queue->lock);
+    }
+    
+    return NULL;
+}
+
+int driver_default_jobs(void) {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    return cpus > 0 ? (int)cpus : 1;
+}
+
+int driver_compile_jobs(CompileJob* jobs, int count, const DriverOptions* options,
+                        FILE* out, FILE* err) {
+    if (count <= 0) return 0;
+    int thread_count = options->jobs > 0 ? options->jobs : driver_default_jobs();
+    if (thread_count > count) thread_count = count;
+    
+    JobQueue queue;
+    queue.jobs = jobs;
+    queue.options = options;
+    queue.count = count;
+    queue.next = 0;
+    pthread_mutex_init(&queue.lock, NULL);
+    pthread_cond_init(&queue.job_done, NULL);
+    
+    pthread_t* threads = (pthread_t*)malloc(sizeof(pthread_t) * thread_count);
+    if (!threads) {
+        perror("malloc failed for threads");
+        exit(1);
+    }
+    for (int i = 0; i < thread_count; i++) {
+        if (pthread_create(&threads[i], NULL, worker_main, &queue) != 0) {
+            perror("pthread_create failed");
+            exit(1);
+        }
+    }
+    
+    // 按输入顺序输出结果: 等待第i个任务完成后立即输出,保证输出确定
+    int failed = 0;
+    for (int i = 0; i < count; i++) {
+        CompileJob* job = &jobs[i];
+        
+        pthread_mutex_lock(&queue.lock);
+        while (!job->done) {
+            pthread_cond_wait(&queue.job_done, &queue.lock);
+        }
+        pthread_mutex_unlock(&queue.lock);
+        
+        fprintf(out, "########## 文件: %s ##########\n", job->filename);
+        fwrite(job->out_buf, 1, job->out_len, out);
+        fflush(out);
+        fwrite(job->err_buf, 1, job->err_len, err);
+        fflush(err);
+        fprintf(out, "\n");
+        
+        if (!job->success) failed++;
+        free(job->out_buf);
+        free(job->err_buf);
+        job->out_buf = NULL;
+        job->err_buf = NULL;
+    }
+    
+    for (int i = 0; i < thread_count; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    free(threads);
+    pthread_mutex_destroy(&queue.lock);
+    pthread_cond_destroy(&queue.job_done);
+    
+    fprintf(out, "共 %d 个文件, %d 个成功, %d 个失败\n", count, count - failed, failed);
+    return failed;
+}
+
+// ========== 阶段统计输出 ==========
+
+// "-"写到本次编译的out(常驻服务中即回复给客户端的输出), 其他路径相对base_dir
+static bool write_json_report(const CompileJob* jobs, int count, const PerfReport* total,
+                              const DriverOptions* options, FILE* out, FILE* err) {
+    FILE* file = out;
+    if (strcmp(options->report_json, "-") != 0) {
+        char* path = resolve_path(options->report_json, options);
+        file = fopen(path, "w");
+        if (!file) {
+            fprintf(err, "无法写入统计文件 %s: %s\n", path, strerror(errno));
+            free(path);
+            return false;
+        }
+        free(path);
+    }
+    
+    fprintf(file, "{\"version\": \"%s\", \"files\": [", COMPILER_VERSION);
+    for (int i = 0; i < count; i++) {
+        fprintf(file, "%s\n  {\"file\": ", i > 0 ? "," : "");
+        perf_json_fprint_string(file, jobs[i].filename);
+        fprintf(file, ", \"success\": %s, \"phases\": ", jobs[i].success ? "true" : "false");
+        perf_report_print_json(&jobs[i].perf, file);
+        fprintf(file, "}");
+    }
+    fprintf(file, "\n], \"total\": ");
+    perf_report_print_json(total, file);
+    fprintf(file, "}\n");
+    
+    if (file != out) fclose(file);
+    return true;
+}
+
+// ========== 命令行 ==========
+
+char* driver_read_stream(FILE* file, size_t* length) {
+    size_t capacity = 4096;
+    size_t size = 0;
+    char* data = (char*)malloc(capacity);
+    if (!data) {
+        perror("malloc failed for source");
+        exit(1);
+    }
+    
+    size_t n;
+    while ((n = fread(data + size, 1, capacity - size, file)) > 0) {
+        size += n;
+        if (size == capacity) {
+            capacity *= 2;
+            data = (char*)realloc(data, capacity);
+            if (!data) {
+                perror("realloc failed for source");
+                exit(1);
+            }
+        }
+    }
+    *length = size;
+    return data;
+}
+
+void driver_print_usage(const char* prog, FILE* err) {
+    fprintf(err, "Usage: %s [options] <input.c>...\n", prog);
+    fprintf(err, "       %s --server[=socket]            常驻编译服务\n", prog);
+    fprintf(err, "       %s --connect[=socket] [args...] 通过编译服务编译\n", prog);
+    fprintf(err, "选项:\n");
+    fprintf(err, "  -j N                 并行编译的线程数(默认CPU核数)\n");
+    fprintf(err, "  -ftime-report        输出各编译阶段的耗时\n");
+    fprintf(err, "  -fmem-report         输出各编译阶段的内存分配次数/字节数/峰值RSS\n");
+    fprintf(err, "  -freport-json=FILE   以JSON输出全部阶段统计(FILE为-时写到标准输出)\n");
+    fprintf(err, "  --trace=FILE         输出Chrome/Perfetto跟踪事件(各阶段及每个函数的耗时)\n");
+    fprintf(err, "  -fdump-ir            输出中间代码\n");
+    fprintf(err, "  -fverify-ir          每一遍之后校验中间代码\n");
+    fprintf(err, "  -O0 / -O1            关闭/开启中间代码优化(默认-O1)\n");
+    fprintf(err, "  -fopt-report         输出每个优化遍删除的指令和基本块数\n");
+    fprintf(err, "  -fdump-regalloc      输出x86-64寄存器分配结果(活跃区间、溢出和边上的复制)\n");
+    fprintf(err, "  -fno-peephole        不对生成的机器指令做窥孔优化\n");
+    fprintf(err, "  -fno-share-frame-slots 栈帧对象各占一个栈槽, 不按活跃范围共用\n");
+    fprintf(err, "  -S                   生成x86-64汇编(GNU as语法), 默认写到输入文件名.s\n");
+    fprintf(err, "  -c                   直接生成ELF目标文件(不经过汇编器), 默认写到输入文件名.o\n");
+    fprintf(err, "  -o FILE              汇编或目标文件的输出文件(只能有一个输入文件)\n");
+    fprintf(err, "  --run                编译后在本进程中直接执行(不生成文件), 以main的返回值退出\n");
+    fprintf(err, "  --run=vm             同--run, 但编译成字节码由虚拟机解释执行(不依赖目标机器)\n");
+    fprintf(err, "  --run=tiered         同--run, 先解释执行, 调用或循环多的函数在后台编译为机器码后替换\n");
+    fprintf(err, "  --profile-generate[=FILE]  插入基本块计数, 程序结束后把计数合并写入FILE(默认%s)\n",
+            PROFILE_DEFAULT_FILE);
+    fprintf(err, "                       只能与--run、--run=vm或--run=tiered一起使用, 不能生成插桩的-c/-S输出\n");
+    fprintf(err, "  --profile-use[=FILE] 按FILE中的计数安排基本块顺序、决定内联和循环展开\n");
+    fprintf(err, "输入文件为 - 时从标准输入读取源代码\n");
+}
+
+int driver_run(int argc, char* argv[], DriverOptions* options, FILE* out, FILE* err) {
+    CompileJob* jobs = (CompileJob*)calloc(argc > 0 ? argc : 1, sizeof(CompileJob));
+    int job_count = 0;
+    if (!jobs) {
+        perror("calloc failed for CompileJob");
+        exit(1);
+    }
+    
+    // 解析命令行参数
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        if (strcmp(arg, "-j") == 0 && i + 1 < argc) {
+            options->jobs = atoi(argv[++i]);
+        } else if (strncmp(arg, "-j", 2) == 0 && arg[2] != '\0') {
+            options->jobs = atoi(arg + 2);
+        } else if (strcmp(arg, "-ftime-report") == 0) {
+            options->time_report = true;
+        } else if (strcmp(arg, "-fmem-report") == 0) {
+            options->mem_report = true;
+        } else if (strncmp(arg, "-freport-json=", 14) == 0 && arg[14] != '\0') {
+            options->report_json = arg + 14;
+        } else if (strncmp(arg, "--trace=", 8) == 0 && arg[8] != '\0') {
+            options->trace = arg + 8;
+        } else if (strcmp(arg, "-fdump-ir") == 0) {
+            options->dump_ir = true;
+        } else if (strcmp(arg, "-fverify-ir") == 0) {
+            options->verify_ir = true;
+        } else if (strcmp(arg, "-O0") == 0 || strcmp(arg, "-O1") == 0) {
+            options->opt_level = arg[2] - '0';
+        } else if (strcmp(arg, "-fopt-report") == 0) {
+            options->opt_report = true;
+        } else if (strcmp(arg, "-fno-peephole") == 0) {
+            options->peephole = false;
+        } else if (strcmp(arg, "-fno-share-frame-slots") == 0) {
+            options->share_frame_slots = false;
+        } else if (strcmp(arg, "-fdump-regalloc") == 0) {
+            options->dump_regalloc = true;
+        } else if (strcmp(arg, "-S") == 0) {
+            options->emit_asm = true;
+        } else if (strcmp(arg, "-c") == 0) {
+            options->emit_object = true;
+        } else if (strcmp(arg, "--run") == 0) {
+            options->run = RUN_NATIVE;
+        } else if (strcmp(arg, "--run=vm") == 0) {
+            options->run = RUN_VM;
+        } else if (strcmp(arg, "--run=tiered") == 0) {
+            options->run = RUN_TIERED;
+        } else if (strcmp(arg, "--profile-generate") == 0) {
+            options->profile_generate = PROFILE_DEFAULT_FILE;
+        } else if (strncmp(arg, "--profile-generate=", 19) == 0 && arg[19] != '\0') {
+            options->profile_generate = arg + 19;
+        } else if (strcmp(arg, "--profile-use") == 0) {
+            options->profile_use = PROFILE_DEFAULT_FILE;
+        } else if (strncmp(arg, "--profile-use=", 14) == 0 && arg[14] != '\0') {
+            options->profile_use = arg + 14;
+        } else if (strcmp(arg, "-o") == 0 && i + 1 < argc) {
+            options->output = argv[++i];
+        } else if (arg[0] == '-' && arg[1] != '\0') {
+            driver_print_usage(argv[0], err);
+            free(jobs);
+            return 1;
+        } else {
+            jobs[job_count].filename = arg;
+            perf_report_init(&jobs[job_count].perf);
+            job_count++;
+        }
+    }
+    
+    if (job_count == 0) {
+        driver_print_usage(argv[0], err);
+        free(jobs);
+        return 1;
+    }
+    if (options->output && job_count > 1) {
+        fprintf(err, "-o 只能用于单个输入文件\n");
+        free(jobs);
+        return 1;
+    }
+    if (options->run && (job_count > 1 || !options->allow_run)) {
+        fprintf(err, job_count > 1 ? "--run 只能用于单个输入文件\n" : "常驻编译服务不支持 --run\n");
+        free(jobs);
+        return 1;
+    }
+    // 计数在程序结束后由本进程写出, 生成的汇编和目标文件里没有写文件的代码
+    if (options->profile_generate && (!options->run || options->profile_use)) {
+        fprintf(err, options->profile_use ? "--profile-generate 和 --profile-use 不能同时使用\n"
+                                          : "--profile-generate 只能与 --run、--run=vm 或 --run=tiered 一起使用\n");
+        free(jobs);
+        return 1;
+    }
+    
+    // 跟踪会话记录进程内所有线程的事件, 常驻服务中会混入其他请求的事件
+    if (options->trace && !options->allow_trace) {
+        fprintf(err, "常驻编译服务不支持 --trace\n");
+        free(jobs);
+        return 1;
+    }
+    
+    // 跟踪事件在编译结束后统一写出
+    bool tracing = false;
+    if (options->trace) {
+        char* trace_path = resolve_path(options->trace, options);
+        tracing = trace_open(trace_path, err);
+        free(trace_path);
+    }
+    
+    int failed;
+    if (options->run) {
+        // 编译过程的输出丢弃, 标准输出只留给程序; 以程序的返回值退出
+        FILE* null_out = fopen("/dev/null", "w");
+        jobs[0].success = compile_job(&jobs[0], options, null_out ? null_out : out, err);
+        if (null_out) fclose(null_out);
+        failed = jobs[0].success ? 0 : 1;
+    } else if (job_count == 1) {
+        // 单文件: 直接输出
+        jobs[0].success = compile_job(&jobs[0], options, out, err);
+        failed = jobs[0].success ? 0 : 1;
+    } else {
+        // 多文件: 线程池并行编译,按输入顺序输出诊断
+        failed = driver_compile_jobs(jobs, job_count, options, out, err);
+    }
+    
+    if (tracing) {
+        trace_close(err);
+    }
+    
+    // 汇总阶段统计
+    if (options->time_report || options->mem_report || options->report_json) {
+        PerfReport total;
+        perf_report_init(&total);
+        for (int i = 0; i < job_count; i++) {
+            perf_report_merge(&total, &jobs[i].perf);
+        }
+        if (options->time_report || options->mem_report) {
+            perf_report_print_table(&total, err, options->time_report, options->mem_report);
+        }
+        if (options->report_json) {
+            fflush(out);
+            write_json_report(jobs, job_count, &total, options, out, err);
+        }
+    }
+    
+    int status = failed == 0 ? 0 : 1;
+    if (options->run && failed == 0) status = jobs[0].exit_status;
+    free(jobs);
+    return status;
+}
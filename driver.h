@@ -0,0 +1,92 @@
+#ifndef DRIVER_H
+#define DRIVER_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include "perf_report.h"
+
+// ========== 编译驱动 ==========
+
+// --run的执行方式
+typedef enum {
+    RUN_NONE,                   // 只编译
+    RUN_NATIVE,                 // --run: 编译成机器码后在本进程中执行
+    RUN_VM,                     // --run=vm: 编译成字节码后解释执行
+    RUN_TIERED                  // --run=tiered: 先解释执行, 热点函数在后台编译为机器码
+} RunMode;
+
+// 驱动选项
+typedef struct DriverOptions {
+    int jobs;                   // 工作线程数(<=0 表示按CPU核数)
+    const char* base_dir;       // 相对路径的基准目录(NULL表示进程当前目录)
+    const char* stdin_source;   // 文件名"-"对应的源代码(NULL表示未提供)
+    size_t stdin_length;
+    
+    // 阶段统计
+    bool time_report;           // -ftime-report: 输出各阶段耗时表
+    bool mem_report;            // -fmem-report: 输出各阶段内存分配表
+    const char* report_json;    // -freport-json=FILE: 以JSON输出全部统计("-"表示写到out)
+    const char* trace;          // --trace=FILE: 输出Chrome跟踪事件
+    
+    bool dump_ir;               // -fdump-ir: 输出中间代码
+    bool verify_ir;             // -fverify-ir: 每一遍之后校验中间代码
+    int opt_level;              // -O0/-O1: 0表示不运行优化遍
+    bool opt_report;            // -fopt-report: 输出各优化遍的统计
+    bool dump_regalloc;         // -fdump-regalloc: 输出寄存器分配结果
+    bool peephole;              // -fno-peephole时为false: 不对机器指令做窥孔优化(-O0时也不做)
+    bool share_frame_slots;     // -fno-share-frame-slots时为false: 每个栈帧对象各占一个栈槽(-O0时也是)
+    bool emit_asm;              // -S: 生成x86-64汇编
+    bool emit_object;           // -c: 直接生成ELF目标文件(同时给出-S时生成汇编)
+    RunMode run;                // --run/--run=vm/--run=tiered: 在本进程中直接执行编译好的程序(只能有一个输入文件)
+    bool allow_run;             // 常驻编译服务中为false, 不在服务进程里执行用户程序
+    bool allow_trace;           // 常驻编译服务中为false, 跟踪会话是进程全局的
+    const char* output;         // -o FILE: 输出文件(只能有一个输入文件), 默认为输入文件名换成.s/.o
+    const char* profile_generate; // --profile-generate[=FILE]: 插入基本块计数, 程序结束后写入FILE(需要--run)
+    const char* profile_use;    // --profile-use[=FILE]: 按FILE中的计数优化(见profile.h)
+} DriverOptions;
+
+// 单个翻译单元的编译任务
+typedef struct CompileJob {
+    const char* filename;   // 输入文件
+    char* out_buf;          // 捕获的标准输出内容
+    size_t out_len;
+    char* err_buf;          // 捕获的诊断信息
+    size_t err_len;
+    bool success;           // 是否编译成功
+    int exit_status;        // --run: 程序main的返回值
+    bool done;              // 是否已完成
+    PerfReport perf;        // 阶段统计
+} CompileJob;
+
+// 初始化默认选项
+void driver_options_init(DriverOptions* options);
+
+// 编译单个文件: 词法分析 → 构建AST → 语义分析 → 中间代码(→ 汇编/目标文件), 进度写入out, 诊断写入err
+// options为NULL时使用默认选项; perf不为NULL时记录各阶段统计
+bool compile_file(const char* filename, const DriverOptions* options, FILE* out, FILE* err,
+                  PerfReport* perf);
+// 编译内存中的源代码, name仅用于显示
+bool compile_source(const char* name, const char* source, size_t length,
+                    const DriverOptions* options, FILE* out, FILE* err, PerfReport* perf);
+
+// 在SSA形式的IR上按options->opt_level依次运行各优化遍(计入PHASE_OPT), 校验失败时返回false
+struct IRModule;
+bool driver_optimize_module(struct IRModule* module, const DriverOptions* options, FILE* err,
+                            PerfReport* perf);
+
+// 在线程池中并行编译jobs中的全部任务, 按输入顺序输出每个文件的结果
+// 返回失败的文件数
+int driver_compile_jobs(CompileJob* jobs, int count, const DriverOptions* options,
+                        FILE* out, FILE* err);
+
+// 解析命令行参数并编译, 返回进程退出码
+int driver_run(int argc, char* argv[], DriverOptions* options, FILE* out, FILE* err);
+void driver_print_usage(const char* prog, FILE* err);
+
+// 读取文件流的全部内容(用于"-"输入), 调用者负责释放
+char* driver_read_stream(FILE* file, size_t* length);
+
+// 默认的工作线程数(在线CPU核数)
+int driver_default_jobs(void);
+
+#endif // DRIVER_H
@@ -0,0 +1,279 @@
+#include "elf_object.h"
+#include <elf.h>
+#include <stdlib.h>
+#include <string.h>
+
+// 节按固定顺序排列; 没有顶层语句时.init_array和它的重定位节为空
+enum {
+    SECTION_NULL,
+    SECTION_TEXT,
+    SECTION_DATA,
+    SECTION_BSS,
+    SECTION_INIT_ARRAY,
+    SECTION_RELA_TEXT,
+    SECTION_RELA_INIT_ARRAY,
+    SECTION_SYMTAB,
+    SECTION_STRTAB,
+    SECTION_SHSTRTAB,
+    SECTION_NOTE,
+    SECTION_COUNT
+};
+
+typedef struct ElfWriter {
+    const X86Module* module;
+    const X86Code* code;
+    OutBuf data;
+    OutBuf init_array;
+    OutBuf rela_text;
+    OutBuf rela_init_array;
+    OutBuf symtab;
+    OutBuf strtab;
+    OutBuf shstrtab;
+    int symbol_count;
+    int first_global;           // 第一个全局符号(之前都是本地符号)
+    int32_t* function_symbols;  // IR函数编号 → 符号编号, -1表示还没有
+    int32_t* global_symbols;    // IR全局变量编号 → 符号编号
+    uint64_t* global_offsets;   // 全局变量在.data或.bss中的偏移
+    uint64_t bss_size;
+    uint64_t data_align;
+    uint64_t bss_align;
+    Elf64_Shdr headers[SECTION_COUNT];
+} ElfWriter;
+
+static void* elf_alloc(size_t size) {
+    void* ptr = malloc(size ? size : 1);
+    if (!ptr) {
+        perror("malloc failed for ELF writer");
+        exit(1);
+    }
+    return ptr;
+}
+
+static uint64_t align_up(uint64_t value, uint64_t align) {
+    return (value + align - 1) / align * align;
+}
+
+static uint32_t add_string(OutBuf* table, const char* text) {
+    uint32_t offset = (uint32_t)table->length;
+    outbuf_write(table, text, strlen(text) + 1);
+    return offset;
+}
+
+static int add_symbol(ElfWriter* writer, const char* name, int bind, int type, int section, uint64_t value,
+                      uint64_t size) {
+    Elf64_Sym symbol;
+    memset(&symbol, 0, sizeof(symbol));
+    symbol.st_name = name ? add_string(&writer->strtab, name) : 0;
+    symbol.st_info = (unsigned char)ELF64_ST_INFO(bind, type);
+    symbol.st_shndx = (Elf64_Section)section;
+    symbol.st_value = value;
+    symbol.st_size = size;
+    outbuf_write(&writer->symtab, &symbol, sizeof(symbol));
+    return writer->symbol_count++;
+}
+
+static void add_rela(OutBuf* table, uint64_t offset, int symbol, uint32_t type, int64_t addend) {
+    Elf64_Rela rela;
+    rela.r_offset = offset;
+    rela.r_info = ELF64_R_INFO((uint64_t)symbol, type);
+    rela.r_addend = addend;
+    outbuf_write(table, &rela, sizeof(rela));
+}
+
+static void write_zeros(OutBuf* buf, uint64_t count) {
+    static const char zeros[16];
+    while (count > 0) {
+        size_t n = count < sizeof(zeros) ? (size_t)count : sizeof(zeros);
+        outbuf_write(buf, zeros, n);
+        count -= n;
+    }
+}
+
+// 有非0初值的标量放在.data, 其余放在.bss(与汇编输出相同)
+static void layout_globals(ElfWriter* writer) {
+    const IRModule* ir = writer->module->ir;
+    writer->data_align = 1;
+    writer->bss_align = 1;
+    for (int i = 0; i < ir->global_count; i++) {
+        const IRGlobal* global = &ir->globals[i];
+        uint64_t elem = global->type == IR_TYPE_PTR ? 8 : 4;
+        if (global->count == 1 && global->init != 0) {
+            write_zeros(&writer->data, align_up(writer->data.length, elem) - writer->data.length);
+            writer->global_offsets[i] = writer->data.length;
+            int64_t value = global->init;
+            outbuf_write(&writer->data, &value, (size_t)elem);
+            if (elem > writer->data_align) writer->data_align = elem;
+        } else {
+            writer->bss_size = align_up(writer->bss_size, elem);
+            writer->global_offsets[i] = writer->bss_size;
+            writer->bss_size += elem * (uint64_t)global->count;
+            if (elem > writer->bss_align) writer->bss_align = elem;
+        }
+    }
+}
+
+// 本地符号(__toplevel)必须排在全局符号之前; 没有定义的函数只在被调用时才加入
+static void build_symbols(ElfWriter* writer) {
+    const X86Module* module = writer->module;
+    const IRModule* ir = module->ir;
+    add_symbol(writer, NULL, STB_LOCAL, STT_NOTYPE, SHN_UNDEF, 0, 0);
+    for (int pass = 0; pass < 2; pass++) {
+        if (pass == 1) writer->first_global = writer->symbol_count;
+        for (int i = 0; i < module->function_count; i++) {
+            const X86Function* function = &module->functions[i];
+            if (function->is_global != (pass == 1)) continue;
+            writer->function_symbols[function->ir_index] =
+                add_symbol(writer, function->name, pass == 1 ? STB_GLOBAL : STB_LOCAL, STT_FUNC, SECTION_TEXT,
+                           writer->code->function_offsets[i], writer->code->function_sizes[i]);
+        }
+    }
+    for (int i = 0; i < ir->global_count; i++) {
+        const IRGlobal* global = &ir->globals[i];
+        bool initialized = global->count == 1 && global->init != 0;
+        uint64_t elem = global->type == IR_TYPE_PTR ? 8 : 4;
+        writer->global_symbols[i] = add_symbol(writer, global->name, STB_GLOBAL, STT_OBJECT,
+                                               initialized ? SECTION_DATA : SECTION_BSS,
+                                               writer->global_offsets[i], elem * (uint64_t)global->count);
+    }
+    for (int i = 0; i < writer->code->reloc_count; i++) {
+        const X86Reloc* reloc = &writer->code->relocs[i];
+        if (reloc->kind != X86_RELOC_PLT32 || writer->function_symbols[reloc->symbol] >= 0) continue;
+        writer->function_symbols[reloc->symbol] =
+            add_symbol(writer, ir->functions[reloc->symbol].name, STB_GLOBAL, STT_NOTYPE, SHN_UNDEF, 0, 0);
+    }
+}
+
+static void build_relocations(ElfWriter* writer) {
+    const X86Code* code = writer->code;
+    for (int i = 0; i < code->reloc_count; i++) {
+        const X86Reloc* reloc = &code->relocs[i];
+        if (reloc->kind == X86_RELOC_PLT32) {
+            add_rela(&writer->rela_text, reloc->offset, writer->function_symbols[reloc->symbol],
+                     R_X86_64_PLT32, reloc->addend);
+        } else {
+            add_rela(&writer->rela_text, reloc->offset, writer->global_symbols[reloc->symbol],
+                     R_X86_64_PC32, reloc->addend);
+        }
+    }
+
+    // 顶层语句在main之前执行
+    const X86Module* module = writer->module;
+    for (int i = 0; i < module->function_count; i++) {
+        if (module->functions[i].is_global) continue;
+        uint64_t zero = 0;
+        add_rela(&writer->rela_init_array, writer->init_array.length,
+                 writer->function_symbols[module->functions[i].ir_index], R_X86_64_64, 0);
+        outbuf_write(&writer->init_array, &zero, sizeof(zero));
+    }
+}
+
+static void set_header(ElfWriter* writer, int index, const char* name, uint32_t type, uint64_t flags,
+                       uint64_t size, uint64_t align, uint64_t entsize) {
+    Elf64_Shdr* header = &writer->headers[index];
+    header->sh_name = add_string(&writer->shstrtab, name);
+    header->sh_type = type;
+    header->sh_flags = flags;
+    header->sh_size = size;
+    header->sh_addralign = align;
+    header->sh_entsize = entsize;
+}
+
+void elf_object_write(OutBuf* out, const X86Module* module, const X86Code* code) {
+    ElfWriter writer;
+    memset(&writer, 0, sizeof(writer));
+    writer.module = module;
+    writer.code = code;
+    OutBuf* tables[] = {
+        &writer.data, &writer.init_array, &writer.rela_text, &writer.rela_init_array,
+        &writer.symtab, &writer.strtab, &writer.shstrtab
+    };
+    int table_count = (int)(sizeof(tables) / sizeof(tables[0]));
+    for (int i = 0; i < table_count; i++) outbuf_init(tables[i], NULL);
+    add_string(&writer.strtab, "");
+    add_string(&writer.shstrtab, "");
+
+    const IRModule* ir = module->ir;
+    writer.function_symbols = (int32_t*)elf_alloc(sizeof(int32_t) * (size_t)ir->function_count);
+    for (int i = 0; i < ir->function_count; i++) writer.function_symbols[i] = -1;
+    writer.global_symbols = (int32_t*)elf_alloc(sizeof(int32_t) * (size_t)ir->global_count);
+    writer.global_offsets = (uint64_t*)elf_alloc(sizeof(uint64_t) * (size_t)ir->global_count);
+
+    layout_globals(&writer);
+    build_symbols(&writer);
+    build_relocations(&writer);
+
+    Elf64_Xword rela_flags = SHF_INFO_LINK;
+    set_header(&writer, SECTION_TEXT, ".text", SHT_PROGBITS, SHF_ALLOC | SHF_EXECINSTR, code->text.length, 16, 0);
+    set_header(&writer, SECTION_DATA, ".data", SHT_PROGBITS, SHF_ALLOC | SHF_WRITE, writer.data.length,
+               writer.data_align, 0);
+    set_header(&writer, SECTION_BSS, ".bss", SHT_NOBITS, SHF_ALLOC | SHF_WRITE, writer.bss_size,
+               writer.bss_align, 0);
+    set_header(&writer, SECTION_INIT_ARRAY, ".init_array", SHT_INIT_ARRAY, SHF_ALLOC | SHF_WRITE,
+               writer.init_array.length, 8, 8);
+    set_header(&writer, SECTION_RELA_TEXT, ".rela.text", SHT_RELA, rela_flags, writer.rela_text.length, 8,
+               sizeof(Elf64_Rela));
+    set_header(&writer, SECTION_RELA_INIT_ARRAY, ".rela.init_array", SHT_RELA, rela_flags,
+               writer.rela_init_array.length, 8, sizeof(Elf64_Rela));
+    set_header(&writer, SECTION_SYMTAB, ".symtab", SHT_SYMTAB, 0, writer.symtab.length, 8, sizeof(Elf64_Sym));
+    set_header(&writer, SECTION_STRTAB, ".strtab", SHT_STRTAB, 0, writer.strtab.length, 1, 0);
+    set_header(&writer, SECTION_SHSTRTAB, ".shstrtab", SHT_STRTAB, 0, 0, 1, 0);
+    set_header(&writer, SECTION_NOTE, ".note.GNU-stack", SHT_PROGBITS, 0, 0, 1, 0);
+    writer.headers[SECTION_SHSTRTAB].sh_size = writer.shstrtab.length;
+    writer.headers[SECTION_RELA_TEXT].sh_link = SECTION_SYMTAB;
+    writer.headers[SECTION_RELA_TEXT].sh_info = SECTION_TEXT;
+    writer.headers[SECTION_RELA_INIT_ARRAY].sh_link = SECTION_SYMTAB;
+    writer.headers[SECTION_RELA_INIT_ARRAY].sh_info = SECTION_INIT_ARRAY;
+    writer.headers[SECTION_SYMTAB].sh_link = SECTION_STRTAB;
+    writer.headers[SECTION_SYMTAB].sh_info = (Elf64_Word)writer.first_global;
+
+    // 文件布局: ELF头, 各节的内容(按对齐要求), 最后是节头表
+    const OutBuf* contents[SECTION_COUNT] = { NULL };
+    contents[SECTION_TEXT] = &code->text;
+    contents[SECTION_DATA] = &writer.data;
+    contents[SECTION_INIT_ARRAY] = &writer.init_array;
+    contents[SECTION_RELA_TEXT] = &writer.rela_text;
+    contents[SECTION_RELA_INIT_ARRAY] = &writer.rela_init_array;
+    contents[SECTION_SYMTAB] = &writer.symtab;
+    contents[SECTION_STRTAB] = &writer.strtab;
+    contents[SECTION_SHSTRTAB] = &writer.shstrtab;
+    uint64_t offset = sizeof(Elf64_Ehdr);
+    for (int i = 1; i < SECTION_COUNT; i++) {
+        offset = align_up(offset, writer.headers[i].sh_addralign);
+        writer.headers[i].sh_offset = offset;
+        if (contents[i]) offset += contents[i]->length;
+    }
+    uint64_t header_offset = align_up(offset, 8);
+
+    Elf64_Ehdr ehdr;
+    memset(&ehdr, 0, sizeof(ehdr));
+    memcpy(ehdr.e_ident, ELFMAG, SELFMAG);
+    ehdr.e_ident[EI_CLASS] = ELFCLASS64;
+    ehdr.e_ident[EI_DATA] = ELFDATA2LSB;
+    ehdr.e_ident[EI_VERSION] = EV_CURRENT;
+    ehdr.e_ident[EI_OSABI] = ELFOSABI_NONE;
+    ehdr.e_type = ET_REL;
+    ehdr.e_machine = EM_X86_64;
+    ehdr.e_version = EV_CURRENT;
+    ehdr.e_shoff = header_offset;
+    ehdr.e_ehsize = sizeof(Elf64_Ehdr);
+    ehdr.e_shentsize = sizeof(Elf64_Shdr);
+    ehdr.e_shnum = SECTION_COUNT;
+    ehdr.e_shstrndx = SECTION_SHSTRTAB;
+
+    // out可能已经写出过一部分(有sink时), 用written记录本文件已写的长度
+    uint64_t written = sizeof(ehdr);
+    outbuf_write(out, &ehdr, sizeof(ehdr));
+    for (int i = 1; i < SECTION_COUNT; i++) {
+        if (!contents[i]) continue;
+        write_zeros(out, writer.headers[i].sh_offset - written);
+        outbuf_write(out, contents[i]->data, contents[i]->length);
+        written = writer.headers[i].sh_offset + contents[i]->length;
+    }
+    write_zeros(out, header_offset - written);
+    outbuf_write(out, writer.headers, sizeof(writer.headers));
+
+    for (int i = 0; i < table_count; i++) outbuf_free(tables[i]);
+    free(writer.function_symbols);
+    free(writer.global_symbols);
+    free(writer.global_offsets);
+}
@@ -0,0 +1,16 @@
+#ifndef ELF_OBJECT_H
+#define ELF_OBJECT_H
+
+#include "x86_encode.h"
+#include "outbuf.h"
+
+// ========== ELF64可重定位目标文件 ==========
+//
+// 把编码好的机器码和全局变量写成x86-64的ELF可重定位目标文件(.o), 直接交给ld/cc链接, 不经过as。
+// 节: .text、.data、.bss、.init_array(有顶层语句时)、对应的.rela节、.symtab/.strtab。
+// 符号、节和重定位的种类与x86_asm.h输出的汇编经as汇编后相同:
+// 函数间的调用用R_X86_64_PLT32, 全局变量用R_X86_64_PC32, .init_array中的__toplevel用R_X86_64_64。
+
+void elf_object_write(OutBuf* out, const X86Module* module, const X86Code* code);
+
+#endif // ELF_OBJECT_H
@@ -0,0 +1,432 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "expr_eval.h"
+#include "lexer.h"
+#include "ast_parser.h"
+#include "semantic_analyzer.h"
+#include <stdlib.h>
+#include <string.h>
+
+// GCC/Clang的向量扩展; 定义EXPR_NO_VECTOR可强制逐行计算
+#if defined(__GNUC__) && !defined(EXPR_NO_VECTOR)
+#define EXPR_LANES 4        // 128位: x86-64的SSE2和AArch64的NEON都是基线指令集
+typedef int32_t ExprVec __attribute__((vector_size(EXPR_LANES * sizeof(int32_t)), may_alias));
+typedef uint32_t ExprUVec __attribute__((vector_size(EXPR_LANES * sizeof(int32_t)), may_alias));
+#else
+#define EXPR_LANES 1
+typedef int32_t ExprVec;
+typedef uint32_t ExprUVec;
+#endif
+
+#define EXPR_VECTORS (EXPR_BLOCK / EXPR_LANES)
+#define EXPR_ALIGN 32
+
+static void* expr_alloc(size_t size) {
+    void* ptr = calloc(1, size ? size : 1);
+    if (!ptr) {
+        perror("malloc failed for expression");
+        exit(1);
+    }
+    return ptr;
+}
+
+static inline int32_t wrap32(int64_t value) {
+    return (int32_t)(uint32_t)value;
+}
+
+// ========== 编译 ==========
+
+typedef struct ExprCompiler {
+    ExprProgram* program;
+    FILE* err;
+    bool ok;
+    int depth;
+} ExprCompiler;
+
+static void emit(ExprCompiler* cx, ExprOpcode op, bool immediate, int32_t value) {
+    ExprProgram* program = cx->program;
+    if (program->code_count == program->code_capacity) {
+        program->code_capacity = program->code_capacity ? program->code_capacity * 2 : 16;
+        program->code = (ExprInstr*)realloc(program->code, sizeof(ExprInstr) * (size_t)program->code_capacity);
+        if (!program->code) {
+            perror("malloc failed for expression code");
+            exit(1);
+        }
+    }
+    ExprInstr* instr = &program->code[program->code_count++];
+    instr->op = (uint8_t)op;
+    instr->immediate = immediate;
+    instr->value = value;
+}
+
+static void push(ExprCompiler* cx) {
+    if (++cx->depth > cx->program->max_depth) cx->program->max_depth = cx->depth;
+}
+
+static void unsupported(ExprCompiler* cx, const ASTNode* node, const char* what) {
+    if (cx->ok) fprintf(cx->err, "表达式求值: 不支持%s(行 %d)\n", what, node->line);
+    cx->ok = false;
+}
+
+static ExprOpcode binary_opcode(BinaryOp op) {
+    switch (op) {
+        case OP_ADD: return EXPR_ADD;
+        case OP_SUB: return EXPR_SUB;
+        case OP_MUL: return EXPR_MUL;
+        case OP_DIV: return EXPR_DIV;
+        case OP_MOD: return EXPR_MOD;
+        case OP_LT:  return EXPR_LT;
+        case OP_LE:  return EXPR_LE;
+        case OP_GT:  return EXPR_GT;
+        case OP_GE:  return EXPR_GE;
+        case OP_EQ:  return EXPR_EQ;
+        case OP_NE:  return EXPR_NE;
+        case OP_AND: return EXPR_AND;
+        default:     return EXPR_OR;
+    }
+}
+
+// 两个常量的运算, 除数为0时不折叠(留到求值时按行报告)
+static bool fold_binary(ExprOpcode op, int32_t x, int32_t y, int32_t* result) {
+    switch (op) {
+        case EXPR_ADD: *result = wrap32((int64_t)x + y); return true;
+        case EXPR_SUB: *result = wrap32((int64_t)x - y); return true;
+        case EXPR_MUL: *result = wrap32((int64_t)x * y); return true;
+        case EXPR_DIV: if (y == 0) return false; *result = wrap32((int64_t)x / y); return true;
+        case EXPR_MOD: if (y == 0) return false; *result = (int32_t)((int64_t)x % y); return true;
+        case EXPR_LT:  *result = x < y; return true;
+        case EXPR_LE:  *result = x <= y; return true;
+        case EXPR_GT:  *result = x > y; return true;
+        case EXPR_GE:  *result = x >= y; return true;
+        case EXPR_EQ:  *result = x == y; return true;
+        case EXPR_NE:  *result = x != y; return true;
+        case EXPR_AND: *result = x != 0 && y != 0; return true;
+        default:       *result = x != 0 || y != 0; return true;
+    }
+}
+
+static void compile_expr(ExprCompiler* cx, const ASTNode* node);
+
+static void compile_binary(ExprCompiler* cx, const ASTNode* node) {
+    BinaryOp op = node->data.binary_op.op;
+    if (op == OP_ASSIGN || op == OP_ADD_ASSIGN || op == OP_SUB_ASSIGN) {
+        unsupported(cx, node, "表达式中的赋值");
+        return;
+    }
+    ExprOpcode code = binary_opcode(op);
+    compile_expr(cx, node->data.binary_op.left);
+    compile_expr(cx, node->data.binary_op.right);
+    if (!cx->ok) return;
+
+    // 右操作数是常量时并入指令; 两边都是常量时直接折叠
+    ExprProgram* program = cx->program;
+    ExprInstr* right = &program->code[program->code_count - 1];
+    if (right->op == EXPR_CONST) {
+        ExprInstr* left = &program->code[program->code_count - 2];
+        int32_t value;
+        if (left->op == EXPR_CONST && fold_binary(code, left->value, right->value, &value)) {
+            left->value = value;
+            program->code_count--;
+            cx->depth--;
+            return;
+        }
+        bool division = code == EXPR_DIV || code == EXPR_MOD;
+        if (!division || right->value != 0) {
+            int32_t constant = right->value;
+            program->code_count--;
+            cx->depth--;
+            emit(cx, code, true, constant);
+            return;
+        }
+    }
+    if (code == EXPR_DIV || code == EXPR_MOD) program->has_division = true;
+    emit(cx, code, false, 0);
+    cx->depth--;
+}
+
+static void compile_expr(ExprCompiler* cx, const ASTNode* node) {
+    if (!cx->ok) return;
+    ExprProgram* program = cx->program;
+    switch (node->node_type) {
+        case AST_LITERAL:
+            emit(cx, EXPR_CONST, false, node->data.literal.value.int_value);
+            push(cx);
+            break;
+
+        case AST_IDENTIFIER: {
+            int variable = expr_program_variable(program, node->data.identifier.name);
+            if (variable < 0) {
+                unsupported(cx, node, "没有声明为int变量的标识符");
+                return;
+            }
+            emit(cx, EXPR_LOAD, false, variable);
+            push(cx);
+            break;
+        }
+
+        case AST_BINARY_OP:
+            compile_binary(cx, node);
+            break;
+
+        case AST_UNARY_OP: {
+            UnaryOp op = node->data.unary_op.op;
+            if (op != OP_NEG && op != OP_NOT) {
+                unsupported(cx, node, "自增、自减和指针运算");
+                return;
+            }
+            compile_expr(cx, node->data.unary_op.operand);
+            if (!cx->ok) return;
+            ExprInstr* operand = &program->code[program->code_count - 1];
+            if (operand->op == EXPR_CONST) {
+                operand->value = op == OP_NEG ? wrap32(-(int64_t)operand->value) : operand->value == 0;
+            } else {
+                emit(cx, op == OP_NEG ? EXPR_NEG : EXPR_NOT, false, 0);
+            }
+            break;
+        }
+
+        default:
+            unsupported(cx, node, ast_node_type_str(node->node_type));
+            break;
+    }
+}
+
+static void add_variable(ExprCompiler* cx, const ASTNode* decl) {
+    ExprProgram* program = cx->program;
+    const ASTNode* init = decl->data.var_decl.init_value;
+    if (!decl->data.var_decl.var_type || decl->data.var_decl.var_type->base_type != TYPE_INT) {
+        unsupported(cx, decl, "int以外的变量");
+        return;
+    }
+    if (init && init->node_type != AST_LITERAL) {
+        unsupported(cx, decl, "不是常量的初值");
+        return;
+    }
+    int index = program->variable_count++;
+    program->names = (char**)realloc(program->names, sizeof(char*) * (size_t)program->variable_count);
+    program->defaults = (int32_t*)realloc(program->defaults, sizeof(int32_t) * (size_t)program->variable_count);
+    if (!program->names || !program->defaults) {
+        perror("malloc failed for expression variables");
+        exit(1);
+    }
+    program->names[index] = strdup(decl->data.var_decl.var_name);
+    program->defaults[index] = init ? init->data.literal.value.int_value : 0;
+}
+
+ExprProgram* expr_program_compile(const ASTNode* program, FILE* err) {
+    ExprCompiler cx;
+    memset(&cx, 0, sizeof(cx));
+    cx.program = (ExprProgram*)expr_alloc(sizeof(ExprProgram));
+    cx.program->target = -1;
+    cx.err = err;
+    cx.ok = true;
+
+    const ASTNode* formula = NULL;
+    for (int i = 0; i < program->data.program.decl_count && cx.ok; i++) {
+        const ASTNode* node = program->data.program.declarations[i];
+        if (formula) {
+            unsupported(&cx, node, "公式之后的语句");
+        } else if (node->node_type == AST_VAR_DECL) {
+            add_variable(&cx, node);
+        } else if (node->node_type == AST_ASSIGN_STMT || node->node_type == AST_EXPR_STMT) {
+            formula = node;
+        } else {
+            unsupported(&cx, node, ast_node_type_str(node->node_type));
+        }
+    }
+    if (cx.ok && !formula) {
+        fprintf(err, "表达式求值: 没有要计算的表达式\n");
+        cx.ok = false;
+    }
+
+    if (cx.ok && formula->node_type == AST_ASSIGN_STMT) {
+        const ASTNode* lvalue = formula->data.assign_stmt.lvalue;
+        if (lvalue->node_type != AST_IDENTIFIER) {
+            unsupported(&cx, lvalue, "给数组元素赋值");
+        } else {
+            cx.program->target = expr_program_variable(cx.program, lvalue->data.identifier.name);
+        }
+        compile_expr(&cx, formula->data.assign_stmt.rvalue);
+    } else if (cx.ok) {
+        compile_expr(&cx, formula->data.expr_stmt.expr);
+    }
+
+    if (!cx.ok) {
+        expr_program_destroy(cx.program);
+        return NULL;
+    }
+    return cx.program;
+}
+
+ExprProgram* expr_program_create(const char* source, size_t length, FILE* err) {
+    // 公式里的变量由调用者绑定, "未初始化"之类的警告没有意义: 诊断先写入内存, 失败时才转给err;
+    // 分析过程的进度信息丢弃
+    char* log_buf = NULL;
+    size_t log_len = 0;
+    FILE* log = open_memstream(&log_buf, &log_len);
+    if (!log) {
+        perror("open_memstream failed");
+        exit(1);
+    }
+    FILE* null_out = fopen("/dev/null", "w");
+
+    ExprProgram* result = NULL;
+    Lexer* lexer = lexer_create_from_memory(source, length);
+    ASTNode* program = NULL;
+    if (lexer) {
+        lexer->err = log;
+        program = ast_parse_program(lexer, log);
+        lexer_destroy(lexer);
+    }
+    if (program) {
+        SemanticAnalyzer* analyzer = semantic_analyzer_create();
+        semantic_analyzer_set_output(analyzer, null_out ? null_out : log, log);
+        if (semantic_analyze_program(analyzer, program)) result = expr_program_compile(program, log);
+        semantic_analyzer_destroy(analyzer);
+        ast_free(program);
+    }
+
+    if (null_out) fclose(null_out);
+    fclose(log);
+    if (!result && log_len > 0) fwrite(log_buf, 1, log_len, err);
+    free(log_buf);
+    return result;
+}
+
+void expr_program_destroy(ExprProgram* program) {
+    if (!program) return;
+    for (int i = 0; i < program->variable_count; i++) free(program->names[i]);
+    free(program->names);
+    free(program->defaults);
+    free(program->code);
+    free(program);
+}
+
+int expr_program_variable(const ExprProgram* program, const char* name) {
+    for (int i = 0; i < program->variable_count; i++) {
+        if (strcmp(program->names[i], name) == 0) return i;
+    }
+    return -1;
+}
+
+// ========== 求值 ==========
+
+static inline ExprVec splat(int32_t value) {
+    ExprVec zero = {0};
+    return zero + value;
+}
+
+// 栈顶两块 a ← a op b(或 a ← a op 立即数); 比较的结果按位与1得到0或1(向量比较得到-1或0)
+#define VECTOR_BINARY(expr) \
+    for (int v = 0; v < EXPR_VECTORS; v++) { \
+        ExprVec x = a[v]; \
+        ExprVec y = instr->immediate ? imm : b[v]; \
+        a[v] = (expr); \
+    } \
+    break;
+
+// 除法没有SIMD指令, 逐行在64位中计算: INT_MIN / -1 回绕, 除数为0的行记入fault
+#define SCALAR_DIVISION(expr) \
+    for (int r = 0; r < EXPR_BLOCK; r++) { \
+        int64_t x = ((int32_t*)a)[r]; \
+        int64_t y = instr->immediate ? instr->value : ((int32_t*)b)[r]; \
+        if (y == 0) { \
+            ((int32_t*)a)[r] = 0; \
+            ((int32_t*)fa)[r] = 1; \
+        } else { \
+            ((int32_t*)a)[r] = (expr); \
+        } \
+    } \
+    break;
+
+// 对一块(count行, 不满一块的部分补0)求值, 结果在stack[0], 除数为0的标记在faults[0]
+static void eval_block(const ExprProgram* program, const int32_t* const* columns, size_t start, size_t count,
+                       ExprVec* stack, ExprVec* faults) {
+    int top = -1;
+    for (int i = 0; i < program->code_count; i++) {
+        const ExprInstr* instr = &program->code[i];
+        if (instr->op == EXPR_LOAD || instr->op == EXPR_CONST) {
+            top++;
+            ExprVec* slot = stack + (size_t)top * EXPR_VECTORS;
+            const int32_t* column = instr->op == EXPR_LOAD ? columns[instr->value] : NULL;
+            if (column) {
+                memcpy(slot, column + start, sizeof(int32_t) * count);
+                memset((int32_t*)slot + count, 0, sizeof(int32_t) * (EXPR_BLOCK - count));
+            } else {
+                ExprVec value = splat(instr->op == EXPR_LOAD ? program->defaults[instr->value] : instr->value);
+                for (int v = 0; v < EXPR_VECTORS; v++) slot[v] = value;
+            }
+            if (faults) memset(faults + (size_t)top * EXPR_VECTORS, 0, sizeof(int32_t) * EXPR_BLOCK);
+            continue;
+        }
+
+        bool unary = instr->op == EXPR_NEG || instr->op == EXPR_NOT;
+        if (!unary && !instr->immediate) top--;
+        ExprVec* a = stack + (size_t)top * EXPR_VECTORS;
+        ExprVec* b = a + EXPR_VECTORS;
+        ExprVec* fa = faults ? faults + (size_t)top * EXPR_VECTORS : NULL;
+        ExprVec* fb = fa ? fa + EXPR_VECTORS : NULL;
+        ExprVec imm = splat(instr->value);
+
+        // 右侧的除数为0向左合并; && || 只在右侧会被求值的行合并
+        if (fa && !unary && !instr->immediate) {
+            for (int v = 0; v < EXPR_VECTORS; v++) {
+                ExprVec taken = splat(1);
+                if (instr->op == EXPR_AND) taken = (a[v] != 0) & 1;
+                else if (instr->op == EXPR_OR) taken = (a[v] == 0) & 1;
+                fa[v] |= taken & fb[v];
+            }
+        }
+
+        switch (instr->op) {
+            case EXPR_ADD: VECTOR_BINARY((ExprVec)((ExprUVec)x + (ExprUVec)y))
+            case EXPR_SUB: VECTOR_BINARY((ExprVec)((ExprUVec)x - (ExprUVec)y))
+            case EXPR_MUL: VECTOR_BINARY((ExprVec)((ExprUVec)x * (ExprUVec)y))
+            case EXPR_LT:  VECTOR_BINARY((x < y) & 1)
+            case EXPR_LE:  VECTOR_BINARY((x <= y) & 1)
+            case EXPR_GT:  VECTOR_BINARY((x > y) & 1)
+            case EXPR_GE:  VECTOR_BINARY((x >= y) & 1)
+            case EXPR_EQ:  VECTOR_BINARY((x == y) & 1)
+            case EXPR_NE:  VECTOR_BINARY((x != y) & 1)
+            case EXPR_AND: VECTOR_BINARY((x != 0) & (y != 0) & 1)
+            case EXPR_OR:  VECTOR_BINARY(((x != 0) | (y != 0)) & 1)
+            case EXPR_DIV: SCALAR_DIVISION(wrap32(x / y))
+            case EXPR_MOD: SCALAR_DIVISION((int32_t)(x % y))
+            case EXPR_NEG:
+                for (int v = 0; v < EXPR_VECTORS; v++) a[v] = (ExprVec)(-(ExprUVec)a[v]);
+                break;
+            case EXPR_NOT:
+                for (int v = 0; v < EXPR_VECTORS; v++) a[v] = (a[v] == 0) & 1;
+                break;
+        }
+    }
+}
+
+size_t expr_program_eval(const ExprProgram* program, const int32_t* const* columns, size_t rows, int32_t* out) {
+    // 每次调用各自分配求值栈, 同一程序可以在多个线程中同时求值
+    size_t block_bytes = sizeof(int32_t) * EXPR_BLOCK;
+    size_t depth = program->max_depth > 0 ? (size_t)program->max_depth : 1;
+    ExprVec* stack = (ExprVec*)aligned_alloc(EXPR_ALIGN, block_bytes * depth);
+    ExprVec* faults = program->has_division ? (ExprVec*)aligned_alloc(EXPR_ALIGN, block_bytes * depth) : NULL;
+    if (!stack || (program->has_division && !faults)) {
+        perror("malloc failed for expression stack");
+        exit(1);
+    }
+
+    size_t failed = 0;
+    for (size_t start = 0; start < rows; start += EXPR_BLOCK) {
+        size_t count = rows - start < EXPR_BLOCK ? rows - start : EXPR_BLOCK;
+        eval_block(program, columns, start, count, stack, faults);
+        memcpy(out + start, stack, sizeof(int32_t) * count);
+        if (!faults) continue;
+        const int32_t* fault = (const int32_t*)faults;
+        for (size_t r = 0; r < count; r++) {
+            if (!fault[r]) continue;
+            out[start + r] = 0;
+            failed++;
+        }
+    }
+    free(faults);
+    free(stack);
+    return failed;
+}
@@ -0,0 +1,62 @@
+#ifndef EXPR_EVAL_H
+#define EXPR_EVAL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "ast.h"
+
+// ========== 公式批量求值 ==========
+//
+// 面向"若干int变量声明 + 一个表达式或赋值"的公式(如test_legal.c):
+// 编译一次为扁平的后缀程序, 再对一批变量绑定求值。绑定按列给出:
+// 第i个声明的变量对应 columns[i], 每列rows个int; 列为NULL时整列取该变量的初值(没有初值为0)。
+// 求值按块进行: 每条后缀指令对整块EXPR_BLOCK行做同一运算,
+// GCC/Clang下用向量扩展每次处理EXPR_LANES行(编译为SSE/NEON等SIMD指令), 除法逐行计算。
+// 语义与编译出的代码相同: int按32位回绕, 比较和 && || ! 的结果是0或1;
+// 除数为0的行结果为0并计入返回值, 但被 && || 短路的一侧不算。
+
+#define EXPR_BLOCK 256
+
+typedef enum {
+    EXPR_LOAD,      // 压入变量value的列
+    EXPR_CONST,     // 压入常量value
+    EXPR_ADD, EXPR_SUB, EXPR_MUL, EXPR_DIV, EXPR_MOD,
+    EXPR_LT, EXPR_LE, EXPR_GT, EXPR_GE, EXPR_EQ, EXPR_NE,
+    EXPR_AND, EXPR_OR,
+    EXPR_NEG, EXPR_NOT
+} ExprOpcode;
+
+typedef struct ExprInstr {
+    uint8_t op;             // ExprOpcode
+    bool immediate;         // 二元运算的右操作数是常量value, 不占栈
+    int32_t value;
+} ExprInstr;
+
+typedef struct ExprProgram {
+    ExprInstr* code;
+    int code_count;
+    int code_capacity;
+    int max_depth;          // 求值栈的最大深度(块数)
+    bool has_division;      // 有除法时才需要逐行记录除数为0
+
+    char** names;           // 变量名, 按声明顺序
+    int32_t* defaults;      // 变量的初值
+    int variable_count;
+    int target;             // 被赋值的变量, -1表示公式只是一个表达式
+} ExprProgram;
+
+// 从已通过语义分析的AST编译; 公式之外的语句(函数、数组、调用等)写错误到err并返回NULL
+ExprProgram* expr_program_compile(const ASTNode* program, FILE* err);
+// 词法、语法、语义分析后编译; 诊断只在失败时写到err
+ExprProgram* expr_program_create(const char* source, size_t length, FILE* err);
+void expr_program_destroy(ExprProgram* program);
+
+// 变量的列号, 找不到返回-1
+int expr_program_variable(const ExprProgram* program, const char* name);
+
+// 对rows行绑定求值, 结果写入out; 返回除数为0的行数。可在多个线程中同时对同一程序求值
+size_t expr_program_eval(const ExprProgram* program, const int32_t* const* columns, size_t rows, int32_t* out);
+
+#endif // EXPR_EVAL_H
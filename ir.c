@@ -0,0 +1,672 @@
+#include "ir.h"
+#include <stdlib.h>
+#include <string.h>
+
+// ========== 模块 ==========
+
+IRModule* ir_module_create(void) {
+    IRModule* module = (IRModule*)malloc(sizeof(IRModule));
+    if (!module) {
+        perror("malloc failed for IRModule");
+        exit(1);
+    }
+    memset(module, 0, sizeof(IRModule));
+    module->arena = arena_create(0);
+    return module;
+}
+
+void ir_module_destroy(IRModule* module) {
+    if (!module) return;
+
+    // 模块的所有数组都在Arena中
+    arena_destroy(module->arena);
+    free(module);
+}
+
+int ir_module_add_global(IRModule* module, const char* name, IRType type, int count) {
+    ARENA_RESERVE(module->arena, module->globals, module->global_count, module->global_capacity);
+
+    IRGlobal* global = &module->globals[module->global_count];
+    global->name = arena_strdup(module->arena, name);
+    global->type = type;
+    global->count = count;
+    global->init = 0;
+    return module->global_count++;
+}
+
+int ir_module_add_function(IRModule* module, const char* name, IRType return_type, int param_count) {
+    ARENA_RESERVE(module->arena, module->functions, module->function_count, module->function_capacity);
+
+    IRFunction* function = &module->functions[module->function_count];
+    memset(function, 0, sizeof(IRFunction));
+    function->name = arena_strdup(module->arena, name);
+    function->return_type = return_type;
+    function->param_count = param_count;
+    function->is_defined = false;
+    function->arena = module->arena;
+
+    // 参数占用前param_count个虚拟寄存器
+    for (int i = 0; i < param_count; i++) {
+        ir_new_vreg(function, IR_TYPE_I32);
+    }
+    return module->function_count++;
+}
+
+int ir_module_find_function(const IRModule* module, const char* name) {
+    for (int i = 0; i < module->function_count; i++) {
+        if (strcmp(module->functions[i].name, name) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+int ir_module_instr_count(const IRModule* module) {
+    int count = 0;
+    for (int f = 0; f < module->function_count; f++) {
+        const IRFunction* function = &module->functions[f];
+        for (int b = 0; b < function->block_count; b++) {
+            const IRBlock* block = &function->blocks[b];
+            for (int i = 0; i < block->instr_count; i++) {
+                if (function->instrs[block->instrs[i]].op != IR_NOP) count++;
+            }
+        }
+    }
+    return count;
+}
+
+// ========== 函数构建 ==========
+
+int ir_new_block(IRFunction* function) {
+    ARENA_RESERVE(function->arena, function->blocks, function->block_count, function->block_capacity);
+
+    IRBlock* block = &function->blocks[function->block_count];
+    memset(block, 0, sizeof(IRBlock));
+    block->count = -1;
+    return function->block_count++;
+}
+
+int ir_new_vreg(IRFunction* function, IRType type) {
+    ARENA_RESERVE(function->arena, function->vreg_types, function->vreg_count, function->vreg_capacity);
+
+    function->vreg_types[function->vreg_count] = type;
+    return function->vreg_count++;
+}
+
+int ir_new_slot(IRFunction* function, const char* name, IRType type, int count, int param) {
+    ARENA_RESERVE(function->arena, function->slots, function->slot_count, function->slot_capacity);
+
+    IRSlot* slot = &function->slots[function->slot_count];
+    slot->name = name ? arena_strdup(function->arena, name) : NULL;
+    slot->type = type;
+    slot->count = count;
+    slot->param = param;
+    slot->line = 0;
+    slot->promoted = false;
+    return function->slot_count++;
+}
+
+int ir_emit(IRFunction* function, int block, IROpcode op, IRType type, bool has_dest,
+            const IROperand* args, int arg_count, int line) {
+    ARENA_RESERVE(function->arena, function->instrs, function->instr_count, function->instr_capacity);
+
+    int id = function->instr_count++;
+    IRInstr* instr = &function->instrs[id];
+    instr->op = op;
+    instr->type = type;
+    instr->arg_count = arg_count;
+    instr->dest = has_dest ? ir_new_vreg(function, type) : -1;
+    instr->args = function->operand_count;
+    instr->block = block;
+    instr->line = line;
+
+    for (int i = 0; i < arg_count; i++) {
+        ARENA_RESERVE(function->arena, function->operands, function->operand_count,
+                      function->operand_capacity);
+        function->operands[function->operand_count++] = args[i];
+    }
+
+    IRBlock* target = &function->blocks[block];
+    ARENA_RESERVE(function->arena, target->instrs, target->instr_count, target->instr_capacity);
+    target->instrs[target->instr_count++] = id;
+    return id;
+}
+
+bool ir_opcode_is_terminator(IROpcode op) {
+    return op == IR_JMP || op == IR_BR || op == IR_RET;
+}
+
+IRInstr* ir_block_terminator(IRFunction* function, int block) {
+    IRBlock* b = &function->blocks[block];
+    if (b->instr_count == 0) return NULL;
+    return &function->instrs[b->instrs[b->instr_count - 1]];
+}
+
+bool ir_is_tail_call(const IRFunction* function, int block, int index) {
+    const IRBlock* b = &function->blocks[block];
+    const IRInstr* call = &function->instrs[b->instrs[index]];
+    if (call->op != IR_CALL) return false;
+    int next = index + 1;
+    while (next < b->instr_count && function->instrs[b->instrs[next]].op == IR_NOP) next++;
+    if (next != b->instr_count - 1) return false;
+    const IRInstr* ret = &function->instrs[b->instrs[next]];
+    if (ret->op != IR_RET) return false;
+    if (ret->arg_count == 0) return true;
+    const IROperand* value = &function->operands[ret->args];
+    return call->dest >= 0 && value->kind == IR_OPERAND_VREG && value->value == call->dest;
+}
+
+bool ir_function_takes_slot_address(const IRFunction* function) {
+    for (int b = 0; b < function->block_count; b++) {
+        const IRBlock* block = &function->blocks[b];
+        for (int i = 0; i < block->instr_count; i++) {
+            const IRInstr* instr = &function->instrs[block->instrs[i]];
+            if (instr->op == IR_ADDR && function->operands[instr->args].kind == IR_OPERAND_SLOT) return true;
+        }
+    }
+    return false;
+}
+
+static void add_pred(IRFunction* function, int block, int pred) {
+    IRBlock* b = &function->blocks[block];
+    ARENA_RESERVE(function->arena, b->preds, b->pred_count, b->pred_capacity);
+    b->preds[b->pred_count++] = pred;
+}
+
+void ir_function_compute_cfg(IRFunction* function) {
+    for (int i = 0; i < function->block_count; i++) {
+        function->blocks[i].succ_count = 0;
+        function->blocks[i].pred_count = 0;
+    }
+
+    for (int i = 0; i < function->block_count; i++) {
+        IRBlock* block = &function->blocks[i];
+        IRInstr* term = ir_block_terminator(function, i);
+        if (!term) continue;
+
+        IROperand* args = ir_instr_args(function, term);
+        if (term->op == IR_JMP) {
+            block->succs[block->succ_count++] = args[0].value;
+        } else if (term->op == IR_BR) {
+            block->succs[block->succ_count++] = args[1].value;
+            if (args[2].value != args[1].value) {
+                block->succs[block->succ_count++] = args[2].value;
+            }
+        }
+        for (int s = 0; s < block->succ_count; s++) {
+            add_pred(function, block->succs[s], i);
+        }
+    }
+}
+
+int ir_function_remove_unreachable(IRFunction* function) {
+    if (function->block_count == 0) return 0;
+
+    int* stack = (int*)malloc(sizeof(int) * function->block_count);
+    bool* reachable = (bool*)calloc(function->block_count, sizeof(bool));
+    if (!stack || !reachable) {
+        perror("malloc failed for reachability");
+        exit(1);
+    }
+
+    int depth = 0;
+    stack[depth++] = 0;
+    reachable[0] = true;
+    while (depth > 0) {
+        IRBlock* block = &function->blocks[stack[--depth]];
+        for (int s = 0; s < block->succ_count; s++) {
+            if (!reachable[block->succs[s]]) {
+                reachable[block->succs[s]] = true;
+                stack[depth++] = block->succs[s];
+            }
+        }
+    }
+
+    int removed = 0;
+    for (int b = 0; b < function->block_count; b++) {
+        IRBlock* block = &function->blocks[b];
+        if (reachable[b] || block->instr_count == 0) continue;
+
+        for (int i = 0; i < block->instr_count; i++) {
+            function->instrs[block->instrs[i]].op = IR_NOP;
+        }
+        block->instr_count = 0;
+        removed++;
+    }
+    free(stack);
+    free(reachable);
+
+    ir_function_compute_cfg(function);
+
+    // 汇合点的phi去掉来自已不是前驱的块(已删除或分支已改写)的输入
+    for (int b = 0; b < function->block_count; b++) {
+        IRBlock* block = &function->blocks[b];
+        for (int i = 0; i < block->instr_count; i++) {
+            IRInstr* instr = &function->instrs[block->instrs[i]];
+            if (instr->op == IR_NOP) continue;  // 常量传播已折叠的phi
+            if (instr->op != IR_PHI) break;
+
+            IROperand* args = ir_instr_args(function, instr);
+            int kept = 0;
+            for (int a = 0; a < instr->arg_count; a += 2) {
+                bool is_pred = false;
+                for (int p = 0; p < block->pred_count; p++) {
+                    if (block->preds[p] == args[a].value) is_pred = true;
+                }
+                if (!is_pred) continue;
+                args[kept++] = args[a];
+                args[kept++] = args[a + 1];
+            }
+            instr->arg_count = kept;
+        }
+    }
+    return removed;
+}
+
+void ir_function_compact(IRFunction* function) {
+    for (int b = 0; b < function->block_count; b++) {
+        IRBlock* block = &function->blocks[b];
+        int kept = 0;
+        for (int i = 0; i < block->instr_count; i++) {
+            if (function->instrs[block->instrs[i]].op != IR_NOP) {
+                block->instrs[kept++] = block->instrs[i];
+            }
+        }
+        block->instr_count = kept;
+    }
+}
+
+int ir_function_split_critical_edges(IRFunction* function) {
+    int created = 0;
+    bool changed = false;
+    int original = function->block_count;
+    for (int b = 0; b < original; b++) {
+        IRInstr* term = ir_block_terminator(function, b);
+        if (!term || term->op != IR_BR) continue;
+
+        IROperand* args = ir_instr_args(function, term);
+        if (args[1].value == args[2].value) {
+            args[0] = args[1];
+            term->op = IR_JMP;
+            term->arg_count = 1;
+            changed = true;
+            continue;
+        }
+
+        for (int t = 1; t <= 2; t++) {
+            int target = ir_instr_args(function, ir_block_terminator(function, b))[t].value;
+            if (function->blocks[target].pred_count < 2) continue;
+
+            int middle = ir_new_block(function);
+            IROperand jump = ir_operand_block(target);
+            int line = ir_block_terminator(function, b)->line;
+            ir_emit(function, middle, IR_JMP, IR_TYPE_VOID, false, &jump, 1, line);
+            ir_instr_args(function, ir_block_terminator(function, b))[t].value = middle;
+
+            // 目标块phi中来自b的输入改为来自新块
+            IRBlock* block = &function->blocks[target];
+            for (int i = 0; i < block->instr_count; i++) {
+                IRInstr* phi = &function->instrs[block->instrs[i]];
+                if (phi->op != IR_PHI) break;
+                IROperand* inputs = ir_instr_args(function, phi);
+                for (int a = 0; a < phi->arg_count; a += 2) {
+                    if (inputs[a].value == b) inputs[a].value = middle;
+                }
+            }
+            created++;
+        }
+    }
+    if (created > 0 || changed) ir_function_compute_cfg(function);
+    return created;
+}
+
+int ir_insert_phi(IRFunction* function, int block, IRType type) {
+    IRBlock* b = &function->blocks[block];
+    IROperand none = { IR_OPERAND_NONE, IR_TYPE_VOID, 0 };
+
+    // 先追加到块尾, 再移动到已有phi之后
+    int pred_count = b->pred_count;
+    int id = ir_emit(function, block, IR_PHI, type, true, NULL, 0, function->line);
+    IRInstr* instr = &function->instrs[id];
+    instr->args = function->operand_count;
+    instr->arg_count = pred_count * 2;
+    for (int p = 0; p < pred_count; p++) {
+        ARENA_RESERVE(function->arena, function->operands, function->operand_count,
+                      function->operand_capacity);
+        function->operands[function->operand_count++] = ir_operand_block(b->preds[p]);
+        ARENA_RESERVE(function->arena, function->operands, function->operand_count,
+                      function->operand_capacity);
+        function->operands[function->operand_count++] = none;
+    }
+
+    int position = 0;
+    while (position < b->instr_count - 1 &&
+           function->instrs[b->instrs[position]].op == IR_PHI) {
+        position++;
+    }
+    memmove(&b->instrs[position + 1], &b->instrs[position],
+            sizeof(int32_t) * (size_t)(b->instr_count - 1 - position));
+    b->instrs[position] = id;
+    return id;
+}
+
+// ========== 使用列表 ==========
+
+// out为NULL时统计每个虚拟寄存器的使用次数, 否则按fill的位置填写使用者
+static void for_each_use(const IRFunction* function, int* counts, int* fill, int* out) {
+    for (int b = 0; b < function->block_count; b++) {
+        const IRBlock* block = &function->blocks[b];
+        for (int i = 0; i < block->instr_count; i++) {
+            int id = block->instrs[i];
+            const IRInstr* instr = &function->instrs[id];
+            const IROperand* args = &function->operands[instr->args];
+
+            for (int a = 0; a < instr->arg_count; a++) {
+                if (args[a].kind != IR_OPERAND_VREG) continue;
+
+                bool repeated = false;
+                for (int prev = 0; prev < a; prev++) {
+                    if (args[prev].kind == IR_OPERAND_VREG && args[prev].value == args[a].value) {
+                        repeated = true;
+                        break;
+                    }
+                }
+                if (repeated) continue;
+
+                int vreg = args[a].value;
+                if (out) {
+                    out[fill[vreg]++] = id;
+                } else {
+                    counts[vreg + 1]++;
+                }
+            }
+        }
+    }
+}
+
+IRUses* ir_uses_create(const IRFunction* function) {
+    IRUses* uses = (IRUses*)malloc(sizeof(IRUses));
+    int n = function->vreg_count;
+    if (!uses) {
+        perror("malloc failed for IRUses");
+        exit(1);
+    }
+    uses->vreg_count = n;
+    uses->start = (int*)calloc((size_t)n + 1, sizeof(int));
+    if (!uses->start) {
+        perror("calloc failed for IRUses");
+        exit(1);
+    }
+
+    for_each_use(function, uses->start, NULL, NULL);
+    for (int v = 0; v < n; v++) {
+        uses->start[v + 1] += uses->start[v];
+    }
+
+    uses->instrs = (int*)malloc(sizeof(int) * (size_t)(uses->start[n] > 0 ? uses->start[n] : 1));
+    int* fill = (int*)malloc(sizeof(int) * (size_t)(n > 0 ? n : 1));
+    if (!uses->instrs || !fill) {
+        perror("malloc failed for IRUses");
+        exit(1);
+    }
+    memcpy(fill, uses->start, sizeof(int) * (size_t)n);
+    for_each_use(function, NULL, fill, uses->instrs);
+    free(fill);
+    return uses;
+}
+
+void ir_uses_destroy(IRUses* uses) {
+    if (!uses) return;
+
+    free(uses->start);
+    free(uses->instrs);
+    free(uses);
+}
+
+void ir_function_replace_uses(IRFunction* function, IROperand* map) {
+    for (int b = 0; b < function->block_count; b++) {
+        IRBlock* block = &function->blocks[b];
+        for (int i = 0; i < block->instr_count; i++) {
+            IRInstr* instr = &function->instrs[block->instrs[i]];
+            IROperand* args = ir_instr_args(function, instr);
+
+            for (int a = 0; a < instr->arg_count; a++) {
+                // 沿替换链找到最终的值, 并把链压缩到它
+                IROperand value = args[a];
+                while (value.kind == IR_OPERAND_VREG && map[value.value].kind != IR_OPERAND_NONE) {
+                    value = map[value.value];
+                }
+                if (args[a].kind == IR_OPERAND_VREG && value.kind != IR_OPERAND_VREG &&
+                    value.kind != IR_OPERAND_NONE) {
+                    // 常量的类型以原寄存器为准
+                    value.type = args[a].type;
+                }
+                if (args[a].kind == IR_OPERAND_VREG && map[args[a].value].kind != IR_OPERAND_NONE) {
+                    map[args[a].value] = value;
+                }
+                args[a] = value;
+            }
+        }
+    }
+}
+
+// ========== 操作数构造 ==========
+
+static IROperand make_operand(IROperandKind kind, IRType type, int value) {
+    IROperand operand;
+    operand.kind = kind;
+    operand.type = type;
+    operand.value = value;
+    return operand;
+}
+
+IROperand ir_operand_vreg(int vreg, IRType type) {
+    return make_operand(IR_OPERAND_VREG, type, vreg);
+}
+
+IROperand ir_operand_const(int value, IRType type) {
+    return make_operand(IR_OPERAND_CONST, type, value);
+}
+
+IROperand ir_operand_slot(int slot, IRType type) {
+    return make_operand(IR_OPERAND_SLOT, type, slot);
+}
+
+IROperand ir_operand_global(int global, IRType type) {
+    return make_operand(IR_OPERAND_GLOBAL, type, global);
+}
+
+IROperand ir_operand_block(int block) {
+    return make_operand(IR_OPERAND_BLOCK, IR_TYPE_VOID, block);
+}
+
+IROperand ir_operand_func(int function) {
+    return make_operand(IR_OPERAND_FUNC, IR_TYPE_VOID, function);
+}
+
+// ========== 输出 ==========
+
+const char* ir_opcode_name(IROpcode op) {
+    switch (op) {
+        case IR_NOP: return "nop";
+        case IR_ADD: return "add";
+        case IR_SUB: return "sub";
+        case IR_MUL: return "mul";
+        case IR_DIV: return "div";
+        case IR_MOD: return "mod";
+        case IR_NEG: return "neg";
+        case IR_SHL: return "shl";
+        case IR_SHR: return "shr";
+        case IR_AND: return "and";
+        case IR_EQ: return "eq";
+        case IR_NE: return "ne";
+        case IR_LT: return "lt";
+        case IR_LE: return "le";
+        case IR_GT: return "gt";
+        case IR_GE: return "ge";
+        case IR_NOT: return "not";
+        case IR_ZEXT: return "zext";
+        case IR_COPY: return "copy";
+        case IR_PHI: return "phi";
+        case IR_ADDR: return "addr";
+        case IR_LOAD: return "load";
+        case IR_STORE: return "store";
+        case IR_VLOAD: return "vload";
+        case IR_VSTORE: return "vstore";
+        case IR_SPLAT: return "splat";
+        case IR_COUNT: return "count";
+        case IR_CALL: return "call";
+        case IR_JMP: return "jmp";
+        case IR_BR: return "br";
+        case IR_RET: return "ret";
+        default: return "?";
+    }
+}
+
+const char* ir_type_name(IRType type) {
+    switch (type) {
+        case IR_TYPE_VOID: return "void";
+        case IR_TYPE_BOOL: return "bool";
+        case IR_TYPE_I32: return "i32";
+        case IR_TYPE_PTR: return "ptr";
+        case IR_TYPE_V4I32: return "v4i32";
+        default: return "?";
+    }
+}
+
+static void print_operand(FILE* out, const IRModule* module, const IRFunction* function,
+                          IROperand operand) {
+    switch (operand.kind) {
+        case IR_OPERAND_VREG:
+            fprintf(out, "%%%d", operand.value);
+            break;
+        case IR_OPERAND_CONST:
+            fprintf(out, "%d", operand.value);
+            break;
+        case IR_OPERAND_SLOT: {
+            const IRSlot* slot = &function->slots[operand.value];
+            if (slot->name) {
+                fprintf(out, "$%d.%s", operand.value, slot->name);
+            } else {
+                fprintf(out, "$%d", operand.value);
+            }
+            break;
+        }
+        case IR_OPERAND_GLOBAL:
+            fprintf(out, "@%s", module->globals[operand.value].name);
+            break;
+        case IR_OPERAND_BLOCK:
+            fprintf(out, "bb%d", operand.value);
+            break;
+        case IR_OPERAND_FUNC:
+            fprintf(out, "@%s", module->functions[operand.value].name);
+            break;
+        default:
+            fprintf(out, "_");
+            break;
+    }
+}
+
+void ir_function_print(FILE* out, const IRModule* module, const IRFunction* function) {
+    fprintf(out, "%s %s @%s(", function->is_defined ? "func" : "declare",
+            ir_type_name(function->return_type), function->name);
+    for (int i = 0; i < function->param_count; i++) {
+        fprintf(out, "%si32 %%%d", i > 0 ? ", " : "", i);
+    }
+    fprintf(out, ")");
+    if (!function->is_defined) {
+        fprintf(out, "\n");
+        return;
+    }
+    fprintf(out, " {\n");
+
+    for (int i = 0; i < function->slot_count; i++) {
+        const IRSlot* slot = &function->slots[i];
+        if (slot->promoted) continue;
+        fprintf(out, "  $%d", i);
+        if (slot->name) fprintf(out, ".%s", slot->name);
+        fprintf(out, ": %s", ir_type_name(slot->type));
+        if (slot->count > 1) fprintf(out, "[%d]", slot->count);
+        if (slot->param >= 0) fprintf(out, " (参数 %d)", slot->param);
+        fprintf(out, "\n");
+    }
+
+    for (int b = 0; b < function->block_count; b++) {
+        const IRBlock* block = &function->blocks[b];
+        if (block->instr_count == 0 && b > 0) continue;   // 已删除的基本块
+        fprintf(out, "bb%d:", b);
+        if (block->pred_count > 0) {
+            fprintf(out, "  ; 前驱");
+            for (int p = 0; p < block->pred_count; p++) {
+                fprintf(out, " bb%d", block->preds[p]);
+            }
+        }
+        if (block->count >= 0) {
+            fprintf(out, "%s 执行 %lld 次", block->pred_count > 0 ? "," : "  ;", (long long)block->count);
+        }
+        fprintf(out, "\n");
+
+        for (int i = 0; i < block->instr_count; i++) {
+            const IRInstr* instr = &function->instrs[block->instrs[i]];
+            if (instr->op == IR_NOP) continue;
+
+            fprintf(out, "  ");
+            if (instr->dest >= 0) {
+                fprintf(out, "%%%d = ", instr->dest);
+            }
+            fprintf(out, "%s", ir_opcode_name(instr->op));
+            if (instr->dest >= 0) {
+                fprintf(out, " %s", ir_type_name(instr->type));
+            }
+
+            const IROperand* args = &function->operands[instr->args];
+            if (instr->op == IR_PHI) {
+                for (int a = 0; a + 1 < instr->arg_count; a += 2) {
+                    fprintf(out, "%s[bb%d: ", a > 0 ? ", " : " ", args[a].value);
+                    print_operand(out, module, function, args[a + 1]);
+                    fprintf(out, "]");
+                }
+            } else if (instr->op == IR_LOAD || instr->op == IR_ADDR || instr->op == IR_STORE ||
+                       instr->op == IR_VLOAD || instr->op == IR_VSTORE || instr->op == IR_COUNT) {
+                // 内存访问写成 base[index] 的形式
+                int index = instr->op == IR_STORE || instr->op == IR_VSTORE ? 2 : 1;
+                fprintf(out, " ");
+                print_operand(out, module, function, args[0]);
+                if (instr->arg_count > index) {
+                    fprintf(out, "[");
+                    print_operand(out, module, function, args[index]);
+                    fprintf(out, "]");
+                }
+                if (instr->op == IR_STORE || instr->op == IR_VSTORE) {
+                    fprintf(out, ", ");
+                    print_operand(out, module, function, args[1]);
+                }
+            } else {
+                for (int a = 0; a < instr->arg_count; a++) {
+                    fprintf(out, "%s", a > 0 ? ", " : " ");
+                    print_operand(out, module, function, args[a]);
+                }
+            }
+            fprintf(out, "\n");
+        }
+    }
+    fprintf(out, "}\n");
+}
+
+void ir_module_print(FILE* out, const IRModule* module) {
+    for (int i = 0; i < module->global_count; i++) {
+        const IRGlobal* global = &module->globals[i];
+        fprintf(out, "global @%s: %s", global->name, ir_type_name(global->type));
+        if (global->count > 1) {
+            fprintf(out, "[%d]\n", global->count);
+        } else {
+            fprintf(out, " = %d\n", global->init);
+        }
+    }
+    if (module->global_count > 0) fprintf(out, "\n");
+
+    for (int i = 0; i < module->function_count; i++) {
+        ir_function_print(out, module, &module->functions[i]);
+        if (i + 1 < module->function_count) fprintf(out, "\n");
+    }
+}
@@ -0,0 +1,258 @@
+#ifndef IR_H
+#define IR_H
+
+#include "arena.h"
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+// ========== 三地址中间代码(IR) ==========
+//
+// 每个函数由基本块组成, 基本块是线性的三地址指令序列, 以跳转/返回指令结束。
+// 指令、操作数、基本块、栈槽、虚拟寄存器都存放在函数内的稠密数组中,
+// 彼此之间用整数编号引用; 所有数组从模块的Arena分配, 随模块整体释放。
+//
+// 变量在SSA构造之前存放在栈槽($N)中, 通过load/store访问;
+// 表达式的中间结果存放在虚拟寄存器(%N)中, 每个虚拟寄存器只被赋值一次。
+// SSA构造(ir_ssa.h)把不取地址的标量栈槽提升为虚拟寄存器, 在汇合点插入phi。
+
+// IR值类型
+typedef enum {
+    IR_TYPE_VOID,
+    IR_TYPE_BOOL,   // 比较和逻辑运算的结果(0或1)
+    IR_TYPE_I32,    // int
+    IR_TYPE_PTR,    // 取地址的结果
+    IR_TYPE_V4I32   // 4个int组成的向量(循环向量化, 见ir_unroll.h), 只在定值的块内使用
+} IRType;
+
+// 操作数种类
+typedef enum {
+    IR_OPERAND_NONE,
+    IR_OPERAND_VREG,    // 虚拟寄存器 %N
+    IR_OPERAND_CONST,   // 整数常量
+    IR_OPERAND_SLOT,    // 当前函数的栈槽 $N(局部变量、参数、数组、临时变量)
+    IR_OPERAND_GLOBAL,  // 全局变量 @name
+    IR_OPERAND_BLOCK,   // 基本块 bbN(跳转目标)
+    IR_OPERAND_FUNC     // 函数 @name(调用目标)
+} IROperandKind;
+
+// 操作数: 种类 + 类型 + 编号(或常量值), 共8字节
+typedef struct IROperand {
+    uint8_t kind;       // IROperandKind
+    uint8_t type;       // IRType
+    int32_t value;
+} IROperand;
+
+typedef enum {
+    IR_NOP,             // 已删除的指令
+
+    // 算术: dest = a op b
+    IR_ADD, IR_SUB, IR_MUL, IR_DIV, IR_MOD,
+    IR_NEG,             // dest = -a
+    IR_SHL,             // dest = a << b
+    IR_SHR,             // dest = a >> b(算术右移)
+    IR_AND,             // dest = a & b
+
+    // 比较: dest(bool) = a op b
+    IR_EQ, IR_NE, IR_LT, IR_LE, IR_GT, IR_GE,
+    IR_NOT,             // dest(bool) = !a
+    IR_ZEXT,            // dest(i32) = a(bool)
+    IR_COPY,            // dest = a
+    IR_PHI,             // dest = phi [bb1: a1], [bb2: a2] ...; 操作数按(前驱块, 值)成对存放, 位于块首
+
+    // 内存: base是栈槽、全局变量或指针, index为元素下标(标量省略)
+    IR_ADDR,            // dest(ptr) = &base[index]
+    IR_LOAD,            // dest = base[index]
+    IR_STORE,           // base[index] = value; 操作数依次为 base, value[, index]
+
+    // 向量: add/sub/and对两个v4i32逐个元素运算, shl/shr的移位数是常量; base是栈槽或全局数组
+    IR_VLOAD,           // dest(v4i32) = base[index .. index+3]
+    IR_VSTORE,          // base[index .. index+3] = value; 操作数依次为 base, value, index
+    IR_SPLAT,           // dest(v4i32) = 4个a
+
+    // profile插桩(见profile.h): base[index .. index+1]作为64位计数器加1; 操作数依次为 base(全局变量), index(常量)
+    IR_COUNT,
+
+    IR_CALL,            // dest = func(args...); 第一个操作数是函数
+
+    // 终结指令
+    IR_JMP,             // goto bb
+    IR_BR,              // if (a) goto bb1 else goto bb2
+    IR_RET,             // return [a]
+
+    IR_OPCODE_COUNT
+} IROpcode;
+
+typedef struct IRInstr {
+    uint8_t op;         // IROpcode
+    uint8_t type;       // 结果类型(IRType)
+    uint16_t arg_count; // 操作数个数
+    int32_t dest;       // 结果虚拟寄存器, -1表示没有结果
+    int32_t args;       // 第一个操作数在IRFunction.operands中的下标
+    int32_t block;      // 所属基本块
+    int32_t line;       // 源代码行号
+} IRInstr;
+
+typedef struct IRBlock {
+    int32_t* instrs;    // 指令编号, 按执行顺序
+    int instr_count;
+    int instr_capacity;
+
+    // 控制流图(由ir_function_compute_cfg根据终结指令计算)
+    int32_t succs[2];
+    int succ_count;
+    int32_t* preds;
+    int pred_count;
+    int pred_capacity;
+
+    int64_t count;      // profile中记录的执行次数(见profile.h), -1表示未知
+} IRBlock;
+
+// 栈槽: 局部变量、参数或编译器生成的临时变量
+typedef struct IRSlot {
+    const char* name;   // 变量名(临时变量为NULL)
+    uint8_t type;       // 元素类型
+    int32_t count;      // 元素个数(标量为1)
+    int32_t param;      // 参数序号, -1表示不是参数
+    int32_t line;       // 声明所在行(临时变量为0)
+    bool promoted;      // 已被SSA构造提升为虚拟寄存器, 不再占用栈空间
+} IRSlot;
+
+typedef struct IRGlobal {
+    const char* name;
+    uint8_t type;       // 元素类型
+    int32_t count;      // 元素个数(标量为1)
+    int32_t init;       // 标量的初始值(未初始化时为0)
+} IRGlobal;
+
+typedef struct IRFunction {
+    const char* name;
+    uint8_t return_type;
+    int param_count;    // 参数依次存放在虚拟寄存器 %0 .. %(param_count-1)
+    bool is_defined;    // false表示只有声明
+    bool is_ssa;        // 是否已经过SSA构造
+    int line;
+    Arena* arena;       // 所属模块的Arena
+
+    IRInstr* instrs;
+    int instr_count;
+    int instr_capacity;
+
+    IROperand* operands;
+    int operand_count;
+    int operand_capacity;
+
+    IRBlock* blocks;    // 0号基本块是入口
+    int block_count;
+    int block_capacity;
+
+    IRSlot* slots;
+    int slot_count;
+    int slot_capacity;
+
+    uint8_t* vreg_types; // 每个虚拟寄存器的类型
+    int vreg_count;
+    int vreg_capacity;
+} IRFunction;
+
+typedef struct IRModule {
+    Arena* arena;
+
+    IRFunction* functions;
+    int function_count;
+    int function_capacity;
+
+    IRGlobal* globals;
+    int global_count;
+    int global_capacity;
+} IRModule;
+
+// ========== 模块 ==========
+
+IRModule* ir_module_create(void);
+void ir_module_destroy(IRModule* module);
+int ir_module_add_global(IRModule* module, const char* name, IRType type, int count);
+int ir_module_add_function(IRModule* module, const char* name, IRType return_type, int param_count);
+// 按名字查找函数, 找不到返回-1
+int ir_module_find_function(const IRModule* module, const char* name);
+// 各基本块中(不含nop)的指令总数
+int ir_module_instr_count(const IRModule* module);
+
+// ========== 函数构建 ==========
+
+int ir_new_block(IRFunction* function);
+int ir_new_vreg(IRFunction* function, IRType type);
+int ir_new_slot(IRFunction* function, const char* name, IRType type, int count, int param);
+
+// 在block末尾追加一条指令, has_dest为true时分配新的结果虚拟寄存器, 返回指令编号
+int ir_emit(IRFunction* function, int block, IROpcode op, IRType type, bool has_dest,
+            const IROperand* args, int arg_count, int line);
+
+// 根据每个基本块的终结指令计算前驱和后继
+void ir_function_compute_cfg(IRFunction* function);
+
+// 清空从入口不可达的基本块(指令改为nop), 重新计算控制流图,
+// 并去掉phi中来自已不是前驱的块的输入; 返回清空的块数
+int ir_function_remove_unreachable(IRFunction* function);
+// 从各基本块的指令列表中去掉nop
+void ir_function_compact(IRFunction* function);
+// 在关键边(多后继块 → 多前驱块)上插入只含跳转的新块, 两个目标相同的br改为jmp;
+// 之后每条边上的复制都可以放在起点块末尾或终点块开头。返回新建的块数
+int ir_function_split_critical_edges(IRFunction* function);
+
+// 在block的已有phi之后插入一条phi, 为每个前驱预留(块, 值)操作数, 值初始为空; 返回指令编号
+int ir_insert_phi(IRFunction* function, int block, IRType type);
+
+static inline IRInstr* ir_instr(IRFunction* function, int id) {
+    return &function->instrs[id];
+}
+
+static inline IROperand* ir_instr_args(IRFunction* function, const IRInstr* instr) {
+    return &function->operands[instr->args];
+}
+
+// 基本块的最后一条指令, 空基本块返回NULL
+IRInstr* ir_block_terminator(IRFunction* function, int block);
+bool ir_opcode_is_terminator(IROpcode op);
+// block中第index条指令是否是尾调用: call之后(跳过nop)紧接着块末的ret, ret返回call的结果或不返回值
+bool ir_is_tail_call(const IRFunction* function, int block, int index);
+// 函数是否取了栈槽的地址; 取了地址的栈槽可能在调用期间被访问, 不能在调用前释放栈帧
+bool ir_function_takes_slot_address(const IRFunction* function);
+
+// ========== 使用列表 ==========
+
+// 每个虚拟寄存器被哪些指令使用(按CSR存放, 同一指令多次使用只记一次)
+typedef struct IRUses {
+    int vreg_count;
+    int* start;         // vreg的使用者为 instrs[start[vreg] .. start[vreg+1])
+    int* instrs;
+} IRUses;
+
+// 统计各基本块中现有指令的使用; 修改IR后需要重新构建
+IRUses* ir_uses_create(const IRFunction* function);
+void ir_uses_destroy(IRUses* uses);
+
+static inline int ir_uses_count(const IRUses* uses, int vreg) {
+    return uses->start[vreg + 1] - uses->start[vreg];
+}
+
+// 把所有对虚拟寄存器的使用按map替换(map[v].kind为NONE表示不替换), 会沿替换链解析
+void ir_function_replace_uses(IRFunction* function, IROperand* map);
+
+// ========== 操作数构造 ==========
+
+IROperand ir_operand_vreg(int vreg, IRType type);
+IROperand ir_operand_const(int value, IRType type);
+IROperand ir_operand_slot(int slot, IRType type);
+IROperand ir_operand_global(int global, IRType type);
+IROperand ir_operand_block(int block);
+IROperand ir_operand_func(int function);
+
+// ========== 输出 ==========
+
+void ir_module_print(FILE* out, const IRModule* module);
+void ir_function_print(FILE* out, const IRModule* module, const IRFunction* function);
+const char* ir_opcode_name(IROpcode op);
+const char* ir_type_name(IRType type);
+
+#endif // IR_H
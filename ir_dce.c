@@ -0,0 +1,354 @@
+#include "ir_dce.h"
+#include <stdlib.h>
+#include <string.h>
+
+static void* dce_alloc(size_t size) {
+    void* ptr = calloc(1, size ? size : 1);
+    if (!ptr) {
+        perror("malloc failed for DCE");
+        exit(1);
+    }
+    return ptr;
+}
+
+static void add_note(IRDCEStats* stats, IRDeadKind kind, const IRFunction* function,
+                     const char* name, int line) {
+    if (stats->note_count == stats->note_capacity) {
+        int capacity = stats->note_capacity ? stats->note_capacity * 2 : 16;
+        IRDeadNote* notes = (IRDeadNote*)realloc(stats->notes, sizeof(IRDeadNote) * (size_t)capacity);
+        if (!notes) {
+            perror("malloc failed for IRDeadNote");
+            exit(1);
+        }
+        stats->notes = notes;
+        stats->note_capacity = capacity;
+    }
+    IRDeadNote* note = &stats->notes[stats->note_count++];
+    note->kind = kind;
+    note->function = function->name;
+    note->name = name;
+    note->line = line;
+}
+
+static int compare_notes(const void* a, const void* b) {
+    const IRDeadNote* x = (const IRDeadNote*)a;
+    const IRDeadNote* y = (const IRDeadNote*)b;
+    if (x->line != y->line) return x->line < y->line ? -1 : 1;
+    return (int)x->kind - (int)y->kind;
+}
+
+void ir_dce_stats_free(IRDCEStats* stats) {
+    if (!stats) return;
+    free(stats->notes);
+    stats->notes = NULL;
+    stats->note_count = 0;
+    stats->note_capacity = 0;
+}
+
+// ========== 局部栈槽的死存储 ==========
+
+// 位集合: 每个基本块一行, 每行words个64位字
+typedef struct BitRows {
+    uint64_t* bits;
+    int words;
+} BitRows;
+
+static inline uint64_t* row(const BitRows* rows, int index) {
+    return &rows->bits[(size_t)index * (size_t)rows->words];
+}
+
+static inline bool bit_test(const uint64_t* set, int i) {
+    return (set[i >> 6] >> (i & 63)) & 1;
+}
+
+static inline void bit_set(uint64_t* set, int i) {
+    set[i >> 6] |= (uint64_t)1 << (i & 63);
+}
+
+static inline void bit_clear(uint64_t* set, int i) {
+    set[i >> 6] &= ~((uint64_t)1 << (i & 63));
+}
+
+// 被跟踪的栈槽(只作为load/store的基址出现)上的访问, 其余返回-1
+static int tracked_slot(const IRFunction* function, const IRInstr* instr, const bool* tracked) {
+    if (instr->op != IR_LOAD && instr->op != IR_STORE) return -1;
+    IROperand base = function->operands[instr->args];
+    if (base.kind != IR_OPERAND_SLOT || !tracked[base.value]) return -1;
+    return base.value;
+}
+
+static bool is_scalar_store(const IRInstr* instr) {
+    return instr->op == IR_STORE && instr->arg_count == 2;
+}
+
+// 参数在入口处存入栈槽的那条store
+static bool is_param_spill(const IRFunction* function, const IRInstr* instr, int slot) {
+    const IROperand* args = &function->operands[instr->args];
+    return function->slots[slot].param >= 0 && args[1].kind == IR_OPERAND_VREG &&
+           args[1].value == function->slots[slot].param;
+}
+
+static int local_dead_stores(IRFunction* function, bool remove, IRDCEStats* stats) {
+    int slot_count = function->slot_count;
+    int block_count = function->block_count;
+    if (slot_count == 0) return 0;
+
+    // 取地址(或以其他方式出现)的栈槽可能经指针读取, 不跟踪
+    bool* tracked = (bool*)dce_alloc(sizeof(bool) * (size_t)slot_count);
+    int* load_count = (int*)dce_alloc(sizeof(int) * (size_t)slot_count);
+    for (int s = 0; s < slot_count; s++) tracked[s] = true;
+    for (int b = 0; b < block_count; b++) {
+        IRBlock* block = &function->blocks[b];
+        for (int i = 0; i < block->instr_count; i++) {
+            IRInstr* instr = &function->instrs[block->instrs[i]];
+            IROperand* args = ir_instr_args(function, instr);
+            for (int a = 0; a < instr->arg_count; a++) {
+                if (args[a].kind != IR_OPERAND_SLOT) continue;
+                if (a != 0 || (instr->op != IR_LOAD && instr->op != IR_STORE)) {
+                    tracked[args[a].value] = false;
+                } else if (instr->op == IR_LOAD) {
+                    load_count[args[a].value]++;
+                }
+            }
+        }
+    }
+
+    // 每个块向上暴露的读取(use)和整体覆盖的标量(def)
+    BitRows use = { NULL, (slot_count + 63) / 64 };
+    BitRows def = use, live_in = use, live_out = use;
+    size_t row_bytes = sizeof(uint64_t) * (size_t)use.words;
+    use.bits = (uint64_t*)dce_alloc(row_bytes * (size_t)block_count);
+    def.bits = (uint64_t*)dce_alloc(row_bytes * (size_t)block_count);
+    live_in.bits = (uint64_t*)dce_alloc(row_bytes * (size_t)block_count);
+    live_out.bits = (uint64_t*)dce_alloc(row_bytes * (size_t)block_count);
+
+    for (int b = 0; b < block_count; b++) {
+        IRBlock* block = &function->blocks[b];
+        for (int i = 0; i < block->instr_count; i++) {
+            IRInstr* instr = &function->instrs[block->instrs[i]];
+            int s = tracked_slot(function, instr, tracked);
+            if (s < 0) continue;
+            if (instr->op == IR_LOAD) {
+                if (!bit_test(row(&def, b), s)) bit_set(row(&use, b), s);
+            } else if (is_scalar_store(instr)) {
+                bit_set(row(&def, b), s);
+            }
+        }
+    }
+
+    // 逆向迭代到不动点; 降低顺序大致是拓扑序, 从后往前遍历收敛很快
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (int b = block_count - 1; b >= 0; b--) {
+            IRBlock* block = &function->blocks[b];
+            uint64_t* out = row(&live_out, b);
+            for (int s = 0; s < block->succ_count; s++) {
+                const uint64_t* succ_in = row(&live_in, block->succs[s]);
+                for (int w = 0; w < use.words; w++) out[w] |= succ_in[w];
+            }
+            uint64_t* in = row(&live_in, b);
+            const uint64_t* block_use = row(&use, b);
+            const uint64_t* block_def = row(&def, b);
+            for (int w = 0; w < use.words; w++) {
+                uint64_t value = block_use[w] | (out[w] & ~block_def[w]);
+                if (value != in[w]) {
+                    in[w] = value;
+                    changed = true;
+                }
+            }
+        }
+    }
+
+    // 从块尾逆向扫描, 写入时不活跃的栈槽上的store是死存储
+    int first_note = stats->note_count;
+    int removed = 0;
+    uint64_t* live = (uint64_t*)dce_alloc(row_bytes);
+    for (int b = 0; b < block_count; b++) {
+        IRBlock* block = &function->blocks[b];
+        memcpy(live, row(&live_out, b), row_bytes);
+        for (int i = block->instr_count - 1; i >= 0; i--) {
+            IRInstr* instr = &function->instrs[block->instrs[i]];
+            int s = tracked_slot(function, instr, tracked);
+            if (s < 0) continue;
+            if (instr->op == IR_LOAD) {
+                bit_set(live, s);
+                continue;
+            }
+            if (bit_test(live, s)) {
+                if (is_scalar_store(instr)) bit_clear(live, s);
+                continue;
+            }
+
+            const IRSlot* slot = &function->slots[s];
+            if (slot->name && load_count[s] > 0 && !is_param_spill(function, instr, s)) {
+                add_note(stats, IR_DEAD_STORE, function, slot->name, instr->line);
+            }
+            if (remove) instr->op = IR_NOP;
+            removed++;
+        }
+    }
+
+    // 没有任何读取的具名变量(不含参数)只报告一次未使用
+    for (int s = 0; s < slot_count; s++) {
+        const IRSlot* slot = &function->slots[s];
+        if (tracked[s] && slot->name && slot->param < 0 && load_count[s] == 0) {
+            add_note(stats, IR_DEAD_UNUSED_VAR, function, slot->name, slot->line);
+        }
+    }
+    if (stats->note_count > first_note) qsort(stats->notes + first_note, (size_t)(stats->note_count - first_note),
+                                              sizeof(IRDeadNote), compare_notes);
+
+    free(tracked);
+    free(load_count);
+    free(use.bits);
+    free(def.bits);
+    free(live_in.bits);
+    free(live_out.bits);
+    free(live);
+    return removed;
+}
+
+// ========== 全局标量的死存储 ==========
+
+// 块内被后面的store覆盖、中间没有读取该全局变量也没有调用和指针读取的store
+static int global_dead_stores(IRFunction* function) {
+    int global_count = 0;
+    for (int i = 0; i < function->operand_count; i++) {
+        const IROperand* operand = &function->operands[i];
+        if (operand->kind == IR_OPERAND_GLOBAL && operand->value >= global_count) {
+            global_count = operand->value + 1;
+        }
+    }
+    if (global_count == 0) return 0;
+
+    // overwritten[g] == stamp 表示g在块内稍后被整体覆盖; 换块或遇到调用时stamp加一
+    uint32_t* overwritten = (uint32_t*)dce_alloc(sizeof(uint32_t) * (size_t)global_count);
+    uint32_t stamp = 0;
+    int removed = 0;
+    for (int b = 0; b < function->block_count; b++) {
+        IRBlock* block = &function->blocks[b];
+        stamp++;
+        for (int i = block->instr_count - 1; i >= 0; i--) {
+            IRInstr* instr = &function->instrs[block->instrs[i]];
+            IROperand* args = ir_instr_args(function, instr);
+            switch (instr->op) {
+                case IR_CALL:
+                    stamp++;
+                    break;
+                case IR_LOAD:
+                case IR_ADDR:
+                    if (args[0].kind == IR_OPERAND_GLOBAL) {
+                        overwritten[args[0].value] = 0;
+                    } else if (args[0].kind == IR_OPERAND_VREG) {
+                        stamp++;
+                    }
+                    break;
+                case IR_STORE:
+                    if (args[0].kind != IR_OPERAND_GLOBAL || !is_scalar_store(instr)) break;
+                    if (overwritten[args[0].value] == stamp) {
+                        instr->op = IR_NOP;
+                        removed++;
+                    } else {
+                        overwritten[args[0].value] = stamp;
+                    }
+                    break;
+                default:
+                    break;
+            }
+        }
+    }
+    free(overwritten);
+    return removed;
+}
+
+void ir_function_dse(IRFunction* function, bool remove, IRDCEStats* stats) {
+    if (!function->is_defined || function->block_count == 0 || function->is_ssa) return;
+
+    IRDCEStats local;
+    memset(&local, 0, sizeof(local));
+    IRDCEStats* target = stats ? stats : &local;
+
+    int removed = local_dead_stores(function, remove, target);
+    if (remove) {
+        removed += global_dead_stores(function);
+        if (removed > 0) ir_function_compact(function);
+        target->removed_stores += removed;
+    }
+    ir_dce_stats_free(&local);
+}
+
+void ir_module_dse(IRModule* module, bool remove, IRDCEStats* stats) {
+    for (int i = 0; i < module->function_count; i++) {
+        ir_function_dse(&module->functions[i], remove, stats);
+    }
+}
+
+// ========== 标记-清除 ==========
+
+static bool is_root(IROpcode op) {
+    return op == IR_STORE || op == IR_VSTORE || op == IR_COUNT || op == IR_CALL || ir_opcode_is_terminator(op);
+}
+
+void ir_function_dce(IRFunction* function, IRDCEStats* stats) {
+    if (!function->is_defined || function->block_count == 0) return;
+
+    int* def_instr = (int*)dce_alloc(sizeof(int) * (size_t)(function->vreg_count + 1));
+    bool* marked = (bool*)dce_alloc(sizeof(bool) * (size_t)function->instr_count);
+    int* worklist = (int*)dce_alloc(sizeof(int) * (size_t)(function->instr_count + 1));
+    int top = 0;
+
+    memset(def_instr, -1, sizeof(int) * (size_t)(function->vreg_count + 1));
+    for (int b = 0; b < function->block_count; b++) {
+        IRBlock* block = &function->blocks[b];
+        for (int i = 0; i < block->instr_count; i++) {
+            int id = block->instrs[i];
+            IRInstr* instr = &function->instrs[id];
+            if (instr->op == IR_NOP) continue;
+            if (instr->dest >= 0) def_instr[instr->dest] = id;
+            if (is_root((IROpcode)instr->op)) {
+                marked[id] = true;
+                worklist[top++] = id;
+            }
+        }
+    }
+
+    // 活跃指令使用的值的定义也是活跃的(参数没有定义指令)
+    while (top > 0) {
+        IRInstr* instr = &function->instrs[worklist[--top]];
+        IROperand* args = ir_instr_args(function, instr);
+        for (int a = 0; a < instr->arg_count; a++) {
+            if (args[a].kind != IR_OPERAND_VREG) continue;
+            int def = def_instr[args[a].value];
+            if (def >= 0 && !marked[def]) {
+                marked[def] = true;
+                worklist[top++] = def;
+            }
+        }
+    }
+
+    int removed = 0;
+    for (int b = 0; b < function->block_count; b++) {
+        IRBlock* block = &function->blocks[b];
+        for (int i = 0; i < block->instr_count; i++) {
+            int id = block->instrs[i];
+            IRInstr* instr = &function->instrs[id];
+            if (instr->op != IR_NOP && !marked[id]) {
+                instr->op = IR_NOP;
+                removed++;
+            }
+        }
+    }
+    if (removed > 0) ir_function_compact(function);
+    if (stats) stats->removed_instrs += removed;
+
+    free(def_instr);
+    free(marked);
+    free(worklist);
+}
+
+void ir_module_dce(IRModule* module, IRDCEStats* stats) {
+    for (int i = 0; i < module->function_count; i++) {
+        ir_function_dce(&module->functions[i], stats);
+    }
+}
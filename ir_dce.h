@@ -0,0 +1,49 @@
+#ifndef IR_DCE_H
+#define IR_DCE_H
+
+#include "ir.h"
+
+// ========== 死代码与死存储删除 ==========
+//
+// 死存储分析(SSA构造之前): 对不取地址的局部栈槽做逆向活跃分析,
+// 写入后在任何路径上都不会再被读取的store是死存储。分析结果记为:
+//   - 从未被读取的具名变量 → 未使用变量
+//   - 其余具名变量上被覆盖或不再读取的赋值 → 无用赋值
+// 同时删除基本块内被后续store覆盖(中间没有读取和调用)的全局标量store。
+//
+// 死代码删除(SSA形式): 标记-清除。store、count、call和终结指令是根,
+// 从根出发沿操作数标记定义它们的指令, 未被标记的计算(包括只互相使用的phi环)被删除。
+
+typedef enum {
+    IR_DEAD_UNUSED_VAR,     // 变量从未被读取
+    IR_DEAD_STORE           // 赋给变量的值从未被读取
+} IRDeadKind;
+
+typedef struct IRDeadNote {
+    uint8_t kind;           // IRDeadKind
+    const char* function;   // 所在函数
+    const char* name;       // 变量名
+    int line;               // 变量声明或赋值的行号
+} IRDeadNote;
+
+typedef struct IRDCEStats {
+    int removed_instrs;     // 标记-清除删除的指令数
+    int removed_stores;     // 删除的死存储数
+
+    // 死存储分析的结果, 按函数和行号排列; 由ir_dce_stats_free释放
+    IRDeadNote* notes;
+    int note_count;
+    int note_capacity;
+} IRDCEStats;
+
+// 对SSA构造之前的函数做死存储分析; remove为false时只记录结果, 不修改IR
+void ir_function_dse(IRFunction* function, bool remove, IRDCEStats* stats);
+void ir_module_dse(IRModule* module, bool remove, IRDCEStats* stats);
+
+// 对SSA形式的函数做标记-清除死代码删除
+void ir_function_dce(IRFunction* function, IRDCEStats* stats);
+void ir_module_dce(IRModule* module, IRDCEStats* stats);
+
+void ir_dce_stats_free(IRDCEStats* stats);
+
+#endif // IR_DCE_H
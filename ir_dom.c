@@ -0,0 +1,233 @@
+#include "ir_dom.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static int* int_array(int count, int fill) {
+    int* array = (int*)malloc(sizeof(int) * (count > 0 ? count : 1));
+    if (!array) {
+        perror("malloc failed for IRDomTree");
+        exit(1);
+    }
+    for (int i = 0; i < count; i++) {
+        array[i] = fill;
+    }
+    return array;
+}
+
+// 从入口做非递归深度优先搜索, 得到可达块的逆后序
+static void compute_rpo(IRDomTree* tree, const IRFunction* function) {
+    int n = function->block_count;
+    int* stack = int_array(n, 0);
+    int* next_succ = int_array(n, 0);
+    int* postorder = int_array(n, 0);
+    bool* visited = (bool*)calloc(n > 0 ? n : 1, sizeof(bool));
+    if (!visited) {
+        perror("calloc failed for IRDomTree");
+        exit(1);
+    }
+
+    int depth = 0;
+    int post_count = 0;
+    if (n > 0) {
+        stack[depth++] = 0;
+        visited[0] = true;
+    }
+    while (depth > 0) {
+        int block = stack[depth - 1];
+        const IRBlock* b = &function->blocks[block];
+        if (next_succ[block] < b->succ_count) {
+            int succ = b->succs[next_succ[block]++];
+            if (!visited[succ]) {
+                visited[succ] = true;
+                stack[depth++] = succ;
+            }
+        } else {
+            postorder[post_count++] = block;
+            depth--;
+        }
+    }
+
+    tree->rpo_count = post_count;
+    for (int i = 0; i < post_count; i++) {
+        int block = postorder[post_count - 1 - i];
+        tree->rpo[i] = block;
+        tree->rpo_index[block] = i;
+    }
+
+    free(stack);
+    free(next_succ);
+    free(postorder);
+    free(visited);
+}
+
+static int intersect(const IRDomTree* tree, int a, int b) {
+    while (a != b) {
+        while (tree->rpo_index[a] > tree->rpo_index[b]) a = tree->idom[a];
+        while (tree->rpo_index[b] > tree->rpo_index[a]) b = tree->idom[b];
+    }
+    return a;
+}
+
+static void compute_idom(IRDomTree* tree, const IRFunction* function) {
+    if (tree->rpo_count == 0) return;
+    tree->idom[tree->rpo[0]] = tree->rpo[0];
+
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (int i = 1; i < tree->rpo_count; i++) {
+            int block = tree->rpo[i];
+            const IRBlock* b = &function->blocks[block];
+
+            int new_idom = -1;
+            for (int p = 0; p < b->pred_count; p++) {
+                int pred = b->preds[p];
+                if (tree->idom[pred] < 0) continue;   // 不可达或还没处理过
+                new_idom = new_idom < 0 ? pred : intersect(tree, pred, new_idom);
+            }
+            if (new_idom != tree->idom[block]) {
+                tree->idom[block] = new_idom;
+                changed = true;
+            }
+        }
+    }
+}
+
+// 按逆后序把每个块挂到直接支配者下面, 并计算先序/后序编号
+static void build_children(IRDomTree* tree) {
+    int n = tree->block_count;
+    for (int i = 1; i < tree->rpo_count; i++) {
+        tree->child_start[tree->idom[tree->rpo[i]] + 1]++;
+    }
+    for (int b = 0; b < n; b++) {
+        tree->child_start[b + 1] += tree->child_start[b];
+    }
+
+    int* fill = int_array(n, 0);
+    for (int i = 1; i < tree->rpo_count; i++) {
+        int block = tree->rpo[i];
+        int parent = tree->idom[block];
+        tree->children[tree->child_start[parent] + fill[parent]++] = block;
+    }
+    free(fill);
+
+    if (tree->rpo_count == 0) return;
+
+    int* stack = int_array(n, 0);
+    int* next_child = int_array(n, 0);
+    int depth = 0;
+    int counter = 0;
+    stack[depth++] = tree->rpo[0];
+    tree->pre[tree->rpo[0]] = counter++;
+    while (depth > 0) {
+        int block = stack[depth - 1];
+        int index = tree->child_start[block] + next_child[block];
+        if (index < tree->child_start[block + 1]) {
+            int child = tree->children[index];
+            next_child[block]++;
+            tree->pre[child] = counter++;
+            stack[depth++] = child;
+        } else {
+            tree->post[block] = counter++;
+            depth--;
+        }
+    }
+    free(stack);
+    free(next_child);
+}
+
+IRDomTree* ir_dom_tree_create(const IRFunction* function) {
+    IRDomTree* tree = (IRDomTree*)malloc(sizeof(IRDomTree));
+    if (!tree) {
+        perror("malloc failed for IRDomTree");
+        exit(1);
+    }
+
+    int n = function->block_count;
+    tree->block_count = n;
+    tree->idom = int_array(n, -1);
+    tree->rpo = int_array(n, -1);
+    tree->rpo_count = 0;
+    tree->rpo_index = int_array(n, -1);
+    tree->children = int_array(n, -1);
+    tree->child_start = int_array(n + 1, 0);
+    tree->pre = int_array(n, -1);
+    tree->post = int_array(n, -1);
+    tree->frontier = NULL;
+    tree->frontier_start = NULL;
+
+    compute_rpo(tree, function);
+    compute_idom(tree, function);
+    build_children(tree);
+    return tree;
+}
+
+void ir_dom_tree_destroy(IRDomTree* tree) {
+    if (!tree) return;
+
+    free(tree->idom);
+    free(tree->rpo);
+    free(tree->rpo_index);
+    free(tree->children);
+    free(tree->child_start);
+    free(tree->pre);
+    free(tree->post);
+    free(tree->frontier);
+    free(tree->frontier_start);
+    free(tree);
+}
+
+// 汇合点b属于从前驱沿支配树向上、到idom(b)之前经过的每个块的支配边界。
+// fill为NULL时只计数
+static void walk_frontiers(IRDomTree* tree, const IRFunction* function, int* last, int* fill) {
+    for (int i = 0; i < tree->rpo_count; i++) {
+        int block = tree->rpo[i];
+        const IRBlock* b = &function->blocks[block];
+        if (b->pred_count < 2) continue;
+
+        for (int p = 0; p < b->pred_count; p++) {
+            int runner = b->preds[p];
+            if (tree->idom[runner] < 0) continue;
+
+            while (runner != tree->idom[block]) {
+                if (last[runner] == block) break;   // 这条支配链已经走过
+                last[runner] = block;
+                if (fill) {
+                    tree->frontier[tree->frontier_start[runner] + fill[runner]++] = block;
+                } else {
+                    tree->frontier_start[runner + 1]++;
+                }
+                runner = tree->idom[runner];
+            }
+        }
+    }
+}
+
+void ir_dom_compute_frontiers(IRDomTree* tree, const IRFunction* function) {
+    int n = tree->block_count;
+    free(tree->frontier);
+    free(tree->frontier_start);
+    tree->frontier_start = int_array(n + 1, 0);
+
+    int* last = int_array(n, -1);
+    walk_frontiers(tree, function, last, NULL);
+    for (int b = 0; b < n; b++) {
+        tree->frontier_start[b + 1] += tree->frontier_start[b];
+    }
+    tree->frontier = int_array(tree->frontier_start[n], -1);
+
+    int* fill = int_array(n, 0);
+    for (int b = 0; b < n; b++) {
+        last[b] = -1;
+    }
+    walk_frontiers(tree, function, last, fill);
+
+    free(fill);
+    free(last);
+}
+
+bool ir_dom_dominates(const IRDomTree* tree, int a, int b) {
+    if (tree->idom[a] < 0 || tree->idom[b] < 0) return false;
+    return tree->pre[a] <= tree->pre[b] && tree->post[b] <= tree->post[a];
+}
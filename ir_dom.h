@@ -0,0 +1,45 @@
+#ifndef IR_DOM_H
+#define IR_DOM_H
+
+#include "ir.h"
+#include <stdbool.h>
+
+// ========== 支配树 ==========
+//
+// 用 Cooper-Harvey-Kennedy 迭代算法在逆后序上计算直接支配者,
+// 再按需计算支配边界。从入口不可达的基本块不在支配树中(idom为-1)。
+
+typedef struct IRDomTree {
+    int block_count;
+    int* idom;          // 直接支配者, 入口为自身, 不可达块为-1
+    int* rpo;           // 可达基本块的逆后序
+    int rpo_count;
+    int* rpo_index;     // 基本块在rpo中的位置, 不可达块为-1
+
+    // 支配树的孩子, 以 child_start[b] .. child_start[b+1] 为下标存放在children中
+    int* children;
+    int* child_start;
+
+    // 支配树先序/后序编号, 用于O(1)判断支配关系
+    int* pre;
+    int* post;
+
+    // 支配边界(ir_dom_compute_frontiers之后有效), 存放方式与children相同
+    int* frontier;
+    int* frontier_start;
+} IRDomTree;
+
+// 根据函数当前的控制流图(ir_function_compute_cfg)构造支配树
+IRDomTree* ir_dom_tree_create(const IRFunction* function);
+void ir_dom_tree_destroy(IRDomTree* tree);
+
+void ir_dom_compute_frontiers(IRDomTree* tree, const IRFunction* function);
+
+// a是否支配b(每个块支配自身); 任一块不可达时返回false
+bool ir_dom_dominates(const IRDomTree* tree, int a, int b);
+
+static inline bool ir_dom_reachable(const IRDomTree* tree, int block) {
+    return tree->idom[block] >= 0;
+}
+
+#endif // IR_DOM_H
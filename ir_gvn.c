@@ -0,0 +1,232 @@
+#include "ir_gvn.h"
+#include "ir_dom.h"
+#include <stdlib.h>
+#include <string.h>
+
+// ========== 表达式散列表 ==========
+
+// 开放寻址(线性探测), 表项是指令编号。表项只按插入的相反顺序删除,
+// 此时直接清空槽位不会打断其余表项的探测链
+typedef struct ExprTable {
+    int* slots;         // -1表示空
+    int mask;
+    IRFunction* function;
+} ExprTable;
+
+static uint32_t hash_instr(const IRFunction* function, const IRInstr* instr) {
+    const IROperand* args = &function->operands[instr->args];
+    uint32_t hash = 2166136261u;
+    hash = (hash ^ instr->op) * 16777619u;
+    hash = (hash ^ instr->type) * 16777619u;
+    if (instr->op == IR_PHI) {
+        hash = (hash ^ (uint32_t)instr->block) * 16777619u;
+    }
+    for (int a = 0; a < instr->arg_count; a++) {
+        hash = (hash ^ args[a].kind) * 16777619u;
+        hash = (hash ^ (uint32_t)args[a].value) * 16777619u;
+    }
+    return hash;
+}
+
+static bool same_expr(const IRFunction* function, const IRInstr* a, const IRInstr* b) {
+    if (a->op != b->op || a->type != b->type || a->arg_count != b->arg_count) return false;
+    if (a->op == IR_PHI && a->block != b->block) return false;
+
+    const IROperand* args_a = &function->operands[a->args];
+    const IROperand* args_b = &function->operands[b->args];
+    for (int i = 0; i < a->arg_count; i++) {
+        if (args_a[i].kind != args_b[i].kind || args_a[i].value != args_b[i].value) return false;
+    }
+    return true;
+}
+
+// 查找与id相同的表达式; 没有时插入id并返回-1
+static int table_find_or_insert(ExprTable* table, int id, int* inserted_slot) {
+    IRFunction* function = table->function;
+    const IRInstr* instr = &function->instrs[id];
+    int slot = (int)(hash_instr(function, instr) & (uint32_t)table->mask);
+
+    while (table->slots[slot] >= 0) {
+        int existing = table->slots[slot];
+        if (same_expr(function, &function->instrs[existing], instr)) {
+            *inserted_slot = -1;
+            return existing;
+        }
+        slot = (slot + 1) & table->mask;
+    }
+    table->slots[slot] = id;
+    *inserted_slot = slot;
+    return -1;
+}
+
+// ========== 规范化 ==========
+
+static bool operand_less(IROperand a, IROperand b) {
+    if (a.kind != b.kind) return a.kind < b.kind;
+    return a.value < b.value;
+}
+
+static bool is_pure(IROpcode op) {
+    switch (op) {
+        case IR_ADD: case IR_SUB: case IR_MUL: case IR_DIV: case IR_MOD: case IR_NEG:
+        case IR_SHL: case IR_SHR: case IR_AND:
+        case IR_EQ: case IR_NE: case IR_LT: case IR_LE: case IR_GT: case IR_GE:
+        case IR_NOT: case IR_ZEXT: case IR_ADDR: case IR_PHI:
+            return true;
+        default:
+            return false;
+    }
+}
+
+static void canonicalize(IRFunction* function, IRInstr* instr) {
+    IROperand* args = ir_instr_args(function, instr);
+
+    if (instr->op == IR_GT || instr->op == IR_GE) {
+        // a > b 即 b < a
+        IROperand tmp = args[0];
+        args[0] = args[1];
+        args[1] = tmp;
+        instr->op = instr->op == IR_GT ? IR_LT : IR_LE;
+    }
+
+    bool commutative = instr->op == IR_ADD || instr->op == IR_MUL || instr->op == IR_AND ||
+                       instr->op == IR_EQ || instr->op == IR_NE;
+    if (commutative && operand_less(args[1], args[0])) {
+        IROperand tmp = args[0];
+        args[0] = args[1];
+        args[1] = tmp;
+    }
+}
+
+// ========== 遍历 ==========
+
+typedef struct GVN {
+    IRFunction* function;
+    ExprTable table;
+    IROperand* map;         // 被删除指令的结果 → 复用的值
+
+    int* undo;              // 按插入顺序记录的表槽位
+    int undo_count;
+    int removed;
+} GVN;
+
+static IROperand resolve(const GVN* gvn, IROperand operand) {
+    while (operand.kind == IR_OPERAND_VREG && gvn->map[operand.value].kind != IR_OPERAND_NONE) {
+        operand = gvn->map[operand.value];
+    }
+    return operand;
+}
+
+static void number_block(GVN* gvn, int b) {
+    IRFunction* function = gvn->function;
+    IRBlock* block = &function->blocks[b];
+
+    for (int i = 0; i < block->instr_count; i++) {
+        int id = block->instrs[i];
+        IRInstr* instr = &function->instrs[id];
+        IROperand* args = ir_instr_args(function, instr);
+
+        // phi的输入可能来自还没访问的前驱(回边), 只解析已知的替换
+        for (int a = 0; a < instr->arg_count; a++) {
+            args[a] = resolve(gvn, args[a]);
+        }
+
+        if (instr->op == IR_COPY) {
+            gvn->map[instr->dest] = args[0];
+            instr->op = IR_NOP;
+            gvn->removed++;
+            continue;
+        }
+        if (instr->dest < 0 || !is_pure((IROpcode)instr->op)) continue;
+
+        canonicalize(function, instr);
+        int inserted = -1;
+        int existing = table_find_or_insert(&gvn->table, id, &inserted);
+        if (existing >= 0) {
+            gvn->map[instr->dest] = ir_operand_vreg(function->instrs[existing].dest, (IRType)instr->type);
+            instr->op = IR_NOP;
+            gvn->removed++;
+        } else {
+            gvn->undo[gvn->undo_count++] = inserted;
+        }
+    }
+}
+
+void ir_function_gvn(IRFunction* function, IRGVNStats* stats) {
+    if (!function->is_defined || function->block_count == 0) return;
+
+    GVN gvn;
+    memset(&gvn, 0, sizeof(gvn));
+    gvn.function = function;
+
+    int capacity = 16;
+    while (capacity < function->instr_count * 2) capacity *= 2;
+    gvn.table.function = function;
+    gvn.table.mask = capacity - 1;
+    gvn.table.slots = (int*)malloc(sizeof(int) * (size_t)capacity);
+    gvn.undo = (int*)malloc(sizeof(int) * (size_t)(function->instr_count + 1));
+    gvn.map = (IROperand*)calloc((size_t)function->vreg_count + 1, sizeof(IROperand));
+    if (!gvn.table.slots || !gvn.undo || !gvn.map) {
+        perror("malloc failed for GVN");
+        exit(1);
+    }
+    memset(gvn.table.slots, -1, sizeof(int) * (size_t)capacity);
+
+    // 非递归地先序遍历支配树, 离开子树时删除它加入的表项
+    IRDomTree* dom = ir_dom_tree_create(function);
+    int n = function->block_count;
+    int* stack = (int*)malloc(sizeof(int) * (size_t)n);
+    int* next_child = (int*)calloc((size_t)n, sizeof(int));
+    int* undo_mark = (int*)malloc(sizeof(int) * (size_t)n);
+    if (!stack || !next_child || !undo_mark) {
+        perror("malloc failed for GVN");
+        exit(1);
+    }
+
+    int depth = 0;
+    if (dom->rpo_count > 0) {
+        int entry = dom->rpo[0];
+        undo_mark[entry] = 0;
+        number_block(&gvn, entry);
+        stack[depth++] = entry;
+    }
+    while (depth > 0) {
+        int block = stack[depth - 1];
+        int index = dom->child_start[block] + next_child[block];
+        if (index < dom->child_start[block + 1]) {
+            int child = dom->children[index];
+            next_child[block]++;
+            undo_mark[child] = gvn.undo_count;
+            number_block(&gvn, child);
+            stack[depth++] = child;
+        } else {
+            while (gvn.undo_count > undo_mark[block]) {
+                gvn.table.slots[gvn.undo[--gvn.undo_count]] = -1;
+            }
+            depth--;
+        }
+    }
+
+    // 回边上的phi输入在遍历时还没有被替换
+    if (gvn.removed > 0) {
+        ir_function_replace_uses(function, gvn.map);
+        ir_function_compact(function);
+    }
+    if (stats) {
+        stats->removed_instrs += gvn.removed;
+    }
+
+    ir_dom_tree_destroy(dom);
+    free(stack);
+    free(next_child);
+    free(undo_mark);
+    free(gvn.table.slots);
+    free(gvn.undo);
+    free(gvn.map);
+}
+
+void ir_module_gvn(IRModule* module, IRGVNStats* stats) {
+    for (int i = 0; i < module->function_count; i++) {
+        ir_function_gvn(&module->functions[i], stats);
+    }
+}
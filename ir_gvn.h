@@ -0,0 +1,20 @@
+#ifndef IR_GVN_H
+#define IR_GVN_H
+
+#include "ir.h"
+
+// ========== 全局值编号(GVN) ==========
+//
+// 按支配树先序遍历SSA形式的函数, 用散列表记录每个纯计算(算术、比较、取地址、phi)
+// 第一次出现的结果; 被支配的块中相同的计算直接复用它, 离开子树时撤销该子树加入的表项。
+// 比较前先规范化操作数: add/mul/and/eq/ne 交换律按操作数排序, gt/ge 改写为交换操作数的 lt/le。
+// load和call可能读到不同的内存状态, 不参与编号。
+
+typedef struct IRGVNStats {
+    int removed_instrs;     // 被已有值替换而删除的指令数
+} IRGVNStats;
+
+void ir_function_gvn(IRFunction* function, IRGVNStats* stats);
+void ir_module_gvn(IRModule* module, IRGVNStats* stats);
+
+#endif // IR_GVN_H
@@ -0,0 +1,411 @@
+#include "ir_inline.h"
+#include "ir_sccp.h"
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct Inliner {
+    IRModule* module;
+    IRInlineStats* stats;
+
+    // 调用图(CSR): 函数f调用的已定义函数为 callees[edge_start[f] .. edge_start[f+1])
+    int* edge_start;
+    int* callees;
+    int* scc;               // 函数 → 强连通分量编号
+    int* order;             // 按强连通分量完成的顺序(被调用者在前)排列的函数
+    int order_count;
+    int* call_count;        // 函数 → 模块中调用它的调用点数
+} Inliner;
+
+static void* inline_alloc(size_t size) {
+    void* ptr = calloc(1, size ? size : 1);
+    if (!ptr) {
+        perror("malloc failed for inliner");
+        exit(1);
+    }
+    return ptr;
+}
+
+static bool is_call_to_defined(const IRModule* module, const IRFunction* function, const IRInstr* instr) {
+    if (instr->op != IR_CALL) return false;
+    const IRFunction* callee = &module->functions[function->operands[instr->args].value];
+    return callee->is_defined && callee->block_count > 0;
+}
+
+static int function_size(const IRFunction* function) {
+    int size = 0;
+    for (int b = 0; b < function->block_count; b++) {
+        const IRBlock* block = &function->blocks[b];
+        for (int i = 0; i < block->instr_count; i++) {
+            if (function->instrs[block->instrs[i]].op != IR_NOP) size++;
+        }
+    }
+    return size;
+}
+
+// ========== 调用图与强连通分量 ==========
+
+static void build_call_graph(Inliner* in) {
+    const IRModule* module = in->module;
+    int n = module->function_count;
+    in->edge_start = (int*)inline_alloc(sizeof(int) * (size_t)(n + 1));
+    in->call_count = (int*)inline_alloc(sizeof(int) * (size_t)n);
+
+    // 第一遍计数, 第二遍填写
+    for (int pass = 0; pass < 2; pass++) {
+        int edges = 0;
+        for (int f = 0; f < n; f++) {
+            const IRFunction* function = &module->functions[f];
+            in->edge_start[f] = edges;
+            for (int b = 0; b < function->block_count; b++) {
+                const IRBlock* block = &function->blocks[b];
+                for (int i = 0; i < block->instr_count; i++) {
+                    const IRInstr* instr = &function->instrs[block->instrs[i]];
+                    if (!is_call_to_defined(module, function, instr)) continue;
+                    int callee = function->operands[instr->args].value;
+                    if (pass == 1) {
+                        in->callees[edges] = callee;
+                        in->call_count[callee]++;
+                    }
+                    edges++;
+                }
+            }
+        }
+        in->edge_start[n] = edges;
+        if (pass == 0) in->callees = (int*)inline_alloc(sizeof(int) * (size_t)edges);
+    }
+}
+
+// Tarjan算法(显式栈); 强连通分量按完成顺序编号, 即被调用者的分量先于调用者
+static void find_sccs(Inliner* in) {
+    int n = in->module->function_count;
+    int* index = (int*)inline_alloc(sizeof(int) * (size_t)n);
+    int* low = (int*)inline_alloc(sizeof(int) * (size_t)n);
+    bool* on_stack = (bool*)inline_alloc(sizeof(bool) * (size_t)n);
+    int* stack = (int*)inline_alloc(sizeof(int) * (size_t)n);
+    int* frame_node = (int*)inline_alloc(sizeof(int) * (size_t)n);
+    int* frame_edge = (int*)inline_alloc(sizeof(int) * (size_t)n);
+    in->scc = (int*)inline_alloc(sizeof(int) * (size_t)n);
+    in->order = (int*)inline_alloc(sizeof(int) * (size_t)n);
+    for (int f = 0; f < n; f++) index[f] = -1;
+
+    int counter = 0, depth = 0, scc_count = 0;
+    for (int root = 0; root < n; root++) {
+        if (index[root] >= 0) continue;
+        int frames = 0;
+        frame_node[frames] = root;
+        frame_edge[frames++] = in->edge_start[root];
+        index[root] = low[root] = counter++;
+        stack[depth++] = root;
+        on_stack[root] = true;
+
+        while (frames > 0) {
+            int v = frame_node[frames - 1];
+            if (frame_edge[frames - 1] < in->edge_start[v + 1]) {
+                int w = in->callees[frame_edge[frames - 1]++];
+                if (index[w] < 0) {
+                    index[w] = low[w] = counter++;
+                    stack[depth++] = w;
+                    on_stack[w] = true;
+                    frame_node[frames] = w;
+                    frame_edge[frames++] = in->edge_start[w];
+                } else if (on_stack[w] && index[w] < low[v]) {
+                    low[v] = index[w];
+                }
+                continue;
+            }
+
+            if (low[v] == index[v]) {
+                int w;
+                do {
+                    w = stack[--depth];
+                    on_stack[w] = false;
+                    in->scc[w] = scc_count;
+                    in->order[in->order_count++] = w;
+                } while (w != v);
+                scc_count++;
+            }
+            frames--;
+            if (frames > 0) {
+                int parent = frame_node[frames - 1];
+                if (low[v] < low[parent]) low[parent] = low[v];
+            }
+        }
+    }
+
+    free(frame_edge);
+    free(frame_node);
+    free(stack);
+    free(on_stack);
+    free(low);
+    free(index);
+}
+
+// ========== 代价模型 ==========
+
+static bool should_inline(const Inliner* in, const IRFunction* caller, const IRInstr* call, int callee_index,
+                          int budget) {
+    const IRFunction* callee = &in->module->functions[callee_index];
+    int frame = 0;
+    for (int s = 0; s < callee->slot_count; s++) {
+        if (!callee->slots[s].promoted) frame += callee->slots[s].count;
+    }
+    if (frame > IR_INLINE_FRAME_LIMIT) return false;
+
+    int size = function_size(callee);
+    if (function_size(caller) + size > IR_INLINE_CALLER_LIMIT) return false;
+
+    const IROperand* args = &caller->operands[call->args];
+    int benefit = call->arg_count + (call->dest >= 0 ? 1 : 0);
+    for (int a = 1; a < call->arg_count; a++) {
+        if (args[a].kind == IR_OPERAND_CONST) benefit += IR_INLINE_CONST_ARG_BONUS;
+    }
+    if (size - benefit <= budget) return true;
+    return in->call_count[callee_index] == 1 && size <= IR_INLINE_SINGLE_SITE_LIMIT;
+}
+
+// ========== 内联一个调用点 ==========
+
+static void append_instr(IRFunction* function, int block, int id) {
+    IRBlock* target = &function->blocks[block];
+    ARENA_RESERVE(function->arena, target->instrs, target->instr_count, target->instr_capacity);
+    target->instrs[target->instr_count++] = id;
+    function->instrs[id].block = block;
+}
+
+// 把target块中phi来自from的输入改为来自to
+static void retarget_phis(IRFunction* function, int target, int from, int to) {
+    IRBlock* block = &function->blocks[target];
+    for (int i = 0; i < block->instr_count; i++) {
+        IRInstr* phi = &function->instrs[block->instrs[i]];
+        if (phi->op != IR_PHI) break;
+        IROperand* inputs = ir_instr_args(function, phi);
+        for (int a = 0; a < phi->arg_count; a += 2) {
+            if (inputs[a].value == from) inputs[a].value = to;
+        }
+    }
+}
+
+static void inline_call(IRFunction* function, int call_id, const IRFunction* callee) {
+    const IRInstr* call = &function->instrs[call_id];
+    int block = call->block;
+    int dest = call->dest;
+    IRType type = (IRType)call->type;
+    int line = call->line;
+    int argc = call->arg_count - 1;
+    IROperand* actuals = (IROperand*)inline_alloc(sizeof(IROperand) * (size_t)(argc > 0 ? argc : 1));
+    memcpy(actuals, &function->operands[call->args + 1], sizeof(IROperand) * (size_t)argc);
+
+    // 调用之后的指令(连同终结指令)移到新的后半块, 后继中phi的输入随之改为来自后半块
+    int position = 0;
+    while (function->blocks[block].instrs[position] != call_id) position++;
+    int cont = ir_new_block(function);
+    int64_t site_count = function->blocks[block].count;
+    function->blocks[cont].count = site_count;
+    for (int i = position + 1; i < function->blocks[block].instr_count; i++) {
+        append_instr(function, cont, function->blocks[block].instrs[i]);
+    }
+    function->blocks[block].instr_count = position;
+    function->instrs[call_id].op = IR_NOP;
+    const IRInstr* term = ir_block_terminator(function, cont);
+    if (term && term->op != IR_RET) {
+        const IROperand* targets = ir_instr_args(function, term);
+        for (int t = term->op == IR_BR ? 1 : 0; t < term->arg_count; t++) {
+            retarget_phis(function, targets[t].value, block, cont);
+        }
+    }
+
+    // 被调用者的块、虚拟寄存器和栈槽在调用者中的对应; 形参直接换成实参
+    int* block_map = (int*)inline_alloc(sizeof(int) * (size_t)callee->block_count);
+    for (int b = 0; b < callee->block_count; b++) {
+        block_map[b] = callee->blocks[b].instr_count > 0 ? ir_new_block(function) : -1;
+    }
+    // profile计数按这个调用点占被调用者全部调用的比例折算
+    int64_t entry_count = callee->blocks[0].count;
+    for (int b = 0; b < callee->block_count && site_count >= 0 && entry_count > 0; b++) {
+        int64_t count = callee->blocks[b].count;
+        if (block_map[b] < 0 || count < 0) continue;
+        function->blocks[block_map[b]].count = (int64_t)((double)count * (double)site_count / (double)entry_count);
+    }
+    IROperand* value_map = (IROperand*)inline_alloc(sizeof(IROperand) * (size_t)(callee->vreg_count + 1));
+    for (int p = 0; p < callee->param_count && p < argc; p++) value_map[p] = actuals[p];
+    for (int b = 0; b < callee->block_count; b++) {
+        const IRBlock* source = &callee->blocks[b];
+        for (int i = 0; i < source->instr_count; i++) {
+            const IRInstr* instr = &callee->instrs[source->instrs[i]];
+            if (instr->dest < 0 || instr->op == IR_NOP) continue;
+            IRType vreg_type = (IRType)callee->vreg_types[instr->dest];
+            value_map[instr->dest] = ir_operand_vreg(ir_new_vreg(function, vreg_type), vreg_type);
+        }
+    }
+    int* slot_map = (int*)inline_alloc(sizeof(int) * (size_t)(callee->slot_count + 1));
+    for (int s = 0; s < callee->slot_count; s++) {
+        const IRSlot* slot = &callee->slots[s];
+        slot_map[s] = ir_new_slot(function, slot->name, (IRType)slot->type, slot->count, -1);
+        function->slots[slot_map[s]].line = slot->line;
+        function->slots[slot_map[s]].promoted = slot->promoted;
+    }
+
+    // 复制指令, ret改为跳到后半块并记下返回值
+    int* ret_block = (int*)inline_alloc(sizeof(int) * (size_t)callee->block_count);
+    IROperand* ret_value = (IROperand*)inline_alloc(sizeof(IROperand) * (size_t)callee->block_count);
+    int ret_count = 0;
+    IROperand* mapped = NULL;
+    int mapped_capacity = 0;
+    for (int b = 0; b < callee->block_count; b++) {
+        const IRBlock* source = &callee->blocks[b];
+        int target = block_map[b];
+        for (int i = 0; i < source->instr_count; i++) {
+            const IRInstr* instr = &callee->instrs[source->instrs[i]];
+            if (instr->op == IR_NOP) continue;
+            if (instr->arg_count > mapped_capacity) {
+                mapped_capacity = instr->arg_count * 2;
+                free(mapped);
+                mapped = (IROperand*)inline_alloc(sizeof(IROperand) * (size_t)mapped_capacity);
+            }
+
+            const IROperand* args = &callee->operands[instr->args];
+            int count = 0;
+            for (int a = 0; a < instr->arg_count; a++) {
+                IROperand operand = args[a];
+                switch (operand.kind) {
+                    case IR_OPERAND_VREG: operand = value_map[operand.value]; break;
+                    case IR_OPERAND_SLOT: operand.value = slot_map[operand.value]; break;
+                    case IR_OPERAND_BLOCK: operand.value = block_map[operand.value]; break;
+                    default: break;
+                }
+                // phi中来自空块(不可达)的输入没有对应的块
+                if (instr->op == IR_PHI && a % 2 == 0 && operand.value < 0) {
+                    a++;
+                    continue;
+                }
+                mapped[count++] = operand;
+            }
+
+            if (instr->op == IR_RET) {
+                if (count > 0) ret_value[ret_count] = mapped[0];
+                ret_block[ret_count++] = target;
+                IROperand jump = ir_operand_block(cont);
+                ir_emit(function, target, IR_JMP, IR_TYPE_VOID, false, &jump, 1, instr->line);
+                continue;
+            }
+            int id = ir_emit(function, target, (IROpcode)instr->op, (IRType)instr->type, false, mapped, count,
+                             instr->line);
+            if (instr->dest >= 0) function->instrs[id].dest = value_map[instr->dest].value;
+        }
+    }
+    IROperand entry = ir_operand_block(block_map[0]);
+    ir_emit(function, block, IR_JMP, IR_TYPE_VOID, false, &entry, 1, line);
+    ir_function_compute_cfg(function);
+
+    // 返回值: 只有一处ret时直接使用, 多处时在后半块开头用phi汇合; 不返回时后半块不可达
+    if (dest >= 0) {
+        IROperand result = ir_operand_const(0, type);
+        if (ret_count == 1) {
+            result = ret_value[0];
+        } else if (ret_count > 1) {
+            int phi_id = ir_insert_phi(function, cont, type);
+            IRInstr* phi = &function->instrs[phi_id];
+            IROperand* inputs = ir_instr_args(function, phi);
+            for (int a = 0; a < phi->arg_count; a += 2) {
+                for (int r = 0; r < ret_count; r++) {
+                    if (ret_block[r] == inputs[a].value) inputs[a + 1] = ret_value[r];
+                }
+            }
+            result = ir_operand_vreg(phi->dest, type);
+        }
+        IROperand* map = (IROperand*)inline_alloc(sizeof(IROperand) * (size_t)function->vreg_count);
+        map[dest] = result;
+        ir_function_replace_uses(function, map);
+        free(map);
+    }
+
+    free(mapped);
+    free(ret_value);
+    free(ret_block);
+    free(slot_map);
+    free(value_map);
+    free(block_map);
+    free(actuals);
+}
+
+// ========== 遍历 ==========
+
+static void inline_into(Inliner* in, int caller_index) {
+    IRModule* module = in->module;
+    IRFunction* caller = &module->functions[caller_index];
+    if (!caller->is_defined || caller->block_count == 0) return;
+
+    // 先收集原有的调用点, 复制进来的函数体中的调用不再考虑
+    int call_count = in->edge_start[caller_index + 1] - in->edge_start[caller_index];
+    int* calls = (int*)inline_alloc(sizeof(int) * (size_t)(call_count > 0 ? call_count : 1));
+    int count = 0;
+    for (int b = 0; b < caller->block_count; b++) {
+        const IRBlock* block = &caller->blocks[b];
+        for (int i = 0; i < block->instr_count; i++) {
+            const IRInstr* instr = &caller->instrs[block->instrs[i]];
+            if (is_call_to_defined(module, caller, instr)) calls[count++] = block->instrs[i];
+        }
+    }
+
+    int inlined = 0;
+    for (int k = 0; k < count; k++) {
+        const IRInstr* call = &caller->instrs[calls[k]];
+        int callee = caller->operands[call->args].value;
+        in->stats->call_sites++;
+        if (in->scc[callee] == in->scc[caller_index]) {
+            in->stats->recursive_calls++;
+            continue;
+        }
+        // 有profile时: 没有执行过的调用点不内联, 热点调用点放宽预算
+        int64_t count = caller->blocks[call->block].count;
+        if (count == 0) {
+            in->stats->cold_calls++;
+            continue;
+        }
+        if (!should_inline(in, caller, call, callee, IR_INLINE_BUDGET)) {
+            if (count < IR_INLINE_HOT_COUNT || !should_inline(in, caller, call, callee, IR_INLINE_HOT_BUDGET)) {
+                continue;
+            }
+            in->stats->hot_calls++;
+        }
+        inline_call(caller, calls[k], &module->functions[callee]);
+        inlined++;
+    }
+    in->stats->inlined_calls += inlined;
+    free(calls);
+
+    // 常量实参折叠进函数体, 不返回的函数体之后的代码被删除
+    if (inlined > 0) ir_function_sccp(module, caller, NULL, NULL);
+}
+
+void ir_module_inline(IRModule* module, IRInlineStats* stats) {
+    IRInlineStats local;
+    memset(&local, 0, sizeof(local));
+    Inliner in;
+    memset(&in, 0, sizeof(in));
+    in.module = module;
+    in.stats = &local;
+    local.instrs_before = ir_module_instr_count(module);
+
+    build_call_graph(&in);
+    find_sccs(&in);
+    for (int k = 0; k < in.order_count; k++) {
+        inline_into(&in, in.order[k]);
+    }
+    local.instrs_after = ir_module_instr_count(module);
+
+    free(in.call_count);
+    free(in.order);
+    free(in.scc);
+    free(in.callees);
+    free(in.edge_start);
+    if (stats) {
+        stats->call_sites += local.call_sites;
+        stats->inlined_calls += local.inlined_calls;
+        stats->recursive_calls += local.recursive_calls;
+        stats->hot_calls += local.hot_calls;
+        stats->cold_calls += local.cold_calls;
+        stats->instrs_before += local.instrs_before;
+        stats->instrs_after += local.instrs_after;
+    }
+}
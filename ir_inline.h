@@ -0,0 +1,42 @@
+#ifndef IR_INLINE_H
+#define IR_INLINE_H
+
+#include "ir.h"
+
+// ========== 函数内联 ==========
+//
+// 在SSA形式上把对小函数的调用替换为被调用者的函数体:
+// 调用所在的块在调用处一分为二, 中间接入复制的函数体(形参直接换成实参),
+// ret改为跳到后半块, 返回值经后半块开头的phi汇合。
+// 按调用图的强连通分量(Tarjan)自底向上处理: 被调用者先处理完(已内联它自己的调用并重新做过
+// 常量传播)再决定是否内联进调用者; 同一强连通分量内的调用(直接或间接递归)一律不内联。
+// 有内联的函数随后重新做常量传播(ir_sccp.h), 常量实参由此折叠进函数体。
+//
+// 代价模型: 被调用者的大小(指令数)减去收益, 不超过IR_INLINE_BUDGET时内联。
+//   收益 = 省掉的调用本身(call、实参传递、返回值) + 每个常量实参IR_INLINE_CONST_ARG_BONUS
+// 整个模块只有一处调用的函数放宽到IR_INLINE_SINGLE_SITE_LIMIT条指令;
+// 调用者超过IR_INLINE_CALLER_LIMIT条指令后不再内联, 数组总长超过IR_INLINE_FRAME_LIMIT的函数不内联。
+// 有profile(见profile.h)时: 没有执行过的调用点不内联; 执行次数不少于IR_INLINE_HOT_COUNT的调用点
+// 预算放宽到IR_INLINE_HOT_BUDGET。复制进来的块的计数按调用点占被调用者入口计数的比例折算。
+
+#define IR_INLINE_BUDGET 12
+#define IR_INLINE_HOT_BUDGET 40
+#define IR_INLINE_HOT_COUNT 1000
+#define IR_INLINE_CONST_ARG_BONUS 4
+#define IR_INLINE_SINGLE_SITE_LIMIT 60
+#define IR_INLINE_CALLER_LIMIT 2000
+#define IR_INLINE_FRAME_LIMIT 256
+
+typedef struct IRInlineStats {
+    int call_sites;         // 调用已定义函数的调用点
+    int inlined_calls;      // 内联的调用点
+    int recursive_calls;    // 因在同一强连通分量中(递归)而没有内联的调用点
+    int hot_calls;          // 按profile放宽预算后内联的热点调用点
+    int cold_calls;         // profile中没有执行过而不内联的调用点
+    int instrs_before;      // 内联之前模块的指令数
+    int instrs_after;       // 内联并重新常量传播之后模块的指令数
+} IRInlineStats;
+
+void ir_module_inline(IRModule* module, IRInlineStats* stats);
+
+#endif // IR_INLINE_H
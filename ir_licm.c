@@ -0,0 +1,202 @@
+#include "ir_licm.h"
+#include "ir_dom.h"
+#include "ir_loop.h"
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct LICM {
+    IRFunction* function;
+    IRLoopInfo* loops;
+    int* def_instr;         // 虚拟寄存器 → 定义它的指令, 参数为-1
+    int* stored;            // 全局变量 → 最近一个写它的循环
+    bool* moved;            // 指令已被外提过(从内层再外提到外层时不重复计数)
+    int global_count;
+
+    // 当前循环的副作用
+    bool has_call;
+    bool has_pointer_store;
+} LICM;
+
+static void* licm_alloc(size_t size) {
+    void* ptr = malloc(size ? size : 1);
+    if (!ptr) {
+        perror("malloc failed for LICM");
+        exit(1);
+    }
+    return ptr;
+}
+
+// ========== 判断 ==========
+
+static bool is_invariant(const LICM* licm, int loop, IROperand operand) {
+    if (operand.kind != IR_OPERAND_VREG) return true;
+    int def = licm->def_instr[operand.value];
+    if (def < 0) return true;
+    return !ir_loop_contains(licm->loops, loop, licm->function->instrs[def].block);
+}
+
+static bool can_speculate(const LICM* licm, int loop, const IRInstr* instr, const IROperand* args) {
+    switch (instr->op) {
+        case IR_ADD: case IR_SUB: case IR_MUL: case IR_NEG:
+        case IR_SHL: case IR_SHR: case IR_AND:
+        case IR_EQ: case IR_NE: case IR_LT: case IR_LE: case IR_GT: case IR_GE:
+        case IR_NOT: case IR_ZEXT: case IR_COPY: case IR_ADDR:
+            return true;
+        case IR_DIV: case IR_MOD:
+            return args[1].kind == IR_OPERAND_CONST && args[1].value != 0 && args[1].value != -1;
+        case IR_LOAD:
+            return instr->arg_count == 1 && args[0].kind == IR_OPERAND_GLOBAL &&
+                   !licm->has_call && !licm->has_pointer_store &&
+                   licm->stored[args[0].value] != loop;
+        default:
+            return false;
+    }
+}
+
+static void scan_side_effects(LICM* licm, int loop) {
+    IRFunction* function = licm->function;
+    const IRLoop* info = &licm->loops->loops[loop];
+    licm->has_call = false;
+    licm->has_pointer_store = false;
+
+    for (int i = 0; i < info->block_count; i++) {
+        const IRBlock* block = &function->blocks[licm->loops->blocks[info->block_start + i]];
+        for (int j = 0; j < block->instr_count; j++) {
+            const IRInstr* instr = &function->instrs[block->instrs[j]];
+            const IROperand* args = &function->operands[instr->args];
+            if (instr->op == IR_CALL) {
+                licm->has_call = true;
+            } else if (instr->op == IR_STORE) {
+                if (args[0].kind == IR_OPERAND_GLOBAL) {
+                    licm->stored[args[0].value] = loop;
+                } else if (args[0].kind == IR_OPERAND_VREG) {
+                    licm->has_pointer_store = true;
+                }
+            }
+        }
+    }
+}
+
+// ========== 外提 ==========
+
+static void append_before_terminator(IRFunction* function, int b, int id) {
+    IRBlock* block = &function->blocks[b];
+    ARENA_RESERVE(function->arena, block->instrs, block->instr_count, block->instr_capacity);
+    int position = block->instr_count;
+    if (position > 0 && ir_opcode_is_terminator((IROpcode)function->instrs[block->instrs[position - 1]].op)) {
+        position--;
+    }
+    memmove(&block->instrs[position + 1], &block->instrs[position],
+            sizeof(int32_t) * (size_t)(block->instr_count - position));
+    block->instrs[position] = id;
+    block->instr_count++;
+    function->instrs[id].block = b;
+}
+
+static int hoist_loop(LICM* licm, int loop) {
+    IRFunction* function = licm->function;
+    const IRLoop* info = &licm->loops->loops[loop];
+    int preheader = info->preheader;
+    if (preheader < 0) return 0;
+
+    scan_side_effects(licm, loop);
+
+    // 按逆后序遍历, 操作数的定义先于使用被外提, 一遍就能找出所有不变量
+    int hoisted = 0;
+    for (int i = 0; i < info->block_count; i++) {
+        int b = licm->loops->blocks[info->block_start + i];
+        IRBlock* block = &function->blocks[b];
+        int kept = 0;
+        for (int j = 0; j < block->instr_count; j++) {
+            int id = block->instrs[j];
+            IRInstr* instr = &function->instrs[id];
+            IROperand* args = ir_instr_args(function, instr);
+
+            bool invariant = instr->dest >= 0 && can_speculate(licm, loop, instr, args);
+            for (int a = 0; invariant && a < instr->arg_count; a++) {
+                invariant = is_invariant(licm, loop, args[a]);
+            }
+            if (!invariant) {
+                block->instrs[kept++] = id;
+                continue;
+            }
+            append_before_terminator(function, preheader, id);
+            block = &function->blocks[b];
+            if (!licm->moved[id]) hoisted++;
+            licm->moved[id] = true;
+        }
+        block->instr_count = kept;
+    }
+    return hoisted;
+}
+
+void ir_function_licm(IRFunction* function, IRLICMStats* stats) {
+    if (!function->is_defined || function->block_count == 0 || !function->is_ssa) return;
+
+    IRDomTree* dom = ir_dom_tree_create(function);
+    IRLoopInfo* loops = ir_loop_info_create(function, dom);
+    if (loops->loop_count == 0) {
+        ir_loop_info_destroy(loops);
+        ir_dom_tree_destroy(dom);
+        return;
+    }
+
+    int created = ir_loop_insert_preheaders(function, loops);
+    if (created > 0) {
+        ir_loop_info_destroy(loops);
+        ir_dom_tree_destroy(dom);
+        dom = ir_dom_tree_create(function);
+        loops = ir_loop_info_create(function, dom);
+    }
+
+    LICM licm;
+    memset(&licm, 0, sizeof(licm));
+    licm.function = function;
+    licm.loops = loops;
+    licm.def_instr = (int*)licm_alloc(sizeof(int) * (size_t)(function->vreg_count + 1));
+    memset(licm.def_instr, -1, sizeof(int) * (size_t)(function->vreg_count + 1));
+    for (int b = 0; b < function->block_count; b++) {
+        const IRBlock* block = &function->blocks[b];
+        for (int i = 0; i < block->instr_count; i++) {
+            const IRInstr* instr = &function->instrs[block->instrs[i]];
+            if (instr->dest >= 0) licm.def_instr[instr->dest] = block->instrs[i];
+        }
+    }
+    for (int i = 0; i < function->operand_count; i++) {
+        const IROperand* operand = &function->operands[i];
+        if (operand->kind == IR_OPERAND_GLOBAL && operand->value >= licm.global_count) {
+            licm.global_count = operand->value + 1;
+        }
+    }
+    licm.moved = (bool*)calloc((size_t)function->instr_count + 1, sizeof(bool));
+    if (!licm.moved) {
+        perror("malloc failed for LICM");
+        exit(1);
+    }
+    licm.stored = (int*)licm_alloc(sizeof(int) * (size_t)(licm.global_count + 1));
+    memset(licm.stored, -1, sizeof(int) * (size_t)(licm.global_count + 1));
+
+    // 内层循环先外提到自己的前置块, 它在外层循环中, 之后还可能继续外提
+    int hoisted = 0;
+    for (int l = loops->loop_count - 1; l >= 0; l--) {
+        hoisted += hoist_loop(&licm, l);
+    }
+
+    if (stats) {
+        stats->loops += loops->loop_count;
+        stats->preheaders += created;
+        stats->hoisted_instrs += hoisted;
+    }
+
+    free(licm.def_instr);
+    free(licm.stored);
+    free(licm.moved);
+    ir_loop_info_destroy(loops);
+    ir_dom_tree_destroy(dom);
+}
+
+void ir_module_licm(IRModule* module, IRLICMStats* stats) {
+    for (int i = 0; i < module->function_count; i++) {
+        ir_function_licm(&module->functions[i], stats);
+    }
+}
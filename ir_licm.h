@@ -0,0 +1,23 @@
+#ifndef IR_LICM_H
+#define IR_LICM_H
+
+#include "ir.h"
+
+// ========== 循环不变量外提(LICM) ==========
+//
+// 在SSA形式上找出自然循环(ir_loop.h), 必要时插入前置块, 再从内层到外层
+// 把操作数都在循环外定义的纯计算移到前置块。外提是投机执行: 循环一次都不执行、
+// 或者计算原本在不一定执行的分支里时也会算一次, 所以只外提不会出错的指令:
+//   - 算术、比较、取地址(除法和取模要求除数是非0且非-1的常量)
+//   - 全局标量的load, 要求循环里没有调用、没有指针写入、没有写这个全局变量
+
+typedef struct IRLICMStats {
+    int loops;              // 找到的自然循环数
+    int preheaders;         // 新建的前置块数
+    int hoisted_instrs;     // 外提的指令数
+} IRLICMStats;
+
+void ir_function_licm(IRFunction* function, IRLICMStats* stats);
+void ir_module_licm(IRModule* module, IRLICMStats* stats);
+
+#endif // IR_LICM_H
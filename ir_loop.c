@@ -0,0 +1,236 @@
+#include "ir_loop.h"
+#include <stdlib.h>
+#include <string.h>
+
+static int* int_array(int count, int fill) {
+    int* array = (int*)malloc(sizeof(int) * (size_t)(count > 0 ? count : 1));
+    if (!array) {
+        perror("malloc failed for loop info");
+        exit(1);
+    }
+    for (int i = 0; i < count; i++) array[i] = fill;
+    return array;
+}
+
+// ========== 循环识别 ==========
+
+IRLoopInfo* ir_loop_info_create(const IRFunction* function, const IRDomTree* dom) {
+    IRLoopInfo* info = (IRLoopInfo*)malloc(sizeof(IRLoopInfo));
+    if (!info) {
+        perror("malloc failed for IRLoopInfo");
+        exit(1);
+    }
+
+    int n = function->block_count;
+    info->block_count = n;
+    info->block_loop = int_array(n, -1);
+    info->loops = NULL;
+    info->loop_count = 0;
+
+    // 按逆后序找循环头, 外层循环头先于内层, 这样内层循环后标记、覆盖外层的block_loop
+    int capacity = 0;
+    int* visited = int_array(n, -1);
+    int* stack = int_array(n, -1);
+    for (int r = 0; r < dom->rpo_count; r++) {
+        int header = dom->rpo[r];
+        const IRBlock* block = &function->blocks[header];
+
+        int depth = 0;
+        for (int p = 0; p < block->pred_count; p++) {
+            int pred = block->preds[p];
+            if (ir_dom_dominates(dom, header, pred)) stack[depth++] = pred;
+        }
+        if (depth == 0) continue;
+
+        if (info->loop_count == capacity) {
+            capacity = capacity ? capacity * 2 : 8;
+            info->loops = (IRLoop*)realloc(info->loops, sizeof(IRLoop) * (size_t)capacity);
+            if (!info->loops) {
+                perror("malloc failed for IRLoop");
+                exit(1);
+            }
+        }
+        int id = info->loop_count++;
+        IRLoop* loop = &info->loops[id];
+        loop->header = header;
+        loop->preheader = -1;
+        loop->parent = info->block_loop[header];
+        loop->depth = loop->parent >= 0 ? info->loops[loop->parent].depth + 1 : 1;
+        loop->block_count = 0;
+
+        // 从回边起点逆着控制流走到循环头为止
+        visited[header] = id;
+        info->block_loop[header] = id;
+        for (int i = 0; i < depth; i++) visited[stack[i]] = id;
+        while (depth > 0) {
+            int b = stack[--depth];
+            info->block_loop[b] = id;
+            const IRBlock* body = &function->blocks[b];
+            for (int p = 0; p < body->pred_count; p++) {
+                int pred = body->preds[p];
+                if (visited[pred] != id && ir_dom_reachable(dom, pred)) {
+                    visited[pred] = id;
+                    stack[depth++] = pred;
+                }
+            }
+        }
+    }
+
+    // 按逆后序把每个块记入它所在的各层循环
+    int* counts = int_array(info->loop_count + 1, 0);
+    for (int r = 0; r < dom->rpo_count; r++) {
+        for (int l = info->block_loop[dom->rpo[r]]; l >= 0; l = info->loops[l].parent) {
+            counts[l]++;
+        }
+    }
+    int total = 0;
+    for (int l = 0; l < info->loop_count; l++) {
+        info->loops[l].block_start = total;
+        total += counts[l];
+    }
+    info->blocks = int_array(total, -1);
+    for (int r = 0; r < dom->rpo_count; r++) {
+        int b = dom->rpo[r];
+        for (int l = info->block_loop[b]; l >= 0; l = info->loops[l].parent) {
+            IRLoop* loop = &info->loops[l];
+            info->blocks[loop->block_start + loop->block_count++] = b;
+        }
+    }
+
+    // 唯一的循环外前驱只跳到循环头时就是前置块
+    for (int l = 0; l < info->loop_count; l++) {
+        IRLoop* loop = &info->loops[l];
+        const IRBlock* header = &function->blocks[loop->header];
+        int outside = -1;
+        int outside_count = 0;
+        for (int p = 0; p < header->pred_count; p++) {
+            if (!ir_loop_contains(info, l, header->preds[p])) {
+                outside = header->preds[p];
+                outside_count++;
+            }
+        }
+        if (outside_count == 1 && function->blocks[outside].succ_count == 1) {
+            loop->preheader = outside;
+        }
+    }
+
+    free(visited);
+    free(stack);
+    free(counts);
+    return info;
+}
+
+void ir_loop_info_destroy(IRLoopInfo* info) {
+    if (!info) return;
+
+    free(info->loops);
+    free(info->blocks);
+    free(info->block_loop);
+    free(info);
+}
+
+bool ir_loop_contains(const IRLoopInfo* info, int loop, int block) {
+    for (int l = info->block_loop[block]; l >= 0; l = info->loops[l].parent) {
+        if (l == loop) return true;
+    }
+    return false;
+}
+
+// ========== 前置块 ==========
+
+static void retarget(IRFunction* function, int block, int from, int to) {
+    IRInstr* term = ir_block_terminator(function, block);
+    if (!term) return;
+    IROperand* args = ir_instr_args(function, term);
+    for (int a = 0; a < term->arg_count; a++) {
+        if (args[a].kind == IR_OPERAND_BLOCK && args[a].value == from) args[a].value = to;
+    }
+}
+
+static int create_preheader(IRFunction* function, const IRLoopInfo* info, int l) {
+    int header = info->loops[l].header;
+    int preheader = ir_new_block(function);
+    int line = function->line;
+
+    // 循环头的phi: 循环外前驱的输入移到前置块, 多于一个时在前置块里合并
+    int* phis = NULL;
+    int phi_count = 0;
+    IRBlock* block = &function->blocks[header];
+    while (phi_count < block->instr_count &&
+           function->instrs[block->instrs[phi_count]].op == IR_PHI) {
+        phi_count++;
+    }
+    if (phi_count > 0) {
+        phis = int_array(phi_count, -1);
+        memcpy(phis, block->instrs, sizeof(int) * (size_t)phi_count);
+    }
+
+    for (int i = 0; i < phi_count; i++) {
+        IRInstr* phi = &function->instrs[phis[i]];
+        int arg_count = phi->arg_count;
+        IROperand* merged = (IROperand*)malloc(sizeof(IROperand) * (size_t)(arg_count + 2));
+        if (!merged) {
+            perror("malloc failed for preheader phi");
+            exit(1);
+        }
+        int merged_count = 0;
+        int kept = 0;
+        IROperand* args = ir_instr_args(function, phi);
+        for (int a = 0; a + 1 < arg_count; a += 2) {
+            if (ir_loop_contains(info, l, args[a].value)) {
+                args[kept++] = args[a];
+                args[kept++] = args[a + 1];
+            } else {
+                merged[merged_count++] = args[a];
+                merged[merged_count++] = args[a + 1];
+            }
+        }
+
+        IROperand value = merged[1];
+        if (merged_count > 2) {
+            line = phi->line;
+            IRType type = (IRType)phi->type;
+            int id = ir_emit(function, preheader, IR_PHI, type, true, merged, merged_count, line);
+            value = ir_operand_vreg(function->instrs[id].dest, type);
+        }
+        // ir_emit可能扩容指令数组, 重新取phi
+        phi = &function->instrs[phis[i]];
+        args = ir_instr_args(function, phi);
+        args[kept++] = ir_operand_block(preheader);
+        args[kept++] = value;
+        phi->arg_count = kept;
+        free(merged);
+    }
+    free(phis);
+
+    IROperand target = ir_operand_block(header);
+    ir_emit(function, preheader, IR_JMP, IR_TYPE_VOID, false, &target, 1, line);
+
+    block = &function->blocks[header];
+    for (int p = 0; p < block->pred_count; p++) {
+        int pred = block->preds[p];
+        if (!ir_loop_contains(info, l, pred)) retarget(function, pred, header, preheader);
+    }
+    return preheader;
+}
+
+int ir_loop_insert_preheaders(IRFunction* function, const IRLoopInfo* info) {
+    int created = 0;
+    for (int l = 0; l < info->loop_count; l++) {
+        if (info->loops[l].preheader >= 0) continue;
+
+        // 入口块作循环头时没有循环外前驱
+        const IRBlock* header = &function->blocks[info->loops[l].header];
+        bool has_outside = false;
+        for (int p = 0; p < header->pred_count; p++) {
+            if (!ir_loop_contains(info, l, header->preds[p])) has_outside = true;
+        }
+        if (!has_outside) continue;
+
+        create_preheader(function, info, l);
+        created++;
+        // 后面的循环仍按旧的前驱关系判断, 控制流图最后统一重算
+    }
+    if (created > 0) ir_function_compute_cfg(function);
+    return created;
+}
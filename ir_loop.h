@@ -0,0 +1,45 @@
+#ifndef IR_LOOP_H
+#define IR_LOOP_H
+
+#include "ir.h"
+#include "ir_dom.h"
+
+// ========== 自然循环 ==========
+//
+// 回边是指向支配自己的块(循环头)的边; 以同一块为头的所有回边合成一个自然循环,
+// 循环体是不经过循环头就能到达回边起点的块。结构化的源程序只产生可归约的控制流图,
+// 自然循环之间要么嵌套要么不相交。
+//
+// 前置块(preheader)是循环头唯一的循环外前驱, 并且只有循环头一个后继;
+// 外提到这里的计算在进入循环前执行一次。
+
+typedef struct IRLoop {
+    int header;
+    int preheader;      // 前置块, 没有时为-1
+    int parent;         // 直接外层循环, 最外层为-1
+    int depth;          // 嵌套深度, 最外层为1
+    int block_start;    // 循环体(含内层循环)为 IRLoopInfo.blocks[block_start .. block_start+block_count)
+    int block_count;    // 按逆后序排列, 循环头在最前
+} IRLoop;
+
+typedef struct IRLoopInfo {
+    IRLoop* loops;      // 按循环头的逆后序排列, 外层循环在内层之前
+    int loop_count;
+
+    int* blocks;
+    int* block_loop;    // 每个基本块所在的最内层循环, 不在循环中为-1
+    int block_count;
+} IRLoopInfo;
+
+// 根据函数的控制流图和支配树找出所有自然循环
+IRLoopInfo* ir_loop_info_create(const IRFunction* function, const IRDomTree* dom);
+void ir_loop_info_destroy(IRLoopInfo* info);
+
+// block是否在loop(含其内层循环)中
+bool ir_loop_contains(const IRLoopInfo* info, int loop, int block);
+
+// 为没有前置块的循环创建前置块: 循环外的前驱改为跳到新块, 循环头的phi中来自这些前驱的输入
+// 合并到新块的phi里。返回创建的块数; 之后控制流图已重新计算, 支配树和循环信息需要重建
+int ir_loop_insert_preheaders(IRFunction* function, const IRLoopInfo* info);
+
+#endif // IR_LOOP_H
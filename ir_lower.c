@@ -0,0 +1,629 @@
+#include "ir_lower.h"
+#include "symbol_table.h"
+#include "semantic_analyzer.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+
+// ========== 转换状态 ==========
+
+typedef struct IRLowering {
+    IRModule* module;
+    int function;           // 当前函数编号, -1表示在全局声明之间
+    int block;              // 当前插入指令的基本块, -1表示当前位置不可达
+    int toplevel;           // 顶层语句所在的函数(-1表示还没有顶层语句)
+    int toplevel_block;     // 顶层函数中下一条语句所在的基本块
+    SymbolTable* symbols;   // 名字 → IR编号(Symbol.ir_id), 作用域划分与类型检查器一致
+    FILE* err;
+    bool has_errors;
+} IRLowering;
+
+#define CURRENT_FUNCTION(lowering) (&(lowering)->module->functions[(lowering)->function])
+
+static IROperand lower_expr(IRLowering* lowering, ASTNode* node);
+static void lower_stmt(IRLowering* lowering, ASTNode* node);
+
+static void lower_error(IRLowering* lowering, int line, const char* format, ...) {
+    fprintf(lowering->err, "\033[31mIR生成错误 (行 %d): ", line);
+
+    va_list args;
+    va_start(args, format);
+    vfprintf(lowering->err, format, args);
+    va_end(args);
+
+    fprintf(lowering->err, "\033[0m\n");
+    lowering->has_errors = true;
+}
+
+static IRType lower_type(IRLowering* lowering, Type* type, int line) {
+    if (!type) return IR_TYPE_VOID;
+
+    switch (type->base_type) {
+        case TYPE_VOID: return IR_TYPE_VOID;
+        case TYPE_INT:
+        case TYPE_CHAR: return IR_TYPE_I32;
+        case TYPE_BOOL: return IR_TYPE_BOOL;
+        case TYPE_POINTER: return IR_TYPE_PTR;
+        case TYPE_ARRAY: return lower_type(lowering, type->array_info.element_type, line);
+        default:
+            lower_error(lowering, line, "不支持的类型 '%s'", type_to_string(type));
+            return IR_TYPE_I32;
+    }
+}
+
+// ========== 指令生成 ==========
+
+// 当前位置不可达时(return之后)为后续语句新建一个基本块
+static int current_block(IRLowering* lowering) {
+    if (lowering->block < 0) {
+        lowering->block = ir_new_block(CURRENT_FUNCTION(lowering));
+    }
+    return lowering->block;
+}
+
+static IROperand emit_value(IRLowering* lowering, IROpcode op, IRType type,
+                            const IROperand* args, int arg_count, int line) {
+    IRFunction* function = CURRENT_FUNCTION(lowering);
+    int id = ir_emit(function, current_block(lowering), op, type, true, args, arg_count, line);
+    return ir_operand_vreg(function->instrs[id].dest, type);
+}
+
+static void emit_void(IRLowering* lowering, IROpcode op, const IROperand* args, int arg_count, int line) {
+    ir_emit(CURRENT_FUNCTION(lowering), current_block(lowering), op, IR_TYPE_VOID, false,
+            args, arg_count, line);
+}
+
+// 跳转到target, 之后的位置不可达
+static void emit_jump(IRLowering* lowering, int target, int line) {
+    if (lowering->block < 0) return;
+
+    IROperand args[1] = { ir_operand_block(target) };
+    emit_void(lowering, IR_JMP, args, 1, line);
+    lowering->block = -1;
+}
+
+static void emit_branch(IRLowering* lowering, IROperand condition, int then_block, int else_block,
+                        int line) {
+    IROperand args[3] = { condition, ir_operand_block(then_block), ir_operand_block(else_block) };
+    emit_void(lowering, IR_BR, args, 3, line);
+    lowering->block = -1;
+}
+
+static IROperand to_bool(IRLowering* lowering, IROperand value, int line) {
+    if (value.type == IR_TYPE_BOOL) return value;
+    if (value.kind == IR_OPERAND_CONST) {
+        return ir_operand_const(value.value != 0, IR_TYPE_BOOL);
+    }
+
+    IROperand args[2] = { value, ir_operand_const(0, value.type) };
+    return emit_value(lowering, IR_NE, IR_TYPE_BOOL, args, 2, line);
+}
+
+static IROperand to_i32(IRLowering* lowering, IROperand value, int line) {
+    if (value.type != IR_TYPE_BOOL) return value;
+    if (value.kind == IR_OPERAND_CONST) {
+        return ir_operand_const(value.value, IR_TYPE_I32);
+    }
+
+    IROperand args[1] = { value };
+    return emit_value(lowering, IR_ZEXT, IR_TYPE_I32, args, 1, line);
+}
+
+static IROperand coerce(IRLowering* lowering, IROperand value, IRType type, int line) {
+    if (type == IR_TYPE_BOOL) return to_bool(lowering, value, line);
+    if (type == IR_TYPE_I32) return to_i32(lowering, value, line);
+    return value;
+}
+
+// ========== 变量 ==========
+
+// 查找变量对应的栈槽或全局变量
+static Symbol* lookup_variable(IRLowering* lowering, const char* name, int line, IROperand* base) {
+    Symbol* symbol = symbol_table_lookup(lowering->symbols, name);
+    if (!symbol || symbol->kind == SYMBOL_FUNC || symbol->ir_id < 0) {
+        lower_error(lowering, line, "未声明的变量 '%s'", name);
+        return NULL;
+    }
+
+    IRType type = lower_type(lowering, symbol->type, line);
+    *base = symbol->scope_level == 0 ? ir_operand_global(symbol->ir_id, type)
+                                     : ir_operand_slot(symbol->ir_id, type);
+    return symbol;
+}
+
+// 计算左值的位置: base[index], 标量的index为IR_OPERAND_NONE
+static bool lower_lvalue(IRLowering* lowering, ASTNode* node, IROperand* base, IROperand* index) {
+    index->kind = IR_OPERAND_NONE;
+
+    switch (node->node_type) {
+        case AST_IDENTIFIER: {
+            Symbol* symbol = lookup_variable(lowering, node->data.identifier.name, node->line, base);
+            if (!symbol) return false;
+            if (symbol->type->base_type == TYPE_ARRAY) {
+                lower_error(lowering, node->line, "数组 '%s' 不能作为整体使用",
+                            node->data.identifier.name);
+                return false;
+            }
+            return true;
+        }
+        case AST_ARRAY_ACCESS: {
+            ASTNode* array = node->data.array_access.array;
+            if (array->node_type != AST_IDENTIFIER) {
+                lower_error(lowering, node->line, "只支持对数组变量取下标");
+                return false;
+            }
+            Symbol* symbol = lookup_variable(lowering, array->data.identifier.name, node->line, base);
+            if (!symbol) return false;
+            *index = to_i32(lowering, lower_expr(lowering, node->data.array_access.index), node->line);
+            return true;
+        }
+        case AST_UNARY_OP:
+            if (node->data.unary_op.op == OP_DEREF) {
+                *base = lower_expr(lowering, node->data.unary_op.operand);
+                return true;
+            }
+            break;
+        default:
+            break;
+    }
+
+    lower_error(lowering, node->line, "表达式不是左值");
+    return false;
+}
+
+// 左值位置上元素的类型(指针只能指向int)
+static IRType lvalue_type(IROperand base) {
+    return base.kind == IR_OPERAND_VREG ? IR_TYPE_I32 : (IRType)base.type;
+}
+
+static IROperand emit_load(IRLowering* lowering, IROperand base, IROperand index, int line) {
+    IROperand args[2] = { base, index };
+    return emit_value(lowering, IR_LOAD, lvalue_type(base), args,
+                      index.kind == IR_OPERAND_NONE ? 1 : 2, line);
+}
+
+static void emit_store(IRLowering* lowering, IROperand base, IROperand index, IROperand value, int line) {
+    IROperand args[3] = { base, coerce(lowering, value, lvalue_type(base), line), index };
+    emit_void(lowering, IR_STORE, args, index.kind == IR_OPERAND_NONE ? 2 : 3, line);
+}
+
+// ========== 表达式 ==========
+
+// a && b / a || b: 短路求值, 结果先存入临时栈槽(SSA构造会把它变成phi)
+static IROperand lower_logical(IRLowering* lowering, ASTNode* node) {
+    IRFunction* function = CURRENT_FUNCTION(lowering);
+    int line = node->line;
+    IROperand result = ir_operand_slot(ir_new_slot(function, NULL, IR_TYPE_BOOL, 1, -1), IR_TYPE_BOOL);
+    IROperand none = { IR_OPERAND_NONE, IR_TYPE_VOID, 0 };
+
+    IROperand left = to_bool(lowering, lower_expr(lowering, node->data.binary_op.left), line);
+    emit_store(lowering, result, none, left, line);
+
+    int rhs_block = ir_new_block(function);
+    int end_block = ir_new_block(function);
+    if (node->data.binary_op.op == OP_AND) {
+        emit_branch(lowering, left, rhs_block, end_block, line);
+    } else {
+        emit_branch(lowering, left, end_block, rhs_block, line);
+    }
+
+    lowering->block = rhs_block;
+    IROperand right = to_bool(lowering, lower_expr(lowering, node->data.binary_op.right), line);
+    emit_store(lowering, result, none, right, line);
+    emit_jump(lowering, end_block, line);
+
+    lowering->block = end_block;
+    return emit_load(lowering, result, none, line);
+}
+
+static IROperand lower_binary(IRLowering* lowering, ASTNode* node) {
+    BinaryOp op = node->data.binary_op.op;
+    int line = node->line;
+
+    if (op == OP_AND || op == OP_OR) {
+        return lower_logical(lowering, node);
+    }
+
+    IROperand left = lower_expr(lowering, node->data.binary_op.left);
+    IROperand right = lower_expr(lowering, node->data.binary_op.right);
+
+    IROpcode opcode;
+    IRType type = IR_TYPE_BOOL;
+    switch (op) {
+        case OP_ADD: opcode = IR_ADD; type = IR_TYPE_I32; break;
+        case OP_SUB: opcode = IR_SUB; type = IR_TYPE_I32; break;
+        case OP_MUL: opcode = IR_MUL; type = IR_TYPE_I32; break;
+        case OP_DIV: opcode = IR_DIV; type = IR_TYPE_I32; break;
+        case OP_MOD: opcode = IR_MOD; type = IR_TYPE_I32; break;
+        case OP_LT: opcode = IR_LT; break;
+        case OP_LE: opcode = IR_LE; break;
+        case OP_GT: opcode = IR_GT; break;
+        case OP_GE: opcode = IR_GE; break;
+        case OP_EQ: opcode = IR_EQ; break;
+        case OP_NE: opcode = IR_NE; break;
+        default:
+            lower_error(lowering, line, "不支持的二元运算符 '%s'", binary_op_str(op));
+            return ir_operand_const(0, IR_TYPE_I32);
+    }
+
+    // 两个bool之间的相等比较保持bool, 其余情况按int比较
+    bool bool_compare = (op == OP_EQ || op == OP_NE) &&
+                        left.type == IR_TYPE_BOOL && right.type == IR_TYPE_BOOL;
+    if (!bool_compare) {
+        left = to_i32(lowering, left, line);
+        right = to_i32(lowering, right, line);
+    }
+
+    IROperand args[2] = { left, right };
+    return emit_value(lowering, opcode, type, args, 2, line);
+}
+
+static IROperand lower_unary(IRLowering* lowering, ASTNode* node) {
+    ASTNode* operand = node->data.unary_op.operand;
+    int line = node->line;
+
+    switch (node->data.unary_op.op) {
+        case OP_NEG: {
+            IROperand args[1] = { to_i32(lowering, lower_expr(lowering, operand), line) };
+            return emit_value(lowering, IR_NEG, IR_TYPE_I32, args, 1, line);
+        }
+        case OP_NOT: {
+            IROperand args[1] = { to_bool(lowering, lower_expr(lowering, operand), line) };
+            return emit_value(lowering, IR_NOT, IR_TYPE_BOOL, args, 1, line);
+        }
+        case OP_INC:
+        case OP_DEC: {
+            // ++x: 读取、加减1、写回, 结果为新值
+            IROperand base, index;
+            if (!lower_lvalue(lowering, operand, &base, &index)) break;
+            IROperand args[2] = { emit_load(lowering, base, index, line), ir_operand_const(1, IR_TYPE_I32) };
+            IROperand value = emit_value(lowering, node->data.unary_op.op == OP_INC ? IR_ADD : IR_SUB,
+                                         IR_TYPE_I32, args, 2, line);
+            emit_store(lowering, base, index, value, line);
+            return value;
+        }
+        case OP_ADDR: {
+            IROperand base, index;
+            if (!lower_lvalue(lowering, operand, &base, &index)) break;
+            IROperand args[2] = { base, index };
+            return emit_value(lowering, IR_ADDR, IR_TYPE_PTR, args,
+                              index.kind == IR_OPERAND_NONE ? 1 : 2, line);
+        }
+        case OP_DEREF: {
+            IROperand base, index;
+            if (!lower_lvalue(lowering, node, &base, &index)) break;
+            return emit_load(lowering, base, index, line);
+        }
+    }
+    return ir_operand_const(0, IR_TYPE_I32);
+}
+
+static IROperand lower_call(IRLowering* lowering, ASTNode* node) {
+    const char* name = node->data.func_call.func_name;
+    int arg_count = node->data.func_call.arg_count;
+    int line = node->line;
+
+    Symbol* symbol = symbol_table_lookup(lowering->symbols, name);
+    if (!symbol || symbol->kind != SYMBOL_FUNC) {
+        lower_error(lowering, line, "未声明的函数 '%s'", name);
+        return ir_operand_const(0, IR_TYPE_I32);
+    }
+    IRType return_type = (IRType)lowering->module->functions[symbol->ir_id].return_type;
+
+    IROperand* args = (IROperand*)malloc(sizeof(IROperand) * (arg_count + 1));
+    if (!args) {
+        perror("malloc failed for call args");
+        exit(1);
+    }
+    args[0] = ir_operand_func(symbol->ir_id);
+    for (int i = 0; i < arg_count; i++) {
+        args[i + 1] = to_i32(lowering, lower_expr(lowering, node->data.func_call.args[i]), line);
+    }
+
+    // 实参中的&&/||可能切换了当前基本块, 在求值完所有实参后再取
+    IRFunction* function = CURRENT_FUNCTION(lowering);
+    bool has_value = return_type != IR_TYPE_VOID;
+    int id = ir_emit(function, current_block(lowering), IR_CALL, return_type, has_value,
+                     args, arg_count + 1, line);
+    free(args);
+
+    if (!has_value) {
+        IROperand none = { IR_OPERAND_NONE, IR_TYPE_VOID, 0 };
+        return none;
+    }
+    return ir_operand_vreg(function->instrs[id].dest, return_type);
+}
+
+static IROperand lower_expr(IRLowering* lowering, ASTNode* node) {
+    switch (node->node_type) {
+        case AST_LITERAL:
+            if (node->type && node->type->base_type == TYPE_FLOAT) {
+                lower_error(lowering, node->line, "暂不支持浮点数");
+            }
+            return ir_operand_const(node->data.literal.value.int_value, IR_TYPE_I32);
+
+        case AST_IDENTIFIER:
+        case AST_ARRAY_ACCESS: {
+            IROperand base, index;
+            if (!lower_lvalue(lowering, node, &base, &index)) break;
+            return emit_load(lowering, base, index, node->line);
+        }
+
+        case AST_BINARY_OP:
+            return lower_binary(lowering, node);
+        case AST_UNARY_OP:
+            return lower_unary(lowering, node);
+        case AST_FUNC_CALL:
+            return lower_call(lowering, node);
+
+        default:
+            lower_error(lowering, node->line, "不支持的表达式 '%s'", ast_node_type_str(node->node_type));
+            break;
+    }
+    return ir_operand_const(0, IR_TYPE_I32);
+}
+
+// ========== 语句 ==========
+
+static void lower_local_decl(IRLowering* lowering, ASTNode* node) {
+    Type* var_type = node->data.var_decl.var_type;
+    int count = var_type->base_type == TYPE_ARRAY ? var_type->array_info.size : 1;
+    IRType type = lower_type(lowering, var_type, node->line);
+
+    int slot = ir_new_slot(CURRENT_FUNCTION(lowering), node->data.var_decl.var_name, type, count, -1);
+    CURRENT_FUNCTION(lowering)->slots[slot].line = node->line;
+    Symbol* symbol = symbol_table_insert(lowering->symbols, node->data.var_decl.var_name,
+                                         SYMBOL_VAR, var_type);
+    if (symbol) symbol->ir_id = slot;
+
+    if (node->data.var_decl.init_value) {
+        IROperand none = { IR_OPERAND_NONE, IR_TYPE_VOID, 0 };
+        IROperand value = lower_expr(lowering, node->data.var_decl.init_value);
+        emit_store(lowering, ir_operand_slot(slot, type), none, value, node->line);
+    }
+}
+
+static void lower_if(IRLowering* lowering, ASTNode* node) {
+    IRFunction* function = CURRENT_FUNCTION(lowering);
+    int line = node->line;
+
+    IROperand condition = to_bool(lowering, lower_expr(lowering, node->data.if_stmt.condition), line);
+    int then_block = ir_new_block(function);
+    int else_block = node->data.if_stmt.else_branch ? ir_new_block(function) : -1;
+    int end_block = ir_new_block(function);
+    emit_branch(lowering, condition, then_block, else_block >= 0 ? else_block : end_block, line);
+
+    lowering->block = then_block;
+    symbol_table_enter_scope(lowering->symbols);
+    lower_stmt(lowering, node->data.if_stmt.then_branch);
+    symbol_table_exit_scope(lowering->symbols);
+    emit_jump(lowering, end_block, line);
+
+    if (else_block >= 0) {
+        lowering->block = else_block;
+        symbol_table_enter_scope(lowering->symbols);
+        lower_stmt(lowering, node->data.if_stmt.else_branch);
+        symbol_table_exit_scope(lowering->symbols);
+        emit_jump(lowering, end_block, line);
+    }
+
+    lowering->block = end_block;
+}
+
+static void lower_while(IRLowering* lowering, ASTNode* node) {
+    IRFunction* function = CURRENT_FUNCTION(lowering);
+    int line = node->line;
+
+    int header_block = ir_new_block(function);
+    emit_jump(lowering, header_block, line);
+
+    lowering->block = header_block;
+    IROperand condition = to_bool(lowering, lower_expr(lowering, node->data.while_stmt.condition), line);
+    int body_block = ir_new_block(function);
+    int exit_block = ir_new_block(function);
+    emit_branch(lowering, condition, body_block, exit_block, line);
+
+    lowering->block = body_block;
+    symbol_table_enter_scope(lowering->symbols);
+    lower_stmt(lowering, node->data.while_stmt.body);
+    symbol_table_exit_scope(lowering->symbols);
+    emit_jump(lowering, header_block, line);
+
+    lowering->block = exit_block;
+}
+
+static void lower_return(IRLowering* lowering, ASTNode* node) {
+    IRFunction* function = CURRENT_FUNCTION(lowering);
+    IRType return_type = (IRType)function->return_type;
+
+    if (node->data.return_stmt.return_value && return_type != IR_TYPE_VOID) {
+        IROperand value = lower_expr(lowering, node->data.return_stmt.return_value);
+        IROperand args[1] = { coerce(lowering, value, return_type, node->line) };
+        emit_void(lowering, IR_RET, args, 1, node->line);
+    } else {
+        if (node->data.return_stmt.return_value) {
+            lower_expr(lowering, node->data.return_stmt.return_value);
+        }
+        emit_void(lowering, IR_RET, NULL, 0, node->line);
+    }
+    lowering->block = -1;
+}
+
+static void lower_stmt(IRLowering* lowering, ASTNode* node) {
+    if (!node) return;
+
+    switch (node->node_type) {
+        case AST_VAR_DECL:
+            lower_local_decl(lowering, node);
+            break;
+
+        case AST_ASSIGN_STMT: {
+            IROperand base, index;
+            if (!lower_lvalue(lowering, node->data.assign_stmt.lvalue, &base, &index)) break;
+            IROperand value = lower_expr(lowering, node->data.assign_stmt.rvalue);
+            emit_store(lowering, base, index, value, node->line);
+            break;
+        }
+
+        case AST_IF_STMT:
+            lower_if(lowering, node);
+            break;
+        case AST_WHILE_STMT:
+            lower_while(lowering, node);
+            break;
+        case AST_RETURN_STMT:
+            lower_return(lowering, node);
+            break;
+
+        case AST_COMPOUND_STMT:
+            for (int i = 0; i < node->data.compound_stmt.stmt_count; i++) {
+                lower_stmt(lowering, node->data.compound_stmt.statements[i]);
+            }
+            break;
+
+        case AST_EXPR_STMT:
+            if (node->data.expr_stmt.expr) {
+                lower_expr(lowering, node->data.expr_stmt.expr);
+            }
+            break;
+
+        default:
+            lower_error(lowering, node->line, "不支持的语句 '%s'", ast_node_type_str(node->node_type));
+            break;
+    }
+}
+
+// ========== 顶层声明 ==========
+
+// 切换到顶层函数(第一次使用时创建)
+static void enter_toplevel(IRLowering* lowering) {
+    if (lowering->toplevel < 0) {
+        lowering->toplevel = ir_module_add_function(lowering->module, IR_TOPLEVEL_NAME, IR_TYPE_VOID, 0);
+        IRFunction* function = &lowering->module->functions[lowering->toplevel];
+        function->is_defined = true;
+        lowering->toplevel_block = ir_new_block(function);
+    }
+    lowering->function = lowering->toplevel;
+    lowering->block = lowering->toplevel_block;
+}
+
+static void leave_toplevel(IRLowering* lowering) {
+    lowering->toplevel_block = lowering->block;
+    lowering->function = -1;
+    lowering->block = -1;
+}
+
+static void lower_global_decl(IRLowering* lowering, ASTNode* node) {
+    Type* var_type = node->data.var_decl.var_type;
+    int count = var_type->base_type == TYPE_ARRAY ? var_type->array_info.size : 1;
+    IRType type = lower_type(lowering, var_type, node->line);
+
+    int id = ir_module_add_global(lowering->module, node->data.var_decl.var_name, type, count);
+    Symbol* symbol = symbol_table_insert(lowering->symbols, node->data.var_decl.var_name,
+                                         SYMBOL_VAR, var_type);
+    if (symbol) symbol->ir_id = id;
+
+    ASTNode* init = node->data.var_decl.init_value;
+    if (!init) return;
+
+    if (is_constant_expr(init)) {
+        lowering->module->globals[id].init = evaluate_constant_expr(init);
+    } else {
+        // 非常量初始值在顶层函数中按声明顺序赋值
+        IROperand none = { IR_OPERAND_NONE, IR_TYPE_VOID, 0 };
+        enter_toplevel(lowering);
+        emit_store(lowering, ir_operand_global(id, type), none, lower_expr(lowering, init), node->line);
+        leave_toplevel(lowering);
+    }
+}
+
+static void lower_func_decl(IRLowering* lowering, ASTNode* node) {
+    const char* name = node->data.func_decl.func_name;
+    int param_count = node->data.func_decl.param_count;
+
+    Symbol* symbol = symbol_table_lookup(lowering->symbols, name);
+    if (!symbol) {
+        IRType return_type = lower_type(lowering, node->data.func_decl.return_type, node->line);
+        int id = ir_module_add_function(lowering->module, name, return_type, param_count);
+        symbol = symbol_table_insert(lowering->symbols, name, SYMBOL_FUNC,
+                                     node->data.func_decl.return_type);
+        symbol->ir_id = id;
+    }
+    if (!node->data.func_decl.body) return;
+
+    lowering->function = symbol->ir_id;
+    IRFunction* function = CURRENT_FUNCTION(lowering);
+    function->is_defined = true;
+    function->line = node->line;
+    lowering->block = ir_new_block(function);
+
+    // 参数先存入各自的栈槽, 之后和局部变量一样通过load/store访问
+    IROperand none = { IR_OPERAND_NONE, IR_TYPE_VOID, 0 };
+    symbol_table_enter_scope(lowering->symbols);
+    for (int i = 0; i < param_count; i++) {
+        ASTNode* param = node->data.func_decl.params[i];
+        int slot = ir_new_slot(function, param->data.var_decl.var_name, IR_TYPE_I32, 1, i);
+        function->slots[slot].line = param->line;
+        Symbol* param_symbol = symbol_table_insert(lowering->symbols, param->data.var_decl.var_name,
+                                                   SYMBOL_PARAM, param->data.var_decl.var_type);
+        if (param_symbol) param_symbol->ir_id = slot;
+        emit_store(lowering, ir_operand_slot(slot, IR_TYPE_I32), none,
+                   ir_operand_vreg(i, IR_TYPE_I32), param->line);
+    }
+
+    lower_stmt(lowering, node->data.func_decl.body);
+
+    // 执行到函数末尾: void函数直接返回, 其余返回0
+    if (lowering->block >= 0) {
+        IROperand zero[1] = { ir_operand_const(0, (IRType)function->return_type) };
+        emit_void(lowering, IR_RET, zero, function->return_type == IR_TYPE_VOID ? 0 : 1, node->line);
+    }
+    symbol_table_exit_scope(lowering->symbols);
+
+    ir_function_compute_cfg(function);
+    lowering->function = -1;
+    lowering->block = -1;
+}
+
+IRModule* ir_lower_program(ASTNode* program, FILE* err) {
+    if (!program || program->node_type != AST_PROGRAM) return NULL;
+
+    IRLowering lowering;
+    lowering.module = ir_module_create();
+    lowering.function = -1;
+    lowering.block = -1;
+    lowering.toplevel = -1;
+    lowering.toplevel_block = -1;
+    lowering.symbols = symbol_table_create();
+    lowering.err = err;
+    lowering.has_errors = false;
+
+    for (int i = 0; i < program->data.program.decl_count; i++) {
+        ASTNode* decl = program->data.program.declarations[i];
+        if (!decl) continue;
+
+        if (decl->node_type == AST_VAR_DECL) {
+            lower_global_decl(&lowering, decl);
+        } else if (decl->node_type == AST_FUNC_DECL) {
+            lower_func_decl(&lowering, decl);
+        } else {
+            enter_toplevel(&lowering);
+            lower_stmt(&lowering, decl);
+            leave_toplevel(&lowering);
+        }
+    }
+
+    if (lowering.toplevel >= 0) {
+        enter_toplevel(&lowering);
+        emit_void(&lowering, IR_RET, NULL, 0, 0);
+        ir_function_compute_cfg(CURRENT_FUNCTION(&lowering));
+        leave_toplevel(&lowering);
+    }
+
+    symbol_table_destroy(lowering.symbols);
+    if (lowering.has_errors) {
+        ir_module_destroy(lowering.module);
+        return NULL;
+    }
+    return lowering.module;
+}
@@ -0,0 +1,17 @@
+#ifndef IR_LOWER_H
+#define IR_LOWER_H
+
+#include "ast.h"
+#include "ir.h"
+#include <stdio.h>
+
+// ========== AST → IR ==========
+
+// 顶层语句(脚本形式的程序)被放进这个函数
+#define IR_TOPLEVEL_NAME "__toplevel"
+
+// 把通过类型检查(和常量折叠)的程序AST转换为IR模块。
+// 遇到无法转换的结构时把错误写入err并返回NULL。
+IRModule* ir_lower_program(ASTNode* program, FILE* err);
+
+#endif // IR_LOWER_H
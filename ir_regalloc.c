@@ -0,0 +1,700 @@
+#include "ir_regalloc.h"
+#include "ir_dom.h"
+#include "ir_loop.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define NO_SPLIT INT32_MAX
+#define PARAM_POS 1
+
+static void* ra_alloc(size_t size) {
+    void* ptr = malloc(size ? size : 1);
+    if (!ptr) {
+        perror("malloc failed for register allocation");
+        exit(1);
+    }
+    return ptr;
+}
+
+static int32_t* int_array(int count, int32_t fill) {
+    int32_t* array = (int32_t*)ra_alloc(sizeof(int32_t) * (size_t)(count > 0 ? count : 1));
+    for (int i = 0; i < count; i++) array[i] = fill;
+    return array;
+}
+
+static IRLoc make_loc(IRLocKind kind, int value) {
+    IRLoc loc = { (uint8_t)kind, value };
+    return loc;
+}
+
+static bool loc_equal(IRLoc a, IRLoc b) {
+    return a.kind == b.kind && a.value == b.value;
+}
+
+static void move_list_add(IRMoveList* list, IRLoc src, IRLoc dst) {
+    if (list->count == list->capacity) {
+        list->capacity = list->capacity ? list->capacity * 2 : 4;
+        list->moves = (IRMove*)realloc(list->moves, sizeof(IRMove) * (size_t)list->capacity);
+        if (!list->moves) {
+            perror("malloc failed for IRMoveList");
+            exit(1);
+        }
+    }
+    list->moves[list->count].src = src;
+    list->moves[list->count].dst = dst;
+    list->count++;
+}
+
+// ========== 块顺序与编号 ==========
+
+// 拓扑排序(忽略回边), 同一循环的块排在一起: 就绪的块按所在循环分组,
+// 循环头算作外层循环的块, 每次从当前循环起由内向外取最近就绪的块。
+// 这样循环回边是唯一从后往前的边, 循环中的值不会被拉长到循环之后的代码。
+// 源语言没有goto, 控制流图总是可归约的
+static void compute_block_order(IRRegAlloc* alloc, const IRFunction* function,
+                                const IRDomTree* dom, const IRLoopInfo* loops) {
+    int n = function->block_count;
+    int32_t* waiting = int_array(n, 0);    // 尚未排入的前向前驱数
+    for (int r = 0; r < dom->rpo_count; r++) {
+        int b = dom->rpo[r];
+        const IRBlock* block = &function->blocks[b];
+        for (int p = 0; p < block->pred_count; p++) {
+            int pred = block->preds[p];
+            if (ir_dom_reachable(dom, pred) && !ir_dom_dominates(dom, b, pred)) waiting[b]++;
+        }
+    }
+
+    // ready[l + 1]是循环l中就绪的块(ready[0]为不在循环中的块), 作栈用, 共用next链
+    int32_t* ready = int_array(loops->loop_count + 1, -1);
+    int32_t* next = int_array(n, -1);
+    alloc->order = int_array(dom->rpo_count, -1);
+    alloc->order_count = 0;
+
+    int current = 0;
+    int context = -1;
+    while (current >= 0) {
+        alloc->order[alloc->order_count++] = current;
+        context = loops->block_loop[current];
+
+        const IRBlock* block = &function->blocks[current];
+        for (int s = 0; s < block->succ_count; s++) {
+            int succ = block->succs[s];
+            if (ir_dom_dominates(dom, succ, current) || --waiting[succ] > 0) continue;
+            int loop = loops->block_loop[succ];
+            if (loop >= 0 && loops->loops[loop].header == succ) loop = loops->loops[loop].parent;
+            next[succ] = ready[loop + 1];
+            ready[loop + 1] = succ;
+        }
+
+        current = -1;
+        for (int l = context; current < 0; l = loops->loops[l].parent) {
+            if (ready[l + 1] >= 0) {
+                current = ready[l + 1];
+                ready[l + 1] = next[current];
+            }
+            if (l < 0) break;
+        }
+    }
+
+    free(waiting);
+    free(ready);
+    free(next);
+}
+
+static void number_instructions(IRRegAlloc* alloc, const IRFunction* function) {
+    int32_t pos = PARAM_POS + 1;
+    for (int r = 0; r < alloc->order_count; r++) {
+        int b = alloc->order[r];
+        const IRBlock* block = &function->blocks[b];
+        alloc->block_from[b] = pos;
+        pos += 2;
+        for (int i = 0; i < block->instr_count; i++) {
+            int id = block->instrs[i];
+            if (function->instrs[id].op == IR_PHI) {
+                alloc->instr_pos[id] = alloc->block_from[b];
+            } else {
+                alloc->instr_pos[id] = pos;
+                pos += 2;
+            }
+        }
+        alloc->block_to[b] = pos - 1;
+    }
+}
+
+// ========== 活跃区间 ==========
+
+// 稀疏集合: 可以O(1)加入、删除和清空
+typedef struct LiveSet {
+    int32_t* members;
+    int32_t* index;     // 虚拟寄存器在members中的位置, -1表示不在集合中
+    int count;
+} LiveSet;
+
+static void live_add(LiveSet* set, int v) {
+    if (set->index[v] >= 0) return;
+    set->index[v] = set->count;
+    set->members[set->count++] = v;
+}
+
+static void live_remove(LiveSet* set, int v) {
+    int i = set->index[v];
+    if (i < 0) return;
+    int last = set->members[--set->count];
+    set->members[i] = last;
+    set->index[last] = i;
+    set->index[v] = -1;
+}
+
+static void live_clear(LiveSet* set) {
+    for (int i = 0; i < set->count; i++) set->index[set->members[i]] = -1;
+    set->count = 0;
+}
+
+static void extend(IRInterval* interval, int32_t pos) {
+    if (interval->start < 0) {
+        interval->start = pos;
+        interval->end = pos;
+        return;
+    }
+    if (pos < interval->start) interval->start = pos;
+    if (pos > interval->end) interval->end = pos;
+}
+
+static void build_intervals(IRRegAlloc* alloc, const IRFunction* function, const IRLoopInfo* loops) {
+    IRInterval* intervals = alloc->intervals;
+    int n = function->block_count;
+
+    // 循环头 → 循环中最后一个块的块尾
+    int32_t* loop_end = int_array(n, -1);
+    for (int l = 0; l < loops->loop_count; l++) {
+        const IRLoop* loop = &loops->loops[l];
+        int32_t end = -1;
+        for (int i = 0; i < loop->block_count; i++) {
+            int32_t to = alloc->block_to[loops->blocks[loop->block_start + i]];
+            if (to > end) end = to;
+        }
+        if (end > loop_end[loop->header]) loop_end[loop->header] = end;
+    }
+
+    LiveSet live;
+    live.members = int_array(function->vreg_count, -1);
+    live.index = int_array(function->vreg_count, -1);
+    live.count = 0;
+
+    // 各块入口活跃的虚拟寄存器, 连续存放在pool中
+    int32_t* in_start = int_array(n, 0);
+    int32_t* in_count = int_array(n, 0);
+    int32_t* pool = NULL;
+    size_t pool_count = 0;
+    size_t pool_capacity = 0;
+
+    // 逆序处理, 前向边的后继已经处理过; 回边的后继(循环头)由循环延长补上
+    for (int r = alloc->order_count - 1; r >= 0; r--) {
+        int b = alloc->order[r];
+        const IRBlock* block = &function->blocks[b];
+        live_clear(&live);
+
+        for (int s = 0; s < block->succ_count; s++) {
+            int succ = block->succs[s];
+            if (alloc->block_from[succ] > alloc->block_from[b]) {
+                for (int i = 0; i < in_count[succ]; i++) live_add(&live, pool[in_start[succ] + i]);
+            }
+            const IRBlock* target = &function->blocks[succ];
+            for (int i = 0; i < target->instr_count; i++) {
+                const IRInstr* phi = &function->instrs[target->instrs[i]];
+                if (phi->op != IR_PHI) break;
+                const IROperand* args = &function->operands[phi->args];
+                for (int a = 0; a + 1 < phi->arg_count; a += 2) {
+                    if (args[a].value == b && args[a + 1].kind == IR_OPERAND_VREG) {
+                        live_add(&live, args[a + 1].value);
+                    }
+                }
+            }
+        }
+        for (int i = 0; i < live.count; i++) extend(&intervals[live.members[i]], alloc->block_to[b]);
+
+        for (int i = block->instr_count - 1; i >= 0; i--) {
+            int id = block->instrs[i];
+            const IRInstr* instr = &function->instrs[id];
+            if (instr->op == IR_PHI) {
+                live_remove(&live, instr->dest);
+                extend(&intervals[instr->dest], alloc->block_from[b] + 1);
+                continue;
+            }
+            // 向量值只在块内使用, 由指令选择放在向量寄存器中, 不参与分配
+            int32_t pos = alloc->instr_pos[id];
+            if (instr->dest >= 0 && instr->type != IR_TYPE_V4I32) {
+                extend(&intervals[instr->dest], pos + 1);
+                live_remove(&live, instr->dest);
+            }
+            const IROperand* args = &function->operands[instr->args];
+            for (int a = 0; a < instr->arg_count; a++) {
+                if (args[a].kind != IR_OPERAND_VREG || args[a].type == IR_TYPE_V4I32) continue;
+                extend(&intervals[args[a].value], pos);
+                live_add(&live, args[a].value);
+            }
+        }
+
+        for (int i = 0; i < live.count; i++) {
+            IRInterval* interval = &intervals[live.members[i]];
+            extend(interval, alloc->block_from[b]);
+            if (loop_end[b] >= 0) extend(interval, loop_end[b]);
+        }
+
+        if (pool_count + (size_t)live.count > pool_capacity) {
+            while (pool_count + (size_t)live.count > pool_capacity) {
+                pool_capacity = pool_capacity ? pool_capacity * 2 : 256;
+            }
+            pool = (int32_t*)realloc(pool, sizeof(int32_t) * pool_capacity);
+            if (!pool) {
+                perror("malloc failed for live sets");
+                exit(1);
+            }
+        }
+        in_start[b] = (int32_t)pool_count;
+        in_count[b] = live.count;
+        if (live.count == 0) continue;
+        memcpy(&pool[pool_count], live.members, sizeof(int32_t) * (size_t)live.count);
+        pool_count += (size_t)live.count;
+    }
+
+    // 参数在入口之前到达
+    for (int v = 0; v < function->param_count && v < function->vreg_count; v++) {
+        if (intervals[v].start >= 0) extend(&intervals[v], PARAM_POS);
+    }
+
+    free(loop_end);
+    free(live.members);
+    free(live.index);
+    free(in_start);
+    free(in_count);
+    free(pool);
+}
+
+// ========== 线性扫描 ==========
+
+typedef struct Scan {
+    IRRegAlloc* alloc;
+    const int32_t* calls;   // 调用指令的位置, 升序
+    int call_count;
+} Scan;
+
+// 区间内部(不含两端)是否有调用: 作为参数使用和作为返回值定义都不算跨过
+static bool crosses_call(const Scan* scan, const IRInterval* interval) {
+    int lo = 0;
+    int hi = scan->call_count;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (scan->calls[mid] <= interval->start) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo < scan->call_count && scan->calls[lo] < interval->end;
+}
+
+static int pick_register(const IRRegTarget* target, uint32_t available, bool prefer_caller_saved) {
+    if (prefer_caller_saved) {
+        for (int i = 0; i < target->reg_count; i++) {
+            int reg = target->regs[i];
+            if ((available >> reg & 1) && !(target->callee_saved >> reg & 1)) return reg;
+        }
+    }
+    for (int i = 0; i < target->reg_count; i++) {
+        int reg = target->regs[i];
+        if (available >> reg & 1) return reg;
+    }
+    return -1;
+}
+
+static void spill_from(IRRegAlloc* alloc, IRInterval* interval, int32_t pos) {
+    interval->split = pos;
+    if (interval->slot < 0) interval->slot = alloc->slot_count++;
+    if (pos <= interval->start) interval->reg = -1;
+}
+
+static void linear_scan(IRRegAlloc* alloc, const Scan* scan) {
+    const IRRegTarget* target = alloc->target;
+    IRInterval* intervals = alloc->intervals;
+
+    // 按起点桶排序
+    int32_t max_pos = 0;
+    int count = 0;
+    for (int v = 0; v < alloc->vreg_count; v++) {
+        if (intervals[v].start < 0) continue;
+        if (intervals[v].end > max_pos) max_pos = intervals[v].end;
+        count++;
+    }
+    int32_t* bucket = int_array(max_pos + 2, 0);
+    for (int v = 0; v < alloc->vreg_count; v++) {
+        if (intervals[v].start >= 0) bucket[intervals[v].start + 1]++;
+    }
+    for (int p = 0; p <= max_pos; p++) bucket[p + 1] += bucket[p];
+    int32_t* sorted = int_array(count, -1);
+    for (int v = 0; v < alloc->vreg_count; v++) {
+        if (intervals[v].start >= 0) sorted[bucket[intervals[v].start]++] = v;
+    }
+    free(bucket);
+
+    uint32_t all = 0;
+    for (int i = 0; i < target->reg_count; i++) all |= 1u << target->regs[i];
+    uint32_t free_regs = all;
+    int32_t active[32];
+    int active_count = 0;
+
+    for (int k = 0; k < count; k++) {
+        int v = sorted[k];
+        IRInterval* current = &intervals[v];
+        int32_t start = current->start;
+
+        // 终点在当前起点之前的区间释放寄存器
+        int kept = 0;
+        for (int i = 0; i < active_count; i++) {
+            IRInterval* other = &intervals[active[i]];
+            if (other->end < start) {
+                free_regs |= 1u << other->reg;
+            } else {
+                active[kept++] = active[i];
+            }
+        }
+        active_count = kept;
+
+        bool crosses = crosses_call(scan, current);
+        uint32_t allowed = crosses ? (all & target->callee_saved) : all;
+        int reg = pick_register(target, free_regs & allowed, !crosses);
+        if (reg >= 0) {
+            current->reg = (int8_t)reg;
+            free_regs &= ~(1u << reg);
+            active[active_count++] = v;
+            alloc->used_regs |= 1u << reg;
+            continue;
+        }
+
+        // 没有空闲寄存器: 终点最远的区间让出寄存器
+        int victim = -1;
+        for (int i = 0; i < active_count; i++) {
+            IRInterval* other = &intervals[active[i]];
+            if (!(allowed >> other->reg & 1)) continue;
+            if (victim < 0 || other->end > intervals[active[victim]].end) victim = i;
+        }
+        if (victim >= 0 && intervals[active[victim]].end > current->end) {
+            IRInterval* other = &intervals[active[victim]];
+            current->reg = other->reg;
+            spill_from(alloc, other, start);
+            if (other->reg >= 0) alloc->stats.split++;
+            else alloc->stats.spilled++;
+            active[victim] = v;
+        } else {
+            spill_from(alloc, current, start);
+            alloc->stats.spilled++;
+        }
+    }
+    alloc->stats.intervals += count;
+    free(sorted);
+}
+
+// ========== 边上的复制 ==========
+
+static IRLoc location_at(const IRRegAlloc* alloc, int vreg, int32_t pos) {
+    const IRInterval* interval = &alloc->intervals[vreg];
+    if (interval->start < 0) return make_loc(IR_LOC_NONE, 0);
+    if (interval->reg >= 0 && pos < interval->split) return make_loc(IR_LOC_REG, interval->reg);
+    return make_loc(IR_LOC_STACK, interval->slot);
+}
+
+// 先做目标不再被读的复制, 剩下的都在环上, 把一个目标的旧值存入scratch后断开
+void ir_regalloc_sequentialize(const IRRegTarget* target, IRMove* moves, int count, IRMoveList* out) {
+    int remaining = 0;
+    for (int i = 0; i < count; i++) {
+        if (!loc_equal(moves[i].src, moves[i].dst)) moves[remaining++] = moves[i];
+    }
+    IRLoc scratch = make_loc(IR_LOC_REG, target->scratch);
+
+    while (remaining > 0) {
+        bool progress = false;
+        for (int i = 0; i < remaining; i++) {
+            bool blocked = false;
+            for (int j = 0; j < remaining && !blocked; j++) {
+                blocked = j != i && loc_equal(moves[j].src, moves[i].dst);
+            }
+            if (blocked) continue;
+            move_list_add(out, moves[i].src, moves[i].dst);
+            moves[i] = moves[--remaining];
+            progress = true;
+            break;
+        }
+        if (progress) continue;
+
+        IRLoc saved = moves[0].dst;
+        move_list_add(out, saved, scratch);
+        for (int j = 0; j < remaining; j++) {
+            if (loc_equal(moves[j].src, saved)) moves[j].src = scratch;
+        }
+    }
+}
+
+typedef struct SplitEntry {
+    int32_t split;
+    int32_t vreg;
+} SplitEntry;
+
+static int compare_split(const void* a, const void* b) {
+    int32_t x = ((const SplitEntry*)a)->split;
+    int32_t y = ((const SplitEntry*)b)->split;
+    return (x > y) - (x < y);
+}
+
+static void resolve_edges(IRRegAlloc* alloc, const IRFunction* function) {
+    // 被拆分且拆分前在寄存器中的区间, 按拆分点排序
+    SplitEntry* split = (SplitEntry*)ra_alloc(sizeof(SplitEntry) * (size_t)(alloc->vreg_count + 1));
+    int split_count = 0;
+    for (int v = 0; v < alloc->vreg_count; v++) {
+        const IRInterval* interval = &alloc->intervals[v];
+        if (interval->start >= 0 && interval->reg >= 0 && interval->split != NO_SPLIT) {
+            split[split_count].split = interval->split;
+            split[split_count++].vreg = v;
+        }
+    }
+    qsort(split, (size_t)split_count, sizeof(SplitEntry), compare_split);
+
+    IRMove* moves = NULL;
+    int capacity = 0;
+    for (int r = 0; r < alloc->order_count; r++) {
+        int from = alloc->order[r];
+        const IRBlock* block = &function->blocks[from];
+        int32_t from_end = alloc->block_to[from];
+
+        for (int s = 0; s < block->succ_count; s++) {
+            int to = block->succs[s];
+            int32_t to_start = alloc->block_from[to];
+            const IRBlock* target = &function->blocks[to];
+            int count = 0;
+            int needed = split_count;
+            for (int i = 0; i < target->instr_count; i++) {
+                const IRInstr* phi = &function->instrs[target->instrs[i]];
+                if (phi->op != IR_PHI) break;
+                needed += 2;
+            }
+            if (needed > capacity) {
+                capacity = needed * 2;
+                moves = (IRMove*)realloc(moves, sizeof(IRMove) * (size_t)capacity);
+                if (!moves) {
+                    perror("malloc failed for IRMove");
+                    exit(1);
+                }
+            }
+
+            for (int i = 0; i < target->instr_count; i++) {
+                const IRInstr* phi = &function->instrs[target->instrs[i]];
+                if (phi->op != IR_PHI) break;
+                const IRInterval* dest = &alloc->intervals[phi->dest];
+                IROperand input = { IR_OPERAND_NONE, IR_TYPE_VOID, 0 };
+                const IROperand* args = &function->operands[phi->args];
+                for (int a = 0; a + 1 < phi->arg_count; a += 2) {
+                    if (args[a].value == from) input = args[a + 1];
+                }
+                IRLoc src;
+                if (input.kind == IR_OPERAND_CONST) {
+                    src = make_loc(IR_LOC_CONST, input.value);
+                } else if (input.kind == IR_OPERAND_VREG) {
+                    src = location_at(alloc, input.value, from_end);
+                } else {
+                    continue;
+                }
+                if (dest->start < 0 || src.kind == IR_LOC_NONE) continue;
+                if (dest->reg >= 0) {
+                    moves[count].src = src;
+                    moves[count++].dst = make_loc(IR_LOC_REG, dest->reg);
+                }
+                if (dest->split != NO_SPLIT) {
+                    moves[count].src = src;
+                    moves[count++].dst = make_loc(IR_LOC_STACK, dest->slot);
+                }
+            }
+
+            // 回边: 拆分点之后跳回拆分点之前, 寄存器里的值要从溢出槽重新装入。
+            // 循环头的第一次使用在to_start + 2, 拆分点不晚于它的值在循环中不再从寄存器读,
+            // 寄存器可能已经分给了循环头的phi; 只需看拆分点在(to_start + 2, from_end]中的区间
+            if (to_start < from_end) {
+                int lo = 0;
+                int hi = split_count;
+                while (lo < hi) {
+                    int mid = (lo + hi) / 2;
+                    if (split[mid].split <= to_start + 2) lo = mid + 1;
+                    else hi = mid;
+                }
+                for (int i = lo; i < split_count; i++) {
+                    if (split[i].split > from_end) break;
+                    const IRInterval* interval = &alloc->intervals[split[i].vreg];
+                    if (interval->start < to_start && interval->end >= to_start) {
+                        moves[count].src = make_loc(IR_LOC_STACK, interval->slot);
+                        moves[count++].dst = make_loc(IR_LOC_REG, interval->reg);
+                    }
+                }
+            }
+            if (count == 0) continue;
+
+            // 关键边已拆分: 起点只有一个后继时放在起点末尾, 否则终点只有一个前驱
+            IRMoveList* list = block->succ_count == 1 ? &alloc->moves_out[from] : &alloc->moves_in[to];
+            int before = list->count;
+            ir_regalloc_sequentialize(alloc->target, moves, count, list);
+            alloc->stats.moves += list->count - before;
+        }
+    }
+    free(moves);
+    free(split);
+}
+
+// ========== 接口 ==========
+
+IRRegAlloc* ir_regalloc_create(IRFunction* function, const IRRegTarget* target) {
+    IRRegAlloc* alloc = (IRRegAlloc*)calloc(1, sizeof(IRRegAlloc));
+    if (!alloc) {
+        perror("malloc failed for IRRegAlloc");
+        exit(1);
+    }
+    alloc->target = target;
+    if (function->is_defined && function->block_count > 0) {
+        ir_function_split_critical_edges(function);
+    }
+
+    alloc->vreg_count = function->vreg_count;
+    alloc->intervals = (IRInterval*)ra_alloc(sizeof(IRInterval) * (size_t)(function->vreg_count + 1));
+    for (int v = 0; v < function->vreg_count; v++) {
+        IRInterval* interval = &alloc->intervals[v];
+        interval->start = -1;
+        interval->end = -1;
+        interval->split = NO_SPLIT;
+        interval->slot = -1;
+        interval->reg = -1;
+    }
+    alloc->instr_pos = int_array(function->instr_count, -1);
+    alloc->block_count = function->block_count;
+    alloc->block_from = int_array(function->block_count, -1);
+    alloc->block_to = int_array(function->block_count, -1);
+    alloc->moves_out = (IRMoveList*)calloc((size_t)function->block_count + 1, sizeof(IRMoveList));
+    alloc->moves_in = (IRMoveList*)calloc((size_t)function->block_count + 1, sizeof(IRMoveList));
+    if (!alloc->moves_out || !alloc->moves_in) {
+        perror("malloc failed for IRMoveList");
+        exit(1);
+    }
+    if (!function->is_defined || function->block_count == 0) {
+        alloc->order = int_array(0, -1);
+        return alloc;
+    }
+
+    IRDomTree* dom = ir_dom_tree_create(function);
+    IRLoopInfo* loops = ir_loop_info_create(function, dom);
+    compute_block_order(alloc, function, dom, loops);
+    number_instructions(alloc, function);
+    build_intervals(alloc, function, loops);
+
+    Scan scan;
+    int32_t* calls = int_array(function->instr_count, -1);
+    scan.alloc = alloc;
+    scan.calls = calls;
+    scan.call_count = 0;
+    for (int r = 0; r < alloc->order_count; r++) {
+        const IRBlock* block = &function->blocks[alloc->order[r]];
+        for (int i = 0; i < block->instr_count; i++) {
+            int id = block->instrs[i];
+            if (function->instrs[id].op == IR_CALL) calls[scan.call_count++] = alloc->instr_pos[id];
+        }
+    }
+    linear_scan(alloc, &scan);
+    resolve_edges(alloc, function);
+
+    free(calls);
+    ir_loop_info_destroy(loops);
+    ir_dom_tree_destroy(dom);
+    return alloc;
+}
+
+void ir_regalloc_destroy(IRRegAlloc* alloc) {
+    if (!alloc) return;
+
+    for (int b = 0; b < alloc->block_count; b++) {
+        free(alloc->moves_out[b].moves);
+        free(alloc->moves_in[b].moves);
+    }
+    free(alloc->moves_out);
+    free(alloc->moves_in);
+    free(alloc->intervals);
+    free(alloc->instr_pos);
+    free(alloc->block_from);
+    free(alloc->block_to);
+    free(alloc->order);
+    free(alloc);
+}
+
+IRLoc ir_regalloc_use(const IRRegAlloc* alloc, IROperand operand, int instr) {
+    if (operand.kind == IR_OPERAND_CONST) return make_loc(IR_LOC_CONST, operand.value);
+    if (operand.kind != IR_OPERAND_VREG) return make_loc(IR_LOC_NONE, 0);
+    return location_at(alloc, operand.value, alloc->instr_pos[instr]);
+}
+
+IRLoc ir_regalloc_def(const IRRegAlloc* alloc, int vreg) {
+    const IRInterval* interval = &alloc->intervals[vreg];
+    if (interval->start < 0) return make_loc(IR_LOC_NONE, 0);
+    if (interval->reg >= 0) return make_loc(IR_LOC_REG, interval->reg);
+    return make_loc(IR_LOC_STACK, interval->slot);
+}
+
+bool ir_regalloc_spill_at_def(const IRRegAlloc* alloc, int vreg) {
+    const IRInterval* interval = &alloc->intervals[vreg];
+    return interval->start >= 0 && interval->reg >= 0 && interval->split != NO_SPLIT;
+}
+
+void ir_regalloc_stats_add(IRRegAllocStats* total, const IRRegAllocStats* stats) {
+    total->intervals += stats->intervals;
+    total->spilled += stats->spilled;
+    total->split += stats->split;
+    total->moves += stats->moves;
+}
+
+// ========== 输出 ==========
+
+static void print_loc(FILE* out, const IRRegAlloc* alloc, IRLoc loc) {
+    switch (loc.kind) {
+        case IR_LOC_REG:   fprintf(out, "%%%s", alloc->target->names[loc.value]); break;
+        case IR_LOC_STACK: fprintf(out, "[s%d]", loc.value); break;
+        case IR_LOC_CONST: fprintf(out, "%d", loc.value); break;
+        default:           fprintf(out, "-"); break;
+    }
+}
+
+static void print_moves(FILE* out, const IRRegAlloc* alloc, const char* where, int block,
+                        const IRMoveList* list) {
+    if (list->count == 0) return;
+    fprintf(out, "  bb%d %s:", block, where);
+    for (int i = 0; i < list->count; i++) {
+        fprintf(out, i ? ", " : " ");
+        print_loc(out, alloc, list->moves[i].dst);
+        fprintf(out, " <- ");
+        print_loc(out, alloc, list->moves[i].src);
+    }
+    fprintf(out, "\n");
+}
+
+void ir_regalloc_print(FILE* out, const IRFunction* function, const IRRegAlloc* alloc) {
+    fprintf(out, "寄存器分配 %s: 区间 %d 个, 溢出 %d 个, 拆分 %d 个, 溢出槽 %d 个, 边上复制 %d 条\n",
+            function->name, alloc->stats.intervals, alloc->stats.spilled, alloc->stats.split,
+            alloc->slot_count, alloc->stats.moves);
+    for (int v = 0; v < alloc->vreg_count; v++) {
+        const IRInterval* interval = &alloc->intervals[v];
+        if (interval->start < 0) continue;
+        fprintf(out, "  %%%d [%d, %d] ", v, interval->start, interval->end);
+        if (interval->reg >= 0) {
+            fprintf(out, "%%%s", alloc->target->names[interval->reg]);
+            if (interval->split != NO_SPLIT) {
+                fprintf(out, ", 从 %d 起 [s%d]", interval->split, interval->slot);
+            }
+        } else {
+            fprintf(out, "[s%d]", interval->slot);
+        }
+        fprintf(out, "\n");
+    }
+    for (int r = 0; r < alloc->order_count; r++) {
+        int b = alloc->order[r];
+        print_moves(out, alloc, "入口", b, &alloc->moves_in[b]);
+        print_moves(out, alloc, "出口", b, &alloc->moves_out[b]);
+    }
+}
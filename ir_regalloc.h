@@ -0,0 +1,110 @@
+#ifndef IR_REGALLOC_H
+#define IR_REGALLOC_H
+
+#include "ir.h"
+#include <stdio.h>
+#include <stdint.h>
+
+// ========== 线性扫描寄存器分配 ==========
+//
+// 直接在SSA形式上分配(Poletto-Sarkar线性扫描):
+//   1. 拆分关键边, 把块排成拓扑顺序(同一循环的块连续)后依次编号: 块首占一个位置,
+//      每条指令占两个, 使用在偶数位置, 定义在其后的奇数位置, phi定义在块首之后
+//   2. 逆序扫描各块求活跃性, 每个虚拟寄存器得到一个活跃区间[start, end];
+//      活跃到循环头的值延长到整个循环结束
+//   3. 按起点依次分配, 区间跨过调用时只用被调用者保存的寄存器;
+//      没有空闲寄存器时, 终点最远的活跃区间在当前位置拆分: 之前仍在寄存器中,
+//      之后改用栈上的溢出槽; 当前区间自己终点最远时整个溢出
+//   4. 被拆分/溢出的值在定义处同时写入溢出槽, 所以槽中总是最新值;
+//      只有从拆分点之后跳回拆分点之前(循环回边)时要在边上从槽重新装入寄存器
+//
+// phi和上面的装入都表示为控制流边上的并行复制, 已经按顺序排好(必要时经target->scratch
+// 打破环), 放在起点块的终结指令之前(起点只有一个后继时)或终点块的开头。
+// 溢出的操作数由指令选择用不参与分配的寄存器临时装入。
+
+// 目标机器的寄存器描述
+typedef struct IRRegTarget {
+    int reg_count;              // 可分配的寄存器数
+    const int8_t* regs;         // 可分配的物理寄存器编号, 按优先顺序
+    uint32_t callee_saved;      // 被调用者保存的物理寄存器(按编号的位)
+    int8_t scratch;             // 不参与分配, 用于打破并行复制的环
+    const char* const* names;   // 物理寄存器名, 按编号
+} IRRegTarget;
+
+typedef enum {
+    IR_LOC_NONE,
+    IR_LOC_REG,     // 物理寄存器
+    IR_LOC_STACK,   // 溢出槽
+    IR_LOC_CONST    // 立即数
+} IRLocKind;
+
+typedef struct IRLoc {
+    uint8_t kind;       // IRLocKind
+    int32_t value;      // 寄存器编号/溢出槽编号/常量值
+} IRLoc;
+
+// 一个虚拟寄存器的活跃区间及分配结果
+typedef struct IRInterval {
+    int32_t start;      // -1表示没有用到
+    int32_t end;
+    int32_t split;      // 从这个位置起在溢出槽中; INT32_MAX表示一直在寄存器中
+    int32_t slot;       // 溢出槽, -1表示没有
+    int8_t reg;         // 拆分点之前所在的寄存器, -1表示整个区间都在溢出槽中
+} IRInterval;
+
+typedef struct IRMove {
+    IRLoc src;
+    IRLoc dst;
+} IRMove;
+
+typedef struct IRMoveList {
+    IRMove* moves;      // 按执行顺序
+    int count;
+    int capacity;
+} IRMoveList;
+
+typedef struct IRRegAllocStats {
+    int intervals;      // 活跃区间数
+    int spilled;        // 整个溢出的区间数
+    int split;          // 拆分的区间数
+    int moves;          // 边上的复制数
+} IRRegAllocStats;
+
+typedef struct IRRegAlloc {
+    const IRRegTarget* target;
+    int vreg_count;
+    IRInterval* intervals;  // 按虚拟寄存器编号
+
+    int32_t* instr_pos;     // 指令的位置, 不可达的为-1
+    int block_count;
+    int32_t* block_from;    // 块首位置
+    int32_t* block_to;      // 块尾位置(最后一条指令之后)
+    int32_t* order;         // 代码中块的排列顺序, 不含不可达块
+    int order_count;
+
+    IRMoveList* moves_out;  // 在块的终结指令之前执行
+    IRMoveList* moves_in;   // 在块首执行
+
+    int slot_count;         // 溢出槽数
+    uint32_t used_regs;     // 分配出去的物理寄存器(按编号的位)
+    IRRegAllocStats stats;
+} IRRegAlloc;
+
+// 为函数分配寄存器; 会拆分关键边(修改控制流图), 之后直到释放前不能再修改函数
+IRRegAlloc* ir_regalloc_create(IRFunction* function, const IRRegTarget* target);
+void ir_regalloc_destroy(IRRegAlloc* alloc);
+
+// 指令instr读取operand时它所在的位置(常量返回IR_LOC_CONST)
+IRLoc ir_regalloc_use(const IRRegAlloc* alloc, IROperand operand, int instr);
+// 定义vreg时写入的位置: 有寄存器时为寄存器, 否则为溢出槽; 没有用到时为IR_LOC_NONE
+IRLoc ir_regalloc_def(const IRRegAlloc* alloc, int vreg);
+// 定义vreg之后是否还要把值写入溢出槽(被拆分的区间)
+bool ir_regalloc_spill_at_def(const IRRegAlloc* alloc, int vreg);
+
+// 把并行复制moves排成顺序复制追加到out(会修改moves); 环经target->scratch打破
+void ir_regalloc_sequentialize(const IRRegTarget* target, IRMove* moves, int count, IRMoveList* out);
+
+void ir_regalloc_stats_add(IRRegAllocStats* total, const IRRegAllocStats* stats);
+void ir_regalloc_print(FILE* out, const IRFunction* function, const IRRegAlloc* alloc);
+
+#endif // IR_REGALLOC_H
@@ -0,0 +1,425 @@
+#include "ir_sccp.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+// ========== 格 ==========
+
+typedef enum {
+    LATTICE_TOP,        // 还没有求值(可能是任何常量)
+    LATTICE_CONST,      // 确定是常量
+    LATTICE_BOTTOM      // 不是常量
+} LatticeState;
+
+typedef struct LatticeValue {
+    uint8_t state;
+    int32_t value;
+} LatticeValue;
+
+static const LatticeValue lattice_top = { LATTICE_TOP, 0 };
+static const LatticeValue lattice_bottom = { LATTICE_BOTTOM, 0 };
+
+static LatticeValue lattice_const(int32_t value) {
+    LatticeValue result = { LATTICE_CONST, value };
+    return result;
+}
+
+static LatticeValue lattice_meet(LatticeValue a, LatticeValue b) {
+    if (a.state == LATTICE_TOP) return b;
+    if (b.state == LATTICE_TOP) return a;
+    if (a.state == LATTICE_CONST && b.state == LATTICE_CONST && a.value == b.value) return a;
+    return lattice_bottom;
+}
+
+// ========== 工作表 ==========
+
+typedef struct IntList {
+    int* items;
+    int count;
+    int capacity;
+} IntList;
+
+static void list_push(IntList* list, int item) {
+    if (list->count == list->capacity) {
+        list->capacity = list->capacity > 0 ? list->capacity * 2 : 64;
+        list->items = (int*)realloc(list->items, sizeof(int) * (size_t)list->capacity);
+        if (!list->items) {
+            perror("realloc failed for IntList");
+            exit(1);
+        }
+    }
+    list->items[list->count++] = item;
+}
+
+typedef struct SCCP {
+    IRFunction* function;
+    IRUses* uses;
+    LatticeValue* values;   // 每个虚拟寄存器的格值
+    bool* block_exec;       // 基本块是否可执行
+    bool* edge_exec;        // 控制流边是否可执行, 下标为 block*2 + 后继序号
+    IntList flow_work;      // 待处理的控制流边
+    IntList ssa_work;       // 格值下降了的虚拟寄存器
+} SCCP;
+
+static void* sccp_alloc(size_t size) {
+    void* ptr = calloc(1, size > 0 ? size : 1);
+    if (!ptr) {
+        perror("calloc failed for SCCP");
+        exit(1);
+    }
+    return ptr;
+}
+
+// ========== 求值 ==========
+
+static LatticeValue operand_value(const SCCP* sccp, IROperand operand) {
+    if (operand.kind == IR_OPERAND_CONST) return lattice_const(operand.value);
+    if (operand.kind == IR_OPERAND_VREG) return sccp->values[operand.value];
+    return lattice_bottom;
+}
+
+// 按32位补码回绕计算; 除零和溢出的除法不折叠, 留到运行时
+static LatticeValue fold_binary(IROpcode op, int32_t a, int32_t b) {
+    uint32_t ua = (uint32_t)a;
+    uint32_t ub = (uint32_t)b;
+    switch (op) {
+        case IR_ADD: return lattice_const((int32_t)(ua + ub));
+        case IR_SUB: return lattice_const((int32_t)(ua - ub));
+        case IR_MUL: return lattice_const((int32_t)(ua * ub));
+        case IR_DIV:
+            if (b == 0 || (a == INT32_MIN && b == -1)) return lattice_bottom;
+            return lattice_const(a / b);
+        case IR_MOD:
+            if (b == 0 || (a == INT32_MIN && b == -1)) return lattice_bottom;
+            return lattice_const(a % b);
+        case IR_SHL: return lattice_const((int32_t)(ua << (ub & 31)));
+        case IR_SHR: return lattice_const(a >> (ub & 31));
+        case IR_AND: return lattice_const(a & b);
+        case IR_EQ: return lattice_const(a == b);
+        case IR_NE: return lattice_const(a != b);
+        case IR_LT: return lattice_const(a < b);
+        case IR_LE: return lattice_const(a <= b);
+        case IR_GT: return lattice_const(a > b);
+        case IR_GE: return lattice_const(a >= b);
+        default: return lattice_bottom;
+    }
+}
+
+static bool edge_executable(const SCCP* sccp, int from, int to) {
+    const IRBlock* block = &sccp->function->blocks[from];
+    for (int s = 0; s < block->succ_count; s++) {
+        if (block->succs[s] == to && sccp->edge_exec[from * 2 + s]) return true;
+    }
+    return false;
+}
+
+static LatticeValue evaluate(const SCCP* sccp, const IRInstr* instr) {
+    IRFunction* function = sccp->function;
+    const IROperand* args = ir_instr_args(function, instr);
+
+    switch ((IROpcode)instr->op) {
+        case IR_PHI: {
+            LatticeValue result = lattice_top;
+            for (int a = 0; a + 1 < instr->arg_count; a += 2) {
+                if (edge_executable(sccp, args[a].value, instr->block)) {
+                    result = lattice_meet(result, operand_value(sccp, args[a + 1]));
+                }
+            }
+            return result;
+        }
+        case IR_NEG:
+        case IR_NOT:
+        case IR_ZEXT:
+        case IR_COPY: {
+            LatticeValue a = operand_value(sccp, args[0]);
+            if (a.state != LATTICE_CONST) return a;
+            if (instr->op == IR_NEG) return lattice_const((int32_t)(0u - (uint32_t)a.value));
+            if (instr->op == IR_NOT) return lattice_const(a.value == 0);
+            return a;
+        }
+        case IR_ADD: case IR_SUB: case IR_MUL: case IR_DIV: case IR_MOD:
+        case IR_SHL: case IR_SHR: case IR_AND:
+        case IR_EQ: case IR_NE: case IR_LT: case IR_LE: case IR_GT: case IR_GE: {
+            LatticeValue a = operand_value(sccp, args[0]);
+            LatticeValue b = operand_value(sccp, args[1]);
+            // x * 0 和 x & 0 不管x是什么都是0
+            if ((instr->op == IR_MUL || instr->op == IR_AND) &&
+                ((a.state == LATTICE_CONST && a.value == 0) || (b.state == LATTICE_CONST && b.value == 0))) {
+                return lattice_const(0);
+            }
+            if (a.state == LATTICE_BOTTOM || b.state == LATTICE_BOTTOM) return lattice_bottom;
+            if (a.state == LATTICE_TOP || b.state == LATTICE_TOP) return lattice_top;
+            return fold_binary((IROpcode)instr->op, a.value, b.value);
+        }
+        default:
+            // load、call、addr的结果在编译时未知
+            return lattice_bottom;
+    }
+}
+
+static void mark_edge(SCCP* sccp, int from, int succ_index) {
+    if (!sccp->edge_exec[from * 2 + succ_index]) {
+        list_push(&sccp->flow_work, from * 2 + succ_index);
+    }
+}
+
+static void visit_instr(SCCP* sccp, int id) {
+    IRFunction* function = sccp->function;
+    IRInstr* instr = &function->instrs[id];
+    if (instr->op == IR_NOP) return;
+
+    if (instr->dest >= 0) {
+        LatticeValue old = sccp->values[instr->dest];
+        if (old.state == LATTICE_BOTTOM) return;
+
+        LatticeValue value = evaluate(sccp, instr);
+        if (old.state == LATTICE_CONST && value.state != LATTICE_BOTTOM) {
+            value = lattice_meet(old, value);   // 格值只能下降
+        }
+        if (value.state != old.state || value.value != old.value) {
+            sccp->values[instr->dest] = value;
+            list_push(&sccp->ssa_work, instr->dest);
+        }
+        return;
+    }
+
+    IRBlock* block = &function->blocks[instr->block];
+    const IROperand* args = ir_instr_args(function, instr);
+    if (instr->op == IR_JMP) {
+        mark_edge(sccp, instr->block, 0);
+    } else if (instr->op == IR_BR) {
+        LatticeValue cond = operand_value(sccp, args[0]);
+        if (cond.state == LATTICE_BOTTOM) {
+            for (int s = 0; s < block->succ_count; s++) {
+                mark_edge(sccp, instr->block, s);
+            }
+        } else if (cond.state == LATTICE_CONST) {
+            int target = cond.value ? args[1].value : args[2].value;
+            for (int s = 0; s < block->succ_count; s++) {
+                if (block->succs[s] == target) mark_edge(sccp, instr->block, s);
+            }
+        }
+    }
+}
+
+static void propagate(SCCP* sccp) {
+    IRFunction* function = sccp->function;
+
+    sccp->block_exec[0] = true;
+    for (int i = 0; i < function->blocks[0].instr_count; i++) {
+        visit_instr(sccp, function->blocks[0].instrs[i]);
+    }
+
+    while (sccp->flow_work.count > 0 || sccp->ssa_work.count > 0) {
+        while (sccp->flow_work.count > 0) {
+            int edge = sccp->flow_work.items[--sccp->flow_work.count];
+            if (sccp->edge_exec[edge]) continue;
+            sccp->edge_exec[edge] = true;
+
+            int target = function->blocks[edge / 2].succs[edge % 2];
+            IRBlock* block = &function->blocks[target];
+            if (!sccp->block_exec[target]) {
+                // 第一次到达: 求值整个块
+                sccp->block_exec[target] = true;
+                for (int i = 0; i < block->instr_count; i++) {
+                    visit_instr(sccp, block->instrs[i]);
+                }
+            } else {
+                // 新的入边只影响phi
+                for (int i = 0; i < block->instr_count; i++) {
+                    if (function->instrs[block->instrs[i]].op != IR_PHI) break;
+                    visit_instr(sccp, block->instrs[i]);
+                }
+            }
+        }
+
+        while (sccp->ssa_work.count > 0) {
+            int vreg = sccp->ssa_work.items[--sccp->ssa_work.count];
+            for (int u = sccp->uses->start[vreg]; u < sccp->uses->start[vreg + 1]; u++) {
+                int user = sccp->uses->instrs[u];
+                if (sccp->block_exec[function->instrs[user].block]) {
+                    visit_instr(sccp, user);
+                }
+            }
+        }
+    }
+}
+
+// ========== 块内store转发 ==========
+
+// 在每个基本块内记住全局标量最近一次store(或load)的值, 替换之后对它的load。
+// 调用和通过指针的store可能修改任何全局变量, 遇到时全部作废
+static int forward_global_stores(const IRModule* module, IRFunction* function, IROperand* map) {
+    if (module->global_count == 0) return 0;
+
+    IROperand* known = (IROperand*)sccp_alloc(sizeof(IROperand) * (size_t)module->global_count);
+    int* epoch_of = (int*)sccp_alloc(sizeof(int) * (size_t)module->global_count);
+    int epoch = 0;
+    int forwarded = 0;
+
+    for (int b = 0; b < function->block_count; b++) {
+        IRBlock* block = &function->blocks[b];
+        epoch++;
+        for (int i = 0; i < block->instr_count; i++) {
+            IRInstr* instr = &function->instrs[block->instrs[i]];
+            IROperand* args = ir_instr_args(function, instr);
+
+            if (instr->op == IR_CALL) {
+                epoch++;
+            } else if (instr->op == IR_STORE) {
+                if (args[0].kind == IR_OPERAND_GLOBAL && instr->arg_count == 2) {
+                    known[args[0].value] = args[1];
+                    epoch_of[args[0].value] = epoch;
+                } else if (args[0].kind == IR_OPERAND_VREG) {
+                    epoch++;
+                }
+            } else if (instr->op == IR_LOAD && args[0].kind == IR_OPERAND_GLOBAL && instr->arg_count == 1) {
+                int global = args[0].value;
+                if (epoch_of[global] == epoch) {
+                    map[instr->dest] = known[global];
+                    instr->op = IR_NOP;
+                    forwarded++;
+                } else {
+                    known[global] = ir_operand_vreg(instr->dest, (IRType)instr->type);
+                    epoch_of[global] = epoch;
+                }
+            }
+        }
+    }
+
+    free(known);
+    free(epoch_of);
+    return forwarded;
+}
+
+// ========== 改写 ==========
+
+static int count_live_instrs(const IRFunction* function, const IRBlock* block) {
+    int count = 0;
+    for (int i = 0; i < block->instr_count; i++) {
+        if (function->instrs[block->instrs[i]].op != IR_NOP) count++;
+    }
+    return count;
+}
+
+static void rewrite(SCCP* sccp, IROperand* map, IRSCCPStats* stats, FILE* warn) {
+    IRFunction* function = sccp->function;
+
+    for (int b = 0; b < function->block_count; b++) {
+        IRBlock* block = &function->blocks[b];
+        if (block->instr_count == 0) continue;
+
+        if (!sccp->block_exec[b]) {
+            stats->removed_instrs += count_live_instrs(function, block);
+            stats->removed_blocks++;
+            for (int i = 0; i < block->instr_count; i++) {
+                function->instrs[block->instrs[i]].op = IR_NOP;
+            }
+            block->instr_count = 0;
+            continue;
+        }
+
+        for (int i = 0; i < block->instr_count; i++) {
+            IRInstr* instr = &function->instrs[block->instrs[i]];
+            IROperand* args = ir_instr_args(function, instr);
+
+            if (instr->dest >= 0 && instr->op != IR_CALL &&
+                sccp->values[instr->dest].state == LATTICE_CONST) {
+                map[instr->dest] = ir_operand_const(sccp->values[instr->dest].value, (IRType)instr->type);
+                instr->op = IR_NOP;
+                stats->removed_instrs++;
+            } else if (instr->op == IR_BR) {
+                LatticeValue cond = operand_value(sccp, args[0]);
+                if (cond.state != LATTICE_CONST) continue;
+
+                // 源代码中的字面常量条件(如while (1))是有意为之, 不警告
+                if (warn && args[0].kind == IR_OPERAND_VREG) {
+                    fprintf(warn, "\033[33m警告 (行 %d): 条件恒为%s, 另一个分支永远不会执行\033[0m\n",
+                            instr->line, cond.value ? "真" : "假");
+                }
+                args[0] = args[cond.value ? 1 : 2];
+                instr->op = IR_JMP;
+                instr->arg_count = 1;
+                stats->folded_branches++;
+            }
+        }
+    }
+
+    // 重新计算控制流图, 去掉phi中不再可执行的输入
+    ir_function_remove_unreachable(function);
+
+    // 只剩一个输入(或所有输入相同)的phi就是该输入
+    for (int b = 0; b < function->block_count; b++) {
+        IRBlock* block = &function->blocks[b];
+        for (int i = 0; i < block->instr_count; i++) {
+            IRInstr* instr = &function->instrs[block->instrs[i]];
+            if (instr->op == IR_NOP) continue;
+            if (instr->op != IR_PHI) break;
+
+            IROperand* args = ir_instr_args(function, instr);
+            bool same = instr->arg_count >= 2;
+            for (int a = 3; a < instr->arg_count; a += 2) {
+                if (args[a].kind != args[1].kind || args[a].value != args[1].value) same = false;
+            }
+            if (same && !(args[1].kind == IR_OPERAND_VREG && args[1].value == instr->dest)) {
+                map[instr->dest] = args[1];
+                instr->op = IR_NOP;
+                stats->removed_instrs++;
+            }
+        }
+    }
+}
+
+// ========== 入口 ==========
+
+void ir_function_sccp(const IRModule* module, IRFunction* function, IRSCCPStats* stats, FILE* warn) {
+    if (!function->is_defined || function->block_count == 0) return;
+
+    IRSCCPStats local;
+    memset(&local, 0, sizeof(local));
+
+    IROperand* map = (IROperand*)sccp_alloc(sizeof(IROperand) * (size_t)function->vreg_count);
+    local.forwarded_loads = forward_global_stores(module, function, map);
+    if (local.forwarded_loads > 0) {
+        ir_function_replace_uses(function, map);
+        ir_function_compact(function);
+        memset(map, 0, sizeof(IROperand) * (size_t)function->vreg_count);
+    }
+
+    SCCP sccp;
+    memset(&sccp, 0, sizeof(sccp));
+    sccp.function = function;
+    sccp.uses = ir_uses_create(function);
+    sccp.values = (LatticeValue*)sccp_alloc(sizeof(LatticeValue) * (size_t)function->vreg_count);
+    sccp.block_exec = (bool*)sccp_alloc(sizeof(bool) * (size_t)function->block_count);
+    sccp.edge_exec = (bool*)sccp_alloc(sizeof(bool) * (size_t)function->block_count * 2);
+    for (int v = 0; v < function->vreg_count; v++) {
+        sccp.values[v] = v < function->param_count ? lattice_bottom : lattice_top;
+    }
+
+    propagate(&sccp);
+    rewrite(&sccp, map, &local, warn);
+    ir_function_replace_uses(function, map);
+    ir_function_compact(function);
+
+    if (stats) {
+        stats->removed_instrs += local.removed_instrs;
+        stats->removed_blocks += local.removed_blocks;
+        stats->folded_branches += local.folded_branches;
+        stats->forwarded_loads += local.forwarded_loads;
+    }
+
+    ir_uses_destroy(sccp.uses);
+    free(sccp.values);
+    free(sccp.block_exec);
+    free(sccp.edge_exec);
+    free(sccp.flow_work.items);
+    free(sccp.ssa_work.items);
+    free(map);
+}
+
+void ir_module_sccp(IRModule* module, IRSCCPStats* stats, FILE* warn) {
+    for (int i = 0; i < module->function_count; i++) {
+        ir_function_sccp(module, &module->functions[i], stats, warn);
+    }
+}
@@ -0,0 +1,29 @@
+#ifndef IR_SCCP_H
+#define IR_SCCP_H
+
+#include "ir.h"
+#include <stdio.h>
+
+// ========== 稀疏条件常量传播(SCCP) ==========
+//
+// 在SSA形式的IR上同时传播常量和可达性(Wegman-Zadeck):
+// 只沿可执行的控制流边求值, phi只合并可执行前驱的输入。结束后
+//   - 值为常量的指令被删除, 其使用替换为常量
+//   - 条件为常量的br改写为jmp, 永远不会执行的基本块被清空
+//   - 只剩一个输入的phi被其输入替换
+// 之前先在每个基本块内把全局标量的store转发给之后的load(中间没有调用和指针写入),
+// 使顶层语句中经过全局变量的常量也能传播。
+
+typedef struct IRSCCPStats {
+    int removed_instrs;     // 删除的指令数
+    int removed_blocks;     // 清空的基本块数
+    int folded_branches;    // 改写为无条件跳转的分支数
+    int forwarded_loads;    // 被store转发替换的load数
+} IRSCCPStats;
+
+// 对SSA形式的函数做常量传播; stats不为NULL时累加统计。
+// warn不为NULL时, 对经传播才确定的常量条件输出"分支永远不会执行"的警告
+void ir_function_sccp(const IRModule* module, IRFunction* function, IRSCCPStats* stats, FILE* warn);
+void ir_module_sccp(IRModule* module, IRSCCPStats* stats, FILE* warn);
+
+#endif // IR_SCCP_H
@@ -0,0 +1,442 @@
+#include "ir_ssa.h"
+#include "ir_dom.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// ========== 构造状态 ==========
+
+typedef struct SSABuilder {
+    IRFunction* function;
+    IRDomTree* dom;
+
+    int* slot_var;          // 栈槽 → 变量编号, -1表示不提升
+    int* var_slot;          // 变量编号 → 栈槽
+    int var_count;
+
+    // 每个变量的定值块/向上暴露使用块, 按变量分组(CSR)
+    int* def_blocks;
+    int* def_start;
+    int* use_blocks;
+    int* use_start;
+
+    int* phi_var;           // phi指令编号 → 变量编号(其余指令为-1)
+
+    // 重命名
+    IROperand* current;     // 每个变量的当前值
+    IROperand* replace;     // load结果寄存器 → 替换成的值
+    IRSSAStats stats;
+} SSABuilder;
+
+typedef struct VarBlock {
+    int var;
+    int block;
+} VarBlock;
+
+static void* ssa_alloc(size_t size) {
+    void* ptr = malloc(size > 0 ? size : 1);
+    if (!ptr) {
+        perror("malloc failed for SSABuilder");
+        exit(1);
+    }
+    return ptr;
+}
+
+static int* int_array(int count, int fill) {
+    int* array = (int*)ssa_alloc(sizeof(int) * (size_t)count);
+    for (int i = 0; i < count; i++) {
+        array[i] = fill;
+    }
+    return array;
+}
+
+static int promoted_var(const SSABuilder* builder, IROperand operand) {
+    if (operand.kind != IR_OPERAND_SLOT) return -1;
+    return builder->slot_var[operand.value];
+}
+
+// ========== 选择要提升的栈槽 ==========
+
+// 标量栈槽只作为load/store的基址出现时才能提升
+static void find_promotable(SSABuilder* builder) {
+    IRFunction* function = builder->function;
+    bool* promotable = (bool*)ssa_alloc(sizeof(bool) * (size_t)function->slot_count);
+    for (int s = 0; s < function->slot_count; s++) {
+        promotable[s] = function->slots[s].count == 1;
+    }
+
+    for (int b = 0; b < function->block_count; b++) {
+        IRBlock* block = &function->blocks[b];
+        for (int i = 0; i < block->instr_count; i++) {
+            IRInstr* instr = &function->instrs[block->instrs[i]];
+            IROperand* args = ir_instr_args(function, instr);
+            for (int a = 0; a < instr->arg_count; a++) {
+                if (args[a].kind != IR_OPERAND_SLOT) continue;
+
+                bool scalar_access = a == 0 &&
+                    ((instr->op == IR_LOAD && instr->arg_count == 1) ||
+                     (instr->op == IR_STORE && instr->arg_count == 2));
+                if (!scalar_access) {
+                    promotable[args[a].value] = false;
+                }
+            }
+        }
+    }
+
+    builder->slot_var = int_array(function->slot_count, -1);
+    builder->var_slot = int_array(function->slot_count, -1);
+    builder->var_count = 0;
+    for (int s = 0; s < function->slot_count; s++) {
+        if (!promotable[s]) continue;
+        builder->slot_var[s] = builder->var_count;
+        builder->var_slot[builder->var_count++] = s;
+    }
+    free(promotable);
+}
+
+// 把(变量, 块)对按变量分组
+static void group_by_var(const VarBlock* pairs, int count, int var_count, int** blocks, int** start) {
+    *start = int_array(var_count + 1, 0);
+    *blocks = int_array(count, -1);
+    for (int i = 0; i < count; i++) {
+        (*start)[pairs[i].var + 1]++;
+    }
+    for (int v = 0; v < var_count; v++) {
+        (*start)[v + 1] += (*start)[v];
+    }
+
+    int* fill = int_array(var_count, 0);
+    for (int i = 0; i < count; i++) {
+        (*blocks)[(*start)[pairs[i].var] + fill[pairs[i].var]++] = pairs[i].block;
+    }
+    free(fill);
+}
+
+// 收集每个变量的定值块和向上暴露的使用块(块内第一次访问是load)
+static void collect_defs_uses(SSABuilder* builder) {
+    IRFunction* function = builder->function;
+    int var_count = builder->var_count;
+
+    VarBlock* defs = (VarBlock*)ssa_alloc(sizeof(VarBlock) * (size_t)function->instr_count);
+    VarBlock* uses = (VarBlock*)ssa_alloc(sizeof(VarBlock) * (size_t)function->instr_count);
+    int def_count = 0;
+    int use_count = 0;
+    int* def_seen = int_array(var_count, -1);  // 最近一次在哪个块中定值
+    int* use_seen = int_array(var_count, -1);
+
+    for (int b = 0; b < function->block_count; b++) {
+        IRBlock* block = &function->blocks[b];
+        for (int i = 0; i < block->instr_count; i++) {
+            IRInstr* instr = &function->instrs[block->instrs[i]];
+            if (instr->op != IR_LOAD && instr->op != IR_STORE) continue;
+
+            int var = promoted_var(builder, ir_instr_args(function, instr)[0]);
+            if (var < 0) continue;
+
+            if (instr->op == IR_LOAD) {
+                if (def_seen[var] != b && use_seen[var] != b) {
+                    use_seen[var] = b;
+                    uses[use_count].var = var;
+                    uses[use_count++].block = b;
+                }
+            } else if (def_seen[var] != b) {
+                def_seen[var] = b;
+                defs[def_count].var = var;
+                defs[def_count++].block = b;
+            }
+        }
+    }
+
+    group_by_var(defs, def_count, var_count, &builder->def_blocks, &builder->def_start);
+    group_by_var(uses, use_count, var_count, &builder->use_blocks, &builder->use_start);
+    free(defs);
+    free(uses);
+    free(def_seen);
+    free(use_seen);
+}
+
+// ========== 放置phi ==========
+
+typedef struct PhiRecord {
+    int instr;
+    int var;
+} PhiRecord;
+
+static void place_phis(SSABuilder* builder) {
+    IRFunction* function = builder->function;
+    IRDomTree* dom = builder->dom;
+    int n = function->block_count;
+
+    // 以 var+1 作为标记, 避免每个变量都清空数组
+    int* live = int_array(n, 0);
+    int* defined = int_array(n, 0);
+    int* has_phi = int_array(n, 0);
+    int* queued = int_array(n, 0);
+    int* worklist = int_array(n, 0);
+
+    PhiRecord* phis = NULL;
+    int phi_count = 0;
+    int phi_capacity = 0;
+
+    for (int var = 0; var < builder->var_count; var++) {
+        int mark = var + 1;
+        for (int i = builder->def_start[var]; i < builder->def_start[var + 1]; i++) {
+            defined[builder->def_blocks[i]] = mark;
+        }
+
+        // 活跃入口块: 从向上暴露的使用逆着控制流传播, 遇到定值块停止
+        int top = 0;
+        for (int i = builder->use_start[var]; i < builder->use_start[var + 1]; i++) {
+            int block = builder->use_blocks[i];
+            live[block] = mark;
+            worklist[top++] = block;
+        }
+        while (top > 0) {
+            IRBlock* block = &function->blocks[worklist[--top]];
+            for (int p = 0; p < block->pred_count; p++) {
+                int pred = block->preds[p];
+                if (live[pred] == mark || defined[pred] == mark) continue;
+                live[pred] = mark;
+                worklist[top++] = pred;
+            }
+        }
+
+        // 迭代支配边界
+        top = 0;
+        for (int i = builder->def_start[var]; i < builder->def_start[var + 1]; i++) {
+            int block = builder->def_blocks[i];
+            queued[block] = mark;
+            worklist[top++] = block;
+        }
+        while (top > 0) {
+            int block = worklist[--top];
+            for (int f = dom->frontier_start[block]; f < dom->frontier_start[block + 1]; f++) {
+                int join = dom->frontier[f];
+                if (has_phi[join] == mark || live[join] != mark) continue;
+
+                has_phi[join] = mark;
+                IRType type = (IRType)function->slots[builder->var_slot[var]].type;
+                if (phi_count == phi_capacity) {
+                    phi_capacity = phi_capacity > 0 ? phi_capacity * 2 : 16;
+                    phis = (PhiRecord*)realloc(phis, sizeof(PhiRecord) * (size_t)phi_capacity);
+                    if (!phis) {
+                        perror("realloc failed for PhiRecord");
+                        exit(1);
+                    }
+                }
+                phis[phi_count].instr = ir_insert_phi(function, join, type);
+                phis[phi_count++].var = var;
+
+                if (queued[join] != mark) {
+                    queued[join] = mark;
+                    worklist[top++] = join;
+                }
+            }
+        }
+    }
+
+    builder->phi_var = int_array(function->instr_count, -1);
+    for (int i = 0; i < phi_count; i++) {
+        builder->phi_var[phis[i].instr] = phis[i].var;
+    }
+    builder->stats.phi_count += phi_count;
+
+    free(phis);
+    free(live);
+    free(defined);
+    free(has_phi);
+    free(queued);
+    free(worklist);
+}
+
+// ========== 重命名 ==========
+
+typedef struct UndoEntry {
+    int var;
+    IROperand value;
+} UndoEntry;
+
+typedef struct UndoLog {
+    UndoEntry* entries;
+    int count;
+    int capacity;
+} UndoLog;
+
+static void set_current(SSABuilder* builder, UndoLog* log, int var, IROperand value) {
+    if (log->count == log->capacity) {
+        log->capacity = log->capacity > 0 ? log->capacity * 2 : 64;
+        log->entries = (UndoEntry*)realloc(log->entries, sizeof(UndoEntry) * (size_t)log->capacity);
+        if (!log->entries) {
+            perror("realloc failed for UndoLog");
+            exit(1);
+        }
+    }
+    log->entries[log->count].var = var;
+    log->entries[log->count++].value = builder->current[var];
+    builder->current[var] = value;
+}
+
+static IROperand resolve(const SSABuilder* builder, IROperand operand) {
+    if (operand.kind == IR_OPERAND_VREG && builder->replace[operand.value].kind != IR_OPERAND_NONE) {
+        return builder->replace[operand.value];
+    }
+    return operand;
+}
+
+static void rename_block(SSABuilder* builder, UndoLog* log, int b) {
+    IRFunction* function = builder->function;
+    IRBlock* block = &function->blocks[b];
+
+    for (int i = 0; i < block->instr_count; i++) {
+        IRInstr* instr = &function->instrs[block->instrs[i]];
+        IROperand* args = ir_instr_args(function, instr);
+
+        if (instr->op == IR_PHI) {
+            int var = builder->phi_var[block->instrs[i]];
+            if (var >= 0) {
+                set_current(builder, log, var, ir_operand_vreg(instr->dest, (IRType)instr->type));
+            }
+            continue;
+        }
+
+        for (int a = 0; a < instr->arg_count; a++) {
+            args[a] = resolve(builder, args[a]);
+        }
+
+        if (instr->op == IR_LOAD || instr->op == IR_STORE) {
+            int var = promoted_var(builder, args[0]);
+            if (var < 0) continue;
+
+            if (instr->op == IR_LOAD) {
+                builder->replace[instr->dest] = builder->current[var];
+                builder->stats.removed_loads++;
+            } else {
+                set_current(builder, log, var, args[1]);
+                builder->stats.removed_stores++;
+            }
+            instr->op = IR_NOP;
+        }
+    }
+
+    // 填写后继块中phi对应本块的操作数
+    for (int s = 0; s < block->succ_count; s++) {
+        IRBlock* succ = &function->blocks[block->succs[s]];
+        for (int i = 0; i < succ->instr_count; i++) {
+            IRInstr* phi = &function->instrs[succ->instrs[i]];
+            if (phi->op != IR_PHI) break;
+
+            int var = builder->phi_var[succ->instrs[i]];
+            if (var < 0) continue;
+
+            IROperand* args = ir_instr_args(function, phi);
+            for (int a = 0; a < phi->arg_count; a += 2) {
+                if (args[a].value == b) {
+                    args[a + 1] = builder->current[var];
+                }
+            }
+        }
+    }
+}
+
+// 非递归地先序遍历支配树, 离开子树时撤销其中的赋值
+static void rename_all(SSABuilder* builder) {
+    IRFunction* function = builder->function;
+    IRDomTree* dom = builder->dom;
+    int n = function->block_count;
+
+    builder->current = (IROperand*)ssa_alloc(sizeof(IROperand) * (size_t)builder->var_count);
+    for (int v = 0; v < builder->var_count; v++) {
+        IRType type = (IRType)function->slots[builder->var_slot[v]].type;
+        builder->current[v] = ir_operand_const(0, type);
+    }
+    builder->replace = (IROperand*)ssa_alloc(sizeof(IROperand) * (size_t)function->vreg_count);
+    memset(builder->replace, 0, sizeof(IROperand) * (size_t)function->vreg_count);
+
+    UndoLog log = { NULL, 0, 0 };
+    int* stack = int_array(n, 0);
+    int* next_child = int_array(n, 0);
+    int* undo_mark = int_array(n, 0);
+    int depth = 0;
+
+    if (dom->rpo_count > 0) {
+        int entry = dom->rpo[0];
+        undo_mark[entry] = log.count;
+        rename_block(builder, &log, entry);
+        stack[depth++] = entry;
+    }
+    while (depth > 0) {
+        int block = stack[depth - 1];
+        int index = dom->child_start[block] + next_child[block];
+        if (index < dom->child_start[block + 1]) {
+            int child = dom->children[index];
+            next_child[block]++;
+            undo_mark[child] = log.count;
+            rename_block(builder, &log, child);
+            stack[depth++] = child;
+        } else {
+            while (log.count > undo_mark[block]) {
+                log.count--;
+                builder->current[log.entries[log.count].var] = log.entries[log.count].value;
+            }
+            depth--;
+        }
+    }
+
+    free(log.entries);
+    free(stack);
+    free(next_child);
+    free(undo_mark);
+}
+
+// ========== 入口 ==========
+
+void ir_function_to_ssa(IRFunction* function, IRSSAStats* stats) {
+    if (!function->is_defined || function->is_ssa) return;
+
+    SSABuilder builder;
+    memset(&builder, 0, sizeof(builder));
+    builder.function = function;
+
+    builder.stats.removed_blocks = ir_function_remove_unreachable(function);
+    find_promotable(&builder);
+
+    if (builder.var_count > 0) {
+        builder.dom = ir_dom_tree_create(function);
+        ir_dom_compute_frontiers(builder.dom, function);
+        collect_defs_uses(&builder);
+        place_phis(&builder);
+        rename_all(&builder);
+        ir_function_compact(function);
+
+        for (int v = 0; v < builder.var_count; v++) {
+            function->slots[builder.var_slot[v]].promoted = true;
+        }
+        builder.stats.promoted_slots = builder.var_count;
+    }
+    function->is_ssa = true;
+
+    if (stats) {
+        stats->promoted_slots += builder.stats.promoted_slots;
+        stats->phi_count += builder.stats.phi_count;
+        stats->removed_loads += builder.stats.removed_loads;
+        stats->removed_stores += builder.stats.removed_stores;
+        stats->removed_blocks += builder.stats.removed_blocks;
+    }
+
+    ir_dom_tree_destroy(builder.dom);
+    free(builder.slot_var);
+    free(builder.var_slot);
+    free(builder.def_blocks);
+    free(builder.def_start);
+    free(builder.use_blocks);
+    free(builder.use_start);
+    free(builder.phi_var);
+    free(builder.current);
+    free(builder.replace);
+}
+
+void ir_module_to_ssa(IRModule* module, IRSSAStats* stats) {
+    for (int i = 0; i < module->function_count; i++) {
+        ir_function_to_ssa(&module->functions[i], stats);
+    }
+}
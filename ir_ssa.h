@@ -0,0 +1,27 @@
+#ifndef IR_SSA_H
+#define IR_SSA_H
+
+#include "ir.h"
+
+// ========== SSA构造 ==========
+//
+// 把只通过标量load/store访问的栈槽(没有取地址、不是数组)提升为虚拟寄存器:
+//   1. 清空不可达基本块, 计算支配树和支配边界
+//   2. 对每个变量求活跃入口块, 只在变量活跃的迭代支配边界上放置phi(剪枝SSA)
+//   3. 沿支配树重命名: load替换为当前值, store更新当前值, 填写后继块phi的操作数
+// 读取未赋值的变量得到0。
+
+typedef struct IRSSAStats {
+    int promoted_slots;     // 提升的栈槽数
+    int phi_count;          // 插入的phi数
+    int removed_loads;      // 删除的load数
+    int removed_stores;     // 删除的store数
+    int removed_blocks;     // 清空的不可达基本块数
+} IRSSAStats;
+
+// 把函数转换为SSA形式; stats不为NULL时累加统计
+void ir_function_to_ssa(IRFunction* function, IRSSAStats* stats);
+// 转换模块中所有已定义的函数
+void ir_module_to_ssa(IRModule* module, IRSSAStats* stats);
+
+#endif // IR_SSA_H
@@ -0,0 +1,394 @@
+#include "ir_strength.h"
+#include "ir_dom.h"
+#include "ir_loop.h"
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct InductionVar {
+    int phi;                // 循环头里的phi指令
+    int loop;
+    IROperand init;         // 来自前置块的初值
+    IROperand step;         // 每次迭代的增量(循环不变量)
+    int next;               // 计算 i + step 的指令
+    bool non_negative;      // 从非负常量开始按正常量递增
+} InductionVar;
+
+typedef struct Strength {
+    IRFunction* function;
+    IRLoopInfo* loops;
+    int* def_instr;         // 虚拟寄存器 → 定义它的指令; 只覆盖本遍开始前的寄存器
+    int def_count;
+    int* iv_of;             // phi的结果寄存器 → 归纳变量
+    InductionVar* ivs;
+    int iv_count;
+    IROperand* map;         // 被削弱的乘法 → 新的归纳变量
+} Strength;
+
+static void* strength_alloc(size_t size) {
+    void* ptr = calloc(1, size ? size : 1);
+    if (!ptr) {
+        perror("malloc failed for strength reduction");
+        exit(1);
+    }
+    return ptr;
+}
+
+static int def_of(const Strength* strength, IROperand operand) {
+    if (operand.kind != IR_OPERAND_VREG || operand.value >= strength->def_count) return -1;
+    return strength->def_instr[operand.value];
+}
+
+static bool is_invariant(const Strength* strength, int loop, IROperand operand) {
+    if (operand.kind == IR_OPERAND_CONST) return true;
+    if (operand.kind != IR_OPERAND_VREG) return false;
+    int def = def_of(strength, operand);
+    if (def < 0) return operand.value < strength->function->param_count;
+    return !ir_loop_contains(strength->loops, loop, strength->function->instrs[def].block);
+}
+
+static int iv_index(const Strength* strength, IROperand operand) {
+    if (operand.kind != IR_OPERAND_VREG || operand.value >= strength->def_count) return -1;
+    return strength->iv_of[operand.value];
+}
+
+// ========== 插入指令 ==========
+
+// ir_emit把指令追加在块尾, 挪到终结指令之前
+static IROperand emit_before_terminator(IRFunction* function, int b, IROpcode op,
+                                        IROperand lhs, IROperand rhs, int line) {
+    IROperand args[2] = { lhs, rhs };
+    int id = ir_emit(function, b, op, IR_TYPE_I32, true, args, 2, line);
+    IRBlock* block = &function->blocks[b];
+    if (block->instr_count >= 2) {
+        block->instrs[block->instr_count - 1] = block->instrs[block->instr_count - 2];
+        block->instrs[block->instr_count - 2] = id;
+    }
+    return ir_operand_vreg(function->instrs[id].dest, IR_TYPE_I32);
+}
+
+// 两个操作数都是常量时直接按32位回绕折叠
+static IROperand emit_folded(IRFunction* function, int b, IROpcode op, IROperand lhs, IROperand rhs,
+                             int line) {
+    if (lhs.kind == IR_OPERAND_CONST && rhs.kind == IR_OPERAND_CONST) {
+        uint32_t a = (uint32_t)lhs.value;
+        uint32_t c = (uint32_t)rhs.value;
+        return ir_operand_const((int32_t)(op == IR_MUL ? a * c : a + c), IR_TYPE_I32);
+    }
+    return emit_before_terminator(function, b, op, lhs, rhs, line);
+}
+
+// 把刚追加在块尾的new_id挪到after_id之后
+static void move_after(IRFunction* function, int b, int after_id, int new_id) {
+    IRBlock* block = &function->blocks[b];
+    int position = 0;
+    while (position < block->instr_count && block->instrs[position] != after_id) position++;
+    position++;
+    memmove(&block->instrs[position + 1], &block->instrs[position],
+            sizeof(int32_t) * (size_t)(block->instr_count - 1 - position));
+    block->instrs[position] = new_id;
+}
+
+// ========== 归纳变量 ==========
+
+static void find_induction_vars(Strength* strength) {
+    IRFunction* function = strength->function;
+    for (int l = 0; l < strength->loops->loop_count; l++) {
+        const IRLoop* loop = &strength->loops->loops[l];
+        if (loop->preheader < 0) continue;
+
+        const IRBlock* header = &function->blocks[loop->header];
+        for (int i = 0; i < header->instr_count; i++) {
+            int id = header->instrs[i];
+            const IRInstr* phi = &function->instrs[id];
+            if (phi->op != IR_PHI) break;
+            if (phi->arg_count != 4 || phi->type != IR_TYPE_I32) continue;
+
+            const IROperand* args = &function->operands[phi->args];
+            int entry = args[0].value == loop->preheader ? 0 : 2;
+            IROperand init = args[entry + 1];
+            IROperand back = args[(entry + 2) % 4 + 1];
+            if (args[entry].value != loop->preheader) continue;
+
+            int next = def_of(strength, back);
+            if (next < 0) continue;
+            const IRInstr* update = &function->instrs[next];
+            const IROperand* operands = &function->operands[update->args];
+            IROperand self = ir_operand_vreg(phi->dest, IR_TYPE_I32);
+            IROperand step;
+            if (update->op == IR_ADD && operands[0].kind == self.kind && operands[0].value == self.value) {
+                step = operands[1];
+            } else if (update->op == IR_ADD && operands[1].kind == self.kind &&
+                       operands[1].value == self.value) {
+                step = operands[0];
+            } else if (update->op == IR_SUB && operands[0].kind == self.kind &&
+                       operands[0].value == self.value && operands[1].kind == IR_OPERAND_CONST &&
+                       operands[1].value != INT32_MIN) {
+                step = ir_operand_const(-operands[1].value, IR_TYPE_I32);
+            } else {
+                continue;
+            }
+            if (step.kind == IR_OPERAND_VREG && step.value == phi->dest) continue;
+            if (!is_invariant(strength, l, step)) continue;
+
+            InductionVar* iv = &strength->ivs[strength->iv_count];
+            iv->phi = id;
+            iv->loop = l;
+            iv->init = init;
+            iv->step = step;
+            iv->next = next;
+            iv->non_negative = init.kind == IR_OPERAND_CONST && init.value >= 0 &&
+                               step.kind == IR_OPERAND_CONST && step.value > 0;
+            strength->iv_of[phi->dest] = strength->iv_count++;
+        }
+    }
+}
+
+// i * k → t, t = phi [前置块: init * k], [回边: t + step * k]
+static void reduce_mul(Strength* strength, int mul_id, const InductionVar* iv, IROperand factor) {
+    IRFunction* function = strength->function;
+    const IRLoop* loop = &strength->loops->loops[iv->loop];
+    int line = function->instrs[mul_id].line;
+    int preheader = loop->preheader;
+
+    IROperand init = emit_folded(function, preheader, IR_MUL, iv->init, factor, line);
+    IROperand step = emit_folded(function, preheader, IR_MUL, iv->step, factor, line);
+
+    int phi_id = ir_insert_phi(function, loop->header, IR_TYPE_I32);
+    IROperand t = ir_operand_vreg(function->instrs[phi_id].dest, IR_TYPE_I32);
+
+    int next_block = function->instrs[iv->next].block;
+    IROperand add[2] = { t, step };
+    int next_id = ir_emit(function, next_block, IR_ADD, IR_TYPE_I32, true, add, 2, line);
+    move_after(function, next_block, iv->next, next_id);
+    IROperand t_next = ir_operand_vreg(function->instrs[next_id].dest, IR_TYPE_I32);
+
+    IRInstr* phi = &function->instrs[phi_id];
+    IROperand* args = ir_instr_args(function, phi);
+    for (int a = 0; a + 1 < phi->arg_count; a += 2) {
+        args[a + 1] = args[a].value == preheader ? init : t_next;
+    }
+
+    IRInstr* mul = &function->instrs[mul_id];
+    strength->map[mul->dest] = t;
+    mul->op = IR_NOP;
+}
+
+static int reduce_loop(Strength* strength, int l) {
+    IRFunction* function = strength->function;
+    const IRLoop* loop = &strength->loops->loops[l];
+    int reduced = 0;
+
+    for (int i = 0; i < loop->block_count; i++) {
+        int b = strength->loops->blocks[loop->block_start + i];
+        // 插入新指令会使块内位置后移, 重新访问到的已削弱乘法是nop, 不会重复处理
+        for (int j = 0; j < function->blocks[b].instr_count; j++) {
+            int id = function->blocks[b].instrs[j];
+            const IRInstr* instr = &function->instrs[id];
+            // 跳过本遍插入的乘法: 内层前置块里的 init * k 位于外层循环中, 但map只覆盖旧寄存器
+            if (instr->op != IR_MUL || instr->dest >= strength->def_count) continue;
+
+            IROperand lhs = function->operands[instr->args];
+            IROperand rhs = function->operands[instr->args + 1];
+            int iv = iv_index(strength, lhs);
+            IROperand factor = rhs;
+            if (iv < 0 || strength->ivs[iv].loop != l) {
+                iv = iv_index(strength, rhs);
+                factor = lhs;
+            }
+            if (iv < 0 || strength->ivs[iv].loop != l || !is_invariant(strength, l, factor)) continue;
+
+            InductionVar copy = strength->ivs[iv];
+            reduce_mul(strength, id, &copy, factor);
+            reduced++;
+        }
+    }
+    return reduced;
+}
+
+// ========== 移位 ==========
+
+static int log2_exact(IROperand operand) {
+    if (operand.kind != IR_OPERAND_CONST || operand.value < 2) return -1;
+    if ((operand.value & (operand.value - 1)) != 0) return -1;
+    int n = 0;
+    while ((1 << n) != operand.value) n++;
+    return n;
+}
+
+static bool known_non_negative(const Strength* strength, IROperand operand) {
+    if (operand.kind == IR_OPERAND_CONST) return operand.value >= 0;
+    int iv = iv_index(strength, operand);
+    if (iv >= 0) return strength->ivs[iv].non_negative;
+
+    int def = def_of(strength, operand);
+    if (def < 0) return false;
+    const IRInstr* instr = &strength->function->instrs[def];
+    const IROperand* args = &strength->function->operands[instr->args];
+    if (instr->op == IR_ZEXT) return true;
+    if (instr->op == IR_AND) {
+        return (args[0].kind == IR_OPERAND_CONST && args[0].value >= 0) ||
+               (args[1].kind == IR_OPERAND_CONST && args[1].value >= 0);
+    }
+    return false;
+}
+
+static void append_instr(IRFunction* function, int b, int id) {
+    IRBlock* block = &function->blocks[b];
+    ARENA_RESERVE(function->arena, block->instrs, block->instr_count, block->instr_capacity);
+    block->instrs[block->instr_count++] = id;
+}
+
+// 有符号除以2^n向0取整: 负数先加上 2^n - 1 再算术右移
+static IROperand emit_rounding_bias(IRFunction* function, int b, IROperand x, int n, int line) {
+    IROperand sign[2] = { x, ir_operand_const(31, IR_TYPE_I32) };
+    int t1 = ir_emit(function, b, IR_SHR, IR_TYPE_I32, true, sign, 2, line);
+    IROperand mask[2] = { ir_operand_vreg(function->instrs[t1].dest, IR_TYPE_I32),
+                          ir_operand_const((1 << n) - 1, IR_TYPE_I32) };
+    int t2 = ir_emit(function, b, IR_AND, IR_TYPE_I32, true, mask, 2, line);
+    IROperand biased[2] = { x, ir_operand_vreg(function->instrs[t2].dest, IR_TYPE_I32) };
+    int t3 = ir_emit(function, b, IR_ADD, IR_TYPE_I32, true, biased, 2, line);
+    return ir_operand_vreg(function->instrs[t3].dest, IR_TYPE_I32);
+}
+
+static bool rewrite_power_of_two(Strength* strength, int b, int id) {
+    IRFunction* function = strength->function;
+    IRInstr* instr = &function->instrs[id];
+    IROperand* args = ir_instr_args(function, instr);
+    int line = instr->line;
+
+    if (instr->op == IR_MUL) {
+        int n = log2_exact(args[1]);
+        if (n < 0 && (n = log2_exact(args[0])) >= 0) args[0] = args[1];
+        if (n < 0) return false;
+        instr->op = IR_SHL;
+        args[1] = ir_operand_const(n, IR_TYPE_I32);
+        return true;
+    }
+    if (instr->op != IR_DIV && instr->op != IR_MOD) return false;
+
+    int n = log2_exact(args[1]);
+    if (n < 0 || args[0].kind != IR_OPERAND_VREG) return false;
+    IROperand x = args[0];
+    if (known_non_negative(strength, x)) {
+        instr->op = instr->op == IR_DIV ? IR_SHR : IR_AND;
+        args[1] = ir_operand_const(instr->op == IR_SHR ? n : (1 << n) - 1, IR_TYPE_I32);
+        return true;
+    }
+
+    // x / 2^n = (x + bias) >> n;  x % 2^n = x - ((x + bias) & -2^n)
+    IROpcode op = (IROpcode)instr->op;
+    IROperand biased = emit_rounding_bias(function, b, x, n, line);
+    if (op == IR_MOD) {
+        IROperand round[2] = { biased, ir_operand_const(-(1 << n), IR_TYPE_I32) };
+        int t4 = ir_emit(function, b, IR_AND, IR_TYPE_I32, true, round, 2, line);
+        instr = &function->instrs[id];
+        args = ir_instr_args(function, instr);
+        instr->op = IR_SUB;
+        args[1] = ir_operand_vreg(function->instrs[t4].dest, IR_TYPE_I32);
+    } else {
+        instr = &function->instrs[id];
+        args = ir_instr_args(function, instr);
+        instr->op = IR_SHR;
+        args[0] = biased;
+        args[1] = ir_operand_const(n, IR_TYPE_I32);
+    }
+    return true;
+}
+
+static int rewrite_shifts(Strength* strength) {
+    IRFunction* function = strength->function;
+    int rewritten = 0;
+    int* old = NULL;
+    int old_capacity = 0;
+
+    for (int b = 0; b < function->block_count; b++) {
+        IRBlock* block = &function->blocks[b];
+        int count = block->instr_count;
+        if (count > old_capacity) {
+            free(old);
+            old_capacity = count;
+            old = (int*)strength_alloc(sizeof(int) * (size_t)count);
+        }
+        memcpy(old, block->instrs, sizeof(int) * (size_t)count);
+
+        // 重新填写指令列表, 展开时新指令由ir_emit追加在被改写的指令之前
+        block->instr_count = 0;
+        for (int i = 0; i < count; i++) {
+            if (rewrite_power_of_two(strength, b, old[i])) rewritten++;
+            append_instr(function, b, old[i]);
+        }
+    }
+    free(old);
+    return rewritten;
+}
+
+// ========== 入口 ==========
+
+void ir_function_strength_reduce(IRFunction* function, IRStrengthStats* stats) {
+    if (!function->is_defined || function->block_count == 0 || !function->is_ssa) return;
+
+    IRDomTree* dom = ir_dom_tree_create(function);
+    IRLoopInfo* loops = ir_loop_info_create(function, dom);
+    if (loops->loop_count > 0 && ir_loop_insert_preheaders(function, loops) > 0) {
+        ir_loop_info_destroy(loops);
+        ir_dom_tree_destroy(dom);
+        dom = ir_dom_tree_create(function);
+        loops = ir_loop_info_create(function, dom);
+    }
+
+    Strength strength;
+    memset(&strength, 0, sizeof(strength));
+    strength.function = function;
+    strength.loops = loops;
+    strength.def_count = function->vreg_count;
+    strength.def_instr = (int*)strength_alloc(sizeof(int) * (size_t)(function->vreg_count + 1));
+    strength.iv_of = (int*)strength_alloc(sizeof(int) * (size_t)(function->vreg_count + 1));
+    strength.map = (IROperand*)strength_alloc(sizeof(IROperand) * (size_t)(function->vreg_count + 1));
+    strength.ivs = (InductionVar*)strength_alloc(sizeof(InductionVar) * (size_t)(function->instr_count + 1));
+    memset(strength.def_instr, -1, sizeof(int) * (size_t)(function->vreg_count + 1));
+    memset(strength.iv_of, -1, sizeof(int) * (size_t)(function->vreg_count + 1));
+    for (int b = 0; b < function->block_count; b++) {
+        const IRBlock* block = &function->blocks[b];
+        for (int i = 0; i < block->instr_count; i++) {
+            const IRInstr* instr = &function->instrs[block->instrs[i]];
+            if (instr->dest >= 0) strength.def_instr[instr->dest] = block->instrs[i];
+        }
+    }
+
+    find_induction_vars(&strength);
+
+    // 内层循环先处理; 外层归纳变量在内层循环中是不变量, 其乘法已被外提
+    int reduced = 0;
+    for (int l = loops->loop_count - 1; l >= 0; l--) {
+        reduced += reduce_loop(&strength, l);
+    }
+    if (reduced > 0) {
+        // map只覆盖旧寄存器, 扩展到新的寄存器数再替换
+        IROperand* map = (IROperand*)strength_alloc(sizeof(IROperand) * (size_t)(function->vreg_count + 1));
+        memcpy(map, strength.map, sizeof(IROperand) * (size_t)strength.def_count);
+        ir_function_replace_uses(function, map);
+        free(map);
+        ir_function_compact(function);
+    }
+
+    int shifts = rewrite_shifts(&strength);
+
+    if (stats) {
+        stats->induction_vars += strength.iv_count;
+        stats->reduced_muls += reduced;
+        stats->shifts += shifts;
+    }
+
+    free(strength.def_instr);
+    free(strength.iv_of);
+    free(strength.map);
+    free(strength.ivs);
+    ir_loop_info_destroy(loops);
+    ir_dom_tree_destroy(dom);
+}
+
+void ir_module_strength_reduce(IRModule* module, IRStrengthStats* stats) {
+    for (int i = 0; i < module->function_count; i++) {
+        ir_function_strength_reduce(&module->functions[i], stats);
+    }
+}
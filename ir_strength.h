@@ -0,0 +1,25 @@
+#ifndef IR_STRENGTH_H
+#define IR_STRENGTH_H
+
+#include "ir.h"
+
+// ========== 归纳变量与强度削弱 ==========
+//
+// 基本归纳变量是循环头里形如 i = phi [前置块: init], [回边: i + step] 的phi,
+// step是循环不变量。循环中 i * k(k为循环不变量)改写为新的归纳变量
+//   t = phi [前置块: init * k], [回边: t + step * k]
+// 每次迭代只做一次加法, 原来的乘法由死代码删除去掉。
+//
+// 之后把乘、除、取模2的幂常量改写为移位和按位与; 被除数可能为负时按C的向0取整补偏移,
+// 已知非负(从非负常量开始递增的归纳变量)时直接移位。
+
+typedef struct IRStrengthStats {
+    int induction_vars;     // 识别出的基本归纳变量数
+    int reduced_muls;       // 改写为递增的乘法数
+    int shifts;             // 改写为移位/按位与的乘除法数
+} IRStrengthStats;
+
+void ir_function_strength_reduce(IRFunction* function, IRStrengthStats* stats);
+void ir_module_strength_reduce(IRModule* module, IRStrengthStats* stats);
+
+#endif // IR_STRENGTH_H
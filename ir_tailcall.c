@@ -0,0 +1,159 @@
+#include "ir_tailcall.h"
+#include <stdlib.h>
+#include <string.h>
+
+static void* tailcall_alloc(size_t size) {
+    void* ptr = calloc(1, size ? size : 1);
+    if (!ptr) {
+        perror("malloc failed for tail recursion");
+        exit(1);
+    }
+    return ptr;
+}
+
+// 自递归尾调用所在的块, 块末的两条指令是 call 和 ret; 返回个数, sites中依次存放块号
+static int find_self_tail_calls(IRModule* module, int index, int* sites) {
+    IRFunction* function = &module->functions[index];
+    int count = 0;
+    for (int b = 0; b < function->block_count; b++) {
+        const IRBlock* block = &function->blocks[b];
+        for (int i = 0; i < block->instr_count; i++) {
+            const IRInstr* instr = &function->instrs[block->instrs[i]];
+            if (instr->op != IR_CALL) continue;
+            if (ir_instr_args(function, instr)[0].value != index) continue;
+            if (instr->arg_count - 1 != function->param_count) continue;
+            if (!ir_is_tail_call(function, b, i)) continue;
+            sites[count++] = b;
+            break;
+        }
+    }
+    return count;
+}
+
+// 把入口块的指令整体移到新块, 入口块只剩一条跳到新块的jmp; 返回新块
+static int split_entry(IRFunction* function) {
+    int body = ir_new_block(function);
+    IRBlock* entry = &function->blocks[0];
+    IRBlock* moved = &function->blocks[body];
+    IRBlock empty = *moved;
+    moved->instrs = entry->instrs;
+    moved->instr_count = entry->instr_count;
+    moved->instr_capacity = entry->instr_capacity;
+    entry->instrs = empty.instrs;
+    entry->instr_count = empty.instr_count;
+    entry->instr_capacity = empty.instr_capacity;
+    moved->count = entry->count;
+    for (int i = 0; i < moved->instr_count; i++) {
+        function->instrs[moved->instrs[i]].block = body;
+    }
+
+    // 后继块phi中来自入口块的输入改为来自新块
+    for (int s = 0; s < entry->succ_count; s++) {
+        const IRBlock* succ = &function->blocks[entry->succs[s]];
+        for (int i = 0; i < succ->instr_count; i++) {
+            const IRInstr* phi = &function->instrs[succ->instrs[i]];
+            if (phi->op != IR_PHI) break;
+            IROperand* args = ir_instr_args(function, phi);
+            for (int a = 0; a < phi->arg_count; a += 2) {
+                if (args[a].value == 0) args[a] = ir_operand_block(body);
+            }
+        }
+    }
+
+    IROperand target = ir_operand_block(body);
+    ir_emit(function, 0, IR_JMP, IR_TYPE_VOID, false, &target, 1, function->line);
+    return body;
+}
+
+void ir_function_eliminate_tail_recursion(IRModule* module, int index, IRTailCallStats* stats) {
+    IRFunction* function = &module->functions[index];
+    if (!function->is_defined || !function->is_ssa) return;
+    if (ir_function_takes_slot_address(function)) return;
+
+    ir_function_compute_cfg(function);
+    if (function->blocks[0].pred_count > 0) return;
+
+    int* sites = (int*)tailcall_alloc(sizeof(int) * (size_t)function->block_count);
+    int site_count = find_self_tail_calls(module, index, sites);
+    if (site_count == 0) {
+        free(sites);
+        return;
+    }
+
+    int body = split_entry(function);
+    for (int s = 0; s < site_count; s++) {
+        if (sites[s] == 0) sites[s] = body;
+    }
+
+    // profile计数: 原来入口块的计数包括每一轮循环, 新的入口块只在调用时执行
+    int64_t entries = function->blocks[body].count;
+    for (int s = 0; s < site_count && entries >= 0; s++) {
+        int64_t iterations = function->blocks[sites[s]].count;
+        entries = iterations >= 0 && iterations <= entries ? entries - iterations : -1;
+    }
+    function->blocks[0].count = entries;
+
+    // 尾调用和ret改为跳回函数体开头, call先保留到phi取完实参
+    int* calls = (int*)tailcall_alloc(sizeof(int) * (size_t)site_count);
+    for (int s = 0; s < site_count; s++) {
+        IRBlock* block = &function->blocks[sites[s]];
+        int ret = block->instrs[block->instr_count - 1];
+        int line = function->instrs[ret].line;
+        function->instrs[ret].op = IR_NOP;
+        for (int i = block->instr_count - 2; i >= 0; i--) {
+            if (function->instrs[block->instrs[i]].op == IR_CALL) {
+                calls[s] = block->instrs[i];
+                break;
+            }
+        }
+        IROperand target = ir_operand_block(body);
+        ir_emit(function, sites[s], IR_JMP, IR_TYPE_VOID, false, &target, 1, line);
+    }
+    ir_function_compute_cfg(function);
+
+    // 每个参数一个phi: 入口的输入是参数本身, 尾调用处的输入是对应的实参
+    int* phis = (int*)tailcall_alloc(sizeof(int) * (size_t)(function->param_count + 1));
+    for (int p = 0; p < function->param_count; p++) {
+        phis[p] = ir_insert_phi(function, body, (IRType)function->vreg_types[p]);
+        const IRInstr* phi = &function->instrs[phis[p]];
+        IROperand* args = ir_instr_args(function, phi);
+        for (int a = 0; a < phi->arg_count; a += 2) {
+            for (int s = 0; s < site_count; s++) {
+                if (args[a].value != sites[s]) continue;
+                args[a + 1] = ir_instr_args(function, &function->instrs[calls[s]])[1 + p];
+            }
+        }
+    }
+    for (int s = 0; s < site_count; s++) {
+        function->instrs[calls[s]].op = IR_NOP;
+    }
+
+    IROperand* map = (IROperand*)tailcall_alloc(sizeof(IROperand) * (size_t)function->vreg_count);
+    for (int p = 0; p < function->param_count; p++) {
+        map[p] = ir_operand_vreg(function->instrs[phis[p]].dest, (IRType)function->vreg_types[p]);
+    }
+    ir_function_replace_uses(function, map);
+
+    // 替换之后再填入口的输入, 否则它也会被换成phi自己
+    for (int p = 0; p < function->param_count; p++) {
+        const IRInstr* phi = &function->instrs[phis[p]];
+        IROperand* args = ir_instr_args(function, phi);
+        for (int a = 0; a < phi->arg_count; a += 2) {
+            if (args[a].value == 0) args[a + 1] = ir_operand_vreg(p, (IRType)function->vreg_types[p]);
+        }
+    }
+    ir_function_compact(function);
+
+    stats->functions++;
+    stats->tail_calls += site_count;
+    free(map);
+    free(phis);
+    free(calls);
+    free(sites);
+}
+
+void ir_module_eliminate_tail_recursion(IRModule* module, IRTailCallStats* stats) {
+    for (int i = 0; i < module->function_count; i++) {
+        ir_function_eliminate_tail_recursion(module, i, stats);
+    }
+}
@@ -0,0 +1,23 @@
+#ifndef IR_TAILCALL_H
+#define IR_TAILCALL_H
+
+#include "ir.h"
+
+// ========== 尾递归消除 ==========
+//
+// 在SSA形式上把函数对自己的尾调用(call之后紧接着返回它的结果, 见ir_is_tail_call)改为循环:
+//   原来的入口块整体移到新块B, 入口块只剩一条 jmp B;
+//   B开头为每个参数插入phi [入口: %i], [尾调用所在的块: 第i个实参], 函数中对%i的使用都改为这个phi;
+//   尾调用和其后的ret删除, 改为 jmp B。
+// 取了栈槽地址的函数不处理: 实参可能指向本次调用的栈槽, 而循环的下一轮会复用同一个栈槽。
+// 对其他函数的尾调用(以及没有在这里消除的自递归)由后端改为跳转, 见x86_codegen.h和vm.h。
+
+typedef struct IRTailCallStats {
+    int functions;      // 消除了尾递归的函数
+    int tail_calls;     // 改为循环的自递归尾调用
+} IRTailCallStats;
+
+void ir_function_eliminate_tail_recursion(IRModule* module, int index, IRTailCallStats* stats);
+void ir_module_eliminate_tail_recursion(IRModule* module, IRTailCallStats* stats);
+
+#endif // IR_TAILCALL_H
@@ -0,0 +1,528 @@
+#include "ir_unroll.h"
+#include "ir_dom.h"
+#include "ir_loop.h"
+#include <stdlib.h>
+#include <string.h>
+
+// 一个符合条件的计数循环: 归一化为 iv op bound
+typedef struct CountedLoop {
+    int preheader;
+    int header;
+    int body;
+    int exit;
+    int phi_count;          // 循环头开头的phi数
+    int compare;            // 循环头中的比较指令
+    int iv;                 // 归纳变量(循环头的phi)
+    int iv_next;            // 循环体中的 iv + step
+    int step;
+    IROpcode op;            // IR_LT/IR_LE(步长为正)或IR_GT/IR_GE(步长为负)
+    IROperand bound;
+} CountedLoop;
+
+static void* unroll_alloc(size_t size) {
+    void* ptr = calloc(1, size ? size : 1);
+    if (!ptr) {
+        perror("malloc failed for loop unrolling");
+        exit(1);
+    }
+    return ptr;
+}
+
+static bool defined_in(IRFunction* function, int block, int vreg) {
+    const IRBlock* b = &function->blocks[block];
+    for (int i = 0; i < b->instr_count; i++) {
+        if (function->instrs[b->instrs[i]].dest == vreg) return true;
+    }
+    return false;
+}
+
+// 常量和在循环头、循环体之外定义的值
+static bool is_invariant(IRFunction* function, const CountedLoop* loop, IROperand operand) {
+    if (operand.kind == IR_OPERAND_CONST) return true;
+    if (operand.kind != IR_OPERAND_VREG) return false;
+    return !defined_in(function, loop->header, operand.value) && !defined_in(function, loop->body, operand.value);
+}
+
+static IROperand latch_input(IRFunction* function, const IRInstr* phi, int body) {
+    const IROperand* args = ir_instr_args(function, phi);
+    for (int a = 0; a < phi->arg_count; a += 2) {
+        if (args[a].value == body) return args[a + 1];
+    }
+    return args[1];
+}
+
+static IROperand entry_input(IRFunction* function, const IRInstr* phi, int preheader) {
+    const IROperand* args = ir_instr_args(function, phi);
+    for (int a = 0; a < phi->arg_count; a += 2) {
+        if (args[a].value == preheader) return args[a + 1];
+    }
+    return args[1];
+}
+
+static IROpcode swap_compare(IROpcode op) {
+    switch (op) {
+        case IR_LT: return IR_GT;
+        case IR_GT: return IR_LT;
+        case IR_LE: return IR_GE;
+        default:    return IR_LE;
+    }
+}
+
+// ========== 识别 ==========
+
+static bool match_counted_loop(IRFunction* function, const IRLoopInfo* info, int l, const IRUses* uses,
+                               CountedLoop* out) {
+    const IRLoop* loop = &info->loops[l];
+    if (loop->block_count != 2 || loop->preheader < 0) return false;
+    int header = loop->header;
+    int body = info->blocks[loop->block_start + 1];
+    if (info->block_loop[body] != l) return false;
+
+    const IRBlock* h = &function->blocks[header];
+    const IRBlock* b = &function->blocks[body];
+    if (h->pred_count != 2 || b->pred_count != 1) return false;
+    IRInstr* jump = ir_block_terminator(function, body);
+    if (jump->op != IR_JMP) return false;
+    if (b->instr_count - 1 > IR_UNROLL_MAX_BODY) return false;
+
+    // 循环头: phi..., 比较, br 比较, 循环体, 出口
+    int phi_count = 0;
+    while (phi_count < h->instr_count && function->instrs[h->instrs[phi_count]].op == IR_PHI) phi_count++;
+    if (h->instr_count != phi_count + 2) return false;
+    int compare = h->instrs[phi_count];
+    IRInstr* cmp = &function->instrs[compare];
+    IRInstr* br = ir_block_terminator(function, header);
+    const IROperand* br_args = ir_instr_args(function, br);
+    if (br->op != IR_BR || br_args[0].kind != IR_OPERAND_VREG || br_args[0].value != cmp->dest ||
+        br_args[1].value != body || br_args[2].value == body) return false;
+    if (cmp->op != IR_LT && cmp->op != IR_LE && cmp->op != IR_GT && cmp->op != IR_GE) return false;
+    if (ir_uses_count(uses, cmp->dest) != 1) return false;
+
+    // 比较写成 iv op bound
+    const IROperand* cmp_args = ir_instr_args(function, cmp);
+    IROpcode op = (IROpcode)cmp->op;
+    IROperand iv = cmp_args[0];
+    IROperand bound = cmp_args[1];
+    int phi = -1;
+    for (int side = 0; side < 2 && phi < 0; side++) {
+        if (side == 1) {
+            iv = cmp_args[1];
+            bound = cmp_args[0];
+            op = swap_compare((IROpcode)cmp->op);
+        }
+        if (iv.kind != IR_OPERAND_VREG) continue;
+        for (int i = 0; i < phi_count; i++) {
+            if (function->instrs[h->instrs[i]].dest == iv.value) phi = h->instrs[i];
+        }
+    }
+    if (phi < 0) return false;
+    CountedLoop candidate = { loop->preheader, header, body, br_args[2].value, phi_count, compare,
+                              iv.value, -1, 0, op, bound };
+    if (!is_invariant(function, &candidate, bound)) return false;
+
+    // 回边输入是循环体中的 iv + c(或 iv - c)
+    IROperand next = latch_input(function, &function->instrs[phi], body);
+    if (next.kind != IR_OPERAND_VREG) return false;
+    for (int i = 0; i < b->instr_count; i++) {
+        const IRInstr* instr = &function->instrs[b->instrs[i]];
+        if (instr->op == IR_CALL || instr->op == IR_PHI) return false;
+        if (instr->dest != next.value) continue;
+        const IROperand* args = ir_instr_args(function, instr);
+        if (instr->op == IR_ADD && args[0].kind == IR_OPERAND_VREG && args[0].value == iv.value &&
+            args[1].kind == IR_OPERAND_CONST) {
+            candidate.step = args[1].value;
+        } else if (instr->op == IR_ADD && args[1].kind == IR_OPERAND_VREG && args[1].value == iv.value &&
+                   args[0].kind == IR_OPERAND_CONST) {
+            candidate.step = args[0].value;
+        } else if (instr->op == IR_SUB && args[0].kind == IR_OPERAND_VREG && args[0].value == iv.value &&
+                   args[1].kind == IR_OPERAND_CONST && args[1].value != INT32_MIN) {
+            candidate.step = -args[1].value;
+        }
+        candidate.iv_next = next.value;
+    }
+    if (candidate.iv_next < 0 || candidate.step == 0) return false;
+    if (candidate.step > (1 << 24) || candidate.step < -(1 << 24)) return false;
+    bool ascending = op == IR_LT || op == IR_LE;
+    if (ascending != (candidate.step > 0)) return false;
+
+    *out = candidate;
+    return true;
+}
+
+// ========== 向量化的条件 ==========
+
+static bool is_array_base(IRFunction* function, IROperand base) {
+    if (base.kind == IR_OPERAND_SLOT) return function->slots[base.value].type == IR_TYPE_I32;
+    return base.kind == IR_OPERAND_GLOBAL;
+}
+
+static bool indexed_by(IROperand index, int iv) {
+    return index.kind == IR_OPERAND_VREG && index.value == iv;
+}
+
+// 向量循环体同时存活的向量值(含广播的不变量)的最大个数; splat_last是各广播值最后一次使用的位置
+static int vector_pressure(IRFunction* function, const CountedLoop* loop, const bool* vector,
+                           const int* splat_last, int splat_count) {
+    const IRBlock* b = &function->blocks[loop->body];
+    int count = b->instr_count - 1;
+    int* last = (int*)unroll_alloc(sizeof(int) * (size_t)count);
+    for (int i = 0; i < count; i++) {
+        last[i] = -1;
+        int dest = function->instrs[b->instrs[i]].dest;
+        if (dest < 0 || !vector[dest]) continue;
+        for (int j = i + 1; j < count; j++) {
+            const IRInstr* user = &function->instrs[b->instrs[j]];
+            const IROperand* args = ir_instr_args(function, user);
+            for (int a = 0; a < user->arg_count; a++) {
+                if (args[a].kind == IR_OPERAND_VREG && args[a].value == dest) last[i] = j;
+            }
+        }
+    }
+
+    // 位置i的结果与在i之前定值、在i及之后还要使用的值同时存活
+    int pressure = 0;
+    for (int i = 0; i < count; i++) {
+        int dest = function->instrs[b->instrs[i]].dest;
+        int live = dest >= 0 && vector[dest] ? 1 : 0;
+        for (int s = 0; s < splat_count; s++) live += splat_last[s] >= i;
+        for (int j = 0; j < i; j++) live += last[j] >= i;
+        if (live > pressure) pressure = live;
+    }
+    free(last);
+    return pressure;
+}
+
+// 记录由向量计算的值(来自load或向量运算)和要广播的不变量; 返回能否向量化
+static bool plan_vector_body(IRFunction* function, const CountedLoop* loop, bool* vector, IROperand* splats,
+                             int* splat_count) {
+    if (loop->step != 1 || loop->phi_count != 1) return false;
+    const IRBlock* b = &function->blocks[loop->body];
+    int splat_last[IR_UNROLL_MAX_BODY * 2];
+    *splat_count = 0;
+
+    for (int i = 0; i < b->instr_count - 1; i++) {
+        const IRInstr* instr = &function->instrs[b->instrs[i]];
+        const IROperand* args = ir_instr_args(function, instr);
+        if (instr->op == IR_NOP || instr->dest == loop->iv_next) continue;
+
+        // 每个操作数: 向量, 或循环不变量(广播一次)
+        int operands = 0;
+        int first = 0;
+        switch (instr->op) {
+            case IR_LOAD:
+                if (instr->arg_count != 2 || !is_array_base(function, args[0]) ||
+                    !indexed_by(args[1], loop->iv)) return false;
+                break;
+            case IR_STORE:
+                if (instr->arg_count != 3 || !is_array_base(function, args[0]) ||
+                    !indexed_by(args[2], loop->iv) || args[1].type != IR_TYPE_I32) return false;
+                first = 1;
+                operands = 2;
+                break;
+            case IR_ADD: case IR_SUB: case IR_AND:
+                operands = 2;
+                break;
+            case IR_SHL: case IR_SHR:
+                if (args[1].kind != IR_OPERAND_CONST || args[1].value < 0 || args[1].value > 31) return false;
+                operands = 1;
+                break;
+            default:
+                return false;
+        }
+        if (instr->dest >= 0 && instr->type != IR_TYPE_I32) return false;
+
+        bool has_vector = instr->op == IR_LOAD;
+        for (int a = first; a < operands; a++) {
+            IROperand operand = args[a];
+            if (operand.kind == IR_OPERAND_VREG && vector[operand.value]) {
+                has_vector = true;
+                continue;
+            }
+            if (!is_invariant(function, loop, operand)) return false;
+            int s = 0;
+            while (s < *splat_count && !(splats[s].kind == operand.kind && splats[s].value == operand.value)) s++;
+            if (s == *splat_count) splats[(*splat_count)++] = operand;
+            splat_last[s] = i;
+        }
+        // 全由不变量算出的值应该已经被外提, 这里不处理
+        if (!has_vector && instr->op != IR_STORE) return false;
+        if (instr->dest >= 0) vector[instr->dest] = true;
+    }
+    return vector_pressure(function, loop, vector, splat_last, *splat_count) <= IR_VECTOR_MAX_LIVE;
+}
+
+// ========== 改写 ==========
+
+// phi追加一个输入: 操作数整体复制到操作数数组末尾
+static void add_phi_input(IRFunction* function, int phi_id, int block, IROperand value) {
+    IRInstr* phi = &function->instrs[phi_id];
+    int start = function->operand_count;
+    for (int a = 0; a < phi->arg_count + 2; a++) {
+        ARENA_RESERVE(function->arena, function->operands, function->operand_count, function->operand_capacity);
+        function->operand_count++;
+    }
+    memcpy(&function->operands[start], &function->operands[phi->args], sizeof(IROperand) * phi->arg_count);
+    function->operands[start + phi->arg_count] = ir_operand_block(block);
+    function->operands[start + phi->arg_count + 1] = value;
+    phi->args = start;
+    phi->arg_count += 2;
+}
+
+static IROperand map_operand(const IROperand* map, IROperand operand) {
+    if (operand.kind == IR_OPERAND_VREG && map[operand.value].kind != IR_OPERAND_NONE) return map[operand.value];
+    return operand;
+}
+
+// 把循环体复制factor份到block; map开始时是循环头phi的当前值, 结束时是最后一份之后的值
+static void emit_scalar_copies(IRFunction* function, const CountedLoop* loop, int block, int factor,
+                               IROperand* map, const int* phis) {
+    IROperand* next = (IROperand*)unroll_alloc(sizeof(IROperand) * (size_t)loop->phi_count);
+    IROperand args[4];
+    for (int k = 0; k < factor; k++) {
+        const IRBlock* body = &function->blocks[loop->body];
+        for (int i = 0; i < body->instr_count - 1; i++) {
+            int id = function->blocks[loop->body].instrs[i];
+            const IRInstr* instr = &function->instrs[id];
+            if (instr->op == IR_NOP) continue;
+            const IROperand* source = ir_instr_args(function, instr);
+            for (int a = 0; a < instr->arg_count; a++) args[a] = map_operand(map, source[a]);
+            int dest = instr->dest;
+            int line = instr->line;
+            int copy = ir_emit(function, block, (IROpcode)instr->op, (IRType)instr->type, dest >= 0, args,
+                               instr->arg_count, line);
+            if (dest >= 0) map[dest] = ir_operand_vreg(function->instrs[copy].dest, (IRType)function->vreg_types[dest]);
+        }
+        // 各phi同时取回边输入
+        for (int p = 0; p < loop->phi_count; p++) {
+            next[p] = map_operand(map, latch_input(function, &function->instrs[phis[p]], loop->body));
+        }
+        for (int p = 0; p < loop->phi_count; p++) map[function->instrs[phis[p]].dest] = next[p];
+    }
+    free(next);
+}
+
+static IROperand vector_operand(const IROperand* map, const IROperand* splats, const IROperand* splat_values,
+                                int splat_count, IROperand operand) {
+    if (operand.kind == IR_OPERAND_VREG && map[operand.value].kind != IR_OPERAND_NONE) return map[operand.value];
+    for (int s = 0; s < splat_count; s++) {
+        if (splats[s].kind == operand.kind && splats[s].value == operand.value) return splat_values[s];
+    }
+    return operand;
+}
+
+// 一份向量代码处理IR_VECTOR_WIDTH轮; 返回下一组的下标
+static IROperand emit_vector_body(IRFunction* function, const CountedLoop* loop, int block, IROperand iv,
+                                  const IROperand* splats, int splat_count) {
+    IROperand* map = (IROperand*)unroll_alloc(sizeof(IROperand) * (size_t)function->vreg_count);
+    IROperand* splat_values = (IROperand*)unroll_alloc(sizeof(IROperand) * (size_t)(splat_count + 1));
+    int line = function->instrs[loop->compare].line;
+    for (int s = 0; s < splat_count; s++) {
+        int id = ir_emit(function, block, IR_SPLAT, IR_TYPE_V4I32, true, &splats[s], 1, line);
+        splat_values[s] = ir_operand_vreg(function->instrs[id].dest, IR_TYPE_V4I32);
+    }
+
+    IROperand args[3];
+    int count = function->blocks[loop->body].instr_count - 1;
+    for (int i = 0; i < count; i++) {
+        const IRInstr* instr = &function->instrs[function->blocks[loop->body].instrs[i]];
+        if (instr->op == IR_NOP || instr->dest == loop->iv_next) continue;
+        const IROperand* source = ir_instr_args(function, instr);
+        IROpcode op = (IROpcode)instr->op;
+        int dest = instr->dest;
+        line = instr->line;
+        int id;
+        if (op == IR_LOAD) {
+            args[0] = source[0];
+            args[1] = iv;
+            id = ir_emit(function, block, IR_VLOAD, IR_TYPE_V4I32, true, args, 2, line);
+        } else if (op == IR_STORE) {
+            args[0] = source[0];
+            args[1] = vector_operand(map, splats, splat_values, splat_count, source[1]);
+            args[2] = iv;
+            id = ir_emit(function, block, IR_VSTORE, IR_TYPE_VOID, false, args, 3, line);
+        } else {
+            args[0] = vector_operand(map, splats, splat_values, splat_count, source[0]);
+            args[1] = op == IR_SHL || op == IR_SHR
+                          ? source[1]
+                          : vector_operand(map, splats, splat_values, splat_count, source[1]);
+            id = ir_emit(function, block, op, IR_TYPE_V4I32, true, args, 2, line);
+        }
+        if (dest >= 0) map[dest] = ir_operand_vreg(function->instrs[id].dest, IR_TYPE_V4I32);
+    }
+
+    args[0] = iv;
+    args[1] = ir_operand_const(IR_VECTOR_WIDTH, IR_TYPE_I32);
+    int next = ir_emit(function, block, IR_ADD, IR_TYPE_I32, true, args, 2, line);
+    free(splat_values);
+    free(map);
+    return ir_operand_vreg(function->instrs[next].dest, IR_TYPE_I32);
+}
+
+// 在原循环之前插入展开(或向量化)的循环; lim会回绕的常量上界不处理, 返回false
+static bool unroll_loop(IRFunction* function, const CountedLoop* loop, bool vectorize, const IROperand* splats,
+                        int splat_count) {
+    int factor = vectorize ? IR_VECTOR_WIDTH : IR_UNROLL_FACTOR;
+    int32_t span = (factor - 1) * loop->step;
+    int line = function->instrs[loop->compare].line;
+    IROperand limit = loop->bound;
+    if (loop->bound.kind == IR_OPERAND_CONST) {
+        int64_t value = (int64_t)loop->bound.value - span;
+        if (value < INT32_MIN || value > INT32_MAX) return false;
+        limit = ir_operand_const((int32_t)value, IR_TYPE_I32);
+    }
+
+    int* phis = (int*)unroll_alloc(sizeof(int) * (size_t)loop->phi_count);
+    memcpy(phis, function->blocks[loop->header].instrs, sizeof(int) * (size_t)loop->phi_count);
+    int unrolled_header = ir_new_block(function);
+    int unrolled_body = ir_new_block(function);
+
+    // 前置块: 原来跳到循环头, 改为 lim没有回绕 ? 展开的循环头 : 原循环头
+    IRBlock* preheader = &function->blocks[loop->preheader];
+    function->instrs[preheader->instrs[--preheader->instr_count]].op = IR_NOP;
+    IROperand args[3];
+    if (loop->bound.kind == IR_OPERAND_CONST) {
+        args[0] = ir_operand_block(unrolled_header);
+        ir_emit(function, loop->preheader, IR_JMP, IR_TYPE_VOID, false, args, 1, line);
+    } else {
+        args[0] = loop->bound;
+        args[1] = ir_operand_const(span, IR_TYPE_I32);
+        int sub = ir_emit(function, loop->preheader, IR_SUB, IR_TYPE_I32, true, args, 2, line);
+        limit = ir_operand_vreg(function->instrs[sub].dest, IR_TYPE_I32);
+        args[0] = limit;
+        args[1] = loop->bound;
+        int guard = ir_emit(function, loop->preheader, loop->step > 0 ? IR_LT : IR_GT, IR_TYPE_BOOL, true, args,
+                            2, line);
+        args[0] = ir_operand_vreg(function->instrs[guard].dest, IR_TYPE_BOOL);
+        args[1] = ir_operand_block(unrolled_header);
+        args[2] = ir_operand_block(loop->header);
+        ir_emit(function, loop->preheader, IR_BR, IR_TYPE_VOID, false, args, 3, line);
+    }
+
+    // 展开的循环头: 每个phi一份, 回边输入最后填写
+    IROperand* map = (IROperand*)unroll_alloc(sizeof(IROperand) * (size_t)function->vreg_count);
+    int* copies = (int*)unroll_alloc(sizeof(int) * (size_t)loop->phi_count);
+    for (int p = 0; p < loop->phi_count; p++) {
+        const IRInstr* phi = &function->instrs[phis[p]];
+        IRType type = (IRType)phi->type;
+        int dest = phi->dest;
+        args[0] = ir_operand_block(loop->preheader);
+        args[1] = entry_input(function, phi, loop->preheader);
+        copies[p] = ir_emit(function, unrolled_header, IR_PHI, type, true, args, 2, phi->line);
+        map[dest] = ir_operand_vreg(function->instrs[copies[p]].dest, type);
+    }
+    IROperand iv = map[loop->iv];
+    args[0] = iv;
+    args[1] = limit;
+    int cond = ir_emit(function, unrolled_header, loop->op, IR_TYPE_BOOL, true, args, 2, line);
+    args[0] = ir_operand_vreg(function->instrs[cond].dest, IR_TYPE_BOOL);
+    args[1] = ir_operand_block(unrolled_body);
+    args[2] = ir_operand_block(loop->header);
+    ir_emit(function, unrolled_header, IR_BR, IR_TYPE_VOID, false, args, 3, line);
+
+    // 展开的循环体
+    if (vectorize) {
+        map[loop->iv] = emit_vector_body(function, loop, unrolled_body, iv, splats, splat_count);
+    } else {
+        emit_scalar_copies(function, loop, unrolled_body, factor, map, phis);
+    }
+    args[0] = ir_operand_block(unrolled_header);
+    ir_emit(function, unrolled_body, IR_JMP, IR_TYPE_VOID, false, args, 1, line);
+
+    // 展开的循环头的回边输入; 原循环头的phi增加来自展开的循环头的输入,
+    // 常量上界时前置块不再直接进入原循环, 这个输入替换来自前置块的输入
+    for (int p = 0; p < loop->phi_count; p++) {
+        int dest = function->instrs[phis[p]].dest;
+        add_phi_input(function, copies[p], unrolled_body, map[dest]);
+        IRType type = (IRType)function->instrs[copies[p]].type;
+        IROperand value = ir_operand_vreg(function->instrs[copies[p]].dest, type);
+        if (loop->bound.kind != IR_OPERAND_CONST) {
+            add_phi_input(function, phis[p], unrolled_header, value);
+            continue;
+        }
+        IRInstr* phi = &function->instrs[phis[p]];
+        IROperand* inputs = ir_instr_args(function, phi);
+        for (int a = 0; a < phi->arg_count; a += 2) {
+            if (inputs[a].value != loop->preheader) continue;
+            inputs[a].value = unrolled_header;
+            inputs[a + 1] = value;
+        }
+    }
+    ir_function_compute_cfg(function);
+
+    free(copies);
+    free(map);
+    free(phis);
+    return true;
+}
+
+// ========== 入口 ==========
+
+// 有profile(见profile.h)时, 平均每次进入循环执行循环体不到IR_UNROLL_FACTOR次的循环不展开:
+// 展开的循环一轮也执行不了, 只增加代码和一次多余的比较
+static bool worth_unrolling(const IRFunction* function, const CountedLoop* loop) {
+    int64_t header = function->blocks[loop->header].count;
+    int64_t body = function->blocks[loop->body].count;
+    if (header < 0 || body < 0 || body > header) return true;
+    return body > 0 && body >= IR_UNROLL_FACTOR * (header - body);
+}
+
+void ir_function_unroll(IRFunction* function, IRUnrollStats* stats) {
+    if (!function->is_defined || function->block_count == 0 || !function->is_ssa) return;
+
+    IRDomTree* dom = ir_dom_tree_create(function);
+    IRLoopInfo* loops = ir_loop_info_create(function, dom);
+    if (loops->loop_count == 0) {
+        ir_loop_info_destroy(loops);
+        ir_dom_tree_destroy(dom);
+        return;
+    }
+    if (ir_loop_insert_preheaders(function, loops) > 0) {
+        ir_loop_info_destroy(loops);
+        ir_dom_tree_destroy(dom);
+        dom = ir_dom_tree_create(function);
+        loops = ir_loop_info_create(function, dom);
+    }
+
+    // 先找出全部计数循环再改写: 它们都是最内层循环, 改写一个不影响其他循环的块
+    IRUses* uses = ir_uses_create(function);
+    CountedLoop* counted = (CountedLoop*)unroll_alloc(sizeof(CountedLoop) * (size_t)loops->loop_count);
+    int count = 0;
+    for (int l = 0; l < loops->loop_count; l++) {
+        if (match_counted_loop(function, loops, l, uses, &counted[count])) count++;
+    }
+    ir_uses_destroy(uses);
+    ir_loop_info_destroy(loops);
+    ir_dom_tree_destroy(dom);
+
+    IRUnrollStats local;
+    memset(&local, 0, sizeof(local));
+    IROperand splats[IR_UNROLL_MAX_BODY * 2];
+    for (int c = 0; c < count; c++) {
+        local.counted_loops++;
+        if (!worth_unrolling(function, &counted[c])) {
+            local.short_loops++;
+            continue;
+        }
+        bool* vector = (bool*)unroll_alloc(sizeof(bool) * (size_t)function->vreg_count);
+        int splat_count = 0;
+        bool vectorize = plan_vector_body(function, &counted[c], vector, splats, &splat_count);
+        free(vector);
+        if (!unroll_loop(function, &counted[c], vectorize, splats, splat_count)) continue;
+        if (vectorize) local.vectorized_loops++;
+        else local.unrolled_loops++;
+    }
+    free(counted);
+
+    if (stats) {
+        stats->counted_loops += local.counted_loops;
+        stats->unrolled_loops += local.unrolled_loops;
+        stats->vectorized_loops += local.vectorized_loops;
+        stats->short_loops += local.short_loops;
+    }
+}
+
+void ir_module_unroll(IRModule* module, IRUnrollStats* stats) {
+    for (int i = 0; i < module->function_count; i++) {
+        ir_function_unroll(&module->functions[i], stats);
+    }
+}
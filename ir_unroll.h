@@ -0,0 +1,42 @@
+#ifndef IR_UNROLL_H
+#define IR_UNROLL_H
+
+#include "ir.h"
+
+// ========== 循环展开与向量化 ==========
+//
+// 处理最内层的计数循环: 循环头只有phi、一个比较和br, 循环体是一个跳回循环头的基本块且没有调用;
+// 比较是 i < n 或 i <= n(步长为负时 i > n 或 i >= n), i是循环头里形如
+// i = phi [前置块: init], [循环体: i + c] 的归纳变量(c为常量), n在循环外定义。
+//
+// 在原循环之前插入展开的循环, 原循环留作处理最后不足一轮的余数循环:
+//   前置块:       lim = n - (F-1)*c; lim没有回绕时进入展开的循环, 否则直接进入原循环
+//   展开的循环头: 每个phi一份; br i' < lim, 展开的循环体, 原循环头
+//   展开的循环体: 原循环体复制F份, 后一份的phi值取前一份算出的回边输入
+// 原循环头的phi增加来自展开的循环头的输入, 循环之后对phi的使用不变。
+//
+// 循环体满足以下条件时, 展开的循环体改为一份向量代码(IR_VECTOR_WIDTH个int一组, x86-64上用SSE2):
+//   - 步长为1, 循环头除了i没有别的phi, i只用作数组下标和自增
+//   - load/store都是 a[i] 的形式, a是没有提升的栈槽或全局数组(不经指针): 不同的数组互不重叠,
+//     第i轮只访问各数组的第i个元素, 各轮之间没有依赖, 对4个元素同时按原顺序执行每一步
+//     与逐轮执行的结果相同
+//   - 其余的计算是add、sub、and和常量移位, 操作数来自这些load或者是循环不变量(广播为向量)
+// 乘法没有SSE2指令(pmulld要SSE4.1), 含乘法的循环只展开; 浮点数还不能转换为IR, 只处理int。
+// 有profile时, 循环头和循环体的计数给出平均迭代次数, 不到IR_UNROLL_FACTOR次的循环不展开。
+
+#define IR_UNROLL_FACTOR 4
+#define IR_VECTOR_WIDTH 4
+#define IR_UNROLL_MAX_BODY 32       // 循环体最多的指令数(不含跳转)
+#define IR_VECTOR_MAX_LIVE 16       // 向量循环体中同时存活的向量值最多的个数(x86-64有16个xmm寄存器)
+
+typedef struct IRUnrollStats {
+    int counted_loops;      // 符合条件的计数循环
+    int unrolled_loops;     // 展开的循环
+    int vectorized_loops;   // 向量化的循环
+    int short_loops;        // profile中平均迭代次数太少而不展开的循环
+} IRUnrollStats;
+
+void ir_function_unroll(IRFunction* function, IRUnrollStats* stats);
+void ir_module_unroll(IRModule* module, IRUnrollStats* stats);
+
+#endif // IR_UNROLL_H
@@ -0,0 +1,313 @@
+#include "ir_verify.h"
+#include "ir_dom.h"
+#include <stdlib.h>
+#include <stdarg.h>
+
+#define VERIFY_MAX_ERRORS 20
+
+typedef struct Verifier {
+    const IRModule* module;
+    IRFunction* function;
+    FILE* err;
+    int error_count;
+
+    int* def_block;     // 虚拟寄存器 → 定值所在块(参数为入口块), -1表示未定值
+    int* def_index;     // 虚拟寄存器 → 定值在块内的位置(参数为-1)
+} Verifier;
+
+static void verify_error(Verifier* verifier, int block, const char* format, ...) {
+    verifier->error_count++;
+    if (verifier->error_count > VERIFY_MAX_ERRORS) return;
+
+    fprintf(verifier->err, "\033[31mIR校验错误 (@%s, bb%d): ", verifier->function->name, block);
+
+    va_list args;
+    va_start(args, format);
+    vfprintf(verifier->err, format, args);
+    va_end(args);
+
+    fprintf(verifier->err, "\033[0m\n");
+}
+
+static bool live_block(const IRFunction* function, int block) {
+    return block >= 0 && block < function->block_count &&
+           (block == 0 || function->blocks[block].instr_count > 0);
+}
+
+// ========== 结构 ==========
+
+static void verify_operand(Verifier* verifier, int block, const IRInstr* instr, IROperand operand) {
+    IRFunction* function = verifier->function;
+    const char* op = ir_opcode_name((IROpcode)instr->op);
+
+    switch (operand.kind) {
+        case IR_OPERAND_VREG:
+            if (operand.value < 0 || operand.value >= function->vreg_count) {
+                verify_error(verifier, block, "%s 使用了不存在的虚拟寄存器 %%%d", op, operand.value);
+            } else if (function->vreg_types[operand.value] != operand.type) {
+                verify_error(verifier, block, "%s 的操作数 %%%d 类型为 %s, 定值类型为 %s", op,
+                             operand.value, ir_type_name((IRType)operand.type),
+                             ir_type_name((IRType)function->vreg_types[operand.value]));
+            }
+            break;
+        case IR_OPERAND_SLOT:
+            if (operand.value < 0 || operand.value >= function->slot_count) {
+                verify_error(verifier, block, "%s 使用了不存在的栈槽 $%d", op, operand.value);
+            } else if (function->slots[operand.value].promoted) {
+                verify_error(verifier, block, "%s 访问了已提升的栈槽 $%d", op, operand.value);
+            }
+            break;
+        case IR_OPERAND_GLOBAL:
+            if (operand.value < 0 || operand.value >= verifier->module->global_count) {
+                verify_error(verifier, block, "%s 使用了不存在的全局变量 %d", op, operand.value);
+            }
+            break;
+        case IR_OPERAND_FUNC:
+            if (operand.value < 0 || operand.value >= verifier->module->function_count) {
+                verify_error(verifier, block, "%s 调用了不存在的函数 %d", op, operand.value);
+            }
+            break;
+        case IR_OPERAND_BLOCK:
+            if (!live_block(function, operand.value)) {
+                verify_error(verifier, block, "%s 指向不存在或已删除的基本块 bb%d", op, operand.value);
+            }
+            break;
+        case IR_OPERAND_NONE:
+            verify_error(verifier, block, "%s 有空操作数", op);
+            break;
+        default:
+            break;
+    }
+}
+
+static bool has_succ(const IRBlock* block, int succ) {
+    for (int s = 0; s < block->succ_count; s++) {
+        if (block->succs[s] == succ) return true;
+    }
+    return false;
+}
+
+static bool has_pred(const IRBlock* block, int pred) {
+    for (int p = 0; p < block->pred_count; p++) {
+        if (block->preds[p] == pred) return true;
+    }
+    return false;
+}
+
+static void verify_block(Verifier* verifier, int b) {
+    IRFunction* function = verifier->function;
+    IRBlock* block = &function->blocks[b];
+
+    if (block->instr_count == 0) {
+        if (b == 0) verify_error(verifier, b, "入口块为空");
+        if (block->pred_count > 0) verify_error(verifier, b, "已删除的基本块仍有前驱");
+        return;
+    }
+
+    bool seen_non_phi = false;
+    for (int i = 0; i < block->instr_count; i++) {
+        int id = block->instrs[i];
+        if (id < 0 || id >= function->instr_count) {
+            verify_error(verifier, b, "指令编号 %d 越界", id);
+            continue;
+        }
+
+        IRInstr* instr = &function->instrs[id];
+        IROperand* args = ir_instr_args(function, instr);
+        if (instr->block != b) {
+            verify_error(verifier, b, "指令 %d 记录的所属块为 bb%d", id, instr->block);
+        }
+        if (instr->op == IR_NOP) {
+            continue;
+        }
+        if (ir_opcode_is_terminator((IROpcode)instr->op) != (i == block->instr_count - 1)) {
+            verify_error(verifier, b, i == block->instr_count - 1 ? "基本块没有以终结指令结束"
+                                                                 : "终结指令 %s 不在块尾",
+                         ir_opcode_name((IROpcode)instr->op));
+        }
+
+        if (instr->op == IR_PHI) {
+            if (seen_non_phi) verify_error(verifier, b, "phi 不在块首");
+            if (instr->arg_count != block->pred_count * 2) {
+                verify_error(verifier, b, "phi %%%d 有 %d 个输入, 块有 %d 个前驱", instr->dest,
+                             instr->arg_count / 2, block->pred_count);
+            }
+            for (int a = 0; a + 1 < instr->arg_count; a += 2) {
+                if (args[a].kind != IR_OPERAND_BLOCK || !has_pred(block, args[a].value)) {
+                    verify_error(verifier, b, "phi %%%d 的输入块 bb%d 不是前驱", instr->dest,
+                                 args[a].value);
+                }
+                for (int other = 0; other < a; other += 2) {
+                    if (args[other].value == args[a].value) {
+                        verify_error(verifier, b, "phi %%%d 有重复的输入块 bb%d", instr->dest,
+                                     args[a].value);
+                    }
+                }
+                verify_operand(verifier, b, instr, args[a + 1]);
+            }
+        } else {
+            seen_non_phi = true;
+            for (int a = 0; a < instr->arg_count; a++) {
+                verify_operand(verifier, b, instr, args[a]);
+            }
+        }
+
+        if (instr->dest >= 0) {
+            if (instr->dest >= function->vreg_count) {
+                verify_error(verifier, b, "结果寄存器 %%%d 越界", instr->dest);
+            } else if (verifier->def_block[instr->dest] >= 0) {
+                verify_error(verifier, b, "虚拟寄存器 %%%d 被多次定值", instr->dest);
+            } else if (function->vreg_types[instr->dest] != instr->type) {
+                verify_error(verifier, b, "%%%d 的定值类型与寄存器类型不一致", instr->dest);
+            } else {
+                verifier->def_block[instr->dest] = b;
+                verifier->def_index[instr->dest] = i;
+            }
+        }
+    }
+
+    // 控制流图与终结指令一致
+    IRInstr* term = ir_block_terminator(function, b);
+    if (term && ir_opcode_is_terminator((IROpcode)term->op)) {
+        IROperand* args = ir_instr_args(function, term);
+        int expected = 0;
+        if (term->op == IR_JMP) {
+            expected = 1;
+            if (!has_succ(block, args[0].value)) {
+                verify_error(verifier, b, "后继中缺少跳转目标 bb%d", args[0].value);
+            }
+        } else if (term->op == IR_BR) {
+            expected = args[1].value == args[2].value ? 1 : 2;
+            if (!has_succ(block, args[1].value) || !has_succ(block, args[2].value)) {
+                verify_error(verifier, b, "后继与分支目标不一致");
+            }
+        }
+        if (block->succ_count != expected) {
+            verify_error(verifier, b, "有 %d 个后继, 终结指令有 %d 个目标", block->succ_count, expected);
+        }
+    }
+    for (int s = 0; s < block->succ_count; s++) {
+        if (!has_pred(&function->blocks[block->succs[s]], b)) {
+            verify_error(verifier, b, "后继 bb%d 的前驱中没有本块", block->succs[s]);
+        }
+    }
+    for (int p = 0; p < block->pred_count; p++) {
+        int pred = block->preds[p];
+        if (!live_block(function, pred) || !has_succ(&function->blocks[pred], b)) {
+            verify_error(verifier, b, "前驱 bb%d 不跳转到本块", pred);
+        }
+    }
+}
+
+// ========== SSA支配关系 ==========
+
+// 定值是否在(block, index)处的使用之前执行; index为块长度表示块的出口
+static bool def_dominates(const Verifier* verifier, const IRDomTree* dom, int vreg, int block, int index) {
+    int def_block = verifier->def_block[vreg];
+    if (def_block < 0) return false;
+    if (def_block == block) return verifier->def_index[vreg] < index;
+    return ir_dom_dominates(dom, def_block, block);
+}
+
+static void verify_dominance(Verifier* verifier) {
+    IRFunction* function = verifier->function;
+    IRDomTree* dom = ir_dom_tree_create(function);
+
+    for (int b = 0; b < function->block_count; b++) {
+        IRBlock* block = &function->blocks[b];
+        if (block->instr_count == 0) continue;
+        if (!ir_dom_reachable(dom, b)) {
+            verify_error(verifier, b, "SSA形式中存在不可达的基本块");
+            continue;
+        }
+
+        for (int i = 0; i < block->instr_count; i++) {
+            IRInstr* instr = &function->instrs[block->instrs[i]];
+            IROperand* args = ir_instr_args(function, instr);
+            if (instr->op == IR_NOP) continue;
+
+            if (instr->op == IR_PHI) {
+                if (instr->type == IR_TYPE_V4I32) {
+                    verify_error(verifier, b, "phi %%%d 的类型不能是向量", instr->dest);
+                }
+                for (int a = 0; a + 1 < instr->arg_count; a += 2) {
+                    IROperand value = args[a + 1];
+                    int pred = args[a].value;
+                    if (value.kind != IR_OPERAND_VREG || pred < 0 || pred >= function->block_count ||
+                        value.value < 0 || value.value >= function->vreg_count) continue;
+                    if (!def_dominates(verifier, dom, value.value, pred,
+                                       function->blocks[pred].instr_count)) {
+                        verify_error(verifier, b, "phi %%%d 的输入 %%%d 的定值不支配前驱 bb%d",
+                                     instr->dest, value.value, pred);
+                    }
+                }
+                continue;
+            }
+
+            for (int a = 0; a < instr->arg_count; a++) {
+                if (args[a].kind != IR_OPERAND_VREG ||
+                    args[a].value < 0 || args[a].value >= function->vreg_count) continue;
+                if (!def_dominates(verifier, dom, args[a].value, b, i)) {
+                    verify_error(verifier, b, "%s 使用的 %%%d 的定值不支配该使用",
+                                 ir_opcode_name((IROpcode)instr->op), args[a].value);
+                } else if (args[a].type == IR_TYPE_V4I32 && verifier->def_block[args[a].value] != b) {
+                    verify_error(verifier, b, "向量 %%%d 在定值的块之外使用", args[a].value);
+                }
+            }
+        }
+    }
+    ir_dom_tree_destroy(dom);
+}
+
+// ========== 入口 ==========
+
+bool ir_function_verify(const IRModule* module, IRFunction* function, FILE* err) {
+    if (!function->is_defined) return true;
+
+    Verifier verifier;
+    verifier.module = module;
+    verifier.function = function;
+    verifier.err = err;
+    verifier.error_count = 0;
+
+    int vreg_count = function->vreg_count > 0 ? function->vreg_count : 1;
+    verifier.def_block = (int*)malloc(sizeof(int) * (size_t)vreg_count);
+    verifier.def_index = (int*)malloc(sizeof(int) * (size_t)vreg_count);
+    if (!verifier.def_block || !verifier.def_index) {
+        perror("malloc failed for Verifier");
+        exit(1);
+    }
+    for (int v = 0; v < function->vreg_count; v++) {
+        verifier.def_block[v] = v < function->param_count ? 0 : -1;
+        verifier.def_index[v] = -1;
+    }
+
+    if (function->block_count == 0) {
+        verify_error(&verifier, 0, "函数没有基本块");
+    }
+    for (int b = 0; b < function->block_count; b++) {
+        verify_block(&verifier, b);
+    }
+    if (function->is_ssa && verifier.error_count == 0) {
+        verify_dominance(&verifier);
+    }
+
+    if (verifier.error_count > VERIFY_MAX_ERRORS) {
+        fprintf(err, "\033[31mIR校验: @%s 共 %d 个错误, 省略其余 %d 个\033[0m\n", function->name,
+                verifier.error_count, verifier.error_count - VERIFY_MAX_ERRORS);
+    }
+
+    free(verifier.def_block);
+    free(verifier.def_index);
+    return verifier.error_count == 0;
+}
+
+bool ir_module_verify(const IRModule* module, FILE* err) {
+    bool ok = true;
+    for (int i = 0; i < module->function_count; i++) {
+        if (!ir_function_verify(module, &module->functions[i], err)) {
+            ok = false;
+        }
+    }
+    return ok;
+}
@@ -0,0 +1,22 @@
+#ifndef IR_VERIFY_H
+#define IR_VERIFY_H
+
+#include "ir.h"
+#include <stdio.h>
+#include <stdbool.h>
+
+// ========== IR校验 ==========
+//
+// 检查IR的结构是否正确, 发现的问题写入err:
+//   - 每个非空基本块以且仅以一条终结指令结束, 跳转目标存在且非空
+//   - 前驱/后继与终结指令一致, 操作数编号在范围内, 虚拟寄存器类型一致
+//   - 每个虚拟寄存器只定值一次
+//   - SSA形式下: phi只出现在块首且与前驱一一对应, 已提升的栈槽不再被访问,
+//     每个使用都被其定值支配(phi的操作数被对应前驱的出口支配), 向量值只在定值的块内使用
+// 各优化遍之后都应能通过校验。
+
+bool ir_function_verify(const IRModule* module, IRFunction* function, FILE* err);
+// 校验模块中全部已定义的函数, 返回是否全部通过
+bool ir_module_verify(const IRModule* module, FILE* err);
+
+#endif // IR_VERIFY_H
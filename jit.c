@@ -0,0 +1,194 @@
+#define _GNU_SOURCE
+
+#include "jit.h"
+#include <dlfcn.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+// 跳板: jmp *2(%rip), 两字节填充, 8字节目标地址
+#define JIT_STUB_SIZE 16
+
+static void* jit_alloc(size_t size) {
+    void* ptr = calloc(1, size ? size : 1);
+    if (!ptr) {
+        perror("malloc failed for JIT");
+        exit(1);
+    }
+    return ptr;
+}
+
+static size_t align_size(size_t value, size_t align) {
+    return (value + align - 1) / align * align;
+}
+
+static void write_stub(uint8_t* stub, void* target) {
+    static const uint8_t jump[8] = { 0xFF, 0x25, 0x02, 0x00, 0x00, 0x00, 0xCC, 0xCC };
+    uint64_t address = (uint64_t)(uintptr_t)target;
+    memcpy(stub, jump, sizeof(jump));
+    memcpy(stub + sizeof(jump), &address, sizeof(address));
+}
+
+// globals为NULL时全局变量放在代码页之后; 否则使用已有的全局变量, 代码页尽量映射在它们附近
+static JitProgram* jit_load(const X86Module* module, const X86Code* code, void* const* globals,
+                            void* const* linked, FILE* err) {
+    const IRModule* ir = module->ir;
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+
+    // 模块之外的函数(外部函数和其他程序中已装入的函数)各需要一个跳板
+    bool* in_module = (bool*)jit_alloc(sizeof(bool) * (size_t)ir->function_count);
+    for (int i = 0; i < module->function_count; i++) in_module[module->functions[i].ir_index] = true;
+    int32_t* stub_index = (int32_t*)jit_alloc(sizeof(int32_t) * (size_t)ir->function_count);
+    int stub_count = 0;
+    for (int i = 0; i < ir->function_count; i++) stub_index[i] = -1;
+    for (int i = 0; i < code->reloc_count; i++) {
+        const X86Reloc* reloc = &code->relocs[i];
+        if (reloc->kind != X86_RELOC_PLT32 || in_module[reloc->symbol]) continue;
+        if (stub_index[reloc->symbol] < 0) stub_index[reloc->symbol] = stub_count++;
+    }
+
+    // 全局变量按元素大小对齐, 放在代码页之后
+    size_t* global_offsets = (size_t*)jit_alloc(sizeof(size_t) * (size_t)ir->global_count);
+    size_t data_size = 0;
+    for (int i = 0; !globals && i < ir->global_count; i++) {
+        size_t elem = ir->globals[i].type == IR_TYPE_PTR ? 8 : 4;
+        data_size = align_size(data_size, elem);
+        global_offsets[i] = data_size;
+        data_size += elem * (size_t)ir->globals[i].count;
+    }
+
+    size_t stub_base = align_size(code->text.length, 16);
+    size_t code_size = align_size(stub_base + JIT_STUB_SIZE * (size_t)stub_count, page);
+    size_t size = code_size + align_size(data_size, page);
+    if (size == 0) size = page;
+
+    // 只是提示: 紧挨着全局变量的地址被占用时内核另选, 通常仍在同一映射区内
+    void* hint = NULL;
+    if (globals && ir->global_count > 0 && (uintptr_t)globals[0] > size + page) {
+        hint = (void*)(((uintptr_t)globals[0] - size) / page * page);
+    }
+
+    JitProgram* program = (JitProgram*)jit_alloc(sizeof(JitProgram));
+    program->ir = ir;
+    program->functions = (void**)jit_alloc(sizeof(void*) * (size_t)ir->function_count);
+    program->globals = (void**)jit_alloc(sizeof(void*) * (size_t)(ir->global_count + 1));
+    program->toplevel = -1;
+    program->size = size;
+    program->code_size = code_size;
+    program->memory = (uint8_t*)mmap(hint, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    bool ok = program->memory != MAP_FAILED;
+    if (!ok) {
+        program->memory = NULL;
+        fprintf(err, "JIT: 无法映射内存: %s\n", strerror(errno));
+    }
+
+    uint8_t* memory = program->memory;
+    uint8_t* data = ok ? memory + code_size : NULL;
+    if (ok) {
+        if (code->text.length > 0) memcpy(memory, code->text.data, code->text.length);
+        for (int i = 0; i < module->function_count; i++) {
+            const X86Function* function = &module->functions[i];
+            program->functions[function->ir_index] = memory + code->function_offsets[i];
+            if (!function->is_global) program->toplevel = function->ir_index;
+        }
+    }
+    for (int i = 0; ok && i < ir->function_count; i++) {
+        if (stub_index[i] < 0) continue;
+        void* target = linked ? linked[i] : NULL;
+        if (!target && ir->functions[i].is_defined) {
+            fprintf(err, "JIT: 函数 %s 还没有装入\n", ir->functions[i].name);
+            ok = false;
+            break;
+        }
+        if (!target) target = dlsym(RTLD_DEFAULT, ir->functions[i].name);
+        if (!target) {
+            fprintf(err, "JIT: 找不到外部函数 %s\n", ir->functions[i].name);
+            ok = false;
+            break;
+        }
+        uint8_t* stub = memory + stub_base + JIT_STUB_SIZE * (size_t)stub_index[i];
+        write_stub(stub, target);
+        program->functions[i] = stub;
+    }
+    for (int i = 0; ok && i < ir->global_count; i++) {
+        program->globals[i] = globals ? globals[i] : data + global_offsets[i];
+    }
+    // 映射的内存全是0, 只需写有初值的标量
+    for (int i = 0; ok && !globals && i < ir->global_count; i++) {
+        const IRGlobal* global = &ir->globals[i];
+        if (global->count != 1 || global->init == 0) continue;
+        int64_t value = global->init;
+        memcpy(data + global_offsets[i], &value, global->type == IR_TYPE_PTR ? 8 : 4);
+    }
+
+    // 字段 = 目标地址 + addend - 字段地址; 全局变量在同一次映射中时一定在2GB以内
+    for (int i = 0; ok && i < code->reloc_count; i++) {
+        const X86Reloc* reloc = &code->relocs[i];
+        uint8_t* field = memory + reloc->offset;
+        uint8_t* target = reloc->kind == X86_RELOC_PLT32 ? (uint8_t*)program->functions[reloc->symbol]
+                                                         : (uint8_t*)program->globals[reloc->symbol];
+        int64_t value = (int64_t)((intptr_t)target + reloc->addend - (intptr_t)field);
+        if (value != (int32_t)value) {
+            fprintf(err, "JIT: 代码与全局变量 %s 相距超过2GB\n", ir->globals[reloc->symbol].name);
+            ok = false;
+            break;
+        }
+        int32_t field_value = (int32_t)value;
+        memcpy(field, &field_value, sizeof(field_value));
+    }
+
+    if (ok && mprotect(memory, code_size, PROT_READ | PROT_EXEC) != 0) {
+        fprintf(err, "JIT: 无法把代码设为可执行: %s\n", strerror(errno));
+        ok = false;
+    }
+
+    free(global_offsets);
+    free(stub_index);
+    free(in_module);
+    if (!ok) {
+        jit_program_destroy(program);
+        return NULL;
+    }
+    return program;
+}
+
+JitProgram* jit_program_create(const X86Module* module, const X86Code* code, FILE* err) {
+    return jit_load(module, code, NULL, NULL, err);
+}
+
+JitProgram* jit_program_create_linked(const X86Module* module, const X86Code* code, void* const* globals,
+                                      void* const* functions, FILE* err) {
+    return jit_load(module, code, globals, functions, err);
+}
+
+void jit_program_destroy(JitProgram* program) {
+    if (!program) return;
+    if (program->memory) munmap(program->memory, program->size);
+    free(program->functions);
+    free(program->globals);
+    free(program);
+}
+
+void* jit_program_lookup(const JitProgram* program, const char* name) {
+    for (int i = 0; i < program->ir->function_count; i++) {
+        if (strcmp(program->ir->functions[i].name, name) == 0) return program->functions[i];
+    }
+    return NULL;
+}
+
+bool jit_program_run(JitProgram* program, int* status, FILE* err) {
+    void* entry = jit_program_lookup(program, "main");
+    if (!entry) {
+        fprintf(err, "JIT: 没有main函数\n");
+        return false;
+    }
+    if (program->toplevel >= 0) {
+        void (*toplevel)(void) = (void (*)(void))program->functions[program->toplevel];
+        toplevel();
+    }
+    int (*main_function)(void) = (int (*)(void))entry;
+    *status = main_function();
+    return true;
+}
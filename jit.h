@@ -0,0 +1,44 @@
+#ifndef JIT_H
+#define JIT_H
+
+#include <stdio.h>
+#include "x86_encode.h"
+
+// ========== 进程内JIT ==========
+//
+// 把编码好的机器码装入mmap得到的内存直接执行, 不经过汇编器、链接器和临时文件。
+// 一次mmap: [机器码][外部函数的跳板] | [全局变量]
+// 先按可读写映射, 写入代码并填好重定位后再把代码页mprotect为只读可执行,
+// 任何时刻都没有同时可写又可执行的页。
+// 没有定义的函数按名字用dlsym在本进程(C库)中查找, call经跳板 jmp *addr(%rip) 到达,
+// 因此rel32的call不受C库加载位置的影响。
+// 分层执行(tiered.h)每次只装入模块的一部分函数, 与字节码虚拟机共用全局变量区,
+// 调用其他部分中已经装入的函数也经跳板。
+
+typedef struct JitProgram {
+    uint8_t* memory;
+    size_t size;            // 映射的总长度(与已有全局变量链接时只有代码页)
+    size_t code_size;       // 代码页(机器码和跳板)的长度
+    const IRModule* ir;     // 按名字查找函数(装入之后模块仍须保留)
+    void** functions;       // IR函数编号 → 入口地址
+    void** globals;         // IR全局变量编号 → 地址
+    int toplevel;           // __toplevel的IR函数编号, -1表示没有顶层语句
+} JitProgram;
+
+// 装入模块; 外部函数找不到或映射失败时把原因写到err并返回NULL
+JitProgram* jit_program_create(const X86Module* module, const X86Code* code, FILE* err);
+
+// 与已有的全局变量和函数链接后装入: globals[i]是IR全局变量i的地址(布局与本机代码相同),
+// functions[i]不为NULL时是模块之外已经装入的函数i的入口(可以为NULL, 这时模块调用的已定义函数都必须在模块中)。
+// 代码页尽量映射在全局变量附近, rip相对位移超出32位时失败
+JitProgram* jit_program_create_linked(const X86Module* module, const X86Code* code, void* const* globals,
+                                      void* const* functions, FILE* err);
+void jit_program_destroy(JitProgram* program);
+
+// 函数的入口地址, 没有时返回NULL
+void* jit_program_lookup(const JitProgram* program, const char* name);
+
+// 先执行顶层语句再调用main, main的返回值写入status; 没有main时返回false并写错误到err
+bool jit_program_run(JitProgram* program, int* status, FILE* err);
+
+#endif // JIT_H
@@ -1,25 +1,24 @@
+#define _POSIX_C_SOURCE 200809L
+
 #include "lexer.h"
 #include <string.h>
 #include <ctype.h>
 
 char *strdup(const char *s);
 
+// 兼容旧接口的全局默认实例
+static Lexer global_lexer;
 Token current_token; // 全局当前Token，供语法分析器使用
-static int peek_char();
+FILE* input_file;
+
+static int peek_char(Lexer* lexer);
 
 // 预读下一个Token并更新current_token
 void lexer_peek_next_token() {
-    // 仅当value非空时释放，避免空指针free
-    if (current_token.value != NULL) {
-        token_free(current_token);
-        current_token.value = NULL; // 释放后置空，防止野指针
-    }
-    current_token = lexer_next_token();
+    lexer_advance(&global_lexer);
+    current_token = global_lexer.current_token;
 }
 
-// 全局变量
-FILE* input_file;
-char current_char;
 // 关键字映射表
 typedef struct {
     const char* keyword;
@@ -33,61 +32,78 @@ KeywordEntry keyword_table[] = {
 };
 
 // 读取下一个字符
-static void read_char() {
-    int c = fgetc(input_file); // 用int接收
-    if (c == EOF) {
-        current_char = EOF; // 明确标记为EOF，而非乱码字符
-    } else {
-        current_char = (char)c;
+static void read_char(Lexer* lexer) {
+    if (lexer->current_char == '\n') {
+        lexer->line++;
     }
+    lexer->current_char = fgetc(lexer->input_file); // 用int接收,EOF明确标记输入结束
 }
 
 
 // 跳过空白符（空格/制表符/换行）
-static void skip_whitespace() {
-    while (current_char != EOF && isspace(current_char)) {
-        read_char();
+static void skip_whitespace(Lexer* lexer) {
+    while (lexer->current_char != EOF && isspace(lexer->current_char)) {
+        read_char(lexer);
     }
 }
 
 // 处理注释
-static void skip_comment() {
-    if (current_char == '/') {
-        int next_char = fgetc(input_file); // 先读取下一个字符
+static void skip_comment(Lexer* lexer) {
+    if (lexer->current_char == '/') {
+        int next_char = fgetc(lexer->input_file); // 先读取下一个字符
         // 单行注释
         if (next_char == '/') {
-            while ((current_char = fgetc(input_file)) != EOF && current_char != '\n');
+            while ((lexer->current_char = fgetc(lexer->input_file)) != EOF && lexer->current_char != '\n');
         }
         // 多行注释
         else if (next_char == '*') {
             int prev_char = 0;
-            while ((current_char = fgetc(input_file)) != EOF) {
-                if (prev_char == '*' && current_char == '/') {
-                    current_char = fgetc(input_file); // 跳过 '/'
+            while ((lexer->current_char = fgetc(lexer->input_file)) != EOF) {
+                if (lexer->current_char == '\n') {
+                    lexer->line++;
+                }
+                if (prev_char == '*' && lexer->current_char == '/') {
+                    lexer->current_char = fgetc(lexer->input_file); // 跳过 '/'
                     break;
                 }
-                prev_char = current_char;
+                prev_char = lexer->current_char;
             }
         }
         // 不是注释，回退字符
         else {
-            ungetc(next_char, input_file); // 回退第二个字符
-            current_char = '/'; // 恢复第一个字符为 '/'
+            ungetc(next_char, lexer->input_file); // 回退第二个字符
+            lexer->current_char = '/'; // 恢复第一个字符为 '/'
         }
     }
 }
 
+// 超长的Token: 已读完整个Token, 返回错误Token
+static Token overlong_token(Lexer* lexer, const char* what, int limit) {
+    Token token;
+    fprintf(lexer->err, "ERROR (行 %d): %s超过 %d 个字符\n", lexer->line, what, limit);
+    token.type = TOKEN_ERROR;
+    token.value = strdup("?");
+    return token;
+}
+
+// 追加一个字符; 超出缓冲区时只计数, 读完整个Token后由调用者报告错误
+static void append_char(char* buffer, int size, int* pos, int c) {
+    if (*pos < size - 1) buffer[*pos] = (char)c;
+    (*pos)++;
+}
+
 // 解析标识符/关键字
-static Token parse_identifier() {
+static Token parse_identifier(Lexer* lexer) {
     Token token;
-    char buffer[256] = {0}; // 标识符最大长度256
+    char buffer[256] = {0}; // 标识符最大长度255
     int pos = 0;
 
     // 读取字母/数字/下划线
-    while (current_char != EOF && (isalnum(current_char) || current_char == '_')) {
-        buffer[pos++] = current_char;
-        read_char();
+    while (lexer->current_char != EOF && (isalnum(lexer->current_char) || lexer->current_char == '_')) {
+        append_char(buffer, (int)sizeof(buffer), &pos, lexer->current_char);
+        read_char(lexer);
     }
+    if (pos >= (int)sizeof(buffer)) return overlong_token(lexer, "标识符", (int)sizeof(buffer) - 1);
 
     // 检查是否为关键字
     for (int i = 0; keyword_table[i].keyword; i++) {
@@ -105,46 +121,48 @@ static Token parse_identifier() {
 }
 
 // 解析整型常量（十进制/八进制/十六进制）
-static Token parse_int_const() {
+static Token parse_int_const(Lexer* lexer) {
     Token token;
     char buffer[32] = {0};
     int pos = 0;
 
     // 八进制（0开头）
-    if (current_char == '0') {
-        buffer[pos++] = '0';
-        read_char();
-        if (current_char >= '0' && current_char <= '7') {
-            while (current_char != EOF && current_char >= '0' && current_char <= '7') {
-                buffer[pos++] = current_char;
-                read_char();
+    if (lexer->current_char == '0') {
+        append_char(buffer, (int)sizeof(buffer), &pos, '0');
+        read_char(lexer);
+        if (lexer->current_char >= '0' && lexer->current_char <= '7') {
+            while (lexer->current_char != EOF && lexer->current_char >= '0' && lexer->current_char <= '7') {
+                append_char(buffer, (int)sizeof(buffer), &pos, lexer->current_char);
+                read_char(lexer);
             }
         }
         // 十六进制（0x/0X）
-        else if (current_char == 'x' || current_char == 'X') {
-            buffer[pos++] = current_char;
-            read_char();
-            while (current_char != EOF && (isxdigit(current_char))) {
-                buffer[pos++] = current_char;
-                read_char();
+        else if (lexer->current_char == 'x' || lexer->current_char == 'X') {
+            append_char(buffer, (int)sizeof(buffer), &pos, lexer->current_char);
+            read_char(lexer);
+            while (lexer->current_char != EOF && (isxdigit(lexer->current_char))) {
+                append_char(buffer, (int)sizeof(buffer), &pos, lexer->current_char);
+                read_char(lexer);
             }
         }
     }
     // 十进制（1-9开头）
     else {
-        while (current_char != EOF && isdigit(current_char)) {
-            buffer[pos++] = current_char;
-            read_char();
+        while (lexer->current_char != EOF && isdigit(lexer->current_char)) {
+            append_char(buffer, (int)sizeof(buffer), &pos, lexer->current_char);
+            read_char(lexer);
         }
     }
 
+    if (pos >= (int)sizeof(buffer)) return overlong_token(lexer, "整型常量", (int)sizeof(buffer) - 1);
+
     token.type = TOKEN_INT_CONST;
     token.value = strdup(buffer);
     return token;
 }
 
 // 解析运算符/分界符（优先处理复合运算符）
-static Token parse_operator_delimiter() {
+static Token parse_operator_delimiter(Lexer* lexer) {
     Token token = {0}; // 初始化Token，避免野指针
     token.value = (char*)malloc(3 * sizeof(char)); // 复合运算符最多2字符+终止符
     if (token.value == NULL) { // 内存分配失败处理
@@ -154,146 +172,152 @@ static Token parse_operator_delimiter() {
         return token;
     }
 
-    switch (current_char) {
+    switch (lexer->current_char) {
         // 分界符
         case '{': 
             token.type = TOKEN_LBRACE; 
             token.value[0] = '{'; 
             token.value[1] = '\0'; 
-            read_char(); 
+            read_char(lexer); 
             break;
         case '}': 
             token.type = TOKEN_RBRACE; 
             token.value[0] = '}'; 
             token.value[1] = '\0'; 
-            read_char(); 
+            read_char(lexer); 
             break;
         case '(': 
             token.type = TOKEN_LPAREN; 
             token.value[0] = '('; 
             token.value[1] = '\0'; 
-            read_char(); 
+            read_char(lexer); 
             break;
         case ')': 
             token.type = TOKEN_RPAREN; 
             token.value[0] = ')'; 
             token.value[1] = '\0'; 
-            read_char(); 
+            read_char(lexer); 
             break;
         case ';': 
             token.type = TOKEN_SEMICOLON; 
             token.value[0] = ';'; 
             token.value[1] = '\0'; 
-            read_char(); 
+            read_char(lexer); 
             break;
         case ',': 
             token.type = TOKEN_COMMA; 
             token.value[0] = ','; 
             token.value[1] = '\0'; 
-            read_char(); 
+            read_char(lexer); 
+            break;
+        case '[': 
+            token.type = TOKEN_LBRACKET; 
+            token.value[0] = '['; 
+            token.value[1] = '\0'; 
+            read_char(lexer); 
+            break;
+        case ']': 
+            token.type = TOKEN_RBRACKET; 
+            token.value[0] = ']'; 
+            token.value[1] = '\0'; 
+            read_char(lexer); 
             break;
         
         // 复合运算符
         case '>':
-            read_char();
-            if (current_char != EOF && current_char == '=') { // 避免EOF时调用ungetc
+            read_char(lexer);
+            if (lexer->current_char != EOF && lexer->current_char == '=') {
                 token.type = TOKEN_GE; 
                 token.value[0] = '>'; 
                 token.value[1] = '='; 
                 token.value[2] = '\0'; 
-                read_char();
+                read_char(lexer);
             } else { 
                 token.type = TOKEN_GT; 
                 token.value[0] = '>'; 
                 token.value[1] = '\0'; 
-                if (current_char != EOF) ungetc(current_char, input_file); // EOF不回退
             }
             break;
         case '<':
-            read_char();
-            if (current_char != EOF && current_char == '=') {
+            read_char(lexer);
+            if (lexer->current_char != EOF && lexer->current_char == '=') {
                 token.type = TOKEN_LE; 
                 token.value[0] = '<'; 
                 token.value[1] = '='; 
                 token.value[2] = '\0'; 
-                read_char();
+                read_char(lexer);
             } else { 
                 token.type = TOKEN_LT; 
                 token.value[0] = '<'; 
                 token.value[1] = '\0'; 
-                if (current_char != EOF) ungetc(current_char, input_file);
             }
             break;
         case '=':
-            read_char();
-            if (current_char != EOF && current_char == '=') {
+            read_char(lexer);
+            if (lexer->current_char != EOF && lexer->current_char == '=') {
                 token.type = TOKEN_EQ; 
                 token.value[0] = '='; 
                 token.value[1] = '='; 
                 token.value[2] = '\0'; 
-                read_char();
+                read_char(lexer);
             } else { 
                 token.type = TOKEN_ASSIGN; 
                 token.value[0] = '='; 
                 token.value[1] = '\0'; 
-                if (current_char != EOF) ungetc(current_char, input_file);
             }
             break;
         case '!':
-            read_char();
-            if (current_char != EOF && current_char == '=') {
+            read_char(lexer);
+            if (lexer->current_char != EOF && lexer->current_char == '=') {
                 token.type = TOKEN_NE; 
                 token.value[0] = '!'; 
                 token.value[1] = '='; 
                 token.value[2] = '\0'; 
-                read_char();
+                read_char(lexer);
             } else { 
-                token.type = TOKEN_ERROR; 
+                token.type = TOKEN_NOT; 
                 token.value[0] = '!'; 
                 token.value[1] = '\0'; 
-                if (current_char != EOF) ungetc(current_char, input_file);
             }
             break;
         case '+':
-            read_char();
-            if (current_char != EOF && current_char == '+') {
+            read_char(lexer);
+            if (lexer->current_char != EOF && lexer->current_char == '+') {
                 token.type = TOKEN_INC; 
                 token.value[0] = '+'; 
                 token.value[1] = '+'; 
                 token.value[2] = '\0'; 
-                read_char();
-            } else if (current_char != EOF && current_char == '=') {
+                read_char(lexer);
+            } else if (lexer->current_char != EOF && lexer->current_char == '=') {
                 token.type = TOKEN_PLUS_EQ; 
                 token.value[0] = '+'; 
                 token.value[1] = '='; 
                 token.value[2] = '\0'; 
-                read_char();
+                read_char(lexer);
             } else { 
                 token.type = TOKEN_PLUS; 
                 token.value[0] = '+'; 
                 token.value[1] = '\0'; 
-                if (current_char != EOF) ungetc(current_char, input_file);
             }
             break;
         case '-':
-            read_char();
-            if (current_char != EOF && current_char == '-') {
+            read_char(lexer);
+            if (lexer->current_char != EOF && lexer->current_char == '-') {
                 token.type = TOKEN_DEC; 
                 token.value[0] = '-'; 
                 token.value[1] = '-'; 
                 token.value[2] = '\0'; 
-                read_char();
-            } else if (current_char != EOF && current_char == '=') {
+                read_char(lexer);
+            } else if (lexer->current_char != EOF && lexer->current_char == '=') {
                 token.type = TOKEN_MINUS_EQ; 
                 token.value[0] = '-'; 
                 token.value[1] = '='; 
                 token.value[2] = '\0'; 
-                read_char();
+                read_char(lexer);
             } else { 
                 token.type = TOKEN_MINUS; 
                 token.value[0] = '-'; 
                 token.value[1] = '\0'; 
-                if (current_char != EOF) ungetc(current_char, input_file);
             }
             break;
         
@@ -302,45 +326,81 @@ static Token parse_operator_delimiter() {
             token.type = TOKEN_MUL; 
             token.value[0] = '*'; 
             token.value[1] = '\0'; 
-            read_char(); 
+            read_char(lexer); 
             break;
         case '/': 
             token.type = TOKEN_DIV; 
             token.value[0] = '/'; 
             token.value[1] = '\0'; 
-            read_char(); 
+            read_char(lexer); 
+            break;
+        case '%': 
+            token.type = TOKEN_MOD; 
+            token.value[0] = '%'; 
+            token.value[1] = '\0'; 
+            read_char(lexer); 
+            break;
+        
+        // 逻辑运算符(单独的 & 和 | 不支持)
+        case '&':
+            read_char(lexer);
+            token.value[0] = '&'; 
+            if (lexer->current_char == '&') {
+                token.type = TOKEN_AND; 
+                token.value[1] = '&'; 
+                token.value[2] = '\0'; 
+                read_char(lexer);
+            } else { 
+                fprintf(lexer->err, "ERROR: 不支持的运算符 '&'\n");
+                token.type = TOKEN_ERROR; 
+                token.value[1] = '\0'; 
+            }
+            break;
+        case '|':
+            read_char(lexer);
+            token.value[0] = '|'; 
+            if (lexer->current_char == '|') {
+                token.type = TOKEN_OR; 
+                token.value[1] = '|'; 
+                token.value[2] = '\0'; 
+                read_char(lexer);
+            } else { 
+                fprintf(lexer->err, "ERROR: 不支持的运算符 '|'\n");
+                token.type = TOKEN_ERROR; 
+                token.value[1] = '\0'; 
+            }
             break;
         
         // 未知字符/EOF处理
         default:
             // 处理EOF：释放原malloc内存，避免泄漏
-            if (current_char == EOF) {
+            if (lexer->current_char == EOF) {
                 free(token.value); // 释放之前malloc的3字节
                 token.type = TOKEN_EOF;
                 token.value = strdup("EOF");
-                read_char();
+                read_char(lexer);
             } else {
                 // 非法字符处理
-                fprintf(stderr, "ERROR: 未知字符 [ASCII: %d, Char: '%c']\n", current_char, current_char);
+                fprintf(lexer->err, "ERROR: 未知字符 [ASCII: %d, Char: '%c']\n", lexer->current_char, lexer->current_char);
                 token.type = TOKEN_ERROR; 
-                token.value[0] = isprint(current_char) ? current_char : '?'; 
+                token.value[0] = isprint(lexer->current_char) ? lexer->current_char : '?'; 
                 token.value[1] = '\0'; 
-                read_char(); 
+                read_char(lexer); 
             }
             break;
     }
     return token;
 }
 
-// 获取下一个Token
-Token lexer_next_token() {
+// 读取下一个Token
+Token lexer_read_token(Lexer* lexer) {
     // 初始化循环：持续读取直到非空白/注释或EOF
-    while (current_char != EOF) {
-        skip_whitespace(); // 跳过所有空白字符（空格、换行、制表符等）
-        if (current_char == '/') {
+    while (lexer->current_char != EOF) {
+        skip_whitespace(lexer); // 跳过所有空白字符（空格、换行、制表符等）
+        if (lexer->current_char == '/') {
             // 先判断是否是注释，再决定是否处理除法
-            if (peek_char() == '/' || peek_char() == '*') {
-                skip_comment(); // 是注释则跳过
+            if (peek_char(lexer) == '/' || peek_char(lexer) == '*') {
+                skip_comment(lexer); // 是注释则跳过
                 continue;
             } else {
                 break; // 不是注释，是除法运算符，退出循环处理
@@ -351,21 +411,26 @@ Token lexer_next_token() {
     }
 
     // 处理文件末尾：直接返回EOF Token
-    if (current_char == EOF) {
+    if (lexer->current_char == EOF) {
         Token eof_token = {0}; // 初始化Token
         eof_token.type = TOKEN_EOF;
         eof_token.value = strdup("EOF");
+        eof_token.line = lexer->line;
         return eof_token;
     }
 
     // 处理有效字符
-    if (isalpha(current_char) || current_char == '_') {
-        return parse_identifier();
-    } else if (isdigit(current_char)) {
-        return parse_int_const();
+    int line = lexer->line;
+    Token token;
+    if (isalpha(lexer->current_char) || lexer->current_char == '_') {
+        token = parse_identifier(lexer);
+    } else if (isdigit(lexer->current_char)) {
+        token = parse_int_const(lexer);
     } else {
-        return parse_operator_delimiter();
+        token = parse_operator_delimiter(lexer);
     }
+    token.line = line;
+    return token;
 }
 
 
@@ -378,28 +443,124 @@ void token_free(Token token) {
     }
 }
 
+// ========== 词法分析器实例 ==========
+
+Lexer* lexer_create(const char* filename) {
+    FILE* file = fopen(filename, "r");
+    if (!file) {
+        return NULL; // 由调用者根据errno报告错误
+    }
+
+    Lexer* lexer = (Lexer*)malloc(sizeof(Lexer));
+    if (!lexer) {
+        perror("malloc failed for Lexer");
+        exit(1);
+    }
+    lexer->input_file = file;
+    lexer->err = stderr;
+    lexer->current_char = 0;
+    lexer->line = 1;
+    lexer->current_token.type = TOKEN_EOF;
+    lexer->current_token.value = NULL;
+
+    // 初始化current_token
+    read_char(lexer);
+    lexer->current_token = lexer_read_token(lexer);
+    return lexer;
+}
+
+Lexer* lexer_create_from_memory(const char* source, size_t length) {
+    // fmemopen不接受长度为0的缓冲区,空输入用一个换行代替
+    FILE* file = length > 0 ? fmemopen((void*)source, length, "r") : fmemopen("\n", 1, "r");
+    if (!file) {
+        return NULL;
+    }
+
+    Lexer* lexer = (Lexer*)malloc(sizeof(Lexer));
+    if (!lexer) {
+        perror("malloc failed for Lexer");
+        exit(1);
+    }
+    lexer->input_file = file;
+    lexer->err = stderr;
+    lexer->current_char = 0;
+    lexer->line = 1;
+    lexer->current_token.type = TOKEN_EOF;
+    lexer->current_token.value = NULL;
+
+    read_char(lexer);
+    lexer->current_token = lexer_read_token(lexer);
+    return lexer;
+}
+
+void lexer_destroy(Lexer* lexer) {
+    if (!lexer) return;
+
+    token_free(lexer->current_token);
+    if (lexer->input_file) fclose(lexer->input_file);
+    free(lexer);
+}
+
+void lexer_advance(Lexer* lexer) {
+    // 仅当value非空时释放，避免空指针free
+    if (lexer->current_token.value != NULL) {
+        token_free(lexer->current_token);
+        lexer->current_token.value = NULL; // 释放后置空，防止野指针
+    }
+    lexer->current_token = lexer_read_token(lexer);
+}
+
+int lexer_rewind(Lexer* lexer) {
+    if (fseek(lexer->input_file, 0, SEEK_SET) != 0) {
+        perror("Rewind input failed");
+        return -1;
+    }
+    token_free(lexer->current_token);
+    lexer->current_char = 0;
+    lexer->line = 1;
+    read_char(lexer);
+    lexer->current_token = lexer_read_token(lexer);
+    return 0;
+}
+
+// ========== 兼容旧接口 ==========
+
+Token lexer_next_token() {
+    return lexer_read_token(&global_lexer);
+}
+
 // 初始化时读取第一个Token
 int lexer_init(const char* filename) {
-    input_file = fopen(filename, "r");
-    if (!input_file) { 
+    global_lexer.input_file = fopen(filename, "r");
+    if (!global_lexer.input_file) { 
         perror("Open file failed"); 
         return -1; 
     }
+    global_lexer.err = stderr;
+    global_lexer.current_char = 0;
+    global_lexer.line = 1;
+    input_file = global_lexer.input_file;
     // 初始化current_token
-    read_char();
-    current_token = lexer_next_token();
+    read_char(&global_lexer);
+    global_lexer.current_token = lexer_read_token(&global_lexer);
+    current_token = global_lexer.current_token;
     return 0;
 }
 
 void lexer_close() {
     // 释放current_token
-    token_free(current_token);
-    if (input_file) fclose(input_file);
+    token_free(global_lexer.current_token);
+    global_lexer.current_token.value = NULL;
+    current_token.value = NULL;
+    if (global_lexer.input_file) fclose(global_lexer.input_file);
+    global_lexer.input_file = NULL;
+    input_file = NULL;
 }
 
 Token token_copy(Token src) {
     Token dest = {0};
     dest.type = src.type;
+    dest.line = src.line;
     // 深拷贝value：重新分配内存，避免指针共享
     if (src.value != NULL) {
         dest.value = strdup(src.value);
@@ -415,10 +576,54 @@ Token token_copy(Token src) {
 }
 
 // 查看下一个字符（不移动文件指针）
-static int peek_char() {
-    int c = fgetc(input_file);
+static int peek_char(Lexer* lexer) {
+    int c = fgetc(lexer->input_file);
     if (c != EOF) {
-        ungetc(c, input_file); // 回退字符
+        ungetc(c, lexer->input_file); // 回退字符
     }
     return c;
-}
\ No newline at end of file
+}
+
+// Token类型转字符串
+const char* token_type_str(TokenType type) {
+    switch (type) {
+        case TOKEN_IF: return "TOKEN_IF";
+        case TOKEN_ELSE: return "TOKEN_ELSE";
+        case TOKEN_INT: return "TOKEN_INT";
+        case TOKEN_RETURN: return "TOKEN_RETURN";
+        case TOKEN_VOID: return "TOKEN_VOID";
+        case TOKEN_WHILE: return "TOKEN_WHILE";
+        case TOKEN_IDENTIFIER: return "TOKEN_IDENTIFIER";
+        case TOKEN_INT_CONST: return "TOKEN_INT_CONST";
+        case TOKEN_PLUS: return "TOKEN_PLUS";
+        case TOKEN_MINUS: return "TOKEN_MINUS";
+        case TOKEN_MUL: return "TOKEN_MUL";
+        case TOKEN_DIV: return "TOKEN_DIV";
+        case TOKEN_MOD: return "TOKEN_MOD";
+        case TOKEN_GT: return "TOKEN_GT";
+        case TOKEN_GE: return "TOKEN_GE";
+        case TOKEN_LT: return "TOKEN_LT";
+        case TOKEN_LE: return "TOKEN_LE";
+        case TOKEN_EQ: return "TOKEN_EQ";
+        case TOKEN_NE: return "TOKEN_NE";
+        case TOKEN_ASSIGN: return "TOKEN_ASSIGN";
+        case TOKEN_PLUS_EQ: return "TOKEN_PLUS_EQ";
+        case TOKEN_MINUS_EQ: return "TOKEN_MINUS_EQ";
+        case TOKEN_INC: return "TOKEN_INC";
+        case TOKEN_DEC: return "TOKEN_DEC";
+        case TOKEN_NOT: return "TOKEN_NOT";
+        case TOKEN_AND: return "TOKEN_AND";
+        case TOKEN_OR: return "TOKEN_OR";
+        case TOKEN_LBRACE: return "TOKEN_LBRACE";
+        case TOKEN_RBRACE: return "TOKEN_RBRACE";
+        case TOKEN_LPAREN: return "TOKEN_LPAREN";
+        case TOKEN_RPAREN: return "TOKEN_RPAREN";
+        case TOKEN_LBRACKET: return "TOKEN_LBRACKET";
+        case TOKEN_RBRACKET: return "TOKEN_RBRACKET";
+        case TOKEN_SEMICOLON: return "TOKEN_SEMICOLON";
+        case TOKEN_COMMA: return "TOKEN_COMMA";
+        case TOKEN_EOF: return "TOKEN_EOF";
+        case TOKEN_ERROR: return "TOKEN_ERROR";
+        default: return "TOKEN_UNKNOWN";
+    }
+}
@@ -13,11 +13,12 @@ typedef enum {
     // 整型常量（十进制/八进制/十六进制）
     TOKEN_INT_CONST,
     // 运算符
-    TOKEN_PLUS, TOKEN_MINUS, TOKEN_MUL, TOKEN_DIV,
+    TOKEN_PLUS, TOKEN_MINUS, TOKEN_MUL, TOKEN_DIV, TOKEN_MOD,
     TOKEN_GT, TOKEN_GE, TOKEN_LT, TOKEN_LE, TOKEN_EQ, TOKEN_NE,
     TOKEN_ASSIGN, TOKEN_PLUS_EQ, TOKEN_MINUS_EQ, TOKEN_INC, TOKEN_DEC,
+    TOKEN_NOT, TOKEN_AND, TOKEN_OR,
     // 分界符
-    TOKEN_LBRACE, TOKEN_RBRACE, TOKEN_LPAREN, TOKEN_RPAREN,
+    TOKEN_LBRACE, TOKEN_RBRACE, TOKEN_LPAREN, TOKEN_RPAREN, TOKEN_LBRACKET, TOKEN_RBRACKET,
     TOKEN_SEMICOLON, TOKEN_COMMA,
     // 结束/错误
     TOKEN_EOF, TOKEN_ERROR
@@ -27,9 +28,34 @@ typedef enum {
 typedef struct {
     TokenType type;
     char* value; // 存储标识符/常量的字符串值
+    int line;    // Token所在的行号
 } Token;
 
-// 再声明全局变量和函数 
+// 词法分析器实例（每个输入文件一个,可在多个线程中并行使用）
+typedef struct Lexer {
+    FILE* input_file;     // 输入流
+    int current_char;     // 当前字符(EOF表示输入结束)
+    int line;             // 当前字符所在的行号
+    Token current_token;  // 当前Token（语法分析器需预读Token）
+    FILE* err;            // 错误输出流
+} Lexer;
+
+// ========== 词法分析器实例接口 ==========
+
+// 创建词法分析器并读取第一个Token（打开失败返回NULL,errno指示原因）
+Lexer* lexer_create(const char* filename);
+// 从内存中的源代码创建词法分析器(source在销毁前必须保持有效)
+Lexer* lexer_create_from_memory(const char* source, size_t length);
+// 销毁词法分析器,释放当前Token并关闭文件
+void lexer_destroy(Lexer* lexer);
+// 读取下一个Token（调用者负责释放）
+Token lexer_read_token(Lexer* lexer);
+// 前进一个Token并更新lexer->current_token
+void lexer_advance(Lexer* lexer);
+// 回到输入开头并重新读取第一个Token
+int lexer_rewind(Lexer* lexer);
+
+// ========== 兼容旧接口(基于一个全局默认实例) ==========
 
 Token token_copy(Token src);
 
@@ -0,0 +1,61 @@
+#define _GNU_SOURCE
+
+#include "mem_stats.h"
+#include <stdlib.h>
+#include <sys/resource.h>
+
+static _Thread_local unsigned long long thread_allocations;
+static _Thread_local unsigned long long thread_bytes;
+
+#if defined(__GLIBC__)
+
+// glibc导出的分配器实现, 替换函数直接转发给它们
+extern void* __libc_malloc(size_t size);
+extern void* __libc_calloc(size_t count, size_t size);
+extern void* __libc_realloc(void* ptr, size_t size);
+extern void __libc_free(void* ptr);
+
+void* malloc(size_t size) {
+    thread_allocations++;
+    thread_bytes += size;
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size) {
+    thread_allocations++;
+    thread_bytes += count * size;
+    return __libc_calloc(count, size);
+}
+
+void* realloc(void* ptr, size_t size) {
+    thread_allocations++;
+    thread_bytes += size;
+    return __libc_realloc(ptr, size);
+}
+
+void free(void* ptr) {
+    __libc_free(ptr);
+}
+
+bool mem_stats_available(void) {
+    return true;
+}
+
+#else
+
+bool mem_stats_available(void) {
+    return false;
+}
+
+#endif
+
+void mem_stats_thread_counters(MemCounters* counters) {
+    counters->allocations = thread_allocations;
+    counters->bytes = thread_bytes;
+}
+
+long mem_stats_peak_rss_kb(void) {
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+    return usage.ru_maxrss;
+}
@@ -0,0 +1,25 @@
+#ifndef MEM_STATS_H
+#define MEM_STATS_H
+
+#include <stdbool.h>
+
+// ========== 内存分配统计 ==========
+//
+// 在glibc上替换malloc/calloc/realloc/free(转发给glibc的实现), 
+// 按线程统计分配次数和分配字节数; 其他平台上计数恒为0.
+
+typedef struct MemCounters {
+    unsigned long long allocations;  // 分配次数(malloc/calloc/realloc)
+    unsigned long long bytes;        // 申请的字节数
+} MemCounters;
+
+// 当前线程的累计分配计数
+void mem_stats_thread_counters(MemCounters* counters);
+
+// 进程的峰值常驻内存(KB)
+long mem_stats_peak_rss_kb(void);
+
+// 当前平台是否支持分配计数
+bool mem_stats_available(void);
+
+#endif // MEM_STATS_H
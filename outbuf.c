@@ -0,0 +1,71 @@
+#include "outbuf.h"
+#include <stdlib.h>
+#include <string.h>
+
+void outbuf_init(OutBuf* buf, FILE* sink) {
+    buf->data = NULL;
+    buf->length = 0;
+    buf->capacity = 0;
+    buf->sink = sink;
+    buf->failed = false;
+}
+
+void outbuf_free(OutBuf* buf) {
+    free(buf->data);
+    buf->data = NULL;
+    buf->length = 0;
+    buf->capacity = 0;
+}
+
+static void outbuf_reserve(OutBuf* buf, size_t extra) {
+    if (buf->length + extra <= buf->capacity) return;
+    size_t capacity = buf->capacity ? buf->capacity : 4096;
+    while (capacity < buf->length + extra) capacity *= 2;
+    buf->data = (char*)realloc(buf->data, capacity);
+    if (!buf->data) {
+        perror("malloc failed for OutBuf");
+        exit(1);
+    }
+    buf->capacity = capacity;
+}
+
+void outbuf_write(OutBuf* buf, const void* data, size_t length) {
+    if (length == 0) return;
+    outbuf_reserve(buf, length);
+    memcpy(buf->data + buf->length, data, length);
+    buf->length += length;
+    if (buf->sink && buf->length >= OUTBUF_FLUSH_SIZE) outbuf_flush(buf);
+}
+
+void outbuf_puts(OutBuf* buf, const char* text) {
+    outbuf_write(buf, text, strlen(text));
+}
+
+void outbuf_putc(OutBuf* buf, char c) {
+    outbuf_reserve(buf, 1);
+    buf->data[buf->length++] = c;
+    if (buf->sink && buf->length >= OUTBUF_FLUSH_SIZE) outbuf_flush(buf);
+}
+
+void outbuf_int(OutBuf* buf, int64_t value) {
+    char digits[24];
+    int n = 0;
+    // 按无符号取绝对值, INT64_MIN也不会溢出
+    uint64_t magnitude = value < 0 ? 0 - (uint64_t)value : (uint64_t)value;
+    do {
+        digits[n++] = (char)('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude > 0);
+    if (value < 0) digits[n++] = '-';
+
+    outbuf_reserve(buf, (size_t)n);
+    while (n > 0) buf->data[buf->length++] = digits[--n];
+    if (buf->sink && buf->length >= OUTBUF_FLUSH_SIZE) outbuf_flush(buf);
+}
+
+bool outbuf_flush(OutBuf* buf) {
+    if (!buf->sink || buf->length == 0) return !buf->failed;
+    if (fwrite(buf->data, 1, buf->length, buf->sink) != buf->length) buf->failed = true;
+    buf->length = 0;
+    return !buf->failed;
+}
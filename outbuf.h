@@ -0,0 +1,36 @@
+#ifndef OUTBUF_H
+#define OUTBUF_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// ========== 输出缓冲区 ==========
+//
+// 代码生成的输出先追加到内存缓冲区, 不经过逐条fprintf的格式解析和流加锁。
+// 指定sink时缓冲区超过OUTBUF_FLUSH_SIZE就整块写出; 不指定时保留全部内容(如目标文件的节)。
+
+#define OUTBUF_FLUSH_SIZE (64 * 1024)
+
+typedef struct OutBuf {
+    char* data;
+    size_t length;
+    size_t capacity;
+    FILE* sink;     // NULL表示只写入内存
+    bool failed;    // 写出sink时出错
+} OutBuf;
+
+void outbuf_init(OutBuf* buf, FILE* sink);
+void outbuf_free(OutBuf* buf);
+
+void outbuf_write(OutBuf* buf, const void* data, size_t length);
+void outbuf_puts(OutBuf* buf, const char* text);
+void outbuf_putc(OutBuf* buf, char c);
+// 十进制整数
+void outbuf_int(OutBuf* buf, int64_t value);
+
+// 把缓冲的内容写出到sink, 出错时返回false
+bool outbuf_flush(OutBuf* buf);
+
+#endif // OUTBUF_H
@@ -0,0 +1,183 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "perf_report.h"
+#include "mem_stats.h"
+#include "trace.h"
+#include <string.h>
+#include <time.h>
+
+double perf_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+const char* compile_phase_name(CompilePhase phase) {
+    switch (phase) {
+        case PHASE_TOKENIZE: return "词法分析";
+        case PHASE_PARSE: return "构建AST";
+        case PHASE_TYPE_CHECK: return "类型检查";
+        case PHASE_SEMANTIC: return "语义分析";
+        case PHASE_FOLD: return "常量折叠";
+        case PHASE_IR: return "IR生成";
+        case PHASE_SSA: return "SSA构造";
+        case PHASE_OPT: return "优化";
+        case PHASE_REGALLOC: return "寄存器分配";
+        case PHASE_CODEGEN: return "代码生成";
+        case PHASE_JIT: return "后台JIT编译";
+        case PHASE_TEARDOWN: return "符号表/AST释放";
+        default: return "未知阶段";
+    }
+}
+
+const char* compile_phase_key(CompilePhase phase) {
+    switch (phase) {
+        case PHASE_TOKENIZE: return "tokenize";
+        case PHASE_PARSE: return "parse";
+        case PHASE_TYPE_CHECK: return "type_check";
+        case PHASE_SEMANTIC: return "semantic";
+        case PHASE_FOLD: return "fold";
+        case PHASE_IR: return "ir";
+        case PHASE_SSA: return "ssa";
+        case PHASE_OPT: return "opt";
+        case PHASE_REGALLOC: return "regalloc";
+        case PHASE_CODEGEN: return "codegen";
+        case PHASE_JIT: return "jit";
+        case PHASE_TEARDOWN: return "teardown";
+        default: return "unknown";
+    }
+}
+
+void perf_report_init(PerfReport* report) {
+    memset(report, 0, sizeof(*report));
+    report->active_phase = -1;
+}
+
+void perf_phase_begin(PerfReport* report, CompilePhase phase) {
+    if (!report) return;
+    
+    MemCounters counters;
+    mem_stats_thread_counters(&counters);
+    trace_begin("phase", compile_phase_key(phase));
+    report->active_phase = phase;
+    report->start_allocations = counters.allocations;
+    report->start_bytes = counters.bytes;
+    report->start_time = perf_now();
+}
+
+void perf_phase_end(PerfReport* report, CompilePhase phase) {
+    if (!report || report->active_phase != (int)phase) return;
+    
+    double elapsed = perf_now() - report->start_time;
+    MemCounters counters;
+    mem_stats_thread_counters(&counters);
+    
+    PhaseStats* stats = &report->phases[phase];
+    stats->seconds += elapsed;
+    stats->allocations += counters.allocations - report->start_allocations;
+    stats->bytes += counters.bytes - report->start_bytes;
+    stats->peak_rss_kb = mem_stats_peak_rss_kb();
+    stats->runs++;
+    report->active_phase = -1;
+    trace_end();
+}
+
+void perf_report_merge(PerfReport* into, const PerfReport* from) {
+    for (int i = 0; i < PHASE_COUNT; i++) {
+        into->phases[i].seconds += from->phases[i].seconds;
+        into->phases[i].allocations += from->phases[i].allocations;
+        into->phases[i].bytes += from->phases[i].bytes;
+        into->phases[i].runs += from->phases[i].runs;
+        if (from->phases[i].peak_rss_kb > into->phases[i].peak_rss_kb) {
+            into->phases[i].peak_rss_kb = from->phases[i].peak_rss_kb;
+        }
+    }
+    into->tier.requests += from->tier.requests;
+    into->tier.units += from->tier.units;
+    into->tier.compiled += from->tier.compiled;
+    into->tier.failed += from->tier.failed;
+}
+
+void perf_report_print_table(const PerfReport* report, FILE* out, bool show_time, bool show_mem) {
+    double total_time = 0;
+    unsigned long long total_allocations = 0, total_bytes = 0;
+    long peak_rss = 0;
+    for (int i = 0; i < PHASE_COUNT; i++) {
+        total_time += report->phases[i].seconds;
+        total_allocations += report->phases[i].allocations;
+        total_bytes += report->phases[i].bytes;
+        if (report->phases[i].peak_rss_kb > peak_rss) peak_rss = report->phases[i].peak_rss_kb;
+    }
+    
+    fprintf(out, "\n========== 编译阶段统计 ==========\n");
+    fprintf(out, "%-16s", "phase");
+    if (show_time) fprintf(out, " %12s %7s", "time(ms)", "pct");
+    if (show_mem) fprintf(out, " %12s %14s %12s", "allocs", "bytes", "peak_rss(KB)");
+    fprintf(out, "\n");
+    
+    for (int i = 0; i < PHASE_COUNT; i++) {
+        const PhaseStats* stats = &report->phases[i];
+        fprintf(out, "%-16s", compile_phase_key((CompilePhase)i));
+        if (show_time) {
+            double pct = total_time > 0 ? stats->seconds * 100.0 / total_time : 0.0;
+            fprintf(out, " %12.3f %6.1f%%", stats->seconds * 1000.0, pct);
+        }
+        if (show_mem) {
+            fprintf(out, " %12llu %14llu %12ld", stats->allocations, stats->bytes, stats->peak_rss_kb);
+        }
+        fprintf(out, "\n");
+    }
+    
+    fprintf(out, "%-16s", "total");
+    if (show_time) fprintf(out, " %12.3f %6.1f%%", total_time * 1000.0, 100.0);
+    if (show_mem) fprintf(out, " %12llu %14llu %12ld", total_allocations, total_bytes, peak_rss);
+    fprintf(out, "\n");
+    if (show_mem && !mem_stats_available()) {
+        fprintf(out, "(当前平台不支持分配计数)\n");
+    }
+    const TierStats* tier = &report->tier;
+    if (show_time && tier->requests > 0) {
+        fprintf(out, "分层执行: 请求编译 %d 个函数, 后台编译 %d 批(失败 %d), 换成本机代码 %d 个函数, 用时 %.3f ms\n",
+                tier->requests, tier->units, tier->failed, tier->compiled,
+                report->phases[PHASE_JIT].seconds * 1000.0);
+    }
+    fprintf(out, "==================================\n");
+}
+
+void perf_report_print_json(const PerfReport* report, FILE* out) {
+    fprintf(out, "{");
+    for (int i = 0; i < PHASE_COUNT; i++) {
+        const PhaseStats* stats = &report->phases[i];
+        fprintf(out, "%s\"%s\": {\"time_ms\": %.6f, \"allocations\": %llu, \"bytes\": %llu, "
+                     "\"peak_rss_kb\": %ld, \"runs\": %d}",
+                i > 0 ? ", " : "", compile_phase_key((CompilePhase)i),
+                stats->seconds * 1000.0, stats->allocations, stats->bytes,
+                stats->peak_rss_kb, stats->runs);
+    }
+    const TierStats* tier = &report->tier;
+    if (tier->requests > 0) {
+        fprintf(out, ", \"tier\": {\"requests\": %d, \"units\": %d, \"compiled\": %d, \"failed\": %d}",
+                tier->requests, tier->units, tier->compiled, tier->failed);
+    }
+    fprintf(out, "}");
+}
+
+void perf_json_fprint_string(FILE* out, const char* str) {
+    fputc('"', out);
+    for (const unsigned char* p = (const unsigned char*)str; *p; p++) {
+        switch (*p) {
+            case '"': fputs("\\\"", out); break;
+            case '\\': fputs("\\\\", out); break;
+            case '\n': fputs("\\n", out); break;
+            case '\t': fputs("\\t", out); break;
+            default:
+                if (*p < 0x20) {
+                    fprintf(out, "\\u%04x", *p);
+                } else {
+                    fputc(*p, out);
+                }
+                break;
+        }
+    }
+    fputc('"', out);
+}
@@ -0,0 +1,79 @@
+#ifndef PERF_REPORT_H
+#define PERF_REPORT_H
+
+#include <stdio.h>
+#include <stdbool.h>
+
+// ========== 编译阶段统计(-ftime-report / -fmem-report) ==========
+
+#define COMPILER_VERSION "0.2.0"
+
+// 编译阶段
+typedef enum {
+    PHASE_TOKENIZE,     // 词法分析
+    PHASE_PARSE,        // 构建AST
+    PHASE_TYPE_CHECK,   // 类型检查
+    PHASE_SEMANTIC,     // 语义分析
+    PHASE_FOLD,         // 常量折叠
+    PHASE_IR,           // 生成中间代码
+    PHASE_SSA,          // SSA构造
+    PHASE_OPT,          // 中间代码优化
+    PHASE_REGALLOC,     // 寄存器分配
+    PHASE_CODEGEN,      // 指令选择与汇编输出
+    PHASE_JIT,          // 分层执行时后台线程编译热点函数
+    PHASE_TEARDOWN,     // 符号表/AST释放
+    PHASE_COUNT
+} CompilePhase;
+
+// 单个阶段的统计
+typedef struct PhaseStats {
+    double seconds;                 // 累计耗时(单调时钟)
+    unsigned long long allocations; // 分配次数
+    unsigned long long bytes;       // 分配字节数
+    long peak_rss_kb;               // 阶段结束时进程的峰值RSS
+    int runs;                       // 执行次数
+} PhaseStats;
+
+// 分层执行(--run=tiered)的统计
+typedef struct TierStats {
+    int requests;                   // 计数到达阈值而请求编译的函数
+    int units;                      // 后台编译的批次(热点函数连同它调用的函数)
+    int compiled;                   // 换成本机代码的函数
+    int failed;                     // 编译失败的批次
+} TierStats;
+
+typedef struct PerfReport {
+    PhaseStats phases[PHASE_COUNT];
+    TierStats tier;
+    
+    // 正在计时的阶段
+    int active_phase;               // -1表示没有
+    double start_time;
+    unsigned long long start_allocations;
+    unsigned long long start_bytes;
+} PerfReport;
+
+void perf_report_init(PerfReport* report);
+
+// 阶段计时(report为NULL时什么也不做, 调用方无需判断)
+void perf_phase_begin(PerfReport* report, CompilePhase phase);
+void perf_phase_end(PerfReport* report, CompilePhase phase);
+
+// 把from的统计累加到into
+void perf_report_merge(PerfReport* into, const PerfReport* from);
+
+// 以表格形式输出(有分层执行时另起一行)
+void perf_report_print_table(const PerfReport* report, FILE* out, bool show_time, bool show_mem);
+// 以JSON对象形式输出(不含换行); 有分层执行时多一个"tier"成员
+void perf_report_print_json(const PerfReport* report, FILE* out);
+
+const char* compile_phase_name(CompilePhase phase);
+const char* compile_phase_key(CompilePhase phase);
+
+// 输出带引号和转义的JSON字符串
+void perf_json_fprint_string(FILE* out, const char* str);
+
+// 单调时钟(秒)
+double perf_now(void);
+
+#endif // PERF_REPORT_H
@@ -0,0 +1,299 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "profile.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static void* profile_alloc(size_t size) {
+    void* ptr = calloc(1, size ? size : 1);
+    if (!ptr) {
+        perror("malloc failed for profile");
+        exit(1);
+    }
+    return ptr;
+}
+
+static size_t align8(size_t size) {
+    return (size + 7) & ~(size_t)7;
+}
+
+// ========== 校验和 ==========
+
+// FNV-1a, 按4字节小端依次混入
+static uint64_t checksum_mix(uint64_t hash, uint32_t value) {
+    for (int i = 0; i < 4; i++) {
+        hash ^= (value >> (8 * i)) & 0xff;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+// 只看控制流图和每条指令的操作码: 修改常量、变量名或行号不改变基本块, 原有的计数仍然可用
+static uint64_t function_checksum(const IRFunction* function) {
+    uint64_t hash = 14695981039346656037ULL;
+    hash = checksum_mix(hash, (uint32_t)function->param_count);
+    hash = checksum_mix(hash, (uint32_t)function->block_count);
+    for (int b = 0; b < function->block_count; b++) {
+        const IRBlock* block = &function->blocks[b];
+        for (int i = 0; i < block->instr_count; i++) {
+            const IRInstr* instr = &function->instrs[block->instrs[i]];
+            if (instr->op != IR_NOP) hash = checksum_mix(hash, instr->op);
+        }
+        hash = checksum_mix(hash, (uint32_t)block->succ_count);
+        for (int s = 0; s < block->succ_count; s++) {
+            hash = checksum_mix(hash, (uint32_t)block->succs[s]);
+        }
+    }
+    return hash;
+}
+
+// ========== 插桩 ==========
+
+ProfileLayout* profile_layout_create(IRModule* module) {
+    ProfileLayout* layout = (ProfileLayout*)profile_alloc(sizeof(ProfileLayout));
+    layout->functions = (ProfileFunction*)profile_alloc(sizeof(ProfileFunction) * (size_t)module->function_count);
+    layout->global = -1;
+
+    for (int i = 0; i < module->function_count; i++) {
+        IRFunction* function = &module->functions[i];
+        if (!function->is_defined || function->block_count == 0) continue;
+
+        ir_function_compute_cfg(function);
+        ir_function_split_critical_edges(function);
+        ProfileFunction* entry = &layout->functions[layout->function_count++];
+        entry->function = i;
+        entry->checksum = function_checksum(function);
+        entry->first_counter = layout->counter_count;
+        entry->counter_count = function->block_count;
+        layout->counter_count += function->block_count;
+    }
+    return layout;
+}
+
+void profile_layout_destroy(ProfileLayout* layout) {
+    if (!layout) return;
+    free(layout->functions);
+    free(layout);
+}
+
+// 在block的phi之后插入 count @__profile[counter]
+static void insert_count(IRFunction* function, int block, int global, int counter) {
+    IROperand args[2] = { ir_operand_global(global, IR_TYPE_I32), ir_operand_const(2 * counter, IR_TYPE_I32) };
+    int line = function->instrs[function->blocks[block].instrs[0]].line;
+    int id = ir_emit(function, block, IR_COUNT, IR_TYPE_VOID, false, args, 2, line);
+
+    IRBlock* target = &function->blocks[block];
+    int position = 0;
+    while (function->instrs[target->instrs[position]].op == IR_PHI) position++;
+    memmove(&target->instrs[position + 1], &target->instrs[position],
+            sizeof(int32_t) * (size_t)(target->instr_count - 1 - position));
+    target->instrs[position] = id;
+}
+
+void profile_instrument(IRModule* module, ProfileLayout* layout, ProfileStats* stats) {
+    if (layout->counter_count == 0) return;
+    layout->global = ir_module_add_global(module, PROFILE_GLOBAL, IR_TYPE_I32, 2 * layout->counter_count);
+
+    for (int f = 0; f < layout->function_count; f++) {
+        const ProfileFunction* entry = &layout->functions[f];
+        IRFunction* function = &module->functions[entry->function];
+        for (int b = 0; b < entry->counter_count; b++) {
+            if (function->blocks[b].instr_count == 0) continue;
+            insert_count(function, b, layout->global, entry->first_counter + b);
+        }
+    }
+    if (stats) {
+        stats->functions += layout->function_count;
+        stats->counters += layout->counter_count;
+    }
+}
+
+// ========== 文件 ==========
+
+typedef struct ProfileData {
+    void* map;
+    size_t size;
+    const ProfileFileHeader* header;
+    const ProfileFileFunction* functions;
+    const char* names;
+    const uint64_t* counters;
+} ProfileData;
+
+static size_t data_size(uint32_t function_count, uint32_t names_size, uint32_t counter_count) {
+    return sizeof(ProfileFileHeader) + sizeof(ProfileFileFunction) * (size_t)function_count +
+           align8(names_size) + sizeof(uint64_t) * (size_t)counter_count;
+}
+
+// 映射并检查profile文件; err为NULL时不输出原因
+static bool profile_map(const char* path, ProfileData* data, FILE* err) {
+    memset(data, 0, sizeof(*data));
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        if (err) fprintf(err, "警告: 无法读取profile文件 %s: %s\n", path, strerror(errno));
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(ProfileFileHeader)) {
+        if (err) fprintf(err, "警告: %s 不是profile文件\n", path);
+        close(fd);
+        return false;
+    }
+    data->size = (size_t)st.st_size;
+    data->map = mmap(NULL, data->size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data->map == MAP_FAILED) {
+        data->map = NULL;
+        if (err) fprintf(err, "警告: 无法映射profile文件 %s: %s\n", path, strerror(errno));
+        return false;
+    }
+
+    const uint8_t* bytes = (const uint8_t*)data->map;
+    const ProfileFileHeader* header = (const ProfileFileHeader*)bytes;
+    bool ok = header->magic == PROFILE_MAGIC && header->version == PROFILE_VERSION &&
+              data_size(header->function_count, header->names_size, header->counter_count) == data->size;
+    if (ok) {
+        data->header = header;
+        data->functions = (const ProfileFileFunction*)(bytes + sizeof(ProfileFileHeader));
+        data->names = (const char*)(data->functions + header->function_count);
+        data->counters = (const uint64_t*)(data->names + align8(header->names_size));
+        ok = header->names_size == 0 || data->names[header->names_size - 1] == '\0';
+    }
+    for (uint32_t i = 0; ok && i < header->function_count; i++) {
+        const ProfileFileFunction* function = &data->functions[i];
+        ok = function->name_offset < header->names_size && function->first_counter <= header->counter_count &&
+             function->counter_count <= header->counter_count - function->first_counter;
+    }
+    if (!ok) {
+        if (err) fprintf(err, "警告: %s 不是profile文件或版本不符\n", path);
+        munmap(data->map, data->size);
+        data->map = NULL;
+        return false;
+    }
+    return true;
+}
+
+static void profile_unmap(ProfileData* data) {
+    if (data->map) munmap(data->map, data->size);
+    data->map = NULL;
+}
+
+static const ProfileFileFunction* find_function(const ProfileData* data, const char* name) {
+    for (uint32_t i = 0; i < data->header->function_count; i++) {
+        if (strcmp(data->names + data->functions[i].name_offset, name) == 0) return &data->functions[i];
+    }
+    return NULL;
+}
+
+bool profile_write(const IRModule* module, const ProfileLayout* layout, const void* counters, const char* path,
+                   FILE* err) {
+    uint64_t* merged = (uint64_t*)profile_alloc(sizeof(uint64_t) * (size_t)layout->counter_count);
+    memcpy(merged, counters, sizeof(uint64_t) * (size_t)layout->counter_count);
+
+    // 先把原有的计数累加进来再截断文件
+    size_t names_size = 0;
+    ProfileData old;
+    bool have_old = profile_map(path, &old, NULL);
+    for (int f = 0; f < layout->function_count; f++) {
+        const ProfileFunction* entry = &layout->functions[f];
+        const char* name = module->functions[entry->function].name;
+        names_size += strlen(name) + 1;
+        const ProfileFileFunction* previous = have_old ? find_function(&old, name) : NULL;
+        if (!previous || previous->checksum != entry->checksum ||
+            previous->counter_count != (uint32_t)entry->counter_count) continue;
+        for (int c = 0; c < entry->counter_count; c++) {
+            merged[entry->first_counter + c] += old.counters[previous->first_counter + c];
+        }
+    }
+    profile_unmap(&old);
+
+    size_t size = data_size((uint32_t)layout->function_count, (uint32_t)names_size,
+                            (uint32_t)layout->counter_count);
+    int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    void* map = MAP_FAILED;
+    if (fd >= 0 && ftruncate(fd, (off_t)size) == 0) {
+        map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    if (map == MAP_FAILED) {
+        fprintf(err, "无法写入profile文件 %s: %s\n", path, strerror(errno));
+        if (fd >= 0) close(fd);
+        free(merged);
+        return false;
+    }
+
+    uint8_t* bytes = (uint8_t*)map;
+    ProfileFileHeader* header = (ProfileFileHeader*)bytes;
+    header->magic = PROFILE_MAGIC;
+    header->version = PROFILE_VERSION;
+    header->function_count = (uint32_t)layout->function_count;
+    header->counter_count = (uint32_t)layout->counter_count;
+    header->names_size = (uint32_t)names_size;
+    header->reserved = 0;
+    ProfileFileFunction* functions = (ProfileFileFunction*)(bytes + sizeof(ProfileFileHeader));
+    char* names = (char*)(functions + layout->function_count);
+    uint32_t name_offset = 0;
+    for (int f = 0; f < layout->function_count; f++) {
+        const ProfileFunction* entry = &layout->functions[f];
+        const char* name = module->functions[entry->function].name;
+        size_t length = strlen(name) + 1;
+        functions[f].checksum = entry->checksum;
+        functions[f].first_counter = (uint32_t)entry->first_counter;
+        functions[f].counter_count = (uint32_t)entry->counter_count;
+        functions[f].name_offset = name_offset;
+        functions[f].reserved = 0;
+        memcpy(names + name_offset, name, length);
+        name_offset += (uint32_t)length;
+    }
+    memcpy(names + align8(names_size), merged, sizeof(uint64_t) * (size_t)layout->counter_count);
+
+    bool ok = munmap(map, size) == 0;
+    ok = close(fd) == 0 && ok;
+    if (!ok) fprintf(err, "无法写入profile文件 %s: %s\n", path, strerror(errno));
+    free(merged);
+    return ok;
+}
+
+// ========== 读取 ==========
+
+bool profile_apply(IRModule* module, const ProfileLayout* layout, const char* path, ProfileStats* stats,
+                   FILE* err) {
+    ProfileData data;
+    if (!profile_map(path, &data, err)) return false;
+
+    ProfileStats local;
+    memset(&local, 0, sizeof(local));
+    for (int f = 0; f < layout->function_count; f++) {
+        const ProfileFunction* entry = &layout->functions[f];
+        IRFunction* function = &module->functions[entry->function];
+        local.functions++;
+        const ProfileFileFunction* recorded = find_function(&data, function->name);
+        if (!recorded) {
+            local.missing++;
+            continue;
+        }
+        if (recorded->checksum != entry->checksum || recorded->counter_count != (uint32_t)entry->counter_count) {
+            local.mismatched++;
+            continue;
+        }
+        for (int b = 0; b < entry->counter_count; b++) {
+            uint64_t count = data.counters[recorded->first_counter + b];
+            function->blocks[b].count = count > INT64_MAX ? INT64_MAX : (int64_t)count;
+        }
+        local.matched++;
+        local.counters += entry->counter_count;
+    }
+    profile_unmap(&data);
+
+    if (stats) {
+        stats->functions += local.functions;
+        stats->counters += local.counters;
+        stats->matched += local.matched;
+        stats->mismatched += local.mismatched;
+        stats->missing += local.missing;
+    }
+    return true;
+}
@@ -0,0 +1,89 @@
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include "ir.h"
+#include <stdio.h>
+
+// ========== 基于profile的优化(PGO) ==========
+//
+// 插桩和使用profile都在SSA构造之后、优化之前的同一处进行, 两次编译同一份源代码时IR完全相同:
+//   1. 拆分关键边(ir_function_split_critical_edges), 之后每条边要么是起点块唯一的出边,
+//      要么是终点块唯一的入边, 边的执行次数就等于这个块的执行次数, 只需为每个基本块计数;
+//   2. 对每个函数的控制流图计算校验和(基本块数、每个块的指令操作码和后继), 不含行号和常量。
+// --profile-generate: 每个基本块的phi之后插入一条count, 计数器是隐藏的全局数组PROFILE_GLOBAL,
+//   每个计数器8字节; 程序结束后把计数写入profile文件(profile_write)。count在x86-64上是一条不带lock的
+//   addq $1, __profile+8k(%rip): 程序是单线程的, 不需要原子操作。
+// --profile-use: 读取profile文件, 名字、校验和、基本块数都一致的函数把计数写入IRBlock.count;
+//   源代码修改过的函数(校验和不一致)和profile中没有的函数保持未知(-1), 照常优化。
+// 之后的各遍创建的块没有计数(-1), 尾递归消除和内联按比例推算移动或复制的块的计数。
+//
+// 文件格式(本机字节序, 以mmap读写):
+//   ProfileFileHeader
+//   ProfileFileFunction[function_count]
+//   名字(以'\0'结尾, 总长names_size, 补齐到8字节)
+//   uint64_t counters[counter_count]
+// 写入时与已有文件合并: 名字、校验和、计数器个数一致的函数累加原有的计数, 其余的丢弃。
+
+#define PROFILE_GLOBAL "__profile"
+#define PROFILE_MAGIC 0x464f5250u       // "PROF"
+#define PROFILE_VERSION 1
+#define PROFILE_DEFAULT_FILE "default.profdata"
+
+typedef struct ProfileFileHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t function_count;
+    uint32_t counter_count;
+    uint32_t names_size;
+    uint32_t reserved;
+} ProfileFileHeader;
+
+typedef struct ProfileFileFunction {
+    uint64_t checksum;
+    uint32_t first_counter;
+    uint32_t counter_count;
+    uint32_t name_offset;
+    uint32_t reserved;
+} ProfileFileFunction;
+
+// 模块中每个定义了的函数的计数器
+typedef struct ProfileFunction {
+    int function;           // IR函数编号
+    uint64_t checksum;
+    int first_counter;      // 基本块b的计数器是first_counter + b
+    int counter_count;      // 插桩时的基本块数
+} ProfileFunction;
+
+typedef struct ProfileLayout {
+    ProfileFunction* functions;
+    int function_count;
+    int counter_count;
+    int global;             // 计数器全局变量的编号, -1表示没有插桩
+} ProfileLayout;
+
+typedef struct ProfileStats {
+    int functions;          // 有计数器的函数
+    int counters;           // 计数器个数(插桩时)或读到的计数器个数
+    int matched;            // 使用了计数的函数
+    int mismatched;         // 校验和或基本块数与profile不一致而忽略的函数
+    int missing;            // profile中没有记录的函数
+} ProfileStats;
+
+// 拆分关键边并计算每个函数的校验和; 模块必须已经过SSA构造
+ProfileLayout* profile_layout_create(IRModule* module);
+void profile_layout_destroy(ProfileLayout* layout);
+
+// --profile-generate: 添加计数器全局变量, 在每个非空基本块的phi之后插入count
+void profile_instrument(IRModule* module, ProfileLayout* layout, ProfileStats* stats);
+
+// 把程序运行后的计数(插桩的全局变量的内容, counter_count个uint64_t)与path中已有的计数合并后写回;
+// 失败时把原因写到err并返回false
+bool profile_write(const IRModule* module, const ProfileLayout* layout, const void* counters, const char* path,
+                   FILE* err);
+
+// --profile-use: 读取path, 把匹配的函数的计数写入IRBlock.count;
+// 文件不存在或格式不对时把原因写到err并返回false, 模块不变
+bool profile_apply(IRModule* module, const ProfileLayout* layout, const char* path, ProfileStats* stats,
+                   FILE* err);
+
+#endif // PROFILE_H
@@ -1,4 +1,5 @@
 #include "semantic_analyzer.h"
+#include "trace.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -22,6 +23,12 @@ SemanticAnalyzer* semantic_analyzer_create() {
     analyzer->in_function = false;
     analyzer->has_return = false;
     analyzer->enable_constant_folding = true;
+    analyzer->out = stdout;
+    analyzer->err = stderr;
+    analyzer->perf = NULL;
+    analyzer->unused_notes = NULL;
+    analyzer->unused_count = 0;
+    analyzer->unused_capacity = 0;
     
     return analyzer;
 }
@@ -31,34 +38,44 @@ void semantic_analyzer_destroy(SemanticAnalyzer* analyzer) {
     
     symbol_table_destroy(analyzer->symbol_table);
     type_checker_destroy(analyzer->type_checker);
+    free(analyzer->unused_notes);
     free(analyzer);
 }
 
+void semantic_analyzer_set_output(SemanticAnalyzer* analyzer, FILE* out, FILE* err) {
+    if (!analyzer) return;
+    
+    analyzer->out = out;
+    analyzer->err = err;
+    analyzer->type_checker->out = out;
+    analyzer->type_checker->err = err;
+}
+
 // ========== 错误和警告报告 ==========
 
 void semantic_error(SemanticAnalyzer* analyzer, int line, const char* format, ...) {
-    fprintf(stderr, "\033[31m语义错误 (行 %d): ", line);
+    fprintf(analyzer->err, "\033[31m语义错误 (行 %d): ", line);
     
     va_list args;
     va_start(args, format);
-    vfprintf(stderr, format, args);
+    vfprintf(analyzer->err, format, args);
     va_end(args);
     
-    fprintf(stderr, "\033[0m\n");
+    fprintf(analyzer->err, "\033[0m\n");
     
     analyzer->has_errors = true;
     analyzer->error_count++;
 }
 
 void semantic_warning(SemanticAnalyzer* analyzer, int line, const char* format, ...) {
-    fprintf(stderr, "\033[33m语义警告 (行 %d): ", line);
+    fprintf(analyzer->err, "\033[33m语义警告 (行 %d): ", line);
     
     va_list args;
     va_start(args, format);
-    vfprintf(stderr, format, args);
+    vfprintf(analyzer->err, format, args);
     va_end(args);
     
-    fprintf(stderr, "\033[0m\n");
+    fprintf(analyzer->err, "\033[0m\n");
     
     analyzer->warning_count++;
 }
@@ -199,6 +216,63 @@ ASTNode* constant_fold(SemanticAnalyzer* analyzer, ASTNode* node) {
     }
 }
 
+ASTNode* constant_fold_tree(SemanticAnalyzer* analyzer, ASTNode* node) {
+    if (!node) return NULL;
+    
+    // 先折叠子节点,用折叠结果替换子节点指针(被折叠的旧节点已释放)
+    switch (node->node_type) {
+        case AST_VAR_DECL:
+            node->data.var_decl.init_value = constant_fold_tree(analyzer, node->data.var_decl.init_value);
+            break;
+        case AST_FUNC_DECL:
+            node->data.func_decl.body = constant_fold_tree(analyzer, node->data.func_decl.body);
+            break;
+        case AST_ASSIGN_STMT:
+            node->data.assign_stmt.rvalue = constant_fold_tree(analyzer, node->data.assign_stmt.rvalue);
+            break;
+        case AST_RETURN_STMT:
+            node->data.return_stmt.return_value = constant_fold_tree(analyzer, node->data.return_stmt.return_value);
+            break;
+        case AST_FUNC_CALL:
+            for (int i = 0; i < node->data.func_call.arg_count; i++) {
+                node->data.func_call.args[i] = constant_fold_tree(analyzer, node->data.func_call.args[i]);
+            }
+            break;
+        case AST_IF_STMT:
+            node->data.if_stmt.condition = constant_fold_tree(analyzer, node->data.if_stmt.condition);
+            node->data.if_stmt.then_branch = constant_fold_tree(analyzer, node->data.if_stmt.then_branch);
+            node->data.if_stmt.else_branch = constant_fold_tree(analyzer, node->data.if_stmt.else_branch);
+            break;
+        case AST_WHILE_STMT:
+            node->data.while_stmt.condition = constant_fold_tree(analyzer, node->data.while_stmt.condition);
+            node->data.while_stmt.body = constant_fold_tree(analyzer, node->data.while_stmt.body);
+            break;
+        case AST_COMPOUND_STMT:
+            for (int i = 0; i < node->data.compound_stmt.stmt_count; i++) {
+                node->data.compound_stmt.statements[i] =
+                    constant_fold_tree(analyzer, node->data.compound_stmt.statements[i]);
+            }
+            break;
+        case AST_EXPR_STMT:
+            node->data.expr_stmt.expr = constant_fold_tree(analyzer, node->data.expr_stmt.expr);
+            break;
+        case AST_ARRAY_ACCESS:
+            node->data.array_access.index = constant_fold_tree(analyzer, node->data.array_access.index);
+            break;
+        case AST_PROGRAM:
+            for (int i = 0; i < node->data.program.decl_count; i++) {
+                node->data.program.declarations[i] =
+                    constant_fold_tree(analyzer, node->data.program.declarations[i]);
+            }
+            break;
+        default:
+            break;
+    }
+    
+    // 二元/一元运算本身由constant_fold处理
+    return constant_fold(analyzer, node);
+}
+
 // ========== 死代码检测 ==========
 
 bool is_unreachable_after(ASTNode* node) {
@@ -419,10 +493,61 @@ void semantic_check_func_call(SemanticAnalyzer* analyzer, ASTNode* node) {
     }
 }
 
+// 把全局声明登记到语义分析器的符号表(重复声明由类型检查器报告)
+static void semantic_declare_global(SemanticAnalyzer* analyzer, const char* name,
+                                    SymbolKind kind, Type* type) {
+    if (symbol_table_lookup(analyzer->symbol_table, name)) return;
+    
+    Symbol* symbol = symbol_table_insert(analyzer->symbol_table, name, kind, type);
+    if (symbol) {
+        symbol_update_definition(symbol, true);
+    }
+}
+
 // ========== 未使用变量检测 ==========
 
+void semantic_note_unused(SemanticAnalyzer* analyzer, const char* name, int line, bool dead_store) {
+    if (!analyzer || !name) return;
+    
+    if (analyzer->unused_count == analyzer->unused_capacity) {
+        int capacity = analyzer->unused_capacity ? analyzer->unused_capacity * 2 : 8;
+        UnusedVarNote* notes = (UnusedVarNote*)realloc(analyzer->unused_notes,
+                                                       sizeof(UnusedVarNote) * capacity);
+        if (!notes) {
+            perror("malloc failed for UnusedVarNote");
+            exit(1);
+        }
+        analyzer->unused_notes = notes;
+        analyzer->unused_capacity = capacity;
+    }
+    
+    UnusedVarNote* note = &analyzer->unused_notes[analyzer->unused_count++];
+    note->name = name;
+    note->line = line;
+    note->dead_store = dead_store;
+}
+
+static int compare_unused_notes(const void* a, const void* b) {
+    const UnusedVarNote* x = (const UnusedVarNote*)a;
+    const UnusedVarNote* y = (const UnusedVarNote*)b;
+    if (x->line != y->line) return x->line < y->line ? -1 : 1;
+    return (int)x->dead_store - (int)y->dead_store;
+}
+
 void check_unused_variables(SemanticAnalyzer* analyzer) {
-    (void)analyzer;
+    if (!analyzer || analyzer->unused_count == 0) return;
+    
+    qsort(analyzer->unused_notes, analyzer->unused_count, sizeof(UnusedVarNote),
+          compare_unused_notes);
+    for (int i = 0; i < analyzer->unused_count; i++) {
+        UnusedVarNote* note = &analyzer->unused_notes[i];
+        if (note->dead_store) {
+            semantic_warning(analyzer, note->line, "赋给变量 '%s' 的值从未被使用", note->name);
+        } else {
+            semantic_warning(analyzer, note->line, "变量 '%s' 声明后从未被使用", note->name);
+        }
+    }
+    analyzer->unused_count = 0;
 }
 
 // ========== 主语义分析函数 ==========
@@ -433,12 +558,20 @@ void semantic_analyze_node(SemanticAnalyzer* analyzer, ASTNode* node) {
     switch (node->node_type) {
         case AST_VAR_DECL:
             semantic_check_var_decl(analyzer, node);
+            if (!analyzer->in_function) {
+                semantic_declare_global(analyzer, node->data.var_decl.var_name,
+                                        SYMBOL_VAR, node->data.var_decl.var_type);
+            }
             if (node->data.var_decl.init_value) {
                 semantic_analyze_node(analyzer, node->data.var_decl.init_value);
             }
             break;
             
         case AST_FUNC_DECL:
+            trace_begin("semantic", node->data.func_decl.func_name);
+            // 先登记函数再检查函数体, 递归调用才能找到自己
+            semantic_declare_global(analyzer, node->data.func_decl.func_name,
+                                    SYMBOL_FUNC, node->data.func_decl.return_type);
             semantic_check_func_decl(analyzer, node);
             if (node->data.func_decl.body) {
                 bool saved_in_function = analyzer->in_function;
@@ -452,6 +585,7 @@ void semantic_analyze_node(SemanticAnalyzer* analyzer, ASTNode* node) {
                 analyzer->in_function = saved_in_function;
                 analyzer->has_return = saved_has_return;
             }
+            trace_end();
             break;
             
         case AST_ASSIGN_STMT:
@@ -471,21 +605,11 @@ void semantic_analyze_node(SemanticAnalyzer* analyzer, ASTNode* node) {
             semantic_check_binary_op(analyzer, node);
             semantic_analyze_node(analyzer, node->data.binary_op.left);
             semantic_analyze_node(analyzer, node->data.binary_op.right);
-            
-            // 常量折叠
-            if (analyzer->enable_constant_folding) {
-                node = constant_fold(analyzer, node);
-            }
             break;
             
         case AST_UNARY_OP:
             semantic_check_unary_op(analyzer, node);
             semantic_analyze_node(analyzer, node->data.unary_op.operand);
-            
-            // 常量折叠
-            if (analyzer->enable_constant_folding) {
-                node = constant_fold(analyzer, node);
-            }
             break;
             
         case AST_FUNC_CALL:
@@ -543,10 +667,12 @@ bool semantic_analyze_program(SemanticAnalyzer* analyzer, ASTNode* program) {
         return false;
     }
     
-    printf("\n========== 开始语义分析 ==========\n");
+    fprintf(analyzer->out, "\n========== 开始语义分析 ==========\n");
     
     // 首先进行类型检查
+    perf_phase_begin(analyzer->perf, PHASE_TYPE_CHECK);
     bool type_check_passed = type_check_program(analyzer->type_checker, program);
+    perf_phase_end(analyzer->perf, PHASE_TYPE_CHECK);
     
     if (!type_check_passed) {
         analyzer->has_errors = true;
@@ -554,24 +680,33 @@ bool semantic_analyze_program(SemanticAnalyzer* analyzer, ASTNode* program) {
     }
     
     // 然后进行其他语义检查
+    perf_phase_begin(analyzer->perf, PHASE_SEMANTIC);
     for (int i = 0; i < program->data.program.decl_count; i++) {
         semantic_analyze_node(analyzer, program->data.program.declarations[i]);
     }
     
     // 检查未使用的变量
     check_unused_variables(analyzer);
+    perf_phase_end(analyzer->perf, PHASE_SEMANTIC);
+    
+    // 常量折叠(在所有检查之后进行,检查看到的是源程序原本的结构)
+    if (analyzer->enable_constant_folding) {
+        perf_phase_begin(analyzer->perf, PHASE_FOLD);
+        constant_fold_tree(analyzer, program);
+        perf_phase_end(analyzer->perf, PHASE_FOLD);
+    }
     
-    printf("========== 语义分析完成 ==========\n");
+    fprintf(analyzer->out, "========== 语义分析完成 ==========\n");
     
     if (analyzer->has_errors) {
-        printf("\033[31m发现 %d 个语义错误\033[0m\n", analyzer->error_count);
+        fprintf(analyzer->out, "\033[31m发现 %d 个语义错误\033[0m\n", analyzer->error_count);
         return false;
     } else {
-        printf("\033[32m语义分析通过");
+        fprintf(analyzer->out, "\033[32m语义分析通过");
         if (analyzer->warning_count > 0) {
-            printf(" (有 %d 个警告)", analyzer->warning_count);
+            fprintf(analyzer->out, " (有 %d 个警告)", analyzer->warning_count);
         }
-        printf("\033[0m\n");
+        fprintf(analyzer->out, "\033[0m\n");
         return true;
     }
 }
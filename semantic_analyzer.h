@@ -4,10 +4,19 @@
 #include "ast.h"
 #include "symbol_table.h"
 #include "type_checker.h"
+#include "perf_report.h"
 #include <stdbool.h>
+#include <stdio.h>
 
 // ========== 语义分析器结构 ==========
 
+// 中间代码分析发现的未使用变量或无用赋值, 等待check_unused_variables报告
+typedef struct UnusedVarNote {
+    const char* name;       // 变量名(须在报告前保持有效)
+    int line;
+    bool dead_store;        // true: 赋的值从未被读取; false: 变量从未被使用
+} UnusedVarNote;
+
 typedef struct SemanticAnalyzer {
     SymbolTable* symbol_table;
     TypeChecker* type_checker;
@@ -22,12 +31,26 @@ typedef struct SemanticAnalyzer {
     
     // 常量折叠
     bool enable_constant_folding;
+    
+    // 输出流
+    FILE* out;              // 进度信息输出流(默认stdout)
+    FILE* err;              // 错误和警告输出流(默认stderr)
+    
+    // 阶段统计(NULL表示不统计)
+    PerfReport* perf;
+    
+    // 未使用变量检测
+    UnusedVarNote* unused_notes;
+    int unused_count;
+    int unused_capacity;
 } SemanticAnalyzer;
 
 // ========== 语义分析器操作函数 ==========
 
 SemanticAnalyzer* semantic_analyzer_create();
 void semantic_analyzer_destroy(SemanticAnalyzer* analyzer);
+// 设置输出流(同时作用于内部的类型检查器)
+void semantic_analyzer_set_output(SemanticAnalyzer* analyzer, FILE* out, FILE* err);
 
 // 主要的语义分析函数
 bool semantic_analyze_program(SemanticAnalyzer* analyzer, ASTNode* program);
@@ -50,12 +73,16 @@ bool check_all_paths_return(ASTNode* node);
 ASTNode* constant_fold(SemanticAnalyzer* analyzer, ASTNode* node);
 ASTNode* fold_binary_op(ASTNode* node);
 ASTNode* fold_unary_op(ASTNode* node);
+// 对整棵子树做常量折叠,返回(可能被替换的)子树根节点
+ASTNode* constant_fold_tree(SemanticAnalyzer* analyzer, ASTNode* node);
 
 // 死代码检测
 void detect_dead_code(SemanticAnalyzer* analyzer, ASTNode* node);
 bool is_unreachable_after(ASTNode* node);
 
-// 未使用变量检测
+// 未使用变量检测: 变量的读写要到中间代码上做活跃分析才能看清,
+// 分析结果由semantic_note_unused记录, check_unused_variables按行号输出警告并清空
+void semantic_note_unused(SemanticAnalyzer* analyzer, const char* name, int line, bool dead_store);
 void check_unused_variables(SemanticAnalyzer* analyzer);
 
 // 错误和警告报告
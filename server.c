@@ -0,0 +1,359 @@
+#define _GNU_SOURCE
+
+#include "server.h"
+#include "driver.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <signal.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+// 通信协议(本机字节序, 字符串 = u32长度 + 字节):
+//   请求: u32 魔数, 字符串 cwd, u32 argc, argc个字符串, u32 是否带源代码, [字符串 源代码]
+//   回复: i32 退出码, 字符串 标准输出, 字符串 诊断信息
+#define SERVER_MAGIC 0x31534343u            // "CCS1"
+#define SERVER_MAX_MESSAGE (64u << 20)      // 单个字符串的长度上限
+#define SERVER_IO_TIMEOUT 10                // 单次读写的超时(秒), 防止不发请求的客户端一直占着工作线程
+
+static char server_socket_path[sizeof(((struct sockaddr_un*)0)->sun_path)];
+
+// ========== 读写工具 ==========
+
+static bool write_all(int fd, const void* data, size_t length) {
+    const char* p = (const char*)data;
+    while (length > 0) {
+        ssize_t n = write(fd, p, length);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        p += n;
+        length -= (size_t)n;
+    }
+    return true;
+}
+
+static bool read_all(int fd, void* data, size_t length) {
+    char* p = (char*)data;
+    while (length > 0) {
+        ssize_t n = read(fd, p, length);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        if (n == 0) return false;  // 对端提前关闭
+        p += n;
+        length -= (size_t)n;
+    }
+    return true;
+}
+
+static bool write_u32(int fd, uint32_t value) {
+    return write_all(fd, &value, sizeof(value));
+}
+
+static bool read_u32(int fd, uint32_t* value) {
+    return read_all(fd, value, sizeof(*value));
+}
+
+static bool write_string(int fd, const char* data, size_t length) {
+    return write_u32(fd, (uint32_t)length) && write_all(fd, data, length);
+}
+
+// 读取一个字符串(追加'\0'), 调用者负责释放
+static char* read_string(int fd, size_t* length) {
+    uint32_t len;
+    if (!read_u32(fd, &len) || len > SERVER_MAX_MESSAGE) return NULL;
+    
+    char* data = (char*)malloc(len + 1);
+    if (!data) {
+        perror("malloc failed for message");
+        exit(1);
+    }
+    if (!read_all(fd, data, len)) {
+        free(data);
+        return NULL;
+    }
+    data[len] = '\0';
+    if (length) *length = len;
+    return data;
+}
+
+void server_default_socket_path(char* buffer, size_t size) {
+    snprintf(buffer, size, "/tmp/c_compiler-%u.sock", (unsigned)getuid());
+}
+
+static bool fill_address(struct sockaddr_un* addr, const char* socket_path) {
+    memset(addr, 0, sizeof(*addr));
+    addr->sun_family = AF_UNIX;
+    if (strlen(socket_path) >= sizeof(addr->sun_path)) {
+        fprintf(stderr, "套接字路径过长: %s\n", socket_path);
+        return false;
+    }
+    strcpy(addr->sun_path, socket_path);
+    return true;
+}
+
+// ========== 服务端 ==========
+
+typedef struct ServerRequest {
+    char* cwd;
+    int argc;
+    char** argv;
+    char* source;       // 标准输入的源代码(可为NULL)
+    size_t source_length;
+} ServerRequest;
+
+static void request_free(ServerRequest* request) {
+    free(request->cwd);
+    for (int i = 0; i < request->argc; i++) {
+        free(request->argv[i]);
+    }
+    free(request->argv);
+    free(request->source);
+}
+
+static bool read_request(int fd, ServerRequest* request) {
+    memset(request, 0, sizeof(*request));
+    
+    uint32_t magic, argc, has_source;
+    if (!read_u32(fd, &magic) || magic != SERVER_MAGIC) return false;
+    if (!(request->cwd = read_string(fd, NULL))) return false;
+    if (!read_u32(fd, &argc) || argc == 0 || argc > 65536) return false;
+    
+    request->argv = (char**)calloc(argc + 1, sizeof(char*));
+    if (!request->argv) {
+        perror("calloc failed for argv");
+        exit(1);
+    }
+    for (uint32_t i = 0; i < argc; i++) {
+        if (!(request->argv[i] = read_string(fd, NULL))) return false;
+        request->argc++;
+    }
+    
+    if (!read_u32(fd, &has_source)) return false;
+    if (has_source && !(request->source = read_string(fd, &request->source_length))) return false;
+    return true;
+}
+
+static void handle_connection(int fd) {
+    ServerRequest request;
+    if (!read_request(fd, &request)) {
+        request_free(&request);
+        return;
+    }
+    
+    char* out_buf = NULL;
+    char* err_buf = NULL;
+    size_t out_len = 0, err_len = 0;
+    FILE* out = open_memstream(&out_buf, &out_len);
+    FILE* err = open_memstream(&err_buf, &err_len);
+    if (!out || !err) {
+        perror("open_memstream failed");
+        exit(1);
+    }
+    
+    DriverOptions options;
+    driver_options_init(&options);
+    options.base_dir = request.cwd;
+    options.stdin_source = request.source;
+    options.stdin_length = request.source_length;
+    options.allow_run = false;
+    options.allow_trace = false;
+    
+    int32_t status = driver_run(request.argc, request.argv, &options, out, err);
+    
+    fclose(out);
+    fclose(err);
+    
+    // 客户端中途断开时写入失败,忽略即可
+    if (write_all(fd, &status, sizeof(status))) {
+        if (write_string(fd, out_buf, out_len)) {
+            write_string(fd, err_buf, err_len);
+        }
+    }
+    
+    free(out_buf);
+    free(err_buf);
+    request_free(&request);
+}
+
+// 只接受与服务进程同一用户的客户端: 请求里的 -o、-freport-json= 等路径会以服务进程的身份写入
+static bool peer_allowed(int fd) {
+    struct ucred cred;
+    socklen_t length = sizeof(cred);
+    if (getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &cred, &length) != 0) return false;
+    return cred.uid == getuid();
+}
+
+static void set_io_timeout(int fd) {
+    struct timeval timeout = { SERVER_IO_TIMEOUT, 0 };
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+}
+
+// 工作线程常驻: 线程及其malloc分配区在多次请求间保持复用
+static void* server_worker(void* arg) {
+    int listen_fd = *(int*)arg;
+    
+    while (1) {
+        int fd = accept(listen_fd, NULL, NULL);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            perror("accept failed");
+            break;
+        }
+        if (peer_allowed(fd)) {
+            set_io_timeout(fd);
+            handle_connection(fd);
+        }
+        close(fd);
+    }
+    
+    return NULL;
+}
+
+static void server_handle_signal(int sig) {
+    (void)sig;
+    unlink(server_socket_path);
+    _exit(0);
+}
+
+int server_run(const char* socket_path) {
+    struct sockaddr_un addr;
+    if (!fill_address(&addr, socket_path)) return 1;
+    
+    int listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listen_fd < 0) {
+        perror("socket failed");
+        return 1;
+    }
+    
+    // 清理上次异常退出遗留的套接字文件
+    unlink(socket_path);
+    // 套接字文件只允许本用户连接; umask保证创建时就没有其他用户的权限
+    mode_t old_mask = umask(0077);
+    int bound = bind(listen_fd, (struct sockaddr*)&addr, sizeof(addr));
+    umask(old_mask);
+    if (bound != 0 || chmod(socket_path, 0600) != 0) {
+        perror("bind failed");
+        close(listen_fd);
+        if (bound == 0) unlink(socket_path);
+        return 1;
+    }
+    if (listen(listen_fd, 64) != 0) {
+        perror("listen failed");
+        close(listen_fd);
+        unlink(socket_path);
+        return 1;
+    }
+    
+    strcpy(server_socket_path, socket_path);
+    signal(SIGPIPE, SIG_IGN);
+    signal(SIGINT, server_handle_signal);
+    signal(SIGTERM, server_handle_signal);
+    
+    int worker_count = driver_default_jobs();
+    pthread_t* workers = (pthread_t*)malloc(sizeof(pthread_t) * worker_count);
+    if (!workers) {
+        perror("malloc failed for workers");
+        exit(1);
+    }
+    for (int i = 0; i < worker_count; i++) {
+        if (pthread_create(&workers[i], NULL, server_worker, &listen_fd) != 0) {
+            perror("pthread_create failed");
+            exit(1);
+        }
+    }
+    
+    printf("编译服务已启动: %s (%d 个工作线程)\n", socket_path, worker_count);
+    fflush(stdout);
+    
+    for (int i = 0; i < worker_count; i++) {
+        pthread_join(workers[i], NULL);
+    }
+    free(workers);
+    close(listen_fd);
+    unlink(socket_path);
+    return 1;
+}
+
+// ========== 客户端 ==========
+
+int client_run(const char* socket_path, int argc, char* argv[]) {
+    struct sockaddr_un addr;
+    if (!fill_address(&addr, socket_path)) return 1;
+    
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        perror("socket failed");
+        return 1;
+    }
+    if (connect(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+        fprintf(stderr, "无法连接编译服务 %s: %s\n", socket_path, strerror(errno));
+        close(fd);
+        return 1;
+    }
+    
+    // 输入文件为"-"时读取标准输入,随请求一起发送
+    char* source = NULL;
+    size_t source_length = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-") == 0) {
+            source = driver_read_stream(stdin, &source_length);
+            break;
+        }
+    }
+    
+    char cwd[4096];
+    if (!getcwd(cwd, sizeof(cwd))) {
+        perror("getcwd failed");
+        close(fd);
+        free(source);
+        return 1;
+    }
+    
+    bool ok = write_u32(fd, SERVER_MAGIC) && write_string(fd, cwd, strlen(cwd)) &&
+              write_u32(fd, (uint32_t)argc);
+    for (int i = 0; ok && i < argc; i++) {
+        ok = write_string(fd, argv[i], strlen(argv[i]));
+    }
+    ok = ok && write_u32(fd, source ? 1 : 0);
+    if (ok && source) {
+        ok = write_string(fd, source, source_length);
+    }
+    free(source);
+    
+    int32_t status = 1;
+    char* out_buf = NULL;
+    char* err_buf = NULL;
+    size_t out_len = 0, err_len = 0;
+    if (ok) {
+        ok = read_all(fd, &status, sizeof(status)) &&
+             (out_buf = read_string(fd, &out_len)) != NULL &&
+             (err_buf = read_string(fd, &err_len)) != NULL;
+    }
+    close(fd);
+    
+    if (!ok) {
+        fprintf(stderr, "与编译服务通信失败\n");
+        free(out_buf);
+        free(err_buf);
+        return 1;
+    }
+    
+    fwrite(out_buf, 1, out_len, stdout);
+    fwrite(err_buf, 1, err_len, stderr);
+    free(out_buf);
+    free(err_buf);
+    return status;
+}
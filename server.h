@@ -0,0 +1,20 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+#include <stddef.h>
+
+// ========== 常驻编译服务 ==========
+//
+// 服务端常驻内存, 通过本地Unix域套接字接收编译请求, 省去每次编译的进程启动开销;
+// 客户端只负责转发命令行参数(及标准输入的源代码)并打印服务端的回复.
+
+// 默认套接字路径: /tmp/c_compiler-<uid>.sock
+void server_default_socket_path(char* buffer, size_t size);
+
+// 启动编译服务(阻塞直到收到SIGINT/SIGTERM), 返回进程退出码
+int server_run(const char* socket_path);
+
+// 把命令行转发给编译服务并打印回复, 返回编译结果的退出码
+int client_run(const char* socket_path, int argc, char* argv[]);
+
+#endif // SERVER_H
@@ -30,6 +30,7 @@ Symbol* symbol_create(const char* name, SymbolKind kind, Type* type, int scope_l
     symbol->type = type_copy(type);
     symbol->scope_level = scope_level;
     symbol->is_defined = false;
+    symbol->ir_id = -1;
     symbol->next = NULL;
     
     // 初始化变量信息
@@ -246,34 +247,34 @@ void symbol_update_func_info(Symbol* symbol, Type** param_types, int param_count
     }
 }
 
-void symbol_table_print(SymbolTable* table) {
+void symbol_table_fprint(FILE* out, SymbolTable* table) {
     if (!table) return;
     
-    printf("\n========== Symbol Table ==========\n");
-    printf("Current Level: %d\n\n", table->current_level);
+    fprintf(out, "\n========== Symbol Table ==========\n");
+    fprintf(out, "Current Level: %d\n\n", table->current_level);
     
     // 递归打印作用域
     void print_scope(Scope* scope, int indent) {
         if (!scope) return;
         
-        for (int i = 0; i < indent; i++) printf("  ");
-        printf("Scope Level %d (symbols: %d)\n", scope->level, scope->symbol_count);
+        for (int i = 0; i < indent; i++) fprintf(out, "  ");
+        fprintf(out, "Scope Level %d (symbols: %d)\n", scope->level, scope->symbol_count);
         
         // 打印该作用域的所有符号
         for (int i = 0; i < SYMBOL_TABLE_SIZE; i++) {
             Symbol* symbol = scope->symbols[i];
             while (symbol) {
-                for (int j = 0; j < indent + 1; j++) printf("  ");
-                printf("- %s: %s %s", 
+                for (int j = 0; j < indent + 1; j++) fprintf(out, "  ");
+                fprintf(out, "- %s: %s %s", 
                        symbol->name, 
                        symbol_kind_str(symbol->kind),
                        type_to_string(symbol->type));
                 if (symbol->is_defined) {
-                    printf(" [defined]");
+                    fprintf(out, " [defined]");
                 } else {
-                    printf(" [declared]");
+                    fprintf(out, " [declared]");
                 }
-                printf("\n");
+                fprintf(out, "\n");
                 symbol = symbol->next;
             }
         }
@@ -285,7 +286,11 @@ void symbol_table_print(SymbolTable* table) {
     }
     
     print_scope(table->global_scope, 0);
-    printf("==================================\n\n");
+    fprintf(out, "==================================\n\n");
+}
+
+void symbol_table_print(SymbolTable* table) {
+    symbol_table_fprint(stdout, table);
 }
 
 const char* symbol_kind_str(SymbolKind kind) {
@@ -3,6 +3,7 @@
 
 #include "ast.h"
 #include <stdbool.h>
+#include <stdio.h>
 
 // ========== 符号类型 ==========
 
@@ -35,6 +36,8 @@ typedef struct Symbol {
         bool is_declared;    // 是否已声明
     } func_info;
     
+    int ir_id;            // 中间代码中的编号(栈槽/全局变量/函数), -1表示未分配
+    
     struct Symbol* next;  // 链表下一项(哈希冲突处理)
 } Symbol;
 
@@ -82,6 +85,7 @@ void symbol_update_func_info(Symbol* symbol, Type** param_types, int param_count
 
 // 工具函数
 void symbol_table_print(SymbolTable* table);
+void symbol_table_fprint(FILE* out, SymbolTable* table);
 const char* symbol_kind_str(SymbolKind kind);
 
 // ========== 作用域操作函数 ==========
@@ -0,0 +1,121 @@
+int putchar(int c);
+
+int counter = 5;
+int squares[10];
+int seed;
+int base = counter * 3 + 1;
+seed = base * 2;
+
+int sum8(int a, int b, int c, int d, int e, int f, int g, int h) {
+    return a + 2 * b + 3 * c + 4 * d + 5 * e + 6 * f + 7 * g + 8 * h;
+}
+
+int pick7(int a, int b, int c, int d, int e, int f, int g) {
+    return g * 100 + a - f;
+}
+
+int fib(int n) {
+    if (n < 2) return n;
+    return fib(n - 1) + fib(n - 2);
+}
+
+int gcd(int a, int b) {
+    while (b != 0) {
+        int t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+int identity(int x) { return x; }
+
+// 12个值同时活跃并跨过调用, 迫使寄存器分配器溢出和拆分
+int pressure(int n) {
+    int a = n + 1, b = n + 2, c = n + 3, d = n + 4, e = n + 5, f = n + 6;
+    int g = n + 7, h = n + 8, i = n + 9, j = n + 10, k = n + 11, l = n + 12;
+    int total = 0;
+    int round = 0;
+    while (round < 4) {
+        total = total + identity(a) + b + c + d + e + f + g + h + i + j + k + l;
+        a = a + 1;
+        l = l - 1;
+        round++;
+    }
+    return total;
+}
+
+// 循环中交换两个变量: 回边上的并行复制形成环
+int swap_loop(int n) {
+    int x = 1, y = 2, i = 0;
+    while (i < n) {
+        int t = x;
+        x = y;
+        y = t;
+        i++;
+    }
+    return x * 10 + y;
+}
+
+int logic(int a, int b) {
+    int r = 0;
+    if (a > 0 && b > 0) r = r + 1;
+    if (a > 0 || b > 0) r = r + 10;
+    if (!(a == b)) r = r + 100;
+    return r;
+}
+
+void fill_squares(int n) {
+    int i = 0;
+    while (i < n && i < 10) {
+        squares[i] = i * i;
+        i++;
+    }
+}
+
+int check(int value, int expected, int code) {
+    if (value != expected) {
+        putchar(70);
+        putchar(48 + code % 10);
+        putchar(10);
+        return 1;
+    }
+    return 0;
+}
+
+int main() {
+    int failed = 0;
+    int local[5];
+    int i = 0;
+
+    failed += check(sum8(1, 2, 3, 4, 5, 6, 7, 8), 204, 1);
+    failed += check(pick7(1, 2, 3, 4, 5, 6, 7), 695, 2);
+    failed += check(fib(15), 610, 3);
+    failed += check(gcd(84, 36), 12, 4);
+    failed += check(-17 / 5, -3, 5);
+    failed += check(-17 % 5, -2, 6);
+    failed += check(pressure(3), 4 * 114 + 0, 7);
+    failed += check(swap_loop(3), 21, 8);
+    failed += check(swap_loop(4), 12, 9);
+    failed += check(logic(1, 2) + logic(0, 0) + logic(-1, 3), 111 + 0 + 110, 0);
+
+    fill_squares(12);
+    while (i < 5) {
+        local[i] = squares[i * 2] - i;
+        i++;
+    }
+    failed += check(local[4], 60, 1);
+    failed += check(squares[9], 81, 2);
+
+    // 顶层语句在main之前执行
+    failed += check(base, 16, 3);
+    failed += check(seed, 32, 4);
+    failed += check(counter * 8 / 4, 10, 5);
+
+    if (failed == 0) {
+        putchar(79);
+        putchar(75);
+        putchar(10);
+    }
+    return failed;
+}
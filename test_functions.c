@@ -0,0 +1,23 @@
+int g = 3;
+int arr[10];
+int add(int a, int b);
+int fact(int n) {
+    if (n <= 1) return 1;
+    return n * fact(n - 1);
+}
+int add(int a, int b) { return a + b; }
+void fill(int n) {
+    int i = 0;
+    while (i < n && i < 10) {
+        arr[i] = i * i % 7;
+        i++;
+    }
+}
+int main() {
+    int s = 0, k;
+    fill(10);
+    k = 0;
+    while (k < 10) { s += arr[k]; k = k + 1; }
+    if (!(s == 0) || g > 2) s = add(s, fact(5)); else s = -s;
+    return s;
+}
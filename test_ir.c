@@ -0,0 +1,2141 @@
+#include "lexer.h"
+#include "ast.h"
+#include "ast_parser.h"
+#include "semantic_analyzer.h"
+#include "perf_report.h"
+#include "ir.h"
+#include "ir_lower.h"
+#include "ir_dom.h"
+#include "ir_ssa.h"
+#include "ir_verify.h"
+#include "ir_sccp.h"
+#include "ir_tailcall.h"
+#include "ir_inline.h"
+#include "ir_gvn.h"
+#include "ir_loop.h"
+#include "ir_licm.h"
+#include "ir_strength.h"
+#include "ir_dce.h"
+#include "ir_unroll.h"
+#include "profile.h"
+#include "ir_regalloc.h"
+#include "x86_64.h"
+#include "x86_codegen.h"
+#include "x86_peephole.h"
+#include "x86_frame.h"
+#include "x86_asm.h"
+#include "x86_encode.h"
+#include "elf_object.h"
+#include "jit.h"
+#include "vm.h"
+#include "tiered.h"
+#include "expr_eval.h"
+#include "outbuf.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <elf.h>
+
+// ========== 中间代码测试 ==========
+
+static int failures = 0;
+static FILE* null_stream;
+
+#define CHECK(cond, ...) do { \
+    if (!(cond)) { \
+        printf("  \033[31m失败\033[0m (行 %d): ", __LINE__); \
+        printf(__VA_ARGS__); \
+        printf("\n"); \
+        failures++; \
+    } \
+} while (0)
+
+// 源代码 → 类型检查 → IR, 出错返回NULL
+static IRModule* lower_source(const char* source) {
+    Lexer* lexer = lexer_create_from_memory(source, strlen(source));
+    if (!lexer) return NULL;
+    lexer->err = null_stream;
+    ASTNode* program = ast_parse_program(lexer, null_stream);
+    lexer_destroy(lexer);
+    if (!program) return NULL;
+
+    SemanticAnalyzer* analyzer = semantic_analyzer_create();
+    semantic_analyzer_set_output(analyzer, null_stream, null_stream);
+    IRModule* module = NULL;
+    if (semantic_analyze_program(analyzer, program)) {
+        module = ir_lower_program(program, stderr);
+    }
+    semantic_analyzer_destroy(analyzer);
+    ast_free(program);
+    return module;
+}
+
+static IRFunction* find_function(IRModule* module, const char* name) {
+    int id = ir_module_find_function(module, name);
+    return id >= 0 ? &module->functions[id] : NULL;
+}
+
+static int count_op(const IRFunction* function, IROpcode op) {
+    int count = 0;
+    for (int b = 0; b < function->block_count; b++) {
+        const IRBlock* block = &function->blocks[b];
+        for (int i = 0; i < block->instr_count; i++) {
+            if (function->instrs[block->instrs[i]].op == op) count++;
+        }
+    }
+    return count;
+}
+
+// ========== 支配树 ==========
+
+static void test_dominators(void) {
+    printf("=== 支配树 ===\n");
+
+    // bb0 → bb1 → {bb2, bb3} → bb4 → bb1(回边), bb1 → bb5
+    IRModule* module = lower_source(
+        "int f(int n) {\n"
+        "    int i = 0;\n"
+        "    while (i < n) {\n"
+        "        if (i % 2 == 0) i = i + 1; else i = i + 3;\n"
+        "    }\n"
+        "    return i;\n"
+        "}\n");
+    CHECK(module != NULL, "转换失败");
+    if (!module) return;
+
+    IRFunction* function = find_function(module, "f");
+    IRDomTree* dom = ir_dom_tree_create(function);
+    ir_dom_compute_frontiers(dom, function);
+
+    CHECK(dom->rpo_count == function->block_count, "所有块都应可达");
+    for (int b = 1; b < function->block_count; b++) {
+        CHECK(ir_dom_dominates(dom, 0, b), "入口应支配 bb%d", b);
+        CHECK(!ir_dom_dominates(dom, b, 0), "bb%d 不应支配入口", b);
+    }
+
+    // 循环头在每个分支块的支配边界中, 且支配循环体
+    int header = function->blocks[0].succs[0];
+    int then_block = -1, else_block = -1;
+    for (int b = 0; b < function->block_count; b++) {
+        IRInstr* term = ir_block_terminator(function, b);
+        if (b != header && term && term->op == IR_BR) {
+            then_block = ir_instr_args(function, term)[1].value;
+            else_block = ir_instr_args(function, term)[2].value;
+        }
+    }
+    CHECK(then_block >= 0 && else_block >= 0, "找不到if的两个分支");
+    if (then_block >= 0) {
+        CHECK(ir_dom_dominates(dom, header, then_block), "循环头应支配then分支");
+        CHECK(!ir_dom_dominates(dom, then_block, else_block), "then分支不应支配else分支");
+
+        bool found = false;
+        for (int f = dom->frontier_start[then_block]; f < dom->frontier_start[then_block + 1]; f++) {
+            int join = dom->frontier[f];
+            if (ir_dom_dominates(dom, join, then_block) == false) found = true;
+        }
+        CHECK(found, "then分支的支配边界应包含汇合点");
+        int header_df = dom->frontier_start[header + 1] - dom->frontier_start[header];
+        CHECK(header_df == 1 && dom->frontier[dom->frontier_start[header]] == header,
+              "循环头的支配边界应只有自身");
+    }
+
+    ir_dom_tree_destroy(dom);
+    ir_module_destroy(module);
+}
+
+// ========== SSA构造 ==========
+
+static void test_ssa(void) {
+    printf("=== SSA构造 ===\n");
+
+    IRModule* module = lower_source(
+        "int arr[4];\n"
+        "int f(int n) {\n"
+        "    int i = 0, s = 0, t, buf[2];\n"
+        "    while (i < n) {\n"
+        "        if (i > 2 && n > 4) s = s + i; else s = s - 1;\n"
+        "        buf[0] = s;\n"
+        "        i++;\n"
+        "    }\n"
+        "    t = s * 2;\n"
+        "    return t + buf[0];\n"
+        "}\n"
+        "int g(int a) {\n"
+        "    return a;\n"
+        "    a = a + 1;\n"
+        "}\n");
+    CHECK(module != NULL, "转换失败");
+    if (!module) return;
+
+    CHECK(ir_module_verify(module, stdout), "SSA构造前校验失败");
+    IRSSAStats stats;
+    memset(&stats, 0, sizeof(stats));
+    ir_module_to_ssa(module, &stats);
+    CHECK(ir_module_verify(module, stdout), "SSA构造后校验失败");
+
+    IRFunction* f = find_function(module, "f");
+    // i和s在循环头各一个phi, s在if汇合点一个, &&的结果一个; t和n不需要phi(剪枝)
+    CHECK(count_op(f, IR_PHI) == 4, "f 应有4个phi, 实际 %d", count_op(f, IR_PHI));
+    for (int s = 0; s < f->slot_count; s++) {
+        bool is_array = f->slots[s].count > 1;
+        CHECK(f->slots[s].promoted != is_array, "栈槽 $%d 的提升结果不对", s);
+    }
+    // 只剩下数组的访问
+    CHECK(count_op(f, IR_LOAD) == 1 && count_op(f, IR_STORE) == 1, "f 中应只剩数组的load/store");
+
+    // return之后的不可达代码被删除
+    IRFunction* g = find_function(module, "g");
+    CHECK(stats.removed_blocks >= 1, "应清空return之后的基本块");
+    CHECK(count_op(g, IR_ADD) == 0, "g 中不可达的加法应被删除");
+
+    ir_module_destroy(module);
+}
+
+// ========== 校验器 ==========
+
+static void test_verifier(void) {
+    printf("=== 校验器 ===\n");
+
+    IRModule* module = lower_source("int f(int a) { int x = a; while (x > 0) x = x - 1; return x; }\n");
+    CHECK(module != NULL, "转换失败");
+    if (!module) return;
+    ir_module_to_ssa(module, NULL);
+    IRFunction* f = find_function(module, "f");
+    CHECK(ir_function_verify(module, f, stdout), "正确的IR不应报错");
+
+    // 把循环头phi的一个输入换成在它之后才定值的寄存器
+    IRBlock* header = &f->blocks[f->blocks[0].succs[0]];
+    IRInstr* phi = &f->instrs[header->instrs[0]];
+    CHECK(phi->op == IR_PHI, "循环头应以phi开始");
+    IROperand* args = ir_instr_args(f, phi);
+    IROperand saved = args[1];
+    int late = f->instrs[header->instrs[1]].dest;
+    args[1] = ir_operand_vreg(late, (IRType)f->vreg_types[late]);
+    args[1].type = phi->type;
+    CHECK(!ir_function_verify(module, f, null_stream), "应发现不满足支配关系的使用");
+    args[1] = saved;
+
+    // 去掉终结指令
+    IRBlock* entry = &f->blocks[0];
+    entry->instr_count--;
+    CHECK(!ir_function_verify(module, f, null_stream), "应发现没有终结指令的基本块");
+    entry->instr_count++;
+    CHECK(ir_function_verify(module, f, stdout), "恢复后应通过校验");
+
+    ir_module_destroy(module);
+}
+
+// ========== 常量传播 ==========
+
+// 函数的返回值是常量时返回true并写入value
+static bool returns_const(IRFunction* function, int* value) {
+    int found = 0;
+    for (int b = 0; b < function->block_count; b++) {
+        IRInstr* term = ir_block_terminator(function, b);
+        if (!term || term->op != IR_RET) continue;
+        IROperand* args = ir_instr_args(function, term);
+        if (term->arg_count != 1 || args[0].kind != IR_OPERAND_CONST) return false;
+        *value = args[0].value;
+        found++;
+    }
+    return found == 1;
+}
+
+static void test_sccp(void) {
+    printf("=== 常量传播 ===\n");
+
+    IRModule* module = lower_source(
+        "int a;\n"
+        "int result;\n"
+        "int f(int n) {\n"
+        "    int x = 1, y;\n"
+        "    if (x > 0) y = 10; else y = 20;\n"
+        "    while (y < 5) y++;\n"
+        "    if (n > 3) y = y + 0 * n;\n"
+        "    return y * 2;\n"
+        "}\n"
+        "int g(int n) {\n"
+        "    int i = 0, k = 7;\n"
+        "    while (i < n) {\n"
+        "        if (k != 7) k = k + 1;\n"
+        "        i = i + k;\n"
+        "    }\n"
+        "    return k;\n"
+        "}\n"
+        "int h(int n) { int z = 0; return n / z + 2147483647 + 1; }\n"
+        "a = 4;\n"
+        "result = a * 2\n");
+    CHECK(module != NULL, "转换失败");
+    if (!module) return;
+
+    ir_module_to_ssa(module, NULL);
+    IRSCCPStats stats;
+    memset(&stats, 0, sizeof(stats));
+    ir_module_sccp(module, &stats, NULL);
+    CHECK(ir_module_verify(module, stdout), "常量传播后校验失败");
+
+    int value = 0;
+    IRFunction* f = find_function(module, "f");
+    CHECK(returns_const(f, &value) && value == 20, "f 应返回常量20");
+    CHECK(count_op(f, IR_PHI) == 0, "f 中的phi都应被消除");
+
+    // k经过循环中永远不执行的分支仍是常量(普通常量传播做不到)
+    IRFunction* g = find_function(module, "g");
+    CHECK(returns_const(g, &value) && value == 7, "g 应返回常量7");
+    CHECK(count_op(g, IR_PHI) == 1, "g 中只应剩下i的phi");
+
+    // 传播得到的除零留到运行时
+    IRFunction* h = find_function(module, "h");
+    CHECK(count_op(h, IR_DIV) == 1, "除零不应被折叠");
+
+    // 经过全局变量的常量: result = a * 2 直接存入8
+    IRFunction* top = find_function(module, IR_TOPLEVEL_NAME);
+    CHECK(count_op(top, IR_MUL) == 0 && count_op(top, IR_LOAD) == 0, "顶层的a * 2应被折叠");
+    CHECK(stats.forwarded_loads == 1, "应转发1条load, 实际 %d", stats.forwarded_loads);
+    CHECK(stats.folded_branches == 3, "应折叠3个分支, 实际 %d", stats.folded_branches);
+    CHECK(stats.removed_blocks >= 3 && stats.removed_instrs > 10, "删除的块/指令数不对: %d/%d",
+          stats.removed_blocks, stats.removed_instrs);
+
+    ir_module_destroy(module);
+}
+
+// ========== 函数内联 ==========
+
+static void test_inline(void) {
+    printf("=== 函数内联 ===\n");
+
+    IRModule* module = lower_source(
+        "int g;\n"
+        "int sq(int x) { return x * x; }\n"
+        "int clamp(int x, int lo, int hi) { if (x < lo) return lo; if (x > hi) return hi; return x; }\n"
+        "int fib(int n) { if (n < 2) return n; return fib(n - 1) + fib(n - 2); }\n"
+        "int is_even(int n);\n"
+        "int is_odd(int n) { if (n == 0) return 0; return is_even(n - 1); }\n"
+        "int is_even(int n) { if (n == 0) return 1; return is_odd(n - 1); }\n"
+        "void bump(int k) { g = g + k; }\n"
+        "int big(int n) { int s = 0; int i = 0; while (i < n) { s = s + i * i - n / 3 + (s % 7) * 2; i++; }\n"
+        "    s = s * 3 + n; s = s - n * n + 11; s = s / 5 + g * 4; s = s % 1000 + n - 9; return s * 2 - 1; }\n"
+        "int use_big(int n) { return big(n) + big(n + 1); }\n"
+        "int four() { return sq(2); }\n"
+        "int main() { bump(3); return sq(7) + clamp(g, 0, 2) + fib(6) + is_even(4) + four(); }\n");
+    CHECK(module != NULL, "转换失败");
+    if (!module) return;
+    ir_module_to_ssa(module, NULL);
+    ir_module_sccp(module, NULL, NULL);
+
+    // 内联之前的结果作为参照
+    VMProgram* before = vm_program_create(module, stderr);
+    int expected = -1;
+    CHECK(before && vm_program_run(before, &expected, stderr), "内联之前执行失败");
+    vm_program_destroy(before);
+
+    IRInlineStats stats;
+    memset(&stats, 0, sizeof(stats));
+    ir_module_inline(module, &stats);
+    CHECK(ir_module_verify(module, stdout), "内联后校验失败");
+
+    // four()中sq(2)内联后折叠为常量
+    int value = 0;
+    CHECK(returns_const(find_function(module, "four"), &value) && value == 4, "four 应返回常量4");
+
+    // 递归(直接或经强连通分量间接)的调用不内联, 体积大又有两处调用的big也不内联
+    IRFunction* fib = find_function(module, "fib");
+    CHECK(count_op(fib, IR_CALL) == 2, "fib 的递归调用不应内联");
+    CHECK(count_op(find_function(module, "is_odd"), IR_CALL) == 1, "is_odd/is_even 之间不应内联");
+    CHECK(count_op(find_function(module, "use_big"), IR_CALL) == 2, "big 超出预算, 不应内联");
+    CHECK(stats.recursive_calls == 4, "递归调用点应为4, 实际 %d", stats.recursive_calls);
+
+    // 从外面对递归函数的调用可以内联一层: main中剩下复制进来的fib(n-1)、fib(n-2)和is_odd(n-1);
+    // clamp的多个ret在后半块经phi汇合
+    IRFunction* main_function = find_function(module, "main");
+    CHECK(count_op(main_function, IR_CALL) == 3, "main 中应只剩3个调用, 实际 %d",
+          count_op(main_function, IR_CALL));
+    CHECK(count_op(main_function, IR_PHI) >= 1, "clamp 的多个返回值应经phi汇合");
+    CHECK(stats.inlined_calls == 7, "应内联7处, 实际 %d", stats.inlined_calls);
+    CHECK(stats.call_sites == 13, "调用点应为13, 实际 %d", stats.call_sites);
+    CHECK(stats.instrs_before > 0 && stats.instrs_after > 0, "指令数统计缺失");
+
+    VMProgram* after = vm_program_create(module, stderr);
+    int status = -2;
+    CHECK(after && vm_program_run(after, &status, stderr) && status == expected, "内联后结果 %d, 应为 %d",
+          status, expected);
+    vm_program_destroy(after);
+    ir_module_destroy(module);
+}
+
+// ========== 值编号 ==========
+
+static void test_gvn(void) {
+    printf("=== 值编号 ===\n");
+
+    IRModule* module = lower_source(
+        "int num1;\n"
+        "int num2;\n"
+        "int result;\n"
+        "void touch() { num1 = num1 + 1; }\n"
+        "int f(int a, int b) {\n"
+        "    int x = a * (b + 5) / 2 - 10;\n"
+        "    int y = (b + 5) * a + a * (b + 5);\n"
+        "    if (a * (b + 5) > b + 5) y = y + 1;\n"
+        "    if (b + 5 < a * (5 + b)) y = y - 1;\n"
+        "    return x + y;\n"
+        "}\n"
+        "int k(int a, int c) {\n"
+        "    int r;\n"
+        "    if (c > 0) r = a + 1; else r = a + 1;\n"
+        "    return r;\n"
+        "}\n"
+        "int m() {\n"
+        "    int t = num1;\n"
+        "    touch();\n"
+        "    return t + num1;\n"
+        "}\n"
+        "result = num1 * (num2 + 5) / 2 - 10;\n"
+        "result = result + num1 * (num2 + 5)\n");
+    CHECK(module != NULL, "转换失败");
+    if (!module) return;
+
+    ir_module_to_ssa(module, NULL);
+    ir_module_sccp(module, NULL, NULL);
+    int before = ir_module_instr_count(module);
+    IRGVNStats stats;
+    memset(&stats, 0, sizeof(stats));
+    ir_module_gvn(module, &stats);
+    CHECK(ir_module_verify(module, stdout), "值编号后校验失败");
+    CHECK(ir_module_instr_count(module) == before - stats.removed_instrs, "删除数与指令数变化不一致");
+
+    // b + 5、a * (b + 5) 和两个(交换过的)比较各只剩一份
+    IRFunction* f = find_function(module, "f");
+    CHECK(count_op(f, IR_MUL) == 1, "f 应只剩1个乘法, 实际 %d", count_op(f, IR_MUL));
+    CHECK(count_op(f, IR_LT) + count_op(f, IR_GT) == 1, "两个比较应合并为一个");
+
+    // 两个分支互不支配, 各自的 a + 1 都保留
+    IRFunction* k = find_function(module, "k");
+    CHECK(count_op(k, IR_ADD) == 2, "不支配的计算不应合并");
+
+    // 调用之后的load读到的可能是新值
+    IRFunction* m = find_function(module, "m");
+    CHECK(count_op(m, IR_LOAD) == 2, "调用前后的load不应合并");
+
+    IRFunction* top = find_function(module, IR_TOPLEVEL_NAME);
+    CHECK(count_op(top, IR_MUL) == 1 && count_op(top, IR_LOAD) == 2, "顶层的 num1 * (num2 + 5) 应只算一次");
+
+    ir_module_destroy(module);
+}
+
+static bool has_note(const IRDCEStats* stats, IRDeadKind kind, const char* name, int line) {
+    for (int i = 0; i < stats->note_count; i++) {
+        const IRDeadNote* note = &stats->notes[i];
+        if (note->kind == kind && strcmp(note->name, name) == 0 && note->line == line) return true;
+    }
+    return false;
+}
+
+static void test_dce(void) {
+    printf("=== 死代码删除 ===\n");
+
+    IRModule* module = lower_source(
+        "int g;\n"
+        "int f(int a, int b) {\n"
+        "    int unused;\n"
+        "    int x = 1;\n"
+        "    int y = a;\n"
+        "    x = a + b;\n"
+        "    if (a > 0) y = x; else y = b;\n"
+        "    y = y * 2;\n"
+        "    g = 1;\n"
+        "    g = x;\n"
+        "    return x;\n"
+        "}\n"
+        "int h(int n) {\n"
+        "    int i = 0;\n"
+        "    int s = 0;\n"
+        "    int arr[4];\n"
+        "    while (i < n) { s = s + i; arr[0] = i; i = i + 1; }\n"
+        "    return i;\n"
+        "}\n");
+    CHECK(module != NULL, "转换失败");
+    if (!module) return;
+
+    int before = ir_module_instr_count(module);
+    IRDCEStats stats;
+    memset(&stats, 0, sizeof(stats));
+    ir_module_dse(module, true, &stats);
+    CHECK(ir_module_verify(module, stdout), "死存储删除后校验失败");
+
+    CHECK(has_note(&stats, IR_DEAD_UNUSED_VAR, "unused", 3), "应报告 unused 未使用");
+    CHECK(has_note(&stats, IR_DEAD_STORE, "x", 4), "x 的初始值被覆盖, 应报告无用赋值");
+    CHECK(has_note(&stats, IR_DEAD_STORE, "y", 5), "y 的初始值在两个分支上都被覆盖");
+    CHECK(has_note(&stats, IR_DEAD_STORE, "y", 8), "y * 2 之后不再读取 y");
+    CHECK(!has_note(&stats, IR_DEAD_STORE, "y", 7), "分支上的赋值被 y * 2 读取");
+    CHECK(has_note(&stats, IR_DEAD_UNUSED_VAR, "arr", 16), "只写不读的数组应报告未使用");
+    CHECK(!has_note(&stats, IR_DEAD_STORE, "i", 17), "循环变量被条件读取");
+    for (int i = 1; i < stats.note_count; i++) {
+        CHECK(stats.notes[i - 1].line <= stats.notes[i].line, "报告应按行号排列");
+    }
+
+    // 被覆盖的 g = 1 也被删除
+    IRFunction* f = find_function(module, "f");
+    int global_stores = 0;
+    for (int b = 0; b < f->block_count; b++) {
+        for (int i = 0; i < f->blocks[b].instr_count; i++) {
+            IRInstr* instr = &f->instrs[f->blocks[b].instrs[i]];
+            if (instr->op == IR_STORE && f->operands[instr->args].kind == IR_OPERAND_GLOBAL) {
+                global_stores++;
+            }
+        }
+    }
+    CHECK(global_stores == 1, "被覆盖的全局store应删除, 剩余 %d 条", global_stores);
+    CHECK(ir_module_instr_count(module) == before - stats.removed_stores, "删除数与指令数变化不一致");
+
+    // s 只被自己读取, 活跃分析认为它活跃; SSA中它的加法和phi只互相使用, 由标记-清除删掉
+    ir_module_to_ssa(module, NULL);
+    int ssa_count = ir_module_instr_count(module);
+    IRFunction* h = find_function(module, "h");
+    int adds_before = count_op(h, IR_ADD);
+    ir_module_dce(module, &stats);
+    CHECK(ir_module_verify(module, stdout), "死代码删除后校验失败");
+    CHECK(ir_module_instr_count(module) == ssa_count - stats.removed_instrs, "删除数与指令数变化不一致");
+    CHECK(count_op(h, IR_ADD) == 1 && adds_before >= 1, "h 中应只剩 i + 1, 实际 %d 个加法", count_op(h, IR_ADD));
+    CHECK(count_op(h, IR_STORE) == 0, "只写不读的数组不应留下store");
+
+    // 调用即使结果未使用也保留
+    IRModule* calls = lower_source(
+        "int side() { return 1; }\n"
+        "int p(int a) { int t = side(); int u = a * 3; return a; }\n");
+    CHECK(calls != NULL, "转换失败");
+    if (calls) {
+        IRDCEStats call_stats;
+        memset(&call_stats, 0, sizeof(call_stats));
+        ir_module_dse(calls, true, &call_stats);
+        ir_module_to_ssa(calls, NULL);
+        ir_module_dce(calls, &call_stats);
+        IRFunction* p = find_function(calls, "p");
+        CHECK(count_op(p, IR_CALL) == 1, "有副作用的调用不应删除");
+        CHECK(count_op(p, IR_MUL) == 0, "未使用的乘法应删除");
+        ir_dce_stats_free(&call_stats);
+        ir_module_destroy(calls);
+    }
+
+    ir_dce_stats_free(&stats);
+    ir_module_destroy(module);
+}
+
+static int emit_value(IRFunction* f, int block, IROpcode op, IRType type, const IROperand* args, int n) {
+    int id = ir_emit(f, block, op, type, true, args, n, 1);
+    return f->instrs[id].dest;
+}
+
+// 循环头有两个循环外前驱(入口的分支和then块): i = c ? 1 : 0; while (i < a) i = i + c * 3;
+static IRFunction* build_two_entry_loop(IRModule* module) {
+    int id = ir_module_add_function(module, "two_entry", IR_TYPE_I32, 2);
+    IRFunction* f = &module->functions[id];
+    f->is_defined = true;
+
+    IROperand i = ir_operand_slot(ir_new_slot(f, "i", IR_TYPE_I32, 1, -1), IR_TYPE_I32);
+    IROperand a = ir_operand_vreg(0, IR_TYPE_I32);
+    IROperand c = ir_operand_vreg(1, IR_TYPE_I32);
+    int entry = ir_new_block(f);
+    int then_block = ir_new_block(f);
+    int header = ir_new_block(f);
+    int body = ir_new_block(f);
+    int exit_block = ir_new_block(f);
+
+    IROperand init[2] = { i, ir_operand_const(0, IR_TYPE_I32) };
+    ir_emit(f, entry, IR_STORE, IR_TYPE_VOID, false, init, 2, 1);
+    IROperand test_c[2] = { c, ir_operand_const(0, IR_TYPE_I32) };
+    int cond = emit_value(f, entry, IR_NE, IR_TYPE_BOOL, test_c, 2);
+    IROperand br[3] = { ir_operand_vreg(cond, IR_TYPE_BOOL), ir_operand_block(then_block),
+                        ir_operand_block(header) };
+    ir_emit(f, entry, IR_BR, IR_TYPE_VOID, false, br, 3, 1);
+
+    IROperand one[2] = { i, ir_operand_const(1, IR_TYPE_I32) };
+    ir_emit(f, then_block, IR_STORE, IR_TYPE_VOID, false, one, 2, 1);
+    IROperand to_header[1] = { ir_operand_block(header) };
+    ir_emit(f, then_block, IR_JMP, IR_TYPE_VOID, false, to_header, 1, 1);
+
+    int iv = emit_value(f, header, IR_LOAD, IR_TYPE_I32, &i, 1);
+    IROperand lt[2] = { ir_operand_vreg(iv, IR_TYPE_I32), a };
+    int more = emit_value(f, header, IR_LT, IR_TYPE_BOOL, lt, 2);
+    IROperand loop_br[3] = { ir_operand_vreg(more, IR_TYPE_BOOL), ir_operand_block(body),
+                             ir_operand_block(exit_block) };
+    ir_emit(f, header, IR_BR, IR_TYPE_VOID, false, loop_br, 3, 1);
+
+    int iv2 = emit_value(f, body, IR_LOAD, IR_TYPE_I32, &i, 1);
+    IROperand mul[2] = { c, ir_operand_const(3, IR_TYPE_I32) };
+    int step = emit_value(f, body, IR_MUL, IR_TYPE_I32, mul, 2);
+    IROperand add[2] = { ir_operand_vreg(iv2, IR_TYPE_I32), ir_operand_vreg(step, IR_TYPE_I32) };
+    int next = emit_value(f, body, IR_ADD, IR_TYPE_I32, add, 2);
+    IROperand store[2] = { i, ir_operand_vreg(next, IR_TYPE_I32) };
+    ir_emit(f, body, IR_STORE, IR_TYPE_VOID, false, store, 2, 1);
+    ir_emit(f, body, IR_JMP, IR_TYPE_VOID, false, to_header, 1, 1);
+
+    int result = emit_value(f, exit_block, IR_LOAD, IR_TYPE_I32, &i, 1);
+    IROperand ret[1] = { ir_operand_vreg(result, IR_TYPE_I32) };
+    ir_emit(f, exit_block, IR_RET, IR_TYPE_VOID, false, ret, 1, 1);
+
+    ir_function_compute_cfg(f);
+    return f;
+}
+
+// 指令所在基本块是否在某个循环里
+static int count_in_loops(IRFunction* function, IROpcode op) {
+    IRDomTree* dom = ir_dom_tree_create(function);
+    IRLoopInfo* loops = ir_loop_info_create(function, dom);
+    int count = 0;
+    for (int b = 0; b < function->block_count; b++) {
+        if (loops->block_loop[b] < 0) continue;
+        for (int i = 0; i < function->blocks[b].instr_count; i++) {
+            if (function->instrs[function->blocks[b].instrs[i]].op == op) count++;
+        }
+    }
+    ir_loop_info_destroy(loops);
+    ir_dom_tree_destroy(dom);
+    return count;
+}
+
+static void test_licm(void) {
+    printf("=== 循环不变量外提 ===\n");
+
+    IRModule* module = lower_source(
+        "int g;\n"
+        "int n;\n"
+        "void touch() { g = g + 1; }\n"
+        "int nested(int a, int b) {\n"
+        "    int i = 0;\n"
+        "    int s = 0;\n"
+        "    while (i < n) {\n"
+        "        int j = 0;\n"
+        "        while (j < b) { s = s + a * b + g + j / 4 + i / j; j = j + 1; }\n"
+        "        i = i + 1;\n"
+        "    }\n"
+        "    return s;\n"
+        "}\n"
+        "int calls(int a) {\n"
+        "    int i = 0;\n"
+        "    int s = 0;\n"
+        "    while (i < a) { touch(); s = s + g; i = i + 1; }\n"
+        "    return s;\n"
+        "}\n");
+    CHECK(module != NULL, "转换失败");
+    if (!module) return;
+
+    build_two_entry_loop(module);
+    ir_module_to_ssa(module, NULL);
+    ir_module_sccp(module, NULL, NULL);
+    ir_module_gvn(module, NULL);
+
+    IRFunction* nested = find_function(module, "nested");
+    IRDomTree* dom = ir_dom_tree_create(nested);
+    IRLoopInfo* loops = ir_loop_info_create(nested, dom);
+    CHECK(loops->loop_count == 2, "应找到2个循环, 实际 %d", loops->loop_count);
+    if (loops->loop_count == 2) {
+        CHECK(loops->loops[1].parent == 0 && loops->loops[1].depth == 2, "内层循环应嵌套在外层中");
+        CHECK(loops->loops[0].block_count > loops->loops[1].block_count, "外层循环体应包含内层");
+        CHECK(ir_loop_contains(loops, 0, loops->loops[1].header), "外层循环应包含内层循环头");
+    }
+    ir_loop_info_destroy(loops);
+    ir_dom_tree_destroy(dom);
+
+    IRLICMStats stats;
+    memset(&stats, 0, sizeof(stats));
+    ir_module_licm(module, &stats);
+    CHECK(ir_module_verify(module, stdout), "外提后校验失败");
+    CHECK(stats.loops == 4, "应共找到4个循环, 实际 %d", stats.loops);
+
+    // a * b、load @g、load @n 和 j / 4 中, 只有不会出错的前三个移出两层循环
+    CHECK(count_in_loops(nested, IR_MUL) == 0, "a * b 应外提");
+    CHECK(count_in_loops(nested, IR_LOAD) == 0, "循环里不写 g 和 n, load 应外提");
+    CHECK(count_in_loops(nested, IR_DIV) == 2, "依赖循环变量或可能除0的除法不应外提");
+    CHECK(stats.hoisted_instrs >= 3, "外提数 %d 太少", stats.hoisted_instrs);
+
+    // 调用可能修改 g
+    IRFunction* calls = find_function(module, "calls");
+    CHECK(count_in_loops(calls, IR_LOAD) == 1, "有调用的循环不应外提 load");
+
+    // 循环头有两个循环外前驱, 需要新建前置块
+    IRFunction* two_entry = find_function(module, "two_entry");
+    CHECK(stats.preheaders == 1, "应新建1个前置块, 实际 %d", stats.preheaders);
+    CHECK(count_in_loops(two_entry, IR_MUL) == 0, "c * 3 应外提到新建的前置块");
+    CHECK(count_op(two_entry, IR_PHI) == 2, "前置块应合并两个入口的初值");
+
+    ir_module_destroy(module);
+}
+
+static void test_strength(void) {
+    printf("=== 强度削弱 ===\n");
+
+    IRModule* module = lower_source(
+        "int data[64];\n"
+        "int f(int n) {\n"
+        "    int i = 0;\n"
+        "    int s = 0;\n"
+        "    while (i < n) { s = s + i * 12 + data[i % 64] + i / 8; i = i + 1; }\n"
+        "    return s;\n"
+        "}\n"
+        "int down(int n, int k) {\n"
+        "    int i = n;\n"
+        "    int s = 0;\n"
+        "    while (i > 0) { s = s + k * i; i = i - 3; }\n"
+        "    return s;\n"
+        "}\n"
+        "int shifts(int x) { return x * 16 + x / 4 + x % 8 + x * 6; }\n");
+    CHECK(module != NULL, "转换失败");
+    if (!module) return;
+
+    ir_module_to_ssa(module, NULL);
+    ir_module_sccp(module, NULL, NULL);
+    ir_module_gvn(module, NULL);
+    ir_module_licm(module, NULL);
+
+    IRStrengthStats stats;
+    memset(&stats, 0, sizeof(stats));
+    ir_module_strength_reduce(module, &stats);
+    ir_module_dce(module, NULL);
+    CHECK(ir_module_verify(module, stdout), "强度削弱后校验失败");
+    CHECK(stats.induction_vars == 2, "应识别2个归纳变量, 实际 %d", stats.induction_vars);
+    CHECK(stats.reduced_muls == 2, "应削弱2个乘法, 实际 %d", stats.reduced_muls);
+
+    // i * 12 变为每次加12的新归纳变量; i 从0递增, 取模和除法直接用按位与和移位
+    IRFunction* f = find_function(module, "f");
+    CHECK(count_op(f, IR_MUL) == 0, "f 的循环里不应再有乘法");
+    CHECK(count_op(f, IR_MOD) == 0 && count_op(f, IR_DIV) == 0, "非负归纳变量的取模和除法应改为位运算");
+    CHECK(count_in_loops(f, IR_AND) == 1 && count_in_loops(f, IR_SHR) == 1, "应是一个and和一个shr");
+    CHECK(count_op(f, IR_PHI) == 3, "应新增一个phi, 实际共 %d 个", count_op(f, IR_PHI));
+
+    // 变量 k 作系数、步长为 -3 时, 初值 n * k 在前置块计算, 步长 -3 * k 也在前置块
+    IRFunction* down = find_function(module, "down");
+    CHECK(count_in_loops(down, IR_MUL) == 0, "k * i 应移出循环");
+    CHECK(count_op(down, IR_MUL) == 2, "前置块应计算 n * k 和 -3 * k, 实际 %d 个乘法", count_op(down, IR_MUL));
+
+    // 符号未知时除法和取模需要补偏移, 乘6不是2的幂
+    IRFunction* sh = find_function(module, "shifts");
+    CHECK(count_op(sh, IR_SHL) == 1 && count_op(sh, IR_MUL) == 1, "只有乘16应改为移位");
+    CHECK(count_op(sh, IR_DIV) == 0 && count_op(sh, IR_MOD) == 0, "除4和模8应改为移位");
+    CHECK(count_op(sh, IR_SHR) == 3, "除法1个右移加两次取符号, 实际 %d", count_op(sh, IR_SHR));
+
+    ir_module_destroy(module);
+
+    // 先改写为位运算(此时 gx 的值还未知), 再由常量传播折叠
+    IRModule* folded = lower_source("int gx;\nint g() { gx = -20; return gx / 4 + gx % 8 + gx * 8; }\n");
+    CHECK(folded != NULL, "转换失败");
+    if (folded) {
+        ir_module_to_ssa(folded, NULL);
+        IRFunction* g = find_function(folded, "g");
+        IRStrengthStats fold_stats;
+        memset(&fold_stats, 0, sizeof(fold_stats));
+        ir_function_strength_reduce(g, &fold_stats);
+        CHECK(fold_stats.shifts == 3, "应改写3处, 实际 %d", fold_stats.shifts);
+        ir_function_sccp(folded, g, NULL, NULL);
+        int value = 0;
+        CHECK(returns_const(g, &value) && value == -20 / 4 + -20 % 8 + -20 * 8,
+              "移位改写后的结果应为 %d, 实际 %d", -20 / 4 + -20 % 8 + -20 * 8, value);
+        ir_module_destroy(folded);
+    }
+
+    // 内层的 i * j 削弱后, 前置块里的 0 * j 和 1 * j 位于外层循环中, 不应再被外层削弱
+    IRModule* nested = lower_source(
+        "int nest(int n) {\n"
+        "    int s = 0; int j = 0;\n"
+        "    while (j < n) { int i = 0; while (i < 4) { s = s + i * j; i++; } j++; }\n"
+        "    return s;\n"
+        "}\n");
+    CHECK(nested != NULL, "转换失败");
+    if (nested) {
+        ir_module_to_ssa(nested, NULL);
+        ir_module_licm(nested, NULL);
+        IRStrengthStats nest_stats;
+        memset(&nest_stats, 0, sizeof(nest_stats));
+        ir_module_strength_reduce(nested, &nest_stats);
+        CHECK(ir_module_verify(nested, stdout), "嵌套循环强度削弱后校验失败");
+        CHECK(nest_stats.reduced_muls == 1, "只应削弱内层的乘法, 实际 %d", nest_stats.reduced_muls);
+        ir_module_destroy(nested);
+    }
+}
+
+// ========== 寄存器分配 ==========
+
+typedef struct RegRange {
+    int reg;
+    int start;
+    int end;        // 最后一个在寄存器中的位置
+} RegRange;
+
+static int compare_ranges(const void* a, const void* b) {
+    const RegRange* x = (const RegRange*)a;
+    const RegRange* y = (const RegRange*)b;
+    if (x->reg != y->reg) return x->reg - y->reg;
+    return x->start - y->start;
+}
+
+// 一条边上的并行复制不能两次写同一个位置
+static bool distinct_destinations(const IRMoveList* list) {
+    for (int i = 0; i < list->count; i++) {
+        for (int j = i + 1; j < list->count; j++) {
+            if (list->moves[i].dst.kind == list->moves[j].dst.kind &&
+                list->moves[i].dst.value == list->moves[j].dst.value) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// 同一寄存器上的区间互不重叠, 跨调用的区间不用调用者保存的寄存器,
+// 每个被使用的虚拟寄存器都有位置, 边上的复制目标互不相同
+static bool check_allocation(const IRFunction* f, const IRRegAlloc* alloc) {
+    RegRange* ranges = (RegRange*)malloc(sizeof(RegRange) * (size_t)(alloc->vreg_count + 1));
+    int count = 0;
+    for (int v = 0; v < alloc->vreg_count; v++) {
+        const IRInterval* interval = &alloc->intervals[v];
+        if (interval->start < 0 || interval->reg < 0) continue;
+        int end = interval->split == INT32_MAX ? interval->end : interval->split - 1;
+        ranges[count].reg = interval->reg;
+        ranges[count].start = interval->start;
+        ranges[count].end = end;
+        count++;
+    }
+    qsort(ranges, (size_t)count, sizeof(RegRange), compare_ranges);
+    bool ok = true;
+    for (int i = 1; i < count; i++) {
+        if (ranges[i].reg == ranges[i - 1].reg && ranges[i].start <= ranges[i - 1].end) {
+            printf("  %%%s 上的区间 [%d, %d] 与 [%d, %d] 重叠\n", x86_reg_names64[ranges[i].reg],
+                   ranges[i - 1].start, ranges[i - 1].end, ranges[i].start, ranges[i].end);
+            ok = false;
+            break;
+        }
+    }
+    free(ranges);
+
+    for (int b = 0; b < f->block_count && ok; b++) {
+        const IRBlock* block = &f->blocks[b];
+        if (!distinct_destinations(&alloc->moves_in[b]) || !distinct_destinations(&alloc->moves_out[b])) {
+            printf("  bb%d 边上的复制重复写同一位置\n", b);
+            ok = false;
+        }
+        for (int i = 0; i < block->instr_count && ok; i++) {
+            int id = block->instrs[i];
+            const IRInstr* instr = &f->instrs[id];
+            if (alloc->instr_pos[id] < 0) continue;
+            if (instr->op == IR_CALL) {
+                int pos = alloc->instr_pos[id];
+                for (int v = 0; v < alloc->vreg_count; v++) {
+                    const IRInterval* interval = &alloc->intervals[v];
+                    if (interval->reg < 0 || interval->start >= pos || interval->end <= pos) continue;
+                    if (interval->split <= pos) continue;
+                    if (!(x86_64_target.callee_saved >> interval->reg & 1)) {
+                        printf("  %%%d 跨过调用却在 %%%s 中\n", v, x86_reg_names64[interval->reg]);
+                        ok = false;
+                    }
+                }
+            }
+            if (instr->op == IR_PHI) continue;
+            const IROperand* args = &f->operands[instr->args];
+            for (int a = 0; a < instr->arg_count; a++) {
+                if (args[a].kind != IR_OPERAND_VREG) continue;
+                IRLoc loc = ir_regalloc_use(alloc, args[a], id);
+                if (loc.kind != IR_LOC_REG && loc.kind != IR_LOC_STACK) {
+                    printf("  %%%d 在指令 %d 处没有位置\n", args[a].value, id);
+                    ok = false;
+                }
+            }
+        }
+    }
+    return ok;
+}
+
+static void test_regalloc(void) {
+    printf("=== 寄存器分配 ===\n");
+
+    IRModule* module = lower_source(
+        "int g(int x) { return x + 1; }\n"
+        "int small(int a, int b) { return a * b + a - b; }\n"
+        "int pressure(int a, int n) {\n"
+        "    int v0 = a * 3; int v1 = a * 5; int v2 = a * 7; int v3 = a * 9;\n"
+        "    int v4 = a * 11; int v5 = a * 13; int v6 = a * 15; int v7 = a * 17;\n"
+        "    int v8 = a * 19; int v9 = a * 21; int v10 = a * 23; int v11 = a * 25;\n"
+        "    int s = 0;\n"
+        "    int i = 0;\n"
+        "    while (i < n) {\n"
+        "        s = s + v0 + v1 + v2 + v3 + g(i) + v4 + v5;\n"
+        "        i = i + 1;\n"
+        "    }\n"
+        "    return s + v6 + v7 + v8 + v9 + v10 + v11;\n"
+        "}\n"
+        "int swap(int n) {\n"
+        "    int a = 1;\n"
+        "    int b = 2;\n"
+        "    while (n > 0) { int t = a; a = b; b = t; n = n - 1; }\n"
+        "    return a - b;\n"
+        "}\n");
+    CHECK(module != NULL, "转换失败");
+    if (!module) return;
+
+    ir_module_to_ssa(module, NULL);
+    ir_module_sccp(module, NULL, NULL);
+    ir_module_gvn(module, NULL);
+    ir_module_licm(module, NULL);
+    ir_module_strength_reduce(module, NULL);
+    ir_module_dce(module, NULL);
+
+    // 寄存器够用时不溢出, 不跨调用的值优先用调用者保存的寄存器
+    IRFunction* small = find_function(module, "small");
+    IRRegAlloc* alloc = ir_regalloc_create(small, &x86_64_target);
+    CHECK(check_allocation(small, alloc), "small 的分配不正确");
+    CHECK(alloc->stats.spilled == 0 && alloc->stats.split == 0 && alloc->slot_count == 0,
+          "small 不应溢出");
+    CHECK((alloc->used_regs & x86_64_target.callee_saved) == 0, "small 不应用到被调用者保存的寄存器");
+    ir_regalloc_destroy(alloc);
+
+    // 12个值跨过循环里的调用, 只有5个被调用者保存的寄存器可用
+    IRFunction* pressure = find_function(module, "pressure");
+    alloc = ir_regalloc_create(pressure, &x86_64_target);
+    CHECK(ir_function_verify(module, pressure, stdout), "拆分关键边后校验失败");
+    CHECK(check_allocation(pressure, alloc), "pressure 的分配不正确");
+    CHECK(alloc->stats.spilled + alloc->stats.split >= 7, "至少7个值要溢出或拆分, 实际 %d",
+          alloc->stats.spilled + alloc->stats.split);
+    CHECK(alloc->slot_count == alloc->stats.spilled + alloc->stats.split, "每个溢出的值一个溢出槽");
+    int in_stack = 0;
+    for (int v = 0; v < alloc->vreg_count; v++) {
+        if (ir_regalloc_spill_at_def(alloc, v) || ir_regalloc_def(alloc, v).kind == IR_LOC_STACK) {
+            in_stack++;
+        }
+    }
+    CHECK(in_stack == alloc->slot_count, "被拆分的值应在定义处写入溢出槽");
+    ir_regalloc_destroy(alloc);
+
+    // a、b在回边上交换: 并行复制成环, 需要经临时寄存器
+    IRFunction* swap = find_function(module, "swap");
+    alloc = ir_regalloc_create(swap, &x86_64_target);
+    CHECK(check_allocation(swap, alloc), "swap 的分配不正确");
+    bool uses_scratch = false;
+    for (int b = 0; b < swap->block_count; b++) {
+        const IRMoveList* list = &alloc->moves_out[b];
+        for (int i = 0; i < list->count; i++) {
+            if (list->moves[i].dst.kind == IR_LOC_REG && list->moves[i].dst.value == X86_R10) {
+                uses_scratch = true;
+            }
+        }
+    }
+    CHECK(uses_scratch, "交换应经过 %%r10");
+    ir_regalloc_destroy(alloc);
+    ir_module_destroy(module);
+}
+
+// ========== 代码生成 ==========
+
+static int count_x86_op(const X86Function* function, X86Opcode op) {
+    int count = 0;
+    for (int i = 0; i < function->instr_count; i++) {
+        if (function->instrs[i].op == op) count++;
+    }
+    return count;
+}
+
+static const X86Function* find_x86_function(const X86Module* module, const char* name) {
+    for (int i = 0; i < module->function_count; i++) {
+        if (strcmp(module->functions[i].name, name) == 0) return &module->functions[i];
+    }
+    return NULL;
+}
+
+static void test_codegen(void) {
+    printf("=== 代码生成 ===\n");
+
+    IRModule* module = lower_source(
+        "int table[4];\n"
+        "int seed;\n"
+        "int ext(int x);\n"
+        "int seven() { return 7; }\n"
+        "int many(int a, int b, int c, int d, int e, int f, int g) { return a - g; }\n"
+        "int branch(int a, int b) { if (a < b) return a; return b; }\n"
+        "int caller(int x) { table[x] = x; return many(x, 2, 3, 4, 5, 6, 7) + ext(x) / x; }\n"
+        "seed = 4;\n");
+    CHECK(module != NULL, "转换失败");
+    if (!module) return;
+    ir_module_to_ssa(module, NULL);
+    ir_module_sccp(module, NULL, NULL);
+    ir_module_gvn(module, NULL);
+    ir_module_dce(module, NULL);
+
+    X86Module* x86 = x86_module_create(module);
+    for (int i = 0; i < module->function_count; i++) {
+        if (!module->functions[i].is_defined) continue;
+        IRRegAlloc* alloc = ir_regalloc_create(&module->functions[i], &x86_64_target);
+        x86_module_add_function(x86, i, alloc);
+        ir_regalloc_destroy(alloc);
+    }
+
+    // 保存的寄存器和栈帧合起来按16字节对齐, 调用处rsp对齐
+    for (int i = 0; i < x86->function_count; i++) {
+        const X86Function* function = &x86->functions[i];
+        int saved = 0;
+        for (int reg = 0; reg < X86_REG_COUNT; reg++) saved += function->saved_regs >> reg & 1;
+        CHECK((8 * saved + function->frame_size) % 16 == 0, "%s 的栈帧没有对齐", function->name);
+    }
+
+    // 只被br使用的比较合并为cmp + jcc
+    const X86Function* branch = find_x86_function(x86, "branch");
+    CHECK(branch && count_x86_op(branch, X86_SETCC) == 0 && count_x86_op(branch, X86_JCC) == 1,
+          "branch 的比较应与跳转合并");
+
+    OutBuf out;
+    outbuf_init(&out, NULL);
+    x86_asm_emit_module(&out, x86);
+    outbuf_putc(&out, '\0');
+    const char* text = out.data;
+    CHECK(strstr(text, "\tsubq\t$8,%rsp\n\tpushq\t$7\n") != NULL, "第7个参数应压栈并补齐16字节");
+    CHECK(strstr(text, "\taddq\t$16,%rsp\n") != NULL, "调用后应弹出栈上的参数");
+    CHECK(strstr(text, "\tmovl\t16(%rbp),") != NULL, "第7个参数应从调用者的栈帧读取");
+    CHECK(strstr(text, "\txorl\t%eax,%eax\n\tcall\text@PLT\n") != NULL, "外部函数应经PLT调用");
+    CHECK(strstr(text, "\tcltd\n\tidivl\t") != NULL, "除法应使用cltd + idivl");
+    CHECK(strstr(text, "\tleaq\ttable(%rip),%rax\n") != NULL, "变量下标的全局数组应按rip相对取地址");
+    CHECK(strstr(text, "\t.globl\t__toplevel") == NULL && strstr(text, ".init_array") != NULL,
+          "__toplevel 应是本地函数并登记到.init_array");
+    CHECK(strstr(text, "seed:\n\t.zero\t4\n") != NULL, "未初始化的全局变量应放在.bss");
+    outbuf_free(&out);
+
+    // 直接编码的机器码与as的编码相同; 调用和全局变量留作重定位
+    X86Code* code = x86_code_create(x86);
+    const X86Function* seven = find_x86_function(x86, "seven");
+    int seven_index = (int)(seven - x86->functions);
+    // push %rbp; mov %rsp,%rbp; mov $7,%eax; pop %rbp; ret
+    static const uint8_t seven_bytes[] = { 0x55, 0x48, 0x89, 0xe5, 0xb8, 0x07, 0x00, 0x00, 0x00, 0x5d, 0xc3 };
+    CHECK(seven && code->function_sizes[seven_index] == sizeof(seven_bytes) &&
+          memcmp(code->text.data + code->function_offsets[seven_index], seven_bytes, sizeof(seven_bytes)) == 0,
+          "seven 的机器码错误");
+    int calls_to_ext = 0;
+    int global_refs = 0;
+    for (int i = 0; i < code->reloc_count; i++) {
+        const X86Reloc* reloc = &code->relocs[i];
+        CHECK(reloc->offset + 4 <= code->text.length, "重定位超出代码范围");
+        if (reloc->kind == X86_RELOC_PLT32 && strcmp(module->functions[reloc->symbol].name, "ext") == 0) {
+            calls_to_ext++;
+            CHECK(reloc->addend == -4, "call的重定位addend应为-4");
+        }
+        if (reloc->kind == X86_RELOC_PC32) global_refs++;
+    }
+    CHECK(calls_to_ext == 1 && global_refs >= 2, "重定位数目错误: ext %d, 全局变量 %d", calls_to_ext, global_refs);
+
+    outbuf_init(&out, NULL);
+    elf_object_write(&out, x86, code);
+    const Elf64_Ehdr* ehdr = (const Elf64_Ehdr*)out.data;
+    CHECK(out.length > sizeof(Elf64_Ehdr) && memcmp(ehdr->e_ident, ELFMAG, SELFMAG) == 0 &&
+          ehdr->e_type == ET_REL && ehdr->e_machine == EM_X86_64 &&
+          ehdr->e_shoff + (uint64_t)ehdr->e_shnum * sizeof(Elf64_Shdr) == out.length,
+          "ELF目标文件的文件头错误");
+    outbuf_free(&out);
+    x86_code_destroy(code);
+
+    // 缓冲区的整数输出
+    outbuf_init(&out, NULL);
+    outbuf_int(&out, INT64_MIN);
+    outbuf_putc(&out, ' ');
+    outbuf_int(&out, -5);
+    outbuf_putc(&out, ' ');
+    outbuf_int(&out, 0);
+    outbuf_putc(&out, '\0');
+    CHECK(strcmp(out.data, "-9223372036854775808 -5 0") == 0, "整数输出错误: %s", out.data);
+    outbuf_free(&out);
+
+    x86_module_destroy(x86);
+    ir_module_destroy(module);
+}
+
+// ========== JIT ==========
+
+static void test_jit(void) {
+    printf("=== JIT ===\n");
+
+    IRModule* module = lower_source(
+        "int abs(int x);\n"
+        "int counter = 3;\n"
+        "int table[8];\n"
+        "int add(int a, int b) { return a + b; }\n"
+        "int sum_to(int n) { int s = 0; int i = 1; while (i <= n) { s += i; i++; } return s; }\n"
+        "int bump(int k) { counter = counter + k; table[k] = counter; return table[k]; }\n"
+        "int distance(int a, int b) { return abs(a - b); }\n"
+        "int main() { return add(40, 2); }\n"
+        "counter = counter * 2;\n");
+    CHECK(module != NULL, "转换失败");
+    if (!module) return;
+    ir_module_to_ssa(module, NULL);
+    ir_module_sccp(module, NULL, NULL);
+    ir_module_gvn(module, NULL);
+    ir_module_dce(module, NULL);
+
+    X86Module* x86 = x86_module_create(module);
+    for (int i = 0; i < module->function_count; i++) {
+        if (!module->functions[i].is_defined) continue;
+        IRRegAlloc* alloc = ir_regalloc_create(&module->functions[i], &x86_64_target);
+        x86_module_add_function(x86, i, alloc);
+        ir_regalloc_destroy(alloc);
+    }
+    X86Code* code = x86_code_create(x86);
+    JitProgram* program = jit_program_create(x86, code, stderr);
+    CHECK(program != NULL, "装入失败");
+    if (program) {
+        int (*add)(int, int) = (int (*)(int, int))jit_program_lookup(program, "add");
+        int (*sum_to)(int) = (int (*)(int))jit_program_lookup(program, "sum_to");
+        int (*bump)(int) = (int (*)(int))jit_program_lookup(program, "bump");
+        int (*distance)(int, int) = (int (*)(int, int))jit_program_lookup(program, "distance");
+        CHECK(add && add(2, 3) == 5 && add(-7, 7) == 0, "add 结果错误");
+        CHECK(sum_to && sum_to(100) == 5050, "sum_to 结果错误");
+        CHECK(distance && distance(3, 10) == 7, "经跳板调用C库的abs结果错误");
+
+        // 顶层语句在main之前执行, 全局变量在装入的内存中
+        int status = -1;
+        CHECK(jit_program_run(program, &status, stderr) && status == 42, "main 的返回值错误: %d", status);
+        CHECK(bump && bump(4) == 10 && bump(1) == 11, "全局变量读写错误");
+        CHECK(jit_program_lookup(program, "missing") == NULL, "不存在的函数应返回NULL");
+        jit_program_destroy(program);
+    }
+    x86_code_destroy(code);
+    x86_module_destroy(x86);
+    ir_module_destroy(module);
+}
+
+// ========== 循环展开与向量化 ==========
+
+static const char* const unroll_source =
+    "int a[64];\n"
+    "int b[64];\n"
+    "int c[64];\n"
+    "int fill(int n) { int i = 0; while (i < n) { b[i] = i * 3 - 20; c[i] = 7 - i; i++; } return 0; }\n"
+    "int vadd(int n, int k) { int i = 0; while (i < n) { a[i] = b[i] + c[i] - k; i++; } return a[n / 2]; }\n"
+    "int dot(int n) { int s = 0; int i = 0; while (i < n) { s = s + b[i] * c[i]; i++; } return s; }\n"
+    "int down(int n) { int s = 0; int i = n; while (i > 0) { s = s + b[i] / 4; i = i - 3; } return s; }\n";
+
+static IRModule* optimize_source(const char* source, IRUnrollStats* stats) {
+    IRModule* module = lower_source(source);
+    if (!module) return NULL;
+    ir_module_to_ssa(module, NULL);
+    ir_module_sccp(module, NULL, NULL);
+    ir_module_gvn(module, NULL);
+    ir_module_licm(module, NULL);
+    ir_module_strength_reduce(module, NULL);
+    ir_module_dce(module, NULL);
+    if (stats) ir_module_unroll(module, stats);
+    return module;
+}
+
+static int64_t vm_call2(VMProgram* program, const char* name, int64_t x, int64_t y) {
+    int64_t args[2] = { x, y };
+    int64_t result = -1;
+    if (!vm_program_call(program, vm_program_lookup(program, name), args, &result, stderr)) return -1;
+    return result;
+}
+
+static void test_unroll(void) {
+    printf("=== 循环展开与向量化 ===\n");
+
+    IRUnrollStats stats;
+    memset(&stats, 0, sizeof(stats));
+    IRModule* module = optimize_source(unroll_source, &stats);
+    IRModule* reference = optimize_source(unroll_source, NULL);
+    CHECK(module != NULL && reference != NULL, "转换失败");
+    if (!module || !reference) return;
+    CHECK(ir_module_verify(module, stdout), "循环展开后校验失败");
+    CHECK(stats.counted_loops == 4, "应识别4个计数循环, 实际 %d", stats.counted_loops);
+    CHECK(stats.vectorized_loops == 1 && stats.unrolled_loops == 3, "应向量化1个、展开3个, 实际 %d / %d",
+          stats.vectorized_loops, stats.unrolled_loops);
+
+    // a[i] = b[i] + c[i] - k: 两个vload、广播k、一个vstore; 余数循环仍是原来的标量循环
+    IRFunction* vadd = find_function(module, "vadd");
+    CHECK(count_op(vadd, IR_VLOAD) == 2 && count_op(vadd, IR_VSTORE) == 1, "vadd 应使用向量读写");
+    CHECK(count_op(vadd, IR_SPLAT) == 1, "k 应广播一次");
+    CHECK(count_op(vadd, IR_STORE) == 1, "余数循环应保留一个标量store");
+
+    // 归约(s的phi)不向量化, 循环体复制4份; i给b[i]赋值时也只展开
+    CHECK(count_op(find_function(module, "dot"), IR_MUL) == 1 + IR_UNROLL_FACTOR, "dot 的循环体应复制4份");
+    CHECK(count_op(find_function(module, "fill"), IR_VSTORE) == 0, "fill 用到了i的值, 不应向量化");
+
+    // 各种长度(包括不是4的倍数和小于4)的结果与不展开时相同
+    VMProgram* expected = vm_program_create(reference, stderr);
+    VMProgram* actual = vm_program_create(module, stderr);
+    CHECK(expected && actual, "编译字节码失败");
+    if (expected && actual) {
+        vm_call2(expected, "fill", 64, 0);
+        vm_call2(actual, "fill", 64, 0);
+        static const int lengths[] = { 0, 1, 2, 3, 4, 5, 7, 8, 13, 62, 63 };
+        for (size_t t = 0; t < sizeof(lengths) / sizeof(lengths[0]); t++) {
+            int n = lengths[t];
+            CHECK(vm_call2(expected, "vadd", n, 9) == vm_call2(actual, "vadd", n, 9), "vadd(%d) 结果不同", n);
+            CHECK(vm_call2(expected, "dot", n, 0) == vm_call2(actual, "dot", n, 0), "dot(%d) 结果不同", n);
+            CHECK(vm_call2(expected, "down", n, 0) == vm_call2(actual, "down", n, 0), "down(%d) 结果不同", n);
+        }
+    }
+
+    // 本机代码用SSE2, 结果与字节码相同
+    X86Module* x86 = x86_module_create(module);
+    for (int i = 0; i < module->function_count; i++) {
+        if (!module->functions[i].is_defined) continue;
+        IRRegAlloc* alloc = ir_regalloc_create(&module->functions[i], &x86_64_target);
+        x86_module_add_function(x86, i, alloc);
+        ir_regalloc_destroy(alloc);
+    }
+    const X86Function* native_vadd = find_x86_function(x86, "vadd");
+    CHECK(native_vadd && count_x86_op(native_vadd, X86_PADDD) == 1 && count_x86_op(native_vadd, X86_PSUBD) == 1,
+          "vadd 应生成paddd和psubd");
+    X86Code* code = x86_code_create(x86);
+    JitProgram* program = jit_program_create(x86, code, stderr);
+    CHECK(program != NULL, "装入失败");
+    if (program && expected) {
+        int (*fill)(int) = (int (*)(int))jit_program_lookup(program, "fill");
+        int (*vadd_native)(int, int) = (int (*)(int, int))jit_program_lookup(program, "vadd");
+        int (*dot)(int) = (int (*)(int))jit_program_lookup(program, "dot");
+        fill(64);
+        for (int n = 1; n <= 64; n += 3) {
+            CHECK(vadd_native(n, -4) == vm_call2(expected, "vadd", n, -4), "本机 vadd(%d) 结果错误", n);
+            CHECK(dot(n) == vm_call2(expected, "dot", n, 0), "本机 dot(%d) 结果错误", n);
+        }
+    }
+    if (program) jit_program_destroy(program);
+    x86_code_destroy(code);
+    x86_module_destroy(x86);
+    if (actual) vm_program_destroy(actual);
+    if (expected) vm_program_destroy(expected);
+    ir_module_destroy(reference);
+    ir_module_destroy(module);
+}
+
+// ========== 尾调用 ==========
+
+static const char* const tailcall_source =
+    "int sum(int n, int acc) { if (n == 0) return acc; return sum(n - 1, acc + n); }\n"
+    "int is_even(int n);\n"
+    "int is_odd(int n) { if (n == 0) return 0; return is_even(n - 1); }\n"
+    "int is_even(int n) { if (n == 0) return 1; return is_odd(n - 1); }\n"
+    "int spread(int a, int b, int c, int d, int e, int f, int g) { if (a <= 0) return b + g; return spread(a - 1, b, c, d, e, f, g + 2); }\n"
+    "int wide(int n) { return spread(n, 1, 2, 3, 4, 5, 6); }\n"
+    "int fact(int n) { if (n < 2) return 1; return n * fact(n - 1); }\n";
+
+static void test_tailcall(void) {
+    printf("=== 尾调用 ===\n");
+
+    IRModule* module = lower_source(tailcall_source);
+    CHECK(module != NULL, "转换失败");
+    if (!module) return;
+    ir_module_to_ssa(module, NULL);
+    IRTailCallStats stats;
+    memset(&stats, 0, sizeof(stats));
+    ir_module_eliminate_tail_recursion(module, &stats);
+    CHECK(ir_module_verify(module, stdout), "尾递归消除后校验失败");
+    ir_module_sccp(module, NULL, NULL);
+    ir_module_dce(module, NULL);
+
+    // sum和spread的自递归改为循环; 互相递归和不在尾部的递归(fact)不变
+    CHECK(stats.functions == 2 && stats.tail_calls == 2, "应消除2个函数的尾递归, 实际 %d / %d",
+          stats.functions, stats.tail_calls);
+    CHECK(count_op(find_function(module, "sum"), IR_CALL) == 0, "sum 中不应再有调用");
+    CHECK(count_op(find_function(module, "sum"), IR_PHI) >= 2, "sum 的参数应经phi汇合");
+    CHECK(count_op(find_function(module, "is_odd"), IR_CALL) == 1, "is_odd 对is_even的调用应保留");
+    CHECK(count_op(find_function(module, "fact"), IR_CALL) == 1, "fact 的调用不在尾部, 应保留");
+
+    // 字节码: 对其他函数的尾调用复用当前帧, 递归深度超过帧栈也不溢出
+    VMProgram* vm = vm_program_create(module, stderr);
+    CHECK(vm != NULL, "编译字节码失败");
+    if (vm) {
+        CHECK(vm->stats.tail_calls == 3, "应生成3条尾调用, 实际 %d", vm->stats.tail_calls);
+        CHECK(vm_call2(vm, "sum", 1000000, 0) == (int32_t)500000500000LL, "sum(1000000) 结果错误");
+        CHECK(vm_call2(vm, "is_even", 1000001, 0) == 0, "is_even(1000001) 结果错误");
+        CHECK(vm_call2(vm, "is_odd", 1000001, 0) == 1, "is_odd(1000001) 结果错误");
+        CHECK(vm_call2(vm, "wide", 5, 0) == 17, "wide(5) 结果错误");
+        CHECK(vm_call2(vm, "fact", 10, 0) == 3628800, "fact(10) 结果错误");
+        vm_program_destroy(vm);
+    }
+
+    // 本机代码: 实参都在寄存器中的尾调用释放栈帧后jmp; wide有7个实参, 仍用call
+    X86Module* x86 = x86_module_create(module);
+    for (int i = 0; i < module->function_count; i++) {
+        if (!module->functions[i].is_defined) continue;
+        IRRegAlloc* alloc = ir_regalloc_create(&module->functions[i], &x86_64_target);
+        x86_module_add_function(x86, i, alloc);
+        ir_regalloc_destroy(alloc);
+    }
+    const X86Function* is_odd = find_x86_function(x86, "is_odd");
+    const X86Function* wide = find_x86_function(x86, "wide");
+    CHECK(is_odd && count_x86_op(is_odd, X86_TAILJMP) == 1 && count_x86_op(is_odd, X86_CALL) == 0,
+          "is_odd 应以jmp调用is_even");
+    CHECK(wide && count_x86_op(wide, X86_TAILJMP) == 0 && count_x86_op(wide, X86_CALL) == 1,
+          "有栈上实参的尾调用应保留call");
+    CHECK(x86->stats.tail_calls == 2, "应有2处尾调用, 实际 %d", x86->stats.tail_calls);
+    X86Code* code = x86_code_create(x86);
+    JitProgram* program = jit_program_create(x86, code, stderr);
+    CHECK(program != NULL, "装入失败");
+    if (program) {
+        int (*is_even)(int) = (int (*)(int))jit_program_lookup(program, "is_even");
+        int (*sum)(int, int) = (int (*)(int, int))jit_program_lookup(program, "sum");
+        int (*wide_native)(int) = (int (*)(int))jit_program_lookup(program, "wide");
+        // 每层16字节时1000万层需要160MB栈, 只有改为跳转才能完成
+        CHECK(is_even && is_even(10000000) == 1, "本机 is_even(10000000) 结果错误");
+        CHECK(sum && sum(1000000, 0) == (int32_t)500000500000LL, "本机 sum(1000000) 结果错误");
+        CHECK(wide_native && wide_native(5) == 17, "本机 wide(5) 结果错误");
+        jit_program_destroy(program);
+    }
+    x86_code_destroy(code);
+    x86_module_destroy(x86);
+    ir_module_destroy(module);
+}
+
+// ========== profile ==========
+
+// mix有两处调用, 超出普通的内联预算; once从不执行, tiny每次只循环两轮
+static const char* const profile_source =
+    "int rare(int x) { return x * 3 + 1; }\n"
+    "int step(int x) { if (x < 0) return rare(x); return x + 1; }\n"
+    "int mix(int a, int b) { int c = a * 7 + b; int d = c / 3 - a; int e = d * d + c; int f = e % 11 + d;\n"
+    "    int h = f * 5 - e + a * b; int j = h / 7 + c * d; return j % 1000 + h - f * 2; }\n"
+    "int tiny(int n) { int s = 0; int i = 0; while (i < n) { s = s + i; i = i + 1; } return s; }\n"
+    "int once(int n) { return mix(n, 2); }\n"
+    "int run(int n) { int t = 0; int k = 0; while (k < n) { t = t + step(k) + tiny(2) + mix(k, t); k = k + 1; } return t; }\n";
+
+// 修改了tiny的控制流, 其他函数不变
+static const char* const profile_drift_source =
+    "int rare(int x) { return x * 3 + 1; }\n"
+    "int step(int x) { if (x < 0) return rare(x); return x + 1; }\n"
+    "int mix(int a, int b) { int c = a * 7 + b; int d = c / 3 - a; int e = d * d + c; int f = e % 11 + d;\n"
+    "    int h = f * 5 - e + a * b; int j = h / 7 + c * d; return j % 1000 + h - f * 2; }\n"
+    "int tiny(int n) { int s = 0; int i = 0; while (i < n) { if (i > 5) s = s - 1; s = s + i; i = i + 1; } return s; }\n"
+    "int once(int n) { return mix(n, 2); }\n"
+    "int run(int n) { int t = 0; int k = 0; while (k < n) { t = t + step(k) + tiny(2) + mix(k, t); k = k + 1; } return t; }\n";
+
+#define PROFILE_TEST_FILE "test_ir.profdata"
+
+// 与驱动相同: SSA构造之后拆分关键边、插桩或读取profile, 再依次优化
+static IRModule* profile_module(const char* source, ProfileLayout** layout) {
+    IRModule* module = lower_source(source);
+    if (!module) return NULL;
+    ir_module_to_ssa(module, NULL);
+    *layout = profile_layout_create(module);
+    return module;
+}
+
+static void optimize_profiled(IRModule* module, IRInlineStats* inlining, IRUnrollStats* unroll) {
+    ir_module_sccp(module, NULL, NULL);
+    ir_module_inline(module, inlining);
+    ir_module_gvn(module, NULL);
+    ir_module_licm(module, NULL);
+    ir_module_strength_reduce(module, NULL);
+    ir_module_dce(module, NULL);
+    ir_module_unroll(module, unroll);
+}
+
+// 插桩时函数name的基本块block的计数
+static uint64_t profile_counter(const IRModule* module, const ProfileLayout* layout, const void* counters,
+                                const char* name, int block) {
+    for (int f = 0; f < layout->function_count; f++) {
+        if (strcmp(module->functions[layout->functions[f].function].name, name) != 0) continue;
+        uint64_t value;
+        memcpy(&value, (const uint8_t*)counters + 8 * (size_t)(layout->functions[f].first_counter + block),
+               sizeof(value));
+        return value;
+    }
+    return UINT64_MAX;
+}
+
+static X86Module* select_module(IRModule* module) {
+    X86Module* x86 = x86_module_create(module);
+    for (int i = 0; i < module->function_count; i++) {
+        if (!module->functions[i].is_defined) continue;
+        IRRegAlloc* alloc = ir_regalloc_create(&module->functions[i], &x86_64_target);
+        x86_module_add_function(x86, i, alloc);
+        ir_regalloc_destroy(alloc);
+    }
+    return x86;
+}
+
+static void test_profile(void) {
+    printf("=== profile ===\n");
+    remove(PROFILE_TEST_FILE);
+
+    // 插桩: 每个非空基本块一条count, 内联复制进来的count仍计入被调用者的计数器
+    ProfileLayout* layout = NULL;
+    IRModule* module = profile_module(profile_source, &layout);
+    CHECK(module != NULL, "转换失败");
+    if (!module) return;
+    ProfileStats stats;
+    memset(&stats, 0, sizeof(stats));
+    profile_instrument(module, layout, &stats);
+    CHECK(stats.functions == 6 && stats.counters == layout->counter_count, "应为6个函数插桩, 实际 %d",
+          stats.functions);
+    CHECK(count_op(find_function(module, "rare"), IR_COUNT) == 1, "rare 只有一个基本块");
+    optimize_profiled(module, NULL, NULL);
+    CHECK(ir_module_verify(module, stdout), "插桩并优化后校验失败");
+
+    int64_t expected = -1;
+    size_t counter_bytes = 8 * (size_t)layout->counter_count;
+    uint8_t* vm_counters = (uint8_t*)calloc(1, counter_bytes);
+    VMProgram* vm = vm_program_create(module, stderr);
+    CHECK(vm != NULL, "编译字节码失败");
+    if (vm) {
+        expected = vm_call2(vm, "run", 1000, 0);
+        memcpy(vm_counters, vm->globals + vm->global_offsets[layout->global], counter_bytes);
+        CHECK(profile_counter(module, layout, vm_counters, "run", 0) == 1, "run 应执行1次");
+        CHECK(profile_counter(module, layout, vm_counters, "tiny", 0) == 1000, "tiny 应执行1000次");
+        CHECK(profile_counter(module, layout, vm_counters, "rare", 0) == 0, "rare 不应执行");
+        CHECK(profile_counter(module, layout, vm_counters, "once", 0) == 0, "once 不应执行");
+        vm_program_destroy(vm);
+    }
+
+    // 本机代码的计数与字节码完全相同
+    X86Module* x86 = select_module(module);
+    X86Code* code = x86_code_create(x86);
+    JitProgram* program = jit_program_create(x86, code, stderr);
+    CHECK(program != NULL, "装入失败");
+    if (program) {
+        int (*run)(int) = (int (*)(int))jit_program_lookup(program, "run");
+        CHECK(run && run(1000) == (int32_t)expected, "本机 run(1000) 结果错误");
+        CHECK(memcmp(program->globals[layout->global], vm_counters, counter_bytes) == 0,
+              "本机代码的计数与字节码不同");
+        // 两次写入同一文件, 计数累加
+        CHECK(profile_write(module, layout, vm_counters, PROFILE_TEST_FILE, stdout), "写入profile失败");
+        CHECK(profile_write(module, layout, program->globals[layout->global], PROFILE_TEST_FILE, stdout),
+              "合并profile失败");
+        jit_program_destroy(program);
+    }
+    x86_code_destroy(code);
+    x86_module_destroy(x86);
+    free(vm_counters);
+    profile_layout_destroy(layout);
+    ir_module_destroy(module);
+
+    // 使用: 计数写入基本块, 指导内联、展开和块的顺序
+    module = profile_module(profile_source, &layout);
+    memset(&stats, 0, sizeof(stats));
+    CHECK(profile_apply(module, layout, PROFILE_TEST_FILE, &stats, stdout), "读取profile失败");
+    CHECK(stats.matched == 6 && stats.mismatched == 0 && stats.missing == 0, "6个函数都应匹配, 实际 %d / %d / %d",
+          stats.matched, stats.mismatched, stats.missing);
+    CHECK(find_function(module, "tiny")->blocks[0].count == 2000, "tiny 的入口应计数2000次, 实际 %lld",
+          (long long)find_function(module, "tiny")->blocks[0].count);
+    IRInlineStats inlining;
+    IRUnrollStats unroll;
+    memset(&inlining, 0, sizeof(inlining));
+    memset(&unroll, 0, sizeof(unroll));
+    optimize_profiled(module, &inlining, &unroll);
+    CHECK(ir_module_verify(module, stdout), "使用profile优化后校验失败");
+    CHECK(inlining.cold_calls == 2, "rare和once中的mix没有执行过, 不应内联, 实际 %d", inlining.cold_calls);
+    CHECK(inlining.hot_calls == 1, "run中的mix是热点, 应放宽预算内联, 实际 %d", inlining.hot_calls);
+    CHECK(count_op(find_function(module, "once"), IR_CALL) == 1, "once 中的调用应保留");
+    CHECK(unroll.short_loops >= 1 && unroll.unrolled_loops == 0, "tiny 的循环只有两轮, 不应展开");
+
+    x86 = select_module(module);
+    CHECK(x86->stats.cold_blocks >= 1, "没有执行过的块应移到函数末尾");
+    code = x86_code_create(x86);
+    program = jit_program_create(x86, code, stderr);
+    CHECK(program != NULL, "装入失败");
+    if (program) {
+        int (*run)(int) = (int (*)(int))jit_program_lookup(program, "run");
+        CHECK(run && run(1000) == (int32_t)expected, "使用profile后 run(1000) 结果错误");
+        jit_program_destroy(program);
+    }
+    x86_code_destroy(code);
+    x86_module_destroy(x86);
+    profile_layout_destroy(layout);
+    ir_module_destroy(module);
+
+    // 源代码修改过的函数校验和不同, 只忽略这个函数
+    module = profile_module(profile_drift_source, &layout);
+    memset(&stats, 0, sizeof(stats));
+    CHECK(profile_apply(module, layout, PROFILE_TEST_FILE, &stats, stdout), "读取profile失败");
+    CHECK(stats.matched == 5 && stats.mismatched == 1, "应有5个函数匹配、1个不符, 实际 %d / %d",
+          stats.matched, stats.mismatched);
+    CHECK(find_function(module, "tiny")->blocks[0].count == -1, "修改过的tiny不应使用计数");
+    CHECK(find_function(module, "step")->blocks[0].count == 2000, "step 的计数应保留");
+    CHECK(!profile_apply(module, layout, "test_ir.missing.profdata", NULL, null_stream), "不存在的文件应报告失败");
+    profile_layout_destroy(layout);
+    ir_module_destroy(module);
+    remove(PROFILE_TEST_FILE);
+}
+
+// ========== 窥孔优化 ==========
+
+static X86Operand peep_operand(X86OperandKind kind, int value) {
+    X86Operand operand;
+    memset(&operand, 0, sizeof(operand));
+    operand.kind = (uint8_t)kind;
+    operand.index = -1;
+    if (kind == X86_OPERAND_REG) operand.reg = (int8_t)value;
+    else operand.value = value;
+    return operand;
+}
+
+static void peep_emit(X86Function* function, X86Opcode op, int size, X86Operand dst, X86Operand src) {
+    X86Instr* instr = &function->instrs[function->instr_count++];
+    memset(instr, 0, sizeof(*instr));
+    instr->op = (uint8_t)op;
+    instr->size = (uint8_t)size;
+    instr->dst = dst;
+    instr->src = src;
+}
+
+// 短路求值的比较结果既作为值又用于分支; 经过调用和循环
+static const char* const peephole_source =
+    "int less(int a, int b) { int r = 0; if (a < b && b > 0) r = 10; if (a < b || a == 0) r = r + 1; return r; }\n"
+    "int gcd(int x, int y) { while (y != 0) { int t = x % y; x = y; y = t; } return x; }\n"
+    "int mix(int n) { int s = 0; int i = 0; while (i < n) { s = s + gcd(i * 7, 21) + less(i, 5); i++; } return s; }\n";
+
+static int x86_module_instrs(const X86Module* module) {
+    int count = 0;
+    for (int i = 0; i < module->function_count; i++) count += module->functions[i].instr_count;
+    return count;
+}
+
+static void test_peephole(void) {
+    printf("=== 窥孔优化 ===\n");
+
+    // 手工构造的指令序列:
+    //   movl %edi, %edi; cmpl $0, %edi; je L0; jmp L1; L0: movq $5, %rax; jmp R;
+    //   L1: movl %edi, %ecx; addl %esi, %ecx; movl %ecx, %eax; jmp R
+    // R是尾声之前的标号(return_label), 由x86_finalize_frame加在末尾
+    X86Function function;
+    memset(&function, 0, sizeof(function));
+    function.instr_capacity = 16;
+    function.instrs = (X86Instr*)calloc((size_t)function.instr_capacity, sizeof(X86Instr));
+    function.label_count = 3;
+    function.return_label = 2;
+    X86Operand none = peep_operand(X86_OPERAND_NONE, 0);
+    X86Operand edi = peep_operand(X86_OPERAND_REG, X86_RDI);
+    X86Operand esi = peep_operand(X86_OPERAND_REG, X86_RSI);
+    X86Operand ecx = peep_operand(X86_OPERAND_REG, X86_RCX);
+    X86Operand eax = peep_operand(X86_OPERAND_REG, X86_RAX);
+    peep_emit(&function, X86_MOV, 4, edi, edi);
+    peep_emit(&function, X86_CMP, 4, edi, peep_operand(X86_OPERAND_IMM, 0));
+    peep_emit(&function, X86_JCC, 0, peep_operand(X86_OPERAND_LABEL, 0), none);
+    function.instrs[function.instr_count - 1].cond = X86_CC_E;
+    peep_emit(&function, X86_JMP, 0, peep_operand(X86_OPERAND_LABEL, 1), none);
+    peep_emit(&function, X86_LABEL, 0, peep_operand(X86_OPERAND_LABEL, 0), none);
+    peep_emit(&function, X86_MOV, 8, eax, peep_operand(X86_OPERAND_IMM, 5));
+    peep_emit(&function, X86_JMP, 0, peep_operand(X86_OPERAND_LABEL, 2), none);
+    peep_emit(&function, X86_LABEL, 0, peep_operand(X86_OPERAND_LABEL, 1), none);
+    peep_emit(&function, X86_MOV, 4, ecx, edi);
+    peep_emit(&function, X86_ADD, 4, ecx, esi);
+    peep_emit(&function, X86_MOV, 4, eax, ecx);
+    peep_emit(&function, X86_JMP, 0, peep_operand(X86_OPERAND_LABEL, 2), none);
+
+    X86PeepholeStats stats;
+    memset(&stats, 0, sizeof(stats));
+    x86_peephole_function(&function, &stats);
+    CHECK(stats.applied[X86_PEEP_SELF_MOVE] == 1, "应删除自身复制");
+    CHECK(stats.applied[X86_PEEP_CMP_ZERO] == 1, "与0比较应改为test");
+    CHECK(stats.applied[X86_PEEP_JCC_OVER_JMP] == 1, "跳过jmp的条件跳转应反转条件");
+    CHECK(stats.applied[X86_PEEP_UNUSED_LABEL] == 1, "不再被引用的标号应删除");
+    CHECK(stats.applied[X86_PEEP_IMM32] == 1, "非负立即数应改用movl");
+    CHECK(stats.applied[X86_PEEP_OP_COPY] == 1, "运算结果应直接算到目标寄存器");
+    CHECK(stats.applied[X86_PEEP_JUMP_NEXT] == 1, "末尾跳到尾声的jmp应删除");
+    CHECK(stats.removed == 4, "应删除4条指令, 实际 %d", stats.removed);
+    // test %edi, %edi; jne L1; movl $5, %eax; jmp R; L1: movl %edi, %eax; addl %esi, %eax
+    const X86Instr* code = function.instrs;
+    CHECK(function.instr_count == 7, "改写后应剩7条, 实际 %d", function.instr_count);
+    if (function.instr_count == 7) {
+        CHECK(code[0].op == X86_TEST && code[1].op == X86_JCC && code[1].cond == X86_CC_NE &&
+              code[1].dst.value == 1, "条件跳转改写错误");
+        CHECK(code[2].op == X86_MOV && code[2].size == 4 && code[2].src.value == 5, "立即数改写错误");
+        CHECK(code[5].op == X86_MOV && code[5].dst.reg == X86_RAX && code[5].src.reg == X86_RDI &&
+              code[6].op == X86_ADD && code[6].dst.reg == X86_RAX, "复制链改写错误");
+    }
+    free(function.instrs);
+
+    // 同一IR分别生成有无窥孔优化的本机代码, 结果相同且指令更少
+    IRModule* module = optimize_source(peephole_source, NULL);
+    CHECK(module != NULL, "转换失败");
+    if (!module) return;
+    X86Module* plain = x86_module_create(module);
+    plain->peephole = false;
+    for (int i = 0; i < module->function_count; i++) {
+        if (!module->functions[i].is_defined) continue;
+        IRRegAlloc* alloc = ir_regalloc_create(&module->functions[i], &x86_64_target);
+        x86_module_add_function(plain, i, alloc);
+        ir_regalloc_destroy(alloc);
+    }
+    X86Module* peephole = select_module(module);
+    CHECK(plain->stats.peephole == 0 && peephole->stats.peephole > 0, "窥孔优化没有改写, %d",
+          peephole->stats.peephole);
+    CHECK(x86_module_instrs(peephole) < x86_module_instrs(plain), "窥孔优化后指令应更少: %d / %d",
+          x86_module_instrs(peephole), x86_module_instrs(plain));
+    const X86Function* less = find_x86_function(peephole, "less");
+    const X86Function* plain_less = find_x86_function(plain, "less");
+    // 与0比较改为test, 比较数不变; setcc之后的test被原来的条件跳转代替, 比较数减少
+    CHECK(less && plain_less &&
+          count_x86_op(less, X86_TEST) + count_x86_op(less, X86_CMP) <
+              count_x86_op(plain_less, X86_TEST) + count_x86_op(plain_less, X86_CMP),
+          "setcc之后的test应被条件跳转代替");
+
+    X86Code* plain_code = x86_code_create(plain);
+    X86Code* peephole_code = x86_code_create(peephole);
+    JitProgram* a = jit_program_create(plain, plain_code, stderr);
+    JitProgram* b = jit_program_create(peephole, peephole_code, stderr);
+    CHECK(a && b, "装入失败");
+    if (a && b) {
+        int (*less_a)(int, int) = (int (*)(int, int))jit_program_lookup(a, "less");
+        int (*less_b)(int, int) = (int (*)(int, int))jit_program_lookup(b, "less");
+        int (*mix_a)(int) = (int (*)(int))jit_program_lookup(a, "mix");
+        int (*mix_b)(int) = (int (*)(int))jit_program_lookup(b, "mix");
+        CHECK(less_b && less_b(1, 2) == 11 && less_b(2, 1) == 0 && less_b(-3, -3) == 0, "less 结果错误");
+        for (int n = 0; n < 40; n += 3) {
+            CHECK(mix_a && mix_b && mix_a(n) == mix_b(n), "mix(%d) 结果不一致", n);
+            CHECK(less_a && less_a(n - 20, 7) == less_b(n - 20, 7), "less(%d, 7) 结果不一致", n - 20);
+        }
+    }
+    if (a) jit_program_destroy(a);
+    if (b) jit_program_destroy(b);
+    x86_code_destroy(plain_code);
+    x86_code_destroy(peephole_code);
+    x86_module_destroy(plain);
+    x86_module_destroy(peephole);
+    ir_module_destroy(module);
+}
+
+// ========== 栈帧布局 ==========
+
+// 不同作用域中的数组; 分支之后的c与它们都不同时活跃
+static const char* const frame_source =
+    "int f(int k) { int s = 0;\n"
+    "    if (k > 0) { int a[32]; int i = 0; while (i < 32) { a[i] = i * k; i++; }\n"
+    "                 i = 0; while (i < 32) { s = s + a[i]; i++; } }\n"
+    "    else { int b[32]; int j = 0; while (j < 32) { b[j] = j - k; j++; }\n"
+    "           j = 0; while (j < 32) { s = s + b[j]; j++; } }\n"
+    "    int c[16]; int m = 0; while (m < 16) { c[m] = s + m; m++; }\n"
+    "    return c[15] + c[0]; }\n";
+
+static X86Operand frame_slot(int object) {
+    X86Operand operand = peep_operand(X86_OPERAND_MEM, 0);
+    operand.base_kind = X86_BASE_FRAME;
+    operand.object = object;
+    return operand;
+}
+
+static void test_frame(void) {
+    printf("=== 栈帧布局 ===\n");
+
+    // 两个溢出槽先后使用: movq $1, s0; movq s0, %rax; movq $2, s1; movq s1, %rcx
+    X86Function function;
+    memset(&function, 0, sizeof(function));
+    X86FrameObject objects[2] = { { 8, 8, 0 }, { 8, 8, 0 } };
+    X86Instr instrs[5];
+    function.objects = objects;
+    function.object_count = 2;
+    function.instrs = instrs;
+    function.instr_capacity = 5;
+    peep_emit(&function, X86_MOV, 8, frame_slot(0), peep_operand(X86_OPERAND_IMM, 1));
+    peep_emit(&function, X86_MOV, 8, peep_operand(X86_OPERAND_REG, X86_RAX), frame_slot(0));
+    peep_emit(&function, X86_MOV, 8, frame_slot(1), peep_operand(X86_OPERAND_IMM, 2));
+    peep_emit(&function, X86_MOV, 8, peep_operand(X86_OPERAND_REG, X86_RCX), frame_slot(1));
+    X86FrameStats stats;
+    memset(&stats, 0, sizeof(stats));
+    x86_frame_layout(&function, true, &stats);
+    CHECK(stats.objects == 2 && stats.shared == 1 && stats.saved_bytes == 8, "两个溢出槽应共用一个栈槽: %d / %d",
+          stats.shared, stats.saved_bytes);
+    CHECK(objects[0].offset == -8 && objects[1].offset == -8, "共用栈槽的偏移错误: %d / %d",
+          objects[0].offset, objects[1].offset);
+
+    memset(&stats, 0, sizeof(stats));
+    x86_frame_layout(&function, false, &stats);
+    CHECK(stats.shared == 0 && objects[0].offset != objects[1].offset, "不共用时应各占一个栈槽");
+
+    // s1先写后读, 读s0在写s1之后: 两者冲突
+    instrs[1].dst = peep_operand(X86_OPERAND_REG, X86_RDX);
+    instrs[1].src = peep_operand(X86_OPERAND_IMM, 0);
+    peep_emit(&function, X86_ADD, 8, peep_operand(X86_OPERAND_REG, X86_RCX), frame_slot(0));
+    memset(&stats, 0, sizeof(stats));
+    x86_frame_layout(&function, true, &stats);
+    CHECK(stats.shared == 0, "同时活跃的溢出槽不能共用");
+
+    // 取了地址的对象可能经指针读写, 单独占一个栈槽
+    function.instr_count = 4;
+    instrs[1] = (X86Instr){ X86_LEA, 8, 0, peep_operand(X86_OPERAND_REG, X86_RAX), frame_slot(0) };
+    memset(&stats, 0, sizeof(stats));
+    x86_frame_layout(&function, true, &stats);
+    CHECK(stats.shared == 0, "取了地址的对象不应与其他对象共用栈槽");
+
+    // 源程序: a、b、c共用一个栈槽, 栈帧缩小且结果不变
+    IRModule* module = optimize_source(frame_source, NULL);
+    CHECK(module != NULL, "转换失败");
+    if (!module) return;
+    X86Module* separate = x86_module_create(module);
+    separate->share_frame_slots = false;
+    for (int i = 0; i < module->function_count; i++) {
+        if (!module->functions[i].is_defined) continue;
+        IRRegAlloc* alloc = ir_regalloc_create(&module->functions[i], &x86_64_target);
+        x86_module_add_function(separate, i, alloc);
+        ir_regalloc_destroy(alloc);
+    }
+    X86Module* shared = select_module(module);
+    CHECK(shared->stats.frame_shared >= 2, "a、b、c应共用栈槽, 实际 %d", shared->stats.frame_shared);
+    // b(128字节)和c(64字节)放进a的栈槽
+    CHECK(shared->stats.frame_bytes + 128 + 64 <= separate->stats.frame_bytes, "栈帧应至少缩小192字节: %d / %d",
+          shared->stats.frame_bytes, separate->stats.frame_bytes);
+    const X86Function* f = find_x86_function(shared, "f");
+    for (int i = 0; f && i < f->object_count; i++) {
+        const X86FrameObject* object = &f->objects[i];
+        CHECK(object->size == 0 || object->offset % object->align == 0, "对象 %d 没有对齐", i);
+    }
+
+    X86Code* code = x86_code_create(shared);
+    JitProgram* program = jit_program_create(shared, code, stderr);
+    CHECK(program != NULL, "装入失败");
+    if (program) {
+        int (*native)(int) = (int (*)(int))jit_program_lookup(program, "f");
+        // k = 3: s = 3 * 496 = 1488, c[15] + c[0] = 2 * 1488 + 15
+        CHECK(native && native(3) == 2991, "f(3) 结果错误: %d", native ? native(3) : -1);
+        // k = -2: s = 496 + 64 = 560
+        CHECK(native && native(-2) == 1135, "f(-2) 结果错误: %d", native ? native(-2) : -1);
+        jit_program_destroy(program);
+    }
+    x86_code_destroy(code);
+    x86_module_destroy(separate);
+    x86_module_destroy(shared);
+    ir_module_destroy(module);
+}
+
+// ========== 字节码虚拟机 ==========
+
+static void test_vm(void) {
+    printf("=== 字节码虚拟机 ===\n");
+
+    IRModule* module = lower_source(
+        "int abs(int x);\n"
+        "int counter = 3;\n"
+        "int table[8];\n"
+        "int fib(int n) { if (n < 2) return n; return fib(n - 1) + fib(n - 2); }\n"
+        "int sum_to(int n) { int s = 0; int i = 1; while (i <= n) { s += i; i++; } return s; }\n"
+        "int bump(int k) { counter = counter + k; table[k] = table[k] + counter; return table[k]; }\n"
+        "int local(int n) { int a[4]; int i = 0; while (i < 4) { a[i] = i * n; i++; } return a[3] - a[1]; }\n"
+        "int distance(int a, int b) { return abs(a - b); }\n"
+        "int divide(int a, int b) { return a / b + a % 7; }\n"
+        "int deep(int n) { return deep(n + 1) + 1; }\n"
+        "int main() { return fib(10) - 13; }\n"
+        "counter = counter * 2;\n");
+    CHECK(module != NULL, "转换失败");
+    if (!module) return;
+    ir_module_to_ssa(module, NULL);
+    ir_module_sccp(module, NULL, NULL);
+    ir_module_gvn(module, NULL);
+    ir_module_dce(module, NULL);
+
+    VMProgram* program = vm_program_create(module, stderr);
+    CHECK(program != NULL, "编译失败");
+    if (program) {
+        // 循环条件和 counter/table[k] 的读-加-写都应合并为超级指令
+        CHECK(program->stats.fused_branches > 0, "没有生成比较跳转");
+        CHECK(program->stats.fused_updates >= 2, "读-加-写只合并了 %d 处", program->stats.fused_updates);
+
+        int64_t args[2] = { 20, 0 };
+        int64_t result = 0;
+        int fib = vm_program_lookup(program, "fib");
+        CHECK(vm_program_call(program, fib, args, &result, stderr) && result == 6765, "fib(20) 结果错误: %lld",
+              (long long)result);
+        args[0] = 100;
+        CHECK(vm_program_call(program, vm_program_lookup(program, "sum_to"), args, &result, stderr) &&
+              result == 5050, "sum_to 结果错误");
+        args[0] = 5;
+        CHECK(vm_program_call(program, vm_program_lookup(program, "local"), args, &result, stderr) &&
+              result == 10, "局部数组读写错误: %lld", (long long)result);
+        args[0] = 3;
+        args[1] = 10;
+        CHECK(vm_program_call(program, vm_program_lookup(program, "distance"), args, &result, stderr) &&
+              result == 7, "调用C库的abs结果错误");
+
+        // 顶层语句在main之前执行
+        int status = -1;
+        CHECK(vm_program_run(program, &status, stderr) && status == 42, "main 的返回值错误: %d", status);
+        int bump = vm_program_lookup(program, "bump");
+        args[0] = 4;
+        CHECK(vm_program_call(program, bump, args, &result, stderr) && result == 10, "全局变量读写错误");
+        CHECK(vm_program_call(program, bump, args, &result, stderr) && result == 24, "全局数组累加错误");
+
+        // 运行时错误报告后返回false, 之后仍可继续调用
+        int divide = vm_program_lookup(program, "divide");
+        args[0] = -2147483647 - 1;
+        args[1] = -1;
+        CHECK(vm_program_call(program, divide, args, &result, stderr) && result == 2147483646,
+              "INT_MIN / -1 和之后的加法应按32位回绕: %lld", (long long)result);
+        args[1] = 0;
+        CHECK(!vm_program_call(program, divide, args, &result, null_stream), "除数为0应报错");
+        args[0] = 0;
+        CHECK(!vm_program_call(program, vm_program_lookup(program, "deep"), args, &result, null_stream),
+              "无限递归应报告调用栈溢出");
+        args[0] = 10;
+        CHECK(vm_program_call(program, fib, args, &result, stderr) && result == 55, "出错后再次调用失败");
+        CHECK(vm_program_lookup(program, "missing") == -1, "不存在的函数应返回-1");
+        vm_program_destroy(program);
+    }
+    ir_module_destroy(module);
+
+    // 找不到的外部函数在编译时报错
+    IRModule* missing = lower_source(
+        "int no_such_function_in_libc(int x);\n"
+        "int main() { return no_such_function_in_libc(1); }\n");
+    CHECK(missing != NULL, "转换失败");
+    if (missing) {
+        ir_module_to_ssa(missing, NULL);
+        CHECK(vm_program_create(missing, null_stream) == NULL, "外部函数不存在时应编译失败");
+        ir_module_destroy(missing);
+    }
+}
+
+// ========== 分层执行 ==========
+
+static void test_tiered(void) {
+    printf("=== 分层执行 ===\n");
+
+    IRModule* module = lower_source(
+        "int counter = 3;\n"
+        "int table[8];\n"
+        "int fib(int n) { if (n < 2) return n; return fib(n - 1) + fib(n - 2); }\n"
+        "int bump(int k) { counter = counter + k; table[k] = table[k] + counter; return table[k]; }\n"
+        "int sum_to(int n) { int s = 0; int i = 1; while (i <= n) { s += i; i++; } return s; }\n"
+        "int inner(int x) { return x * 3; }\n"
+        "int outer(int x) { return inner(x) + 1; }\n"
+        "int many(int a, int b, int c, int d, int e, int f, int g, int h, int i) { return a + i; }\n"
+        "int main() { return outer(2) + counter; }\n");
+    CHECK(module != NULL, "转换失败");
+    if (!module) return;
+    ir_module_to_ssa(module, NULL);
+    ir_module_sccp(module, NULL, NULL);
+    ir_module_dce(module, NULL);
+
+    TieredProgram* program = tiered_program_create(module, 4, 50, stderr);
+    CHECK(program != NULL, "编译失败");
+    if (program) {
+        VMProgram* vm = program->vm;
+        int64_t args[9] = { 10, 0 };
+        int64_t result = 0;
+
+        // 递归调用很快到达阈值, 编译完成后的调用进入本机代码
+        int fib = vm_program_lookup(vm, "fib");
+        CHECK(vm_program_call(vm, fib, args, &result, stderr) && result == 55, "解释执行 fib(10) 错误");
+        tiered_program_wait(program);
+        CHECK(atomic_load(&vm->functions[fib].compiled) != NULL, "fib 没有换成本机代码");
+        args[0] = 20;
+        CHECK(vm_program_call(vm, fib, args, &result, stderr) && result == 6765, "本机代码 fib(20) 错误: %lld",
+              (long long)result);
+
+        // 前后两层读写同一块全局变量区
+        int bump = vm_program_lookup(vm, "bump");
+        args[0] = 1;
+        for (int i = 0; i < 10; i++) {
+            CHECK(vm_program_call(vm, bump, args, &result, stderr), "bump 调用失败");
+            tiered_program_wait(program);
+        }
+        CHECK(atomic_load(&vm->functions[bump].compiled) != NULL, "bump 没有换成本机代码");
+        CHECK(result == 85, "table[1] 应为 4 + 5 + ... + 13: %lld", (long long)result);
+        CHECK(vm->globals[vm->global_offsets[0]] == 13, "counter 应为 13: %d", vm->globals[vm->global_offsets[0]]);
+
+        // 只调用一次但循环很多的函数按回边数请求, 下一次调用生效
+        int sum_to = vm_program_lookup(vm, "sum_to");
+        args[0] = 1000;
+        CHECK(vm_program_call(vm, sum_to, args, &result, stderr) && result == 500500, "sum_to 结果错误");
+        tiered_program_wait(program);
+        CHECK(atomic_load(&vm->functions[sum_to].compiled) != NULL, "循环多的 sum_to 没有换成本机代码");
+        CHECK(vm_program_call(vm, sum_to, args, &result, stderr) && result == 500500, "本机代码 sum_to 结果错误");
+
+        // 被调用者随调用者一起编译(之后它自己的请求不再编译); 超过8个参数的函数编译但不从虚拟机直接调用
+        int outer = vm_program_lookup(vm, "outer");
+        int many = vm_program_lookup(vm, "many");
+        for (int i = 0; i < 4; i++) {
+            args[0] = i;
+            vm_program_call(vm, outer, args, &result, stderr);
+        }
+        for (int i = 0; i < 9; i++) args[i] = i + 1;
+        for (int i = 0; i < 6; i++) vm_program_call(vm, many, args, &result, stderr);
+        tiered_program_wait(program);
+        CHECK(atomic_load(&vm->functions[vm_program_lookup(vm, "inner")].compiled) != NULL,
+              "inner 应随 outer 一起编译");
+        CHECK(result == 10 && atomic_load(&vm->functions[many].compiled) == NULL, "many 不应从虚拟机直接调用本机代码");
+        CHECK(program->entries[many] != NULL, "many 应已编译");
+
+        int status = -1;
+        CHECK(tiered_program_run(program, &status, stderr) && status == 20, "main 的返回值错误: %d", status);
+
+        tiered_program_stop(program);
+        const TierStats* stats = &program->perf.tier;
+        CHECK(stats->requests >= 5 && stats->units == 5 && stats->failed == 0 && stats->compiled == 5,
+              "统计错误: 请求 %d, 批次 %d, 失败 %d, 函数 %d", stats->requests, stats->units, stats->failed,
+              stats->compiled);
+        CHECK(program->perf.phases[PHASE_JIT].runs == stats->units, "后台编译没有计时");
+        tiered_program_destroy(program);
+    }
+    ir_module_destroy(module);
+}
+
+// ========== 公式批量求值 ==========
+
+static ExprProgram* compile_formula(const char* source, FILE* err) {
+    return expr_program_create(source, strlen(source), err);
+}
+
+static void test_expr_eval(void) {
+    printf("=== 公式批量求值 ===\n");
+
+    // test_legal.c 的公式; 行数不是块大小的倍数
+    ExprProgram* program = compile_formula(
+        "int num1;\nint num2;\nint result;\nresult = num1 * (num2 + 5) / 2 - 10\n", stderr);
+    CHECK(program != NULL, "编译失败");
+    if (program) {
+        CHECK(program->variable_count == 3 && program->target == 2, "变量或赋值目标错误");
+        CHECK(expr_program_variable(program, "num2") == 1 && expr_program_variable(program, "x") == -1,
+              "变量列号错误");
+        enum { ROWS = 1000 };
+        int32_t* num1 = (int32_t*)malloc(sizeof(int32_t) * ROWS);
+        int32_t* num2 = (int32_t*)malloc(sizeof(int32_t) * ROWS);
+        int32_t* out = (int32_t*)malloc(sizeof(int32_t) * ROWS);
+        for (int i = 0; i < ROWS; i++) {
+            num1[i] = i * 37 - 5000;
+            num2[i] = 300 - i;
+        }
+        const int32_t* columns[3] = { num1, num2, NULL };
+        CHECK(expr_program_eval(program, columns, ROWS, out) == 0, "不应有除数为0的行");
+        int wrong = 0;
+        for (int i = 0; i < ROWS; i++) wrong += out[i] != num1[i] * (num2[i] + 5) / 2 - 10;
+        CHECK(wrong == 0, "%d 行结果错误", wrong);
+        free(num1);
+        free(num2);
+        free(out);
+        expr_program_destroy(program);
+    }
+
+    // 乘法按32位回绕; 没有绑定的列取初值
+    program = compile_formula("int a;\nint b;\nint k = 7;\na * 65536 * 65536 + a * b + k\n", stderr);
+    ExprProgram* logic = compile_formula("int a;\nint b;\n(a < b || a == b) && !(a + b)\n", stderr);
+    CHECK(program != NULL && logic != NULL, "编译失败");
+    if (program && logic) {
+        int32_t a[5] = { 1, -3, 0, 2147483647, 4 };
+        int32_t b[5] = { 2, 3, 0, 2, -4 };
+        int32_t out[5];
+        const int32_t* columns[3] = { a, b, NULL };
+        expr_program_eval(program, columns, 5, out);
+        CHECK(out[0] == 9 && out[1] == -2 && out[2] == 7 && out[3] == 5 && out[4] == -9,
+              "乘法应按32位回绕: %d %d %d %d %d", out[0], out[1], out[2], out[3], out[4]);
+        expr_program_eval(logic, columns, 5, out);
+        CHECK(out[0] == 0 && out[1] == 1 && out[2] == 1 && out[3] == 0 && out[4] == 0,
+              "比较和逻辑运算结果错误: %d %d %d %d %d", out[0], out[1], out[2], out[3], out[4]);
+    }
+    expr_program_destroy(program);
+    expr_program_destroy(logic);
+
+    // 除数为0的行结果为0并计数, 被&&短路的一侧不算; INT_MIN / -1 回绕
+    program = compile_formula("int a;\nint b;\nb != 0 && a / b > 1\n", stderr);
+    ExprProgram* divide = compile_formula("int a;\nint b;\na / b + a % 3\n", stderr);
+    CHECK(program != NULL && divide != NULL, "编译失败");
+    if (program && divide) {
+        int32_t a[4] = { 10, 10, -2147483647 - 1, 7 };
+        int32_t b[4] = { 0, 3, -1, 0 };
+        int32_t out[4];
+        const int32_t* columns[2] = { a, b };
+        CHECK(expr_program_eval(program, columns, 4, out) == 0, "短路的除法不应报告除数为0");
+        CHECK(out[0] == 0 && out[1] == 1 && out[2] == 0 && out[3] == 0, "&& 的结果错误");
+        CHECK(expr_program_eval(divide, columns, 4, out) == 2, "应有2行除数为0");
+        // INT_MIN / -1 + INT_MIN % 3 = INT_MIN - 2, 回绕为 INT_MAX - 1
+        CHECK(out[0] == 0 && out[1] == 4 && out[2] == 2147483646 && out[3] == 0, "除法结果错误: %d", out[2]);
+    }
+    expr_program_destroy(program);
+    expr_program_destroy(divide);
+
+    // 公式之外的语句编译失败, 诊断写到err
+    CHECK(compile_formula("int f(int x) { return x; }\nint a;\na + 1\n", null_stream) == NULL,
+          "函数定义应被拒绝");
+    CHECK(compile_formula("int a;\na +\n", null_stream) == NULL, "语法错误应编译失败");
+}
+
+// ========== 规模测试 ==========
+
+// 手工构造有 3*diamonds+2 个基本块的函数:
+// 每个菱形按 x < k 分支, 一边修改x, 另一边修改s, 汇合后进入下一个菱形;
+// 每 loop_every 个菱形外面套一层循环(回边回到该组的第一个菱形)
+static IRFunction* build_diamonds(IRModule* module, int diamonds, int loop_every) {
+    int id = ir_module_add_function(module, "diamonds", IR_TYPE_I32, 1);
+    IRFunction* f = &module->functions[id];
+    f->is_defined = true;
+
+    IROperand x = ir_operand_slot(ir_new_slot(f, "x", IR_TYPE_I32, 1, -1), IR_TYPE_I32);
+    IROperand s = ir_operand_slot(ir_new_slot(f, "s", IR_TYPE_I32, 1, -1), IR_TYPE_I32);
+
+    int entry = ir_new_block(f);
+    IROperand init_x[2] = { x, ir_operand_vreg(0, IR_TYPE_I32) };
+    IROperand init_s[2] = { s, ir_operand_const(0, IR_TYPE_I32) };
+    ir_emit(f, entry, IR_STORE, IR_TYPE_VOID, false, init_x, 2, 1);
+    ir_emit(f, entry, IR_STORE, IR_TYPE_VOID, false, init_s, 2, 1);
+
+    int current = ir_new_block(f);
+    IROperand jump[1] = { ir_operand_block(current) };
+    ir_emit(f, entry, IR_JMP, IR_TYPE_VOID, false, jump, 1, 1);
+
+    int group_head = current;
+    for (int k = 0; k < diamonds; k++) {
+        int then_block = ir_new_block(f);
+        int else_block = ir_new_block(f);
+        int join = ir_new_block(f);
+
+        IROperand load_x[1] = { x };
+        int xv = emit_value(f, current, IR_LOAD, IR_TYPE_I32, load_x, 1);
+        IROperand cmp[2] = { ir_operand_vreg(xv, IR_TYPE_I32), ir_operand_const(k, IR_TYPE_I32) };
+        int cond = emit_value(f, current, IR_LT, IR_TYPE_BOOL, cmp, 2);
+        IROperand br[3] = { ir_operand_vreg(cond, IR_TYPE_BOOL), ir_operand_block(then_block),
+                            ir_operand_block(else_block) };
+        ir_emit(f, current, IR_BR, IR_TYPE_VOID, false, br, 3, 1);
+
+        IROperand add[2] = { ir_operand_vreg(xv, IR_TYPE_I32), ir_operand_const(1, IR_TYPE_I32) };
+        int sum = emit_value(f, then_block, IR_ADD, IR_TYPE_I32, add, 2);
+        IROperand store_x[2] = { x, ir_operand_vreg(sum, IR_TYPE_I32) };
+        ir_emit(f, then_block, IR_STORE, IR_TYPE_VOID, false, store_x, 2, 1);
+        IROperand to_join[1] = { ir_operand_block(join) };
+        ir_emit(f, then_block, IR_JMP, IR_TYPE_VOID, false, to_join, 1, 1);
+
+        IROperand load_s[1] = { s };
+        int sv = emit_value(f, else_block, IR_LOAD, IR_TYPE_I32, load_s, 1);
+        IROperand sub[2] = { ir_operand_vreg(sv, IR_TYPE_I32), ir_operand_vreg(xv, IR_TYPE_I32) };
+        int diff = emit_value(f, else_block, IR_SUB, IR_TYPE_I32, sub, 2);
+        IROperand store_s[2] = { s, ir_operand_vreg(diff, IR_TYPE_I32) };
+        ir_emit(f, else_block, IR_STORE, IR_TYPE_VOID, false, store_s, 2, 1);
+        ir_emit(f, else_block, IR_JMP, IR_TYPE_VOID, false, to_join, 1, 1);
+
+        current = join;
+        if (loop_every > 0 && (k + 1) % loop_every == 0) {
+            // 回到本组开头, 或继续下一组
+            int next = ir_new_block(f);
+            IROperand reload[1] = { s };
+            int sv2 = emit_value(f, current, IR_LOAD, IR_TYPE_I32, reload, 1);
+            IROperand test[2] = { ir_operand_vreg(sv2, IR_TYPE_I32), ir_operand_const(0, IR_TYPE_I32) };
+            int again = emit_value(f, current, IR_GT, IR_TYPE_BOOL, test, 2);
+            IROperand loop[3] = { ir_operand_vreg(again, IR_TYPE_BOOL), ir_operand_block(group_head),
+                                  ir_operand_block(next) };
+            ir_emit(f, current, IR_BR, IR_TYPE_VOID, false, loop, 3, 1);
+            current = next;
+            group_head = next;
+        }
+    }
+
+    IROperand load_x[1] = { x };
+    int xv = emit_value(f, current, IR_LOAD, IR_TYPE_I32, load_x, 1);
+    IROperand ret[1] = { ir_operand_vreg(xv, IR_TYPE_I32) };
+    ir_emit(f, current, IR_RET, IR_TYPE_VOID, false, ret, 1, 1);
+
+    ir_function_compute_cfg(f);
+    return f;
+}
+
+static double time_ssa(int diamonds, int loop_every, int* blocks, bool* ok) {
+    double best = -1;
+    for (int run = 0; run < 3; run++) {
+        IRModule* module = ir_module_create();
+        IRFunction* f = build_diamonds(module, diamonds, loop_every);
+        *blocks = f->block_count;
+
+        double start = perf_now();
+        ir_function_to_ssa(f, NULL);
+        double elapsed = perf_now() - start;
+        if (best < 0 || elapsed < best) best = elapsed;
+
+        if (run == 0) {
+            *ok = ir_function_verify(module, f, stdout) && count_op(f, IR_LOAD) == 0 &&
+                  count_op(f, IR_STORE) == 0;
+        }
+        ir_module_destroy(module);
+    }
+    return best;
+}
+
+static double time_regalloc(int diamonds, int loop_every, int* instrs, bool* ok) {
+    double best = -1;
+    for (int run = 0; run < 3; run++) {
+        IRModule* module = ir_module_create();
+        IRFunction* f = build_diamonds(module, diamonds, loop_every);
+        ir_function_to_ssa(f, NULL);
+        *instrs = ir_module_instr_count(module);
+
+        double start = perf_now();
+        IRRegAlloc* alloc = ir_regalloc_create(f, &x86_64_target);
+        double elapsed = perf_now() - start;
+        if (best < 0 || elapsed < best) best = elapsed;
+
+        if (run == 0) *ok = check_allocation(f, alloc);
+        ir_regalloc_destroy(alloc);
+        ir_module_destroy(module);
+    }
+    return best;
+}
+
+static void test_scaling(void) {
+    printf("=== SSA构造规模测试 ===\n");
+    printf("  %8s %8s %10s %12s\n", "diamonds", "blocks", "ms", "ns/block");
+
+    static const int loop_shapes[] = { 0, 8 };
+    for (int shape = 0; shape < 2; shape++) {
+        double first_per_block = -1;
+        double last_per_block = -1;
+        for (int diamonds = 1000; diamonds <= 32000; diamonds *= 2) {
+            int blocks = 0;
+            bool ok = false;
+            double seconds = time_ssa(diamonds, loop_shapes[shape], &blocks, &ok);
+            double per_block = seconds * 1e9 / blocks;
+            printf("  %8d %8d %10.3f %12.1f%s\n", diamonds, blocks, seconds * 1000.0, per_block,
+                   loop_shapes[shape] ? "  (带循环)" : "");
+            CHECK(ok, "%d 个菱形的SSA未通过校验", diamonds);
+
+            if (first_per_block < 0) first_per_block = per_block;
+            last_per_block = per_block;
+        }
+        // 规模扩大32倍时每块耗时应基本不变; 二次复杂度会使其扩大约32倍
+        CHECK(last_per_block < first_per_block * 8 + 200,
+              "每块耗时从 %.1fns 增长到 %.1fns, 不是线性规模", first_per_block, last_per_block);
+    }
+
+    printf("=== 寄存器分配规模测试 ===\n");
+    printf("  %8s %8s %10s %12s\n", "diamonds", "instrs", "ms", "ns/instr");
+    double first_per_instr = -1;
+    double last_per_instr = -1;
+    for (int diamonds = 1000; diamonds <= 32000; diamonds *= 2) {
+        int instrs = 0;
+        bool ok = false;
+        double seconds = time_regalloc(diamonds, 8, &instrs, &ok);
+        double per_instr = seconds * 1e9 / instrs;
+        printf("  %8d %8d %10.3f %12.1f\n", diamonds, instrs, seconds * 1000.0, per_instr);
+        CHECK(ok, "%d 个菱形的寄存器分配不正确", diamonds);
+
+        if (first_per_instr < 0) first_per_instr = per_instr;
+        last_per_instr = per_instr;
+    }
+    CHECK(last_per_instr < first_per_instr * 8 + 200,
+          "每条指令耗时从 %.1fns 增长到 %.1fns, 不是线性规模", first_per_instr, last_per_instr);
+    // 未优化编译时10万条指令的函数也应在200ms内分配完
+    CHECK(last_per_instr < 2000, "每条指令耗时 %.1fns", last_per_instr);
+}
+
+int main(void) {
+    null_stream = fopen("/dev/null", "w");
+    if (!null_stream) {
+        perror("fopen /dev/null");
+        return 1;
+    }
+
+    test_dominators();
+    test_ssa();
+    test_verifier();
+    test_sccp();
+    test_inline();
+    test_gvn();
+    test_dce();
+    test_licm();
+    test_strength();
+    test_regalloc();
+    test_codegen();
+    test_jit();
+    test_unroll();
+    test_tailcall();
+    test_profile();
+    test_peephole();
+    test_frame();
+    test_vm();
+    test_tiered();
+    test_expr_eval();
+    test_scaling();
+
+    fclose(null_stream);
+    if (failures > 0) {
+        printf("\n\033[31m%d 项检查失败\033[0m\n", failures);
+        return 1;
+    }
+    printf("\n\033[32m中间代码测试全部通过\033[0m\n");
+    return 0;
+}
@@ -0,0 +1,198 @@
+#define _GNU_SOURCE
+
+#include "tiered.h"
+#include "ir_regalloc.h"
+#include "x86_64.h"
+#include <stdlib.h>
+#include <string.h>
+
+static void* tiered_alloc(size_t size) {
+    void* ptr = calloc(1, size ? size : 1);
+    if (!ptr) {
+        perror("malloc failed for tiered");
+        exit(1);
+    }
+    return ptr;
+}
+
+// ========== 后台编译 ==========
+
+// 热点函数连同它调用的、还没有装入的已定义函数, 写入unit并返回个数
+static int collect_unit(const TieredProgram* program, int root, int32_t* unit, bool* in_unit) {
+    const IRModule* module = program->module;
+    int count = 0;
+    unit[count++] = root;
+    in_unit[root] = true;
+    for (int k = 0; k < count; k++) {
+        const IRFunction* function = &module->functions[unit[k]];
+        for (int b = 0; b < function->block_count; b++) {
+            const IRBlock* block = &function->blocks[b];
+            for (int i = 0; i < block->instr_count; i++) {
+                const IRInstr* instr = &function->instrs[block->instrs[i]];
+                if (instr->op != IR_CALL) continue;
+                int callee = function->operands[instr->args].value;
+                if (!module->functions[callee].is_defined || program->entries[callee] || in_unit[callee]) continue;
+                in_unit[callee] = true;
+                unit[count++] = callee;
+            }
+        }
+    }
+    for (int k = 0; k < count; k++) in_unit[unit[k]] = false;
+    return count;
+}
+
+static void compile_unit(TieredProgram* program, int root, int32_t* unit, bool* in_unit) {
+    IRModule* module = program->module;
+    int count = collect_unit(program, root, unit, in_unit);
+
+    perf_phase_begin(&program->perf, PHASE_JIT);
+    X86Module* x86 = x86_module_create(module);
+    for (int k = 0; k < count; k++) {
+        IRRegAlloc* alloc = ir_regalloc_create(&module->functions[unit[k]], &x86_64_target);
+        x86_module_add_function(x86, unit[k], alloc);
+        ir_regalloc_destroy(alloc);
+    }
+    X86Code* code = x86_code_create(x86);
+    JitProgram* jit = jit_program_create_linked(x86, code, program->globals, program->entries, program->err);
+    x86_code_destroy(code);
+    x86_module_destroy(x86);
+    perf_phase_end(&program->perf, PHASE_JIT);
+
+    program->perf.tier.units++;
+    if (!jit) {
+        program->perf.tier.failed++;
+        return;
+    }
+    if (program->unit_count == program->unit_capacity) {
+        program->unit_capacity = program->unit_capacity ? program->unit_capacity * 2 : 8;
+        program->units = (JitProgram**)realloc(program->units, sizeof(JitProgram*) * (size_t)program->unit_capacity);
+        if (!program->units) {
+            perror("realloc failed for tiered units");
+            exit(1);
+        }
+    }
+    program->units[program->unit_count++] = jit;
+
+    // 代码页已经设为可执行, release保证执行线程看到入口时也看到完整的代码
+    for (int k = 0; k < count; k++) {
+        VMFunction* function = &program->vm->functions[unit[k]];
+        program->entries[unit[k]] = jit->functions[unit[k]];
+        if (function->param_count > VM_NATIVE_ARGS) continue;
+        atomic_store_explicit(&function->compiled, jit->functions[unit[k]], memory_order_release);
+        program->perf.tier.compiled++;
+    }
+}
+
+static void* compile_thread(void* arg) {
+    TieredProgram* program = (TieredProgram*)arg;
+    int32_t* unit = (int32_t*)tiered_alloc(sizeof(int32_t) * (size_t)program->module->function_count);
+    bool* in_unit = (bool*)tiered_alloc(sizeof(bool) * (size_t)program->module->function_count);
+
+    pthread_mutex_lock(&program->lock);
+    for (;;) {
+        while (!program->stop && program->queue_head == program->queue_count) {
+            pthread_cond_wait(&program->wake, &program->lock);
+        }
+        if (program->stop) break;
+        int function = program->queue[program->queue_head++];
+        program->busy = true;
+        pthread_mutex_unlock(&program->lock);
+
+        // 可能已经作为之前某一批的被调用者装入了
+        if (!program->entries[function]) compile_unit(program, function, unit, in_unit);
+
+        pthread_mutex_lock(&program->lock);
+        program->busy = false;
+        if (program->queue_head == program->queue_count) pthread_cond_broadcast(&program->idle);
+    }
+    pthread_mutex_unlock(&program->lock);
+
+    free(in_unit);
+    free(unit);
+    return NULL;
+}
+
+// 虚拟机的计数到达阈值: 放入队列, 立即返回继续解释执行
+static void request_compile(void* context, int function) {
+    TieredProgram* program = (TieredProgram*)context;
+    pthread_mutex_lock(&program->lock);
+    if (!program->requested[function] && !program->stop) {
+        program->requested[function] = true;
+        program->queue[program->queue_count++] = function;
+        program->perf.tier.requests++;
+        if (!program->started) {
+            program->started = pthread_create(&program->thread, NULL, compile_thread, program) == 0;
+            if (!program->started) {
+                fprintf(program->err, "分层执行: 无法创建编译线程, 继续解释执行\n");
+                program->stop = true;
+            }
+        }
+        pthread_cond_signal(&program->wake);
+    }
+    pthread_mutex_unlock(&program->lock);
+}
+
+// ========== 创建和执行 ==========
+
+TieredProgram* tiered_program_create(IRModule* module, uint32_t calls, uint32_t loops, FILE* err) {
+    VMProgram* vm = vm_program_create(module, err);
+    if (!vm) return NULL;
+
+    TieredProgram* program = (TieredProgram*)tiered_alloc(sizeof(TieredProgram));
+    program->module = module;
+    program->vm = vm;
+    program->err = err;
+    program->globals = (void**)tiered_alloc(sizeof(void*) * (size_t)module->global_count);
+    for (int i = 0; i < module->global_count; i++) {
+        program->globals[i] = vm->globals + vm->global_offsets[i];
+    }
+    program->entries = (void**)tiered_alloc(sizeof(void*) * (size_t)module->function_count);
+    program->queue = (int32_t*)tiered_alloc(sizeof(int32_t) * (size_t)module->function_count);
+    program->requested = (bool*)tiered_alloc(sizeof(bool) * (size_t)module->function_count);
+    perf_report_init(&program->perf);
+    pthread_mutex_init(&program->lock, NULL);
+    pthread_cond_init(&program->wake, NULL);
+    pthread_cond_init(&program->idle, NULL);
+
+    vm_program_set_tiering(vm, calls ? calls : TIER_CALL_THRESHOLD, loops ? loops : TIER_LOOP_THRESHOLD,
+                           request_compile, program);
+    return program;
+}
+
+void tiered_program_stop(TieredProgram* program) {
+    pthread_mutex_lock(&program->lock);
+    bool joinable = program->started && !program->stop;
+    program->stop = true;
+    pthread_cond_signal(&program->wake);
+    pthread_mutex_unlock(&program->lock);
+    if (joinable) pthread_join(program->thread, NULL);
+}
+
+void tiered_program_destroy(TieredProgram* program) {
+    if (!program) return;
+    tiered_program_stop(program);
+    for (int i = 0; i < program->unit_count; i++) jit_program_destroy(program->units[i]);
+    free(program->units);
+    vm_program_destroy(program->vm);
+    pthread_mutex_destroy(&program->lock);
+    pthread_cond_destroy(&program->wake);
+    pthread_cond_destroy(&program->idle);
+    free(program->requested);
+    free(program->queue);
+    free(program->entries);
+    free(program->globals);
+    free(program);
+}
+
+bool tiered_program_run(TieredProgram* program, int* status, FILE* err) {
+    return vm_program_run(program->vm, status, err);
+}
+
+void tiered_program_wait(TieredProgram* program) {
+    pthread_mutex_lock(&program->lock);
+    while (program->started && !program->stop &&
+           (program->busy || program->queue_head < program->queue_count)) {
+        pthread_cond_wait(&program->idle, &program->lock);
+    }
+    pthread_mutex_unlock(&program->lock);
+}
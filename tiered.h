@@ -0,0 +1,69 @@
+#ifndef TIERED_H
+#define TIERED_H
+
+#include <pthread.h>
+#include <stdio.h>
+#include "jit.h"
+#include "perf_report.h"
+#include "vm.h"
+
+// ========== 分层执行 ==========
+//
+// 先由字节码虚拟机(vm.h)解释执行, 程序不必等机器码生成就开始运行; 虚拟机为每个函数统计
+// 调用次数和循环回边数, 到达阈值的函数交给后台线程编译为本机代码
+// (寄存器分配 → 指令选择 → 编码 → jit_program_create_linked), 装入后发布入口,
+// 之后对它的调用直接进入本机代码。正在解释执行的那一次调用不会中途切换(没有栈上替换),
+// 所以只被调用一次的函数(如main)即使循环很热也一直解释执行。
+// 编译的一批 = 热点函数 + 它直接或间接调用的、还没有编译过的已定义函数, 本机代码从不回到虚拟机;
+// 调用之前批次中的函数经跳板。本机代码与虚拟机共用同一块全局变量区。
+// 除数为0时本机代码与--run一样由SIGFPE终止, 解释执行时则报告错误。
+
+// 默认阈值, 可在编译时用-D覆盖
+#ifndef TIER_CALL_THRESHOLD
+#define TIER_CALL_THRESHOLD 1000
+#endif
+#ifndef TIER_LOOP_THRESHOLD
+#define TIER_LOOP_THRESHOLD 10000
+#endif
+
+typedef struct TieredProgram {
+    IRModule* module;       // 后台线程从中编译(执行期间不能再修改)
+    VMProgram* vm;
+    FILE* err;              // 后台编译失败的原因
+    void** globals;         // IR全局变量 → 虚拟机全局变量区中的地址
+    void** entries;         // IR函数 → 已装入的本机代码入口, 只由后台线程读写
+
+    JitProgram** units;     // 装入的各批代码
+    int unit_count;
+    int unit_capacity;
+
+    PerfReport perf;        // 后台编译的耗时(PHASE_JIT)和分层执行的统计
+
+    // 以下由lock保护
+    pthread_mutex_t lock;
+    pthread_cond_t wake;    // 有新的请求或要求退出
+    pthread_cond_t idle;    // 请求都已处理完
+    int32_t* queue;         // 请求编译的函数, 每个函数最多一次
+    bool* requested;
+    int queue_head;
+    int queue_count;
+    bool busy;              // 后台线程正在编译
+    bool stop;
+    bool started;           // 第一次请求时才创建后台线程
+    pthread_t thread;
+} TieredProgram;
+
+// 编译字节码(见vm_program_create); calls/loops为0时使用默认阈值
+TieredProgram* tiered_program_create(IRModule* module, uint32_t calls, uint32_t loops, FILE* err);
+// 停止后台线程(丢弃还没开始的请求), 之后perf不再变化; 已经装入的代码仍可调用
+void tiered_program_stop(TieredProgram* program);
+// 停止后台线程并释放
+void tiered_program_destroy(TieredProgram* program);
+
+// 先执行顶层语句再调用main, main的返回值写入status
+bool tiered_program_run(TieredProgram* program, int* status, FILE* err);
+
+// 等待已请求的编译全部完成
+void tiered_program_wait(TieredProgram* program);
+
+#endif // TIERED_H
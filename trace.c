@@ -0,0 +1,204 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "trace.h"
+#include "perf_report.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#define TRACE_NAME_SIZE 48
+
+typedef struct TraceEvent {
+    double timestamp;               // 相对于跟踪开始的微秒数
+    const char* category;           // 静态字符串
+    char phase;                     // 'B' 开始 / 'E' 结束
+    char name[TRACE_NAME_SIZE];
+} TraceEvent;
+
+// 每个线程一个事件缓冲区; lock只在本线程追加与trace_close写出/清空之间竞争
+typedef struct TraceBuffer {
+    pthread_mutex_t lock;
+    TraceEvent* events;
+    int count;
+    int capacity;
+    int tid;
+    bool thread_alive;              // 线程退出后由trace_close释放
+    struct TraceBuffer* next;
+} TraceBuffer;
+
+volatile bool trace_active = false;
+
+static pthread_mutex_t trace_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t trace_key_once = PTHREAD_ONCE_INIT;
+static pthread_key_t trace_key;         // 仅用于线程退出时的回调
+static TraceBuffer* trace_buffers = NULL;
+static int trace_next_tid = 1;
+static char* trace_path = NULL;
+static double trace_start_time = 0;
+
+static _Thread_local TraceBuffer* thread_buffer = NULL;
+
+// 线程退出: 缓冲区留给trace_close写出后再释放
+static void trace_thread_exit(void* arg) {
+    TraceBuffer* buffer = (TraceBuffer*)arg;
+    pthread_mutex_lock(&trace_lock);
+    buffer->thread_alive = false;
+    pthread_mutex_unlock(&trace_lock);
+}
+
+static void trace_create_key(void) {
+    pthread_key_create(&trace_key, trace_thread_exit);
+}
+
+static TraceBuffer* trace_thread_buffer(void) {
+    if (thread_buffer) return thread_buffer;
+    
+    TraceBuffer* buffer = (TraceBuffer*)calloc(1, sizeof(TraceBuffer));
+    if (!buffer) {
+        perror("calloc failed for TraceBuffer");
+        exit(1);
+    }
+    buffer->thread_alive = true;
+    pthread_mutex_init(&buffer->lock, NULL);
+    
+    pthread_once(&trace_key_once, trace_create_key);
+    pthread_setspecific(trace_key, buffer);
+    
+    pthread_mutex_lock(&trace_lock);
+    buffer->tid = trace_next_tid++;
+    buffer->next = trace_buffers;
+    trace_buffers = buffer;
+    pthread_mutex_unlock(&trace_lock);
+    
+    thread_buffer = buffer;
+    return buffer;
+}
+
+static void trace_push(char phase, const char* category, const char* name) {
+    TraceBuffer* buffer = trace_thread_buffer();
+    
+    pthread_mutex_lock(&buffer->lock);
+    // trace_close已经结束了会话: 检查trace_active之后才关闭的, 丢弃这个事件
+    if (!trace_active) {
+        pthread_mutex_unlock(&buffer->lock);
+        return;
+    }
+    if (buffer->count == buffer->capacity) {
+        buffer->capacity = buffer->capacity ? buffer->capacity * 2 : 1024;
+        buffer->events = (TraceEvent*)realloc(buffer->events, sizeof(TraceEvent) * buffer->capacity);
+        if (!buffer->events) {
+            perror("realloc failed for TraceEvent");
+            exit(1);
+        }
+    }
+    
+    TraceEvent* event = &buffer->events[buffer->count++];
+    event->timestamp = (perf_now() - trace_start_time) * 1e6;
+    event->category = category;
+    event->phase = phase;
+    if (name) {
+        strncpy(event->name, name, TRACE_NAME_SIZE - 1);
+        event->name[TRACE_NAME_SIZE - 1] = '\0';
+    } else {
+        event->name[0] = '\0';
+    }
+    pthread_mutex_unlock(&buffer->lock);
+}
+
+void trace_begin_event(const char* category, const char* name) {
+    trace_push('B', category, name);
+}
+
+void trace_end_event(void) {
+    trace_push('E', NULL, NULL);
+}
+
+bool trace_open(const char* path, FILE* err) {
+    pthread_mutex_lock(&trace_lock);
+    if (trace_path) {
+        pthread_mutex_unlock(&trace_lock);
+        fprintf(err, "已有跟踪会话正在进行: %s\n", trace_path);
+        return false;
+    }
+    trace_path = strdup(path);
+    trace_start_time = perf_now();
+    trace_active = true;
+    pthread_mutex_unlock(&trace_lock);
+    return true;
+}
+
+bool trace_close(FILE* err) {
+    pthread_mutex_lock(&trace_lock);
+    if (!trace_path) {
+        pthread_mutex_unlock(&trace_lock);
+        return false;
+    }
+    trace_active = false;
+    
+    bool success = true;
+    FILE* file = fopen(trace_path, "w");
+    if (!file) {
+        fprintf(err, "无法写入跟踪文件 %s: %s\n", trace_path, strerror(errno));
+        success = false;
+    } else {
+        int pid = (int)getpid();
+        bool first = true;
+        fprintf(file, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [");
+        
+        for (TraceBuffer* buffer = trace_buffers; buffer; buffer = buffer->next) {
+            pthread_mutex_lock(&buffer->lock);
+            if (buffer->count == 0) {
+                pthread_mutex_unlock(&buffer->lock);
+                continue;
+            }
+            
+            // 线程名元数据
+            fprintf(file, "%s\n{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": %d, \"tid\": %d, "
+                          "\"args\": {\"name\": \"thread %d\"}}",
+                    first ? "" : ",", pid, buffer->tid, buffer->tid);
+            first = false;
+            
+            for (int i = 0; i < buffer->count; i++) {
+                TraceEvent* event = &buffer->events[i];
+                if (event->phase == 'B') {
+                    fprintf(file, ",\n{\"name\": ");
+                    perf_json_fprint_string(file, event->name);
+                    fprintf(file, ", \"cat\": \"%s\", \"ph\": \"B\", \"ts\": %.3f, \"pid\": %d, \"tid\": %d}",
+                            event->category ? event->category : "compile",
+                            event->timestamp, pid, buffer->tid);
+                } else {
+                    fprintf(file, ",\n{\"ph\": \"E\", \"ts\": %.3f, \"pid\": %d, \"tid\": %d}",
+                            event->timestamp, pid, buffer->tid);
+                }
+            }
+            pthread_mutex_unlock(&buffer->lock);
+        }
+        fprintf(file, "\n]}\n");
+        fclose(file);
+    }
+    
+    // 释放已退出线程的缓冲区,清空仍存活线程的缓冲区
+    TraceBuffer** link = &trace_buffers;
+    while (*link) {
+        TraceBuffer* buffer = *link;
+        if (!buffer->thread_alive) {
+            *link = buffer->next;
+            free(buffer->events);
+            pthread_mutex_destroy(&buffer->lock);
+            free(buffer);
+        } else {
+            pthread_mutex_lock(&buffer->lock);
+            buffer->count = 0;
+            pthread_mutex_unlock(&buffer->lock);
+            link = &buffer->next;
+        }
+    }
+    
+    free(trace_path);
+    trace_path = NULL;
+    pthread_mutex_unlock(&trace_lock);
+    return success;
+}
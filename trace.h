@@ -0,0 +1,32 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdbool.h>
+#include <stdio.h>
+
+// ========== Chrome/Perfetto 跟踪事件(--trace=out.json) ==========
+//
+// 每个线程把事件追加到自己的缓冲区(只有trace_close时才会争用缓冲区的锁), trace_close时统一写出为
+// Chrome trace-event JSON格式, 可直接用 chrome://tracing 或 ui.perfetto.dev 打开.
+
+// 开始记录跟踪事件(同一时刻只能有一个跟踪会话, 记录进程内所有线程的事件); 错误写到err
+bool trace_open(const char* path, FILE* err);
+// 写出所有线程缓冲区中的事件并结束跟踪
+bool trace_close(FILE* err);
+
+// 是否正在记录(未开启时trace_begin/trace_end开销只有一次判断)
+extern volatile bool trace_active;
+
+// 开始/结束一个嵌套区间; name会被复制(过长时截断)
+void trace_begin_event(const char* category, const char* name);
+void trace_end_event(void);
+
+static inline void trace_begin(const char* category, const char* name) {
+    if (trace_active) trace_begin_event(category, name);
+}
+
+static inline void trace_end(void) {
+    if (trace_active) trace_end_event();
+}
+
+#endif // TRACE_H
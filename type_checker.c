@@ -1,4 +1,5 @@
 #include "type_checker.h"
+#include "trace.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -17,6 +18,8 @@ TypeChecker* type_checker_create() {
     checker->has_errors = false;
     checker->error_count = 0;
     checker->current_function_return_type = NULL;
+    checker->out = stdout;
+    checker->err = stderr;
     
     return checker;
 }
@@ -31,29 +34,28 @@ void type_checker_destroy(TypeChecker* checker) {
 // ========== 错误报告 ==========
 
 void type_error(TypeChecker* checker, int line, const char* format, ...) {
-    fprintf(stderr, "\033[31m类型错误 (行 %d): ", line);
+    fprintf(checker->err, "\033[31m类型错误 (行 %d): ", line);
     
     va_list args;
     va_start(args, format);
-    vfprintf(stderr, format, args);
+    vfprintf(checker->err, format, args);
     va_end(args);
     
-    fprintf(stderr, "\033[0m\n");
+    fprintf(checker->err, "\033[0m\n");
     
     checker->has_errors = true;
     checker->error_count++;
 }
 
 void type_warning(TypeChecker* checker, int line, const char* format, ...) {
-    (void)checker;
-    fprintf(stderr, "\033[33m类型警告 (行 %d): ", line);
+    fprintf(checker->err, "\033[33m类型警告 (行 %d): ", line);
     
     va_list args;
     va_start(args, format);
-    vfprintf(stderr, format, args);
+    vfprintf(checker->err, format, args);
     va_end(args);
     
-    fprintf(stderr, "\033[0m\n");
+    fprintf(checker->err, "\033[0m\n");
 }
 
 // ========== 工具函数 ==========
@@ -463,6 +465,7 @@ Type* type_check_func_decl(TypeChecker* checker, ASTNode* node) {
     
     // 如果有函数体,进入新作用域检查函数体
     if (node->data.func_decl.body) {
+        trace_begin("type_check", node->data.func_decl.func_name);
         symbol_table_enter_scope(checker->symbol_table);
         
         // 将参数加入符号表
@@ -488,6 +491,7 @@ Type* type_check_func_decl(TypeChecker* checker, ASTNode* node) {
         checker->current_function_return_type = saved_return_type;
         
         symbol_table_exit_scope(checker->symbol_table);
+        trace_end();
     }
     
     return node->data.func_decl.return_type;
@@ -657,20 +661,20 @@ bool type_check_program(TypeChecker* checker, ASTNode* program) {
         return false;
     }
     
-    printf("\n========== 开始类型检查 ==========\n");
+    fprintf(checker->out, "\n========== 开始类型检查 ==========\n");
     
     // 检查所有全局声明
     for (int i = 0; i < program->data.program.decl_count; i++) {
         type_check_node(checker, program->data.program.declarations[i]);
     }
     
-    printf("========== 类型检查完成 ==========\n");
+    fprintf(checker->out, "========== 类型检查完成 ==========\n");
     
     if (checker->has_errors) {
-        printf("\033[31m发现 %d 个类型错误\033[0m\n", checker->error_count);
+        fprintf(checker->out, "\033[31m发现 %d 个类型错误\033[0m\n", checker->error_count);
         return false;
     } else {
-        printf("\033[32m类型检查通过,没有发现错误\033[0m\n");
+        fprintf(checker->out, "\033[32m类型检查通过,没有发现错误\033[0m\n");
         return true;
     }
 }
@@ -4,6 +4,7 @@
 #include "ast.h"
 #include "symbol_table.h"
 #include <stdbool.h>
+#include <stdio.h>
 
 // ========== 类型检查器结构 ==========
 
@@ -12,6 +13,8 @@ typedef struct TypeChecker {
     bool has_errors;
     int error_count;
     Type* current_function_return_type;  // 当前函数的返回类型(用于检查return语句)
+    FILE* out;                           // 进度信息输出流(默认stdout)
+    FILE* err;                           // 错误和警告输出流(默认stderr)
 } TypeChecker;
 
 // ========== 类型检查器操作函数 ==========
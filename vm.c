@@ -0,0 +1,1158 @@
+#define _GNU_SOURCE
+
+#include "vm.h"
+#include "ir_lower.h"
+#include <dlfcn.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+// 运行时栈的容量(寄存器/局部变量的个数)和最大调用深度
+#define VM_REGISTER_WORDS (1 << 20)
+#define VM_LOCAL_WORDS (1 << 20)
+#define VM_FRAME_LIMIT (1 << 18)
+
+// GCC/Clang的标签地址扩展; 定义VM_NO_COMPUTED_GOTO可强制使用switch分派
+#if defined(__GNUC__) && !defined(VM_NO_COMPUTED_GOTO)
+#define VM_COMPUTED_GOTO
+#endif
+
+typedef struct VMFrame {
+    const VMInstr* ip;      // 返回后继续执行的指令
+    int64_t* regs;          // 调用者的寄存器窗口
+    int32_t* locals;        // 调用者的局部变量区
+    VMFunction* function;   // 调用者
+    int32_t dest;           // 结果写入调用者的哪个寄存器, -1表示丢弃
+} VMFrame;
+
+// 按变参函数调用: 与本机代码一样在al中传0, printf等变参函数也能正确调用
+typedef int64_t (*VMNative)(int64_t, ...);
+
+static void* vm_alloc(size_t size) {
+    void* ptr = calloc(1, size ? size : 1);
+    if (!ptr) {
+        perror("malloc failed for VM");
+        exit(1);
+    }
+    return ptr;
+}
+
+static inline int64_t wrap32(int64_t value) {
+    return (int32_t)(uint32_t)value;
+}
+
+// 外部函数和编译好的函数都按本机调用约定调用, int结果只有低32位有意义
+static inline int64_t call_native(void* entry, const int64_t* args, int count, uint8_t return_type) {
+    int64_t argv[VM_NATIVE_ARGS] = { 0 };
+    memcpy(argv, args, sizeof(int64_t) * (size_t)count);
+    int64_t value = ((VMNative)entry)(argv[0], argv[1], argv[2], argv[3], argv[4], argv[5], argv[6], argv[7]);
+    return return_type == IR_TYPE_PTR ? value : wrap32(value);
+}
+
+const char* vm_opcode_name(VMOpcode op) {
+#define VM_OPCODE_STRING(name) #name,
+    static const char* const names[VM_OPCODE_COUNT] = { VM_OPCODES(VM_OPCODE_STRING) };
+#undef VM_OPCODE_STRING
+    return op < VM_OPCODE_COUNT ? names[op] : "?";
+}
+
+// ========== 编译 ==========
+
+typedef struct VMCompiler {
+    VMProgram* program;
+    IRModule* module;
+    IRFunction* function;
+    IRUses* uses;
+    FILE* err;
+    bool ok;
+
+    int32_t* slot_offset;   // 栈槽 → 局部变量区中的字偏移(提升的栈槽为-1)
+    int32_t* block_start;   // 基本块 → 第一条字节码的下标
+    int next_block;         // 排在当前块之后的块, -1表示当前块在最后
+    bool tail_calls;        // 尾调用可以复用当前帧(函数没有取栈槽的地址)
+    int32_t* lanes;         // v4i32虚拟寄存器 → 存放4个元素的连续寄存器中的第一个(排在虚拟寄存器之后)
+    int temp_base;          // 第一个临时寄存器(紧接虚拟寄存器和向量元素), 调用的实参也从这里开始
+    int temp_count;         // 当前IR指令已用的临时寄存器
+    int window;             // 寄存器窗口大小
+    int block_code;         // 当前块的第一条字节码
+    int32_t* update_load;   // 块内位置 → 与该加法合并的load的位置, -1表示不合并
+    bool* absorbed;         // 块内位置 → 该load已并入读-加-写
+
+    // 边上的并行复制
+    int32_t* copy_dst;
+    IROperand* copy_src;
+    int copy_capacity;
+} VMCompiler;
+
+static int emit(VMCompiler* cx, VMOpcode op, int32_t a, int32_t b, int32_t c) {
+    VMProgram* program = cx->program;
+    if (program->code_count == program->code_capacity) {
+        program->code_capacity = program->code_capacity ? program->code_capacity * 2 : 256;
+        program->code = (VMInstr*)realloc(program->code, sizeof(VMInstr) * (size_t)program->code_capacity);
+        if (!program->code) {
+            perror("malloc failed for VMInstr");
+            exit(1);
+        }
+    }
+    VMInstr* instr = &program->code[program->code_count];
+    instr->op = (uint8_t)op;
+    instr->a = a;
+    instr->b = b;
+    instr->c = c;
+    return program->code_count++;
+}
+
+static void reserve_window(VMCompiler* cx, int size) {
+    if (size > cx->window) cx->window = size;
+}
+
+// 临时寄存器只在一条IR指令内有效, 不会跨过调用, 因此与实参区重叠
+static int new_temp(VMCompiler* cx) {
+    int reg = cx->temp_base + cx->temp_count++;
+    reserve_window(cx, reg + 1);
+    return reg;
+}
+
+// 操作数所在的寄存器, 常量先装入临时寄存器
+static int operand_reg(VMCompiler* cx, IROperand operand) {
+    if (operand.kind == IR_OPERAND_VREG) return operand.value;
+    int reg = new_temp(cx);
+    emit(cx, VM_LOADI, reg, operand.kind == IR_OPERAND_CONST ? operand.value : 0, 0);
+    return reg;
+}
+
+static void emit_move(VMCompiler* cx, int dst, IROperand src) {
+    if (src.kind == IR_OPERAND_VREG) {
+        if (src.value != dst) emit(cx, VM_MOV, dst, src.value, 0);
+        return;
+    }
+    emit(cx, VM_LOADI, dst, src.kind == IR_OPERAND_CONST ? src.value : 0, 0);
+}
+
+static bool is_vreg(IROperand operand, int vreg) {
+    return operand.kind == IR_OPERAND_VREG && operand.value == vreg;
+}
+
+static bool same_operand(IROperand a, IROperand b) {
+    return a.kind == b.kind && a.value == b.value;
+}
+
+// 跳转指令中存放目标的字段; 编译时先存基本块编号, 函数编译完后改为字节码下标
+static int32_t* jump_target(VMInstr* instr) {
+    switch (instr->op) {
+        case VM_JMP:
+            return &instr->a;
+        case VM_JZ: case VM_JNZ:
+            return &instr->b;
+        default:
+            return instr->op >= VM_JEQ && instr->op <= VM_JGEI ? &instr->c : NULL;
+    }
+}
+
+static void emit_jump(VMCompiler* cx, int block) {
+    if (block != cx->next_block) emit(cx, VM_JMP, block, 0, 0);
+}
+
+// ---------- 算术与比较 ----------
+
+// 比较的字节码与IR同序: EQ, NE, LT, LE, GT, GE
+static int compare_index(IROpcode op) {
+    return op - IR_EQ;
+}
+
+// 交换两个操作数后的比较
+static IROpcode swap_compare(IROpcode op) {
+    switch (op) {
+        case IR_LT: return IR_GT;
+        case IR_GT: return IR_LT;
+        case IR_LE: return IR_GE;
+        case IR_GE: return IR_LE;
+        default:    return op;
+    }
+}
+
+// 结果取反的比较
+static IROpcode negate_compare(IROpcode op) {
+    switch (op) {
+        case IR_EQ: return IR_NE;
+        case IR_NE: return IR_EQ;
+        case IR_LT: return IR_GE;
+        case IR_GE: return IR_LT;
+        case IR_LE: return IR_GT;
+        default:    return IR_LE;
+    }
+}
+
+static VMOpcode binary_opcode(IROpcode op, bool immediate) {
+    switch (op) {
+        case IR_ADD: return immediate ? VM_ADDI : VM_ADD;
+        case IR_SUB: return immediate ? VM_SUBI : VM_SUB;
+        case IR_MUL: return immediate ? VM_MULI : VM_MUL;
+        case IR_AND: return immediate ? VM_ANDI : VM_AND;
+        case IR_SHL: return immediate ? VM_SHLI : VM_SHL;
+        case IR_SHR: return immediate ? VM_SHRI : VM_SHR;
+        case IR_DIV: return immediate ? VM_DIVI : VM_DIV;
+        default:     return immediate ? VM_MODI : VM_MOD;
+    }
+}
+
+static void compile_binary(VMCompiler* cx, const IRInstr* instr, const IROperand* args) {
+    IROpcode op = (IROpcode)instr->op;
+    IROperand a = args[0];
+    IROperand b = args[1];
+    // 除法只有除数是非0常量时才用立即数形式, 其余在运行时检查除数
+    if ((op != IR_DIV && op != IR_MOD) || (b.kind == IR_OPERAND_CONST && b.value != 0)) {
+        bool commutative = op == IR_ADD || op == IR_MUL || op == IR_AND;
+        if (commutative && a.kind == IR_OPERAND_CONST && b.kind != IR_OPERAND_CONST) {
+            IROperand t = a;
+            a = b;
+            b = t;
+        }
+        if (b.kind == IR_OPERAND_CONST) {
+            emit(cx, binary_opcode(op, true), instr->dest, operand_reg(cx, a), b.value);
+            return;
+        }
+    }
+    int ra = operand_reg(cx, a);
+    int rb = operand_reg(cx, b);
+    emit(cx, binary_opcode(op, false), instr->dest, ra, rb);
+}
+
+// 常量放到第二个操作数, 以便使用立即数形式
+static IROpcode normalize_compare(IROpcode op, IROperand* a, IROperand* b) {
+    if (a->kind == IR_OPERAND_CONST && b->kind != IR_OPERAND_CONST) {
+        IROperand t = *a;
+        *a = *b;
+        *b = t;
+        return swap_compare(op);
+    }
+    return op;
+}
+
+static void compile_compare(VMCompiler* cx, const IRInstr* instr, const IROperand* args) {
+    IROperand a = args[0];
+    IROperand b = args[1];
+    int k = compare_index(normalize_compare((IROpcode)instr->op, &a, &b));
+    int ra = operand_reg(cx, a);
+    if (b.kind == IR_OPERAND_CONST) emit(cx, (VMOpcode)(VM_EQI + k), instr->dest, ra, b.value);
+    else emit(cx, (VMOpcode)(VM_EQ + k), instr->dest, ra, operand_reg(cx, b));
+}
+
+// 比较跳转超级指令: 条件成立时跳到on_true, 排在后面的块直接落入
+static void emit_compare_branch(VMCompiler* cx, const IRInstr* compare, int on_true, int on_false) {
+    IROperand a = cx->function->operands[compare->args];
+    IROperand b = cx->function->operands[compare->args + 1];
+    IROpcode op = normalize_compare((IROpcode)compare->op, &a, &b);
+    if (on_true == cx->next_block) {
+        op = negate_compare(op);
+        on_true = on_false;
+        on_false = cx->next_block;
+    }
+    int k = compare_index(op);
+    int ra = operand_reg(cx, a);
+    if (b.kind == IR_OPERAND_CONST) emit(cx, (VMOpcode)(VM_JEQI + k), ra, b.value, on_true);
+    else emit(cx, (VMOpcode)(VM_JEQ + k), ra, operand_reg(cx, b), on_true);
+    emit_jump(cx, on_false);
+    cx->program->stats.fused_branches++;
+}
+
+// 比较的结果只被紧随其后的br使用时推迟到br中生成
+static bool fuse_with_branch(const VMCompiler* cx, const IRBlock* block, int i) {
+    const IRFunction* function = cx->function;
+    const IRInstr* instr = &function->instrs[block->instrs[i]];
+    if (i + 1 >= block->instr_count) return false;
+    const IRInstr* next = &function->instrs[block->instrs[i + 1]];
+    if (next->op != IR_BR) return false;
+    return is_vreg(function->operands[next->args], instr->dest) && ir_uses_count(cx->uses, instr->dest) == 1;
+}
+
+// ---------- 内存 ----------
+
+// reg ← base[index](load/lea)或 base[index] ← reg(store)。
+// ops依次是全局变量、局部变量区、指针基址的常量下标和变量下标形式;
+// 全局变量和局部变量区的常量下标并入偏移
+static void emit_addressed(VMCompiler* cx, const VMOpcode ops[6], int reg, IROperand base,
+                           const IROperand* index, bool store) {
+    int form;
+    int32_t address;
+    if (base.kind == IR_OPERAND_GLOBAL) {
+        form = 0;
+        address = cx->program->global_offsets[base.value];
+    } else if (base.kind == IR_OPERAND_SLOT) {
+        form = 2;
+        address = cx->slot_offset[base.value];
+    } else {
+        form = 4;
+        address = operand_reg(cx, base);
+    }
+
+    int32_t index_value = 0;
+    if (index && index->kind != IR_OPERAND_CONST) {
+        form++;
+        index_value = index->value;
+    } else if (index && form == 4) {
+        index_value = index->value;
+    } else if (index) {
+        address += index->value;
+    }
+    if (store) emit(cx, ops[form], address, reg, index_value);
+    else emit(cx, ops[form], reg, address, index_value);
+}
+
+static const VMOpcode load_ops[6] = { VM_LDG, VM_LDGX, VM_LDL, VM_LDLX, VM_LDP, VM_LDPX };
+static const VMOpcode store_ops[6] = { VM_STG, VM_STGX, VM_STL, VM_STLX, VM_STP, VM_STPX };
+static const VMOpcode address_ops[6] = { VM_LEAG, VM_LEAGX, VM_LEAL, VM_LEALX, VM_LEAP, VM_LEAPX };
+
+// 读-加-写超级指令: load t ← m; ...; u ← t + x; store m ← u, t只被加法使用,
+// 且load与加法之间没有store和调用(m的值不变)。全局标量(或常量下标)写回时同时把和放入u;
+// 变量下标的形式要求u只被store使用。i是加法在块中的位置, 返回对应load的位置, -1表示不能合并
+static int match_update(const VMCompiler* cx, const IRBlock* block, int i) {
+    const IRFunction* function = cx->function;
+    if (i + 1 >= block->instr_count) return -1;
+    const IRInstr* add = &function->instrs[block->instrs[i]];
+    const IRInstr* store = &function->instrs[block->instrs[i + 1]];
+    if (add->op != IR_ADD || add->type != IR_TYPE_I32 || store->op != IR_STORE) return -1;
+    const IROperand* add_args = &function->operands[add->args];
+    const IROperand* store_args = &function->operands[store->args];
+    if (!is_vreg(store_args[1], add->dest)) return -1;
+
+    // 向前找读同一位置、只被加法使用的load
+    for (int j = i - 1; j >= 0; j--) {
+        const IRInstr* load = &function->instrs[block->instrs[j]];
+        if (load->op == IR_STORE || load->op == IR_CALL) return -1;
+        if (load->op != IR_LOAD || load->dest < 0 || ir_uses_count(cx->uses, load->dest) != 1) continue;
+        if (!is_vreg(add_args[0], load->dest) && !is_vreg(add_args[1], load->dest)) continue;
+        if (is_vreg(add_args[0], load->dest) && is_vreg(add_args[1], load->dest)) return -1;
+
+        const IROperand* load_args = &function->operands[load->args];
+        const IROperand* load_index = load->arg_count > 1 ? &load_args[1] : NULL;
+        const IROperand* store_index = store->arg_count > 2 ? &store_args[2] : NULL;
+        if (!same_operand(load_args[0], store_args[0]) || (load_index == NULL) != (store_index == NULL)) continue;
+        if (load_index && !same_operand(*load_index, *store_index)) continue;
+
+        IROperand base = load_args[0];
+        bool constant_index = !load_index || load_index->kind == IR_OPERAND_CONST;
+        if (base.kind == IR_OPERAND_GLOBAL && constant_index) return j;
+        if (!constant_index && ir_uses_count(cx->uses, add->dest) == 1 &&
+            (base.kind == IR_OPERAND_GLOBAL || base.kind == IR_OPERAND_SLOT)) {
+            return j;
+        }
+        return -1;
+    }
+    return -1;
+}
+
+static void emit_update(VMCompiler* cx, const IRBlock* block, int j, int i) {
+    IRFunction* function = cx->function;
+    const IRInstr* load = &function->instrs[block->instrs[j]];
+    const IRInstr* add = &function->instrs[block->instrs[i]];
+    const IROperand* load_args = ir_instr_args(function, load);
+    const IROperand* add_args = ir_instr_args(function, add);
+    IROperand x = is_vreg(add_args[0], load->dest) ? add_args[1] : add_args[0];
+    IROperand base = load_args[0];
+    const IROperand* index = load->arg_count > 1 ? &load_args[1] : NULL;
+
+    if (!index || index->kind == IR_OPERAND_CONST) {
+        int32_t offset = cx->program->global_offsets[base.value] + (index ? index->value : 0);
+        int dest = ir_uses_count(cx->uses, add->dest) > 1 ? add->dest : new_temp(cx);
+        if (x.kind == IR_OPERAND_CONST) emit(cx, VM_ADDGI, offset, x.value, dest);
+        else emit(cx, VM_ADDG, offset, x.value, dest);
+    } else {
+        bool global = base.kind == IR_OPERAND_GLOBAL;
+        int32_t offset = global ? cx->program->global_offsets[base.value] : cx->slot_offset[base.value];
+        emit(cx, global ? VM_ADDGX : VM_ADDLX, offset, index->value, operand_reg(cx, x));
+    }
+    cx->program->stats.fused_updates++;
+}
+
+// ---------- 调用与控制流 ----------
+
+static void compile_call(VMCompiler* cx, const IRInstr* instr, const IROperand* args) {
+    int callee = args[0].value;
+    int argc = instr->arg_count - 1;
+    VMFunction* target = &cx->program->functions[callee];
+    bool native = !cx->module->functions[callee].is_defined;
+    if (native && target->param_count > VM_NATIVE_ARGS) {
+        fprintf(cx->err, "VM: 外部函数 %s 的参数超过%d个\n", target->name, VM_NATIVE_ARGS);
+        cx->ok = false;
+        return;
+    }
+    if (native && !target->native) {
+        target->native = dlsym(RTLD_DEFAULT, target->name);
+        if (!target->native) {
+            fprintf(cx->err, "VM: 找不到外部函数 %s\n", target->name);
+            cx->ok = false;
+            return;
+        }
+    }
+
+    for (int i = 0; i < argc; i++) emit_move(cx, cx->temp_base + i, args[1 + i]);
+    reserve_window(cx, cx->temp_base + argc);
+    int dest = instr->dest >= 0 && ir_uses_count(cx->uses, instr->dest) > 0 ? instr->dest : -1;
+    emit(cx, native ? VM_CALLX : VM_CALL, callee, cx->temp_base, dest);
+}
+
+// 对已定义函数的尾调用: 被调用者在当前帧中执行, 不再返回到这里
+static void compile_tail_call(VMCompiler* cx, const IRInstr* instr, const IROperand* args) {
+    int argc = instr->arg_count - 1;
+    for (int i = 0; i < argc; i++) emit_move(cx, cx->temp_base + i, args[1 + i]);
+    reserve_window(cx, cx->temp_base + argc);
+    emit(cx, VM_TAILCALL, args[0].value, cx->temp_base, 0);
+    cx->program->stats.tail_calls++;
+}
+
+// 边 from → to 上phi的并行复制。先做寄存器之间的复制: 目标不再被其他待做复制读取的可以先做,
+// 剩下的都在环上时把一个源暂存到临时寄存器; 常量最后装入
+// 结果写入a字段的指令
+static bool writes_a(uint8_t op) {
+    if (op <= VM_GEI) return true;    // MOV..GEI
+    if (op >= VM_LEAG && op <= VM_LEAPX) return true;
+    return op == VM_LDG || op == VM_LDGX || op == VM_LDL || op == VM_LDLX || op == VM_LDP || op == VM_LDPX;
+}
+
+// 块内最后一条指令的结果只作为某个复制的源时, 让它直接写入复制的目的寄存器并删去该复制。
+// 要求没有别的复制读目的寄存器(它提前被改写), 且该值在phi中只出现一次(其他前驱不经过这条指令)
+static int coalesce_last(VMCompiler* cx, int to, int count) {
+    VMProgram* program = cx->program;
+    if (program->code_count <= cx->block_code) return count;
+    VMInstr* last = &program->code[program->code_count - 1];
+    int32_t value = last->a;
+    if (!writes_a(last->op) || value >= cx->function->vreg_count || ir_uses_count(cx->uses, value) != 1) return count;
+
+    int found = -1;
+    for (int i = 0; i < count; i++) {
+        if (cx->copy_src[i].kind == IR_OPERAND_VREG && cx->copy_src[i].value == value) found = i;
+    }
+    if (found < 0) return count;
+    for (int i = 0; i < count; i++) {
+        if (cx->copy_src[i].kind == IR_OPERAND_VREG && cx->copy_src[i].value == cx->copy_dst[found]) return count;
+    }
+    const IRFunction* function = cx->function;
+    const IRBlock* block = &function->blocks[to];
+    int refs = 0;
+    for (int i = 0; i < block->instr_count; i++) {
+        const IRInstr* phi = &function->instrs[block->instrs[i]];
+        if (phi->op != IR_PHI) break;
+        const IROperand* inputs = &function->operands[phi->args];
+        for (int a = 1; a < phi->arg_count; a += 2) refs += is_vreg(inputs[a], value);
+    }
+    if (refs != 1) return count;
+
+    last->a = cx->copy_dst[found];
+    count--;
+    cx->copy_dst[found] = cx->copy_dst[count];
+    cx->copy_src[found] = cx->copy_src[count];
+    return count;
+}
+
+static void emit_edge_copies(VMCompiler* cx, int from, int to) {
+    IRFunction* function = cx->function;
+    const IRBlock* block = &function->blocks[to];
+    int count = 0;
+    for (int i = 0; i < block->instr_count; i++) {
+        const IRInstr* phi = &function->instrs[block->instrs[i]];
+        if (phi->op != IR_PHI) break;
+        const IROperand* inputs = ir_instr_args(function, phi);
+        for (int a = 0; a + 1 < phi->arg_count; a += 2) {
+            if (inputs[a].value != from) continue;
+            IROperand value = inputs[a + 1];
+            if (phi->dest >= 0 && value.kind != IR_OPERAND_NONE && !is_vreg(value, phi->dest)) {
+                if (count == cx->copy_capacity) {
+                    cx->copy_capacity = cx->copy_capacity ? cx->copy_capacity * 2 : 16;
+                    cx->copy_dst = (int32_t*)realloc(cx->copy_dst, sizeof(int32_t) * (size_t)cx->copy_capacity);
+                    cx->copy_src = (IROperand*)realloc(cx->copy_src, sizeof(IROperand) * (size_t)cx->copy_capacity);
+                    if (!cx->copy_dst || !cx->copy_src) {
+                        perror("malloc failed for VM copies");
+                        exit(1);
+                    }
+                }
+                cx->copy_dst[count] = phi->dest;
+                cx->copy_src[count++] = value;
+            }
+            break;
+        }
+    }
+
+    count = coalesce_last(cx, to, count);
+    int32_t* dst = cx->copy_dst;
+    IROperand* src = cx->copy_src;
+    // 常量复制移到末尾, 前面的pending条都是寄存器之间的复制
+    int pending = 0;
+    for (int i = 0; i < count; i++) {
+        if (src[i].kind != IR_OPERAND_VREG) continue;
+        int32_t d = dst[i];
+        IROperand s = src[i];
+        dst[i] = dst[pending];
+        src[i] = src[pending];
+        dst[pending] = d;
+        src[pending++] = s;
+    }
+    while (pending > 0) {
+        bool progress = false;
+        for (int i = 0; i < pending; i++) {
+            bool read = false;
+            for (int j = 0; j < pending && !read; j++) read = j != i && src[j].value == dst[i];
+            if (read) continue;
+            emit(cx, VM_MOV, dst[i], src[i].value, 0);
+            pending--;
+            dst[i] = dst[pending];
+            src[i] = src[pending];
+            progress = true;
+            i--;
+        }
+        if (progress || pending == 0) continue;
+        int temp = new_temp(cx);
+        int32_t saved = src[0].value;
+        emit(cx, VM_MOV, temp, saved, 0);
+        for (int j = 0; j < pending; j++) {
+            if (src[j].value == saved) src[j].value = temp;
+        }
+    }
+    for (int i = 0; i < count; i++) {
+        if (src[i].kind != IR_OPERAND_VREG) emit_move(cx, dst[i], src[i]);
+    }
+}
+
+// 目标块除phi外只有一条合并进br的比较(如循环头)时, 返回该br, 跳转处可以直接生成比较跳转
+static const IRInstr* threaded_branch(const VMCompiler* cx, int target) {
+    const IRFunction* function = cx->function;
+    const IRBlock* block = &function->blocks[target];
+    int i = 0;
+    while (i < block->instr_count && function->instrs[block->instrs[i]].op == IR_PHI) i++;
+    if (i + 2 != block->instr_count) return NULL;
+    const IRInstr* compare = &function->instrs[block->instrs[i]];
+    if (compare->op < IR_EQ || compare->op > IR_GE || !fuse_with_branch(cx, block, i)) return NULL;
+    return &function->instrs[block->instrs[i + 1]];
+}
+
+static void compile_terminator(VMCompiler* cx, const IRInstr* instr, const IROperand* args, int fused_compare) {
+    switch (instr->op) {
+        case IR_JMP: {
+            // 边上的复制已在跳转前完成, 目标块的phi已是新值
+            const IRInstr* branch = args[0].value != cx->next_block ? threaded_branch(cx, args[0].value) : NULL;
+            if (branch) {
+                const IRFunction* function = cx->function;
+                const IROperand* targets = &function->operands[branch->args];
+                const IRBlock* block = &function->blocks[args[0].value];
+                const IRInstr* compare = &function->instrs[block->instrs[block->instr_count - 2]];
+                emit_compare_branch(cx, compare, targets[1].value, targets[2].value);
+            } else {
+                emit_jump(cx, args[0].value);
+            }
+            break;
+        }
+
+        case IR_BR: {
+            int on_true = args[1].value;
+            int on_false = args[2].value;
+            if (fused_compare >= 0) {
+                emit_compare_branch(cx, &cx->function->instrs[fused_compare], on_true, on_false);
+            } else if (args[0].kind == IR_OPERAND_CONST) {
+                emit_jump(cx, args[0].value ? on_true : on_false);
+            } else if (on_true == cx->next_block) {
+                emit(cx, VM_JZ, args[0].value, on_false, 0);
+            } else {
+                emit(cx, VM_JNZ, args[0].value, on_true, 0);
+                emit_jump(cx, on_false);
+            }
+            break;
+        }
+
+        case IR_RET:
+            emit(cx, VM_RET, instr->arg_count > 0 ? operand_reg(cx, args[0]) : -1, 0, 0);
+            break;
+    }
+}
+
+// 向量指令逐个元素展开为标量字节码; 向量循环的数组都是栈槽或全局变量
+static void compile_vector(VMCompiler* cx, const IRInstr* instr, const IROperand* args) {
+    IROpcode op = (IROpcode)instr->op;
+    int dest = instr->dest >= 0 ? cx->lanes[instr->dest] : -1;
+    if (op == IR_VLOAD || op == IR_VSTORE) {
+        bool global = args[0].kind == IR_OPERAND_GLOBAL;
+        int32_t address = global ? cx->program->global_offsets[args[0].value] : cx->slot_offset[args[0].value];
+        IROperand index = args[op == IR_VLOAD ? 1 : 2];
+        int value = op == IR_VSTORE ? cx->lanes[args[1].value] : dest;
+        for (int k = 0; k < 4; k++) {
+            if (index.kind == IR_OPERAND_CONST && op == IR_VLOAD) {
+                emit(cx, global ? VM_LDG : VM_LDL, value + k, address + index.value + k, 0);
+            } else if (index.kind == IR_OPERAND_CONST) {
+                emit(cx, global ? VM_STG : VM_STL, address + index.value + k, value + k, 0);
+            } else if (op == IR_VLOAD) {
+                emit(cx, global ? VM_LDGX : VM_LDLX, value + k, address + k, index.value);
+            } else {
+                emit(cx, global ? VM_STGX : VM_STLX, address + k, value + k, index.value);
+            }
+        }
+        return;
+    }
+    for (int k = 0; k < 4; k++) {
+        if (op == IR_SPLAT) {
+            emit_move(cx, dest + k, args[0]);
+        } else if (op == IR_SHL || op == IR_SHR) {
+            emit(cx, binary_opcode(op, true), dest + k, cx->lanes[args[0].value] + k, args[1].value);
+        } else {
+            emit(cx, binary_opcode(op, false), dest + k, cx->lanes[args[0].value] + k,
+                 cx->lanes[args[1].value] + k);
+        }
+    }
+}
+
+static void compile_instr(VMCompiler* cx, const IRInstr* instr, const IROperand* args) {
+    if (instr->type == IR_TYPE_V4I32 || instr->op == IR_VSTORE) {
+        compile_vector(cx, instr, args);
+        return;
+    }
+    switch (instr->op) {
+        case IR_ADD: case IR_SUB: case IR_MUL: case IR_DIV: case IR_MOD:
+        case IR_AND: case IR_SHL: case IR_SHR:
+            compile_binary(cx, instr, args);
+            break;
+
+        case IR_NEG:
+            if (args[0].kind == IR_OPERAND_CONST) emit(cx, VM_LOADI, instr->dest, (int32_t)wrap32(-(int64_t)args[0].value), 0);
+            else emit(cx, VM_NEG, instr->dest, args[0].value, 0);
+            break;
+
+        case IR_NOT:
+            if (args[0].kind == IR_OPERAND_CONST) emit(cx, VM_LOADI, instr->dest, args[0].value == 0, 0);
+            else emit(cx, VM_NOT, instr->dest, args[0].value, 0);
+            break;
+
+        case IR_EQ: case IR_NE: case IR_LT: case IR_LE: case IR_GT: case IR_GE:
+            compile_compare(cx, instr, args);
+            break;
+
+        case IR_ZEXT: case IR_COPY:
+            emit_move(cx, instr->dest, args[0]);
+            break;
+
+        case IR_ADDR:
+            emit_addressed(cx, address_ops, instr->dest, args[0], instr->arg_count > 1 ? &args[1] : NULL, false);
+            break;
+
+        case IR_LOAD:
+            if (instr->dest < 0) break;
+            emit_addressed(cx, load_ops, instr->dest, args[0], instr->arg_count > 1 ? &args[1] : NULL, false);
+            break;
+
+        case IR_STORE: {
+            int value = operand_reg(cx, args[1]);
+            emit_addressed(cx, store_ops, value, args[0], instr->arg_count > 2 ? &args[2] : NULL, true);
+            break;
+        }
+
+        case IR_CALL:
+            compile_call(cx, instr, args);
+            break;
+
+        case IR_COUNT:
+            emit(cx, VM_PROFILE, cx->program->global_offsets[args[0].value] + args[1].value, 0, 0);
+            break;
+
+        default:
+            break;
+    }
+}
+
+static void compile_block(VMCompiler* cx, int b) {
+    IRFunction* function = cx->function;
+    const IRBlock* block = &function->blocks[b];
+    cx->block_start[b] = cx->program->code_count;
+    cx->block_code = cx->program->code_count;
+
+    // 关键边已拆分: 唯一前驱有两个后继时, 边上的复制放在本块开头
+    cx->temp_count = 0;
+    if (block->pred_count == 1 && function->blocks[block->preds[0]].succ_count > 1) {
+        emit_edge_copies(cx, block->preds[0], b);
+    }
+
+    // 先找出读-加-写: 被合并的load不单独生成, 在加法处生成超级指令并跳过其后的store
+    for (int i = 0; i < block->instr_count; i++) {
+        cx->update_load[i] = -1;
+        cx->absorbed[i] = false;
+    }
+    for (int i = 0; i < block->instr_count; i++) {
+        int j = match_update(cx, block, i);
+        if (j < 0 || cx->absorbed[j]) continue;
+        cx->update_load[i] = j;
+        cx->absorbed[j] = true;
+    }
+
+    int fused_compare = -1;
+    for (int i = 0; i < block->instr_count; i++) {
+        int id = block->instrs[i];
+        const IRInstr* instr = &function->instrs[id];
+        const IROperand* args = ir_instr_args(function, instr);
+        cx->temp_count = 0;
+        if (ir_opcode_is_terminator((IROpcode)instr->op)) {
+            if (block->succ_count == 1) emit_edge_copies(cx, b, block->succs[0]);
+            cx->temp_count = 0;
+            compile_terminator(cx, instr, args, fused_compare);
+            break;
+        }
+        if (cx->absorbed[i]) continue;
+        if (cx->update_load[i] >= 0) {
+            emit_update(cx, block, cx->update_load[i], i);
+            i++;
+        } else if (instr->op >= IR_EQ && instr->op <= IR_GE && fuse_with_branch(cx, block, i)) {
+            fused_compare = id;
+        } else if (instr->op == IR_CALL && cx->tail_calls && ir_is_tail_call(function, b, i) &&
+                   cx->module->functions[args[0].value].is_defined) {
+            compile_tail_call(cx, instr, args);
+            break;
+        } else {
+            compile_instr(cx, instr, args);
+        }
+    }
+}
+
+static void compile_function(VMCompiler* cx, int index) {
+    IRFunction* function = &cx->module->functions[index];
+    VMFunction* out = &cx->program->functions[index];
+    if (!function->is_defined || function->block_count == 0) return;
+
+    ir_function_split_critical_edges(function);
+    cx->function = function;
+    cx->uses = ir_uses_create(function);
+
+    // 没有提升的栈槽(数组)依次放在局部变量区
+    cx->slot_offset = (int32_t*)vm_alloc(sizeof(int32_t) * (size_t)function->slot_count);
+    for (int i = 0; i < function->slot_count; i++) {
+        const IRSlot* slot = &function->slots[i];
+        cx->slot_offset[i] = slot->promoted ? -1 : out->local_words;
+        if (!slot->promoted) out->local_words += slot->count;
+    }
+
+    cx->tail_calls = !ir_function_takes_slot_address(function);
+    cx->lanes = (int32_t*)vm_alloc(sizeof(int32_t) * (size_t)function->vreg_count);
+    cx->temp_base = function->vreg_count;
+    for (int v = 0; v < function->vreg_count; v++) {
+        if (function->vreg_types[v] != IR_TYPE_V4I32) continue;
+        cx->lanes[v] = cx->temp_base;
+        cx->temp_base += 4;
+    }
+    cx->window = cx->temp_base > function->param_count ? cx->temp_base : function->param_count;
+    cx->block_start = (int32_t*)vm_alloc(sizeof(int32_t) * (size_t)function->block_count);
+    int longest = 0;
+    for (int b = 0; b < function->block_count; b++) {
+        if (function->blocks[b].instr_count > longest) longest = function->blocks[b].instr_count;
+    }
+    cx->update_load = (int32_t*)vm_alloc(sizeof(int32_t) * (size_t)longest);
+    cx->absorbed = (bool*)vm_alloc(sizeof(bool) * (size_t)longest);
+    out->entry = cx->program->code_count;
+
+    for (int b = 0; b < function->block_count; b++) {
+        if (function->blocks[b].instr_count == 0) continue;
+        cx->next_block = -1;
+        for (int next = b + 1; next < function->block_count && cx->next_block < 0; next++) {
+            if (function->blocks[next].instr_count > 0) cx->next_block = next;
+        }
+        compile_block(cx, b);
+    }
+    for (int i = out->entry; i < cx->program->code_count; i++) {
+        int32_t* target = jump_target(&cx->program->code[i]);
+        if (target) *target = cx->block_start[*target];
+    }
+    out->reg_count = cx->window;
+    cx->program->stats.functions++;
+
+    free(cx->absorbed);
+    free(cx->update_load);
+    free(cx->block_start);
+    free(cx->lanes);
+    free(cx->slot_offset);
+    ir_uses_destroy(cx->uses);
+    cx->block_start = NULL;
+    cx->slot_offset = NULL;
+    cx->uses = NULL;
+}
+
+VMProgram* vm_program_create(IRModule* module, FILE* err) {
+    VMProgram* program = (VMProgram*)vm_alloc(sizeof(VMProgram));
+    program->function_count = module->function_count;
+    program->functions = (VMFunction*)vm_alloc(sizeof(VMFunction) * (size_t)module->function_count);
+    program->toplevel = -1;
+    for (int i = 0; i < module->function_count; i++) {
+        const IRFunction* function = &module->functions[i];
+        VMFunction* out = &program->functions[i];
+        out->name = function->name;
+        out->entry = -1;
+        out->param_count = function->param_count;
+        out->return_type = function->return_type;
+        if (function->is_defined && strcmp(function->name, IR_TOPLEVEL_NAME) == 0) program->toplevel = i;
+    }
+
+    // 全局变量区, 标量的初值直接写入。单独映射而不用malloc, 使它和JIT的代码页同在映射区,
+    // 本机代码能用rip相对的32位位移访问(见jit_program_create_linked)
+    program->global_offsets = (int32_t*)vm_alloc(sizeof(int32_t) * (size_t)module->global_count);
+    for (int i = 0; i < module->global_count; i++) {
+        program->global_offsets[i] = program->global_words;
+        program->global_words += module->globals[i].count;
+    }
+    program->global_size = sizeof(int32_t) * (size_t)(program->global_words > 0 ? program->global_words : 1);
+    void* globals = mmap(NULL, program->global_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (globals == MAP_FAILED) {
+        perror("mmap failed for VM globals");
+        exit(1);
+    }
+    program->globals = (int32_t*)globals;
+    for (int i = 0; i < module->global_count; i++) {
+        if (module->globals[i].count == 1) program->globals[program->global_offsets[i]] = module->globals[i].init;
+    }
+
+    VMCompiler cx;
+    memset(&cx, 0, sizeof(cx));
+    cx.program = program;
+    cx.module = module;
+    cx.err = err;
+    cx.ok = true;
+    for (int i = 0; i < module->function_count && cx.ok; i++) {
+        compile_function(&cx, i);
+    }
+    free(cx.copy_dst);
+    free(cx.copy_src);
+    program->stats.instrs = program->code_count;
+    if (!cx.ok) {
+        vm_program_destroy(program);
+        return NULL;
+    }
+    return program;
+}
+
+void vm_program_destroy(VMProgram* program) {
+    if (!program) return;
+    free(program->code);
+    free(program->functions);
+    if (program->globals) munmap(program->globals, program->global_size);
+    free(program->global_offsets);
+    free(program->registers);
+    free(program->locals);
+    free(program->frames);
+    free(program);
+}
+
+void vm_program_set_tiering(VMProgram* program, uint32_t calls, uint32_t loops,
+                            VMTierRequest request, void* context) {
+    program->tier_calls = calls;
+    program->tier_loops = loops;
+    program->tier_request = request;
+    program->tier_context = context;
+}
+
+int vm_program_lookup(const VMProgram* program, const char* name) {
+    for (int i = 0; i < program->function_count; i++) {
+        if (strcmp(program->functions[i].name, name) == 0) return i;
+    }
+    return -1;
+}
+
+// ========== 解释执行 ==========
+
+// 计数恰好到达阈值(不为0)时请求编译
+#define VM_COUNT(counter, limit, function) \
+    if (++(counter) == (limit) && (limit) != 0 && program->tier_request) \
+        program->tier_request(program->tier_context, (int)((function) - functions))
+
+static bool vm_execute(VMProgram* program, int function, const int64_t* args, int64_t* result, FILE* err) {
+    const VMInstr* code = program->code;
+    VMFunction* functions = program->functions;
+    int32_t* G = program->globals;
+    VMFrame* frame = program->frames;
+    VMFrame* frame_end = program->frames + VM_FRAME_LIMIT;
+    int64_t* register_end = program->registers + VM_REGISTER_WORDS;
+    int32_t* local_end = program->locals + VM_LOCAL_WORDS;
+    const uint32_t tier_calls = program->tier_calls;
+    const uint32_t tier_loops = program->tier_loops;
+
+    VMFunction* self = &functions[function];
+    VM_COUNT(self->calls, tier_calls, self);
+    void* compiled = atomic_load_explicit(&self->compiled, memory_order_acquire);
+    if (compiled) {
+        *result = call_native(compiled, args, self->param_count, self->return_type);
+        return true;
+    }
+    int64_t* R = program->registers;
+    int32_t* L = program->locals;
+    int64_t ret_value;      // 返回值(RET和调用本机代码的TAILCALL)
+    int32_t* local_top = L + self->local_words;
+    if (R + self->reg_count > register_end || local_top > local_end) goto stack_overflow;
+    for (int i = 0; i < self->param_count; i++) R[i] = args[i];
+    const VMInstr* ip = code + self->entry;
+
+#ifdef VM_COMPUTED_GOTO
+#define VM_LABEL_ADDRESS(name) &&op_##name,
+    static const void* const dispatch[VM_OPCODE_COUNT] = { VM_OPCODES(VM_LABEL_ADDRESS) };
+#undef VM_LABEL_ADDRESS
+#define CASE(name) op_##name:
+#define DISPATCH() goto *dispatch[ip->op]
+    DISPATCH();
+#else
+#define CASE(name) case VM_##name:
+#define DISPATCH() continue
+    for (;;) {
+        switch ((VMOpcode)ip->op) {
+#endif
+
+#define BINARY(name, expr) \
+    CASE(name) { int64_t x = R[ip->b], y = R[ip->c]; R[ip->a] = (expr); ip++; DISPATCH(); }
+#define BINARY_IMM(name, expr) \
+    CASE(name) { int64_t x = R[ip->b], y = ip->c; R[ip->a] = (expr); ip++; DISPATCH(); }
+// 跳转目标不在当前指令之后的是循环回边
+#define JUMP(target) do { \
+        const VMInstr* to = (target); \
+        if (to <= ip) { VM_COUNT(self->loops, tier_loops, self); } \
+        ip = to; \
+    } while (0)
+#define BRANCH(name, cmp) \
+    CASE(name) { if (R[ip->a] cmp R[ip->b]) JUMP(code + ip->c); else ip++; DISPATCH(); }
+#define BRANCH_IMM(name, cmp) \
+    CASE(name) { if (R[ip->a] cmp (int64_t)ip->b) JUMP(code + ip->c); else ip++; DISPATCH(); }
+#define POINTER(reg) ((int32_t*)(intptr_t)(reg))
+#define ADDRESS(ptr) ((int64_t)(intptr_t)(ptr))
+
+    CASE(MOV)   R[ip->a] = R[ip->b]; ip++; DISPATCH();
+    CASE(LOADI) R[ip->a] = ip->b; ip++; DISPATCH();
+
+    // int按32位回绕, 与本机代码一致; 移位数取低5位
+    BINARY(ADD, wrap32(x + y))
+    BINARY(SUB, wrap32(x - y))
+    BINARY(MUL, wrap32(x * y))
+    BINARY(AND, x & y)
+    BINARY(SHL, (int32_t)((uint32_t)x << (y & 31)))
+    BINARY(SHR, (int32_t)x >> (y & 31))
+    BINARY_IMM(ADDI, wrap32(x + y))
+    BINARY_IMM(SUBI, wrap32(x - y))
+    BINARY_IMM(MULI, wrap32(x * y))
+    BINARY_IMM(ANDI, x & y)
+    BINARY_IMM(SHLI, (int32_t)((uint32_t)x << (y & 31)))
+    BINARY_IMM(SHRI, (int32_t)x >> (y & 31))
+    BINARY_IMM(DIVI, wrap32(x / y))
+    BINARY_IMM(MODI, x % y)
+
+    // 在64位中计算, INT_MIN / -1回绕为INT_MIN, 余数为0
+    CASE(DIV) {
+        int64_t y = R[ip->c];
+        if (y == 0) goto divide_by_zero;
+        R[ip->a] = wrap32(R[ip->b] / y);
+        ip++;
+        DISPATCH();
+    }
+    CASE(MOD) {
+        int64_t y = R[ip->c];
+        if (y == 0) goto divide_by_zero;
+        R[ip->a] = R[ip->b] % y;
+        ip++;
+        DISPATCH();
+    }
+
+    CASE(NEG) R[ip->a] = wrap32(-R[ip->b]); ip++; DISPATCH();
+    CASE(NOT) R[ip->a] = R[ip->b] == 0; ip++; DISPATCH();
+
+    BINARY(EQ, x == y)
+    BINARY(NE, x != y)
+    BINARY(LT, x < y)
+    BINARY(LE, x <= y)
+    BINARY(GT, x > y)
+    BINARY(GE, x >= y)
+    BINARY_IMM(EQI, x == y)
+    BINARY_IMM(NEI, x != y)
+    BINARY_IMM(LTI, x < y)
+    BINARY_IMM(LEI, x <= y)
+    BINARY_IMM(GTI, x > y)
+    BINARY_IMM(GEI, x >= y)
+
+    CASE(JMP) JUMP(code + ip->a); DISPATCH();
+    CASE(JZ)  if (R[ip->a] == 0) JUMP(code + ip->b); else ip++; DISPATCH();
+    CASE(JNZ) if (R[ip->a] != 0) JUMP(code + ip->b); else ip++; DISPATCH();
+    BRANCH(JEQ, ==)
+    BRANCH(JNE, !=)
+    BRANCH(JLT, <)
+    BRANCH(JLE, <=)
+    BRANCH(JGT, >)
+    BRANCH(JGE, >=)
+    BRANCH_IMM(JEQI, ==)
+    BRANCH_IMM(JNEI, !=)
+    BRANCH_IMM(JLTI, <)
+    BRANCH_IMM(JLEI, <=)
+    BRANCH_IMM(JGTI, >)
+    BRANCH_IMM(JGEI, >=)
+
+    CASE(LDG)  R[ip->a] = G[ip->b]; ip++; DISPATCH();
+    CASE(LDGX) R[ip->a] = G[ip->b + R[ip->c]]; ip++; DISPATCH();
+    CASE(STG)  G[ip->a] = R[ip->b]; ip++; DISPATCH();
+    CASE(STGX) G[ip->a + R[ip->c]] = R[ip->b]; ip++; DISPATCH();
+    CASE(LDL)  R[ip->a] = L[ip->b]; ip++; DISPATCH();
+    CASE(LDLX) R[ip->a] = L[ip->b + R[ip->c]]; ip++; DISPATCH();
+    CASE(STL)  L[ip->a] = R[ip->b]; ip++; DISPATCH();
+    CASE(STLX) L[ip->a + R[ip->c]] = R[ip->b]; ip++; DISPATCH();
+    CASE(LDP)  R[ip->a] = POINTER(R[ip->b])[ip->c]; ip++; DISPATCH();
+    CASE(LDPX) R[ip->a] = POINTER(R[ip->b])[R[ip->c]]; ip++; DISPATCH();
+    CASE(STP)  POINTER(R[ip->a])[ip->c] = R[ip->b]; ip++; DISPATCH();
+    CASE(STPX) POINTER(R[ip->a])[R[ip->c]] = R[ip->b]; ip++; DISPATCH();
+    CASE(LEAG)  R[ip->a] = ADDRESS(G + ip->b); ip++; DISPATCH();
+    CASE(LEAGX) R[ip->a] = ADDRESS(G + ip->b + R[ip->c]); ip++; DISPATCH();
+    CASE(LEAL)  R[ip->a] = ADDRESS(L + ip->b); ip++; DISPATCH();
+    CASE(LEALX) R[ip->a] = ADDRESS(L + ip->b + R[ip->c]); ip++; DISPATCH();
+    CASE(LEAP)  R[ip->a] = ADDRESS(POINTER(R[ip->b]) + ip->c); ip++; DISPATCH();
+    CASE(LEAPX) R[ip->a] = ADDRESS(POINTER(R[ip->b]) + R[ip->c]); ip++; DISPATCH();
+
+    CASE(ADDG) {
+        int64_t value = wrap32(G[ip->a] + R[ip->b]);
+        G[ip->a] = value;
+        R[ip->c] = value;
+        ip++;
+        DISPATCH();
+    }
+    CASE(ADDGI) {
+        int64_t value = wrap32(G[ip->a] + ip->b);
+        G[ip->a] = value;
+        R[ip->c] = value;
+        ip++;
+        DISPATCH();
+    }
+    CASE(ADDGX) {
+        int32_t* cell = G + ip->a + R[ip->b];
+        *cell = wrap32(*cell + R[ip->c]);
+        ip++;
+        DISPATCH();
+    }
+    CASE(ADDLX) {
+        int32_t* cell = L + ip->a + R[ip->b];
+        *cell = wrap32(*cell + R[ip->c]);
+        ip++;
+        DISPATCH();
+    }
+    CASE(PROFILE) {
+        uint64_t counter;
+        memcpy(&counter, G + ip->a, sizeof(counter));
+        counter++;
+        memcpy(G + ip->a, &counter, sizeof(counter));
+        ip++;
+        DISPATCH();
+    }
+
+    // 被调用者的窗口从实参区开始, 局部变量区接在调用者之后
+    CASE(CALL) {
+        VMFunction* callee = &functions[ip->a];
+        VM_COUNT(callee->calls, tier_calls, callee);
+        void* entry = atomic_load_explicit(&callee->compiled, memory_order_acquire);
+        if (entry) {
+            int64_t value = call_native(entry, R + ip->b, callee->param_count, callee->return_type);
+            if (ip->c >= 0) R[ip->c] = value;
+            ip++;
+            DISPATCH();
+        }
+        int64_t* callee_regs = R + ip->b;
+        if (frame == frame_end || callee_regs + callee->reg_count > register_end ||
+            local_top + callee->local_words > local_end) {
+            goto stack_overflow;
+        }
+        frame->ip = ip + 1;
+        frame->regs = R;
+        frame->locals = L;
+        frame->dest = ip->c;
+        frame->function = self;
+        frame++;
+        self = callee;
+        R = callee_regs;
+        L = local_top;
+        local_top = L + callee->local_words;
+        ip = code + callee->entry;
+        DISPATCH();
+    }
+    CASE(CALLX) {
+        const VMFunction* callee = &functions[ip->a];
+        int64_t value = call_native(callee->native, R + ip->b, callee->param_count, callee->return_type);
+        if (ip->c >= 0) R[ip->c] = value;
+        ip++;
+        DISPATCH();
+    }
+    // 实参区在形参之后, 从前往后复制不会覆盖还没读的实参
+    CASE(TAILCALL) {
+        VMFunction* callee = &functions[ip->a];
+        VM_COUNT(callee->calls, tier_calls, callee);
+        void* entry = atomic_load_explicit(&callee->compiled, memory_order_acquire);
+        if (entry) {
+            ret_value = call_native(entry, R + ip->b, callee->param_count, callee->return_type);
+            goto return_value;
+        }
+        if (R + callee->reg_count > register_end || L + callee->local_words > local_end) goto stack_overflow;
+        for (int i = 0; i < callee->param_count; i++) R[i] = R[ip->b + i];
+        self = callee;
+        local_top = L + callee->local_words;
+        ip = code + callee->entry;
+        DISPATCH();
+    }
+    CASE(RET) {
+        ret_value = ip->a >= 0 ? R[ip->a] : 0;
+    return_value:
+        if (frame == program->frames) {
+            *result = ret_value;
+            return true;
+        }
+        frame--;
+        local_top = L;
+        ip = frame->ip;
+        R = frame->regs;
+        L = frame->locals;
+        self = frame->function;
+        if (frame->dest >= 0) R[frame->dest] = ret_value;
+        DISPATCH();
+    }
+
+#ifndef VM_COMPUTED_GOTO
+        default:
+            fprintf(err, "VM: 无效的字节码 %d\n", ip->op);
+            return false;
+        }
+    }
+#endif
+#undef BINARY
+#undef BINARY_IMM
+#undef JUMP
+#undef BRANCH
+#undef BRANCH_IMM
+#undef POINTER
+#undef ADDRESS
+#undef CASE
+#undef DISPATCH
+
+divide_by_zero:
+    fprintf(err, "VM: 除数为0(函数 %s)\n", self->name);
+    return false;
+stack_overflow:
+    fprintf(err, "VM: 调用栈溢出(函数 %s)\n", self->name);
+    return false;
+}
+
+#undef VM_COUNT
+
+bool vm_program_call(VMProgram* program, int function, const int64_t* args, int64_t* result, FILE* err) {
+    if (function < 0 || function >= program->function_count || program->functions[function].entry < 0) {
+        fprintf(err, "VM: 函数没有定义\n");
+        return false;
+    }
+    if (!program->registers) {
+        program->registers = (int64_t*)vm_alloc(sizeof(int64_t) * VM_REGISTER_WORDS);
+        program->locals = (int32_t*)vm_alloc(sizeof(int32_t) * VM_LOCAL_WORDS);
+        program->frames = (VMFrame*)vm_alloc(sizeof(VMFrame) * VM_FRAME_LIMIT);
+    }
+    *result = 0;
+    return vm_execute(program, function, args, result, err);
+}
+
+bool vm_program_run(VMProgram* program, int* status, FILE* err) {
+    int entry = vm_program_lookup(program, "main");
+    if (entry < 0 || program->functions[entry].entry < 0) {
+        fprintf(err, "VM: 没有main函数\n");
+        return false;
+    }
+    int64_t result = 0;
+    if (program->toplevel >= 0 && !vm_program_call(program, program->toplevel, NULL, &result, err)) {
+        return false;
+    }
+    if (!vm_program_call(program, entry, NULL, &result, err)) return false;
+    *status = (int)result;
+    return true;
+}
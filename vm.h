@@ -0,0 +1,147 @@
+#ifndef VM_H
+#define VM_H
+
+#include <stdatomic.h>
+#include <stdio.h>
+#include "ir.h"
+
+// ========== 寄存器字节码虚拟机 ==========
+//
+// 把SSA形式的IR编译成紧凑的寄存器字节码解释执行, 不依赖目标机器, 也是与本机代码(jit.h)对比的基线。
+// 每个函数有一个int64寄存器窗口: %N就是N号寄存器, 之后是临时寄存器;
+// 调用前实参复制到调用者窗口末尾的连续寄存器, 被调用者的窗口从那里开始, 形参正好是0..n-1号。
+// 调用用显式的帧栈而不是C递归; 分派在GCC/Clang下用 goto *dispatch[op], 其他编译器退回switch。
+// 内存与本机代码相同: 全局变量和没有提升的栈槽(数组)的元素都是4字节的int, 指针是宿主地址;
+// 全局变量区单独mmap, 分层执行(tiered.h)时编译出的本机代码直接读写同一块内存。
+// 超级指令: 只被紧随其后的br使用的比较合并为比较跳转(跳到循环头的jmp直接生成循环头的比较跳转),
+// 同一内存位置的 load → add → store 合并为一条读-加-写指令。
+//
+// 操作数约定(R[x]是寄存器, 立即数直接存放在字段中, 跳转目标是code中的下标):
+//   MOV a←R[b]          LOADI a←b
+//   ADD..SHR a←R[b] op R[c]          ADDI..MODI a←R[b] op c(DIVI/MODI的c不为0)
+//   NEG/NOT a←op R[b]   EQ..GE a←R[b] cmp R[c]   EQI..GEI a←R[b] cmp c
+//   JMP a   JZ/JNZ R[a], b   JEQ..JGE R[a] cmp R[b], c   JEQI..JGEI R[a] cmp b, c
+//   LDG a←G[b]  LDGX a←G[b+R[c]]  STG G[a]←R[b]  STGX G[a+R[c]]←R[b]    (G: 全局变量区)
+//   LDL/LDLX/STL/STLX 同上, 基址是当前帧的局部变量区
+//   LDP a←R[b][c]  LDPX a←R[b][R[c]]  STP R[a][c]←R[b]  STPX R[a][R[c]]←R[b]
+//   LEAG/LEAGX/LEAL/LEALX/LEAP/LEAPX 与对应的读取相同, 但得到元素地址
+//   ADDG R[c]←G[a]+=R[b]  ADDGI R[c]←G[a]+=b  ADDGX G[a+R[b]]+=R[c]  ADDLX L[a+R[b]]+=R[c]
+//   PROFILE G[a..a+1]作为64位计数器加1(profile插桩的count, 见profile.h)
+//   CALL/CALLX 函数a, 实参从R[b]开始, 结果写入R[c](-1表示丢弃)   RET R[a](-1表示没有返回值)
+//   TAILCALL 函数a, 实参从R[b]开始: 尾调用, 实参移到R[0..n)后在当前帧中执行被调用者(复用寄存器窗口和
+//            局部变量区), 被调用者的返回值就是当前帧的返回值; 取了栈槽地址的函数不生成
+//
+// 分层执行的计数: 每次调用(CALL、TAILCALL和vm_program_call)累加被调用者的calls,
+// 每次跳向前面(跳转目标不在当前指令之后, 即循环回边)累加当前函数的loops;
+// 任一计数恰好到达阈值时调用一次tier_request。函数的compiled被设置后,
+// 之后对它的调用改为按本机调用约定直接调用这个入口(已经在执行的不受影响)。
+
+#define VM_OPCODES(X) \
+    X(MOV) X(LOADI) \
+    X(ADD) X(SUB) X(MUL) X(DIV) X(MOD) X(AND) X(SHL) X(SHR) \
+    X(ADDI) X(SUBI) X(MULI) X(ANDI) X(SHLI) X(SHRI) X(DIVI) X(MODI) \
+    X(NEG) X(NOT) \
+    X(EQ) X(NE) X(LT) X(LE) X(GT) X(GE) \
+    X(EQI) X(NEI) X(LTI) X(LEI) X(GTI) X(GEI) \
+    X(JMP) X(JZ) X(JNZ) \
+    X(JEQ) X(JNE) X(JLT) X(JLE) X(JGT) X(JGE) \
+    X(JEQI) X(JNEI) X(JLTI) X(JLEI) X(JGTI) X(JGEI) \
+    X(LDG) X(LDGX) X(STG) X(STGX) \
+    X(LDL) X(LDLX) X(STL) X(STLX) \
+    X(LDP) X(LDPX) X(STP) X(STPX) \
+    X(LEAG) X(LEAGX) X(LEAL) X(LEALX) X(LEAP) X(LEAPX) \
+    X(ADDG) X(ADDGI) X(ADDGX) X(ADDLX) X(PROFILE) \
+    X(CALL) X(CALLX) X(TAILCALL) X(RET)
+
+// 按本机调用约定调用的函数(外部函数和编译好的函数)最多8个参数(前6个经寄存器传递, 其余在栈上)
+#define VM_NATIVE_ARGS 8
+
+#define VM_OPCODE_ENUM(name) VM_##name,
+typedef enum {
+    VM_OPCODES(VM_OPCODE_ENUM)
+    VM_OPCODE_COUNT
+} VMOpcode;
+#undef VM_OPCODE_ENUM
+
+typedef struct VMInstr {
+    uint8_t op;         // VMOpcode
+    int32_t a, b, c;
+} VMInstr;
+
+typedef struct VMFunction {
+    const char* name;
+    int32_t entry;          // 第一条指令在code中的下标, 没有定义的函数为-1
+    int32_t param_count;
+    int32_t reg_count;      // 寄存器窗口的大小(虚拟寄存器 + 临时寄存器/实参区)
+    int32_t local_words;    // 没有提升的栈槽占的元素个数
+    uint8_t return_type;
+    void* native;           // 被调用的外部函数: 按名字用dlsym找到的地址
+
+    uint32_t calls;         // 调用次数
+    uint32_t loops;         // 执行的循环回边数
+    _Atomic(void*) compiled; // 编译好的本机代码入口, 由其他线程发布; NULL表示解释执行
+} VMFunction;
+
+typedef struct VMStats {
+    int functions;          // 编译的函数个数
+    int instrs;             // 字节码指令条数
+    int fused_branches;     // 比较跳转超级指令
+    int fused_updates;      // 读-加-写超级指令
+    int tail_calls;         // 尾调用
+} VMStats;
+
+struct VMFrame;
+
+// 计数到达阈值时的回调, 在执行字节码的线程中调用
+typedef void (*VMTierRequest)(void* context, int function);
+
+typedef struct VMProgram {
+    VMInstr* code;
+    int code_count;
+    int code_capacity;
+
+    VMFunction* functions;  // 与IR函数一一对应
+    int function_count;
+    int toplevel;           // __toplevel的函数编号, -1表示没有顶层语句
+
+    int32_t* globals;       // 全局变量区(mmap得到)
+    int32_t* global_offsets; // IR全局变量 → 第一个元素的下标
+    int global_words;       // 全局变量区的元素个数
+    size_t global_size;     // 映射的长度
+
+    VMStats stats;
+
+    // 分层执行, tier_request为NULL时只计数
+    uint32_t tier_calls;    // 调用次数的阈值, 0表示不按调用次数
+    uint32_t tier_loops;    // 循环回边数的阈值, 0表示不按循环
+    VMTierRequest tier_request;
+    void* tier_context;
+
+    // 运行时栈, 第一次执行时分配
+    int64_t* registers;
+    int32_t* locals;
+    struct VMFrame* frames;
+} VMProgram;
+
+// 编译模块中定义的全部函数; 会拆分IR中的关键边(见ir_function_split_critical_edges)。
+// 被调用的外部函数找不到时把原因写到err并返回NULL
+VMProgram* vm_program_create(IRModule* module, FILE* err);
+void vm_program_destroy(VMProgram* program);
+
+// 设置分层执行的阈值和回调
+void vm_program_set_tiering(VMProgram* program, uint32_t calls, uint32_t loops,
+                            VMTierRequest request, void* context);
+
+// 按名字查找函数编号, 找不到返回-1
+int vm_program_lookup(const VMProgram* program, const char* name);
+
+// 以args为实参执行函数, 返回值写入result(void函数为0);
+// 运行时错误(除数为0、调用栈溢出)写到err并返回false; 已经编译为本机代码的函数直接调用
+bool vm_program_call(VMProgram* program, int function, const int64_t* args, int64_t* result, FILE* err);
+
+// 先执行顶层语句再调用main, main的返回值写入status
+bool vm_program_run(VMProgram* program, int* status, FILE* err);
+
+const char* vm_opcode_name(VMOpcode op);
+
+#endif // VM_H
@@ -0,0 +1,35 @@
+#include "x86_64.h"
+
+const char* const x86_reg_names64[X86_REG_COUNT] = {
+    "rax", "rcx", "rdx", "rbx", "rsp", "rbp", "rsi", "rdi",
+    "r8", "r9", "r10", "r11", "r12", "r13", "r14", "r15"
+};
+
+const char* const x86_reg_names32[X86_REG_COUNT] = {
+    "eax", "ecx", "edx", "ebx", "esp", "ebp", "esi", "edi",
+    "r8d", "r9d", "r10d", "r11d", "r12d", "r13d", "r14d", "r15d"
+};
+
+const char* const x86_reg_names8[X86_REG_COUNT] = {
+    "al", "cl", "dl", "bl", "spl", "bpl", "sil", "dil",
+    "r8b", "r9b", "r10b", "r11b", "r12b", "r13b", "r14b", "r15b"
+};
+
+const int8_t x86_arg_regs[X86_ARG_REG_COUNT] = {
+    X86_RDI, X86_RSI, X86_RDX, X86_RCX, X86_R8, X86_R9
+};
+
+// 不跨调用的区间优先用调用者保存的寄存器, 省去序言中的保存和恢复
+static const int8_t allocatable[] = {
+    X86_RCX, X86_RSI, X86_RDI, X86_R8, X86_R9,
+    X86_RBX, X86_R12, X86_R13, X86_R14, X86_R15
+};
+
+const IRRegTarget x86_64_target = {
+    (int)(sizeof(allocatable) / sizeof(allocatable[0])),
+    allocatable,
+    (1u << X86_RBX) | (1u << X86_RBP) | (1u << X86_R12) | (1u << X86_R13) |
+        (1u << X86_R14) | (1u << X86_R15),
+    X86_R10,
+    x86_reg_names64
+};
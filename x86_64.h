@@ -0,0 +1,30 @@
+#ifndef X86_64_H
+#define X86_64_H
+
+#include "ir_regalloc.h"
+
+// ========== x86-64 目标描述 ==========
+//
+// 寄存器按机器编码编号。按SysV ABI: rbx、rbp、r12-r15由被调用者保存,
+// 参数依次用rdi、rsi、rdx、rcx、r8、r9传递, 返回值在rax。
+// rax/rdx(除法、返回值)、r10(并行复制的环)、r11(溢出操作数的临时寄存器)
+// 以及rsp/rbp不参与分配。
+
+typedef enum {
+    X86_RAX, X86_RCX, X86_RDX, X86_RBX, X86_RSP, X86_RBP, X86_RSI, X86_RDI,
+    X86_R8, X86_R9, X86_R10, X86_R11, X86_R12, X86_R13, X86_R14, X86_R15,
+    X86_REG_COUNT
+} X86Reg;
+
+#define X86_ARG_REG_COUNT 6
+
+// xmm0-xmm15只存放向量循环体中的v4i32值(不跨基本块), 按SysV ABI都由调用者保存
+#define X86_XMM_COUNT 16
+
+extern const IRRegTarget x86_64_target;
+extern const int8_t x86_arg_regs[X86_ARG_REG_COUNT];
+extern const char* const x86_reg_names64[X86_REG_COUNT];
+extern const char* const x86_reg_names32[X86_REG_COUNT];
+extern const char* const x86_reg_names8[X86_REG_COUNT];
+
+#endif // X86_64_H
@@ -0,0 +1,255 @@
+#include "x86_asm.h"
+
+static const char* const cond_names[16] = {
+    "o", "no", "b", "ae", "e", "ne", "be", "a", "s", "ns", "p", "np", "l", "ge", "le", "g"
+};
+
+static char size_suffix(int size) {
+    switch (size) {
+        case 1:  return 'b';
+        case 8:  return 'q';
+        default: return 'l';
+    }
+}
+
+static void emit_reg(OutBuf* out, int reg, int size) {
+    outbuf_putc(out, '%');
+    switch (size) {
+        case 1:  outbuf_puts(out, x86_reg_names8[reg]); break;
+        case 8:  outbuf_puts(out, x86_reg_names64[reg]); break;
+        case 16: outbuf_puts(out, "xmm"); outbuf_int(out, reg); break;
+        default: outbuf_puts(out, x86_reg_names32[reg]); break;
+    }
+}
+
+static void emit_label(OutBuf* out, const X86Function* function, int label) {
+    outbuf_puts(out, ".L");
+    outbuf_int(out, function->ir_index);
+    outbuf_putc(out, '_');
+    outbuf_int(out, label);
+}
+
+static void emit_operand(OutBuf* out, const X86Module* module, const X86Function* function,
+                         const X86Operand* operand, int size) {
+    switch (operand->kind) {
+        case X86_OPERAND_REG:
+            emit_reg(out, operand->reg, size);
+            break;
+
+        case X86_OPERAND_IMM:
+            outbuf_putc(out, '$');
+            outbuf_int(out, operand->value);
+            break;
+
+        case X86_OPERAND_MEM:
+            if (operand->base_kind == X86_BASE_GLOBAL) {
+                outbuf_puts(out, module->ir->globals[operand->object].name);
+                if (operand->value > 0) outbuf_putc(out, '+');
+                if (operand->value != 0) outbuf_int(out, operand->value);
+                outbuf_puts(out, "(%rip)");
+                break;
+            }
+            if (operand->base_kind == X86_BASE_FRAME) {
+                outbuf_int(out, function->objects[operand->object].offset + operand->value);
+                outbuf_puts(out, "(%rbp");
+            } else {
+                if (operand->value != 0) outbuf_int(out, operand->value);
+                outbuf_putc(out, '(');
+                emit_reg(out, operand->reg, 8);
+            }
+            if (operand->index >= 0) {
+                outbuf_putc(out, ',');
+                emit_reg(out, operand->index, 8);
+                outbuf_putc(out, ',');
+                outbuf_int(out, operand->scale);
+            }
+            outbuf_putc(out, ')');
+            break;
+
+        case X86_OPERAND_LABEL:
+            emit_label(out, function, operand->value);
+            break;
+
+        case X86_OPERAND_FUNC: {
+            const IRFunction* callee = &module->ir->functions[operand->value];
+            outbuf_puts(out, callee->name);
+            if (!callee->is_defined) outbuf_puts(out, "@PLT");
+            break;
+        }
+    }
+}
+
+static void emit_instr(OutBuf* out, const X86Module* module, const X86Function* function,
+                       const X86Instr* instr) {
+    X86Opcode op = (X86Opcode)instr->op;
+    if (op == X86_LABEL) {
+        emit_label(out, function, instr->dst.value);
+        outbuf_puts(out, ":\n");
+        return;
+    }
+
+    outbuf_putc(out, '\t');
+    outbuf_puts(out, x86_opcode_name(op));
+    switch (op) {
+        case X86_MOVZX8:
+            outbuf_putc(out, '\t');
+            emit_operand(out, module, function, &instr->src, 1);
+            outbuf_putc(out, ',');
+            emit_operand(out, module, function, &instr->dst, 4);
+            break;
+
+        case X86_MOVSXD:
+            outbuf_putc(out, '\t');
+            emit_operand(out, module, function, &instr->src, 4);
+            outbuf_putc(out, ',');
+            emit_operand(out, module, function, &instr->dst, 8);
+            break;
+
+        case X86_SHL: case X86_SAR:
+            // 移位数不是立即数时在cl中
+            outbuf_putc(out, size_suffix(instr->size));
+            outbuf_putc(out, '\t');
+            emit_operand(out, module, function, &instr->src, 1);
+            outbuf_putc(out, ',');
+            emit_operand(out, module, function, &instr->dst, instr->size);
+            break;
+
+        case X86_SETCC:
+        case X86_JCC:
+            outbuf_puts(out, cond_names[instr->cond & 15]);
+            outbuf_putc(out, '\t');
+            emit_operand(out, module, function, &instr->dst, 1);
+            break;
+
+        case X86_CALL: case X86_JMP:
+            outbuf_putc(out, '\t');
+            emit_operand(out, module, function, &instr->dst, 8);
+            break;
+
+        // 尾调用一律经@PLT: 否则as会把跳到同一文件中函数的jmp改为短跳转, 与直接编码的结果不同
+        case X86_TAILJMP:
+            outbuf_putc(out, '\t');
+            emit_operand(out, module, function, &instr->dst, 8);
+            if (module->ir->functions[instr->dst.value].is_defined) outbuf_puts(out, "@PLT");
+            break;
+
+        case X86_NEG: case X86_IDIV: case X86_PUSH: case X86_POP:
+            outbuf_putc(out, size_suffix(instr->size));
+            outbuf_putc(out, '\t');
+            emit_operand(out, module, function, &instr->dst, instr->size);
+            break;
+
+        case X86_CDQ: case X86_RET:
+            break;
+
+        // SSE2指令的名字不带宽度后缀
+        case X86_MOVD:
+            outbuf_putc(out, '\t');
+            emit_operand(out, module, function, &instr->src, 4);
+            outbuf_putc(out, ',');
+            emit_operand(out, module, function, &instr->dst, 16);
+            break;
+
+        case X86_PSHUFD:
+            outbuf_puts(out, "\t$0,");
+            emit_operand(out, module, function, &instr->src, 16);
+            outbuf_putc(out, ',');
+            emit_operand(out, module, function, &instr->dst, 16);
+            break;
+
+        case X86_MOVDQU: case X86_MOVDQA: case X86_PADDD: case X86_PSUBD: case X86_PAND:
+        case X86_PSLLD: case X86_PSRAD:
+            outbuf_putc(out, '\t');
+            emit_operand(out, module, function, &instr->src, 16);
+            outbuf_putc(out, ',');
+            emit_operand(out, module, function, &instr->dst, 16);
+            break;
+
+        default:
+            outbuf_putc(out, size_suffix(instr->size));
+            outbuf_putc(out, '\t');
+            emit_operand(out, module, function, &instr->src, instr->size);
+            outbuf_putc(out, ',');
+            emit_operand(out, module, function, &instr->dst, instr->size);
+            break;
+    }
+    outbuf_putc(out, '\n');
+}
+
+// "\t指令\t名字", 行尾由调用者补上
+static void emit_directive(OutBuf* out, const char* directive, const char* name) {
+    outbuf_putc(out, '\t');
+    outbuf_puts(out, directive);
+    outbuf_putc(out, '\t');
+    outbuf_puts(out, name);
+}
+
+static void emit_function(OutBuf* out, const X86Module* module, const X86Function* function) {
+    if (function->is_global) {
+        emit_directive(out, ".globl", function->name);
+        outbuf_putc(out, '\n');
+    }
+    emit_directive(out, ".type", function->name);
+    outbuf_puts(out, ", @function\n");
+    outbuf_puts(out, function->name);
+    outbuf_puts(out, ":\n");
+    for (int i = 0; i < function->instr_count; i++) {
+        emit_instr(out, module, function, &function->instrs[i]);
+    }
+    emit_directive(out, ".size", function->name);
+    outbuf_puts(out, ", .-");
+    outbuf_puts(out, function->name);
+    outbuf_putc(out, '\n');
+}
+
+// 有非0初值的标量放在.data, 其余放在.bss
+static void emit_globals(OutBuf* out, const IRModule* ir, bool initialized) {
+    bool section = false;
+    for (int i = 0; i < ir->global_count; i++) {
+        const IRGlobal* global = &ir->globals[i];
+        bool has_init = global->count == 1 && global->init != 0;
+        if (has_init != initialized) continue;
+        if (!section) {
+            outbuf_puts(out, initialized ? "\t.data\n" : "\t.bss\n");
+            section = true;
+        }
+        int elem = global->type == IR_TYPE_PTR ? 8 : 4;
+        emit_directive(out, ".globl", global->name);
+        outbuf_puts(out, "\n\t.align\t");
+        outbuf_int(out, elem);
+        outbuf_putc(out, '\n');
+        emit_directive(out, ".type", global->name);
+        outbuf_puts(out, ", @object\n");
+        emit_directive(out, ".size", global->name);
+        outbuf_puts(out, ", ");
+        outbuf_int(out, (int64_t)elem * global->count);
+        outbuf_putc(out, '\n');
+        outbuf_puts(out, global->name);
+        outbuf_puts(out, ":\n");
+        if (initialized) {
+            outbuf_puts(out, elem == 8 ? "\t.quad\t" : "\t.long\t");
+            outbuf_int(out, global->init);
+        } else {
+            outbuf_puts(out, "\t.zero\t");
+            outbuf_int(out, (int64_t)elem * global->count);
+        }
+        outbuf_putc(out, '\n');
+    }
+}
+
+void x86_asm_emit_module(OutBuf* out, const X86Module* module) {
+    outbuf_puts(out, "\t.text\n");
+    for (int i = 0; i < module->function_count; i++) {
+        emit_function(out, module, &module->functions[i]);
+    }
+    emit_globals(out, module->ir, true);
+    emit_globals(out, module->ir, false);
+
+    for (int i = 0; i < module->function_count; i++) {
+        if (module->functions[i].is_global) continue;
+        outbuf_puts(out, "\t.section\t.init_array,\"aw\"\n\t.align\t8\n");
+        emit_directive(out, ".quad", module->functions[i].name);
+        outbuf_putc(out, '\n');
+    }
+    outbuf_puts(out, "\t.section\t.note.GNU-stack,\"\",@progbits\n");
+}
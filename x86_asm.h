@@ -0,0 +1,15 @@
+#ifndef X86_ASM_H
+#define X86_ASM_H
+
+#include "x86_codegen.h"
+#include "outbuf.h"
+
+// ========== GNU as汇编输出 ==========
+//
+// 按AT&T语法输出整个模块: 代码段中的函数, .data/.bss中的全局变量,
+// __toplevel作为本地函数登记到.init_array, 在main之前执行。
+// 全局变量按rip相对寻址, 调用没有定义的函数经PLT, 输出的汇编可以链接成位置无关的可执行文件。
+
+void x86_asm_emit_module(OutBuf* out, const X86Module* module);
+
+#endif // X86_ASM_H
@@ -0,0 +1,907 @@
+#include "x86_codegen.h"
+#include "x86_peephole.h"
+#include "x86_frame.h"
+#include "ir_lower.h"
+#include <stdlib.h>
+#include <string.h>
+
+static void* cg_alloc(size_t size) {
+    void* ptr = malloc(size ? size : 1);
+    if (!ptr) {
+        perror("malloc failed for x86 codegen");
+        exit(1);
+    }
+    return ptr;
+}
+
+static int type_size(IRType type) {
+    return type == IR_TYPE_PTR ? 8 : 4;
+}
+
+// ========== 操作数 ==========
+
+static X86Operand make_operand(X86OperandKind kind) {
+    X86Operand operand;
+    memset(&operand, 0, sizeof(operand));
+    operand.kind = (uint8_t)kind;
+    operand.reg = -1;
+    operand.index = -1;
+    operand.scale = 1;
+    return operand;
+}
+
+static X86Operand x86_reg(int reg) {
+    X86Operand operand = make_operand(X86_OPERAND_REG);
+    operand.reg = (int8_t)reg;
+    return operand;
+}
+
+static X86Operand x86_imm(int32_t value) {
+    X86Operand operand = make_operand(X86_OPERAND_IMM);
+    operand.value = value;
+    return operand;
+}
+
+static X86Operand x86_label(int label) {
+    X86Operand operand = make_operand(X86_OPERAND_LABEL);
+    operand.value = label;
+    return operand;
+}
+
+static X86Operand x86_func(int function) {
+    X86Operand operand = make_operand(X86_OPERAND_FUNC);
+    operand.value = function;
+    return operand;
+}
+
+static X86Operand x86_mem(X86BaseKind base_kind, int reg_or_object, int32_t disp) {
+    X86Operand operand = make_operand(X86_OPERAND_MEM);
+    operand.base_kind = (uint8_t)base_kind;
+    if (base_kind == X86_BASE_REG) operand.reg = (int8_t)reg_or_object;
+    else operand.object = reg_or_object;
+    operand.value = disp;
+    return operand;
+}
+
+static bool operand_equal(X86Operand a, X86Operand b) {
+    if (a.kind != b.kind) return false;
+    switch (a.kind) {
+        case X86_OPERAND_REG:
+            return a.reg == b.reg;
+        case X86_OPERAND_MEM:
+            return a.base_kind == b.base_kind && a.reg == b.reg && a.object == b.object &&
+                   a.index == b.index && a.scale == b.scale && a.value == b.value;
+        default:
+            return a.value == b.value;
+    }
+}
+
+static bool is_reg(X86Operand operand, int reg) {
+    return operand.kind == X86_OPERAND_REG && operand.reg == reg;
+}
+
+// ========== 指令列表 ==========
+
+static X86Instr* emit(X86Function* function, X86Opcode op, int size, X86Operand dst, X86Operand src) {
+    if (function->instr_count == function->instr_capacity) {
+        function->instr_capacity = function->instr_capacity ? function->instr_capacity * 2 : 64;
+        function->instrs = (X86Instr*)realloc(function->instrs,
+                                              sizeof(X86Instr) * (size_t)function->instr_capacity);
+        if (!function->instrs) {
+            perror("malloc failed for X86Instr");
+            exit(1);
+        }
+    }
+    X86Instr* instr = &function->instrs[function->instr_count++];
+    instr->op = (uint8_t)op;
+    instr->size = (uint8_t)size;
+    instr->cond = 0;
+    instr->dst = dst;
+    instr->src = src;
+    return instr;
+}
+
+static X86Instr* emit1(X86Function* function, X86Opcode op, int size, X86Operand dst) {
+    return emit(function, op, size, dst, make_operand(X86_OPERAND_NONE));
+}
+
+static void emit_jcc(X86Function* function, int cond, int label) {
+    emit1(function, X86_JCC, 0, x86_label(label))->cond = (uint8_t)cond;
+}
+
+// 两个操作数都在内存中时经r11中转
+static void emit_move(X86Function* function, int size, X86Operand dst, X86Operand src) {
+    if (operand_equal(dst, src)) return;
+    if (dst.kind == X86_OPERAND_MEM && src.kind == X86_OPERAND_MEM) {
+        emit(function, X86_MOV, size, x86_reg(X86_R11), src);
+        src = x86_reg(X86_R11);
+    }
+    emit(function, X86_MOV, size, dst, src);
+}
+
+// ========== 指令选择 ==========
+
+typedef struct ISel {
+    X86Module* module;
+    X86Function* out;
+    const IRFunction* function;
+    const IRRegAlloc* alloc;
+    IRUses* uses;
+    int32_t* block_label;   // IR基本块 → 标号
+    int next_block;         // 排在当前块之后的块, -1表示当前块在最后
+    int fused_compare;      // 推迟到br中生成的比较指令, -1表示没有
+    bool sibling_calls;     // 尾调用可以改为jmp(函数没有取栈槽的地址)
+
+    IRMove* moves;          // 调用参数和函数入口的并行复制
+    IRMoveList sequence;
+
+    // 向量值只在块内使用: 定值时分配xmm, 最后一次使用之后归还
+    int8_t* xmm;            // v4i32虚拟寄存器 → xmm编号
+    int32_t* xmm_uses;      // v4i32虚拟寄存器 → 剩余使用次数
+    uint32_t xmm_free;      // 空闲的xmm(按编号的位)
+} ISel;
+
+static X86Operand loc_operand(const ISel* isel, IRLoc loc) {
+    switch (loc.kind) {
+        case IR_LOC_REG:   return x86_reg(loc.value);
+        case IR_LOC_STACK: return x86_mem(X86_BASE_FRAME, isel->out->spill_base + loc.value, 0);
+        case IR_LOC_CONST: return x86_imm(loc.value);
+        default:           return make_operand(X86_OPERAND_NONE);
+    }
+}
+
+static X86Operand use_operand(const ISel* isel, IROperand operand, int instr) {
+    return loc_operand(isel, ir_regalloc_use(isel->alloc, operand, instr));
+}
+
+// 结果先写到哪里: 分到寄存器时直接写入, 溢出时先算到rax
+static X86Operand def_target(const ISel* isel, int vreg) {
+    IRLoc loc = ir_regalloc_def(isel->alloc, vreg);
+    return loc.kind == IR_LOC_REG ? x86_reg(loc.value) : x86_reg(X86_RAX);
+}
+
+// 结果已在value中: 写到分配的位置, 被拆分的区间同时写入溢出槽
+static void finish_def(ISel* isel, int vreg, int size, X86Operand value) {
+    IRLoc loc = ir_regalloc_def(isel->alloc, vreg);
+    if (loc.kind == IR_LOC_NONE) return;
+    X86Operand home = loc_operand(isel, loc);
+    emit_move(isel->out, size, home, value);
+    if (ir_regalloc_spill_at_def(isel->alloc, vreg)) {
+        X86Operand slot = x86_mem(X86_BASE_FRAME, isel->out->spill_base + isel->alloc->intervals[vreg].slot, 0);
+        emit_move(isel->out, size, slot, home);
+    }
+}
+
+static void emit_moves(ISel* isel, const IRMoveList* list) {
+    for (int i = 0; i < list->count; i++) {
+        emit_move(isel->out, 8, loc_operand(isel, list->moves[i].dst), loc_operand(isel, list->moves[i].src));
+    }
+}
+
+static int element_size(const ISel* isel, IROperand base, IRType fallback) {
+    switch (base.kind) {
+        case IR_OPERAND_SLOT:   return type_size((IRType)isel->function->slots[base.value].type);
+        case IR_OPERAND_GLOBAL: return type_size((IRType)isel->module->ir->globals[base.value].type);
+        default:                return type_size(fallback);
+    }
+}
+
+// base[index]的内存操作数; 变量下标符号扩展到r11, 带变量下标的全局变量和溢出的指针经rax寻址
+static X86Operand select_memory(ISel* isel, IROperand base, const IROperand* index, int elem, int instr) {
+    int32_t disp = 0;
+    int index_reg = -1;
+    if (index && index->kind == IR_OPERAND_CONST) {
+        disp = index->value * elem;
+    } else if (index) {
+        emit(isel->out, X86_MOVSXD, 8, x86_reg(X86_R11), use_operand(isel, *index, instr));
+        index_reg = X86_R11;
+    }
+
+    X86Operand mem;
+    if (base.kind == IR_OPERAND_SLOT) {
+        mem = x86_mem(X86_BASE_FRAME, base.value, disp);
+    } else if (base.kind == IR_OPERAND_GLOBAL && index_reg < 0) {
+        mem = x86_mem(X86_BASE_GLOBAL, base.value, disp);
+    } else if (base.kind == IR_OPERAND_GLOBAL) {
+        emit(isel->out, X86_LEA, 8, x86_reg(X86_RAX), x86_mem(X86_BASE_GLOBAL, base.value, 0));
+        mem = x86_mem(X86_BASE_REG, X86_RAX, disp);
+    } else {
+        X86Operand pointer = use_operand(isel, base, instr);
+        if (pointer.kind != X86_OPERAND_REG) {
+            emit(isel->out, X86_MOV, 8, x86_reg(X86_RAX), pointer);
+            pointer = x86_reg(X86_RAX);
+        }
+        mem = x86_mem(X86_BASE_REG, pointer.reg, disp);
+    }
+    mem.index = (int8_t)index_reg;
+    mem.scale = (uint8_t)elem;
+    return mem;
+}
+
+static int compare_cond(IROpcode op) {
+    switch (op) {
+        case IR_EQ: return X86_CC_E;
+        case IR_NE: return X86_CC_NE;
+        case IR_LT: return X86_CC_L;
+        case IR_LE: return X86_CC_LE;
+        case IR_GT: return X86_CC_G;
+        default:    return X86_CC_GE;
+    }
+}
+
+// 交换比较的两个操作数后的条件
+static int swap_cond(int cond) {
+    switch (cond) {
+        case X86_CC_L:  return X86_CC_G;
+        case X86_CC_G:  return X86_CC_L;
+        case X86_CC_LE: return X86_CC_GE;
+        case X86_CC_GE: return X86_CC_LE;
+        default:        return cond;
+    }
+}
+
+// 生成比较, 返回结果为真时成立的条件码
+static int select_compare(ISel* isel, const IRInstr* instr, const IROperand* args, int id) {
+    int size = type_size((IRType)args[0].type);
+    X86Operand a = use_operand(isel, args[0], id);
+    X86Operand b = use_operand(isel, args[1], id);
+    int cond = compare_cond((IROpcode)instr->op);
+    if (a.kind == X86_OPERAND_IMM && b.kind != X86_OPERAND_IMM) {
+        X86Operand t = a;
+        a = b;
+        b = t;
+        cond = swap_cond(cond);
+    }
+    if (a.kind == X86_OPERAND_IMM || (a.kind == X86_OPERAND_MEM && b.kind == X86_OPERAND_MEM)) {
+        emit(isel->out, X86_MOV, size, x86_reg(X86_RAX), a);
+        a = x86_reg(X86_RAX);
+    }
+    emit(isel->out, X86_CMP, size, a, b);
+    return cond;
+}
+
+static void select_setcc(ISel* isel, int vreg, int cond) {
+    X86Operand target = def_target(isel, vreg);
+    emit1(isel->out, X86_SETCC, 1, x86_reg(X86_RAX))->cond = (uint8_t)cond;
+    emit(isel->out, X86_MOVZX8, 4, target, x86_reg(X86_RAX));
+    finish_def(isel, vreg, 4, target);
+}
+
+// 移位数不是常量时要放在cl中, rcx原来的值暂存在r11
+static void select_variable_shift(ISel* isel, X86Opcode op, const IRInstr* instr, X86Operand a,
+                                  X86Operand b) {
+    X86Function* out = isel->out;
+    emit_move(out, 4, x86_reg(X86_RAX), a);
+    if (is_reg(b, X86_RCX)) {
+        emit(out, op, 4, x86_reg(X86_RAX), b);
+    } else {
+        emit(out, X86_MOV, 8, x86_reg(X86_R11), x86_reg(X86_RCX));
+        emit(out, X86_MOV, 4, x86_reg(X86_RCX), b);
+        emit(out, op, 4, x86_reg(X86_RAX), x86_reg(X86_RCX));
+        emit(out, X86_MOV, 8, x86_reg(X86_RCX), x86_reg(X86_R11));
+    }
+    finish_def(isel, instr->dest, 4, x86_reg(X86_RAX));
+}
+
+static void select_binary(ISel* isel, const IRInstr* instr, const IROperand* args, int id) {
+    X86Opcode op;
+    bool commutative = false;
+    switch (instr->op) {
+        case IR_ADD: op = X86_ADD; commutative = true; break;
+        case IR_MUL: op = X86_IMUL; commutative = true; break;
+        case IR_AND: op = X86_AND; commutative = true; break;
+        case IR_SUB: op = X86_SUB; break;
+        case IR_SHL: op = X86_SHL; break;
+        default:     op = X86_SAR; break;
+    }
+    int size = type_size((IRType)instr->type);
+    X86Operand d = def_target(isel, instr->dest);
+    X86Operand a = use_operand(isel, args[0], id);
+    X86Operand b = use_operand(isel, args[1], id);
+
+    if ((op == X86_SHL || op == X86_SAR) && b.kind != X86_OPERAND_IMM) {
+        select_variable_shift(isel, op, instr, a, b);
+        return;
+    }
+    // 可交换时让立即数和已在目标寄存器中的操作数各就各位, 省去一次复制
+    if (commutative && (a.kind == X86_OPERAND_IMM || operand_equal(b, d))) {
+        X86Operand t = a;
+        a = b;
+        b = t;
+    }
+    // 不可交换且b就在目标寄存器中: 先算到r11
+    X86Operand target = operand_equal(b, d) ? x86_reg(X86_R11) : d;
+    emit_move(isel->out, size, target, a);
+    emit(isel->out, op, size, target, b);
+    finish_def(isel, instr->dest, size, target);
+}
+
+static void select_division(ISel* isel, const IRInstr* instr, const IROperand* args, int id) {
+    X86Function* out = isel->out;
+    X86Operand b = use_operand(isel, args[1], id);
+    emit_move(out, 4, x86_reg(X86_RAX), use_operand(isel, args[0], id));
+    emit(out, X86_CDQ, 4, make_operand(X86_OPERAND_NONE), make_operand(X86_OPERAND_NONE));
+    if (b.kind == X86_OPERAND_IMM) {
+        emit(out, X86_MOV, 4, x86_reg(X86_R11), b);
+        b = x86_reg(X86_R11);
+    }
+    emit1(out, X86_IDIV, 4, b);
+    finish_def(isel, instr->dest, 4, x86_reg(instr->op == IR_DIV ? X86_RAX : X86_RDX));
+}
+
+// ========== 向量 ==========
+
+static int alloc_xmm(ISel* isel) {
+    int reg = 0;
+    while (!(isel->xmm_free >> reg & 1)) reg++;
+    isel->xmm_free &= ~(1u << reg);
+    return reg;
+}
+
+static void release_xmm(ISel* isel, int vreg, int count) {
+    isel->xmm_uses[vreg] -= count;
+    if (isel->xmm_uses[vreg] == 0) isel->xmm_free |= 1u << isel->xmm[vreg];
+}
+
+static void define_xmm(ISel* isel, int vreg, int reg) {
+    isel->xmm[vreg] = (int8_t)reg;
+    isel->xmm_uses[vreg] = ir_uses_count(isel->uses, vreg);
+    if (isel->xmm_uses[vreg] == 0) isel->xmm_free |= 1u << reg;
+}
+
+// 向量循环的块内最多同时有X86_XMM_COUNT个向量值(见ir_unroll.h), 不会用完xmm
+static void select_vector(ISel* isel, const IRInstr* instr, const IROperand* args, int id) {
+    X86Function* out = isel->out;
+    switch (instr->op) {
+        case IR_VLOAD: {
+            X86Operand mem = select_memory(isel, args[0], &args[1], 4, id);
+            int reg = alloc_xmm(isel);
+            emit(out, X86_MOVDQU, 16, x86_reg(reg), mem);
+            define_xmm(isel, instr->dest, reg);
+            break;
+        }
+
+        case IR_VSTORE: {
+            X86Operand mem = select_memory(isel, args[0], &args[2], 4, id);
+            emit(out, X86_MOVDQU, 16, mem, x86_reg(isel->xmm[args[1].value]));
+            release_xmm(isel, args[1].value, 1);
+            break;
+        }
+
+        case IR_SPLAT: {
+            X86Operand a = use_operand(isel, args[0], id);
+            if (a.kind == X86_OPERAND_IMM) {
+                emit(out, X86_MOV, 4, x86_reg(X86_RAX), a);
+                a = x86_reg(X86_RAX);
+            }
+            int reg = alloc_xmm(isel);
+            emit(out, X86_MOVD, 16, x86_reg(reg), a);
+            emit(out, X86_PSHUFD, 16, x86_reg(reg), x86_reg(reg));
+            define_xmm(isel, instr->dest, reg);
+            break;
+        }
+
+        default: {
+            X86Opcode op;
+            switch (instr->op) {
+                case IR_ADD: op = X86_PADDD; break;
+                case IR_SUB: op = X86_PSUBD; break;
+                case IR_AND: op = X86_PAND; break;
+                case IR_SHL: op = X86_PSLLD; break;
+                default:     op = X86_PSRAD; break;
+            }
+            bool shift = op == X86_PSLLD || op == X86_PSRAD;
+            int a = args[0].value;
+            bool same = !shift && args[1].value == a;
+            // a在这里最后一次使用时直接在它的寄存器中计算, 否则先复制; 此时b的寄存器还没有归还
+            int reg = isel->xmm[a];
+            release_xmm(isel, a, same ? 2 : 1);
+            if (isel->xmm_uses[a] == 0) {
+                isel->xmm_free &= ~(1u << reg);
+            } else {
+                reg = alloc_xmm(isel);
+                emit(out, X86_MOVDQA, 16, x86_reg(reg), x86_reg(isel->xmm[a]));
+            }
+            if (shift) {
+                emit(out, op, 16, x86_reg(reg), x86_imm(args[1].value));
+            } else {
+                emit(out, op, 16, x86_reg(reg), x86_reg(isel->xmm[args[1].value]));
+                if (!same) release_xmm(isel, args[1].value, 1);
+            }
+            define_xmm(isel, instr->dest, reg);
+            break;
+        }
+    }
+}
+
+// 前6个实参并行复制到参数寄存器
+static void emit_arg_moves(ISel* isel, const IROperand* args, int argc, int id) {
+    int count = 0;
+    for (int i = 0; i < argc && i < X86_ARG_REG_COUNT; i++) {
+        IRLoc src = ir_regalloc_use(isel->alloc, args[1 + i], id);
+        if (src.kind == IR_LOC_NONE) continue;
+        isel->moves[count].src = src;
+        isel->moves[count].dst.kind = IR_LOC_REG;
+        isel->moves[count++].dst.value = x86_arg_regs[i];
+    }
+    isel->sequence.count = 0;
+    ir_regalloc_sequentialize(isel->alloc->target, isel->moves, count, &isel->sequence);
+    emit_moves(isel, &isel->sequence);
+}
+
+static void select_call(ISel* isel, const IRInstr* instr, const IROperand* args, int id) {
+    X86Function* out = isel->out;
+    int callee = args[0].value;
+    int argc = instr->arg_count - 1;
+    int stack_args = argc > X86_ARG_REG_COUNT ? argc - X86_ARG_REG_COUNT : 0;
+    int padding = stack_args % 2 ? 8 : 0;
+
+    // 栈上的参数逆序压栈, 调用时rsp保持16字节对齐
+    if (padding) emit(out, X86_SUB, 8, x86_reg(X86_RSP), x86_imm(padding));
+    for (int i = argc - 1; i >= X86_ARG_REG_COUNT; i--) {
+        emit1(out, X86_PUSH, 8, use_operand(isel, args[1 + i], id));
+    }
+
+    emit_arg_moves(isel, args, argc, id);
+
+    // 外部函数可能是变参函数(如printf), al中是向量寄存器参数的个数
+    if (!isel->module->ir->functions[callee].is_defined) {
+        emit(out, X86_XOR, 4, x86_reg(X86_RAX), x86_reg(X86_RAX));
+    }
+    emit(out, X86_CALL, 8, x86_func(callee), x86_imm(argc < X86_ARG_REG_COUNT ? argc : X86_ARG_REG_COUNT));
+    if (stack_args > 0 || padding) {
+        emit(out, X86_ADD, 8, x86_reg(X86_RSP), x86_imm(8 * stack_args + padding));
+    }
+    if (instr->dest >= 0 && ir_uses_count(isel->uses, instr->dest) > 0) {
+        finish_def(isel, instr->dest, type_size((IRType)instr->type), x86_reg(X86_RAX));
+    }
+}
+
+// 尾调用的实参都经寄存器传递时, 传好实参后由尾声释放栈帧再跳到被调用者;
+// 返回地址仍是调用者的, rsp与进入本函数时相同, 满足调用处的对齐要求
+static bool select_tail_call(ISel* isel, int b, int i) {
+    const IRBlock* block = &isel->function->blocks[b];
+    const IRInstr* instr = &isel->function->instrs[block->instrs[i]];
+    if (!isel->sibling_calls || instr->arg_count - 1 > X86_ARG_REG_COUNT) return false;
+    if (!ir_is_tail_call(isel->function, b, i)) return false;
+
+    const IROperand* args = &isel->function->operands[instr->args];
+    int callee = args[0].value;
+    int argc = instr->arg_count - 1;
+    emit_arg_moves(isel, args, argc, block->instrs[i]);
+    if (!isel->module->ir->functions[callee].is_defined) {
+        emit(isel->out, X86_XOR, 4, x86_reg(X86_RAX), x86_reg(X86_RAX));
+    }
+    emit(isel->out, X86_TAILJMP, 8, x86_func(callee), x86_imm(argc));
+    isel->module->stats.tail_calls++;
+    return true;
+}
+
+// 条件成立时跳到on_true, 否则到on_false; 跳到下一个块的跳转省略
+static void emit_branch(ISel* isel, int cond, int on_true, int on_false) {
+    if (on_true == isel->next_block) {
+        emit_jcc(isel->out, cond ^ 1, isel->block_label[on_false]);
+        return;
+    }
+    emit_jcc(isel->out, cond, isel->block_label[on_true]);
+    if (on_false != isel->next_block) emit1(isel->out, X86_JMP, 0, x86_label(isel->block_label[on_false]));
+}
+
+static void select_terminator(ISel* isel, const IRInstr* instr, const IROperand* args, int id) {
+    X86Function* out = isel->out;
+    switch (instr->op) {
+        case IR_JMP:
+            if (args[0].value != isel->next_block) {
+                emit1(out, X86_JMP, 0, x86_label(isel->block_label[args[0].value]));
+            }
+            break;
+
+        case IR_BR: {
+            int on_true = args[1].value;
+            int on_false = args[2].value;
+            if (isel->fused_compare >= 0) {
+                int compare = isel->fused_compare;
+                const IRInstr* cmp = &isel->function->instrs[compare];
+                int cond = select_compare(isel, cmp, &isel->function->operands[cmp->args], compare);
+                isel->fused_compare = -1;
+                emit_branch(isel, cond, on_true, on_false);
+                break;
+            }
+            X86Operand c = use_operand(isel, args[0], id);
+            if (c.kind == X86_OPERAND_IMM) {
+                int target = c.value ? on_true : on_false;
+                if (target != isel->next_block) emit1(out, X86_JMP, 0, x86_label(isel->block_label[target]));
+                break;
+            }
+            if (c.kind == X86_OPERAND_REG) emit(out, X86_TEST, 4, c, c);
+            else emit(out, X86_CMP, 4, c, x86_imm(0));
+            emit_branch(isel, X86_CC_NE, on_true, on_false);
+            break;
+        }
+
+        case IR_RET:
+            if (instr->arg_count > 0) {
+                emit_move(out, type_size((IRType)args[0].type), x86_reg(X86_RAX), use_operand(isel, args[0], id));
+            }
+            if (isel->next_block >= 0) emit1(out, X86_JMP, 0, x86_label(out->return_label));
+            break;
+    }
+}
+
+// 比较的结果只被紧随其后的br使用时推迟到br中生成
+static bool fuse_with_branch(const ISel* isel, const IRBlock* block, int i) {
+    const IRFunction* function = isel->function;
+    const IRInstr* instr = &function->instrs[block->instrs[i]];
+    if (i + 1 >= block->instr_count) return false;
+    const IRInstr* next = &function->instrs[block->instrs[i + 1]];
+    if (next->op != IR_BR) return false;
+    const IROperand* cond = &function->operands[next->args];
+    return cond->kind == IR_OPERAND_VREG && cond->value == instr->dest &&
+           ir_uses_count(isel->uses, instr->dest) == 1;
+}
+
+static void select_instr(ISel* isel, const IRBlock* block, int i) {
+    int id = block->instrs[i];
+    const IRInstr* instr = &isel->function->instrs[id];
+    const IROperand* args = &isel->function->operands[instr->args];
+    X86Function* out = isel->out;
+
+    if (instr->type == IR_TYPE_V4I32 || instr->op == IR_VSTORE) {
+        select_vector(isel, instr, args, id);
+        return;
+    }
+    switch (instr->op) {
+        case IR_ADD: case IR_SUB: case IR_MUL: case IR_AND: case IR_SHL: case IR_SHR:
+            select_binary(isel, instr, args, id);
+            break;
+
+        case IR_DIV: case IR_MOD:
+            select_division(isel, instr, args, id);
+            break;
+
+        case IR_NEG: {
+            X86Operand target = def_target(isel, instr->dest);
+            emit_move(out, 4, target, use_operand(isel, args[0], id));
+            emit1(out, X86_NEG, 4, target);
+            finish_def(isel, instr->dest, 4, target);
+            break;
+        }
+
+        case IR_EQ: case IR_NE: case IR_LT: case IR_LE: case IR_GT: case IR_GE:
+            if (fuse_with_branch(isel, block, i)) {
+                isel->fused_compare = id;
+                break;
+            }
+            select_setcc(isel, instr->dest, select_compare(isel, instr, args, id));
+            break;
+
+        case IR_NOT: {
+            X86Operand a = use_operand(isel, args[0], id);
+            if (a.kind == X86_OPERAND_IMM) {
+                finish_def(isel, instr->dest, 4, x86_imm(a.value == 0));
+                break;
+            }
+            emit(out, X86_CMP, type_size((IRType)args[0].type), a, x86_imm(0));
+            select_setcc(isel, instr->dest, X86_CC_E);
+            break;
+        }
+
+        case IR_ZEXT: case IR_COPY:
+            finish_def(isel, instr->dest, type_size((IRType)instr->type), use_operand(isel, args[0], id));
+            break;
+
+        case IR_ADDR: {
+            const IROperand* index = instr->arg_count > 1 ? &args[1] : NULL;
+            X86Operand mem = select_memory(isel, args[0], index, element_size(isel, args[0], IR_TYPE_I32), id);
+            X86Operand target = def_target(isel, instr->dest);
+            emit(out, X86_LEA, 8, target, mem);
+            finish_def(isel, instr->dest, 8, target);
+            break;
+        }
+
+        case IR_LOAD: {
+            const IROperand* index = instr->arg_count > 1 ? &args[1] : NULL;
+            int size = type_size((IRType)instr->type);
+            X86Operand mem = select_memory(isel, args[0], index,
+                                           element_size(isel, args[0], (IRType)instr->type), id);
+            if (instr->dest < 0) break;
+            X86Operand target = def_target(isel, instr->dest);
+            emit(out, X86_MOV, size, target, mem);
+            finish_def(isel, instr->dest, size, target);
+            break;
+        }
+
+        case IR_STORE: {
+            const IROperand* index = instr->arg_count > 2 ? &args[2] : NULL;
+            int size = element_size(isel, args[0], (IRType)args[1].type);
+            X86Operand mem = select_memory(isel, args[0], index, size, id);
+            X86Operand value = use_operand(isel, args[1], id);
+            if (value.kind == X86_OPERAND_MEM) {
+                emit(out, X86_MOV, size, x86_reg(X86_RDX), value);
+                value = x86_reg(X86_RDX);
+            }
+            emit(out, X86_MOV, size, mem, value);
+            break;
+        }
+
+        case IR_CALL:
+            select_call(isel, instr, args, id);
+            break;
+
+        case IR_COUNT:
+            // 单线程程序, 不需要lock前缀
+            emit(out, X86_ADD, 8, x86_mem(X86_BASE_GLOBAL, args[0].value, 4 * args[1].value), x86_imm(1));
+            break;
+
+        default:
+            break;
+    }
+}
+
+// 参数从rdi、rsi、...(第7个起从调用者的栈帧)移到分配的位置
+static void select_params(ISel* isel) {
+    const IRFunction* function = isel->function;
+    int count = 0;
+    for (int i = 0; i < function->param_count && i < function->vreg_count; i++) {
+        IRLoc loc = ir_regalloc_def(isel->alloc, i);
+        if (loc.kind == IR_LOC_NONE || i >= X86_ARG_REG_COUNT) continue;
+        IRLoc src = { IR_LOC_REG, x86_arg_regs[i] };
+        isel->moves[count].src = src;
+        isel->moves[count++].dst = loc;
+        if (ir_regalloc_spill_at_def(isel->alloc, i)) {
+            IRLoc slot = { IR_LOC_STACK, isel->alloc->intervals[i].slot };
+            isel->moves[count].src = src;
+            isel->moves[count++].dst = slot;
+        }
+    }
+    isel->sequence.count = 0;
+    ir_regalloc_sequentialize(isel->alloc->target, isel->moves, count, &isel->sequence);
+    emit_moves(isel, &isel->sequence);
+
+    for (int i = X86_ARG_REG_COUNT; i < function->param_count && i < function->vreg_count; i++) {
+        X86Operand incoming = x86_mem(X86_BASE_REG, X86_RBP, 16 + 8 * (i - X86_ARG_REG_COUNT));
+        finish_def(isel, i, type_size((IRType)function->vreg_types[i]), incoming);
+    }
+}
+
+// 基本块按寄存器分配的顺序排列, profile中没有执行过的块(count为0)移到最后, 热路径上的跳转多是落空;
+// 各处的寄存器位置只取决于程序点和边, 与块在代码中的位置无关。返回的数组需要释放
+static int* layout_blocks(ISel* isel) {
+    const IRFunction* function = isel->function;
+    const IRRegAlloc* alloc = isel->alloc;
+    int* layout = (int*)cg_alloc(sizeof(int) * (size_t)(alloc->order_count + 1));
+    int count = 0;
+    for (int pass = 0; pass < 2; pass++) {
+        for (int r = 0; r < alloc->order_count; r++) {
+            int b = alloc->order[r];
+            bool cold = r > 0 && function->blocks[b].count == 0;
+            if (cold == (pass == 1)) layout[count++] = b;
+            if (cold && pass == 1) isel->module->stats.cold_blocks++;
+        }
+    }
+    return layout;
+}
+
+static void select_function(ISel* isel) {
+    const IRFunction* function = isel->function;
+    const IRRegAlloc* alloc = isel->alloc;
+    X86Function* out = isel->out;
+
+    select_params(isel);
+    int* layout = layout_blocks(isel);
+    for (int r = 0; r < alloc->order_count; r++) {
+        int b = layout[r];
+        const IRBlock* block = &function->blocks[b];
+        isel->next_block = r + 1 < alloc->order_count ? layout[r + 1] : -1;
+        emit1(out, X86_LABEL, 0, x86_label(isel->block_label[b]));
+        emit_moves(isel, &alloc->moves_in[b]);
+        isel->xmm_free = (1u << X86_XMM_COUNT) - 1;
+
+        for (int i = 0; i < block->instr_count; i++) {
+            int id = block->instrs[i];
+            const IRInstr* instr = &function->instrs[id];
+            if (instr->op == IR_PHI || instr->op == IR_NOP) continue;
+            if (ir_opcode_is_terminator((IROpcode)instr->op)) {
+                emit_moves(isel, &alloc->moves_out[b]);
+                select_terminator(isel, instr, &function->operands[instr->args], id);
+            } else if (instr->op == IR_CALL && select_tail_call(isel, b, i)) {
+                break;  // 其后的ret已由jmp代替
+            } else {
+                select_instr(isel, block, i);
+            }
+        }
+    }
+    free(layout);
+}
+
+// ========== 栈帧 ==========
+
+static int count_bits(uint32_t bits) {
+    int count = 0;
+    for (; bits; bits &= bits - 1) count++;
+    return count;
+}
+
+static bool is_spill_slot(const X86Function* function, X86Operand operand) {
+    return operand.kind == X86_OPERAND_MEM && operand.base_kind == X86_BASE_FRAME &&
+           operand.object >= function->spill_base;
+}
+
+// 释放栈帧, 恢复保存的寄存器和rbp; 之后rsp指向返回地址
+static void emit_epilogue(X86Function* frame, const X86Function* function) {
+    int saved = count_bits(function->saved_regs);
+    if (function->frame_size > 0 && saved > 0) {
+        emit(frame, X86_LEA, 8, x86_reg(X86_RSP), x86_mem(X86_BASE_REG, X86_RBP, -8 * saved));
+    } else if (function->frame_size > 0) {
+        emit(frame, X86_MOV, 8, x86_reg(X86_RSP), x86_reg(X86_RBP));
+    }
+    for (int reg = X86_REG_COUNT - 1; reg >= 0; reg--) {
+        if (function->saved_regs >> reg & 1) emit1(frame, X86_POP, 8, x86_reg(reg));
+    }
+    emit1(frame, X86_POP, 8, x86_reg(X86_RBP));
+}
+
+void x86_finalize_frame(X86Function* function) {
+    // 保存的寄存器紧挨着rbp, 栈帧对象由x86_frame_layout排在下面
+    int saved = count_bits(function->saved_regs);
+    int32_t offset = 8 * saved;
+    for (int i = 0; i < function->object_count; i++) {
+        const X86FrameObject* object = &function->objects[i];
+        if (object->size > 0 && -object->offset > offset) offset = -object->offset;
+    }
+    // 进入函数时rsp+8按16字节对齐, 压入rbp后对齐; 保存寄存器和栈帧合起来保持对齐
+    int32_t total = (offset + 15) / 16 * 16;
+    function->frame_size = total - 8 * saved;
+
+    X86Function frame;
+    memset(&frame, 0, sizeof(frame));
+    emit1(&frame, X86_PUSH, 8, x86_reg(X86_RBP));
+    emit(&frame, X86_MOV, 8, x86_reg(X86_RBP), x86_reg(X86_RSP));
+    for (int reg = 0; reg < X86_REG_COUNT; reg++) {
+        if (function->saved_regs >> reg & 1) emit1(&frame, X86_PUSH, 8, x86_reg(reg));
+    }
+    if (function->frame_size > 0) {
+        emit(&frame, X86_SUB, 8, x86_reg(X86_RSP), x86_imm(function->frame_size));
+    }
+    for (int i = 0; i < function->instr_count; i++) {
+        if (function->instrs[i].op == X86_TAILJMP) emit_epilogue(&frame, function);
+        X86Instr* instr = emit(&frame, X86_LABEL, 0, make_operand(X86_OPERAND_NONE), make_operand(X86_OPERAND_NONE));
+        *instr = function->instrs[i];
+    }
+
+    emit1(&frame, X86_LABEL, 0, x86_label(function->return_label));
+    emit_epilogue(&frame, function);
+    emit(&frame, X86_RET, 0, make_operand(X86_OPERAND_NONE), make_operand(X86_OPERAND_NONE));
+
+    free(function->instrs);
+    function->instrs = frame.instrs;
+    function->instr_count = frame.instr_count;
+    function->instr_capacity = frame.instr_capacity;
+}
+
+// ========== 模块 ==========
+
+X86Module* x86_module_create(const IRModule* ir) {
+    X86Module* module = (X86Module*)calloc(1, sizeof(X86Module));
+    if (!module) {
+        perror("malloc failed for X86Module");
+        exit(1);
+    }
+    module->ir = ir;
+    module->peephole = true;
+    module->share_frame_slots = true;
+    return module;
+}
+
+void x86_module_destroy(X86Module* module) {
+    if (!module) return;
+    for (int i = 0; i < module->function_count; i++) {
+        free(module->functions[i].instrs);
+        free(module->functions[i].objects);
+    }
+    free(module->functions);
+    free(module);
+}
+
+X86Function* x86_module_add_function(X86Module* module, int ir_index, const IRRegAlloc* alloc) {
+    if (module->function_count == module->function_capacity) {
+        module->function_capacity = module->function_capacity ? module->function_capacity * 2 : 8;
+        module->functions = (X86Function*)realloc(module->functions,
+                                                  sizeof(X86Function) * (size_t)module->function_capacity);
+        if (!module->functions) {
+            perror("malloc failed for X86Function");
+            exit(1);
+        }
+    }
+    const IRFunction* function = &module->ir->functions[ir_index];
+    X86Function* out = &module->functions[module->function_count++];
+    memset(out, 0, sizeof(*out));
+    out->name = function->name;
+    out->ir_index = ir_index;
+    out->is_global = strcmp(function->name, IR_TOPLEVEL_NAME) != 0;
+    out->saved_regs = alloc->used_regs & alloc->target->callee_saved;
+
+    // 栈帧对象: 没被提升的IR栈槽, 然后是溢出槽
+    out->spill_base = function->slot_count;
+    out->object_count = function->slot_count + alloc->slot_count;
+    out->objects = (X86FrameObject*)cg_alloc(sizeof(X86FrameObject) * (size_t)out->object_count);
+    for (int i = 0; i < function->slot_count; i++) {
+        const IRSlot* slot = &function->slots[i];
+        int elem = type_size((IRType)slot->type);
+        out->objects[i].size = slot->promoted ? 0 : elem * slot->count;
+        out->objects[i].align = elem;
+        out->objects[i].offset = 0;
+    }
+    for (int i = function->slot_count; i < out->object_count; i++) {
+        out->objects[i].size = 8;
+        out->objects[i].align = 8;
+        out->objects[i].offset = 0;
+    }
+
+    ISel isel;
+    memset(&isel, 0, sizeof(isel));
+    isel.module = module;
+    isel.out = out;
+    isel.function = function;
+    isel.alloc = alloc;
+    isel.uses = ir_uses_create(function);
+    isel.fused_compare = -1;
+    isel.sibling_calls = !ir_function_takes_slot_address(function);
+    isel.block_label = (int32_t*)cg_alloc(sizeof(int32_t) * (size_t)(function->block_count + 1));
+    for (int b = 0; b < function->block_count; b++) isel.block_label[b] = out->label_count++;
+    out->return_label = out->label_count++;
+
+    int max_moves = 2 * X86_ARG_REG_COUNT;
+    for (int i = 0; i < function->instr_count; i++) {
+        if (function->instrs[i].arg_count > max_moves) max_moves = function->instrs[i].arg_count;
+    }
+    isel.moves = (IRMove*)cg_alloc(sizeof(IRMove) * (size_t)max_moves);
+    isel.xmm = (int8_t*)cg_alloc(sizeof(int8_t) * (size_t)function->vreg_count);
+    isel.xmm_uses = (int32_t*)cg_alloc(sizeof(int32_t) * (size_t)function->vreg_count);
+
+    select_function(&isel);
+
+    free(isel.xmm_uses);
+    free(isel.xmm);
+    free(isel.moves);
+    free(isel.sequence.moves);
+    free(isel.block_label);
+    ir_uses_destroy(isel.uses);
+
+    if (module->peephole) {
+        X86PeepholeStats peephole;
+        memset(&peephole, 0, sizeof(peephole));
+        x86_peephole_function(out, &peephole);
+        for (int k = 0; k < X86_PEEPHOLE_PATTERN_COUNT; k++) module->stats.peephole += peephole.applied[k];
+        module->stats.peephole_removed += peephole.removed;
+    }
+    for (int i = 0; i < out->instr_count; i++) {
+        const X86Instr* instr = &out->instrs[i];
+        if (instr->op == X86_LABEL) continue;
+        module->stats.instrs++;
+        bool spill_dst = is_spill_slot(out, instr->dst);
+        if (is_spill_slot(out, instr->src) || (spill_dst && instr->op != X86_MOV)) module->stats.spill_loads++;
+        if (spill_dst && instr->op == X86_MOV) module->stats.spill_stores++;
+    }
+    X86FrameStats frame;
+    memset(&frame, 0, sizeof(frame));
+    x86_frame_layout(out, module->share_frame_slots, &frame);
+    module->stats.frame_shared += frame.shared;
+    x86_finalize_frame(out);
+    module->stats.functions++;
+    module->stats.frame_bytes += out->frame_size + 8 * count_bits(out->saved_regs);
+    return out;
+}
+
+const char* x86_opcode_name(X86Opcode op) {
+    static const char* const names[X86_OPCODE_COUNT] = {
+        "label", "mov", "movzbl", "movslq", "lea",
+        "add", "sub", "imul", "and", "xor",
+        "neg", "shl", "sar", "cmp", "test",
+        "set", "cltd", "idiv", "push", "pop",
+        "call", "jmp", "j", "ret", "jmp",
+        "movdqu", "movdqa", "movd", "pshufd",
+        "paddd", "psubd", "pand", "pslld", "psrad"
+    };
+    return op < X86_OPCODE_COUNT ? names[op] : "?";
+}
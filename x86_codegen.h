@@ -0,0 +1,157 @@
+#ifndef X86_CODEGEN_H
+#define X86_CODEGEN_H
+
+#include "ir.h"
+#include "ir_regalloc.h"
+#include "x86_64.h"
+
+// ========== x86-64 指令选择 ==========
+//
+// 把分配过寄存器的SSA IR逐条翻译为机器指令列表(每个函数一个X86Function),
+// 之后由x86_asm.h输出为GNU as的AT&T语法。
+//   - int和bool用32位指令, 指针用64位; 边上的复制和溢出槽一律按8字节读写
+//   - 溢出的结果先算到rax再写回溢出槽; 溢出的操作数直接作为内存操作数,
+//     不能作内存操作数时经rax/rdx/r11装入(这三个寄存器不参与分配)
+//   - 比较只被紧随其后的br使用时合并为cmp + jcc
+//   - 调用按SysV ABI: 前6个参数经寄存器(按并行复制排序), 其余逆序压栈并保持16字节对齐
+//   - 尾调用(见ir_is_tail_call)的实参都在寄存器中、函数没有取栈槽的地址时, 传好实参后释放栈帧,
+//     用jmp代替call + ret; 被调用者直接返回到调用者的调用者
+//   - 基本块按寄存器分配的顺序排列, 有profile时(见profile.h)没有执行过的块移到函数末尾
+//   - profile插桩的count是一条 addq $1, 计数器(%rip)
+//   - 指令列表经窥孔优化(x86_peephole.h)改写后, 栈帧对象(没被提升的IR栈槽、溢出槽)按rbp寻址,
+//     由x86_frame_layout确定偏移(活跃范围不相交的对象共用栈槽), 最后由x86_finalize_frame生成序言和尾声
+//   - v4i32用SSE2指令, 在块内按剩余使用次数分配xmm寄存器, 不经过寄存器分配器
+
+typedef enum {
+    X86_OPERAND_NONE,
+    X86_OPERAND_REG,    // 寄存器, 宽度由指令决定
+    X86_OPERAND_IMM,    // 立即数
+    X86_OPERAND_MEM,    // 内存: base + index * scale + value
+    X86_OPERAND_LABEL,  // 函数内的标号
+    X86_OPERAND_FUNC    // 模块中的函数(调用目标)
+} X86OperandKind;
+
+typedef enum {
+    X86_BASE_REG,       // 基址寄存器
+    X86_BASE_FRAME,     // 栈帧对象object, 相对rbp
+    X86_BASE_GLOBAL     // 全局变量object, 相对rip(不能带下标)
+} X86BaseKind;
+
+typedef struct X86Operand {
+    uint8_t kind;       // X86OperandKind
+    uint8_t base_kind;  // X86BaseKind(内存操作数)
+    int8_t reg;         // 寄存器或基址寄存器
+    int8_t index;       // 下标寄存器, -1表示没有
+    uint8_t scale;
+    int32_t value;      // 立即数/位移/标号/函数编号
+    int32_t object;     // 栈帧对象或全局变量编号
+} X86Operand;
+
+typedef enum {
+    X86_LABEL,          // 标号定义, dst为标号
+    X86_MOV,
+    X86_MOVZX8,         // movzbl: 8位零扩展到32位
+    X86_MOVSXD,         // movslq: 32位符号扩展到64位
+    X86_LEA,
+    X86_ADD, X86_SUB, X86_IMUL, X86_AND, X86_XOR,
+    X86_NEG,
+    X86_SHL, X86_SAR,   // 移位数为立即数或cl
+    X86_CMP, X86_TEST,
+    X86_SETCC,          // dst的低8位 = 条件成立
+    X86_CDQ,            // edx:eax = 符号扩展eax
+    X86_IDIV,           // eax = edx:eax / dst, edx = 余数
+    X86_PUSH, X86_POP,
+    X86_CALL,           // 调用dst(函数); src是经寄存器传递的实参个数(立即数, 供窥孔优化的活跃分析)
+    X86_JMP,
+    X86_JCC,
+    X86_RET,
+    X86_TAILJMP,        // 尾调用: 跳到dst(函数), x86_finalize_frame在它之前插入尾声; src同call
+    // SSE2(向量循环): 寄存器操作数是xmm
+    X86_MOVDQU,         // 不要求对齐的16字节读写
+    X86_MOVDQA,         // xmm之间复制
+    X86_MOVD,           // dst(xmm)的低32位 = 32位寄存器或内存, 其余清0
+    X86_PSHUFD,         // dst = src的第0个元素重复4次
+    X86_PADDD, X86_PSUBD, X86_PAND,
+    X86_PSLLD, X86_PSRAD,   // 移位数为立即数
+    X86_OPCODE_COUNT
+} X86Opcode;
+
+// 条件码, 取值与机器编码中的条件字段相同
+typedef enum {
+    X86_CC_E = 0x4,
+    X86_CC_NE = 0x5,
+    X86_CC_L = 0xC,
+    X86_CC_GE = 0xD,
+    X86_CC_LE = 0xE,
+    X86_CC_G = 0xF
+} X86Cond;
+
+// 两个操作数的指令按Intel顺序存放(dst在前), 单操作数的指令只用dst
+typedef struct X86Instr {
+    uint8_t op;         // X86Opcode
+    uint8_t size;       // 操作数宽度: 1/4/8字节, SSE2指令为16
+    uint8_t cond;       // X86Cond(jcc/setcc)
+    X86Operand dst;
+    X86Operand src;
+} X86Instr;
+
+// 栈帧中的对象: 没有被提升的IR栈槽(数组等)和溢出槽
+typedef struct X86FrameObject {
+    int32_t size;       // 0表示不占空间(已被提升的栈槽)
+    int32_t align;
+    int32_t offset;     // 相对rbp的偏移, 由x86_frame_layout确定
+} X86FrameObject;
+
+typedef struct X86Function {
+    const char* name;
+    int ir_index;       // 在IR模块中的函数编号
+    bool is_global;     // __toplevel只在本文件中可见
+
+    X86Instr* instrs;
+    int instr_count;
+    int instr_capacity;
+    int label_count;
+    int return_label;   // 尾声之前的标号
+
+    X86FrameObject* objects;    // IR栈槽按编号在前, 溢出槽在后
+    int object_count;
+    int spill_base;             // 第一个溢出槽的对象编号
+    uint32_t saved_regs;        // 序言中保存的被调用者保存寄存器(按编号的位)
+    int32_t frame_size;         // 保存寄存器之下再分配的字节数(使调用处rsp按16字节对齐)
+} X86Function;
+
+typedef struct X86CodegenStats {
+    int functions;
+    int instrs;         // 机器指令数(不含标号)
+    int spill_loads;    // 从溢出槽读
+    int spill_stores;   // 写入溢出槽
+    int frame_bytes;    // 各函数栈帧大小之和
+    int tail_calls;     // 改为jmp的尾调用
+    int cold_blocks;    // profile中没有执行过、移到函数末尾的基本块
+    int peephole;       // 窥孔优化的改写次数(见x86_peephole.h)
+    int peephole_removed; // 窥孔优化删除的指令
+    int frame_shared;   // 放进了其他对象的栈槽的栈帧对象
+} X86CodegenStats;
+
+typedef struct X86Module {
+    const IRModule* ir;
+    X86Function* functions;
+    int function_count;
+    int function_capacity;
+    bool peephole;      // 指令选择之后做窥孔优化(默认开启)
+    bool share_frame_slots; // 活跃范围不相交的栈帧对象共用栈槽(默认开启, 见x86_frame.h)
+    X86CodegenStats stats;
+} X86Module;
+
+X86Module* x86_module_create(const IRModule* ir);
+void x86_module_destroy(X86Module* module);
+
+// 为一个定义了的函数做指令选择(alloc是它的寄存器分配结果), 再由x86_finalize_frame生成序言和尾声
+X86Function* x86_module_add_function(X86Module* module, int ir_index, const IRRegAlloc* alloc);
+
+// 按栈帧对象的偏移(见x86_frame.h)确定栈帧大小, 在指令列表前后插入序言和尾声
+void x86_finalize_frame(X86Function* function);
+
+const char* x86_opcode_name(X86Opcode op);
+
+#endif // X86_CODEGEN_H
@@ -0,0 +1,396 @@
+#include "x86_encode.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define X86_MAX_INSTR_LENGTH 15
+
+static void* encode_alloc(size_t size) {
+    void* ptr = malloc(size ? size : 1);
+    if (!ptr) {
+        perror("malloc failed for x86 encoder");
+        exit(1);
+    }
+    return ptr;
+}
+
+// 一条编码好的指令; 跳转的位移要等布局确定之后才能写
+typedef struct Encoded {
+    uint8_t bytes[X86_MAX_INSTR_LENGTH + 1];
+    uint8_t length;
+    int8_t reloc_at;        // 重定位字段在bytes中的位置, -1表示没有
+    uint8_t reloc_kind;     // X86RelocKind
+    int32_t symbol;
+    int32_t displacement;   // 相对符号的位移(全局变量的元素偏移)
+} Encoded;
+
+static void put8(Encoded* e, int byte) {
+    e->bytes[e->length++] = (uint8_t)byte;
+}
+
+static void put32(Encoded* e, int32_t value) {
+    uint32_t bits = (uint32_t)value;
+    for (int i = 0; i < 4; i++) put8(e, (int)(bits >> (8 * i) & 0xFF));
+}
+
+static bool fits8(int32_t value) {
+    return value >= -128 && value <= 127;
+}
+
+static void mark_reloc(Encoded* e, X86RelocKind kind, int32_t symbol, int32_t displacement) {
+    e->reloc_at = (int8_t)e->length;
+    e->reloc_kind = (uint8_t)kind;
+    e->symbol = symbol;
+    e->displacement = displacement;
+    put32(e, 0);
+}
+
+// ========== ModRM ==========
+
+// [REX] 操作码 ModRM [SIB] [位移]: reg是ModRM.reg字段(寄存器或扩展操作码), rm是寄存器或内存操作数。
+// byte_rm表示rm是8位寄存器, 此时spl/bpl/sil/dil要带REX前缀才不会被当成ah/ch/dh/bh
+static void encode_modrm(Encoded* e, const X86Function* function, bool wide, int reg, const X86Operand* rm,
+                         int opcode0, int opcode1, bool byte_rm) {
+    int base = -1;
+    int index = -1;
+    int32_t disp = 0;
+    if (rm->kind == X86_OPERAND_REG) {
+        base = rm->reg;
+    } else if (rm->base_kind == X86_BASE_FRAME) {
+        base = X86_RBP;
+        index = rm->index;
+        disp = function->objects[rm->object].offset + rm->value;
+    } else if (rm->base_kind == X86_BASE_REG) {
+        base = rm->reg;
+        index = rm->index;
+        disp = rm->value;
+    }
+
+    int rex = 0x40 | (wide ? 8 : 0) | (reg & 8 ? 4 : 0) | (index >= 0 && (index & 8) ? 2 : 0) |
+              (base >= 0 && (base & 8) ? 1 : 0);
+    bool force_rex = byte_rm && rm->kind == X86_OPERAND_REG && base >= X86_RSP && base <= X86_RDI;
+    if (rex != 0x40 || force_rex) put8(e, rex);
+    put8(e, opcode0);
+    if (opcode1 >= 0) put8(e, opcode1);
+
+    int r = (reg & 7) << 3;
+    if (rm->kind == X86_OPERAND_REG) {
+        put8(e, 0xC0 | r | (base & 7));
+        return;
+    }
+    if (rm->base_kind == X86_BASE_GLOBAL) {
+        put8(e, 0x05 | r);
+        mark_reloc(e, X86_RELOC_PC32, rm->object, rm->value);
+        return;
+    }
+
+    // rbp/r13作基址时没有不带位移的形式, rsp/r12作基址时必须用SIB
+    int mod = disp == 0 && (base & 7) != X86_RBP ? 0 : fits8(disp) ? 1 : 2;
+    if (index >= 0 || (base & 7) == X86_RSP) {
+        int scale = rm->scale == 8 ? 3 : rm->scale == 4 ? 2 : rm->scale == 2 ? 1 : 0;
+        put8(e, mod << 6 | r | 4);
+        put8(e, (index >= 0 ? scale : 0) << 6 | ((index >= 0 ? index : X86_RSP) & 7) << 3 | (base & 7));
+    } else {
+        put8(e, mod << 6 | r | (base & 7));
+    }
+    if (mod == 1) put8(e, disp);
+    else if (mod == 2) put32(e, disp);
+}
+
+static void encode_op(Encoded* e, const X86Function* function, bool wide, int reg, const X86Operand* rm,
+                      int opcode) {
+    encode_modrm(e, function, wide, reg, rm, opcode, -1, false);
+}
+
+// SSE2: 前缀(66/F3)在REX之前, 然后是0F和操作码
+static void encode_sse(Encoded* e, const X86Function* function, int prefix, int reg, const X86Operand* rm,
+                       int opcode) {
+    put8(e, prefix);
+    encode_modrm(e, function, false, reg, rm, 0x0F, opcode, false);
+}
+
+// 只用一个操作数寄存器编号的短格式(push/pop/mov imm)
+static void encode_short_reg(Encoded* e, bool wide, int reg, int opcode) {
+    if (wide || (reg & 8)) put8(e, 0x40 | (wide ? 8 : 0) | (reg & 8 ? 1 : 0));
+    put8(e, opcode + (reg & 7));
+}
+
+// ========== 指令 ==========
+
+// add/sub/and/xor/cmp: code是操作码组中的编号(/n), 也决定了r/m, reg形式的操作码
+static void encode_alu(Encoded* e, const X86Function* function, const X86Instr* instr, int code) {
+    bool wide = instr->size == 8;
+    const X86Operand* dst = &instr->dst;
+    const X86Operand* src = &instr->src;
+    if (src->kind == X86_OPERAND_IMM && fits8(src->value)) {
+        encode_op(e, function, wide, code, dst, 0x83);
+        put8(e, src->value);
+    } else if (src->kind == X86_OPERAND_IMM) {
+        encode_op(e, function, wide, code, dst, 0x81);
+        put32(e, src->value);
+    } else if (src->kind == X86_OPERAND_REG) {
+        encode_op(e, function, wide, src->reg, dst, code << 3 | 0x01);
+    } else {
+        encode_op(e, function, wide, dst->reg, src, code << 3 | 0x03);
+    }
+}
+
+// 除跳转以外的指令
+static void encode_instr(Encoded* e, const X86Function* function, const X86Instr* instr) {
+    const X86Operand* dst = &instr->dst;
+    const X86Operand* src = &instr->src;
+    bool wide = instr->size == 8;
+    e->length = 0;
+    e->reloc_at = -1;
+
+    switch ((X86Opcode)instr->op) {
+        case X86_MOV:
+            if (src->kind == X86_OPERAND_IMM && dst->kind == X86_OPERAND_REG && !wide) {
+                encode_short_reg(e, false, dst->reg, 0xB8);
+                put32(e, src->value);
+            } else if (src->kind == X86_OPERAND_IMM) {
+                encode_op(e, function, wide, 0, dst, 0xC7);
+                put32(e, src->value);
+            } else if (src->kind == X86_OPERAND_REG) {
+                encode_op(e, function, wide, src->reg, dst, 0x89);
+            } else {
+                encode_op(e, function, wide, dst->reg, src, 0x8B);
+            }
+            break;
+
+        case X86_MOVZX8:
+            encode_modrm(e, function, false, dst->reg, src, 0x0F, 0xB6, true);
+            break;
+
+        case X86_MOVSXD:
+            encode_op(e, function, true, dst->reg, src, 0x63);
+            break;
+
+        case X86_LEA:
+            encode_op(e, function, wide, dst->reg, src, 0x8D);
+            break;
+
+        case X86_ADD: encode_alu(e, function, instr, 0); break;
+        case X86_AND: encode_alu(e, function, instr, 4); break;
+        case X86_SUB: encode_alu(e, function, instr, 5); break;
+        case X86_XOR: encode_alu(e, function, instr, 6); break;
+        case X86_CMP: encode_alu(e, function, instr, 7); break;
+
+        case X86_TEST:
+            encode_op(e, function, wide, src->reg, dst, 0x85);
+            break;
+
+        case X86_IMUL:
+            if (src->kind == X86_OPERAND_IMM && fits8(src->value)) {
+                encode_op(e, function, wide, dst->reg, dst, 0x6B);
+                put8(e, src->value);
+            } else if (src->kind == X86_OPERAND_IMM) {
+                encode_op(e, function, wide, dst->reg, dst, 0x69);
+                put32(e, src->value);
+            } else {
+                encode_modrm(e, function, wide, dst->reg, src, 0x0F, 0xAF, false);
+            }
+            break;
+
+        case X86_NEG:
+            encode_op(e, function, wide, 3, dst, 0xF7);
+            break;
+
+        case X86_IDIV:
+            encode_op(e, function, wide, 7, dst, 0xF7);
+            break;
+
+        case X86_SHL: case X86_SAR: {
+            int code = instr->op == X86_SHL ? 4 : 7;
+            if (src->kind != X86_OPERAND_IMM) {
+                encode_op(e, function, wide, code, dst, 0xD3);
+            } else if (src->value == 1) {
+                encode_op(e, function, wide, code, dst, 0xD1);
+            } else {
+                encode_op(e, function, wide, code, dst, 0xC1);
+                put8(e, src->value);
+            }
+            break;
+        }
+
+        case X86_SETCC:
+            encode_modrm(e, function, false, 0, dst, 0x0F, 0x90 | (instr->cond & 15), true);
+            break;
+
+        case X86_CDQ:
+            if (wide) put8(e, 0x48);
+            put8(e, 0x99);
+            break;
+
+        case X86_PUSH:
+            if (dst->kind == X86_OPERAND_REG) {
+                encode_short_reg(e, false, dst->reg, 0x50);
+            } else if (dst->kind == X86_OPERAND_IMM && fits8(dst->value)) {
+                put8(e, 0x6A);
+                put8(e, dst->value);
+            } else if (dst->kind == X86_OPERAND_IMM) {
+                put8(e, 0x68);
+                put32(e, dst->value);
+            } else {
+                encode_op(e, function, false, 6, dst, 0xFF);
+            }
+            break;
+
+        case X86_POP:
+            encode_short_reg(e, false, dst->reg, 0x58);
+            break;
+
+        case X86_CALL:
+            put8(e, 0xE8);
+            mark_reloc(e, X86_RELOC_PLT32, dst->value, 0);
+            break;
+
+        case X86_TAILJMP:
+            put8(e, 0xE9);
+            mark_reloc(e, X86_RELOC_PLT32, dst->value, 0);
+            break;
+
+        case X86_RET:
+            put8(e, 0xC3);
+            break;
+
+        case X86_MOVDQU:
+            if (dst->kind == X86_OPERAND_REG) encode_sse(e, function, 0xF3, dst->reg, src, 0x6F);
+            else encode_sse(e, function, 0xF3, src->reg, dst, 0x7F);
+            break;
+
+        case X86_MOVDQA: encode_sse(e, function, 0x66, dst->reg, src, 0x6F); break;
+        case X86_MOVD:   encode_sse(e, function, 0x66, dst->reg, src, 0x6E); break;
+        case X86_PADDD:  encode_sse(e, function, 0x66, dst->reg, src, 0xFE); break;
+        case X86_PSUBD:  encode_sse(e, function, 0x66, dst->reg, src, 0xFA); break;
+        case X86_PAND:   encode_sse(e, function, 0x66, dst->reg, src, 0xDB); break;
+
+        case X86_PSHUFD:
+            encode_sse(e, function, 0x66, dst->reg, src, 0x70);
+            put8(e, 0);
+            break;
+
+        case X86_PSLLD: case X86_PSRAD:
+            encode_sse(e, function, 0x66, instr->op == X86_PSLLD ? 6 : 4, dst, 0x72);
+            put8(e, src->value);
+            break;
+
+        default:
+            break;
+    }
+}
+
+static bool is_jump(const X86Instr* instr) {
+    return instr->op == X86_JMP || instr->op == X86_JCC;
+}
+
+// ========== 函数与模块 ==========
+
+static void add_reloc(X86Code* code, uint32_t offset, X86RelocKind kind, int32_t symbol, int32_t addend) {
+    if (code->reloc_count == code->reloc_capacity) {
+        code->reloc_capacity = code->reloc_capacity ? code->reloc_capacity * 2 : 64;
+        code->relocs = (X86Reloc*)realloc(code->relocs, sizeof(X86Reloc) * (size_t)code->reloc_capacity);
+        if (!code->relocs) {
+            perror("malloc failed for X86Reloc");
+            exit(1);
+        }
+    }
+    X86Reloc* reloc = &code->relocs[code->reloc_count++];
+    reloc->offset = offset;
+    reloc->kind = (uint8_t)kind;
+    reloc->symbol = symbol;
+    reloc->addend = addend;
+}
+
+static void encode_function(X86Code* code, const X86Function* function) {
+    int count = function->instr_count;
+    Encoded* encoded = (Encoded*)encode_alloc(sizeof(Encoded) * (size_t)count);
+    int32_t* starts = (int32_t*)encode_alloc(sizeof(int32_t) * (size_t)count);
+    int32_t* labels = (int32_t*)encode_alloc(sizeof(int32_t) * (size_t)function->label_count);
+
+    // 除跳转以外的指令长度是固定的; 跳转从短跳转开始, 放不下的改为长跳转直到布局稳定
+    for (int i = 0; i < count; i++) {
+        if (is_jump(&function->instrs[i])) {
+            encoded[i].length = 2;
+            encoded[i].reloc_at = -1;
+        } else {
+            encode_instr(&encoded[i], function, &function->instrs[i]);
+        }
+    }
+    bool changed = true;
+    while (changed) {
+        int32_t offset = 0;
+        for (int i = 0; i < count; i++) {
+            starts[i] = offset;
+            if (function->instrs[i].op == X86_LABEL) labels[function->instrs[i].dst.value] = offset;
+            offset += encoded[i].length;
+        }
+        changed = false;
+        for (int i = 0; i < count; i++) {
+            const X86Instr* instr = &function->instrs[i];
+            if (!is_jump(instr) || encoded[i].length != 2) continue;
+            if (fits8(labels[instr->dst.value] - (starts[i] + 2))) continue;
+            encoded[i].length = instr->op == X86_JMP ? 5 : 6;
+            code->long_jumps++;
+            changed = true;
+        }
+    }
+
+    uint32_t base = (uint32_t)code->text.length;
+    for (int i = 0; i < count; i++) {
+        const X86Instr* instr = &function->instrs[i];
+        Encoded* e = &encoded[i];
+        if (is_jump(instr)) {
+            int length = e->length;
+            int32_t disp = labels[instr->dst.value] - (starts[i] + length);
+            e->length = 0;
+            if (length == 2) {
+                put8(e, instr->op == X86_JMP ? 0xEB : 0x70 | (instr->cond & 15));
+                put8(e, disp);
+            } else {
+                if (instr->op == X86_JMP) {
+                    put8(e, 0xE9);
+                } else {
+                    put8(e, 0x0F);
+                    put8(e, 0x80 | (instr->cond & 15));
+                }
+                put32(e, disp);
+            }
+        } else if (e->reloc_at >= 0) {
+            // 位移相对下一条指令的地址, 字段之后可能还有立即数
+            int32_t tail = e->length - e->reloc_at;
+            add_reloc(code, base + (uint32_t)starts[i] + (uint32_t)e->reloc_at, (X86RelocKind)e->reloc_kind,
+                      e->symbol, e->displacement - tail);
+        }
+        outbuf_write(&code->text, e->bytes, e->length);
+    }
+
+    free(labels);
+    free(starts);
+    free(encoded);
+}
+
+X86Code* x86_code_create(const X86Module* module) {
+    X86Code* code = (X86Code*)calloc(1, sizeof(X86Code));
+    if (!code) {
+        perror("malloc failed for X86Code");
+        exit(1);
+    }
+    outbuf_init(&code->text, NULL);
+    code->function_offsets = (uint32_t*)encode_alloc(sizeof(uint32_t) * (size_t)module->function_count);
+    code->function_sizes = (uint32_t*)encode_alloc(sizeof(uint32_t) * (size_t)module->function_count);
+    for (int i = 0; i < module->function_count; i++) {
+        code->function_offsets[i] = (uint32_t)code->text.length;
+        encode_function(code, &module->functions[i]);
+        code->function_sizes[i] = (uint32_t)code->text.length - code->function_offsets[i];
+    }
+    return code;
+}
+
+void x86_code_destroy(X86Code* code) {
+    if (!code) return;
+    outbuf_free(&code->text);
+    free(code->function_offsets);
+    free(code->function_sizes);
+    free(code->relocs);
+    free(code);
+}
@@ -0,0 +1,40 @@
+#ifndef X86_ENCODE_H
+#define X86_ENCODE_H
+
+#include "x86_codegen.h"
+#include "outbuf.h"
+
+// ========== x86-64 机器码编码 ==========
+//
+// 把X86Module中各函数的指令列表直接编码为机器码, 不经过汇编器。
+// 跳转先按2字节的短跳转编码, 位移超出范围的改为长跳转, 反复直到不再变化(与as相同)。
+// 调用目标和全局变量的地址留作重定位, 由目标文件写出器(elf_object.h)或加载器填写。
+
+typedef enum {
+    X86_RELOC_PC32,     // 全局变量的rip相对位移
+    X86_RELOC_PLT32     // call的目标函数
+} X86RelocKind;
+
+// 4字节的位移字段 = 符号地址 + addend - 字段地址
+typedef struct X86Reloc {
+    uint32_t offset;    // 字段在代码中的偏移
+    uint8_t kind;       // X86RelocKind
+    int32_t symbol;     // IR模块中的函数编号(PLT32)或全局变量编号(PC32)
+    int32_t addend;
+} X86Reloc;
+
+typedef struct X86Code {
+    OutBuf text;                // 全部函数的机器码, 按X86Module中的顺序排列
+    uint32_t* function_offsets; // 每个函数的起始偏移和长度, 下标与X86Module.functions相同
+    uint32_t* function_sizes;
+    X86Reloc* relocs;
+    int reloc_count;
+    int reloc_capacity;
+    int long_jumps;             // 位移超出短跳转范围的跳转数
+} X86Code;
+
+// 编码模块中的全部函数
+X86Code* x86_code_create(const X86Module* module);
+void x86_code_destroy(X86Code* code);
+
+#endif // X86_ENCODE_H
@@ -0,0 +1,361 @@
+#include "x86_frame.h"
+#include <stdlib.h>
+#include <string.h>
+
+static void* frame_alloc(size_t size) {
+    void* ptr = calloc(1, size ? size : 1);
+    if (!ptr) {
+        perror("malloc failed for frame layout");
+        exit(1);
+    }
+    return ptr;
+}
+
+// ========== 位集合 ==========
+
+#define SET_BIT(set, i) ((set)[(i) >> 6] |= (uint64_t)1 << ((i) & 63))
+#define CLEAR_BIT(set, i) ((set)[(i) >> 6] &= ~((uint64_t)1 << ((i) & 63)))
+#define TEST_BIT(set, i) ((set)[(i) >> 6] >> ((i) & 63) & 1)
+
+// dst |= src, 返回dst是否变化
+static bool set_union(uint64_t* dst, const uint64_t* src, int words) {
+    bool changed = false;
+    for (int w = 0; w < words; w++) {
+        uint64_t merged = dst[w] | src[w];
+        if (merged != dst[w]) {
+            dst[w] = merged;
+            changed = true;
+        }
+    }
+    return changed;
+}
+
+static void set_intersect(uint64_t* dst, const uint64_t* a, const uint64_t* b, int words) {
+    for (int w = 0; w < words; w++) dst[w] = a[w] & b[w];
+}
+
+// ========== 对象的读写 ==========
+
+typedef struct Access {
+    int object;
+    bool read;
+    bool write;
+    bool kill;          // 从对象开头写满整个对象: 之前的值不再需要
+} Access;
+
+static int frame_object(X86Operand operand) {
+    return operand.kind == X86_OPERAND_MEM && operand.base_kind == X86_BASE_FRAME ? operand.object : -1;
+}
+
+// 写入dst是否覆盖整个对象; int和bool只使用低32位, 溢出槽写入4字节就够了
+static bool covers_object(const X86Function* function, const X86Instr* instr) {
+    X86Operand dst = instr->dst;
+    if (dst.index >= 0 || dst.value != 0) return false;
+    if (dst.object >= function->spill_base && instr->size >= 4) return true;
+    return instr->size >= function->objects[dst.object].size;
+}
+
+// 指令读写的栈帧对象, 返回个数; 不确定时按既读又写处理
+static int instr_accesses(const X86Function* function, const X86Instr* instr, Access accesses[2]) {
+    int count = 0;
+    int object = frame_object(instr->src);
+    if (object >= 0) {
+        accesses[count++] = (Access){ object, true, false, false };
+    }
+    object = frame_object(instr->dst);
+    if (object >= 0) {
+        bool store = instr->op == X86_MOV || instr->op == X86_MOVDQU || instr->op == X86_SETCC;
+        bool kill = store && instr->op != X86_SETCC && covers_object(function, instr);
+        accesses[count++] = (Access){ object, !store, true, kill };
+    }
+    return count;
+}
+
+// ========== 活跃范围 ==========
+
+typedef struct Frame {
+    X86Function* function;
+    int words;                  // 每个对象集合的字数
+    int block_count;
+    int32_t* block_start;
+    int32_t* block_of_label;
+    uint64_t* need_in;          // 块入口之后还会被读的对象
+    uint64_t* reach_in;         // 块入口之前可能写过的对象
+    uint64_t* conflicts;        // 冲突矩阵, 每个对象一行
+} Frame;
+
+static bool ends_block(const X86Instr* instr) {
+    return instr->op == X86_JMP || instr->op == X86_JCC || instr->op == X86_TAILJMP || instr->op == X86_RET;
+}
+
+static void split_blocks(Frame* frame) {
+    X86Function* function = frame->function;
+    for (int l = 0; l < function->label_count; l++) frame->block_of_label[l] = -1;
+    int count = 0;
+    for (int i = 0; i < function->instr_count; i++) {
+        const X86Instr* instr = &function->instrs[i];
+        if (i == 0 || instr->op == X86_LABEL || ends_block(&function->instrs[i - 1])) {
+            frame->block_start[count++] = i;
+        }
+        if (instr->op == X86_LABEL) frame->block_of_label[instr->dst.value] = count - 1;
+    }
+    frame->block_start[count] = function->instr_count;
+    frame->block_count = count;
+}
+
+// 块的后继, 返回个数; 跳到尾声(return_label不在列表中)和落到函数末尾没有后继
+static int block_succs(const Frame* frame, int block, int succs[2]) {
+    const X86Instr* last = &frame->function->instrs[frame->block_start[block + 1] - 1];
+    int count = 0;
+    if (last->op == X86_JMP || last->op == X86_JCC) {
+        int label = last->dst.value;
+        int target = label >= 0 && label < frame->function->label_count ? frame->block_of_label[label] : -1;
+        if (target >= 0) succs[count++] = target;
+    }
+    bool falls_through = !ends_block(last) || last->op == X86_JCC;
+    if (falls_through && block + 1 < frame->block_count) succs[count++] = block + 1;
+    return count;
+}
+
+// 逆向: 指令之前还会被读的对象
+static void need_transfer(const Frame* frame, const X86Instr* instr, uint64_t* need) {
+    Access accesses[2];
+    int count = instr_accesses(frame->function, instr, accesses);
+    for (int a = 0; a < count; a++) {
+        if (accesses[a].kill) CLEAR_BIT(need, accesses[a].object);
+    }
+    for (int a = 0; a < count; a++) {
+        if (accesses[a].read) SET_BIT(need, accesses[a].object);
+    }
+}
+
+// 正向: 指令之后可能写过的对象
+static void reach_transfer(const Frame* frame, const X86Instr* instr, uint64_t* reach) {
+    Access accesses[2];
+    int count = instr_accesses(frame->function, instr, accesses);
+    for (int a = 0; a < count; a++) {
+        if (accesses[a].write) SET_BIT(reach, accesses[a].object);
+    }
+}
+
+static void compute_ranges(Frame* frame, uint64_t* scratch) {
+    int words = frame->words;
+    int succs[2];
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (int b = frame->block_count - 1; b >= 0; b--) {
+            memset(scratch, 0, sizeof(uint64_t) * (size_t)words);
+            int count = block_succs(frame, b, succs);
+            for (int s = 0; s < count; s++) set_union(scratch, &frame->need_in[(size_t)succs[s] * words], words);
+            for (int i = frame->block_start[b + 1] - 1; i >= frame->block_start[b]; i--) {
+                need_transfer(frame, &frame->function->instrs[i], scratch);
+            }
+            if (set_union(&frame->need_in[(size_t)b * words], scratch, words)) changed = true;
+        }
+    }
+    changed = true;
+    while (changed) {
+        changed = false;
+        for (int b = 0; b < frame->block_count; b++) {
+            memcpy(scratch, &frame->reach_in[(size_t)b * words], sizeof(uint64_t) * (size_t)words);
+            for (int i = frame->block_start[b]; i < frame->block_start[b + 1]; i++) {
+                reach_transfer(frame, &frame->function->instrs[i], scratch);
+            }
+            int count = block_succs(frame, b, succs);
+            for (int s = 0; s < count; s++) {
+                if (set_union(&frame->reach_in[(size_t)succs[s] * words], scratch, words)) changed = true;
+            }
+        }
+    }
+}
+
+// object与live中的每个对象冲突
+static void add_conflicts(Frame* frame, int object, const uint64_t* live) {
+    int words = frame->words;
+    set_union(&frame->conflicts[(size_t)object * words], live, words);
+    for (int w = 0; w < words; w++) {
+        for (uint64_t bits = live[w]; bits; bits &= bits - 1) {
+            int other = w * 64 + __builtin_ctzll(bits);
+            SET_BIT(&frame->conflicts[(size_t)other * words], object);
+        }
+    }
+}
+
+// 对象在写入处与之后活跃(写过且还会被读)的对象冲突; 在块入口活跃的对象两两冲突,
+// 它们可能分别经不同的前驱写入
+static void build_conflicts(Frame* frame, int max_block) {
+    X86Function* function = frame->function;
+    int words = frame->words;
+    uint64_t* need_after = (uint64_t*)frame_alloc(sizeof(uint64_t) * (size_t)words * (size_t)max_block);
+    uint64_t* reach = (uint64_t*)frame_alloc(sizeof(uint64_t) * (size_t)words);
+    uint64_t* live = (uint64_t*)frame_alloc(sizeof(uint64_t) * (size_t)words);
+    int succs[2];
+
+    for (int b = 0; b < frame->block_count; b++) {
+        int start = frame->block_start[b];
+        int end = frame->block_start[b + 1];
+        set_intersect(live, &frame->need_in[(size_t)b * words], &frame->reach_in[(size_t)b * words], words);
+        for (int w = 0; w < words; w++) {
+            for (uint64_t bits = live[w]; bits; bits &= bits - 1) add_conflicts(frame, w * 64 + __builtin_ctzll(bits), live);
+        }
+
+        uint64_t* need = &need_after[(size_t)(end - 1 - start) * words];
+        memset(need, 0, sizeof(uint64_t) * (size_t)words);
+        int count = block_succs(frame, b, succs);
+        for (int s = 0; s < count; s++) set_union(need, &frame->need_in[(size_t)succs[s] * words], words);
+        for (int i = end - 1; i > start; i--) {
+            uint64_t* before = &need_after[(size_t)(i - 1 - start) * words];
+            memcpy(before, &need_after[(size_t)(i - start) * words], sizeof(uint64_t) * (size_t)words);
+            need_transfer(frame, &function->instrs[i], before);
+        }
+
+        memcpy(reach, &frame->reach_in[(size_t)b * words], sizeof(uint64_t) * (size_t)words);
+        for (int i = start; i < end; i++) {
+            reach_transfer(frame, &function->instrs[i], reach);
+            Access accesses[2];
+            int access_count = instr_accesses(function, &function->instrs[i], accesses);
+            if (access_count == 0) continue;
+            set_intersect(live, &need_after[(size_t)(i - start) * words], reach, words);
+            for (int a = 0; a < access_count; a++) {
+                if (accesses[a].write) add_conflicts(frame, accesses[a].object, live);
+            }
+        }
+    }
+    free(live);
+    free(reach);
+    free(need_after);
+}
+
+static void compute_conflicts(X86Function* function, uint64_t* conflicts, int words) {
+    Frame frame;
+    memset(&frame, 0, sizeof(frame));
+    frame.function = function;
+    frame.words = words;
+    frame.conflicts = conflicts;
+    size_t n = (size_t)function->instr_count + 1;
+    frame.block_start = (int32_t*)frame_alloc(sizeof(int32_t) * (n + 1));
+    frame.block_of_label = (int32_t*)frame_alloc(sizeof(int32_t) * ((size_t)function->label_count + 1));
+    split_blocks(&frame);
+    frame.need_in = (uint64_t*)frame_alloc(sizeof(uint64_t) * (size_t)words * (size_t)(frame.block_count + 1));
+    frame.reach_in = (uint64_t*)frame_alloc(sizeof(uint64_t) * (size_t)words * (size_t)(frame.block_count + 1));
+
+    int max_block = 1;
+    for (int b = 0; b < frame.block_count; b++) {
+        int length = frame.block_start[b + 1] - frame.block_start[b];
+        if (length > max_block) max_block = length;
+    }
+    uint64_t* scratch = (uint64_t*)frame_alloc(sizeof(uint64_t) * (size_t)words);
+    compute_ranges(&frame, scratch);
+    build_conflicts(&frame, max_block);
+
+    free(scratch);
+    free(frame.reach_in);
+    free(frame.need_in);
+    free(frame.block_of_label);
+    free(frame.block_start);
+}
+
+// ========== 栈槽分配 ==========
+
+typedef struct SlotOrder {
+    int32_t align;
+    int32_t size;
+    int32_t object;
+} SlotOrder;
+
+// 对齐大的在前, 同样对齐时大的在前
+static int compare_order(const void* a, const void* b) {
+    const SlotOrder* x = (const SlotOrder*)a;
+    const SlotOrder* y = (const SlotOrder*)b;
+    if (x->align != y->align) return y->align - x->align;
+    if (x->size != y->size) return y->size - x->size;
+    return x->object - y->object;
+}
+
+static int count_bits(uint32_t bits) {
+    int count = 0;
+    for (; bits; bits &= bits - 1) count++;
+    return count;
+}
+
+void x86_frame_layout(X86Function* function, bool share, X86FrameStats* stats) {
+    int m = function->object_count;
+    if (m > X86_FRAME_MAX_SHARED) share = false;
+    int words = (m + 63) / 64;
+
+    uint64_t* conflicts = NULL;
+    bool* pinned = (bool*)frame_alloc(sizeof(bool) * ((size_t)m + 1));
+    if (share && m > 1) {
+        conflicts = (uint64_t*)frame_alloc(sizeof(uint64_t) * (size_t)words * (size_t)m);
+        compute_conflicts(function, conflicts, words);
+        for (int i = 0; i < function->instr_count; i++) {
+            const X86Instr* instr = &function->instrs[i];
+            int object = frame_object(instr->src);
+            if (instr->op == X86_LEA && object >= 0) pinned[object] = true;
+        }
+    }
+
+    SlotOrder* order = (SlotOrder*)frame_alloc(sizeof(SlotOrder) * ((size_t)m + 1));
+    int count = 0;
+    for (int i = 0; i < m; i++) {
+        const X86FrameObject* object = &function->objects[i];
+        if (object->size == 0) continue;
+        order[count++] = (SlotOrder){ object->align, object->size, i };
+    }
+    qsort(order, (size_t)count, sizeof(SlotOrder), compare_order);
+
+    // 按顺序放进第一个不冲突的栈槽; 栈槽的对齐是第一个对象的对齐, 所以栈槽也按对齐从大到小排列
+    int32_t* slot_of = (int32_t*)frame_alloc(sizeof(int32_t) * ((size_t)m + 1));
+    SlotOrder* slots = (SlotOrder*)frame_alloc(sizeof(SlotOrder) * ((size_t)count + 1));
+    uint64_t* slot_conflicts = conflicts ? (uint64_t*)frame_alloc(sizeof(uint64_t) * (size_t)words * (size_t)count) : NULL;
+    int slot_count = 0;
+    int shared = 0;
+    int32_t object_bytes = 0;
+    for (int k = 0; k < count; k++) {
+        int object = order[k].object;
+        object_bytes += order[k].size;
+        int slot = -1;
+        for (int s = 0; conflicts && !pinned[object] && s < slot_count; s++) {
+            if (slots[s].object < 0 || TEST_BIT(&slot_conflicts[(size_t)s * words], object)) continue;
+            slot = s;
+            break;
+        }
+        if (slot < 0) {
+            slot = slot_count++;
+            // object < 0 表示被取了地址的对象独占
+            slots[slot] = (SlotOrder){ order[k].align, 0, pinned[object] ? -1 : object };
+        } else {
+            shared++;
+        }
+        if (order[k].size > slots[slot].size) slots[slot].size = order[k].size;
+        if (slot_conflicts) set_union(&slot_conflicts[(size_t)slot * words], &conflicts[(size_t)object * words], words);
+        slot_of[object] = slot;
+    }
+
+    // 保存的寄存器紧挨着rbp, 栈槽依次排在下面
+    int32_t offset = 8 * count_bits(function->saved_regs);
+    int32_t slot_bytes = 0;
+    int32_t* slot_offset = (int32_t*)frame_alloc(sizeof(int32_t) * ((size_t)slot_count + 1));
+    for (int s = 0; s < slot_count; s++) {
+        offset = (offset + slots[s].size + slots[s].align - 1) / slots[s].align * slots[s].align;
+        slot_offset[s] = -offset;
+        slot_bytes += slots[s].size;
+    }
+    for (int k = 0; k < count; k++) {
+        function->objects[order[k].object].offset = slot_offset[slot_of[order[k].object]];
+    }
+
+    if (stats) {
+        stats->objects += count;
+        stats->shared += shared;
+        stats->saved_bytes += object_bytes - slot_bytes;
+    }
+    free(slot_offset);
+    free(slot_conflicts);
+    free(slots);
+    free(slot_of);
+    free(order);
+    free(pinned);
+    free(conflicts);
+}
@@ -0,0 +1,28 @@
+#ifndef X86_FRAME_H
+#define X86_FRAME_H
+
+#include "x86_codegen.h"
+
+// ========== 栈帧布局 ==========
+//
+// 窥孔优化之后、x86_finalize_frame之前, 给每个栈帧对象(没被提升的IR栈槽、溢出槽)确定相对rbp的偏移。
+// 共用栈槽时先在机器指令列表上求出每个对象的活跃范围: 可能已经写过(正向, 写不会被撤销)
+// 且之后还会被读(逆向, 从对象开头写满整个对象的mov才算覆盖)。两个对象在某个写入处
+// 或某个基本块入口同时活跃则冲突; 按对齐和大小从大到小依次放进第一个不冲突的栈槽。
+//   - 读没写过的对象是未定义的, 所以不同作用域、活跃范围不相交的局部数组可以共用同一段栈空间
+//   - 被lea取了地址的对象可能经指针在任何地方读写, 单独占一个栈槽
+// 栈槽按对齐从大到小排在保存的寄存器之下, 减少对齐的填充。
+// 对象超过X86_FRAME_MAX_SHARED个时冲突矩阵太大, 不再共用。
+
+#define X86_FRAME_MAX_SHARED 4096
+
+typedef struct X86FrameStats {
+    int objects;        // 占用栈空间的对象
+    int shared;         // 放进了其他对象的栈槽的对象
+    int32_t saved_bytes; // 与每个对象各占一个栈槽相比省下的字节数(不计对齐填充)
+} X86FrameStats;
+
+// 确定function->objects的偏移; share为false时每个对象各占一个栈槽, stats可以为NULL
+void x86_frame_layout(X86Function* function, bool share, X86FrameStats* stats);
+
+#endif // X86_FRAME_H
@@ -0,0 +1,649 @@
+#include "x86_peephole.h"
+#include <stdlib.h>
+#include <string.h>
+
+static void* peephole_alloc(size_t size) {
+    void* ptr = calloc(1, size ? size : 1);
+    if (!ptr) {
+        perror("malloc failed for x86 peephole");
+        exit(1);
+    }
+    return ptr;
+}
+
+// ========== 读写的寄存器 ==========
+
+#define REG_BIT(reg) (1u << (reg))
+#define FLAGS_BIT (1u << X86_REG_COUNT)
+// rsp和rbp始终活跃, 不会被改写或删除
+#define ALWAYS_LIVE (REG_BIT(X86_RSP) | REG_BIT(X86_RBP))
+// 尾声之后返回: 只有返回值
+#define RETURN_LIVE (REG_BIT(X86_RAX) | ALWAYS_LIVE)
+#define ARG_REGS (REG_BIT(X86_RDI) | REG_BIT(X86_RSI) | REG_BIT(X86_RDX) | REG_BIT(X86_RCX) | \
+                  REG_BIT(X86_R8) | REG_BIT(X86_R9))
+#define CALLER_SAVED (ARG_REGS | REG_BIT(X86_RAX) | REG_BIT(X86_R10) | REG_BIT(X86_R11))
+
+// call和尾调用读的参数寄存器: src是经寄存器传递的实参个数
+static uint32_t call_args(const X86Instr* instr) {
+    int count = instr->src.kind == X86_OPERAND_IMM ? instr->src.value : X86_ARG_REG_COUNT;
+    uint32_t regs = 0;
+    for (int i = 0; i < count && i < X86_ARG_REG_COUNT; i++) regs |= REG_BIT(x86_arg_regs[i]);
+    return regs;
+}
+
+typedef struct Effect {
+    uint32_t reads;
+    uint32_t writes;
+} Effect;
+
+static bool operand_equal(X86Operand a, X86Operand b) {
+    if (a.kind != b.kind) return false;
+    switch (a.kind) {
+        case X86_OPERAND_REG:
+            return a.reg == b.reg;
+        case X86_OPERAND_MEM:
+            return a.base_kind == b.base_kind && a.reg == b.reg && a.object == b.object &&
+                   a.index == b.index && a.scale == b.scale && a.value == b.value;
+        default:
+            return a.value == b.value;
+    }
+}
+
+static bool instr_equal(const X86Instr* a, const X86Instr* b) {
+    return a->op == b->op && a->size == b->size && a->cond == b->cond &&
+           operand_equal(a->dst, b->dst) && operand_equal(a->src, b->src);
+}
+
+static bool is_reg(X86Operand operand, int reg) {
+    return operand.kind == X86_OPERAND_REG && operand.reg == reg;
+}
+
+// 可以改写的通用寄存器(不是rsp/rbp); 只用于非SSE指令的操作数
+static bool is_gpr(X86Operand operand) {
+    return operand.kind == X86_OPERAND_REG && operand.reg != X86_RSP && operand.reg != X86_RBP;
+}
+
+// 内存操作数的基址和下标寄存器
+static uint32_t address_regs(X86Operand operand) {
+    if (operand.kind != X86_OPERAND_MEM) return 0;
+    uint32_t regs = 0;
+    if (operand.base_kind == X86_BASE_REG) regs |= REG_BIT(operand.reg);
+    if (operand.index >= 0) regs |= REG_BIT(operand.index);
+    return regs;
+}
+
+// 读一个通用寄存器或内存操作数用到的寄存器
+static uint32_t operand_regs(X86Operand operand) {
+    return operand.kind == X86_OPERAND_REG ? REG_BIT(operand.reg) : address_regs(operand);
+}
+
+static uint32_t def_regs(X86Operand operand) {
+    return operand.kind == X86_OPERAND_REG ? REG_BIT(operand.reg) : 0;
+}
+
+static Effect instr_effect(const X86Instr* instr) {
+    Effect effect = { 0, 0 };
+    X86Operand dst = instr->dst;
+    X86Operand src = instr->src;
+    switch ((X86Opcode)instr->op) {
+        case X86_LABEL: case X86_JMP:
+            break;
+
+        case X86_MOV: case X86_MOVZX8: case X86_MOVSXD:
+            effect.reads = operand_regs(src) | address_regs(dst);
+            effect.writes = def_regs(dst);
+            break;
+
+        case X86_LEA:
+            effect.reads = address_regs(src);
+            effect.writes = def_regs(dst);
+            break;
+
+        case X86_XOR:
+            if (dst.kind == X86_OPERAND_REG && operand_equal(dst, src)) {
+                effect.writes = def_regs(dst) | FLAGS_BIT;   // 清零, 不读原来的值
+                break;
+            }
+            effect.reads = operand_regs(dst) | operand_regs(src);
+            effect.writes = def_regs(dst) | FLAGS_BIT;
+            break;
+
+        case X86_ADD: case X86_SUB: case X86_IMUL: case X86_AND: case X86_SHL: case X86_SAR:
+            effect.reads = operand_regs(dst) | operand_regs(src);
+            effect.writes = def_regs(dst) | FLAGS_BIT;
+            break;
+
+        case X86_NEG:
+            effect.reads = operand_regs(dst);
+            effect.writes = def_regs(dst) | FLAGS_BIT;
+            break;
+
+        case X86_CMP: case X86_TEST:
+            effect.reads = operand_regs(dst) | operand_regs(src);
+            effect.writes = FLAGS_BIT;
+            break;
+
+        case X86_SETCC:
+            // 只写低8位, 其余位保持不变
+            effect.reads = FLAGS_BIT | operand_regs(dst);
+            effect.writes = def_regs(dst);
+            break;
+
+        case X86_CDQ:
+            effect.reads = REG_BIT(X86_RAX);
+            effect.writes = REG_BIT(X86_RDX);
+            break;
+
+        case X86_IDIV:
+            effect.reads = REG_BIT(X86_RAX) | REG_BIT(X86_RDX) | operand_regs(dst);
+            effect.writes = REG_BIT(X86_RAX) | REG_BIT(X86_RDX) | FLAGS_BIT;
+            break;
+
+        case X86_PUSH:
+            effect.reads = operand_regs(dst) | REG_BIT(X86_RSP);
+            effect.writes = REG_BIT(X86_RSP);
+            break;
+
+        case X86_POP:
+            effect.reads = address_regs(dst) | REG_BIT(X86_RSP);
+            effect.writes = def_regs(dst) | REG_BIT(X86_RSP);
+            break;
+
+        case X86_CALL:
+            effect.reads = call_args(instr) | REG_BIT(X86_RAX) | REG_BIT(X86_RSP);
+            effect.writes = CALLER_SAVED | FLAGS_BIT;
+            break;
+
+        case X86_TAILJMP:
+            effect.reads = call_args(instr) | REG_BIT(X86_RAX) | REG_BIT(X86_RSP);
+            break;
+
+        case X86_RET:
+            effect.reads = REG_BIT(X86_RAX) | REG_BIT(X86_RSP);
+            break;
+
+        case X86_JCC:
+            effect.reads = FLAGS_BIT;
+            break;
+
+        case X86_MOVD:
+            effect.reads = operand_regs(src);
+            break;
+
+        default:
+            // 其余SSE2指令的寄存器操作数都是xmm
+            effect.reads = address_regs(dst) | address_regs(src);
+            break;
+    }
+    return effect;
+}
+
+// ========== 活跃分析 ==========
+
+typedef struct Peephole {
+    X86Function* function;
+    bool* removed;          // 本遍删除的指令, 一遍结束后压缩
+    bool* touched;          // 本遍改写过的指令: 活跃信息已不准确, 不再从这里匹配
+    uint32_t* live;         // 每条指令之后活跃的寄存器和标志(FLAGS_BIT)
+    int32_t* refs;          // 每个标号被跳转引用的次数
+    int32_t* label_at;      // 标号所在的下标, -1表示不在列表中(return_label由x86_finalize_frame加入)
+    int32_t* block_start;
+    int32_t* block_of_label;
+    uint32_t* live_in;
+    X86PeepholeStats stats;
+} Peephole;
+
+static bool ends_block(const X86Instr* instr) {
+    return instr->op == X86_JMP || instr->op == X86_JCC || instr->op == X86_TAILJMP || instr->op == X86_RET;
+}
+
+static uint32_t transfer(const X86Instr* instr, uint32_t live) {
+    Effect effect = instr_effect(instr);
+    return (live & ~effect.writes) | effect.reads | ALWAYS_LIVE;
+}
+
+static uint32_t label_live(const Peephole* p, int label) {
+    if (label == p->function->return_label) return RETURN_LIVE;
+    int block = label >= 0 && label < p->function->label_count ? p->block_of_label[label] : -1;
+    return block >= 0 ? p->live_in[block] : ~0u;
+}
+
+static uint32_t block_live_out(const Peephole* p, int block, int block_count) {
+    const X86Instr* last = &p->function->instrs[p->block_start[block + 1] - 1];
+    uint32_t next = block + 1 < block_count ? p->live_in[block + 1] : RETURN_LIVE;
+    switch (last->op) {
+        case X86_JMP:     return label_live(p, last->dst.value);
+        case X86_JCC:     return label_live(p, last->dst.value) | next;
+        case X86_TAILJMP: return ALWAYS_LIVE;
+        case X86_RET:     return ALWAYS_LIVE;
+        default:          return next;
+    }
+}
+
+// 按标号和跳转划分基本块, 迭代求出各块入口活跃的寄存器, 再逐块逆向求出每条指令之后的活跃集合
+static void compute_liveness(Peephole* p) {
+    X86Function* function = p->function;
+    int n = function->instr_count;
+    int block_count = 0;
+    for (int l = 0; l < function->label_count; l++) p->block_of_label[l] = -1;
+    for (int i = 0; i < n; i++) {
+        const X86Instr* instr = &function->instrs[i];
+        if (i == 0 || instr->op == X86_LABEL || ends_block(&function->instrs[i - 1])) {
+            p->block_start[block_count++] = i;
+        }
+        if (instr->op == X86_LABEL) p->block_of_label[instr->dst.value] = block_count - 1;
+    }
+    p->block_start[block_count] = n;
+    memset(p->live_in, 0, sizeof(uint32_t) * (size_t)(block_count + 1));
+
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (int b = block_count - 1; b >= 0; b--) {
+            uint32_t live = block_live_out(p, b, block_count);
+            for (int i = p->block_start[b + 1] - 1; i >= p->block_start[b]; i--) {
+                live = transfer(&function->instrs[i], live);
+            }
+            if (live != p->live_in[b]) {
+                p->live_in[b] = live;
+                changed = true;
+            }
+        }
+    }
+    for (int b = 0; b < block_count; b++) {
+        uint32_t live = block_live_out(p, b, block_count);
+        for (int i = p->block_start[b + 1] - 1; i >= p->block_start[b]; i--) {
+            p->live[i] = live;
+            live = transfer(&function->instrs[i], live);
+        }
+    }
+}
+
+static void count_labels(Peephole* p) {
+    X86Function* function = p->function;
+    for (int l = 0; l < function->label_count; l++) {
+        p->refs[l] = 0;
+        p->label_at[l] = -1;
+    }
+    for (int i = 0; i < function->instr_count; i++) {
+        const X86Instr* instr = &function->instrs[i];
+        if (instr->op == X86_LABEL) p->label_at[instr->dst.value] = i;
+        if (instr->op == X86_JMP || instr->op == X86_JCC) p->refs[instr->dst.value]++;
+    }
+}
+
+// 指令i之后活跃的寄存器; 本遍改写过的指令当作全部活跃
+static uint32_t live_after(const Peephole* p, int i) {
+    return p->touched[i] ? ~0u : p->live[i];
+}
+
+static int next_instr(const Peephole* p, int i) {
+    do {
+        i++;
+    } while (i < p->function->instr_count && p->removed[i]);
+    return i;
+}
+
+// 跳过标号
+static int next_code(const Peephole* p, int i) {
+    i = next_instr(p, i);
+    while (i < p->function->instr_count && p->function->instrs[i].op == X86_LABEL) i = next_instr(p, i);
+    return i;
+}
+
+static void remove_instr(Peephole* p, int i) {
+    const X86Instr* instr = &p->function->instrs[i];
+    if (instr->op == X86_JMP || instr->op == X86_JCC) p->refs[instr->dst.value]--;
+    if (instr->op != X86_LABEL) p->stats.removed++;
+    p->removed[i] = true;
+}
+
+static void retarget(Peephole* p, X86Instr* jump, int label) {
+    p->refs[jump->dst.value]--;
+    p->refs[label]++;
+    jump->dst.value = label;
+}
+
+static X86Instr* instr_at(const Peephole* p, int i) {
+    return i < p->function->instr_count ? &p->function->instrs[i] : NULL;
+}
+
+// ========== 模式 ==========
+
+static bool peep_self_move(Peephole* p, int i) {
+    const X86Instr* instr = &p->function->instrs[i];
+    if (instr->op != X86_MOV || instr->dst.kind != X86_OPERAND_REG || !operand_equal(instr->dst, instr->src)) {
+        return false;
+    }
+    remove_instr(p, i);
+    return true;
+}
+
+static bool peep_dead_def(Peephole* p, int i) {
+    const X86Instr* instr = &p->function->instrs[i];
+    switch (instr->op) {
+        case X86_MOV: case X86_MOVZX8: case X86_MOVSXD: case X86_LEA:
+        case X86_ADD: case X86_SUB: case X86_IMUL: case X86_AND: case X86_XOR:
+        case X86_NEG: case X86_SHL: case X86_SAR: case X86_SETCC:
+            break;
+        default:
+            return false;
+    }
+    if (!is_gpr(instr->dst) || (instr_effect(instr).writes & live_after(p, i))) return false;
+    remove_instr(p, i);
+    return true;
+}
+
+// mov a, t; mov t, b → mov a, b 的宽度; 不能合并时返回0
+static int chain_size(int first, int second, X86Operand b) {
+    if (first == second) return first;
+    if (first == 8 && second == 4) return 4;
+    if (first == 4 && second == 8 && b.kind == X86_OPERAND_REG) return 4;   // movl也清零高32位
+    return 0;
+}
+
+static bool peep_copy_chain(Peephole* p, int i) {
+    X86Instr* first = &p->function->instrs[i];
+    if (first->op != X86_MOV || !is_gpr(first->dst) || first->size < 4) return false;
+    int k = next_instr(p, i);
+    const X86Instr* second = instr_at(p, k);
+    int t = first->dst.reg;
+    if (!second || second->op != X86_MOV || !is_reg(second->src, t) || second->size < 4) return false;
+    X86Operand b = second->dst;
+    if (is_reg(b, t) || (b.kind == X86_OPERAND_REG && !is_gpr(b)) || (address_regs(b) & REG_BIT(t))) return false;
+    if (first->src.kind == X86_OPERAND_MEM && b.kind == X86_OPERAND_MEM) return false;
+    if (live_after(p, k) & REG_BIT(t)) return false;
+    int size = chain_size(first->size, second->size, b);
+    if (size == 0) return false;
+
+    first->dst = b;
+    first->size = (uint8_t)size;
+    remove_instr(p, k);
+    return true;
+}
+
+static bool peep_op_copy(Peephole* p, int i) {
+    X86Instr* first = &p->function->instrs[i];
+    if (first->op != X86_MOV || !is_gpr(first->dst)) return false;
+    int t = first->dst.reg;
+    int k = next_instr(p, i);
+    X86Instr* op = instr_at(p, k);
+    if (!op || !is_reg(op->dst, t) || op->size != first->size) return false;
+    switch (op->op) {
+        case X86_ADD: case X86_SUB: case X86_IMUL: case X86_AND: case X86_XOR:
+        case X86_SHL: case X86_SAR: case X86_NEG:
+            break;
+        default:
+            return false;
+    }
+    int m = next_instr(p, k);
+    const X86Instr* copy = instr_at(p, m);
+    if (!copy || copy->op != X86_MOV || !is_reg(copy->src, t) || !is_gpr(copy->dst) || copy->dst.reg == t) {
+        return false;
+    }
+    int d = copy->dst.reg;
+    if (copy->size != 8 && copy->size != op->size) return false;
+    if (operand_regs(op->src) & (REG_BIT(t) | REG_BIT(d))) return false;
+    if (live_after(p, m) & REG_BIT(t)) return false;
+
+    first->dst.reg = (int8_t)d;
+    op->dst.reg = (int8_t)d;
+    p->touched[k] = true;
+    remove_instr(p, m);
+    return true;
+}
+
+// 同一基本块中前面已有相同的指令, 其间没有改写它的结果和它读的寄存器
+static bool peep_repeat(Peephole* p, int i) {
+    const X86Instr* instr = &p->function->instrs[i];
+    bool pure = (instr->op == X86_MOV && instr->src.kind == X86_OPERAND_IMM) || instr->op == X86_LEA ||
+                (instr->op == X86_MOVSXD && instr->src.kind == X86_OPERAND_REG);
+    if (!pure || !is_gpr(instr->dst)) return false;
+    Effect effect = instr_effect(instr);
+    if (effect.reads & effect.writes) return false;
+
+    int window = 64;
+    for (int j = i - 1; j >= 0 && window > 0; j--) {
+        if (p->removed[j]) continue;
+        const X86Instr* prev = &p->function->instrs[j];
+        if (prev->op == X86_LABEL || prev->op == X86_JMP || prev->op == X86_TAILJMP) return false;
+        if (instr_equal(prev, instr)) {
+            remove_instr(p, i);
+            return true;
+        }
+        if (instr_effect(prev).writes & (effect.writes | effect.reads)) return false;
+        window--;
+    }
+    return false;
+}
+
+static bool peep_add_zero(Peephole* p, int i) {
+    const X86Instr* instr = &p->function->instrs[i];
+    if (instr->src.kind != X86_OPERAND_IMM) return false;
+    bool identity = ((instr->op == X86_ADD || instr->op == X86_SUB || instr->op == X86_SHL ||
+                      instr->op == X86_SAR) && instr->src.value == 0) ||
+                    (instr->op == X86_IMUL && instr->src.value == 1);
+    if (!identity || (instr->dst.kind == X86_OPERAND_REG && !is_gpr(instr->dst))) return false;
+    if (live_after(p, i) & FLAGS_BIT) return false;
+    remove_instr(p, i);
+    return true;
+}
+
+// 比较结果既要保存又被br使用时, 指令选择生成 setcc; movzbl; test; jne
+static bool peep_setcc_test(Peephole* p, int i) {
+    const X86Instr* setcc = &p->function->instrs[i];
+    if (setcc->op != X86_SETCC || setcc->dst.kind != X86_OPERAND_REG) return false;
+    int k1 = next_instr(p, i);
+    const X86Instr* extend = instr_at(p, k1);
+    if (!extend || extend->op != X86_MOVZX8 || !is_reg(extend->src, setcc->dst.reg) || !is_gpr(extend->dst)) {
+        return false;
+    }
+    int r = extend->dst.reg;
+    int k2 = next_instr(p, k1);
+    const X86Instr* test = instr_at(p, k2);
+    bool tests = test && ((test->op == X86_TEST && is_reg(test->dst, r) && is_reg(test->src, r)) ||
+                          (test->op == X86_CMP && is_reg(test->dst, r) && test->src.kind == X86_OPERAND_IMM &&
+                           test->src.value == 0));
+    if (!tests) return false;
+    int k3 = next_instr(p, k2);
+    X86Instr* jump = instr_at(p, k3);
+    if (!jump || jump->op != X86_JCC || (jump->cond != X86_CC_NE && jump->cond != X86_CC_E)) return false;
+    uint32_t live = live_after(p, k3);
+    if (live & FLAGS_BIT) return false;
+
+    jump->cond = (uint8_t)(jump->cond == X86_CC_NE ? setcc->cond : setcc->cond ^ 1);
+    p->touched[k3] = true;
+    remove_instr(p, k2);
+    if (!(live & (REG_BIT(r) | REG_BIT(setcc->dst.reg)))) {
+        remove_instr(p, k1);
+        remove_instr(p, i);
+    }
+    return true;
+}
+
+static bool peep_cmp_zero(Peephole* p, int i) {
+    X86Instr* instr = &p->function->instrs[i];
+    if (instr->op != X86_CMP || instr->dst.kind != X86_OPERAND_REG || instr->src.kind != X86_OPERAND_IMM ||
+        instr->src.value != 0) {
+        return false;
+    }
+    instr->op = X86_TEST;
+    instr->src = instr->dst;
+    return true;
+}
+
+static bool peep_zero_imm(Peephole* p, int i) {
+    X86Instr* instr = &p->function->instrs[i];
+    if (instr->op != X86_MOV || !is_gpr(instr->dst) || instr->src.kind != X86_OPERAND_IMM ||
+        instr->src.value != 0 || (live_after(p, i) & FLAGS_BIT)) {
+        return false;
+    }
+    instr->op = X86_XOR;
+    instr->size = 4;
+    instr->src = instr->dst;
+    return true;
+}
+
+static bool peep_imm32(Peephole* p, int i) {
+    X86Instr* instr = &p->function->instrs[i];
+    if (instr->op != X86_MOV || instr->size != 8 || !is_gpr(instr->dst) || instr->src.kind != X86_OPERAND_IMM ||
+        instr->src.value < 0) {
+        return false;
+    }
+    instr->size = 4;
+    return true;
+}
+
+static bool peep_jcc_over_jmp(Peephole* p, int i) {
+    X86Instr* jcc = &p->function->instrs[i];
+    if (jcc->op != X86_JCC) return false;
+    int k = next_instr(p, i);
+    while (k < p->function->instr_count && p->function->instrs[k].op == X86_LABEL) {
+        if (p->refs[p->function->instrs[k].dst.value] > 0) return false;
+        k = next_instr(p, k);
+    }
+    const X86Instr* jmp = instr_at(p, k);
+    if (!jmp || jmp->op != X86_JMP || jmp->dst.value == jcc->dst.value) return false;
+    for (int m = next_instr(p, k); m < p->function->instr_count && p->function->instrs[m].op == X86_LABEL;
+         m = next_instr(p, m)) {
+        if (p->function->instrs[m].dst.value != jcc->dst.value) continue;
+        jcc->cond ^= 1;
+        retarget(p, jcc, jmp->dst.value);
+        remove_instr(p, k);
+        return true;
+    }
+    return false;
+}
+
+static bool peep_jump_chain(Peephole* p, int i) {
+    X86Instr* jump = &p->function->instrs[i];
+    if (jump->op != X86_JMP && jump->op != X86_JCC) return false;
+    int at = p->label_at[jump->dst.value];
+    if (at < 0) return false;
+    const X86Instr* target = instr_at(p, next_code(p, at));
+    if (!target || target->op != X86_JMP || target->dst.value == jump->dst.value) return false;
+    retarget(p, jump, target->dst.value);
+    return true;
+}
+
+static bool peep_jump_next(Peephole* p, int i) {
+    const X86Instr* jump = &p->function->instrs[i];
+    if (jump->op != X86_JMP && jump->op != X86_JCC) return false;
+    int k = next_instr(p, i);
+    for (; k < p->function->instr_count && p->function->instrs[k].op == X86_LABEL; k = next_instr(p, k)) {
+        if (p->function->instrs[k].dst.value == jump->dst.value) break;
+    }
+    bool next = k < p->function->instr_count ? p->function->instrs[k].op == X86_LABEL
+                                              : jump->dst.value == p->function->return_label;
+    if (!next) return false;
+    remove_instr(p, i);
+    return true;
+}
+
+static bool peep_unreachable(Peephole* p, int i) {
+    const X86Instr* jump = &p->function->instrs[i];
+    if (jump->op != X86_JMP && jump->op != X86_TAILJMP) return false;
+    bool any = false;
+    for (int k = next_instr(p, i); k < p->function->instr_count; k = next_instr(p, k)) {
+        const X86Instr* instr = &p->function->instrs[k];
+        if (instr->op == X86_LABEL && p->refs[instr->dst.value] > 0) break;
+        remove_instr(p, k);
+        any = true;
+    }
+    return any;
+}
+
+static bool peep_unused_label(Peephole* p, int i) {
+    const X86Instr* instr = &p->function->instrs[i];
+    if (instr->op != X86_LABEL || p->refs[instr->dst.value] > 0) return false;
+    remove_instr(p, i);
+    return true;
+}
+
+typedef bool (*PeepholeRule)(Peephole* p, int i);
+
+static const struct {
+    const char* name;
+    PeepholeRule apply;
+} patterns[X86_PEEPHOLE_PATTERN_COUNT] = {
+    [X86_PEEP_SELF_MOVE]     = { "自身复制", peep_self_move },
+    [X86_PEEP_DEAD_DEF]      = { "无用定值", peep_dead_def },
+    [X86_PEEP_COPY_CHAIN]    = { "复制链", peep_copy_chain },
+    [X86_PEEP_OP_COPY]       = { "运算后复制", peep_op_copy },
+    [X86_PEEP_REPEAT]        = { "重复计算", peep_repeat },
+    [X86_PEEP_ADD_ZERO]      = { "加0", peep_add_zero },
+    [X86_PEEP_SETCC_TEST]    = { "setcc后测试", peep_setcc_test },
+    [X86_PEEP_CMP_ZERO]      = { "与0比较", peep_cmp_zero },
+    [X86_PEEP_ZERO_IMM]      = { "置0", peep_zero_imm },
+    [X86_PEEP_IMM32]         = { "64位立即数", peep_imm32 },
+    [X86_PEEP_JCC_OVER_JMP]  = { "条件跳过jmp", peep_jcc_over_jmp },
+    [X86_PEEP_JUMP_CHAIN]    = { "跳转链", peep_jump_chain },
+    [X86_PEEP_JUMP_NEXT]     = { "跳到下一条", peep_jump_next },
+    [X86_PEEP_UNREACHABLE]   = { "不可达", peep_unreachable },
+    [X86_PEEP_UNUSED_LABEL]  = { "无用标号", peep_unused_label },
+};
+
+// ========== 驱动 ==========
+
+static void compact(Peephole* p) {
+    X86Function* function = p->function;
+    int count = 0;
+    for (int i = 0; i < function->instr_count; i++) {
+        if (!p->removed[i]) function->instrs[count++] = function->instrs[i];
+    }
+    function->instr_count = count;
+}
+
+void x86_peephole_function(X86Function* function, X86PeepholeStats* stats) {
+    Peephole p;
+    memset(&p, 0, sizeof(p));
+    p.function = function;
+    size_t n = (size_t)function->instr_count + 1;
+    size_t labels = (size_t)function->label_count + 1;
+    p.removed = (bool*)peephole_alloc(sizeof(bool) * n);
+    p.touched = (bool*)peephole_alloc(sizeof(bool) * n);
+    p.live = (uint32_t*)peephole_alloc(sizeof(uint32_t) * n);
+    p.block_start = (int32_t*)peephole_alloc(sizeof(int32_t) * (n + 1));
+    p.live_in = (uint32_t*)peephole_alloc(sizeof(uint32_t) * (n + 1));
+    p.refs = (int32_t*)peephole_alloc(sizeof(int32_t) * labels);
+    p.label_at = (int32_t*)peephole_alloc(sizeof(int32_t) * labels);
+    p.block_of_label = (int32_t*)peephole_alloc(sizeof(int32_t) * labels);
+
+    for (int round = 0; round < X86_PEEPHOLE_MAX_ROUNDS && function->instr_count > 0; round++) {
+        memset(p.removed, 0, sizeof(bool) * (size_t)function->instr_count);
+        memset(p.touched, 0, sizeof(bool) * (size_t)function->instr_count);
+        compute_liveness(&p);
+        count_labels(&p);
+
+        bool changed = false;
+        for (int i = 0; i < function->instr_count; i++) {
+            for (int k = 0; k < X86_PEEPHOLE_PATTERN_COUNT; k++) {
+                if (p.removed[i] || p.touched[i]) break;
+                if (!patterns[k].apply(&p, i)) continue;
+                // 之后这一遍不再从i开始匹配
+                p.stats.applied[k]++;
+                p.touched[i] = true;
+                changed = true;
+            }
+        }
+        compact(&p);
+        if (!changed) break;
+    }
+
+    if (stats) {
+        for (int k = 0; k < X86_PEEPHOLE_PATTERN_COUNT; k++) stats->applied[k] += p.stats.applied[k];
+        stats->removed += p.stats.removed;
+    }
+    free(p.block_of_label);
+    free(p.label_at);
+    free(p.refs);
+    free(p.live_in);
+    free(p.block_start);
+    free(p.live);
+    free(p.touched);
+    free(p.removed);
+}
+
+const char* x86_peephole_pattern_name(X86PeepholePattern pattern) {
+    return pattern < X86_PEEPHOLE_PATTERN_COUNT ? patterns[pattern].name : "?";
+}
@@ -0,0 +1,48 @@
+#ifndef X86_PEEPHOLE_H
+#define X86_PEEPHOLE_H
+
+#include "x86_codegen.h"
+
+// ========== x86-64 窥孔优化 ==========
+//
+// 指令选择之后、x86_finalize_frame插入序言和尾声之前, 在每个函数的机器指令列表上
+// 按模式表依次尝试每一条指令, 反复扫描直到没有可改写的(最多X86_PEEPHOLE_MAX_ROUNDS遍)。
+// 每遍开始时按标号划分基本块, 对通用寄存器和标志位做一次逆向活跃分析:
+//   - 跳到尾声(return_label)或落到函数末尾时只有rax活跃, 被调用者保存的寄存器由尾声恢复;
+//   - call读传递实参的寄存器(个数记在call的src中)和al, 改写调用者保存的寄存器和标志; 尾调用的jmp同样读实参;
+//   - SSE2指令的寄存器操作数是xmm, 只有内存操作数的基址、下标和movd的源操作数是通用寄存器。
+// 同一遍中的改写只会让活跃集合变小(或在没有写入的区间内变大, 见重复计算), 分析结果一直是保守的。
+// int和bool只使用寄存器的低32位(作下标时先经movslq扩展), 32位的自身复制和加0可以直接删除。
+
+#define X86_PEEPHOLE_MAX_ROUNDS 4
+
+typedef enum {
+    X86_PEEP_SELF_MOVE,     // mov r, r → 删除
+    X86_PEEP_DEAD_DEF,      // 结果(和标志)之后不再使用的复制、取地址和运算 → 删除
+    X86_PEEP_COPY_CHAIN,    // mov a, t; mov t, b(t之后不再使用) → mov a, b
+    X86_PEEP_OP_COPY,       // mov a, t; op b, t; mov t, d(t之后不再使用) → mov a, d; op b, d
+    X86_PEEP_REPEAT,        // 寄存器中已有同样的常量、全局变量地址或符号扩展的结果 → 删除
+    X86_PEEP_ADD_ZERO,      // add/sub/shl/sar $0 和 imul $1(标志之后不再使用) → 删除
+    X86_PEEP_SETCC_TEST,    // setcc; movzbl; test r, r; jne/je → setcc; movzbl; jcc, r不再使用时只剩jcc
+    X86_PEEP_CMP_ZERO,      // cmp $0, r → test r, r
+    X86_PEEP_ZERO_IMM,      // mov $0, r(标志之后不再使用) → xorl r, r
+    X86_PEEP_IMM32,         // movq $非负数, r → movl(高32位自动清零, 编码短2字节)
+    X86_PEEP_JCC_OVER_JMP,  // jcc L1; jmp L2; L1: → j!cc L2; L1:
+    X86_PEEP_JUMP_CHAIN,    // 跳到只有jmp L2的块 → 直接跳到L2
+    X86_PEEP_JUMP_NEXT,     // 跳到紧接着的标号 → 删除
+    X86_PEEP_UNREACHABLE,   // jmp和尾调用之后、下一个被引用的标号之前的指令 → 删除
+    X86_PEEP_UNUSED_LABEL,  // 没有被跳转引用的标号 → 删除(之后前后两块可以一起匹配)
+    X86_PEEPHOLE_PATTERN_COUNT
+} X86PeepholePattern;
+
+typedef struct X86PeepholeStats {
+    int applied[X86_PEEPHOLE_PATTERN_COUNT];   // 每个模式改写的次数
+    int removed;                                // 删除的指令数(不含标号)
+} X86PeepholeStats;
+
+// 改写一个函数的指令列表; 在x86_finalize_frame之前调用, stats可以为NULL
+void x86_peephole_function(X86Function* function, X86PeepholeStats* stats);
+
+const char* x86_peephole_pattern_name(X86PeepholePattern pattern);
+
+#endif // X86_PEEPHOLE_H